@@ -46,8 +46,14 @@ ControlledDhcpv4Srv::commandShutdownHandler(const string&, ConstElementPtr) {
 ConstElementPtr
 ControlledDhcpv4Srv::commandLibReloadHandler(const string&, ConstElementPtr) {
 
-    /// @todo delete any stored CalloutHandles referring to the old libraries
-    /// Get list of currently loaded libraries and reload them.
+    // The worker threads must not call the callouts while the libraries
+    // are being reloaded. They will be started again when the next packet
+    // is received.
+    stopWorkers();
+
+    // No CalloutHandles referring to the old libraries are left, as they
+    // are released when the packets have been processed.
+    // Get list of currently loaded libraries and reload them.
     vector<string> loaded = HooksManager::getLibraryNames();
     bool status = HooksManager::loadLibraries(loaded);
     if (!status) {
@@ -119,6 +125,11 @@ ControlledDhcpv4Srv::processConfig(isc::data::ConstElementPtr config) {
         return (isc::config::createAnswer(1, err.str()));
     }
 
+    // Make sure that the worker threads are not processing packets while
+    // the configuration is being modified. They will be started again,
+    // according to the new configuration, when the next packet is received.
+    srv->stopWorkers();
+
     ConstElementPtr answer = configureDhcp4Server(*srv, config);
 
 
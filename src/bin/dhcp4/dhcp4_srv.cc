@@ -24,6 +24,7 @@
 #include <dhcp/option_string.h>
 #include <dhcp/pkt4.h>
 #include <dhcp/docsis3_option_defs.h>
+#include <dhcp/libdhcp++.h>
 #include <dhcp4/dhcp4_log.h>
 #include <dhcp4/dhcp4_srv.h>
 #include <dhcpsrv/addr_utilities.h>
@@ -77,6 +78,14 @@ struct Dhcp4Hooks {
 // module is called.
 Dhcp4Hooks Hooks;
 
+/// Maximum number of received packets waiting for processing, per worker
+/// thread. The packets received when the queue is full are dropped.
+const size_t MAX_QUEUED_PACKETS_PER_THREAD = 64;
+
+/// Empty container of option definitions, used to parse options of the
+/// option spaces which have no definitions.
+const OptionDefContainer empty_option_defs;
+
 namespace isc {
 namespace dhcp {
 
@@ -86,7 +95,8 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const bool use_bcast,
                      const bool direct_response_desired)
     : shutdown_(true), alloc_engine_(), port_(port),
       use_bcast_(use_bcast), hook_index_pkt4_receive_(-1),
-      hook_index_subnet4_select_(-1), hook_index_pkt4_send_(-1) {
+      hook_index_subnet4_select_(-1), hook_index_pkt4_send_(-1),
+      next_reclaim_time_(0), received_pos_(0), queue_responses_(false) {
 
     LOG_DEBUG(dhcp4_logger, DBG_DHCP4_START, DHCP4_OPEN_SOCKET).arg(port);
     try {
@@ -125,6 +135,7 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const bool use_bcast,
 }
 
 Dhcpv4Srv::~Dhcpv4Srv() {
+    stopWorkers();
     IfaceMgr::instance().closeSockets();
 }
 
@@ -136,12 +147,42 @@ Dhcpv4Srv::shutdown() {
 
 Pkt4Ptr
 Dhcpv4Srv::receivePacket(int timeout) {
-    return (IfaceMgr::instance().receive4(timeout));
+    // The packets received by the previous call are returned before
+    // waiting for the new ones.
+    if (received_pos_ >= received_.size()) {
+        received_.clear();
+        received_pos_ = 0;
+        IfaceMgr::instance().receive4Batch(received_,
+                                           IfaceMgr::RECEIVE_BATCH_SIZE,
+                                           timeout);
+    }
+    if (received_pos_ < received_.size()) {
+        Pkt4Ptr pkt;
+        pkt.swap(received_[received_pos_++]);
+        return (pkt);
+    }
+    return (Pkt4Ptr());
 }
 
 void
 Dhcpv4Srv::sendPacket(const Pkt4Ptr& packet) {
-    IfaceMgr::instance().send(packet);
+    // The responses produced by the thread receiving the packets are sent
+    // together, when all received packets have been processed. The worker
+    // threads send the responses immediately.
+    if (queue_responses_) {
+        IfaceMgr::instance().queueSend(packet);
+    } else {
+        IfaceMgr::instance().send(packet);
+    }
+}
+
+void
+Dhcpv4Srv::sendQueuedPackets() {
+    try {
+        IfaceMgr::instance().flushSendQueue();
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL).arg(e.what());
+    }
 }
 
 bool
@@ -151,9 +192,14 @@ Dhcpv4Srv::run() {
         //cppcheck-suppress variableScope This is temporary anyway
         const int timeout = 1000;
 
-        // client's message and server's response
+        // client's message
         Pkt4Ptr query;
-        Pkt4Ptr rsp;
+
+        // Send the responses to the packets received by the last call to
+        // receivePacket before waiting for the new packets.
+        if (received_pos_ >= received_.size()) {
+            sendQueuedPackets();
+        }
 
         try {
             query = receivePacket(timeout);
@@ -181,72 +227,148 @@ Dhcpv4Srv::run() {
         // terminate.
         handleSignal();
 
+        // Reclaim expired leases if it is time to do so.
+        reclaimExpiredLeases();
+
         // Timeout may be reached or signal received, which breaks select()
         // with no reception ocurred
         if (!query) {
             continue;
         }
 
-        // In order to parse the DHCP options, the server needs to use some
-        // configuration information such as: existing option spaces, option
-        // definitions etc. This is the kind of information which is not
-        // available in the libdhcp, so we need to supply our own implementation
-        // of the option parsing function here, which would rely on the
-        // configuration data.
-        query->setCallback(boost::bind(&Dhcpv4Srv::unpackOptions, this,
-                                       _1, _2, _3));
+        // Make sure that the number of packet processing threads is in
+        // line with the current configuration. The configuration may have
+        // been changed by the signal handler.
+        startWorkers();
+        queue_responses_ = (worker_pool_.getThreadCount() == 0);
+
+        // Process the packet, either by one of the worker threads or by
+        // this thread if no worker threads are configured.
+        if (!worker_pool_.add(boost::bind(&Dhcpv4Srv::processPacket, this,
+                                          query))) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_QUEUE_FULL)
+                .arg(query->getTransid())
+                .arg(query->getIface());
+        }
+    }
 
-        bool skip_unpack = false;
+    // Process the queued packets before returning.
+    stopWorkers();
+    sendQueuedPackets();
 
-        // The packet has just been received so contains the uninterpreted wire
-        // data; execute callouts registered for buffer4_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    return (true);
+}
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+void
+Dhcpv4Srv::processPacket(Pkt4Ptr query) {
+    // server's response
+    Pkt4Ptr rsp;
+    // The packet and its callout handle are not kept by this thread after
+    // the packet has been processed.
+    CalloutHandleReleaser<Pkt4Ptr> callout_handle_releaser;
+
+
+    // In order to parse the DHCP options, the server needs to use some
+    // configuration information such as: existing option spaces, option
+    // definitions etc. This is the kind of information which is not
+    // available in the libdhcp, so we need to supply our own implementation
+    // of the option parsing function here, which would rely on the
+    // configuration data.
+    query->setCallback(boost::bind(&Dhcpv4Srv::unpackOptions, this,
+                                   _1, _2, _3));
+
+    // Most of the options are not needed to process the packet, or the
+    // packet is dropped before they are needed, so the options are only
+    // created when they are first accessed.
+    query->setLazyUnpack(true);
+
+    bool skip_unpack = false;
+
+    // The packet has just been received so contains the uninterpreted wire
+    // data; execute callouts registered for buffer4_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query4", query);
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query4", query);
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_buffer4_receive_,
-                                       *callout_handle);
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_buffer4_receive_,
+                                   *callout_handle);
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to parse the packet, so skip at this
-            // stage means that callouts did the parsing already, so server
-            // should skip parsing.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_BUFFER_RCVD_SKIP);
-                skip_unpack = true;
-            }
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to parse the packet, so skip at this
+        // stage means that callouts did the parsing already, so server
+        // should skip parsing.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_BUFFER_RCVD_SKIP);
+            skip_unpack = true;
+        }
 
-            callout_handle->getArgument("query4", query);
+        callout_handle->getArgument("query4", query);
+    }
+
+    // Unpack the packet information unless the buffer4_receive callouts
+    // indicated they did it
+    if (!skip_unpack) {
+        try {
+            query->unpack();
+        } catch (const std::exception& e) {
+            // Failed to parse the packet.
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                      DHCP4_PACKET_PARSE_FAIL).arg(e.what());
+            return;
         }
+    }
 
-        // Unpack the packet information unless the buffer4_receive callouts
-        // indicated they did it
-        if (!skip_unpack) {
-            try {
-                query->unpack();
-            } catch (const std::exception& e) {
-                // Failed to parse the packet.
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
-                          DHCP4_PACKET_PARSE_FAIL).arg(e.what());
-                continue;
-            }
+    // Two packets sent by the same client must not be processed at the
+    // same time by different worker threads, because they would race for
+    // the same leases. The client is identified by its hardware address,
+    // which is present in every packet. If another packet from this
+    // client is being processed, this one is most likely a retransmission
+    // and is dropped (see Dhcpv6Srv::processPacket). The lock is held
+    // until this function returns.
+    HWAddrPtr hwaddr = query->getHWAddr();
+    ClientLockMgr::Locker client_lock(client_lock_mgr_, hwaddr ?
+                                      hwaddr->hwaddr_ :
+                                      ClientLockMgr::ClientId(), false);
+    if (client_lock.busy()) {
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_CLIENT_BUSY)
+            .arg(query->getTransid())
+            .arg(query->getIface());
+        return;
+    }
+
+    // The context holds the information about the query obtained by the
+    // processing stages, e.g. the selected subnet.
+    QueryContext4 ctx(query);
+
+    // The options are created when they are first accessed, so a malformed
+    // option may be found by any of the steps below. Such a packet is
+    // dropped as if it could not be parsed.
+    try {
+        // The callouts catch and log as errors the exceptions raised while
+        // they run, so all options are created before the query is passed
+        // to any of them.
+        if (HooksManager::calloutsPresent(hook_index_pkt4_receive_) ||
+            HooksManager::calloutsPresent(hook_index_subnet4_select_) ||
+            HooksManager::calloutsPresent(Hooks.hook_index_lease4_release_)) {
+            query->unpackIndexedOptions();
         }
 
-        // Assign this packet to one or more classes if needed. We need to do
-        // this before calling accept(), because getSubnet4() may need client
-        // class information.
+        // Assign this packet to one or more classes if needed. We need to
+        // do this before calling accept(), because getSubnet4() may need
+        // client class information.
         classifyPacket(query);
 
-        // Check whether the message should be further processed or discarded.
-        // There is no need to log anything here. This function logs by itself.
-        if (!accept(query)) {
-            continue;
+        // Check whether the message should be further processed or
+        // discarded. There is no need to log anything here. This function
+        // logs by itself.
+        if (!accept(ctx)) {
+            return;
         }
 
         // We have sanity checked (in accept() that the Message Type option
@@ -259,179 +381,236 @@ Dhcpv4Srv::run() {
         LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_QUERY_DATA)
             .arg(type)
             .arg(query->toText());
+    } catch (const isc::Exception& e) {
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                  DHCP4_PACKET_PARSE_FAIL).arg(e.what());
+        return;
+    }
 
-        // Let's execute all callouts registered for pkt4_receive
-        if (HooksManager::calloutsPresent(hook_index_pkt4_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
-
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+    // Let's execute all callouts registered for pkt4_receive
+    if (HooksManager::calloutsPresent(hook_index_pkt4_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query4", query);
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            // Call callouts
-            HooksManager::callCallouts(hook_index_pkt4_receive_,
-                                       *callout_handle);
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query4", query);
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to process the packet, so skip at this
-            // stage means drop.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_RCVD_SKIP);
-                continue;
-            }
+        // Call callouts
+        HooksManager::callCallouts(hook_index_pkt4_receive_,
+                                   *callout_handle);
 
-            callout_handle->getArgument("query4", query);
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to process the packet, so skip at this
+        // stage means drop.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_RCVD_SKIP);
+            return;
         }
 
-        try {
-            switch (query->getType()) {
-            case DHCPDISCOVER:
-                rsp = processDiscover(query);
-                break;
-
-            case DHCPREQUEST:
-                // Note that REQUEST is used for many things in DHCPv4: for
-                // requesting new leases, renewing existing ones and even
-                // for rebinding.
-                rsp = processRequest(query);
-                break;
-
-            case DHCPRELEASE:
-                processRelease(query);
-                break;
-
-            case DHCPDECLINE:
-                processDecline(query);
-                break;
-
-            case DHCPINFORM:
-                rsp = processInform(query);
-                break;
-
-            default:
-                // Only action is to output a message if debug is enabled,
-                // and that is covered by the debug statement before the
-                // "switch" statement.
-                ;
-            }
-        } catch (const isc::Exception& e) {
-
-            // Catch-all exception (at least for ones based on the isc Exception
-            // class, which covers more or less all that are explicitly raised
-            // in the Kea code).  Just log the problem and ignore the packet.
-            // (The problem is logged as a debug message because debug is
-            // disabled by default - it prevents a DDOS attack based on the
-            // sending of problem packets.)
-            if (dhcp4_logger.isDebugEnabled(DBG_DHCP4_BASIC)) {
-                std::string source = "unknown";
-                HWAddrPtr hwptr = query->getHWAddr();
-                if (hwptr) {
-                    source = hwptr->toText();
-                }
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC,
-                          DHCP4_PACKET_PROCESS_FAIL)
-                    .arg(source).arg(e.what());
+        callout_handle->getArgument("query4", query);
+
+        // The callouts may have replaced the query or modified it in place,
+        // e.g. changed its giaddr, so the subnet selected while accepting
+        // the query must not be used for its processing.
+        ctx = QueryContext4(query);
+    }
+
+    try {
+        switch (query->getType()) {
+        case DHCPDISCOVER:
+            rsp = processDiscover(ctx);
+            break;
+
+        case DHCPREQUEST:
+            // Note that REQUEST is used for many things in DHCPv4: for
+            // requesting new leases, renewing existing ones and even
+            // for rebinding.
+            rsp = processRequest(ctx);
+            break;
+
+        case DHCPRELEASE:
+            processRelease(query);
+            break;
+
+        case DHCPDECLINE:
+            processDecline(query);
+            break;
+
+        case DHCPINFORM:
+            rsp = processInform(ctx);
+            break;
+
+        default:
+            // Only action is to output a message if debug is enabled,
+            // and that is covered by the debug statement before the
+            // "switch" statement.
+            ;
+        }
+    } catch (const isc::Exception& e) {
+
+        // Catch-all exception (at least for ones based on the isc Exception
+        // class, which covers more or less all that are explicitly raised
+        // in the Kea code).  Just log the problem and ignore the packet.
+        // (The problem is logged as a debug message because debug is
+        // disabled by default - it prevents a DDOS attack based on the
+        // sending of problem packets.)
+        if (dhcp4_logger.isDebugEnabled(DBG_DHCP4_BASIC)) {
+            std::string source = "unknown";
+            HWAddrPtr hwptr = query->getHWAddr();
+            if (hwptr) {
+                source = hwptr->toText();
             }
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC,
+                      DHCP4_PACKET_PROCESS_FAIL)
+                .arg(source).arg(e.what());
         }
+    }
 
-        if (!rsp) {
-            continue;
-        }
+    if (!rsp) {
+        return;
+    }
 
-        // Let's do class specific processing. This is done before
-        // pkt4_send.
-        //
-        /// @todo: decide whether we want to add a new hook point for
-        /// doing class specific processing.
-        if (!classSpecificProcessing(query, rsp)) {
+    // Let's do class specific processing. This is done before
+    // pkt4_send.
+    //
+    /// @todo: decide whether we want to add a new hook point for
+    /// doing class specific processing.
+    try {
+        if (!classSpecificProcessing(ctx, rsp)) {
             /// @todo add more verbosity here
-            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC, DHCP4_CLASS_PROCESSING_FAILED);
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC,
+                      DHCP4_CLASS_PROCESSING_FAILED);
 
-            continue;
+            return;
         }
+    } catch (const isc::Exception& e) {
+        // The options of the query which have not been accessed by the
+        // previous steps may still be malformed.
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                  DHCP4_PACKET_PARSE_FAIL).arg(e.what());
+        return;
+    }
 
-        // Specifies if server should do the packing
-        bool skip_pack = false;
+    // Specifies if server should do the packing
+    bool skip_pack = false;
+
+    // Execute all callouts registered for pkt4_send
+    if (HooksManager::calloutsPresent(hook_index_pkt4_send_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete all previous arguments
+        callout_handle->deleteAllArguments();
+
+        // Clear skip flag if it was set in previous callouts
+        callout_handle->setSkip(false);
+
+        // The callouts may modify the options of the response, so their
+        // on-wire format can't be used.
+        rsp->clearPackedOptions();
+
+        // Set our response
+        callout_handle->setArgument("response4", rsp);
+
+        // Call all installed callouts
+        HooksManager::callCallouts(hook_index_pkt4_send_,
+                                   *callout_handle);
 
-        // Execute all callouts registered for pkt4_send
-        if (HooksManager::calloutsPresent(hook_index_pkt4_send_)) {
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to send the packet, so skip at this
+        // stage means "drop response".
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_SEND_SKIP);
+            skip_pack = true;
+        }
+    }
+
+    if (!skip_pack) {
+        try {
+            rsp->pack();
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+                .arg(e.what());
+        }
+    }
+
+    try {
+        // Now all fields and options are constructed into output wire buffer.
+        // Option objects modification does not make sense anymore. Hooks
+        // can only manipulate wire buffer at this stage.
+        // Let's execute all callouts registered for buffer4_send
+        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_send_)) {
             CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Delete all previous arguments
+            // Delete previously set arguments
             callout_handle->deleteAllArguments();
 
-            // Clear skip flag if it was set in previous callouts
-            callout_handle->setSkip(false);
-
-            // Set our response
+            // Pass incoming packet as argument
             callout_handle->setArgument("response4", rsp);
 
-            // Call all installed callouts
-            HooksManager::callCallouts(hook_index_pkt4_send_,
+            // Call callouts
+            HooksManager::callCallouts(Hooks.hook_index_buffer4_send_,
                                        *callout_handle);
 
             // Callouts decided to skip the next processing step. The next
-            // processing step would to send the packet, so skip at this
-            // stage means "drop response".
+            // processing step would to parse the packet, so skip at this
+            // stage means drop.
             if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_SEND_SKIP);
-                skip_pack = true;
+                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS,
+                          DHCP4_HOOK_BUFFER_SEND_SKIP);
+                return;
             }
-        }
 
-        if (!skip_pack) {
-            try {
-                rsp->pack();
-            } catch (const std::exception& e) {
-                LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
-                    .arg(e.what());
-            }
+            callout_handle->getArgument("response4", rsp);
         }
 
-        try {
-            // Now all fields and options are constructed into output wire buffer.
-            // Option objects modification does not make sense anymore. Hooks
-            // can only manipulate wire buffer at this stage.
-            // Let's execute all callouts registered for buffer4_send
-            if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_send_)) {
-                CalloutHandlePtr callout_handle = getCalloutHandle(query);
-
-                // Delete previously set arguments
-                callout_handle->deleteAllArguments();
-
-                // Pass incoming packet as argument
-                callout_handle->setArgument("response4", rsp);
-
-                // Call callouts
-                HooksManager::callCallouts(Hooks.hook_index_buffer4_send_,
-                                           *callout_handle);
-
-                // Callouts decided to skip the next processing step. The next
-                // processing step would to parse the packet, so skip at this
-                // stage means drop.
-                if (callout_handle->getSkip()) {
-                    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS,
-                              DHCP4_HOOK_BUFFER_SEND_SKIP);
-                    continue;
-                }
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA,
+                  DHCP4_RESPONSE_DATA)
+            .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
 
-                callout_handle->getArgument("response4", rsp);
-            }
+        sendPacket(rsp);
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+            .arg(e.what());
+    }
+}
 
-            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA,
-                      DHCP4_RESPONSE_DATA)
-                .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+void
+Dhcpv4Srv::startWorkers() {
+    const size_t threads = CfgMgr::instance().workerThreads();
+    if (worker_pool_.getThreadCount() != threads) {
+        // The standard option definitions are created on first use. Make
+        // sure they are created before the worker threads start using them.
+        LibDHCP::getOptionDefs(Option::V4);
 
-            sendPacket(rsp);
-        } catch (const std::exception& e) {
-            LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
-                .arg(e.what());
-        }
+        worker_pool_.stop();
+        worker_pool_.start(threads, threads * MAX_QUEUED_PACKETS_PER_THREAD);
     }
+}
 
-    return (true);
+void
+Dhcpv4Srv::stopWorkers() {
+    worker_pool_.stop();
+}
+
+void
+Dhcpv4Srv::reclaimExpiredLeases() {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+    const uint32_t wait_time = cfg_mgr.reclaimTimerWaitTime();
+    const time_t now = time(NULL);
+    if ((wait_time == 0) || !alloc_engine_ || (now < next_reclaim_time_)) {
+        return;
+    }
+    next_reclaim_time_ = now + wait_time;
+
+    try {
+        alloc_engine_->reclaimExpiredLeases4(cfg_mgr.maxReclaimLeases(),
+                                             cfg_mgr.maxReclaimTime());
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp4_logger, DHCP4_RECLAIM_EXPIRED_LEASES_FAIL)
+            .arg(ex.what());
+    }
 }
 
 string
@@ -455,7 +634,7 @@ Dhcpv4Srv::srvidToString(const OptionPtr& srvid) {
 }
 
 isc::dhcp_ddns::D2Dhcid
-Dhcpv4Srv::computeDhcid(const Lease4Ptr& lease) {
+Dhcpv4Srv::computeDhcid(const ConstLease4Ptr& lease) {
     if (!lease) {
         isc_throw(DhcidComputeError, "a pointer to the lease must be not"
                   " NULL to compute DHCID");
@@ -569,11 +748,11 @@ Dhcpv4Srv::appendServerID(const Pkt4Ptr& response) {
 }
 
 void
-Dhcpv4Srv::appendRequestedOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
+Dhcpv4Srv::appendRequestedOptions(QueryContext4& ctx, Pkt4Ptr& msg) {
 
     // Get the subnet relevant for the client. We will need it
     // to get the options associated with it.
-    Subnet4Ptr subnet = selectSubnet(question);
+    Subnet4Ptr subnet = getSubnet(ctx);
     // If we can't find the subnet for the client there is no way
     // to get the options to be sent to a client. We don't log an
     // error because it will be logged by the assignLease method
@@ -585,7 +764,7 @@ Dhcpv4Srv::appendRequestedOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
     // try to get the 'Parameter Request List' option which holds the
     // codes of requested options.
     OptionUint8ArrayPtr option_prl = boost::dynamic_pointer_cast<
-        OptionUint8Array>(question->getOption(DHO_DHCP_PARAMETER_REQUEST_LIST));
+        OptionUint8Array>(ctx.query_->getOption(DHO_DHCP_PARAMETER_REQUEST_LIST));
     // If there is no PRL option in the message from the client then
     // there is nothing to do.
     if (!option_prl) {
@@ -595,23 +774,23 @@ Dhcpv4Srv::appendRequestedOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
     // Get the codes of requested options.
     const std::vector<uint8_t>& requested_opts = option_prl->getValues();
     // For each requested option code get the instance of the option
-    // to be returned to the client.
+    // to be returned to the client. The subnet holds the options in the
+    // on-wire format, which is copied to the response.
     for (std::vector<uint8_t>::const_iterator opt = requested_opts.begin();
          opt != requested_opts.end(); ++opt) {
-        if (!msg->getOption(*opt)) {
-            Subnet::OptionDescriptor desc =
-                subnet->getOptionDescriptor("dhcp4", *opt);
-            if (desc.option && !msg->getOption(*opt)) {
-                msg->addOption(desc.option);
+        if (!msg->hasOption(*opt)) {
+            PackedOption packed = subnet->getPackedOption(*opt);
+            if (packed.option) {
+                msg->addPackedOption(packed);
             }
         }
     }
 }
 
 void
-Dhcpv4Srv::appendRequestedVendorOptions(const Pkt4Ptr& question, Pkt4Ptr& answer) {
+Dhcpv4Srv::appendRequestedVendorOptions(QueryContext4& ctx, Pkt4Ptr& answer) {
     // Get the configured subnet suitable for the incoming packet.
-    Subnet4Ptr subnet = selectSubnet(question);
+    Subnet4Ptr subnet = getSubnet(ctx);
     // Leave if there is no subnet matching the incoming packet.
     // There is no need to log the error message here because
     // it will be logged in the assignLease() when it fails to
@@ -623,7 +802,7 @@ Dhcpv4Srv::appendRequestedVendorOptions(const Pkt4Ptr& question, Pkt4Ptr& answer
 
     // Try to get the vendor option
     boost::shared_ptr<OptionVendor> vendor_req =
-        boost::dynamic_pointer_cast<OptionVendor>(question->getOption(DHO_VIVSO_SUBOPTIONS));
+        boost::dynamic_pointer_cast<OptionVendor>(ctx.query_->getOption(DHO_VIVSO_SUBOPTIONS));
     if (!vendor_req) {
         return;
     }
@@ -666,7 +845,7 @@ Dhcpv4Srv::appendRequestedVendorOptions(const Pkt4Ptr& question, Pkt4Ptr& answer
 
 
 void
-Dhcpv4Srv::appendBasicOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
+Dhcpv4Srv::appendBasicOptions(QueryContext4& ctx, Pkt4Ptr& msg) {
     // Identify options that we always want to send to the
     // client (if they are configured).
     static const uint16_t required_options[] = {
@@ -678,7 +857,7 @@ Dhcpv4Srv::appendBasicOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
         sizeof(required_options) / sizeof(required_options[0]);
 
     // Get the subnet.
-    Subnet4Ptr subnet = selectSubnet(question);
+    Subnet4Ptr subnet = getSubnet(ctx);
     if (!subnet) {
         return;
     }
@@ -686,13 +865,12 @@ Dhcpv4Srv::appendBasicOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
     // Try to find all 'required' options in the outgoing
     // message. Those that are not present will be added.
     for (int i = 0; i < required_options_size; ++i) {
-        OptionPtr opt = msg->getOption(required_options[i]);
-        if (!opt) {
+        if (!msg->hasOption(required_options[i])) {
             // Check whether option has been configured.
-            Subnet::OptionDescriptor desc =
-                subnet->getOptionDescriptor("dhcp4", required_options[i]);
-            if (desc.option) {
-                msg->addOption(desc.option);
+            PackedOption packed =
+                subnet->getPackedOption(required_options[i]);
+            if (packed.option) {
+                msg->addPackedOption(packed);
             }
         }
     }
@@ -823,7 +1001,7 @@ Dhcpv4Srv::processHostnameOption(const OptionStringPtr& opt_hostname,
 
 void
 Dhcpv4Srv::createNameChangeRequests(const Lease4Ptr& lease,
-                                    const Lease4Ptr& old_lease) {
+                                    const ConstLease4Ptr& old_lease) {
     if (!lease) {
         isc_throw(isc::Unexpected,
                   "NULL lease specified when creating NameChangeRequest");
@@ -870,7 +1048,7 @@ Dhcpv4Srv::createNameChangeRequests(const Lease4Ptr& lease,
 void
 Dhcpv4Srv::
 queueNameChangeRequest(const isc::dhcp_ddns::NameChangeType chg_type,
-                       const Lease4Ptr& lease) {
+                       const ConstLease4Ptr& lease) {
     // The hostname must not be empty, and at least one type of update
     // should be requested.
     if (!lease || lease->hostname_.empty() ||
@@ -908,10 +1086,11 @@ queueNameChangeRequest(const isc::dhcp_ddns::NameChangeType chg_type,
 }
 
 void
-Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
+Dhcpv4Srv::assignLease(QueryContext4& ctx, Pkt4Ptr& answer) {
+    const Pkt4Ptr& question = ctx.query_;
 
     // We need to select a subnet the client is connected in.
-    Subnet4Ptr subnet = selectSubnet(question);
+    Subnet4Ptr subnet = getSubnet(ctx);
     if (!subnet) {
         // This particular client is out of luck today. We do not have
         // information about the subnet he is connected to. This likely means
@@ -932,10 +1111,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
     }
 
     // Set up siaddr. Perhaps assignLease is not the best place to call this
-    // as siaddr has nothing to do with a lease, but otherwise we would have
-    // to select subnet twice (performance hit) or update too many functions
-    // at once.
-    /// @todo: move subnet selection to a common code
+    // as siaddr has nothing to do with a lease.
     answer->setSiaddr(subnet->getSiaddr());
 
     LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_SUBNET_SELECTED)
@@ -979,7 +1155,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
     // the client is in the INIT-REBOOT state in which the server has to
     // determine whether the client's notion of the address has to be verified.
     if (!fake_allocation && !opt_serverid && opt_requested_address) {
-        Lease4Ptr lease = LeaseMgrFactory::instance().getLease4(hint);
+        ConstLease4Ptr lease = LeaseMgrFactory::instance().getConstLease4(hint);
         if (!lease) {
             LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
                       DHCP4_INVALID_ADDRESS_INIT_REBOOT)
@@ -1031,7 +1207,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
     // may be used instead. If fake_allocation is set to false, the lease will
     // be inserted into the LeaseMgr as well.
     /// @todo pass the actual FQDN data.
-    Lease4Ptr old_lease;
+    ConstLease4Ptr old_lease;
     Lease4Ptr lease = alloc_engine_->allocateLease4(subnet, client_id, hwaddr,
                                                     hint, fqdn_fwd, fqdn_rev,
                                                     hostname,
@@ -1270,6 +1446,13 @@ Dhcpv4Srv::getNetmaskOption(const Subnet4Ptr& subnet) {
 
 Pkt4Ptr
 Dhcpv4Srv::processDiscover(Pkt4Ptr& discover) {
+    QueryContext4 ctx(discover);
+    return (processDiscover(ctx));
+}
+
+Pkt4Ptr
+Dhcpv4Srv::processDiscover(QueryContext4& ctx) {
+    Pkt4Ptr& discover = ctx.query_;
 
     sanityCheck(discover, FORBIDDEN);
 
@@ -1285,16 +1468,16 @@ Dhcpv4Srv::processDiscover(Pkt4Ptr& discover) {
     // updating DNS when the client sends REQUEST message.
     processClientName(discover, offer);
 
-    assignLease(discover, offer);
+    assignLease(ctx, offer);
 
     // Adding any other options makes sense only when we got the lease.
     if (offer->getYiaddr() != IOAddress("0.0.0.0")) {
-        appendRequestedOptions(discover, offer);
-        appendRequestedVendorOptions(discover, offer);
+        appendRequestedOptions(ctx, offer);
+        appendRequestedVendorOptions(ctx, offer);
         // There are a few basic options that we always want to
         // include in the response. If client did not request
         // them we append them for him.
-        appendBasicOptions(discover, offer);
+        appendBasicOptions(ctx, offer);
     }
 
     // Set the src/dest IP address, port and interface for the outgoing
@@ -1308,6 +1491,13 @@ Dhcpv4Srv::processDiscover(Pkt4Ptr& discover) {
 
 Pkt4Ptr
 Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
+    QueryContext4 ctx(request);
+    return (processRequest(ctx));
+}
+
+Pkt4Ptr
+Dhcpv4Srv::processRequest(QueryContext4& ctx) {
+    Pkt4Ptr& request = ctx.query_;
 
     /// @todo Uncomment this (see ticket #3116)
     /// sanityCheck(request, MANDATORY);
@@ -1327,16 +1517,16 @@ Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
     // Note that we treat REQUEST message uniformly, regardless if this is a
     // first request (requesting for new address), renewing existing address
     // or even rebinding.
-    assignLease(request, ack);
+    assignLease(ctx, ack);
 
     // Adding any other options makes sense only when we got the lease.
     if (ack->getYiaddr() != IOAddress("0.0.0.0")) {
-        appendRequestedOptions(request, ack);
-        appendRequestedVendorOptions(request, ack);
+        appendRequestedOptions(ctx, ack);
+        appendRequestedVendorOptions(ctx, ack);
         // There are a few basic options that we always want to
         // include in the response. If client did not request
         // them we append them for him.
-        appendBasicOptions(request, ack);
+        appendBasicOptions(ctx, ack);
     }
 
     // Set the src/dest IP address, port and interface for the outgoing
@@ -1431,6 +1621,9 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
             bool success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
 
             if (success) {
+                // Make the address available for allocation again.
+                alloc_engine_->leaseRemoved(lease);
+
                 // Release successful
                 LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_RELEASE)
                     .arg(lease->addr_.toText())
@@ -1465,14 +1658,22 @@ Dhcpv4Srv::processDecline(Pkt4Ptr& /* decline */) {
 
 Pkt4Ptr
 Dhcpv4Srv::processInform(Pkt4Ptr& inform) {
+    QueryContext4 ctx(inform);
+    return (processInform(ctx));
+}
+
+Pkt4Ptr
+Dhcpv4Srv::processInform(QueryContext4& ctx) {
+    Pkt4Ptr& inform = ctx.query_;
+
     // DHCPINFORM MUST not include server identifier.
     sanityCheck(inform, FORBIDDEN);
 
     Pkt4Ptr ack = Pkt4Ptr(new Pkt4(DHCPACK, inform->getTransid()));
     copyDefaultFields(inform, ack);
-    appendRequestedOptions(inform, ack);
-    appendRequestedVendorOptions(inform, ack);
-    appendBasicOptions(inform, ack);
+    appendRequestedOptions(ctx, ack);
+    appendRequestedVendorOptions(ctx, ack);
+    appendBasicOptions(ctx, ack);
     adjustIfaceData(inform, ack);
 
     // There are cases for the DHCPINFORM that the server receives it via
@@ -1601,8 +1802,25 @@ Dhcpv4Srv::selectSubnet(const Pkt4Ptr& question) const {
     return (subnet);
 }
 
+Subnet4Ptr
+Dhcpv4Srv::getSubnet(QueryContext4& ctx) const {
+    if (!ctx.subnet_selected_) {
+        ctx.subnet_ = selectSubnet(ctx.query_);
+        ctx.subnet_selected_ = true;
+    }
+    return (ctx.subnet_);
+}
+
 bool
 Dhcpv4Srv::accept(const Pkt4Ptr& query) const {
+    QueryContext4 ctx(query);
+    return (accept(ctx));
+}
+
+bool
+Dhcpv4Srv::accept(QueryContext4& ctx) const {
+    const Pkt4Ptr& query = ctx.query_;
+
     // Check that the message type is accepted by the server. We rely on the
     // function called to log a message if needed.
     if (!acceptMessageType(query)) {
@@ -1610,7 +1828,7 @@ Dhcpv4Srv::accept(const Pkt4Ptr& query) const {
     }
     // Check if the message from directly connected client (if directly
     // connected) should be dropped or processed.
-    if (!acceptDirectRequest(query)) {
+    if (!acceptDirectRequest(ctx)) {
         LOG_INFO(dhcp4_logger, DHCP4_NO_SUBNET_FOR_DIRECT_CLIENT)
             .arg(query->getTransid())
             .arg(query->getIface());
@@ -1630,7 +1848,8 @@ Dhcpv4Srv::accept(const Pkt4Ptr& query) const {
 }
 
 bool
-Dhcpv4Srv::acceptDirectRequest(const Pkt4Ptr& pkt) const {
+Dhcpv4Srv::acceptDirectRequest(QueryContext4& ctx) const {
+    const Pkt4Ptr& pkt = ctx.query_;
     try {
         if (pkt->isRelayed()) {
             return (true);
@@ -1656,7 +1875,7 @@ Dhcpv4Srv::acceptDirectRequest(const Pkt4Ptr& pkt) const {
         return (false);
     }
     static const IOAddress bcast("255.255.255.255");
-    return ((pkt->getLocalAddr() != bcast || selectSubnet(pkt)));
+    return ((pkt->getLocalAddr() != bcast || getSubnet(ctx)));
 }
 
 bool
@@ -1801,17 +2020,18 @@ Dhcpv4Srv::unpackOptions(const OptionBuffer& buf,
                          isc::dhcp::OptionCollection& options) {
     size_t offset = 0;
 
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp4") {
-        // Get the list of stdandard option definitions.
-        option_defs = LibDHCP::getOptionDefs(Option::V4);
-    } else if (!option_space.empty()) {
-        OptionDefContainerPtr option_defs_ptr =
-            CfgMgr::instance().getOptionDefs(option_space);
-        if (option_defs_ptr != NULL) {
-            option_defs = *option_defs_ptr;
-        }
-    }
+    // The option definitions are referenced rather than copied because
+    // this function is called for every received packet and for every
+    // option which encapsulates other options. The pointer holds the
+    // configured definitions while they are used.
+    OptionDefContainerPtr option_defs_ptr;
+    if (!option_space.empty() && (option_space != "dhcp4")) {
+        option_defs_ptr = CfgMgr::instance().getOptionDefs(option_space);
+    }
+    // Get the list of stdandard option definitions for the dhcp4 space.
+    const OptionDefContainer& option_defs = (option_space == "dhcp4" ?
+        LibDHCP::getOptionDefs(Option::V4) :
+        (option_defs_ptr ? *option_defs_ptr : empty_option_defs));
     // Get the search index #1. It allows to search for option definitions
     // using option code.
     const OptionDefContainerTypeIndex& idx = option_defs.get<1>();
@@ -1934,9 +2154,10 @@ void Dhcpv4Srv::classifyPacket(const Pkt4Ptr& pkt) {
     }
 }
 
-bool Dhcpv4Srv::classSpecificProcessing(const Pkt4Ptr& query, const Pkt4Ptr& rsp) {
+bool Dhcpv4Srv::classSpecificProcessing(QueryContext4& ctx, const Pkt4Ptr& rsp) {
+    const Pkt4Ptr& query = ctx.query_;
 
-    Subnet4Ptr subnet = selectSubnet(query);
+    Subnet4Ptr subnet = getSubnet(ctx);
     if (!subnet) {
         return (true);
     }
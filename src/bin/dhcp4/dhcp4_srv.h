@@ -25,8 +25,10 @@
 #include <dhcpsrv/d2_client_mgr.h>
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/client_lock_mgr.h>
 #include <hooks/callout_handle.h>
 #include <dhcpsrv/daemon.h>
+#include <dhcpsrv/worker_pool.h>
 
 #include <boost/noncopyable.hpp>
 
@@ -43,6 +45,33 @@ public:
         isc::Exception(file, line, what) { };
 };
 
+/// @brief Context of the DHCPv4 query being processed.
+///
+/// The context is created when the server starts processing the query and
+/// it is passed to the functions processing it. It holds the information
+/// used by more than one processing stage, so as this information is
+/// obtained once for the query. In particular, the subnet is selected and
+/// the subnet4_select callouts are called once for the query.
+struct QueryContext4 {
+    /// @brief Constructor.
+    ///
+    /// @param query query being processed
+    explicit QueryContext4(const Pkt4Ptr& query)
+        : query_(query), subnet_selected_(false) {
+    }
+
+    /// @brief Query being processed.
+    Pkt4Ptr query_;
+
+    /// @brief Subnet selected for the query.
+    Subnet4Ptr subnet_;
+
+    /// @brief Indicates if the subnet has been selected.
+    ///
+    /// The subnet is selected when it is needed for the first time.
+    bool subnet_selected_;
+};
+
 /// @brief DHCPv4 server service.
 ///
 /// This singleton class represents DHCPv4 server. It contains all
@@ -95,14 +124,30 @@ public:
 
     /// @brief Main server processing loop.
     ///
-    /// Main server processing loop. Receives incoming packets, verifies
-    /// their correctness, generates appropriate answer (if needed) and
-    /// transmits respones.
+    /// Main server processing loop. Receives incoming packets and passes
+    /// them to @c Dhcpv4Srv::processPacket. If the server is configured to
+    /// use worker threads, the packets are queued for processing by these
+    /// threads. Otherwise, they are processed by the thread running this
+    /// loop.
     ///
     /// @return true, if being shut down gracefully, fail if experienced
     ///         critical error.
     bool run();
 
+    /// @brief Processes a single received packet.
+    ///
+    /// Verifies the packet's correctness, generates appropriate answer (if
+    /// needed) and transmits the response. All hook points for the packet
+    /// are called within this function, so as the callout handle associated
+    /// with the packet is used by a single thread.
+    ///
+    /// Packets carrying the same hardware address are never processed
+    /// concurrently: the function drops the packet if another packet from
+    /// the same client is being processed by other thread.
+    ///
+    /// @param query A pointer to the packet received from the client.
+    void processPacket(Pkt4Ptr query);
+
     /// @brief Instructs the server to shut down.
     void shutdown();
 
@@ -204,6 +249,17 @@ protected:
     /// the message should be discarded.
     bool accept(const Pkt4Ptr& query) const;
 
+    /// @brief Checks whether received message should be processed or discarded.
+    ///
+    /// This variant of the function uses the context of the query, so as the
+    /// subnet selected for the query is reused by the processing stages.
+    ///
+    /// @param ctx Context of the received message.
+    ///
+    /// @return true if the message should be further processed, or false if
+    /// the message should be discarded.
+    bool accept(QueryContext4& ctx) const;
+
     /// @brief Check if a message sent by directly connected client should be
     /// accepted or discared.
     ///
@@ -227,11 +283,11 @@ protected:
     /// for which the suitable subnet exists (is configured).
     /// - all DHCPINFORM messages with source address or ciaddr set.
     ///
-    /// @param query Message sent by a client.
+    /// @param ctx Context of the message sent by a client.
     ///
     /// @return true if message is accepted for further processing, false
     /// otherwise.
-    bool acceptDirectRequest(const Pkt4Ptr& query) const;
+    bool acceptDirectRequest(QueryContext4& ctx) const;
 
     /// @brief Check if received message type is valid for the server to
     /// process.
@@ -290,6 +346,13 @@ protected:
     /// @return OFFER message or NULL
     Pkt4Ptr processDiscover(Pkt4Ptr& discover);
 
+    /// @brief Processes incoming DISCOVER and returns response.
+    ///
+    /// @param ctx context of the DISCOVER message received from client
+    ///
+    /// @return OFFER message or NULL
+    Pkt4Ptr processDiscover(QueryContext4& ctx);
+
     /// @brief Processes incoming REQUEST and returns REPLY response.
     ///
     /// Processes incoming REQUEST message and verifies that its sender
@@ -304,6 +367,13 @@ protected:
     /// @return ACK or NAK message
     Pkt4Ptr processRequest(Pkt4Ptr& request);
 
+    /// @brief Processes incoming REQUEST and returns REPLY response.
+    ///
+    /// @param ctx context of the message received from client
+    ///
+    /// @return ACK or NAK message
+    Pkt4Ptr processRequest(QueryContext4& ctx);
+
     /// @brief Stub function that will handle incoming RELEASE messages.
     ///
     /// In DHCPv4, server does not respond to RELEASE messages, therefore
@@ -322,6 +392,11 @@ protected:
     /// @param inform message received from client
     Pkt4Ptr processInform(Pkt4Ptr& inform);
 
+    /// @brief Stub function that will handle incoming INFORM messages.
+    ///
+    /// @param ctx context of the message received from client
+    Pkt4Ptr processInform(QueryContext4& ctx);
+
     /// @brief Copies default parameters from client's to server's message
     ///
     /// Some fields are copied from client's message into server's response,
@@ -336,9 +411,9 @@ protected:
     /// This method assigns options that were requested by client
     /// (sent in PRL) or are enforced by server.
     ///
-    /// @param question DISCOVER or REQUEST message from a client.
+    /// @param ctx context of the DISCOVER or REQUEST message from a client.
     /// @param msg outgoing message (options will be added here)
-    void appendRequestedOptions(const Pkt4Ptr& question, Pkt4Ptr& msg);
+    void appendRequestedOptions(QueryContext4& ctx, Pkt4Ptr& msg);
 
     /// @brief Appends requested vendor options as requested by client.
     ///
@@ -348,9 +423,9 @@ protected:
     /// options, each with unique vendor-id). Vendor options are requested
     /// using separate options within their respective vendor-option spaces.
     ///
-    /// @param question DISCOVER or REQUEST message from a client.
+    /// @param ctx context of the DISCOVER or REQUEST message from a client.
     /// @param answer outgoing message (options will be added here)
-    void appendRequestedVendorOptions(const Pkt4Ptr& question, Pkt4Ptr& answer);
+    void appendRequestedVendorOptions(QueryContext4& ctx, Pkt4Ptr& answer);
 
     /// @brief Assigns a lease and appends corresponding options
     ///
@@ -358,9 +433,9 @@ protected:
     /// client and assigning it. Options corresponding to the lease
     /// are added to specific message.
     ///
-    /// @param question DISCOVER or REQUEST message from client
+    /// @param ctx context of the DISCOVER or REQUEST message from client
     /// @param answer OFFER or ACK/NAK message (lease options will be added here)
-    void assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer);
+    void assignLease(QueryContext4& ctx, Pkt4Ptr& answer);
 
     /// @brief Append basic options if they are not present.
     ///
@@ -371,9 +446,9 @@ protected:
     /// - Name Server,
     /// - Domain Name.
     ///
-    /// @param question DISCOVER or REQUEST message from a client.
+    /// @param ctx context of the DISCOVER or REQUEST message from a client.
     /// @param msg the message to add options to.
-    void appendBasicOptions(const Pkt4Ptr& question, Pkt4Ptr& msg);
+    void appendBasicOptions(QueryContext4& ctx, Pkt4Ptr& msg);
 
     /// @brief Processes Client FQDN and Hostname Options sent by a client.
     ///
@@ -467,7 +542,7 @@ protected:
     /// value indicates that the new lease has been allocated, rather than
     /// lease being renewed.
     void createNameChangeRequests(const Lease4Ptr& lease,
-                                  const Lease4Ptr& old_lease);
+                                  const ConstLease4Ptr& old_lease);
 
     /// @brief Creates the NameChangeRequest and adds to the queue for
     /// processing.
@@ -481,7 +556,7 @@ protected:
     /// @param lease A lease for which the NameChangeRequest is created and
     /// queued.
     void queueNameChangeRequest(const isc::dhcp_ddns::NameChangeType chg_type,
-                                const Lease4Ptr& lease);
+                                const ConstLease4Ptr& lease);
 
     /// @brief Attempts to renew received addresses
     ///
@@ -607,7 +682,7 @@ protected:
     /// @param lease A pointer to the structure describing a lease.
     /// @return An object encapsulating DHCID to be used for DNS updates.
     /// @throw DhcidComputeError If the computation of the DHCID failed.
-    static isc::dhcp_ddns::D2Dhcid computeDhcid(const Lease4Ptr& lease);
+    static isc::dhcp_ddns::D2Dhcid computeDhcid(const ConstLease4Ptr& lease);
 
     /// @brief Selects a subnet for a given client's packet.
     ///
@@ -615,11 +690,25 @@ protected:
     /// @return selected subnet (or NULL if no suitable subnet was found)
     isc::dhcp::Subnet4Ptr selectSubnet(const Pkt4Ptr& question) const;
 
+    /// @brief Returns the subnet selected for the query.
+    ///
+    /// The subnet is selected with @c selectSubnet when this function is
+    /// called for the query for the first time. Subsequent calls return
+    /// the subnet stored in the context.
+    ///
+    /// @param ctx context of the client's message
+    /// @return selected subnet (or NULL if no suitable subnet was found)
+    isc::dhcp::Subnet4Ptr getSubnet(QueryContext4& ctx) const;
+
     /// indicates if shutdown is in progress. Setting it to true will
     /// initiate server shutdown procedure.
     volatile bool shutdown_;
 
-    /// @brief dummy wrapper around IfaceMgr::receive4
+    /// @brief dummy wrapper around IfaceMgr::receive4Batch
+    ///
+    /// It returns the packets received by a single call to
+    /// IfaceMgr::receive4Batch one by one, and receives the new packets
+    /// when all of them have been returned.
     ///
     /// This method is useful for testing purposes, where its replacement
     /// simulates reception of a packet. For that purpose it is protected.
@@ -627,10 +716,19 @@ protected:
 
     /// @brief dummy wrapper around IfaceMgr::send()
     ///
+    /// If no worker threads are running, the packet is appended to the
+    /// send queue of the IfaceMgr, which is flushed by
+    /// @c sendQueuedPackets.
+    ///
     /// This method is useful for testing purposes, where its replacement
     /// simulates transmission of a packet. For that purpose it is protected.
     virtual void sendPacket(const Pkt4Ptr& pkt);
 
+    /// @brief Sends the responses queued by @c sendPacket.
+    ///
+    /// The errors are logged.
+    void sendQueuedPackets();
+
     /// @brief Implements a callback function to parse options in the message.
     ///
     /// @param buf a A buffer holding options in on-wire format.
@@ -657,10 +755,38 @@ protected:
     ///
     /// This processing is a likely candidate to be pushed into hooks.
     ///
-    /// @param query incoming client's packet
+    /// @param ctx context of the incoming client's packet
     /// @param rsp server's response
     /// @return true if successful, false otherwise (will prevent sending response)
-    bool classSpecificProcessing(const Pkt4Ptr& query, const Pkt4Ptr& rsp);
+    bool classSpecificProcessing(QueryContext4& ctx, const Pkt4Ptr& rsp);
+
+    /// @brief Starts or restarts the packet processing threads.
+    ///
+    /// This function checks whether the number of running worker threads
+    /// matches the value returned by @c CfgMgr::workerThreads. If it
+    /// doesn't, the running threads are stopped and the configured number
+    /// of threads is started. It is no-op if the number of threads is
+    /// already correct.
+    void startWorkers();
+
+    /// @brief Stops the packet processing threads.
+    ///
+    /// This function waits for the worker threads to process queued packets
+    /// and terminate. It must be called before the server configuration is
+    /// modified, so as the configuration isn't accessed by the workers while
+    /// it is being updated. The threads are started again, using the new
+    /// configuration, by the next iteration of @c Dhcpv4Srv::run.
+    void stopWorkers();
+
+    /// @brief Reclaims expired leases if the reclamation is due.
+    ///
+    /// The expired leases are reclaimed every
+    /// @c CfgMgr::reclaimTimerWaitTime seconds. It is no-op if the
+    /// reclamation is not due yet or if it has been disabled by setting
+    /// this value to 0. The number of leases reclaimed in one cycle and
+    /// the duration of the cycle are limited according to
+    /// @c CfgMgr::maxReclaimLeases and @c CfgMgr::maxReclaimTime.
+    void reclaimExpiredLeases();
 
 private:
 
@@ -692,6 +818,25 @@ private:
     int hook_index_pkt4_receive_;
     int hook_index_subnet4_select_;
     int hook_index_pkt4_send_;
+
+    /// Threads processing received packets.
+    WorkerPool worker_pool_;
+
+    /// Serializes processing of packets sent by the same client.
+    ClientLockMgr client_lock_mgr_;
+
+    /// Time when the expired leases should be reclaimed next time.
+    time_t next_reclaim_time_;
+
+    /// Packets received by the last call to @c IfaceMgr::receive4Batch.
+    Pkt4Collection received_;
+
+    /// Position of the next packet to be returned from @c received_.
+    size_t received_pos_;
+
+    /// Indicates that the responses are queued by @c sendPacket, because
+    /// the packets are processed by the thread receiving them.
+    bool queue_responses_;
 };
 
 }; // namespace isc::dhcp
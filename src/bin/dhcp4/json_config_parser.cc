@@ -20,6 +20,7 @@
 #include <dhcp4/json_config_parser.h>
 #include <dhcpsrv/dbaccess_parser.h>
 #include <dhcpsrv/dhcp_parsers.h>
+#include <dhcpsrv/lease_mgr_factory.h>
 #include <dhcpsrv/option_space_container.h>
 #include <util/encode/hex.h>
 #include <util/strutil.h>
@@ -401,11 +402,13 @@ public:
     ///
     /// Iterates over all Subnet4 parsers. Each parser contains definitions of
     /// a single subnet and its parameters and commits each subnet separately.
+    /// The subnets are then indexed for their selection.
     void commit() {
         BOOST_FOREACH(ParserPtr subnet, subnets_) {
             subnet->commit();
         }
 
+        CfgMgr::instance().commitSubnets4();
     }
 
     /// @brief Returns Subnet4ListConfigParser object
@@ -439,7 +442,11 @@ namespace dhcp {
     DhcpConfigParser* parser = NULL;
     if ((config_id.compare("valid-lifetime") == 0)  ||
         (config_id.compare("renew-timer") == 0)  ||
-        (config_id.compare("rebind-timer") == 0))  {
+        (config_id.compare("rebind-timer") == 0) ||
+        (config_id.compare("worker-threads") == 0) ||
+        (config_id.compare("reclaim-timer-wait-time") == 0) ||
+        (config_id.compare("max-reclaim-leases") == 0) ||
+        (config_id.compare("max-reclaim-time") == 0))  {
         parser = new Uint32Parser(config_id,
                                  globalContext()->uint32_values_);
     } else if (config_id.compare("interfaces") == 0) {
@@ -461,7 +468,8 @@ namespace dhcp {
         parser = new DbAccessParser(config_id, *globalContext());
     } else if (config_id.compare("hooks-libraries") == 0) {
         parser = new HooksLibrariesParser(config_id);
-    } else if (config_id.compare("echo-client-id") == 0) {
+    } else if ((config_id.compare("echo-client-id") == 0) ||
+               (config_id.compare("free-address-tracking") == 0)) {
         parser = new BooleanParser(config_id, globalContext()->boolean_values_);
     } else if (config_id.compare("dhcp-ddns") == 0) {
         parser = new D2ClientConfigParser(config_id);
@@ -486,6 +494,28 @@ void commitGlobalOptions() {
     } catch (...) {
         // Ignore errors. This flag is optional
     }
+
+    // Set the number of threads processing received packets. If it is not
+    // specified, the packets are processed by the main thread.
+    uint32_t worker_threads = globalContext()->uint32_values_->
+        getOptionalParam("worker-threads", 0);
+    CfgMgr::instance().workerThreads(worker_threads);
+
+    // Set the parameters controlling the reclamation of expired leases.
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+    cfg_mgr.reclaimTimerWaitTime(globalContext()->uint32_values_->
+        getOptionalParam("reclaim-timer-wait-time",
+                         CfgMgr::DEFAULT_RECLAIM_TIMER_WAIT_TIME));
+    cfg_mgr.maxReclaimLeases(globalContext()->uint32_values_->
+        getOptionalParam("max-reclaim-leases",
+                         CfgMgr::DEFAULT_MAX_RECLAIM_LEASES));
+    cfg_mgr.maxReclaimTime(globalContext()->uint32_values_->
+        getOptionalParam("max-reclaim-time",
+                         CfgMgr::DEFAULT_MAX_RECLAIM_TIME));
+
+    // Enable the tracking of free addresses in pools if requested.
+    cfg_mgr.freeAddressTracking(globalContext()->boolean_values_->
+        getOptionalParam("free-address-tracking", false));
 }
 
 isc::data::ConstElementPtr
@@ -520,6 +550,10 @@ configureDhcp4Server(Dhcpv4Srv&, isc::data::ConstElementPtr config_set) {
     // the same risk of failure as doing the change.)
     ParserPtr hooks_parser;
 
+    // The lease database parser is committed after the global parameters
+    // are parsed (see below).
+    boost::shared_ptr<DbAccessParser> db_parser;
+
     // The subnet parsers implement data inheritance by directly
     // accessing global storage. For this reason the global data
     // parsers must store the parsed data into global storages
@@ -562,6 +596,12 @@ configureDhcp4Server(Dhcpv4Srv&, isc::data::ConstElementPtr config_set) {
                 // but defer the commit until everything else has committed.
                 hooks_parser = parser;
                 parser->build(config_pair.second);
+            } else if (config_pair.first == "lease-database") {
+                // Committing the parser opens the lease database. Defer
+                // the commit until its parameters can be checked against
+                // the global parameters.
+                db_parser = boost::dynamic_pointer_cast<DbAccessParser>(parser);
+                db_parser->build(config_pair.second);
             } else {
                 // Those parsers should be started before other
                 // parsers so we can call build straight away.
@@ -574,6 +614,17 @@ configureDhcp4Server(Dhcpv4Srv&, isc::data::ConstElementPtr config_set) {
             }
         }
 
+        // The lease database is opened once all global parameters have
+        // been parsed.
+        if (db_parser) {
+            config_pair.first = "lease-database";
+            LeaseMgrFactory::checkWorkerThreads(
+                db_parser->getDbAccessParameters(),
+                globalContext()->uint32_values_->
+                getOptionalParam("worker-threads", 0));
+            db_parser->commit();
+        }
+
         // The option values parser is the next one to be run.
         std::map<std::string, ConstElementPtr>::const_iterator option_config =
             values_map.find("option-data");
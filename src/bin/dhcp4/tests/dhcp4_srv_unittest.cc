@@ -45,6 +45,7 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 #include <arpa/inet.h>
@@ -963,6 +964,31 @@ TEST_F(Dhcpv4SrvTest, sanityCheck) {
                  RFCViolation);
 }
 
+// This test verifies that the server reclaims expired leases and that the
+// reclamation can be disabled.
+TEST_F(Dhcpv4SrvTest, reclaimExpiredLeases) {
+    boost::scoped_ptr<NakedDhcpv4Srv> srv;
+    ASSERT_NO_THROW(srv.reset(new NakedDhcpv4Srv(0)));
+
+    // Create a lease which expired 400 seconds ago.
+    const IOAddress addr("192.0.2.106");
+    uint8_t mac_addr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe};
+    Lease4Ptr lease(new Lease4(addr, mac_addr, sizeof(mac_addr), NULL, 0,
+                               100, 50, 75, time(NULL) - 500,
+                               subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+
+    // The lease must not be reclaimed when the reclamation is disabled.
+    CfgMgr::instance().reclaimTimerWaitTime(0);
+    srv->reclaimExpiredLeases();
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(addr));
+
+    // Enable the reclamation. The lease should be removed.
+    CfgMgr::instance().reclaimTimerWaitTime(CfgMgr::DEFAULT_RECLAIM_TIMER_WAIT_TIME);
+    srv->reclaimExpiredLeases();
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addr));
+}
+
 // This test verifies that incoming (positive) RELEASE can be handled properly.
 // As there is no REPLY in DHCPv4, the only thing to verify here is that
 // the lease is indeed removed from the database.
@@ -1728,6 +1754,23 @@ public:
         return pkt4_receive_callout(callout_handle);
     }
 
+    /// test callback that makes the query look as relayed
+    /// @param callout_handle handle passed by the hooks framework
+    /// @return always 0
+    static int
+    pkt4_receive_change_giaddr(CalloutHandle& callout_handle) {
+
+        Pkt4Ptr pkt;
+        callout_handle.getArgument("query4", pkt);
+
+        // Set the relay address, in the second subnet
+        pkt->setGiaddr(IOAddress("192.0.3.1"));
+        pkt->setHops(1);
+
+        // carry on as usual
+        return pkt4_receive_callout(callout_handle);
+    }
+
     /// test callback that deletes client-id
     /// @param callout_handle handle passed by the hooks framework
     /// @return always 0
@@ -1809,6 +1852,26 @@ public:
         return pkt4_send_callout(callout_handle);
     }
 
+    /// Test callback that changes the configured routers option
+    /// @param callout_handle handle passed by the hooks framework
+    /// @return always 0
+    static int
+    pkt4_send_change_routers(CalloutHandle& callout_handle) {
+
+        Pkt4Ptr pkt;
+        callout_handle.getArgument("response4", pkt);
+
+        // Replace the router address in the option added by the server.
+        Option4AddrLstPtr routers = boost::dynamic_pointer_cast<
+            Option4AddrLst>(pkt->getOption(DHO_ROUTERS));
+        if (routers) {
+            routers->setAddress(IOAddress("192.0.2.5"));
+        }
+
+        // carry on as usual
+        return pkt4_send_callout(callout_handle);
+    }
+
     /// Test callback that sets skip flag
     /// @param callout_handle handle passed by the hooks framework
     /// @return always 0
@@ -1879,6 +1942,16 @@ public:
         return (0);
     }
 
+    /// Test callback that counts the subnet4_select calls
+    /// @param callout_handle handle passed by the hooks framework
+    /// @return always 0
+    static int
+    subnet4_select_count_callout(CalloutHandle& callout_handle) {
+        ++callback_subnet4_select_count_;
+
+        return (subnet4_select_callout(callout_handle));
+    }
+
     /// Test callback that picks the other subnet if possible.
     /// @param callout_handle handle passed by the hooks framework
     /// @return always 0
@@ -1902,6 +1975,22 @@ public:
         return (0);
     }
 
+    /// Test callback that reads the lease time option of the query
+    /// @param callout_handle handle passed by the hooks framework
+    /// @return always 0
+    static int
+    subnet4_select_lease_time_callout(CalloutHandle& callout_handle) {
+
+        // Call the basic calllout to record all passed values
+        subnet4_select_callout(callout_handle);
+
+        // The server does not read this option from the queries, so it
+        // is created here.
+        callback_pkt4_->getOption(DHO_DHCP_LEASE_TIME);
+
+        return (0);
+    }
+
     /// Test callback that stores received callout name passed parameters
     /// @param callout_handle handle passed by the hooks framework
     /// @return always 0
@@ -1943,6 +2032,7 @@ public:
         callback_subnet4_.reset();
         callback_subnet4collection_ = NULL;
         callback_argument_names_.clear();
+        callback_subnet4_select_count_ = 0;
     }
 
     /// pointer to Dhcpv4Srv that is used in tests
@@ -1973,6 +2063,9 @@ public:
 
     /// A list of all received arguments
     static vector<string> callback_argument_names_;
+
+    /// Number of the subnet4_select callout calls
+    static int callback_subnet4_select_count_;
 };
 
 // The following fields are used in testing pkt4_receive_callout.
@@ -1985,6 +2078,7 @@ ClientIdPtr HooksDhcpv4SrvTest::callback_clientid_;
 Lease4Ptr HooksDhcpv4SrvTest::callback_lease4_;
 const Subnet4Collection* HooksDhcpv4SrvTest::callback_subnet4collection_;
 vector<string> HooksDhcpv4SrvTest::callback_argument_names_;
+int HooksDhcpv4SrvTest::callback_subnet4_select_count_;
 
 // Checks if callouts installed on pkt4_receive are indeed called and the
 // all necessary parameters are passed.
@@ -2331,6 +2425,44 @@ TEST_F(HooksDhcpv4SrvTest, pkt4SendDeleteServerId) {
     EXPECT_FALSE(adv->getOption(DHO_DHCP_SERVER_IDENTIFIER));
 }
 
+// Checks that the change made by the callout installed on pkt4_send to
+// the option configured for the subnet is included in the packed response.
+// The server would otherwise copy the on-wire format of the option held by
+// the subnet.
+TEST_F(HooksDhcpv4SrvTest, pkt4SendConfiguredOptionChange) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    // Install pkt4_send_change_routers
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "pkt4_send", pkt4_send_change_routers));
+
+    // Let's create a simple DISCOVER
+    Pkt4Ptr sol = generateSimpleDiscover();
+
+    // Simulate that we have received that traffic
+    srv_->fakeReceive(sol);
+
+    // Server will now process to run its normal loop, but instead of calling
+    // IfaceMgr::receive4(), it will read all packets from the list set by
+    // fakeReceive()
+    srv_->run();
+
+    // check that the server did send a response
+    ASSERT_EQ(1, srv_->fake_sent_.size());
+    Pkt4Ptr adv = srv_->fake_sent_.front();
+    ASSERT_TRUE(adv);
+    ASSERT_TRUE(adv->getOption(DHO_ROUTERS));
+
+    // The packed response holds the router address set by the callout.
+    const uint8_t expected[] = { DHO_ROUTERS, 4, 192, 0, 2, 5 };
+    const uint8_t* data =
+        static_cast<const uint8_t*>(adv->getBuffer().getData());
+    const uint8_t* data_end = data + adv->getBuffer().getLength();
+    EXPECT_TRUE(std::search(data, data_end, expected,
+                            expected + sizeof(expected)) != data_end);
+}
+
 // Checks if callouts installed on pkt4_skip is able to set skip flag that
 // will cause the server to not process the packet (drop), even though it is valid.
 TEST_F(HooksDhcpv4SrvTest, skip_pkt4_send) {
@@ -2587,6 +2719,120 @@ TEST_F(HooksDhcpv4SrvTest, subnet4SelectChange) {
     EXPECT_TRUE((*subnets)[1]->inPool(Lease::TYPE_V4, addr));
 }
 
+// This test checks that a query carrying a malformed option, which the
+// server itself does not read but a callout does, is dropped before it is
+// passed to the callouts.
+TEST_F(HooksDhcpv4SrvTest, subnet4SelectMalformedOption) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    // Install a callout reading the malformed option
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "subnet4_select", subnet4_select_lease_time_callout));
+
+    // Let's create a simple DISCOVER and append the lease time option
+    // carrying a single byte, rather than a 32-bit value.
+    OptionBuffer buf = generateSimpleDiscover()->data_;
+    buf.push_back(static_cast<uint8_t>(DHO_DHCP_LEASE_TIME));
+    buf.push_back(1);
+    buf.push_back(0);
+    Pkt4Ptr dis(new Pkt4(&buf[0], buf.size()));
+    dis->setIface("eth1");
+
+    // Simulate that we have received that traffic
+    srv_->fakeReceive(dis);
+
+    // The server should find the malformed option before selecting the
+    // subnet, so the packet should be dropped without calling the callout.
+    ASSERT_NO_THROW(srv_->run());
+    EXPECT_TRUE(callback_name_.empty());
+    EXPECT_EQ(0, srv_->fake_sent_.size());
+}
+
+// This test checks that the subnet is selected once per query, after the
+// pkt4_receive callouts.
+TEST_F(HooksDhcpv4SrvTest, subnet4SelectOnceAfterPkt4Receive) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    // Install the callouts
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "pkt4_receive", pkt4_receive_callout));
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "subnet4_select", subnet4_select_count_callout));
+
+    // Let's create a simple DISCOVER
+    Pkt4Ptr dis = generateSimpleDiscover();
+
+    // Simulate that we have received that traffic
+    srv_->fakeReceive(dis);
+    ASSERT_NO_THROW(srv_->run());
+
+    // The server should respond, having selected the subnet once.
+    ASSERT_EQ(1, srv_->fake_sent_.size());
+    EXPECT_EQ(1, callback_subnet4_select_count_);
+    EXPECT_TRUE(callback_pkt4_.get() == dis.get());
+}
+
+// This test checks that the subnet selected while accepting the query is
+// not used when a pkt4_receive callout changes the giaddr of the query.
+TEST_F(HooksDhcpv4SrvTest, subnet4SelectAfterPkt4ReceiveChangeGiaddr) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    // Install the callouts
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "pkt4_receive", pkt4_receive_change_giaddr));
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "subnet4_select", subnet4_select_count_callout));
+
+    // Configure 2 subnets, the first one directly reachable over eth0
+    string config = "{ \"interfaces\": [ \"*\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet4\": [ { "
+        "    \"pools\": [ { \"pool\": \"192.0.2.0/25\" } ],"
+        "    \"subnet\": \"192.0.2.0/24\", "
+        "    \"interface\": \"eth0\" "
+        " }, {"
+        "    \"pools\": [ { \"pool\": \"192.0.3.0/25\" } ],"
+        "    \"subnet\": \"192.0.3.0/24\" "
+        " } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    ElementPtr json = Element::fromJSON(config);
+    ConstElementPtr status;
+
+    // Configure the server and make sure the config is accepted
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    ASSERT_TRUE(status);
+    comment_ = config::parseAnswer(rcode_, status);
+    ASSERT_EQ(0, rcode_);
+
+    // Let's create a simple DISCOVER, not relayed and broadcast on eth0,
+    // so as the server selects the first subnet to accept it.
+    OptionBuffer buf = generateSimpleDiscover()->data_;
+    buf[3] = 0; // hops
+    fill(buf.begin() + 24, buf.begin() + 28, 0); // giaddr
+    Pkt4Ptr dis(new Pkt4(&buf[0], buf.size()));
+    dis->setIface("eth0");
+    dis->setLocalAddr(IOAddress("255.255.255.255"));
+
+    // Simulate that we have received that traffic
+    srv_->fakeReceive(dis);
+    ASSERT_NO_THROW(srv_->run());
+
+    // The callout made the query relayed, so the server should have
+    // selected the second subnet again for its processing.
+    ASSERT_EQ(1, srv_->fake_sent_.size());
+    EXPECT_EQ(2, callback_subnet4_select_count_);
+    const Subnet4Collection* subnets = CfgMgr::instance().getSubnets4();
+    ASSERT_EQ(2, subnets->size());
+    ASSERT_TRUE(callback_subnet4_);
+    EXPECT_EQ((*subnets)[1].get(), callback_subnet4_.get());
+    EXPECT_TRUE((*subnets)[1]->inRange(srv_->fake_sent_.front()->getYiaddr()));
+}
+
 // This test verifies that incoming (positive) REQUEST/Renewing can be handled
 // properly and that callout installed on lease4_renew is triggered with
 // expected parameters.
@@ -3240,6 +3486,57 @@ TEST_F(Dhcpv4SrvTest, relayOverride) {
     EXPECT_FALSE(srv_.selectSubnet(dis));
 }
 
+// Checks that the subnet is selected once for the query context.
+TEST_F(Dhcpv4SrvTest, getSubnet) {
+    string config = "{ \"interfaces\": [ \"*\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet4\": [ "
+        "{   \"pools\": [ { \"pool\": \"192.0.2.2 - 192.0.2.100\" } ],"
+        "    \"subnet\": \"192.0.2.0/24\" }, "
+        "{   \"pools\": [ { \"pool\": \"192.0.3.1 - 192.0.3.100\" } ],"
+        "    \"subnet\": \"192.0.3.0/24\" } "
+        "],"
+        "\"valid-lifetime\": 4000 }";
+
+    // Use this config to set up the server
+    ASSERT_NO_THROW(configure(config));
+
+    const Subnet4Collection* subnets = CfgMgr::instance().getSubnets4();
+    ASSERT_EQ(2, subnets->size());
+    Subnet4Ptr subnet1 = (*subnets)[0];
+    Subnet4Ptr subnet2 = (*subnets)[1];
+
+    // Create a relayed packet belonging to the first subnet.
+    Pkt4Ptr dis = Pkt4Ptr(new Pkt4(DHCPDISCOVER, 1234));
+    dis->setRemoteAddr(IOAddress("192.0.2.1"));
+    dis->setIface("eth0");
+    dis->setHops(1);
+    dis->setGiaddr(IOAddress("192.0.2.1"));
+
+    QueryContext4 ctx(dis);
+    EXPECT_FALSE(ctx.subnet_selected_);
+    EXPECT_TRUE(subnet1 == srv_.getSubnet(ctx));
+    EXPECT_TRUE(ctx.subnet_selected_);
+
+    // The subnet held in the context is returned, even though the relay
+    // now belongs to the second subnet.
+    dis->setGiaddr(IOAddress("192.0.3.1"));
+    EXPECT_TRUE(subnet1 == srv_.getSubnet(ctx));
+
+    // The subnet is selected again for the new context.
+    QueryContext4 ctx2(dis);
+    EXPECT_TRUE(subnet2 == srv_.getSubnet(ctx2));
+
+    // The lack of the subnet is also held in the context.
+    dis->setGiaddr(IOAddress("192.0.5.1"));
+    QueryContext4 ctx3(dis);
+    EXPECT_FALSE(srv_.getSubnet(ctx3));
+    EXPECT_TRUE(ctx3.subnet_selected_);
+    dis->setGiaddr(IOAddress("192.0.2.1"));
+    EXPECT_FALSE(srv_.getSubnet(ctx3));
+}
+
 // Checks if relay IP address specified in the relay-info structure can be
 // used together with client-classification.
 TEST_F(Dhcpv4SrvTest, relayOverrideAndClientClass) {
@@ -44,8 +44,14 @@ ControlledDhcpv6Srv::commandShutdownHandler(const string&, ConstElementPtr) {
 
 ConstElementPtr
 ControlledDhcpv6Srv::commandLibReloadHandler(const string&, ConstElementPtr) {
-    /// @todo delete any stored CalloutHandles referring to the old libraries
-    /// Get list of currently loaded libraries and reload them.
+    // The worker threads must not call the callouts while the libraries
+    // are being reloaded. They will be started again when the next packet
+    // is received.
+    stopWorkers();
+
+    // No CalloutHandles referring to the old libraries are left, as they
+    // are released when the packets have been processed.
+    // Get list of currently loaded libraries and reload them.
     vector<string> loaded = HooksManager::getLibraryNames();
     bool status = HooksManager::loadLibraries(loaded);
     if (!status) {
@@ -114,6 +120,11 @@ ControlledDhcpv6Srv::processConfig(isc::data::ConstElementPtr config) {
         return (no_srv);
     }
 
+    // Make sure that the worker threads are not processing packets while
+    // the configuration is being modified. They will be started again,
+    // according to the new configuration, when the next packet is received.
+    srv->stopWorkers();
+
     ConstElementPtr answer = configureDhcp6Server(*srv, config);
 
     // Check that configuration was successful. If not, do not reopen sockets
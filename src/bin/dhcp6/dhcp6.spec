@@ -54,6 +54,36 @@
         "item_default": 4000
       },
 
+      { "item_name": "worker-threads",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 0
+      },
+
+      { "item_name": "reclaim-timer-wait-time",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 10
+      },
+
+      { "item_name": "max-reclaim-leases",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 100
+      },
+
+      { "item_name": "max-reclaim-time",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 250
+      },
+
+      { "item_name": "free-address-tracking",
+        "item_type": "boolean",
+        "item_optional": true,
+        "item_default": false
+      },
+
       { "item_name": "option-def",
         "item_type": "list",
         "item_optional": false,
@@ -191,6 +221,60 @@
                 "item_type": "boolean",
                 "item_optional": true,
                 "item_default": true
+            },
+            {
+                "item_name": "lfc-interval",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
+            },
+            {
+                "item_name": "snapshot",
+                "item_type": "boolean",
+                "item_optional": true,
+                "item_default": false
+            },
+            {
+                "item_name": "sync-policy",
+                "item_type": "string",
+                "item_optional": true,
+                "item_default": "os"
+            },
+            {
+                "item_name": "sync-interval",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 100
+            },
+            {
+                "item_name": "connections",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 1
+            },
+            {
+                "item_name": "group-commit-size",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
+            },
+            {
+                "item_name": "group-commit-delay",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
+            },
+            {
+                "item_name": "cache-size",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
+            },
+            {
+                "item_name": "pipeline",
+                "item_type": "boolean",
+                "item_optional": true,
+                "item_default": false
             }
         ]
       },
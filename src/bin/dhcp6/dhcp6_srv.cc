@@ -97,6 +97,14 @@ struct Dhcp6Hooks {
 // module is called.
 Dhcp6Hooks Hooks;
 
+/// Maximum number of received packets waiting for processing, per worker
+/// thread. The packets received when the queue is full are dropped.
+const size_t MAX_QUEUED_PACKETS_PER_THREAD = 64;
+
+/// Empty container of option definitions, used to parse options of the
+/// option spaces which have no definitions.
+const OptionDefContainer empty_option_defs;
+
 }; // anonymous namespace
 
 namespace isc {
@@ -115,7 +123,8 @@ const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 static const char* SERVER_DUID_FILE = "kea-dhcp6-serverid";
 
 Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
-:alloc_engine_(), serverid_(), port_(port), shutdown_(true)
+:alloc_engine_(), serverid_(), port_(port), next_reclaim_time_(0),
+ received_pos_(0), queue_responses_(false), shutdown_(true)
 {
 
     LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_OPEN_SOCKET).arg(port);
@@ -168,6 +177,7 @@ Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
 }
 
 Dhcpv6Srv::~Dhcpv6Srv() {
+    stopWorkers();
     IfaceMgr::instance().closeSockets();
 
     LeaseMgrFactory::destroy();
@@ -179,11 +189,41 @@ void Dhcpv6Srv::shutdown() {
 }
 
 Pkt6Ptr Dhcpv6Srv::receivePacket(int timeout) {
-    return (IfaceMgr::instance().receive6(timeout));
+    // The packets received by the previous call are returned before
+    // waiting for the new ones.
+    if (received_pos_ >= received_.size()) {
+        received_.clear();
+        received_pos_ = 0;
+        IfaceMgr::instance().receive6Batch(received_,
+                                           IfaceMgr::RECEIVE_BATCH_SIZE,
+                                           timeout);
+    }
+    if (received_pos_ < received_.size()) {
+        Pkt6Ptr pkt;
+        pkt.swap(received_[received_pos_++]);
+        return (pkt);
+    }
+    return (Pkt6Ptr());
 }
 
 void Dhcpv6Srv::sendPacket(const Pkt6Ptr& packet) {
-    IfaceMgr::instance().send(packet);
+    // The responses produced by the thread receiving the packets are sent
+    // together, when all received packets have been processed. The worker
+    // threads send the responses immediately.
+    if (queue_responses_) {
+        IfaceMgr::instance().queueSend(packet);
+    } else {
+        IfaceMgr::instance().send(packet);
+    }
+}
+
+void
+Dhcpv6Srv::sendQueuedPackets() {
+    try {
+        IfaceMgr::instance().flushSendQueue();
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL).arg(e.what());
+    }
 }
 
 bool
@@ -242,9 +282,14 @@ bool Dhcpv6Srv::run() {
         //cppcheck-suppress variableScope This is temporary anyway
         const int timeout = 1000;
 
-        // client's message and server's response
+        // client's message
         Pkt6Ptr query;
-        Pkt6Ptr rsp;
+
+        // Send the responses to the packets received by the last call to
+        // receivePacket before waiting for the new packets.
+        if (received_pos_ >= received_.size()) {
+            sendQueuedPackets();
+        }
 
         try {
             query = receivePacket(timeout);
@@ -271,276 +316,363 @@ bool Dhcpv6Srv::run() {
         // terminate.
         handleSignal();
 
+        // Reclaim expired leases if it is time to do so.
+        reclaimExpiredLeases();
+
         // Timeout may be reached or signal received, which breaks select()
         // with no packet received
         if (!query) {
             continue;
         }
 
-        // In order to parse the DHCP options, the server needs to use some
-        // configuration information such as: existing option spaces, option
-        // definitions etc. This is the kind of information which is not
-        // available in the libdhcp, so we need to supply our own implementation
-        // of the option parsing function here, which would rely on the
-        // configuration data.
-        query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
-                                       _3, _4, _5));
+        // Make sure that the number of packet processing threads is in
+        // line with the current configuration. The configuration may have
+        // been changed by the signal handler.
+        startWorkers();
+        queue_responses_ = (worker_pool_.getThreadCount() == 0);
+
+        // Process the packet, either by one of the worker threads or by
+        // this thread if no worker threads are configured.
+        if (!worker_pool_.add(boost::bind(&Dhcpv6Srv::processPacket, this,
+                                          query))) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_QUEUE_FULL)
+                .arg(query->getTransid())
+                .arg(query->getIface());
+        }
+    }
 
-        bool skip_unpack = false;
+    // Process the queued packets before returning.
+    stopWorkers();
+    sendQueuedPackets();
 
-        // The packet has just been received so contains the uninterpreted wire
-        // data; execute callouts registered for buffer6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    return (true);
+}
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+void Dhcpv6Srv::processPacket(Pkt6Ptr query) {
+    // The packet and its callout handle are not kept by this thread after
+    // the packet has been processed.
+    CalloutHandleReleaser<Pkt6Ptr> callout_handle_releaser;
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+    // server's response
+    Pkt6Ptr rsp;
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
+    // In order to parse the DHCP options, the server needs to use some
+    // configuration information such as: existing option spaces, option
+    // definitions etc. This is the kind of information which is not
+    // available in the libdhcp, so we need to supply our own implementation
+    // of the option parsing function here, which would rely on the
+    // configuration data.
+    query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
+                                   _3, _4, _5));
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to parse the packet, so skip at this
-            // stage means that callouts did the parsing already, so server
-            // should skip parsing.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
-                skip_unpack = true;
-            }
+    bool skip_unpack = false;
 
-            callout_handle->getArgument("query6", query);
-        }
+    // The packet has just been received so contains the uninterpreted wire
+    // data; execute callouts registered for buffer6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-        // Unpack the packet information unless the buffer6_receive callouts
-        // indicated they did it
-        if (!skip_unpack) {
-            if (!query->unpack()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
-                          DHCP6_PACKET_PARSE_FAIL);
-                continue;
-            }
-        }
-        // Check if received query carries server identifier matching
-        // server identifier being used by the server.
-        if (!testServerID(query)) {
-            continue;
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
+
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query6", query);
+
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to parse the packet, so skip at this
+        // stage means that callouts did the parsing already, so server
+        // should skip parsing.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
+            skip_unpack = true;
         }
 
-        // Check if the received query has been sent to unicast or multicast.
-        // The Solicit, Confirm, Rebind and Information Request will be
-        // discarded if sent to unicast address.
-        if (!testUnicast(query)) {
-            continue;
+        callout_handle->getArgument("query6", query);
+    }
+
+    // Unpack the packet information unless the buffer6_receive callouts
+    // indicated they did it
+    if (!skip_unpack) {
+        if (!query->unpack()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                      DHCP6_PACKET_PARSE_FAIL);
+            return;
         }
+    }
+    // Check if received query carries server identifier matching
+    // server identifier being used by the server.
+    if (!testServerID(query)) {
+        return;
+    }
 
-        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
-            .arg(query->getName());
-        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_QUERY_DATA)
-            .arg(static_cast<int>(query->getType()))
-            .arg(query->getBuffer().getLength())
-            .arg(query->toText());
-
-        // At this point the information in the packet has been unpacked into
-        // the various packet fields and option objects has been cretated.
-        // Execute callouts registered for packet6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    // Check if the received query has been sent to unicast or multicast.
+    // The Solicit, Confirm, Rebind and Information Request will be
+    // discarded if sent to unicast address.
+    if (!testUnicast(query)) {
+        return;
+    }
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
+        .arg(query->getName());
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_QUERY_DATA)
+        .arg(static_cast<int>(query->getType()))
+        .arg(query->getBuffer().getLength())
+        .arg(query->toText());
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+    // At this point the information in the packet has been unpacked into
+    // the various packet fields and option objects has been cretated.
+    // Execute callouts registered for packet6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to process the packet, so skip at this
-            // stage means drop.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
-                continue;
-            }
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query6", query);
+
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
 
-            callout_handle->getArgument("query6", query);
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to process the packet, so skip at this
+        // stage means drop.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
+            return;
         }
 
-        // Assign this packet to a class, if possible
-        classifyPacket(query);
+        callout_handle->getArgument("query6", query);
+    }
+
+    // Two packets sent by the same client must not be processed at the
+    // same time by different worker threads, because they would race for
+    // the same leases. If another packet from this client is being
+    // processed, this one is most likely a retransmission and is dropped.
+    // Waiting for the other packet would let a client sending packets
+    // quickly hold all worker threads. The lock is held until this
+    // function returns.
+    OptionPtr client_id = query->getOption(D6O_CLIENTID);
+    ClientLockMgr::Locker client_lock(client_lock_mgr_, client_id ?
+                                      client_id->getData() :
+                                      ClientLockMgr::ClientId(), false);
+    if (client_lock.busy()) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_CLIENT_BUSY)
+            .arg(query->getTransid())
+            .arg(query->getIface());
+        return;
+    }
 
-        try {
-                NameChangeRequestPtr ncr;
-            switch (query->getType()) {
-            case DHCPV6_SOLICIT:
-                rsp = processSolicit(query);
-                    break;
-
-            case DHCPV6_REQUEST:
-                rsp = processRequest(query);
-                break;
+    // Assign this packet to a class, if possible
+    classifyPacket(query);
 
-            case DHCPV6_RENEW:
-                rsp = processRenew(query);
+    try {
+            NameChangeRequestPtr ncr;
+        switch (query->getType()) {
+        case DHCPV6_SOLICIT:
+            rsp = processSolicit(query);
                 break;
 
-            case DHCPV6_REBIND:
-                rsp = processRebind(query);
-                break;
+        case DHCPV6_REQUEST:
+            rsp = processRequest(query);
+            break;
 
-            case DHCPV6_CONFIRM:
-                rsp = processConfirm(query);
-                break;
+        case DHCPV6_RENEW:
+            rsp = processRenew(query);
+            break;
 
-            case DHCPV6_RELEASE:
-                rsp = processRelease(query);
-                break;
+        case DHCPV6_REBIND:
+            rsp = processRebind(query);
+            break;
 
-            case DHCPV6_DECLINE:
-                rsp = processDecline(query);
-                break;
+        case DHCPV6_CONFIRM:
+            rsp = processConfirm(query);
+            break;
 
-            case DHCPV6_INFORMATION_REQUEST:
-                rsp = processInfRequest(query);
-                break;
+        case DHCPV6_RELEASE:
+            rsp = processRelease(query);
+            break;
 
-            default:
-                // We received a packet type that we do not recognize.
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
-                    .arg(static_cast<int>(query->getType()))
-                    .arg(query->getIface());
-                // Only action is to output a message if debug is enabled,
-                // and that will be covered by the debug statement before
-                // the "switch" statement.
-                ;
-            }
+        case DHCPV6_DECLINE:
+            rsp = processDecline(query);
+            break;
 
-        } catch (const RFCViolation& e) {
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+        case DHCPV6_INFORMATION_REQUEST:
+            rsp = processInfRequest(query);
+            break;
 
-        } catch (const isc::Exception& e) {
+        default:
+            // We received a packet type that we do not recognize.
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
+                .arg(static_cast<int>(query->getType()))
+                .arg(query->getIface());
+            // Only action is to output a message if debug is enabled,
+            // and that will be covered by the debug statement before
+            // the "switch" statement.
+            ;
+        }
 
-            // Catch-all exception (at least for ones based on the isc Exception
-            // class, which covers more or less all that are explicitly raised
-            // in the Kea code).  Just log the problem and ignore the packet.
-            // (The problem is logged as a debug message because debug is
-            // disabled by default - it prevents a DDOS attack based on the
-            // sending of problem packets.)
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+    } catch (const RFCViolation& e) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+
+    } catch (const isc::Exception& e) {
+
+        // Catch-all exception (at least for ones based on the isc Exception
+        // class, which covers more or less all that are explicitly raised
+        // in the Kea code).  Just log the problem and ignore the packet.
+        // (The problem is logged as a debug message because debug is
+        // disabled by default - it prevents a DDOS attack based on the
+        // sending of problem packets.)
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+    }
+
+    if (rsp) {
+        rsp->setRemoteAddr(query->getRemoteAddr());
+        rsp->setLocalAddr(query->getLocalAddr());
+
+        if (rsp->relay_info_.empty()) {
+            // Direct traffic, send back to the client directly
+            rsp->setRemotePort(DHCP6_CLIENT_PORT);
+        } else {
+            // Relayed traffic, send back to the relay agent
+            rsp->setRemotePort(DHCP6_SERVER_PORT);
         }
 
-        if (rsp) {
-            rsp->setRemoteAddr(query->getRemoteAddr());
-            rsp->setLocalAddr(query->getLocalAddr());
+        rsp->setLocalPort(DHCP6_SERVER_PORT);
+        rsp->setIndex(query->getIndex());
+        rsp->setIface(query->getIface());
 
-            if (rsp->relay_info_.empty()) {
-                // Direct traffic, send back to the client directly
-                rsp->setRemotePort(DHCP6_CLIENT_PORT);
-            } else {
-                // Relayed traffic, send back to the relay agent
-                rsp->setRemotePort(DHCP6_SERVER_PORT);
+        // Specifies if server should do the packing
+        bool skip_pack = false;
+
+        // Server's reply packet now has all options and fields set.
+        // Options are represented by individual objects, but the
+        // output wire data has not been prepared yet.
+        // Execute all callouts registered for packet6_send
+        if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
+            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+            // Delete all previous arguments
+            callout_handle->deleteAllArguments();
+
+            // The callouts may modify the options of the response, so
+            // their on-wire format can't be used.
+            rsp->clearPackedOptions();
+
+            // Set our response
+            callout_handle->setArgument("response6", rsp);
+
+            // Call all installed callouts
+            HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
+
+            // Callouts decided to skip the next processing step. The next
+            // processing step would to pack the packet (create wire data).
+            // That step will be skipped if any callout sets skip flag.
+            // It essentially means that the callout already did packing,
+            // so the server does not have to do it again.
+            if (callout_handle->getSkip()) {
+                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
+                skip_pack = true;
             }
+        }
 
-            rsp->setLocalPort(DHCP6_SERVER_PORT);
-            rsp->setIndex(query->getIndex());
-            rsp->setIface(query->getIface());
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
+                  DHCP6_RESPONSE_DATA)
+            .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
 
-            // Specifies if server should do the packing
-            bool skip_pack = false;
+        if (!skip_pack) {
+            try {
+                rsp->pack();
+            } catch (const std::exception& e) {
+                LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
+                    .arg(e.what());
+                return;
+            }
 
-            // Server's reply packet now has all options and fields set.
-            // Options are represented by individual objects, but the
-            // output wire data has not been prepared yet.
-            // Execute all callouts registered for packet6_send
-            if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
+        }
+
+        try {
+
+            // Now all fields and options are constructed into output wire buffer.
+            // Option objects modification does not make sense anymore. Hooks
+            // can only manipulate wire buffer at this stage.
+            // Let's execute all callouts registered for buffer6_send
+            if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
                 CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-                // Delete all previous arguments
+                // Delete previously set arguments
                 callout_handle->deleteAllArguments();
 
-                // Set our response
+                // Pass incoming packet as argument
                 callout_handle->setArgument("response6", rsp);
 
-                // Call all installed callouts
-                HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
+                // Call callouts
+                HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
 
                 // Callouts decided to skip the next processing step. The next
-                // processing step would to pack the packet (create wire data).
-                // That step will be skipped if any callout sets skip flag.
-                // It essentially means that the callout already did packing,
-                // so the server does not have to do it again.
+                // processing step would to parse the packet, so skip at this
+                // stage means drop.
                 if (callout_handle->getSkip()) {
-                    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
-                    skip_pack = true;
+                    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
+                    return;
                 }
+
+                callout_handle->getArgument("response6", rsp);
             }
 
             LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
                       DHCP6_RESPONSE_DATA)
                 .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
 
-            if (!skip_pack) {
-                try {
-                    rsp->pack();
-                } catch (const std::exception& e) {
-                    LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
-                        .arg(e.what());
-                    continue;
-                }
-
-            }
-
-            try {
-
-                // Now all fields and options are constructed into output wire buffer.
-                // Option objects modification does not make sense anymore. Hooks
-                // can only manipulate wire buffer at this stage.
-                // Let's execute all callouts registered for buffer6_send
-                if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
-                    CalloutHandlePtr callout_handle = getCalloutHandle(query);
-
-                    // Delete previously set arguments
-                    callout_handle->deleteAllArguments();
-
-                    // Pass incoming packet as argument
-                    callout_handle->setArgument("response6", rsp);
-
-                    // Call callouts
-                    HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
+            sendPacket(rsp);
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
+                .arg(e.what());
+        }
+    }
+}
 
-                    // Callouts decided to skip the next processing step. The next
-                    // processing step would to parse the packet, so skip at this
-                    // stage means drop.
-                    if (callout_handle->getSkip()) {
-                        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
-                        continue;
-                    }
+void Dhcpv6Srv::startWorkers() {
+    const size_t threads = CfgMgr::instance().workerThreads();
+    if (worker_pool_.getThreadCount() != threads) {
+        // The standard option definitions are created on first use. Make
+        // sure they are created before the worker threads start using them.
+        LibDHCP::getOptionDefs(Option::V6);
 
-                    callout_handle->getArgument("response6", rsp);
-                }
+        worker_pool_.stop();
+        worker_pool_.start(threads, threads * MAX_QUEUED_PACKETS_PER_THREAD);
+    }
+}
 
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
-                          DHCP6_RESPONSE_DATA)
-                    .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+void Dhcpv6Srv::stopWorkers() {
+    worker_pool_.stop();
+}
 
-                sendPacket(rsp);
-            } catch (const std::exception& e) {
-                LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
-                    .arg(e.what());
-            }
-        }
+void Dhcpv6Srv::reclaimExpiredLeases() {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+    const uint32_t wait_time = cfg_mgr.reclaimTimerWaitTime();
+    const time_t now = time(NULL);
+    if ((wait_time == 0) || !alloc_engine_ || (now < next_reclaim_time_)) {
+        return;
     }
+    next_reclaim_time_ = now + wait_time;
 
-    return (true);
+    try {
+        alloc_engine_->reclaimExpiredLeases6(cfg_mgr.maxReclaimLeases(),
+                                             cfg_mgr.maxReclaimTime());
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp6_logger, DHCP6_RECLAIM_EXPIRED_LEASES_FAIL)
+            .arg(ex.what());
+    }
 }
 
 bool Dhcpv6Srv::loadServerID(const std::string& file_name) {
@@ -714,9 +846,9 @@ Dhcpv6Srv::appendDefaultOptions(const Pkt6Ptr&, Pkt6Ptr& answer) {
 }
 
 void
-Dhcpv6Srv::appendRequestedOptions(const Pkt6Ptr& question, Pkt6Ptr& answer) {
+Dhcpv6Srv::appendRequestedOptions(QueryContext6& ctx, Pkt6Ptr& answer) {
     // Get the configured subnet suitable for the incoming packet.
-    Subnet6Ptr subnet = selectSubnet(question);
+    Subnet6Ptr subnet = getSubnet(ctx);
     // Leave if there is no subnet matching the incoming packet.
     // There is no need to log the error message here because
     // it will be logged in the assignLease() when it fails to
@@ -729,7 +861,7 @@ Dhcpv6Srv::appendRequestedOptions(const Pkt6Ptr& question, Pkt6Ptr& answer) {
     // Client requests some options using ORO option. Try to
     // get this option from client's message.
     boost::shared_ptr<OptionIntArray<uint16_t> > option_oro =
-        boost::dynamic_pointer_cast<OptionIntArray<uint16_t> >(question->getOption(D6O_ORO));
+        boost::dynamic_pointer_cast<OptionIntArray<uint16_t> >(ctx.query_->getOption(D6O_ORO));
     // Option ORO not found. Don't do anything then.
     if (!option_oro) {
         return;
@@ -737,17 +869,17 @@ Dhcpv6Srv::appendRequestedOptions(const Pkt6Ptr& question, Pkt6Ptr& answer) {
     // Get the list of options that client requested.
     const std::vector<uint16_t>& requested_opts = option_oro->getValues();
     BOOST_FOREACH(uint16_t opt, requested_opts) {
-        Subnet::OptionDescriptor desc = subnet->getOptionDescriptor("dhcp6", opt);
-        if (desc.option) {
-            answer->addOption(desc.option);
+        PackedOption packed = subnet->getPackedOption(opt);
+        if (packed.option) {
+            answer->addPackedOption(packed);
         }
     }
 }
 
 void
-Dhcpv6Srv::appendRequestedVendorOptions(const Pkt6Ptr& question, Pkt6Ptr& answer) {
+Dhcpv6Srv::appendRequestedVendorOptions(QueryContext6& ctx, Pkt6Ptr& answer) {
     // Get the configured subnet suitable for the incoming packet.
-    Subnet6Ptr subnet = selectSubnet(question);
+    Subnet6Ptr subnet = getSubnet(ctx);
     // Leave if there is no subnet matching the incoming packet.
     // There is no need to log the error message here because
     // it will be logged in the assignLease() when it fails to
@@ -759,7 +891,7 @@ Dhcpv6Srv::appendRequestedVendorOptions(const Pkt6Ptr& question, Pkt6Ptr& answer
 
     // Try to get the vendor option
     boost::shared_ptr<OptionVendor> vendor_req =
-        boost::dynamic_pointer_cast<OptionVendor>(question->getOption(D6O_VENDOR_OPTS));
+        boost::dynamic_pointer_cast<OptionVendor>(ctx.query_->getOption(D6O_VENDOR_OPTS));
     if (!vendor_req) {
         return;
     }
@@ -943,15 +1075,25 @@ Dhcpv6Srv::selectSubnet(const Pkt6Ptr& question) {
     return (subnet);
 }
 
+Subnet6Ptr
+Dhcpv6Srv::getSubnet(QueryContext6& ctx) {
+    if (!ctx.subnet_selected_) {
+        ctx.subnet_ = selectSubnet(ctx.query_);
+        ctx.subnet_selected_ = true;
+    }
+    return (ctx.subnet_);
+}
+
 void
-Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer) {
+Dhcpv6Srv::assignLeases(QueryContext6& ctx, Pkt6Ptr& answer) {
+    const Pkt6Ptr& question = ctx.query_;
 
     // We need to allocate addresses for all IA_NA options in the client's
     // question (i.e. SOLICIT or REQUEST) message.
     // @todo add support for IA_TA
 
     // We need to select a subnet the client is connected in.
-    Subnet6Ptr subnet = selectSubnet(question);
+    Subnet6Ptr subnet = getSubnet(ctx);
     if (!subnet) {
         // This particular client is out of luck today. We do not have
         // information about the subnet he is connected to. This likely means
@@ -1149,7 +1291,7 @@ Dhcpv6Srv::createNameChangeRequests(const Pkt6Ptr& answer) {
 }
 
 void
-Dhcpv6Srv::createRemovalNameChangeRequest(const Lease6Ptr& lease) {
+Dhcpv6Srv::createRemovalNameChangeRequest(const ConstLease6Ptr& lease) {
     // Don't create NameChangeRequests if DNS updates are disabled.
     if (!CfgMgr::instance().ddnsEnabled()) {
         return;
@@ -1276,7 +1418,7 @@ Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
     // will try to honour the hint, but it is just a hint - some other address
     // may be used instead. If fake_allocation is set to false, the lease will
     // be inserted into the LeaseMgr as well.
-    Lease6Collection old_leases;
+    ConstLease6Collection old_leases;
     Lease6Collection leases = alloc_engine_->allocateLeases6(subnet, duid,
                                                              ia->getIAID(),
                                                              hint, Lease::TYPE_NA,
@@ -1319,7 +1461,7 @@ Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // but this is considered waste of bandwidth as absence of status
         // code is considered a success.
 
-        Lease6Ptr old_lease;
+        ConstLease6Ptr old_lease;
         if (!old_leases.empty()) {
             old_lease = *old_leases.begin();
         }
@@ -1405,7 +1547,7 @@ Dhcpv6Srv::assignIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
     // will try to honour the hint, but it is just a hint - some other address
     // may be used instead. If fake_allocation is set to false, the lease will
     // be inserted into the LeaseMgr as well.
-    Lease6Collection old_leases;
+    ConstLease6Collection old_leases;
     Lease6Collection leases = alloc_engine_->allocateLeases6(subnet, duid,
                                                              ia->getIAID(),
                                                              hint, Lease::TYPE_PD,
@@ -1810,7 +1952,8 @@ Dhcpv6Srv::extendIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
 }
 
 void
-Dhcpv6Srv::extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply) {
+Dhcpv6Srv::extendLeases(QueryContext6& ctx, Pkt6Ptr& reply) {
+    const Pkt6Ptr& query = ctx.query_;
 
     // We will try to extend lease lifetime for all IA options in the client's
     // Renew or Rebind message.
@@ -1819,7 +1962,7 @@ Dhcpv6Srv::extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply) {
     // We need to select a subnet the client is connected in. This is needed
     // to get the client's bindings from the lease database. The subnet id
     // is one of the lease search parameters.
-    Subnet6Ptr subnet = selectSubnet(query);
+    Subnet6Ptr subnet = getSubnet(ctx);
     if (!subnet) {
         // This particular client is out of luck today. We do not have
         // information about the subnet he is connected to. This likely means
@@ -2069,6 +2212,10 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success) {
+            // Make the address available for allocation again.
+            alloc_engine_->leaseRemoved(lease);
+        }
     }
 
     // Here the success should be true if we removed lease successfully
@@ -2213,6 +2360,10 @@ Dhcpv6Srv::releaseIA_PD(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success) {
+            // Make the prefix available for allocation again.
+            alloc_engine_->leaseRemoved(lease);
+        }
     } else {
         // Callouts decided to skip the next processing step. The next
         // processing step would to send the packet, so skip at this
@@ -2251,14 +2402,15 @@ Dhcpv6Srv::processSolicit(const Pkt6Ptr& solicit) {
     sanityCheck(solicit, MANDATORY, FORBIDDEN);
 
     Pkt6Ptr advertise(new Pkt6(DHCPV6_ADVERTISE, solicit->getTransid()));
+    QueryContext6 ctx(solicit);
 
     copyDefaultOptions(solicit, advertise);
     appendDefaultOptions(solicit, advertise);
-    appendRequestedOptions(solicit, advertise);
-    appendRequestedVendorOptions(solicit, advertise);
+    appendRequestedOptions(ctx, advertise);
+    appendRequestedVendorOptions(ctx, advertise);
 
     processClientFqdn(solicit, advertise);
-    assignLeases(solicit, advertise);
+    assignLeases(ctx, advertise);
     // Note, that we don't create NameChangeRequests here because we don't
     // perform DNS Updates for Solicit. Client must send Request to update
     // DNS.
@@ -2274,14 +2426,15 @@ Dhcpv6Srv::processRequest(const Pkt6Ptr& request) {
     sanityCheck(request, MANDATORY, MANDATORY);
 
     Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, request->getTransid()));
+    QueryContext6 ctx(request);
 
     copyDefaultOptions(request, reply);
     appendDefaultOptions(request, reply);
-    appendRequestedOptions(request, reply);
-    appendRequestedVendorOptions(request, reply);
+    appendRequestedOptions(ctx, reply);
+    appendRequestedVendorOptions(ctx, reply);
 
     processClientFqdn(request, reply);
-    assignLeases(request, reply);
+    assignLeases(ctx, reply);
     generateFqdn(reply);
     createNameChangeRequests(reply);
 
@@ -2294,13 +2447,14 @@ Dhcpv6Srv::processRenew(const Pkt6Ptr& renew) {
     sanityCheck(renew, MANDATORY, MANDATORY);
 
     Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, renew->getTransid()));
+    QueryContext6 ctx(renew);
 
     copyDefaultOptions(renew, reply);
     appendDefaultOptions(renew, reply);
-    appendRequestedOptions(renew, reply);
+    appendRequestedOptions(ctx, reply);
 
     processClientFqdn(renew, reply);
-    extendLeases(renew, reply);
+    extendLeases(ctx, reply);
     generateFqdn(reply);
     createNameChangeRequests(reply);
 
@@ -2311,13 +2465,14 @@ Pkt6Ptr
 Dhcpv6Srv::processRebind(const Pkt6Ptr& rebind) {
 
     Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, rebind->getTransid()));
+    QueryContext6 ctx(rebind);
 
     copyDefaultOptions(rebind, reply);
     appendDefaultOptions(rebind, reply);
-    appendRequestedOptions(rebind, reply);
+    appendRequestedOptions(ctx, reply);
 
     processClientFqdn(rebind, reply);
-    extendLeases(rebind, reply);
+    extendLeases(ctx, reply);
     generateFqdn(reply);
     createNameChangeRequests(rebind);
 
@@ -2444,17 +2599,18 @@ Dhcpv6Srv::unpackOptions(const OptionBuffer& buf,
     size_t offset = 0;
     size_t length = buf.size();
 
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp6") {
-        // Get the list of stdandard option definitions.
-        option_defs = LibDHCP::getOptionDefs(Option::V6);
-    } else if (!option_space.empty()) {
-        OptionDefContainerPtr option_defs_ptr =
-            CfgMgr::instance().getOptionDefs(option_space);
-        if (option_defs_ptr != NULL) {
-            option_defs = *option_defs_ptr;
-        }
-    }
+    // The option definitions are referenced rather than copied because
+    // this function is called for every received packet and for every
+    // option which encapsulates other options. The pointer holds the
+    // configured definitions while they are used.
+    OptionDefContainerPtr option_defs_ptr;
+    if (!option_space.empty() && (option_space != "dhcp6")) {
+        option_defs_ptr = CfgMgr::instance().getOptionDefs(option_space);
+    }
+    // Get the list of stdandard option definitions for the dhcp6 space.
+    const OptionDefContainer& option_defs = (option_space == "dhcp6" ?
+        LibDHCP::getOptionDefs(Option::V6) :
+        (option_defs_ptr ? *option_defs_ptr : empty_option_defs));
 
     // Get the search index #1. It allows to search for option definitions
     // using option code.
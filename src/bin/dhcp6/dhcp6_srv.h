@@ -24,10 +24,12 @@
 #include <dhcp/option_definition.h>
 #include <dhcp/pkt6.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/client_lock_mgr.h>
 #include <dhcpsrv/d2_client_mgr.h>
 #include <dhcpsrv/subnet.h>
 #include <hooks/callout_handle.h>
 #include <dhcpsrv/daemon.h>
+#include <dhcpsrv/worker_pool.h>
 
 #include <iostream>
 #include <queue>
@@ -43,6 +45,33 @@ public:
         isc::Exception(file, line, what) { };
 };
 
+/// @brief Context of the DHCPv6 query being processed.
+///
+/// The context is created when the server starts processing the query and
+/// it is passed to the functions processing it. It holds the information
+/// used by more than one processing stage, so as this information is
+/// obtained once for the query. In particular, the subnet is selected and
+/// the subnet6_select callouts are called once for the query.
+struct QueryContext6 {
+    /// @brief Constructor.
+    ///
+    /// @param query query being processed
+    explicit QueryContext6(const Pkt6Ptr& query)
+        : query_(query), subnet_selected_(false) {
+    }
+
+    /// @brief Query being processed.
+    Pkt6Ptr query_;
+
+    /// @brief Subnet selected for the query.
+    Subnet6Ptr subnet_;
+
+    /// @brief Indicates if the subnet has been selected.
+    ///
+    /// The subnet is selected when it is needed for the first time.
+    bool subnet_selected_;
+};
+
 /// @brief DHCPv6 server service.
 ///
 /// This class represents DHCPv6 server. It contains all
@@ -84,14 +113,30 @@ public:
 
     /// @brief Main server processing loop.
     ///
-    /// Main server processing loop. Receives incoming packets, verifies
-    /// their correctness, generates appropriate answer (if needed) and
-    /// transmits responses.
+    /// Main server processing loop. Receives incoming packets and passes
+    /// them to @c Dhcpv6Srv::processPacket. If the server is configured to
+    /// use worker threads, the packets are queued for processing by these
+    /// threads. Otherwise, they are processed by the thread running this
+    /// loop.
     ///
     /// @return true, if being shut down gracefully, fail if experienced
     ///         critical error.
     bool run();
 
+    /// @brief Processes a single received packet.
+    ///
+    /// Verifies the packet's correctness, generates appropriate answer (if
+    /// needed) and transmits the response. All hook points for the packet
+    /// are called within this function, so as the callout handle associated
+    /// with the packet is used by a single thread.
+    ///
+    /// Packets carrying the same client identifier are never processed
+    /// concurrently: the function drops the packet if another packet from
+    /// the same client is being processed by other thread.
+    ///
+    /// @param query A pointer to the packet received from the client.
+    void processPacket(Pkt6Ptr query);
+
     /// @brief Instructs the server to shut down.
     void shutdown();
 
@@ -258,6 +303,16 @@ protected:
     /// @return selected subnet (or NULL if no suitable subnet was found)
     isc::dhcp::Subnet6Ptr selectSubnet(const Pkt6Ptr& question);
 
+    /// @brief Returns the subnet selected for the query.
+    ///
+    /// The subnet is selected with @c selectSubnet when this function is
+    /// called for the query for the first time. Subsequent calls return
+    /// the subnet stored in the context.
+    ///
+    /// @param ctx context of the client's message
+    /// @return selected subnet (or NULL if no suitable subnet was found)
+    isc::dhcp::Subnet6Ptr getSubnet(QueryContext6& ctx);
+
     /// @brief Processes IA_NA option (and assigns addresses if necessary).
     ///
     /// Generates response to IA_NA. This typically includes selecting (and
@@ -413,18 +468,18 @@ protected:
     ///
     /// Appends options requested by client to the server's answer.
     ///
-    /// @param question client's message
+    /// @param ctx context of the client's message
     /// @param answer server's message (options will be added here)
-    void appendRequestedOptions(const Pkt6Ptr& question, Pkt6Ptr& answer);
+    void appendRequestedOptions(QueryContext6& ctx, Pkt6Ptr& answer);
 
     /// @brief Appends requested vendor options to server's answer.
     ///
     /// This is mostly useful for Cable Labs options for now, but the method
     /// is easily extensible to other vendors.
     ///
-    /// @param question client's message
+    /// @param ctx context of the client's message
     /// @param answer server's message (vendor options will be added here)
-    void appendRequestedVendorOptions(const Pkt6Ptr& question, Pkt6Ptr& answer);
+    void appendRequestedVendorOptions(QueryContext6& ctx, Pkt6Ptr& answer);
 
     /// @brief Assigns leases.
     ///
@@ -432,11 +487,11 @@ protected:
     /// addresses (IA_TA) nor prefixes (IA_PD).
     /// @todo: Extend this method once TA and PD becomes supported
     ///
-    /// @param question client's message (with requested IA_NA)
+    /// @param ctx context of the client's message (with requested IA_NA)
     /// @param answer server's message (IA_NA options will be added here).
     /// This message should contain Client FQDN option being sent by the server
     /// to the client (if the client sent this option to the server).
-    void assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer);
+    void assignLeases(QueryContext6& ctx, Pkt6Ptr& answer);
 
     /// @brief Processes Client FQDN Option.
     ///
@@ -494,7 +549,7 @@ protected:
     ///
     /// @param lease A lease for which the the removal of corresponding DNS
     /// records will be performed.
-    void createRemovalNameChangeRequest(const Lease6Ptr& lease);
+    void createRemovalNameChangeRequest(const ConstLease6Ptr& lease);
 
     /// @brief Attempts to extend the lifetime of IAs.
     ///
@@ -504,9 +559,9 @@ protected:
     /// @c Dhcpv6Srv::extendIA_NA and @c Dhcpv6Srv::extendIA_PD to extend
     /// the lifetime of IA_NA and IA_PD leases accordingly.
     ///
-    /// @param query client's Renew or Rebind message
+    /// @param ctx context of the client's Renew or Rebind message
     /// @param reply server's response
-    void extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply);
+    void extendLeases(QueryContext6& ctx, Pkt6Ptr& reply);
 
     /// @brief Attempts to release received addresses
     ///
@@ -556,7 +611,11 @@ protected:
     static std::string duidToString(const OptionPtr& opt);
 
 
-    /// @brief dummy wrapper around IfaceMgr::receive6
+    /// @brief dummy wrapper around IfaceMgr::receive6Batch
+    ///
+    /// It returns the packets received by a single call to
+    /// IfaceMgr::receive6Batch one by one, and receives the new packets
+    /// when all of them have been returned.
     ///
     /// This method is useful for testing purposes, where its replacement
     /// simulates reception of a packet. For that purpose it is protected.
@@ -564,10 +623,19 @@ protected:
 
     /// @brief dummy wrapper around IfaceMgr::send()
     ///
+    /// If no worker threads are running, the packet is appended to the
+    /// send queue of the IfaceMgr, which is flushed by
+    /// @c sendQueuedPackets.
+    ///
     /// This method is useful for testing purposes, where its replacement
     /// simulates transmission of a packet. For that purpose it is protected.
     virtual void sendPacket(const Pkt6Ptr& pkt);
 
+    /// @brief Sends the responses queued by @c sendPacket.
+    ///
+    /// The errors are logged.
+    void sendQueuedPackets();
+
     /// @brief Implements a callback function to parse options in the message.
     ///
     /// @param buf a A buffer holding options in on-wire format.
@@ -670,8 +738,55 @@ private:
     /// UDP port number on which server listens.
     uint16_t port_;
 
+    /// Threads processing received packets.
+    WorkerPool worker_pool_;
+
+    /// Time when the expired leases should be reclaimed next time.
+    time_t next_reclaim_time_;
+
+    /// Packets received by the last call to @c IfaceMgr::receive6Batch.
+    Pkt6Collection received_;
+
+    /// Position of the next packet to be returned from @c received_.
+    size_t received_pos_;
+
+    /// Indicates that the responses are queued by @c sendPacket, because
+    /// the packets are processed by the thread receiving them.
+    bool queue_responses_;
+
+    /// Serializes processing of packets sent by the same client.
+    ClientLockMgr client_lock_mgr_;
+
 protected:
 
+    /// @brief Starts or restarts the packet processing threads.
+    ///
+    /// This function checks whether the number of running worker threads
+    /// matches the value returned by @c CfgMgr::workerThreads. If it
+    /// doesn't, the running threads are stopped and the configured number
+    /// of threads is started. It is no-op if the number of threads is
+    /// already correct.
+    void startWorkers();
+
+    /// @brief Stops the packet processing threads.
+    ///
+    /// This function waits for the worker threads to process queued packets
+    /// and terminate. It must be called before the server configuration is
+    /// modified, so as the configuration isn't accessed by the workers while
+    /// it is being updated. The threads are started again, using the new
+    /// configuration, by the next iteration of @c Dhcpv6Srv::run.
+    void stopWorkers();
+
+    /// @brief Reclaims expired leases if the reclamation is due.
+    ///
+    /// The expired leases are reclaimed every
+    /// @c CfgMgr::reclaimTimerWaitTime seconds. It is no-op if the
+    /// reclamation is not due yet or if it has been disabled by setting
+    /// this value to 0. The number of leases reclaimed in one cycle and
+    /// the duration of the cycle are limited according to
+    /// @c CfgMgr::maxReclaimLeases and @c CfgMgr::maxReclaimTime.
+    void reclaimExpiredLeases();
+
     /// Indicates if shutdown is in progress. Setting it to true will
     /// initiate server shutdown procedure.
     volatile bool shutdown_;
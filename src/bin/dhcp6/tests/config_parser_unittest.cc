@@ -566,6 +566,151 @@ TEST_F(Dhcp6ParserTest, subnetGlobalDefaults) {
     EXPECT_EQ(1, subnet->getID());
 }
 
+// Check whether it is possible to configure the number of worker threads
+TEST_F(Dhcp6ParserTest, workerThreads) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interfaces\": [ \"*\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"worker-threads\": 4,"
+        "\"subnet6\": [ { "
+        "    \"pools\": [ { \"pool\": \"2001:db8:1::1 - 2001:db8:1::ffff\" } ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    string config_default = "{ \"interfaces\": [ \"*\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet6\": [ { "
+        "    \"pools\": [ { \"pool\": \"2001:db8:1::1 - 2001:db8:1::ffff\" } ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    // By default, the packets are processed by the main thread.
+    ASSERT_EQ(0, CfgMgr::instance().workerThreads());
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config)));
+    checkResult(status, 0);
+    EXPECT_EQ(4, CfgMgr::instance().workerThreads());
+
+    // Omitting the parameter restores the default.
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config_default)));
+    checkResult(status, 0);
+    EXPECT_EQ(0, CfgMgr::instance().workerThreads());
+}
+
+// Check that the group commit of the lease database is rejected when the
+// packets are processed by the main thread.
+TEST_F(Dhcp6ParserTest, groupCommitWithoutWorkerThreads) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interfaces\": [ \"*\" ],"
+        "\"lease-database\": { \"type\": \"mysql\","
+        "    \"name\": \"keatest\", \"group-commit-size\": 8 },"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet6\": [ { "
+        "    \"pools\": [ { \"pool\": \"2001:db8:1::1 - 2001:db8:1::ffff\" } ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    // The configuration is rejected before the database is opened.
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config)));
+    checkResult(status, 1);
+    EXPECT_NE(std::string::npos, comment_->stringValue().find("worker-threads"));
+}
+
+// Check that the parameters controlling the reclamation of expired leases
+// can be configured.
+TEST_F(Dhcp6ParserTest, reclaimParameters) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interfaces\": [ \"*\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"reclaim-timer-wait-time\": 20,"
+        "\"max-reclaim-leases\": 50,"
+        "\"max-reclaim-time\": 500,"
+        "\"subnet6\": [ { "
+        "    \"pools\": [ { \"pool\": \"2001:db8:1::1 - 2001:db8:1::ffff\" } ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    string config_default = "{ \"interfaces\": [ \"*\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet6\": [ { "
+        "    \"pools\": [ { \"pool\": \"2001:db8:1::1 - 2001:db8:1::ffff\" } ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config)));
+    checkResult(status, 0);
+    EXPECT_EQ(20, CfgMgr::instance().reclaimTimerWaitTime());
+    EXPECT_EQ(50, CfgMgr::instance().maxReclaimLeases());
+    EXPECT_EQ(500, CfgMgr::instance().maxReclaimTime());
+
+    // Omitting the parameters restores the defaults.
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config_default)));
+    checkResult(status, 0);
+    EXPECT_EQ(CfgMgr::DEFAULT_RECLAIM_TIMER_WAIT_TIME,
+              CfgMgr::instance().reclaimTimerWaitTime());
+    EXPECT_EQ(CfgMgr::DEFAULT_MAX_RECLAIM_LEASES,
+              CfgMgr::instance().maxReclaimLeases());
+    EXPECT_EQ(CfgMgr::DEFAULT_MAX_RECLAIM_TIME,
+              CfgMgr::instance().maxReclaimTime());
+}
+
+// This test checks that the free address tracking can be enabled.
+TEST_F(Dhcp6ParserTest, freeAddressTracking) {
+
+    ConstElementPtr status;
+
+    string config = "{ \"interfaces\": [ \"*\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"free-address-tracking\": true,"
+        "\"subnet6\": [ { "
+        "    \"pools\": [ { \"pool\": \"2001:db8:1::1 - 2001:db8:1::ffff\" } ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    string config_default = "{ \"interfaces\": [ \"*\" ],"
+        "\"preferred-lifetime\": 3000,"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, "
+        "\"subnet6\": [ { "
+        "    \"pools\": [ { \"pool\": \"2001:db8:1::1 - 2001:db8:1::ffff\" } ],"
+        "    \"subnet\": \"2001:db8:1::/64\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config)));
+    checkResult(status, 0);
+    EXPECT_TRUE(CfgMgr::instance().freeAddressTracking());
+
+    // Omitting the parameter disables the tracking.
+    EXPECT_NO_THROW(status = configureDhcp6Server(srv_,
+                                                  Element::fromJSON(config_default)));
+    checkResult(status, 0);
+    EXPECT_FALSE(CfgMgr::instance().freeAddressTracking());
+}
+
 // This test checks that multiple subnets can be defined and handled properly.
 TEST_F(Dhcp6ParserTest, multipleSubnets) {
     ConstElementPtr x;
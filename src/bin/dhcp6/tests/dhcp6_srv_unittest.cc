@@ -936,6 +936,33 @@ TEST_F(Dhcpv6SrvTest, pdRenewReject) {
     testRenewReject(Lease::TYPE_PD, IOAddress("2001:db8:1:2::"));
 }
 
+// This test verifies that the server reclaims expired leases and that the
+// reclamation can be disabled.
+TEST_F(Dhcpv6SrvTest, reclaimExpiredLeases) {
+    NakedDhcpv6Srv srv(0);
+
+    // Generate the DUID of the client.
+    generateClientId();
+
+    // Create a lease which expired 400 seconds ago.
+    const IOAddress addr("2001:db8:1:1::cafe:babe");
+    ASSERT_TRUE(subnet_->inPool(Lease::TYPE_NA, addr));
+    Lease6Ptr lease(new Lease6(Lease::TYPE_NA, addr, duid_, 234, 50, 100,
+                               25, 40, subnet_->getID()));
+    lease->cltt_ = time(NULL) - 500;
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+
+    // The lease must not be reclaimed when the reclamation is disabled.
+    CfgMgr::instance().reclaimTimerWaitTime(0);
+    srv.reclaimExpiredLeases();
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addr));
+
+    // Enable the reclamation. The lease should be removed.
+    CfgMgr::instance().reclaimTimerWaitTime(CfgMgr::DEFAULT_RECLAIM_TIMER_WAIT_TIME);
+    srv.reclaimExpiredLeases();
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addr));
+}
+
 // This test verifies that incoming (positive) RELEASE with address can be
 // handled properly, that a REPLY is generated, that the response has status
 // code and that the lease is indeed removed from the database.
@@ -1342,6 +1369,39 @@ TEST_F(Dhcpv6SrvTest, selectSubnetRelayLinkaddr) {
 
 }
 
+// This test verifies that the subnet is selected once for the query context.
+TEST_F(Dhcpv6SrvTest, getSubnet) {
+    NakedDhcpv6Srv srv(0);
+
+    Subnet6Ptr subnet1(new Subnet6(IOAddress("2001:db8:1::"), 48, 1, 2, 3, 4));
+    Subnet6Ptr subnet2(new Subnet6(IOAddress("2001:db8:2::"), 48, 1, 2, 3, 4));
+
+    CfgMgr::instance().deleteSubnets6();
+    CfgMgr::instance().addSubnet6(subnet1);
+    CfgMgr::instance().addSubnet6(subnet2);
+
+    Pkt6::RelayInfo relay;
+    relay.linkaddr_ = IOAddress("2001:db8:2::1234");
+    relay.peeraddr_ = IOAddress("fe80::1");
+
+    Pkt6Ptr pkt = Pkt6Ptr(new Pkt6(DHCPV6_SOLICIT, 1234));
+    pkt->relay_info_.push_back(relay);
+
+    QueryContext6 ctx(pkt);
+    EXPECT_FALSE(ctx.subnet_selected_);
+    EXPECT_EQ(subnet2, srv.getSubnet(ctx));
+    EXPECT_TRUE(ctx.subnet_selected_);
+
+    // The subnet held in the context is returned, even though the relay
+    // now belongs to the other subnet.
+    pkt->relay_info_[0].linkaddr_ = IOAddress("2001:db8:1::1234");
+    EXPECT_EQ(subnet2, srv.getSubnet(ctx));
+
+    // The subnet is selected again for the new context.
+    QueryContext6 ctx2(pkt);
+    EXPECT_EQ(subnet1, srv.getSubnet(ctx2));
+}
+
 // This test verifies if selectSubnet() selects proper subnet for a given
 // interface-id option
 TEST_F(Dhcpv6SrvTest, selectSubnetRelayInterfaceId) {
@@ -103,6 +103,8 @@ public:
     using Dhcpv6Srv::createRemovalNameChangeRequest;
     using Dhcpv6Srv::createStatusCode;
     using Dhcpv6Srv::selectSubnet;
+    using Dhcpv6Srv::getSubnet;
+    using Dhcpv6Srv::reclaimExpiredLeases;
     using Dhcpv6Srv::testServerID;
     using Dhcpv6Srv::testUnicast;
     using Dhcpv6Srv::sanityCheck;
@@ -24,6 +24,7 @@
 #include <exceptions/exceptions.h>
 #include <asiolink/io_address.h>
 #include <asiolink/io_error.h>
+#include <boost/functional/hash.hpp>
 #include <boost/static_assert.hpp>
 
 using namespace asio;
@@ -125,6 +126,17 @@ IOAddress::operator uint32_t() const {
     }
 }
 
+size_t
+hash_value(const IOAddress& address) {
+    if (address.asio_address_.is_v4()) {
+        return (static_cast<size_t>(address.asio_address_.to_v4().to_ulong()));
+    }
+
+    const asio::ip::address_v6::bytes_type bytes6 =
+        address.asio_address_.to_v6().to_bytes();
+    return (boost::hash_range(bytes6.begin(), bytes6.end()));
+}
+
 std::ostream&
 operator<<(std::ostream& os, const IOAddress& address) {
     os << address.toText();
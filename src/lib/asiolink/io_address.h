@@ -230,10 +230,28 @@ public:
     ///         network byte order
     operator uint32_t () const;
 
+    /// \brief Computes the hash value of the address.
+    ///
+    /// This function allows for using \c IOAddress as a key in the
+    /// containers using \c boost::hash, e.g. hashed indexes of the
+    /// \c boost::multi_index_container.
+    ///
+    /// \param address Address for which the hash should be computed.
+    ///
+    /// \return Hash value of the address.
+    friend size_t hash_value(const IOAddress& address);
+
 private:
     asio::ip::address asio_address_;
 };
 
+/// \brief Computes the hash value of the address.
+///
+/// \param address Address for which the hash should be computed.
+///
+/// \return Hash value of the address.
+size_t hash_value(const IOAddress& address);
+
 /// \brief Insert the IOAddress as a string into stream.
 ///
 /// This method converts the \c address into a string and inserts it
@@ -18,6 +18,8 @@
 #include <asiolink/io_error.h>
 #include <asiolink/io_address.h>
 
+#include <boost/functional/hash.hpp>
+
 #include <algorithm>
 #include <cstring>
 #include <vector>
@@ -217,3 +219,17 @@ TEST(IOAddressTest, accessClassificationMethods) {
     EXPECT_FALSE(addr5.isV6LinkLocal());
     EXPECT_TRUE (addr5.isV6Multicast());
 }
+
+// Test that the hash values of equal addresses are equal and that the
+// addresses can be used with boost::hash.
+TEST(IOAddressTest, hashValue) {
+    boost::hash<IOAddress> hasher;
+
+    EXPECT_EQ(hasher(IOAddress("192.0.2.1")), hasher(IOAddress("192.0.2.1")));
+    EXPECT_NE(hasher(IOAddress("192.0.2.1")), hasher(IOAddress("192.0.2.2")));
+
+    EXPECT_EQ(hasher(IOAddress("2001:db8::1")),
+              hasher(IOAddress("2001:db8::1")));
+    EXPECT_NE(hasher(IOAddress("2001:db8::1")),
+              hasher(IOAddress("2001:db8::2")));
+}
@@ -0,0 +1,410 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/docsis3_option_defs.h>
+#include <dhcp/libdhcp++.h>
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+#include <exceptions/exceptions.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+
+using namespace std;
+using namespace isc::dhcp;
+
+// Measures the cost of parsing received packets which carry the options
+// sent by the DOCSIS cable modems and added by the relay agents. The
+// DHCPv4 packets are parsed at once and lazily, i.e. with the options
+// created when they are first accessed. The lazy parsing is measured
+// for the packets which are dropped right after parsing, for the packets
+// from which only the message type, client identifier and parameter
+// request list are read, and for the packets from which all options are
+// read. The DHCPv6 packets are always parsed at once.
+//
+// Usage: pkt_unpack_bench [-n packets]
+//
+// The number of packets parsed in each measurement defaults to 100000.
+
+namespace {
+
+/// @brief Returns current time in microseconds.
+double
+now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1e6 + tv.tv_usec);
+}
+
+/// @brief Returns the buffer holding the string.
+OptionBuffer
+text(const char* value) {
+    return (OptionBuffer(value, value + strlen(value)));
+}
+
+/// @brief Returns the buffer holding the bytes.
+OptionBuffer
+bytes(const uint8_t* value, const size_t len) {
+    return (OptionBuffer(value, value + len));
+}
+
+/// @brief Appends DHCPv4 option to the buffer.
+void
+addOption4(OptionBuffer& buf, const uint8_t code, const OptionBuffer& data) {
+    buf.push_back(code);
+    buf.push_back(static_cast<uint8_t>(data.size()));
+    buf.insert(buf.end(), data.begin(), data.end());
+}
+
+/// @brief Appends DHCPv6 option to the buffer.
+void
+addOption6(OptionBuffer& buf, const uint16_t code, const OptionBuffer& data) {
+    buf.push_back(code >> 8);
+    buf.push_back(code & 0xFF);
+    buf.push_back(data.size() >> 8);
+    buf.push_back(data.size() & 0xFF);
+    buf.insert(buf.end(), data.begin(), data.end());
+}
+
+/// @brief Appends the enterprise number to the buffer.
+void
+addEnterprise(OptionBuffer& buf, const uint32_t enterprise) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        buf.push_back((enterprise >> shift) & 0xFF);
+    }
+}
+
+/// @brief Enterprise number of the CableLabs.
+const uint32_t CABLELABS = 4491;
+
+/// @brief Creates the DHCPv4 header and the magic cookie.
+///
+/// @param relayed Indicates if the packet is sent by the relay agent.
+OptionBuffer
+createHeader4(const bool relayed) {
+    OptionBuffer buf(Pkt4::DHCPV4_PKT_HDR_LEN, 0);
+    buf[0] = BOOTREQUEST;
+    buf[1] = HTYPE_ETHER;
+    buf[2] = 6;
+    buf[3] = relayed ? 1 : 0;
+    // Transaction identifier.
+    buf[4] = 0x12;
+    buf[5] = 0x34;
+    buf[6] = 0x56;
+    buf[7] = 0x78;
+    if (relayed) {
+        // Giaddr: 10.1.0.1.
+        buf[24] = 10;
+        buf[25] = 1;
+        buf[27] = 1;
+    }
+    // Chaddr.
+    const uint8_t mac[] = { 0x00, 0x1a, 0xc3, 0x0a, 0x0b, 0x0c };
+    memcpy(&buf[28], mac, sizeof(mac));
+    addEnterprise(buf, DHCP_OPTIONS_COOKIE);
+    return (buf);
+}
+
+/// @brief Creates the relay agent information option.
+///
+/// The option carries the circuit and remote identifiers, the DOCSIS
+/// device class and the vendor specific information.
+OptionBuffer
+createRelayAgentInfo() {
+    OptionBuffer rai;
+    addOption4(rai, RAI_OPTION_AGENT_CIRCUIT_ID, text("cmts1/Cable3/0/1:U0"));
+    const uint8_t remote_id[] = { 0x00, 0x1a, 0xc3, 0x0a, 0x0b, 0x0c };
+    addOption4(rai, RAI_OPTION_REMOTE_ID, bytes(remote_id, sizeof(remote_id)));
+    const uint8_t device_class[] = { 0x00, 0x00, 0x00, 0x02 };
+    addOption4(rai, RAI_OPTION_DOCSIS_DEVICE_CLASS,
+               bytes(device_class, sizeof(device_class)));
+    OptionBuffer vsi;
+    addEnterprise(vsi, CABLELABS);
+    vsi.push_back(0);
+    addOption4(vsi, 1, text("cmts1"));
+    addOption4(vsi, 2, text("Cable3/0/1"));
+    vsi[4] = vsi.size() - 5;
+    addOption4(rai, RAI_OPTION_VSI, vsi);
+    addOption4(rai, RAI_OPTION_SUBSCRIBER_ID, text("subscriber-000123"));
+    return (rai);
+}
+
+/// @brief Creates the DHCPDISCOVER sent by the DOCSIS cable modem.
+OptionBuffer
+createDocsisDiscover() {
+    OptionBuffer buf = createHeader4(true);
+    const uint8_t type[] = { DHCPDISCOVER };
+    addOption4(buf, DHO_DHCP_MESSAGE_TYPE, bytes(type, sizeof(type)));
+    const uint8_t max_size[] = { 0x05, 0xdc };
+    addOption4(buf, DHO_DHCP_MAX_MESSAGE_SIZE,
+               bytes(max_size, sizeof(max_size)));
+    const uint8_t client_id[] = { 0x01, 0x00, 0x1a, 0xc3, 0x0a, 0x0b, 0x0c };
+    addOption4(buf, DHO_DHCP_CLIENT_IDENTIFIER,
+               bytes(client_id, sizeof(client_id)));
+    const uint8_t prl[] = { 1, 2, 3, 4, 6, 7, 42, 43, 66, 67, 100, 101, 122,
+                            125 };
+    addOption4(buf, DHO_DHCP_PARAMETER_REQUEST_LIST, bytes(prl, sizeof(prl)));
+    // The modem capabilities are encoded in the vendor class identifier.
+    addOption4(buf, DHO_VENDOR_CLASS_IDENTIFIER,
+               text("docsis3.0:053b0101010201020301010401010501010601010701"
+                    "0f0801100901000a01010b01180c01010d0200400e0200100f"));
+    // Device information of the cable modem.
+    OptionBuffer device_info;
+    addOption4(device_info, 2, text("ECM"));
+    addOption4(device_info, 3, text("ECM:EROUTER"));
+    addOption4(device_info, 4, text("SN0123456789"));
+    addOption4(device_info, 5, text("V1.0"));
+    addOption4(device_info, 6, text("CM-FW-7.1.2.3"));
+    addOption4(device_info, 7, text("BOOT-2.4.0"));
+    addOption4(device_info, 8, text("001AC3"));
+    addOption4(device_info, 9, text("CM8200"));
+    addOption4(device_info, 10, text("Vendor"));
+    addOption4(buf, DHO_VENDOR_ENCAPSULATED_OPTIONS, device_info);
+    OptionBuffer vivso;
+    addEnterprise(vivso, CABLELABS);
+    OptionBuffer docsis;
+    const uint8_t oro[] = { DOCSIS3_V4_ORO, DOCSIS3_V4_TFTP_SERVERS };
+    addOption4(docsis, DOCSIS3_V4_ORO, bytes(oro, sizeof(oro)));
+    vivso.push_back(static_cast<uint8_t>(docsis.size()));
+    vivso.insert(vivso.end(), docsis.begin(), docsis.end());
+    addOption4(buf, DHO_VIVSO_SUBOPTIONS, vivso);
+    addOption4(buf, DHO_DHCP_AGENT_OPTIONS, createRelayAgentInfo());
+    buf.push_back(DHO_END);
+    return (buf);
+}
+
+/// @brief Creates the renewing DHCPREQUEST forwarded by the relay agent.
+OptionBuffer
+createRelayedRequest() {
+    OptionBuffer buf = createHeader4(true);
+    const uint8_t type[] = { DHCPREQUEST };
+    addOption4(buf, DHO_DHCP_MESSAGE_TYPE, bytes(type, sizeof(type)));
+    const uint8_t client_id[] = { 0x01, 0x00, 0x1a, 0xc3, 0x0a, 0x0b, 0x0c };
+    addOption4(buf, DHO_DHCP_CLIENT_IDENTIFIER,
+               bytes(client_id, sizeof(client_id)));
+    const uint8_t address[] = { 10, 1, 0, 100 };
+    addOption4(buf, DHO_DHCP_REQUESTED_ADDRESS,
+               bytes(address, sizeof(address)));
+    const uint8_t server_id[] = { 10, 0, 0, 1 };
+    addOption4(buf, DHO_DHCP_SERVER_IDENTIFIER,
+               bytes(server_id, sizeof(server_id)));
+    const uint8_t prl[] = { 1, 3, 6, 12, 15, 28, 42, 51, 54, 58, 59, 119,
+                            121 };
+    addOption4(buf, DHO_DHCP_PARAMETER_REQUEST_LIST, bytes(prl, sizeof(prl)));
+    addOption4(buf, DHO_HOST_NAME, text("subscriber-router"));
+    const uint8_t subnet[] = { 10, 1, 0, 0 };
+    addOption4(buf, DHO_SUBNET_SELECTION, bytes(subnet, sizeof(subnet)));
+    addOption4(buf, DHO_DHCP_AGENT_OPTIONS, createRelayAgentInfo());
+    buf.push_back(DHO_END);
+    return (buf);
+}
+
+/// @brief Creates the SOLICIT sent by the DOCSIS cable modem and forwarded
+/// by the three relay agents.
+OptionBuffer
+createRelayedSolicit() {
+    OptionBuffer msg(4, 0);
+    msg[0] = DHCPV6_SOLICIT;
+    msg[1] = 0x12;
+    msg[2] = 0x34;
+    msg[3] = 0x56;
+    const uint8_t duid[] = { 0x00, 0x01, 0x00, 0x01, 0x1a, 0x2b, 0x3c, 0x4d,
+                             0x00, 0x1a, 0xc3, 0x0a, 0x0b, 0x0c };
+    addOption6(msg, D6O_CLIENTID, bytes(duid, sizeof(duid)));
+    const uint8_t elapsed[] = { 0x00, 0x00 };
+    addOption6(msg, D6O_ELAPSED_TIME, bytes(elapsed, sizeof(elapsed)));
+    const uint8_t oro[] = { 0x00, 0x17, 0x00, 0x18, 0x00, 0x1f, 0x00, 0x11 };
+    addOption6(msg, D6O_ORO, bytes(oro, sizeof(oro)));
+    const uint8_t ia_na[] = { 0x0a, 0x0b, 0x0c, 0x0d, 0, 0, 0, 0, 0, 0, 0, 0 };
+    addOption6(msg, D6O_IA_NA, bytes(ia_na, sizeof(ia_na)));
+    OptionBuffer vendor_class;
+    addEnterprise(vendor_class, CABLELABS);
+    vendor_class.push_back(0);
+    vendor_class.push_back(9);
+    const OptionBuffer docsis = text("docsis3.0");
+    vendor_class.insert(vendor_class.end(), docsis.begin(), docsis.end());
+    addOption6(msg, D6O_VENDOR_CLASS, vendor_class);
+    OptionBuffer vendor_opts;
+    addEnterprise(vendor_opts, CABLELABS);
+    const uint8_t docsis_oro[] = { 0x00, 0x20, 0x00, 0x21, 0x00, 0x22,
+                                   0x00, 0x25, 0x00, 0x26 };
+    addOption6(vendor_opts, DOCSIS3_V6_ORO,
+               bytes(docsis_oro, sizeof(docsis_oro)));
+    addOption6(vendor_opts, DOCSIS3_V6_DEVICE_TYPE, text("ECM"));
+    addOption6(vendor_opts, DOCSIS3_V6_VENDOR_NAME, text("Vendor"));
+    addOption6(vendor_opts, 36, bytes(duid + 8, 6));
+    addOption6(msg, D6O_VENDOR_OPTS, vendor_opts);
+
+    // Each relay agent adds its identifiers around the message.
+    for (int hop = 0; hop < 3; ++hop) {
+        OptionBuffer relay(34, 0);
+        relay[0] = DHCPV6_RELAY_FORW;
+        relay[1] = hop;
+        relay[2] = 0x20;
+        relay[3] = 0x01;
+        relay[4] = 0x0d;
+        relay[5] = 0xb8;
+        relay[17] = hop + 1;
+        relay[18] = 0xfe;
+        relay[19] = 0x80;
+        relay[33] = hop + 1;
+        addOption6(relay, D6O_INTERFACE_ID, text("cmts1/Cable3/0/1"));
+        OptionBuffer remote_id;
+        addEnterprise(remote_id, CABLELABS);
+        remote_id.insert(remote_id.end(), duid + 8, duid + 14);
+        addOption6(relay, D6O_REMOTE_ID, remote_id);
+        addOption6(relay, D6O_SUBSCRIBER_ID, text("subscriber-000123"));
+        addOption6(relay, D6O_RELAY_MSG, msg);
+        msg.swap(relay);
+    }
+    return (msg);
+}
+
+/// @brief Prints a single result.
+void
+report(const char* name, const size_t packets, const double start,
+       const double end) {
+    cout << "  " << setw(44) << left << name << right << setw(10)
+         << fixed << setprecision(3) << ((end - start) / packets)
+         << " us/packet" << endl;
+}
+
+/// @brief Runs the benchmark for the DHCPv4 packet.
+///
+/// @param name Name of the packet.
+/// @param data Packet in the on-wire format.
+/// @param packets Number of packets parsed per measurement.
+void
+run4(const char* name, const OptionBuffer& data, const size_t packets) {
+    cout << name << " (" << data.size() << " bytes):" << endl;
+
+    double start = now();
+    for (size_t i = 0; i < packets; ++i) {
+        Pkt4 pkt(&data[0], data.size());
+        pkt.unpack();
+    }
+    report("unpack at once", packets, start, now());
+
+    start = now();
+    for (size_t i = 0; i < packets; ++i) {
+        Pkt4 pkt(&data[0], data.size());
+        pkt.setLazyUnpack(true);
+        pkt.unpack();
+    }
+    report("unpack lazily, drop", packets, start, now());
+
+    start = now();
+    for (size_t i = 0; i < packets; ++i) {
+        Pkt4 pkt(&data[0], data.size());
+        pkt.setLazyUnpack(true);
+        pkt.unpack();
+        pkt.getOption(DHO_DHCP_CLIENT_IDENTIFIER);
+        pkt.getOption(DHO_DHCP_PARAMETER_REQUEST_LIST);
+    }
+    report("unpack lazily, read type, client-id, PRL", packets, start, now());
+
+    start = now();
+    for (size_t i = 0; i < packets; ++i) {
+        Pkt4 pkt(&data[0], data.size());
+        pkt.setLazyUnpack(true);
+        pkt.unpack();
+        pkt.getOption(DHO_DHCP_CLIENT_IDENTIFIER);
+        pkt.getOption(DHO_DHCP_PARAMETER_REQUEST_LIST);
+        pkt.getOption(DHO_DHCP_AGENT_OPTIONS);
+    }
+    report("unpack lazily, also read RAI", packets, start, now());
+
+    start = now();
+    for (size_t i = 0; i < packets; ++i) {
+        Pkt4 pkt(&data[0], data.size());
+        pkt.setLazyUnpack(true);
+        pkt.unpack();
+        // The length is computed from all options, so they are created.
+        pkt.len();
+    }
+    report("unpack lazily, read all options", packets, start, now());
+}
+
+/// @brief Runs the benchmark for the DHCPv6 packet.
+///
+/// @param name Name of the packet.
+/// @param data Packet in the on-wire format.
+/// @param packets Number of packets parsed per measurement.
+void
+run6(const char* name, const OptionBuffer& data, const size_t packets) {
+    cout << name << " (" << data.size() << " bytes):" << endl;
+
+    const double start = now();
+    for (size_t i = 0; i < packets; ++i) {
+        Pkt6 pkt(&data[0], data.size());
+        pkt.unpack();
+    }
+    report("unpack at once", packets, start, now());
+}
+
+} // end of anonymous namespace
+
+int
+main(int argc, char* argv[]) {
+    size_t packets = 100000;
+    for (int i = 1; i < argc; ++i) {
+        if ((std::string(argv[i]) == "-n") && (i + 1 < argc)) {
+            packets = strtoul(argv[++i], NULL, 10);
+        } else {
+            cerr << "usage: pkt_unpack_bench [-n packets]" << endl;
+            return (1);
+        }
+    }
+
+    if (packets == 0) {
+        cerr << "number of packets must be greater than 0" << endl;
+        return (1);
+    }
+
+    const OptionBuffer discover = createDocsisDiscover();
+    const OptionBuffer request = createRelayedRequest();
+    const OptionBuffer solicit = createRelayedSolicit();
+
+    // Make sure that the packets are well formed, so as the errors are
+    // not measured.
+    try {
+        Pkt4 discover4(&discover[0], discover.size());
+        discover4.unpack();
+        Pkt4 request4(&request[0], request.size());
+        request4.unpack();
+        Pkt6 pkt6(&solicit[0], solicit.size());
+        if (!pkt6.unpack() || (pkt6.relay_info_.size() != 3)) {
+            isc_throw(isc::Unexpected, "failed to parse relayed SOLICIT");
+        }
+    } catch (const std::exception& ex) {
+        cerr << "invalid test packet: " << ex.what() << endl;
+        return (1);
+    }
+
+    run4("DOCSIS DHCPDISCOVER", discover, packets);
+    run4("relayed DHCPREQUEST", request, packets);
+    run6("DOCSIS SOLICIT relayed three times", solicit, packets);
+
+    return (0);
+}
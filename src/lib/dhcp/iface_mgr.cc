@@ -34,9 +34,14 @@
 #include <sstream>
 
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/select.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 using namespace std;
 using namespace isc::asiolink;
@@ -45,6 +50,209 @@ using namespace isc::util::io::internal;
 namespace isc {
 namespace dhcp {
 
+#ifdef HAVE_SYS_EPOLL_H
+
+/// @brief Registrations of the sockets of a single family with epoll.
+///
+/// The sockets of the interfaces and the external sockets are registered
+/// with the epoll instance when the first wait takes place and remain
+/// registered until @c IfaceMgr::socketsChanged is called or the
+/// generation of the sockets of the interfaces changes. The changed
+/// sockets are registered with the new epoll instance.
+class IfaceMgr::SocketPoll : public boost::noncopyable {
+public:
+
+    /// @brief Socket of the interface registered for the notification.
+    struct Registration {
+        /// @brief Constructor.
+        ///
+        /// @param iface interface of the socket
+        /// @param socket socket information
+        Registration(const Iface* iface, const SocketInfo& socket)
+            : iface_(iface), socket_(socket) {
+        }
+
+        /// @brief Interface of the socket.
+        const Iface* iface_;
+
+        /// @brief Copy of the socket information.
+        SocketInfo socket_;
+    };
+
+    /// @brief Constructor.
+    ///
+    /// @param family family of the sockets (AF_INET or AF_INET6)
+    SocketPoll(const uint16_t family)
+        : family_(family), epoll_fd_(-1), changed_(true), generation_(0) {
+    }
+
+    /// @brief Destructor.
+    ///
+    /// Closes the epoll instance.
+    ~SocketPoll() {
+        closePoll();
+    }
+
+    /// @brief Indicates that the registrations must be updated.
+    void setChanged() {
+        changed_ = true;
+    }
+
+    /// @brief Registers the sockets if they have changed.
+    ///
+    /// @param ifaces interfaces holding the sockets
+    /// @param callbacks external sockets
+    ///
+    /// @throw SocketReadError if the socket can't be registered.
+    void update(const IfaceCollection& ifaces,
+                const SocketCallbackInfoContainer& callbacks);
+
+    /// @brief Checks that the registered sockets are still open.
+    ///
+    /// The socket closed with the close() function is silently removed
+    /// from the epoll instance, so this is checked explicitly.
+    ///
+    /// @throw SocketReadError if one of the sockets has been closed.
+    void checkSockets() const;
+
+    /// @brief Family of the sockets.
+    uint16_t family_;
+
+    /// @brief Descriptor of the epoll instance.
+    int epoll_fd_;
+
+    /// @brief Indicates if the registrations must be updated.
+    bool changed_;
+
+    /// @brief Generation of the registered sockets of the interfaces.
+    ///
+    /// @see Iface::getSocketsGeneration
+    uint64_t generation_;
+
+    /// @brief Registered sockets of the interfaces.
+    ///
+    /// The index of the socket in this vector is held in the data of the
+    /// epoll event.
+    std::vector<Registration> sockets_;
+
+    /// @brief Registered external sockets.
+    ///
+    /// The index of the external socket is held in the data of the epoll
+    /// event after the indexes of the interface sockets.
+    std::vector<SocketCallbackInfo> callbacks_;
+
+private:
+
+    /// @brief Registers a single descriptor with the epoll instance.
+    ///
+    /// @param fd descriptor
+    /// @param index index of the registration
+    void add(const int fd, const size_t index);
+
+    /// @brief Closes the epoll instance and removes the registrations.
+    void closePoll();
+};
+
+void
+IfaceMgr::SocketPoll::update(const IfaceCollection& ifaces,
+                             const SocketCallbackInfoContainer& callbacks) {
+    if (!changed_ && (generation_ == Iface::getSocketsGeneration())) {
+        return;
+    }
+
+    // The new epoll instance is created rather than modifying the existing
+    // one, because the sockets are changed rarely.
+    closePoll();
+    epoll_fd_ = epoll_create(1);
+    if (epoll_fd_ < 0) {
+        isc_throw(SocketReadError, "failed to create epoll instance: "
+                  << strerror(errno));
+    }
+    (void)fcntl(epoll_fd_, F_SETFD, FD_CLOEXEC);
+
+    for (IfaceCollection::const_iterator iface = ifaces.begin();
+         iface != ifaces.end(); ++iface) {
+        const Iface::SocketCollection& socket_collection = iface->getSockets();
+        for (Iface::SocketCollection::const_iterator s =
+                 socket_collection.begin();
+             s != socket_collection.end(); ++s) {
+            // Only deal with the addresses of the specified family.
+            if (s->addr_.getFamily() == family_) {
+                sockets_.push_back(Registration(&(*iface), *s));
+            }
+        }
+    }
+    callbacks_.assign(callbacks.begin(), callbacks.end());
+
+    for (size_t i = 0; i < sockets_.size(); ++i) {
+        add(sockets_[i].socket_.sockfd_, i);
+    }
+    for (size_t i = 0; i < callbacks_.size(); ++i) {
+        add(callbacks_[i].socket_, sockets_.size() + i);
+    }
+    changed_ = false;
+    generation_ = Iface::getSocketsGeneration();
+}
+
+void
+IfaceMgr::SocketPoll::add(const int fd, const size_t index) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = index;
+    // The same descriptor may be used by more than one registration. The
+    // first one takes precedence, like when the descriptors are tested by
+    // select().
+    if ((epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) &&
+        (errno != EEXIST)) {
+        const int error = errno;
+        closePoll();
+        isc_throw(SocketReadError, "failed to wait for the data on socket "
+                  << fd << ": " << strerror(error));
+    }
+}
+
+void
+IfaceMgr::SocketPoll::checkSockets() const {
+    for (std::vector<Registration>::const_iterator s = sockets_.begin();
+         s != sockets_.end(); ++s) {
+        if ((fcntl(s->socket_.sockfd_, F_GETFD) < 0) && (errno == EBADF)) {
+            isc_throw(SocketReadError, "socket " << s->socket_.sockfd_
+                      << " has been closed");
+        }
+    }
+}
+
+void
+IfaceMgr::SocketPoll::closePoll() {
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+    sockets_.clear();
+    callbacks_.clear();
+}
+
+#else
+
+/// @brief Empty placeholder used on the systems without epoll.
+///
+/// The sockets are collected by each call to select().
+class IfaceMgr::SocketPoll : public boost::noncopyable {
+public:
+    /// @brief Constructor.
+    SocketPoll(const uint16_t) {
+    }
+
+    /// @brief Does nothing.
+    void setChanged() {
+    }
+};
+
+#endif
+
+uint64_t Iface::sockets_generation_ = 0;
+
 IfaceMgr&
 IfaceMgr::instance() {
     static IfaceMgr iface_mgr;
@@ -103,6 +311,7 @@ Iface::closeSockets(const uint16_t family) {
                 close(sock->fallbackfd_);
             }
             sockets_.erase(sock++);
+            ++sockets_generation_;
 
         } else {
             // Different type of socket. Let's move
@@ -167,6 +376,7 @@ bool Iface::delSocket(const uint16_t sockfd) {
                 close(sock->fallbackfd_);
             }
             sockets_.erase(sock);
+            ++sockets_generation_;
             return (true); //socket found
         }
         ++sock;
@@ -196,7 +406,9 @@ IfaceMgr::IfaceMgr()
     :control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
      control_buf_(new char[control_buf_len_]),
      packet_filter_(new PktFilterInet()),
-     packet_filter6_(new PktFilterInet6())
+     packet_filter6_(new PktFilterInet6()),
+     poll4_(new SocketPoll(AF_INET)),
+     poll6_(new SocketPoll(AF_INET6))
 {
 
     try {
@@ -269,6 +481,12 @@ IfaceMgr::closeSockets(const uint16_t family) {
     }
 }
 
+void
+IfaceMgr::socketsChanged() {
+    poll4_->setChanged();
+    poll6_->setChanged();
+}
+
 IfaceMgr::~IfaceMgr() {
     // control_buf_ is deleted automatically (scoped_ptr)
     control_buf_len_ = 0;
@@ -290,6 +508,7 @@ IfaceMgr::addExternalSocket(int socketfd, SocketCallback callback) {
         // Update the callback and we're done
         if (s->socket_ == socketfd) {
             s->callback_ = callback;
+            socketsChanged();
             return;
         }
     }
@@ -299,6 +518,7 @@ IfaceMgr::addExternalSocket(int socketfd, SocketCallback callback) {
     x.socket_ = socketfd;
     x.callback_ = callback;
     callbacks_.push_back(x);
+    socketsChanged();
 }
 
 void
@@ -307,6 +527,7 @@ IfaceMgr::deleteExternalSocket(int socketfd) {
          s != callbacks_.end(); ++s) {
         if (s->socket_ == socketfd) {
             callbacks_.erase(s);
+            socketsChanged();
             return;
         }
     }
@@ -696,6 +917,7 @@ IfaceMgr::getIface(const std::string& ifname) {
 void
 IfaceMgr::clearIfaces() {
     ifaces_.clear();
+    socketsChanged();
 }
 
 void
@@ -906,71 +1128,170 @@ IfaceMgr::send(const Pkt4Ptr& pkt) {
     return (packet_filter_->send(*iface, getSocket(*pkt).sockfd_, pkt));
 }
 
+void
+IfaceMgr::queueSend(const Pkt6Ptr& pkt) {
+    send_queue6_.push_back(pkt);
+}
+
+void
+IfaceMgr::queueSend(const Pkt4Ptr& pkt) {
+    send_queue4_.push_back(pkt);
+}
 
-boost::shared_ptr<Pkt4>
-IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
-    // Sanity check for microsecond timeout.
-    if (timeout_usec >= 1000000) {
-        isc_throw(BadValue, "fractional timeout must be shorter than"
-                  " one million microseconds");
+void
+IfaceMgr::flushSendQueue() {
+    std::string error;
+    flushSendQueue4(error);
+    flushSendQueue6(error);
+    if (!error.empty()) {
+        isc_throw(SocketWriteError, error);
     }
-    const SocketInfo* candidate = 0;
-    IfaceCollection::const_iterator iface;
-    fd_set sockets;
-    int maxfd = 0;
+}
 
-    FD_ZERO(&sockets);
+void
+IfaceMgr::flushSendQueue4(std::string& error) {
+    Pkt4Collection queue;
+    queue.swap(send_queue4_);
+
+    // Collect the consecutive packets to be sent over the same socket.
+    Pkt4Collection batch;
+    const Iface* batch_iface = NULL;
+    int batch_sockfd = -1;
+    for (Pkt4Collection::const_iterator pkt = queue.begin();
+         pkt != queue.end(); ++pkt) {
+        const Iface* iface = NULL;
+        int sockfd = -1;
+        try {
+            iface = getIface((*pkt)->getIface());
+            if (!iface) {
+                isc_throw(BadValue, "Unable to send DHCPv4 message. Invalid"
+                          " interface (" << (*pkt)->getIface()
+                          << ") specified.");
+            }
+            sockfd = getSocket(**pkt).sockfd_;
+        } catch (const std::exception& ex) {
+            error = ex.what();
+            continue;
+        }
 
-    /// @todo: marginal performance optimization. We could create the set once
-    /// and then use its copy for select(). Please note that select() modifies
-    /// provided set to indicated which sockets have something to read.
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+        if (!batch.empty() &&
+            ((iface != batch_iface) || (sockfd != batch_sockfd))) {
+            sendBatch(*batch_iface, batch_sockfd, batch, error);
+        }
+        batch_iface = iface;
+        batch_sockfd = sockfd;
+        batch.push_back(*pkt);
+    }
 
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
-        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
-             s != socket_collection.end(); ++s) {
+    if (!batch.empty()) {
+        sendBatch(*batch_iface, batch_sockfd, batch, error);
+    }
+}
 
-            // Only deal with IPv4 addresses.
-            if (s->addr_.isV4()) {
+void
+IfaceMgr::sendBatch(const Iface& iface, const int sockfd, Pkt4Collection& batch,
+                    std::string& error) {
+    ++send_stats_.batches_;
+    send_stats_.packets_ += batch.size();
+    try {
+        // Assuming that packet filter is not NULL, because its modifier
+        // checks it.
+        packet_filter_->sendBatch(iface, sockfd, batch);
+    } catch (const std::exception& ex) {
+        error = ex.what();
+    }
+    batch.clear();
+}
 
-                // Add this socket to listening set
-                FD_SET(s->sockfd_, &sockets);
-                if (maxfd < s->sockfd_) {
-                    maxfd = s->sockfd_;
-                }
+void
+IfaceMgr::flushSendQueue6(std::string& error) {
+    Pkt6Collection queue;
+    queue.swap(send_queue6_);
+
+    // Collect the consecutive messages to be sent over the same socket.
+    Pkt6Collection batch;
+    const Iface* batch_iface = NULL;
+    int batch_sockfd = -1;
+    for (Pkt6Collection::const_iterator pkt = queue.begin();
+         pkt != queue.end(); ++pkt) {
+        const Iface* iface = NULL;
+        int sockfd = -1;
+        try {
+            iface = getIface((*pkt)->getIface());
+            if (!iface) {
+                isc_throw(BadValue, "Unable to send DHCPv6 message. Invalid"
+                          " interface (" << (*pkt)->getIface()
+                          << ") specified.");
             }
+            sockfd = getSocket(**pkt);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+            continue;
         }
-    }
 
-    // if there are any callbacks for external sockets registered...
-    if (!callbacks_.empty()) {
-        for (SocketCallbackInfoContainer::const_iterator s = callbacks_.begin();
-             s != callbacks_.end(); ++s) {
-            FD_SET(s->socket_, &sockets);
-            if (maxfd < s->socket_) {
-                maxfd = s->socket_;
-            }
+        if (!batch.empty() &&
+            ((iface != batch_iface) || (sockfd != batch_sockfd))) {
+            sendBatch(*batch_iface, batch_sockfd, batch, error);
         }
+        batch_iface = iface;
+        batch_sockfd = sockfd;
+        batch.push_back(*pkt);
     }
 
-    struct timeval select_timeout;
-    select_timeout.tv_sec = timeout_sec;
-    select_timeout.tv_usec = timeout_usec;
+    if (!batch.empty()) {
+        sendBatch(*batch_iface, batch_sockfd, batch, error);
+    }
+}
 
-    int result = select(maxfd + 1, &sockets, NULL, NULL, &select_timeout);
+void
+IfaceMgr::sendBatch(const Iface& iface, const int sockfd, Pkt6Collection& batch,
+                    std::string& error) {
+    ++send_stats_.batches_;
+    send_stats_.packets_ += batch.size();
+    try {
+        // Assuming that packet filter is not NULL, because its modifier
+        // checks it.
+        packet_filter6_->sendBatch(iface, sockfd, batch);
+    } catch (const std::exception& ex) {
+        error = ex.what();
+    }
+    batch.clear();
+}
+
+const SocketInfo*
+IfaceMgr::selectSocket(const uint16_t family, uint32_t timeout_sec,
+                       uint32_t timeout_usec, const Iface*& iface) {
+    // Sanity check for microsecond timeout.
+    if (timeout_usec >= 1000000) {
+        isc_throw(BadValue, "fractional timeout must be shorter than"
+                  " one million microseconds");
+    }
 
+#ifdef HAVE_SYS_EPOLL_H
+    SocketPoll& poll = (family == AF_INET ? *poll4_ : *poll6_);
+    poll.update(ifaces_, callbacks_);
+
+    // The timeout is rounded up to milliseconds so as the function doesn't
+    // return before the timeout elapses.
+    const uint64_t timeout_ms = static_cast<uint64_t>(timeout_sec) * 1000 +
+        (timeout_usec + 999) / 1000;
+    const int timeout = timeout_ms > INT_MAX ? INT_MAX :
+        static_cast<int>(timeout_ms);
+
+    // A few events are retrieved at once, so as the external sockets may
+    // take precedence over the interface sockets, like with select().
+    // The remaining events are reported again by the next call.
+    struct epoll_event events[8];
+    const int result = epoll_wait(poll.epoll_fd_, events,
+                                  sizeof(events) / sizeof(events[0]),
+                                  timeout);
     if (result == 0) {
-        // nothing received and timeout has been reached
-        return (Pkt4Ptr()); // NULL
+        // The sockets closed by the caller are not reported by epoll_wait(),
+        // so check them before indicating the timeout.
+        poll.checkSockets();
+        return (NULL);
 
     } else if (result < 0) {
-        // In most cases we would like to know whether select() returned
-        // an error because of a signal being received  or for some other
-        // reasaon. This is because DHCP servers use signals to trigger
-        // certain actions, like reconfiguration or graceful shutdown.
-        // By catching a dedicated exception the caller will know if the
-        // error returned by the function is due to the reception of the
-        // signal or for some other reason.
         if (errno == EINTR) {
             isc_throw(SignalInterruptOnSelect, strerror(errno));
         } else {
@@ -978,57 +1299,33 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
         }
     }
 
-    // Let's find out which socket has the data
-    for (SocketCallbackInfoContainer::iterator s = callbacks_.begin();
-         s != callbacks_.end(); ++s) {
-        if (!FD_ISSET(s->socket_, &sockets)) {
-            continue;
-        }
-
-        // something received over external socket
-
-        // Calling the external socket's callback provides its service
-        // layer access without integrating any specific features
-        // in IfaceMgr
-        if (s->callback_) {
-            s->callback_();
-        }
-
-        return (Pkt4Ptr());
-    }
-
-    // Let's find out which interface/socket has the data
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
-        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
-             s != socket_collection.end(); ++s) {
-            if (FD_ISSET(s->sockfd_, &sockets)) {
-                candidate = &(*s);
-                break;
+    const SocketPoll::Registration* candidate = NULL;
+    for (int i = 0; i < result; ++i) {
+        const size_t index = events[i].data.u64;
+        if (index >= poll.sockets_.size()) {
+            // something received over external socket
+
+            // Calling the external socket's callback provides its service
+            // layer access without integrating any specific features
+            // in IfaceMgr
+            const SocketCallbackInfo& s =
+                poll.callbacks_[index - poll.sockets_.size()];
+            if (s.callback_) {
+                s.callback_();
             }
-        }
-        if (candidate) {
-            break;
-        }
-    }
+            return (NULL);
 
-    if (!candidate) {
-        isc_throw(SocketReadError, "received data over unknown socket");
+        } else if (!candidate) {
+            candidate = &poll.sockets_[index];
+        }
     }
 
-    // Now we have a socket, let's get some data from it!
-    // Assuming that packet filter is not NULL, because its modifier checks it.
-    return (packet_filter_->receive(*iface, *candidate));
-}
-
-Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */ ) {
-    // Sanity check for microsecond timeout.
-    if (timeout_usec >= 1000000) {
-        isc_throw(BadValue, "fractional timeout must be shorter than"
-                  " one million microseconds");
-    }
+    iface = candidate->iface_;
+    return (&candidate->socket_);
 
+#else
     const SocketInfo* candidate = 0;
+    IfaceCollection::const_iterator i;
     fd_set sockets;
     int maxfd = 0;
 
@@ -1037,14 +1334,14 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
     /// @todo: marginal performance optimization. We could create the set once
     /// and then use its copy for select(). Please note that select() modifies
     /// provided set to indicated which sockets have something to read.
-    IfaceCollection::const_iterator iface;
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
+    for (i = ifaces_.begin(); i != ifaces_.end(); ++i) {
+
+        const Iface::SocketCollection& socket_collection = i->getSockets();
         for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
              s != socket_collection.end(); ++s) {
 
-            // Only deal with IPv6 addresses.
-            if (s->addr_.isV6()) {
+            // Only deal with the addresses of the specified family.
+            if (s->addr_.getFamily() == family) {
 
                 // Add this socket to listening set
                 FD_SET(s->sockfd_, &sockets);
@@ -1059,8 +1356,6 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
     if (!callbacks_.empty()) {
         for (SocketCallbackInfoContainer::const_iterator s = callbacks_.begin();
              s != callbacks_.end(); ++s) {
-
-            // Add it to the set as well
             FD_SET(s->socket_, &sockets);
             if (maxfd < s->socket_) {
                 maxfd = s->socket_;
@@ -1076,7 +1371,7 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
 
     if (result == 0) {
         // nothing received and timeout has been reached
-        return (Pkt6Ptr()); // NULL
+        return (NULL);
 
     } else if (result < 0) {
         // In most cases we would like to know whether select() returned
@@ -1109,12 +1404,12 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
             s->callback_();
         }
 
-        return (Pkt6Ptr());
+        return (NULL);
     }
 
     // Let's find out which interface/socket has the data
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
+    for (i = ifaces_.begin(); i != ifaces_.end(); ++i) {
+        const Iface::SocketCollection& socket_collection = i->getSockets();
         for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
              s != socket_collection.end(); ++s) {
             if (FD_ISSET(s->sockfd_, &sockets)) {
@@ -1130,10 +1425,60 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
     if (!candidate) {
         isc_throw(SocketReadError, "received data over unknown socket");
     }
+
+    iface = &(*i);
+    return (candidate);
+#endif
+}
+
+boost::shared_ptr<Pkt4>
+IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
+    const Iface* iface = NULL;
+    const SocketInfo* candidate = selectSocket(AF_INET, timeout_sec,
+                                               timeout_usec, iface);
+    if (!candidate) {
+        return (Pkt4Ptr()); // NULL
+    }
+
+    // Now we have a socket, let's get some data from it!
+    // Assuming that packet filter is not NULL, because its modifier checks it.
+    return (packet_filter_->receive(*iface, *candidate));
+}
+
+void
+IfaceMgr::receive4Batch(Pkt4Collection& pkts, const size_t max_count,
+                        uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
+    const Iface* iface = NULL;
+    const SocketInfo* candidate = selectSocket(AF_INET, timeout_sec,
+                                               timeout_usec, iface);
+    if (candidate) {
+        packet_filter_->receiveBatch(*iface, *candidate, max_count, pkts);
+    }
+}
+
+Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */ ) {
+    const Iface* iface = NULL;
+    const SocketInfo* candidate = selectSocket(AF_INET6, timeout_sec,
+                                               timeout_usec, iface);
+    if (!candidate) {
+        return (Pkt6Ptr()); // NULL
+    }
+
     // Assuming that packet filter is not NULL, because its modifier checks it.
     return (packet_filter6_->receive(*candidate));
 }
 
+void
+IfaceMgr::receive6Batch(Pkt6Collection& pkts, const size_t max_count,
+                        uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
+    const Iface* iface = NULL;
+    const SocketInfo* candidate = selectSocket(AF_INET6, timeout_sec,
+                                               timeout_usec, iface);
+    if (candidate) {
+        packet_filter6_->receiveBatch(*candidate, max_count, pkts);
+    }
+}
+
 uint16_t IfaceMgr::getSocket(const isc::dhcp::Pkt6& pkt) {
     Iface* iface = getIface(pkt.getIface());
     if (iface == NULL) {
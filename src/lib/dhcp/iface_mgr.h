@@ -26,6 +26,7 @@
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <list>
@@ -311,6 +312,7 @@ public:
     /// @param sock SocketInfo structure that describes socket.
     void addSocket(const SocketInfo& sock) {
         sockets_.push_back(sock);
+        ++sockets_generation_;
     }
 
     /// @brief Closes socket.
@@ -337,6 +339,18 @@ public:
     /// @return collection of sockets added to interface
     const SocketCollection& getSockets() const { return sockets_; }
 
+    /// @brief Returns the generation of the sockets of all interfaces.
+    ///
+    /// The generation is incremented whenever a socket is added to or
+    /// removed from any interface. The @c IfaceMgr compares it with the
+    /// generation of the sockets it waits on, to detect the sockets added
+    /// or closed by the caller directly through the @c Iface object.
+    ///
+    /// @return generation of the sockets
+    static uint64_t getSocketsGeneration() {
+        return (sockets_generation_);
+    }
+
     /// @brief Removes any unicast addresses
     ///
     /// Removes any unicast addresses that the server was configured to
@@ -449,6 +463,9 @@ private:
 
     /// @brief Allocated size of the read buffer.
     size_t read_buffer_size_;
+
+    /// @brief Generation of the sockets of all interfaces.
+    static uint64_t sockets_generation_;
 };
 
 /// @brief This type describes the callback function invoked when error occurs
@@ -490,6 +507,31 @@ public:
     /// we don't support packets larger than 1500.
     static const uint32_t RCVBUFSIZE = 1500;
 
+    /// @brief Default maximum number of packets received by the
+    /// @c receive4Batch and @c receive6Batch functions.
+    static const size_t RECEIVE_BATCH_SIZE = 32;
+
+    /// @brief Statistics of the packets sent from the send queue.
+    struct SendStatistics {
+        /// @brief Constructor.
+        SendStatistics()
+            : batches_(0), packets_(0) {
+        }
+
+        /// @brief Returns the average number of packets in a batch.
+        double getAverageBatchSize() const {
+            return (batches_ > 0 ? static_cast<double>(packets_) / batches_
+                    : 0.0);
+        }
+
+        /// @brief Number of batches, i.e. groups of the packets sent over
+        /// the same socket together.
+        uint64_t batches_;
+
+        /// @brief Number of packets sent in batches.
+        uint64_t packets_;
+    };
+
     // TODO performance improvement: we may change this into
     //      2 maps (ifindex-indexed and name-indexed) and
     //      also hide it (make it public make tests easier for now)
@@ -615,6 +657,47 @@ public:
     /// @return true if sending was successful
     bool send(const Pkt4Ptr& pkt);
 
+    /// @brief Appends the DHCPv6 message to the send queue.
+    ///
+    /// The message is sent by the next call to @c flushSendQueue. The
+    /// queue is not protected against the concurrent access, so the
+    /// callers must serialize the calls to the functions using it.
+    ///
+    /// @param pkt packet to be sent
+    void queueSend(const Pkt6Ptr& pkt);
+
+    /// @brief Appends the IPv4 packet to the send queue.
+    ///
+    /// The packet is sent by the next call to @c flushSendQueue. The
+    /// queue is not protected against the concurrent access, so the
+    /// callers must serialize the calls to the functions using it.
+    ///
+    /// @param pkt packet to be sent
+    void queueSend(const Pkt4Ptr& pkt);
+
+    /// @brief Returns the number of packets in the send queue.
+    size_t getSendQueueSize() const {
+        return (send_queue4_.size() + send_queue6_.size());
+    }
+
+    /// @brief Sends the queued packets.
+    ///
+    /// The consecutive packets to be sent over the same socket are passed
+    /// to the packet filter together, which sends them with a single
+    /// system call where supported. The queue is empty when this function
+    /// returns, even if some of the packets couldn't be sent.
+    ///
+    /// @throw isc::dhcp::SocketWriteError if any of the packets couldn't be
+    /// sent, including the packets specifying an invalid interface. The
+    /// exception is thrown after the remaining packets have been sent.
+    void flushSendQueue();
+
+    /// @brief Returns the statistics of the packets sent from the send
+    /// queue.
+    const SendStatistics& getSendStatistics() const {
+        return (send_stats_);
+    }
+
     /// @brief Tries to receive DHCPv6 message over open IPv6 sockets.
     ///
     /// Attempts to receive a single DHCPv6 message over any of the open IPv6
@@ -659,6 +742,61 @@ public:
     /// @return Pkt4 object representing received packet (or NULL)
     Pkt4Ptr receive4(uint32_t timeout_sec, uint32_t timeout_usec = 0);
 
+    /// @brief Tries to receive multiple DHCPv6 messages over open IPv6
+    /// sockets.
+    ///
+    /// Waits for the data on the open IPv6 sockets the same way as the
+    /// @c receive6 function. When the data arrives, all messages queued on
+    /// the socket, up to the specified number, are received, possibly with
+    /// a single system call. This allows for processing the bursts of
+    /// messages without waiting on the sockets before each message.
+    ///
+    /// This method also checks if data arrived over registered external socket,
+    /// in which case no message is appended to the collection.
+    ///
+    /// @param [out] pkts collection to which the received messages are
+    /// appended
+    /// @param max_count maximum number of messages to be received
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if error occured when receiving a
+    /// packet. The messages received successfully are appended to the
+    /// collection before the exception is thrown.
+    /// @throw isc::dhcp::SignalInterruptOnSelect when a call to select() is
+    /// interrupted by a signal.
+    void receive6Batch(Pkt6Collection& pkts, const size_t max_count,
+                       uint32_t timeout_sec, uint32_t timeout_usec = 0);
+
+    /// @brief Tries to receive multiple IPv4 packets over open IPv4 sockets.
+    ///
+    /// Waits for the data on the open IPv4 sockets the same way as the
+    /// @c receive4 function. When the data arrives, all packets queued on
+    /// the socket, up to the specified number, are received, possibly with
+    /// a single system call. This allows for processing the bursts of
+    /// packets without waiting on the sockets before each packet.
+    ///
+    /// This method also checks if data arrived over registered external socket,
+    /// in which case no packet is appended to the collection.
+    ///
+    /// @param [out] pkts collection to which the received packets are
+    /// appended
+    /// @param max_count maximum number of packets to be received
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if error occured when receiving a
+    /// packet. The packets received successfully are appended to the
+    /// collection before the exception is thrown.
+    /// @throw isc::dhcp::SignalInterruptOnSelect when a call to select() is
+    /// interrupted by a signal.
+    void receive4Batch(Pkt4Collection& pkts, const size_t max_count,
+                       uint32_t timeout_sec, uint32_t timeout_usec = 0);
+
     /// Opens UDP/IP socket and binds it to address, interface and port.
     ///
     /// Specific type of socket (UDP/IPv4 or UDP/IPv6) depends on passed addr
@@ -960,6 +1098,7 @@ public:
     /// from unit tests.
     void addInterface(const Iface& iface) {
         ifaces_.push_back(iface);
+        socketsChanged();
     }
 
     /// @brief Checks if there is at least one socket of the specified family
@@ -1043,6 +1182,17 @@ protected:
     /// List of available interfaces
     IfaceCollection ifaces_;
 
+    /// @brief Indicates that the sockets waited on for the data have changed.
+    ///
+    /// On the systems supporting epoll, the sockets are registered for the
+    /// readiness notification once and the registrations are reused by the
+    /// subsequent calls to @c receive4 and @c receive6. This function must be
+    /// called whenever the interfaces are added or removed or the external
+    /// sockets are changed, so as the registrations are updated before the
+    /// next wait. The sockets of the interfaces are tracked with
+    /// @c Iface::getSocketsGeneration.
+    void socketsChanged();
+
     // TODO: Also keep this interface on Iface once interface detection
     // is implemented. We may need it e.g. to close all sockets on
     // specific interface
@@ -1077,6 +1227,64 @@ protected:
     bool os_receive4(struct msghdr& m, Pkt4Ptr& pkt);
 
 private:
+    /// @brief Waits for the data on the open sockets.
+    ///
+    /// Waits until the data arrives on one of the open sockets of the
+    /// specified family or on one of the registered external sockets.
+    /// The callback of the external socket is invoked when the data
+    /// arrives on it.
+    ///
+    /// @param family address family of the sockets (AF_INET or AF_INET6)
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    /// @param [out] iface interface of the socket having the data
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if select() or epoll_wait() fails
+    /// or one of the sockets has been closed.
+    /// @throw isc::dhcp::SignalInterruptOnSelect when a call to select() or
+    /// epoll_wait() is interrupted by a signal.
+    ///
+    /// @return socket having the data or NULL if the timeout has been reached
+    /// or the data arrived on the external socket.
+    const SocketInfo* selectSocket(const uint16_t family,
+                                   uint32_t timeout_sec,
+                                   uint32_t timeout_usec,
+                                   const Iface*& iface);
+
+    /// @brief Sends the queued IPv4 packets.
+    ///
+    /// @param [out] error description of the last error, left unchanged
+    /// if all packets have been sent
+    void flushSendQueue4(std::string& error);
+
+    /// @brief Sends the queued DHCPv6 messages.
+    ///
+    /// @param [out] error description of the last error, left unchanged
+    /// if all messages have been sent
+    void flushSendQueue6(std::string& error);
+
+    /// @brief Sends the IPv4 packets over the same socket.
+    ///
+    /// @param iface interface to be used to send packets
+    /// @param sockfd socket descriptor
+    /// @param [in,out] batch packets to be sent, cleared by this function
+    /// @param [out] error description of the error, left unchanged if all
+    /// packets have been sent
+    void sendBatch(const Iface& iface, const int sockfd, Pkt4Collection& batch,
+                   std::string& error);
+
+    /// @brief Sends the DHCPv6 messages over the same socket.
+    ///
+    /// @param iface interface to be used to send messages
+    /// @param sockfd socket descriptor
+    /// @param [in,out] batch messages to be sent, cleared by this function
+    /// @param [out] error description of the error, left unchanged if all
+    /// messages have been sent
+    void sendBatch(const Iface& iface, const int sockfd, Pkt6Collection& batch,
+                   std::string& error);
+
     /// @brief Identifies local network address to be used to
     /// connect to remote address.
     ///
@@ -1136,6 +1344,28 @@ private:
 
     /// @brief Contains list of callbacks for external sockets
     SocketCallbackInfoContainer callbacks_;
+
+    /// @brief IPv4 packets waiting to be sent.
+    Pkt4Collection send_queue4_;
+
+    /// @brief DHCPv6 messages waiting to be sent.
+    Pkt6Collection send_queue6_;
+
+    /// @brief Statistics of the packets sent from the send queue.
+    SendStatistics send_stats_;
+
+    /// @brief Readiness notification registrations of the sockets of
+    /// a single family.
+    ///
+    /// The class is defined in the implementation file because it uses
+    /// the OS specific interfaces.
+    class SocketPoll;
+
+    /// @brief Registrations of the IPv4 sockets.
+    boost::scoped_ptr<SocketPoll> poll4_;
+
+    /// @brief Registrations of the IPv6 sockets.
+    boost::scoped_ptr<SocketPoll> poll6_;
 };
 
 }; // namespace isc::dhcp
@@ -60,6 +60,14 @@ const char* isc::dhcp::DOCSIS3_CLASS_MODEM = "docsis3.0";
 /// DOCSIS3.0 cable modem that has router built-in
 const char* isc::dhcp::DOCSIS3_CLASS_EROUTER = "eRouter1.0";
 
+namespace {
+
+/// Empty container of option definitions, used to parse options of the
+/// option spaces which have no definitions.
+const OptionDefContainer empty_option_defs;
+
+}
+
 // Let's keep it in .cc file. Moving it to .h would require including optionDefParams
 // definitions there
 void initOptionSpace(OptionDefContainer& defs,
@@ -215,14 +223,13 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
     size_t offset = 0;
     size_t length = buf.size();
 
-    // Get the list of standard option definitions.
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp6") {
-        option_defs = LibDHCP::getOptionDefs(Option::V6);
-    }
-    // @todo Once we implement other option spaces we should add else clause
-    // here and gather option definitions for them. For now leaving option_defs
-    // empty will imply creation of generic Option.
+    // Get the list of standard option definitions. The container is not
+    // copied because this function is called for every received packet.
+    // @todo Once we implement other option spaces we should gather option
+    // definitions for them here. For now using the empty container will
+    // imply creation of generic Option.
+    const OptionDefContainer& option_defs = (option_space == "dhcp6" ?
+        LibDHCP::getOptionDefs(Option::V6) : empty_option_defs);
 
     // Get the search index #1. It allows to search for option definitions
     // using option code.
@@ -315,14 +322,13 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                                isc::dhcp::OptionCollection& options) {
     size_t offset = 0;
 
-    // Get the list of stdandard option definitions.
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp4") {
-        option_defs = LibDHCP::getOptionDefs(Option::V4);
-    }
-    // @todo Once we implement other option spaces we should add else clause
-    // here and gather option definitions for them. For now leaving option_defs
-    // empty will imply creation of generic Option.
+    // Get the list of standard option definitions. The container is not
+    // copied because this function is called for every received packet.
+    // @todo Once we implement other option spaces we should gather option
+    // definitions for them here. For now using the empty container will
+    // imply creation of generic Option.
+    const OptionDefContainer& option_defs = (option_space == "dhcp4" ?
+        LibDHCP::getOptionDefs(Option::V4) : empty_option_defs);
 
     // Get the search index #1. It allows to search for option definitions
     // using option code.
@@ -393,6 +399,44 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
     return (offset);
 }
 
+size_t LibDHCP::indexOptions4(const OptionBuffer& buf, size_t offset,
+                              isc::dhcp::OptionIndex& index) {
+    // The options are walked exactly as in unpackOptions4, so as the same
+    // packets are rejected whether the options are created now or later.
+    while (offset + 1 <= buf.size()) {
+        const size_t opt_offset = offset;
+        uint8_t opt_type = buf[offset++];
+
+        // DHO_END is a special, one octet long option
+        if (opt_type == DHO_END)
+            return (offset); // just return. Don't need to add DHO_END option
+
+        // DHO_PAD is just a padding after DHO_END. Let's continue parsing
+        // in case we receive a message without DHO_END.
+        if (opt_type == DHO_PAD)
+            continue;
+
+        if (offset + 1 >= buf.size()) {
+            // opt_type must be cast to integer so as it is not treated as
+            // unsigned char value (a number is presented in error message).
+            isc_throw(OutOfRange, "Attempt to parse truncated option "
+                      << static_cast<int>(opt_type));
+        }
+
+        uint8_t opt_len =  buf[offset++];
+        if (offset + opt_len > buf.size()) {
+            isc_throw(OutOfRange, "Option parse failed. Tried to parse "
+                      << offset + opt_len << " bytes from " << buf.size()
+                      << "-byte long buffer.");
+        }
+
+        index.insert(std::make_pair(opt_type,
+                                    OptionLocation(opt_offset, opt_len + 2)));
+        offset += opt_len;
+    }
+    return (offset);
+}
+
 size_t LibDHCP::unpackVendorOptions6(const uint32_t vendor_id,
                                      const OptionBuffer& buf,
                                      isc::dhcp::OptionCollection& options) {
@@ -587,6 +631,39 @@ LibDHCP::packOptions(isc::util::OutputBuffer& buf,
     }
 }
 
+void
+LibDHCP::packOptions(isc::util::OutputBuffer& buf,
+                     const OptionCollection& options,
+                     const PackedOptionCollection& packed) {
+    for (OptionCollection::const_iterator it = options.begin();
+         it != options.end(); ++it) {
+        // There are only a few packed options in a packet, so the linear
+        // search is fast enough.
+        PackedOptionCollection::const_iterator p = packed.begin();
+        while ((p != packed.end()) && (p->option != it->second)) {
+            ++p;
+        }
+        if ((p != packed.end()) && p->wire && !p->wire->empty()) {
+            buf.writeData(&(*p->wire)[0], p->wire->size());
+        } else {
+            it->second->pack(buf);
+        }
+    }
+}
+
+void
+LibDHCP::discardPackedOptions(PackedOptionCollection& packed,
+                              const uint16_t type) {
+    PackedOptionCollection::iterator p = packed.begin();
+    while (p != packed.end()) {
+        if (p->option->getType() == type) {
+            p = packed.erase(p);
+        } else {
+            ++p;
+        }
+    }
+}
+
 void LibDHCP::OptionFactoryRegister(Option::Universe u,
                                     uint16_t opt_type,
                                     Option::Factory* factory) {
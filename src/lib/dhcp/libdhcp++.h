@@ -113,6 +113,30 @@ public:
     static void packOptions(isc::util::OutputBuffer& buf,
                             const isc::dhcp::OptionCollection& options);
 
+    /// @brief Stores options in a buffer, using their known on-wire format.
+    ///
+    /// This function works like the other @c packOptions, but the options
+    /// which are found in the collection of packed options (the same
+    /// instance of the option) are not packed: their on-wire format is
+    /// copied to the buffer instead.
+    ///
+    /// @param buf output buffer (assembled options will be stored here)
+    /// @param options collection of options to store to
+    /// @param packed options for which the on-wire format is known
+    static void packOptions(isc::util::OutputBuffer& buf,
+                            const isc::dhcp::OptionCollection& options,
+                            const isc::dhcp::PackedOptionCollection& packed);
+
+    /// @brief Discards the on-wire format of the options of specified type.
+    ///
+    /// This is used when the options may be modified, so their on-wire
+    /// format may no longer be valid.
+    ///
+    /// @param packed options for which the on-wire format is known
+    /// @param type type of the options which must be packed
+    static void discardPackedOptions(isc::dhcp::PackedOptionCollection& packed,
+                                     const uint16_t type);
+
     /// @brief Parses provided buffer as DHCPv4 options and creates Option objects.
     ///
     /// Parses provided buffer and stores created Option objects
@@ -127,6 +151,23 @@ public:
                                  const std::string& option_space,
                                  isc::dhcp::OptionCollection& options);
 
+    /// @brief Finds DHCPv4 options in the provided buffer.
+    ///
+    /// Walks the options in the buffer as @c unpackOptions4 does and
+    /// checks that none of them is truncated, but rather than creating
+    /// the Option objects, stores the location of each option in the
+    /// index. The options may be created from their locations later,
+    /// when they are needed.
+    ///
+    /// @param buf Buffer to be parsed.
+    /// @param offset Offset of the first option in the buffer.
+    /// @param index Reference to option index. Locations of the options,
+    ///        relative to the beginning of the buffer, will be put here.
+    /// @throw isc::OutOfRange if an option is truncated.
+    /// @return offset to the first byte after last parsed option
+    static size_t indexOptions4(const OptionBuffer& buf, size_t offset,
+                                isc::dhcp::OptionIndex& index);
+
     /// @brief Parses provided buffer as DHCPv6 options and creates Option objects.
     ///
     /// Parses provided buffer and stores created Option objects in options
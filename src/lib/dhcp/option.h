@@ -16,6 +16,7 @@
 #define OPTION_H
 
 #include <util/buffer.h>
+#include <util/flat_multimap.h>
 
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
@@ -45,8 +46,42 @@ typedef boost::shared_ptr<OptionBuffer> OptionBufferPtr;
 class Option;
 typedef boost::shared_ptr<Option> OptionPtr;
 
-/// A collection of DHCP (v4 or v6) options
-typedef std::multimap<unsigned int, OptionPtr> OptionCollection;
+/// @brief A collection of DHCP (v4 or v6) options
+///
+/// The options are held in a vector sorted by option code rather than in
+/// a tree, as a packet typically carries a few dozens of options at most.
+/// The options having the same code are held in the order in which they
+/// have been added.
+typedef isc::util::FlatMultimap<unsigned int, OptionPtr> OptionCollection;
+
+/// pointer to a constant DHCP buffer
+typedef boost::shared_ptr<const OptionBuffer> ConstOptionBufferPtr;
+
+/// @brief Option along with its on-wire format.
+///
+/// The on-wire format of an option which doesn't change (e.g. an option
+/// configured for a subnet) may be computed once and then copied into the
+/// outgoing packets, rather than rebuilt each time the option is sent.
+struct PackedOption {
+    /// Option instance.
+    OptionPtr option;
+    /// Option in the on-wire format, including the option code and length
+    /// (or NULL if the option must be packed when it is sent).
+    ConstOptionBufferPtr wire;
+};
+
+/// A collection of options along with their on-wire format.
+typedef std::vector<PackedOption> PackedOptionCollection;
+
+/// @brief Location of an option in a buffer.
+///
+/// The first value is the offset of the option code in the buffer, the
+/// second value is the length of the option including its code and
+/// length fields.
+typedef std::pair<size_t, size_t> OptionLocation;
+
+/// A collection of option locations in a buffer, indexed by option code.
+typedef isc::util::FlatMultimap<unsigned int, OptionLocation> OptionIndex;
 
 /// @brief This type describes a callback function to parse options from buffer.
 ///
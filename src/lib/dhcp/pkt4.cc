@@ -32,6 +32,36 @@ namespace dhcp {
 
 const IOAddress DEFAULT_ADDRESS("0.0.0.0");
 
+namespace {
+
+/// @brief Copies the options found in the received data to a buffer.
+///
+/// @param data Received data.
+/// @param first Location of the first option to be copied.
+/// @param last Location past the last option to be copied.
+///
+/// @throw isc::OutOfRange if an option lies outside the received data.
+/// @return Buffer holding the options in the on-wire format.
+OptionBuffer
+copyOptions(const OptionBuffer& data, OptionIndex::const_iterator first,
+            OptionIndex::const_iterator last) {
+    OptionBuffer buf;
+    for (; first != last; ++first) {
+        const OptionLocation& loc = first->second;
+        // The received data may have been truncated by a callout since
+        // the options were found.
+        if (loc.first + loc.second > data.size()) {
+            isc_throw(OutOfRange, "option " << first->first << " lies outside"
+                      " of the " << data.size() << "-byte long received data");
+        }
+        buf.insert(buf.end(), data.begin() + loc.first,
+                   data.begin() + loc.first + loc.second);
+    }
+    return (buf);
+}
+
+}
+
 Pkt4::Pkt4(uint8_t msg_type, uint32_t transid)
      :buffer_out_(DHCPV4_PKT_HDR_LEN),
       local_addr_(DEFAULT_ADDRESS),
@@ -49,7 +79,8 @@ Pkt4::Pkt4(uint8_t msg_type, uint32_t transid)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      lazy_unpack_(false)
 {
     memset(sname_, 0, MAX_SNAME_LEN);
     memset(file_, 0, MAX_FILE_LEN);
@@ -74,7 +105,8 @@ Pkt4::Pkt4(const uint8_t* data, size_t len)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      lazy_unpack_(false)
 {
     if (len < DHCPV4_PKT_HDR_LEN) {
         isc_throw(OutOfRange, "Truncated DHCPv4 packet (len=" << len
@@ -93,6 +125,8 @@ size_t
 Pkt4::len() {
     size_t length = DHCPV4_PKT_HDR_LEN; // DHCPv4 header
 
+    unpackIndexedOptions();
+
     // ... and sum of lengths of all options
     for (OptionCollection::const_iterator it = options_.begin();
          it != options_.end();
@@ -113,6 +147,14 @@ Pkt4::pack() {
     // will not result in concatenation of multiple packet copies.
     buffer_out_.clear();
 
+    // Options which have not been accessed yet must be created to be
+    // packed. Errors in these options are reported as packing errors.
+    try {
+        unpackIndexedOptions();
+    } catch (const Exception& e) {
+        isc_throw(InvalidOperation, e.what());
+    }
+
     try {
         size_t hw_len = hwaddr_->hwaddr_.size();
 
@@ -152,7 +194,7 @@ Pkt4::pack() {
         // write DHCP magic cookie
         buffer_out_.writeUint32(DHCP_OPTIONS_COOKIE);
 
-        LibDHCP::packOptions(buffer_out_, options_);
+        LibDHCP::packOptions(buffer_out_, options_, packed_options_);
 
         // add END option that indicates end of options
         // (End option is very simple, just a 255 octet)
@@ -213,25 +255,86 @@ Pkt4::unpack() {
       isc_throw(Unexpected, "Invalid or missing DHCP magic cookie");
     }
 
-    size_t opts_len = buffer_in.getLength() - buffer_in.getPosition();
-    vector<uint8_t> opts_buffer;
+    // Options found by the previous unpack are no longer valid.
+    option_index_.clear();
+
+    if (lazy_unpack_) {
+        // Only find the options and check that they are not truncated.
+        // The options are created from data_ when they are accessed.
+        LibDHCP::indexOptions4(data_, buffer_in.getPosition(), option_index_);
 
-    // Use readVector because a function which parses option requires
-    // a vector as an input.
-    buffer_in.readVector(opts_buffer, opts_len);
+    } else {
+        size_t opts_len = buffer_in.getLength() - buffer_in.getPosition();
+        vector<uint8_t> opts_buffer;
+
+        // Use readVector because a function which parses option requires
+        // a vector as an input.
+        buffer_in.readVector(opts_buffer, opts_len);
+        unpackOptions(opts_buffer, options_);
+    }
+
+    // @todo check will need to be called separately, so hooks can be called
+    // after the packet is parsed, but before its content is verified
+    check();
+}
+
+void
+Pkt4::unpackOptions(const OptionBuffer& buf,
+                    OptionCollection& options) const {
     if (callback_.empty()) {
-        LibDHCP::unpackOptions4(opts_buffer, "dhcp4", options_);
+        LibDHCP::unpackOptions4(buf, "dhcp4", options);
     } else {
         // The last two arguments are set to NULL because they are
         // specific to DHCPv6 options parsing. They are unused for
         // DHCPv4 case. In DHCPv6 case they hold are the relay message
         // offset and length.
-        callback_(opts_buffer, "dhcp4", options_, NULL, NULL);
+        callback_(buf, "dhcp4", options, NULL, NULL);
     }
+}
 
-    // @todo check will need to be called separately, so hooks can be called
-    // after the packet is parsed, but before its content is verified
-    check();
+void
+Pkt4::unpackIndexedOptions(const uint8_t type) const {
+    if (option_index_.empty()) {
+        return;
+    }
+
+    std::pair<OptionIndex::iterator, OptionIndex::iterator> range =
+        option_index_.equal_range(type);
+    if (range.first == range.second) {
+        return;
+    }
+
+    // Options of the same type are unpacked together, in the order in
+    // which they were received.
+    const OptionBuffer buf = copyOptions(data_, range.first, range.second);
+
+    // The options are added to the packet and removed from the index
+    // only if all of them have been created, so as a malformed option
+    // is reported each time it is accessed.
+    OptionCollection options;
+    unpackOptions(buf, options);
+    for (OptionCollection::const_iterator opt = options.begin();
+         opt != options.end(); ++opt) {
+        options_.insert(*opt);
+    }
+    option_index_.erase(range.first, range.second);
+}
+
+void
+Pkt4::unpackIndexedOptions() const {
+    if (option_index_.empty()) {
+        return;
+    }
+
+    const OptionBuffer buf = copyOptions(data_, option_index_.begin(),
+                                         option_index_.end());
+    OptionCollection options;
+    unpackOptions(buf, options);
+    for (OptionCollection::const_iterator opt = options.begin();
+         opt != options.end(); ++opt) {
+        options_.insert(*opt);
+    }
+    option_index_.clear();
 }
 
 void Pkt4::check() {
@@ -284,6 +387,8 @@ Pkt4::toText() {
         << ":" << remote_port_ << ", msgtype=" << static_cast<int>(getType())
         << ", transid=0x" << hex << transid_ << dec << endl;
 
+    unpackIndexedOptions();
+
     for (isc::dhcp::OptionCollection::iterator opt=options_.begin();
          opt != options_.end();
          ++opt) {
@@ -435,24 +540,42 @@ Pkt4::getHlen() const {
 void
 Pkt4::addOption(boost::shared_ptr<Option> opt) {
     // Check for uniqueness (DHCPv4 options must be unique)
-    if (getOption(opt->getType())) {
+    if (hasOption(opt->getType())) {
         isc_throw(BadValue, "Option " << opt->getType()
                   << " already present in this message.");
     }
     options_.insert(pair<int, boost::shared_ptr<Option> >(opt->getType(), opt));
 }
 
+void
+Pkt4::addPackedOption(const PackedOption& packed) {
+    addOption(packed.option);
+    if (packed.wire) {
+        packed_options_.push_back(packed);
+    }
+}
+
 boost::shared_ptr<isc::dhcp::Option>
 Pkt4::getOption(uint8_t type) const {
+    unpackIndexedOptions(type);
     OptionCollection::const_iterator x = options_.find(type);
     if (x != options_.end()) {
+        // The caller may modify the option, so it must be packed.
+        LibDHCP::discardPackedOptions(packed_options_, type);
         return (*x).second;
     }
     return boost::shared_ptr<isc::dhcp::Option>(); // NULL
 }
 
+bool
+Pkt4::hasOption(uint8_t type) const {
+    unpackIndexedOptions(type);
+    return (options_.find(type) != options_.end());
+}
+
 bool
 Pkt4::delOption(uint8_t type) {
+    unpackIndexedOptions(type);
     isc::dhcp::OptionCollection::iterator x = options_.find(type);
     if (x != options_.end()) {
         options_.erase(x);
@@ -85,7 +85,10 @@ public:
     /// Parses received packet, stored in on-wire format in bufferIn_.
     ///
     /// Will create a collection of option objects that will
-    /// be stored in options_ container.
+    /// be stored in options_ container. If the lazy unpacking is enabled
+    /// (see @ref setLazyUnpack), only the locations of the options in the
+    /// packet are found and the option objects are created when they are
+    /// first accessed.
     ///
     /// Method with throw exception if packet parsing fails.
     void unpack();
@@ -326,13 +329,53 @@ public:
     void
     addOption(boost::shared_ptr<Option> opt);
 
+    /// @brief Adds an option along with its on-wire format.
+    ///
+    /// The option is added as with @c addOption, but it is not packed when
+    /// the packet is packed: its on-wire format is copied to the output
+    /// buffer instead. When the option is returned by @c getOption (and
+    /// may be modified), the on-wire format is discarded and the option
+    /// is packed as any other option.
+    ///
+    /// @param packed option to be added and its on-wire format.
+    void
+    addPackedOption(const PackedOption& packed);
+
+    /// @brief Discards the on-wire format of all options.
+    ///
+    /// The options added with @c addPackedOption are packed as any other
+    /// option afterwards. This is called before the options of the packet
+    /// are exposed for modification (e.g. to the hooks libraries).
+    void
+    clearPackedOptions() {
+        packed_options_.clear();
+    }
+
     /// @brief Returns an option of specified type.
     ///
+    /// If the packet was unpacked lazily and the option has not been
+    /// accessed yet, the option is created from the received data.
+    /// As the returned option may be modified, its on-wire format added
+    /// with @c addPackedOption is discarded.
+    ///
+    /// @throw isc::Exception if the received option is malformed.
     /// @return returns option of requested type (or NULL)
     ///         if no such option is present
     boost::shared_ptr<Option>
     getOption(uint8_t opt_type) const;
 
+    /// @brief Checks if the packet holds an option of specified type.
+    ///
+    /// Unlike @c getOption, this doesn't discard the on-wire format of
+    /// the option.
+    ///
+    /// @param opt_type option type.
+    ///
+    /// @throw isc::Exception if the received option is malformed.
+    /// @return true if the option is present, false otherwise.
+    bool
+    hasOption(uint8_t opt_type) const;
+
     /// @brief Deletes specified option
     /// @param type option type to be deleted
     /// @return true if anything was deleted, false otherwise
@@ -512,6 +555,39 @@ public:
         callback_ = callback;
     }
 
+    /// @brief Enables or disables the lazy unpacking of options.
+    ///
+    /// When enabled, @ref unpack checks that the options in the packet
+    /// are not truncated, but creates each option (using the callback,
+    /// if set) only when it is first accessed. Packets which are dropped
+    /// early, or from which only a few options are read, are parsed at
+    /// a fraction of the cost. A malformed option is then reported when
+    /// it is accessed rather than by @ref unpack.
+    ///
+    /// Options which are never accessed through the @ref getOption,
+    /// @ref addOption and @ref delOption are not held in the options_
+    /// member, so the derived classes accessing this member directly
+    /// must not enable the lazy unpacking. Also, the options are created
+    /// from the data_ member, so modifying it after @ref unpack modifies
+    /// the options which have not been accessed yet.
+    ///
+    /// @param lazy_unpack true if options are to be unpacked on first
+    /// access.
+    void setLazyUnpack(const bool lazy_unpack) {
+        lazy_unpack_ = lazy_unpack;
+    }
+
+    /// @brief Unpacks all options which have not been accessed yet.
+    ///
+    /// This is called by the methods walking all options of the packet.
+    /// It may also be called to find the malformed options at a chosen
+    /// point, rather than when they are accessed. It does nothing if the
+    /// packet was not unpacked lazily.
+    ///
+    /// @throw isc::Exception or derived exception if an option is
+    /// malformed. The options are then left as they were.
+    void unpackIndexedOptions() const;
+
     /// @brief Update packet timestamp.
     ///
     /// Updates packet timestamp. This method is invoked
@@ -600,6 +676,22 @@ private:
                          const std::vector<uint8_t>& mac_addr,
                          HWAddrPtr& hw_addr);
 
+    /// @brief Unpacks the options of the specified type which have not
+    /// been accessed yet.
+    ///
+    /// @param type Option type.
+    void unpackIndexedOptions(const uint8_t type) const;
+
+    /// @brief Creates options from the received data.
+    ///
+    /// The options are created with the callback, if set, or with the
+    /// @c LibDHCP::unpackOptions4.
+    ///
+    /// @param buf Buffer holding options in the on-wire format.
+    /// @param [out] options Collection to which the options are added.
+    void unpackOptions(const OptionBuffer& buf,
+                       OptionCollection& options) const;
+
 protected:
 
     /// converts DHCP message type to BOOTP op type
@@ -693,7 +785,10 @@ protected:
     /// behavior must be taken into consideration before making
     /// changes to this member such as access scope restriction or
     /// data format change etc.
-    isc::dhcp::OptionCollection options_;
+    ///
+    /// The member is mutable because the options are added to it when
+    /// they are first accessed if the packet was unpacked lazily.
+    mutable isc::dhcp::OptionCollection options_;
 
     /// packet timestamp
     boost::posix_time::ptime timestamp_;
@@ -701,10 +796,26 @@ protected:
     /// A callback to be called to unpack options from the packet.
     UnpackOptionsCallback callback_;
 
+    /// Options added with their on-wire format.
+    ///
+    /// The member is mutable because the on-wire format of an option is
+    /// discarded when the option is returned by @ref getOption.
+    mutable isc::dhcp::PackedOptionCollection packed_options_;
+
+    /// Indicates whether the options are unpacked on first access.
+    bool lazy_unpack_;
+
+    /// Locations of the received options (relative to the beginning of
+    /// data_) which have not been accessed yet.
+    mutable isc::dhcp::OptionIndex option_index_;
+
 }; // Pkt4 class
 
 typedef boost::shared_ptr<Pkt4> Pkt4Ptr;
 
+/// @brief A collection of DHCPv4 packets.
+typedef std::vector<Pkt4Ptr> Pkt4Collection;
+
 } // isc::dhcp namespace
 
 } // isc namespace
@@ -253,7 +253,7 @@ Pkt6::packUDP() {
         buffer_out_.writeUint8( (transid_) & 0xff );
 
         // the rest are options
-        LibDHCP::packOptions(buffer_out_, options_);
+        LibDHCP::packOptions(buffer_out_, options_, packed_options_);
     }
     catch (const Exception& e) {
        // An exception is thrown and message will be written to Logger
@@ -470,6 +470,8 @@ OptionPtr
 Pkt6::getOption(uint16_t opt_type) {
     isc::dhcp::OptionCollection::const_iterator x = options_.find(opt_type);
     if (x!=options_.end()) {
+        // The caller may modify the option, so it must be packed.
+        LibDHCP::discardPackedOptions(packed_options_, opt_type);
         return (*x).second;
     }
     return OptionPtr(); // NULL
@@ -485,6 +487,9 @@ Pkt6::getOptions(uint16_t opt_type) {
             found.insert(make_pair(opt_type, x->second));
         }
     }
+    if (!found.empty()) {
+        LibDHCP::discardPackedOptions(packed_options_, opt_type);
+    }
     return (found);
 }
 
@@ -493,6 +498,14 @@ Pkt6::addOption(const OptionPtr& opt) {
     options_.insert(pair<int, boost::shared_ptr<Option> >(opt->getType(), opt));
 }
 
+void
+Pkt6::addPackedOption(const PackedOption& packed) {
+    addOption(packed.option);
+    if (packed.wire) {
+        packed_options_.push_back(packed);
+    }
+}
+
 bool
 Pkt6::delOption(uint16_t type) {
     isc::dhcp::OptionCollection::iterator x = options_.find(type);
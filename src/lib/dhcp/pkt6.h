@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <set>
+#include <vector>
 
 #include <time.h>
 
@@ -35,6 +36,9 @@ namespace dhcp {
 class Pkt6;
 typedef boost::shared_ptr<Pkt6> Pkt6Ptr;
 
+/// @brief A collection of DHCPv6 packets.
+typedef std::vector<Pkt6Ptr> Pkt6Collection;
+
 class Pkt6 {
 public:
     /// specifies non-relayed DHCPv6 packet header length (over UDP)
@@ -198,11 +202,34 @@ public:
     /// @param opt option to be added.
     void addOption(const OptionPtr& opt);
 
+    /// @brief Adds an option along with its on-wire format.
+    ///
+    /// The option is added as with @c addOption, but it is not packed when
+    /// the packet is packed: its on-wire format is copied to the output
+    /// buffer instead. When the option is returned by @c getOption or
+    /// @c getOptions (and may be modified), the on-wire format is discarded
+    /// and the option is packed as any other option. The options modified
+    /// through the @c options_ member directly must be preceded by the
+    /// call to @c clearPackedOptions.
+    ///
+    /// @param packed option to be added and its on-wire format.
+    void addPackedOption(const PackedOption& packed);
+
+    /// @brief Discards the on-wire format of all options.
+    ///
+    /// The options added with @c addPackedOption are packed as any other
+    /// option afterwards. This is called before the options of the packet
+    /// are exposed for modification (e.g. to the hooks libraries).
+    void clearPackedOptions() {
+        packed_options_.clear();
+    }
+
     /// @brief Returns the first option of specified type.
     ///
     /// Returns the first option of specified type. Note that in DHCPv6 several
     /// instances of the same option are allowed (and frequently used).
-    /// Also see \ref getOptions().
+    /// Also see \ref getOptions(). As the returned option may be modified,
+    /// the on-wire format of the options of this type is discarded.
     ///
     /// @param type option type we are looking for
     ///
@@ -241,7 +268,8 @@ public:
     /// @brief Returns all instances of specified type.
     ///
     /// Returns all instances of options of the specified type. DHCPv6 protocol
-    /// allows (and uses frequently) multiple instances.
+    /// allows (and uses frequently) multiple instances. As the returned
+    /// options may be modified, their on-wire format is discarded.
     ///
     /// @param type option type we are looking for
     /// @return instance of option collection with requested options
@@ -578,6 +606,9 @@ protected:
     /// A callback to be called to unpack options from the packet.
     UnpackOptionsCallback callback_;
 
+    /// Options added with their on-wire format.
+    isc::dhcp::PackedOptionCollection packed_options_;
+
 }; // Pkt6 class
 
 } // isc::dhcp namespace
@@ -67,6 +67,34 @@ PktFilter::openFallbackSocket(const isc::asiolink::IOAddress& addr,
     return (sock);
 }
 
+void
+PktFilter::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                        const size_t max_count, Pkt4Collection& pkts) {
+    if (max_count > 0) {
+        Pkt4Ptr pkt = receive(iface, socket_info);
+        if (pkt) {
+            pkts.push_back(pkt);
+        }
+    }
+}
+
+void
+PktFilter::sendBatch(const Iface& iface, uint16_t sockfd,
+                     const Pkt4Collection& pkts) {
+    std::string error;
+    for (Pkt4Collection::const_iterator pkt = pkts.begin(); pkt != pkts.end();
+         ++pkt) {
+        try {
+            send(iface, sockfd, *pkt);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    if (!error.empty()) {
+        isc_throw(SocketWriteError, error);
+    }
+}
+
 
 } // end of isc::dhcp namespace
 } // end of isc namespace
@@ -101,6 +101,25 @@ public:
     virtual Pkt4Ptr receive(const Iface& iface,
                             const SocketInfo& socket_info) = 0;
 
+    /// @brief Receive the packets queued on the specified socket.
+    ///
+    /// This function is called when the socket is known to have data to
+    /// read. It receives up to the specified number of packets, without
+    /// blocking once the first packet has been received. The default
+    /// implementation receives a single packet using @c receive. The
+    /// derived classes may override it to receive multiple packets with
+    /// a single system call.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param max_count maximum number of packets to be received
+    /// @param [out] pkts collection to which the received packets are
+    /// appended
+    virtual void receiveBatch(const Iface& iface,
+                              const SocketInfo& socket_info,
+                              const size_t max_count,
+                              Pkt4Collection& pkts);
+
     /// @brief Send packet over specified socket.
     ///
     /// @param iface interface to be used to send packet
@@ -111,6 +130,23 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt4Ptr& pkt) = 0;
 
+    /// @brief Send the packets over specified socket.
+    ///
+    /// The default implementation sends the packets one by one using
+    /// @c send. The derived classes may override it to send multiple
+    /// packets with a single system call. The packet which can't be sent
+    /// doesn't prevent the remaining packets from being sent.
+    ///
+    /// @param iface interface to be used to send packets
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    ///
+    /// @throw isc::dhcp::SocketWriteError if any of the packets couldn't be
+    /// sent. The exception is thrown after the remaining packets have been
+    /// sent.
+    virtual void sendBatch(const Iface& iface, uint16_t sockfd,
+                           const Pkt4Collection& pkts);
+
 protected:
 
     /// @brief Default implementation to open a fallback socket.
@@ -12,6 +12,7 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <dhcp/iface_mgr.h>
 #include <dhcp/pkt_filter6.h>
 
 namespace isc {
@@ -39,6 +40,33 @@ PktFilter6::joinMulticast(int sock, const std::string& ifname,
     return (true);
 }
 
+void
+PktFilter6::receiveBatch(const SocketInfo& socket_info, const size_t max_count,
+                         Pkt6Collection& pkts) {
+    if (max_count > 0) {
+        Pkt6Ptr pkt = receive(socket_info);
+        if (pkt) {
+            pkts.push_back(pkt);
+        }
+    }
+}
+
+void
+PktFilter6::sendBatch(const Iface& iface, uint16_t sockfd,
+                      const Pkt6Collection& pkts) {
+    std::string error;
+    for (Pkt6Collection::const_iterator pkt = pkts.begin(); pkt != pkts.end();
+         ++pkt) {
+        try {
+            send(iface, sockfd, *pkt);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    if (!error.empty()) {
+        isc_throw(SocketWriteError, error);
+    }
+}
 
 } // end of isc::dhcp namespace
 } // end of isc namespace
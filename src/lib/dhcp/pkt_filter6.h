@@ -109,6 +109,23 @@ public:
     /// @return A pointer to received message.
     virtual Pkt6Ptr receive(const SocketInfo& socket_info) = 0;
 
+    /// @brief Receives the DHCPv6 messages queued on the socket.
+    ///
+    /// This function is called when the socket is known to have data to
+    /// read. It receives up to the specified number of messages, without
+    /// blocking once the first message has been received. The default
+    /// implementation receives a single message using @c receive. The
+    /// derived classes may override it to receive multiple messages with
+    /// a single system call.
+    ///
+    /// @param socket_info A structure holding socket information.
+    /// @param max_count Maximum number of messages to be received.
+    /// @param [out] pkts Collection to which the received messages are
+    /// appended.
+    virtual void receiveBatch(const SocketInfo& socket_info,
+                              const size_t max_count,
+                              Pkt6Collection& pkts);
+
     /// @brief Sends DHCPv6 message through a specified interface and socket.
     ///
     /// This function sends a DHCPv6 message through a specified interface and
@@ -123,6 +140,23 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt6Ptr& pkt) = 0;
 
+    /// @brief Sends DHCPv6 messages through a specified interface and socket.
+    ///
+    /// The default implementation sends the messages one by one using
+    /// @c send. The derived classes may override it to send multiple
+    /// messages with a single system call. The message which can't be sent
+    /// doesn't prevent the remaining messages from being sent.
+    ///
+    /// @param iface Interface to be used to send messages.
+    /// @param sockfd A socket descriptor.
+    /// @param pkts Messages to be sent.
+    ///
+    /// @throw isc::dhcp::SocketWriteError if any of the messages couldn't be
+    /// sent. The exception is thrown after the remaining messages have been
+    /// sent.
+    virtual void sendBatch(const Iface& iface, uint16_t sockfd,
+                           const Pkt6Collection& pkts);
+
     /// @brief Joins IPv6 multicast group on a socket.
     ///
     /// This function joins the socket to the specified multicast group.
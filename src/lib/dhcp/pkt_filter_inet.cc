@@ -16,20 +16,59 @@
 #include <dhcp/iface_mgr.h>
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt_filter_inet.h>
+#include <util/io/mmsg_utilities.h>
 #include <errno.h>
 #include <cstring>
+#include <vector>
 
 using namespace isc::asiolink;
 
 namespace isc {
 namespace dhcp {
 
+#ifdef HAVE_RECVMMSG
+/// @brief Buffers used to receive multiple packets with @c recvmmsg.
+struct PktFilterInet::BatchBuffers {
+    /// @brief Constructor.
+    ///
+    /// @param count Number of packets received with a single call.
+    /// @param control_buf_len Length of the control buffer of a packet.
+    BatchBuffers(const size_t count, const size_t control_buf_len)
+        : control_buf_len_(control_buf_len),
+          data_(count * IfaceMgr::RCVBUFSIZE),
+          control_(count * control_buf_len), from_(count), iov_(count),
+          msgs_(count) {
+    }
+
+    /// @brief Length of the control buffer of a packet.
+    size_t control_buf_len_;
+    /// @brief Data buffers of the packets.
+    std::vector<uint8_t> data_;
+    /// @brief Control buffers of the packets.
+    std::vector<char> control_;
+    /// @brief Source addresses of the packets.
+    std::vector<struct sockaddr_in> from_;
+    /// @brief Vectors pointing to the data buffers.
+    std::vector<struct iovec> iov_;
+    /// @brief Message headers passed to @c recvmmsg.
+    std::vector<struct mmsghdr> msgs_;
+};
+#else
+/// @brief Buffers used to receive multiple packets, which are not used
+/// on the systems without @c recvmmsg.
+struct PktFilterInet::BatchBuffers {
+};
+#endif
+
 PktFilterInet::PktFilterInet()
     : control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
       control_buf_(new char[control_buf_len_])
 {
 }
 
+PktFilterInet::~PktFilterInet() {
+}
+
 SocketInfo
 PktFilterInet::openSocket(Iface& iface,
                           const isc::asiolink::IOAddress& addr,
@@ -135,8 +174,83 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
         isc_throw(SocketReadError, "failed to receive UDP4 data");
     }
 
+    return (createPacket(iface, socket_info, m, buf, result));
+}
+
+void
+PktFilterInet::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                            const size_t max_count, Pkt4Collection& pkts) {
+#ifdef HAVE_RECVMMSG
+    if (max_count == 0) {
+        return;
+    }
+    if (!batch_ || (batch_->msgs_.size() < max_count)) {
+        batch_.reset(new BatchBuffers(max_count, control_buf_len_));
+    }
+
+    // The message headers are modified by recvmmsg, so they are
+    // initialized for each call.
+    for (size_t i = 0; i < max_count; ++i) {
+        memset(&batch_->from_[i], 0, sizeof(batch_->from_[i]));
+        batch_->iov_[i].iov_base = &batch_->data_[i * IfaceMgr::RCVBUFSIZE];
+        batch_->iov_[i].iov_len = IfaceMgr::RCVBUFSIZE;
+
+        struct msghdr& m = batch_->msgs_[i].msg_hdr;
+        memset(&batch_->msgs_[i], 0, sizeof(batch_->msgs_[i]));
+        m.msg_name = &batch_->from_[i];
+        m.msg_namelen = sizeof(batch_->from_[i]);
+        m.msg_iov = &batch_->iov_[i];
+        m.msg_iovlen = 1;
+        m.msg_control = &batch_->control_[i * batch_->control_buf_len_];
+        m.msg_controllen = batch_->control_buf_len_;
+    }
+    memset(&batch_->control_[0], 0, batch_->control_.size());
+
+    // The socket has data to read, so the call returns at least one packet
+    // and doesn't wait for more.
+    int result = 0;
+    do {
+        result = recvmmsg(socket_info.sockfd_, &batch_->msgs_[0], max_count,
+                          MSG_DONTWAIT, NULL);
+    } while ((result < 0) && (errno == EINTR));
+    if (result < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            return;
+        }
+        isc_throw(SocketReadError, "failed to receive UDP4 data: "
+                  << strerror(errno));
+    }
+
+    // The malformed packet doesn't prevent the other packets from being
+    // returned. The error is reported when all packets have been appended.
+    std::string error;
+    for (int i = 0; i < result; ++i) {
+        try {
+            pkts.push_back(createPacket(iface, socket_info,
+                                        batch_->msgs_[i].msg_hdr,
+                                        &batch_->data_[i * IfaceMgr::RCVBUFSIZE],
+                                        batch_->msgs_[i].msg_len));
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    if (!error.empty()) {
+        isc_throw(SocketReadError, "failed to create UDP4 packet: " << error);
+    }
+#else
+    PktFilter::receiveBatch(iface, socket_info, max_count, pkts);
+#endif
+}
+
+Pkt4Ptr
+PktFilterInet::createPacket(const Iface& iface, const SocketInfo& socket_info,
+                            struct msghdr& m, const uint8_t* buf,
+                            const size_t length) const {
+    const struct sockaddr_in& from_addr =
+        *static_cast<const struct sockaddr_in*>(m.msg_name);
+
     // We have all data let's create Pkt4 object.
-    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(buf, result));
+    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(buf, length));
 
     pkt->updateTimestamp();
 
@@ -192,16 +306,74 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
 int
 PktFilterInet::send(const Iface&, uint16_t sockfd,
                     const Pkt4Ptr& pkt) {
-    memset(&control_buf_[0], 0, control_buf_len_);
+    struct msghdr m;
+    sockaddr_in to;
+    struct iovec v;
+    // The control buffer is allocated on the stack rather than shared,
+    // because the packets may be sent by several threads at once.
+    union {
+        struct cmsghdr align;
+        char data[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    } control;
+    initSendMessage(pkt, m, to, v, control.data);
+
+    pkt->updateTimestamp();
+
+    int result = sendmsg(sockfd, &m, 0);
+    if (result < 0) {
+        isc_throw(SocketWriteError, "pkt4 send failed: sendmsg() returned "
+                  " with an error: " << strerror(errno));
+    }
+
+    return (result);
+}
+
+void
+PktFilterInet::sendBatch(const Iface& iface, uint16_t sockfd,
+                         const Pkt4Collection& pkts) {
+#ifdef HAVE_SENDMMSG
+    // The interface is only used by the generic implementation.
+    static_cast<void>(iface);
+
+    if (pkts.empty()) {
+        return;
+    }
+
+    const size_t count = pkts.size();
+    std::vector<struct mmsghdr> msgs(count);
+    std::vector<sockaddr_in> to(count);
+    std::vector<struct iovec> iov(count);
+    std::vector<char> control(count * control_buf_len_);
+    for (size_t i = 0; i < count; ++i) {
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        initSendMessage(pkts[i], msgs[i].msg_hdr, to[i], iov[i],
+                        &control[i * control_buf_len_]);
+        pkts[i]->updateTimestamp();
+    }
+
+    const std::string error =
+        util::io::internal::sendMessages(sockfd, &msgs[0], count);
+    if (!error.empty()) {
+        isc_throw(SocketWriteError, "pkt4 send failed: sendmmsg() returned"
+                  " with an error: " << error);
+    }
+#else
+    PktFilter::sendBatch(iface, sockfd, pkts);
+#endif
+}
+
+void
+PktFilterInet::initSendMessage(const Pkt4Ptr& pkt, struct msghdr& m,
+                               sockaddr_in& to, struct iovec& v,
+                               char* control) const {
+    memset(control, 0, control_buf_len_);
 
     // Set the target address we're sending to.
-    sockaddr_in to;
     memset(&to, 0, sizeof(to));
     to.sin_family = AF_INET;
     to.sin_port = htons(pkt->getRemotePort());
     to.sin_addr.s_addr = htonl(pkt->getRemoteAddr());
 
-    struct msghdr m;
     // Initialize our message header structure.
     memset(&m, 0, sizeof(m));
     m.msg_name = &to;
@@ -210,7 +382,6 @@ PktFilterInet::send(const Iface&, uint16_t sockfd,
     // Set the data buffer we're sending. (Using this wacky
     // "scatter-gather" stuff... we only have a single chunk
     // of data to send, so we declare a single vector entry.)
-    struct iovec v;
     memset(&v, 0, sizeof(v));
     // iov_base field is of void * type. We use it for packet
     // transmission, so this buffer will not be modified.
@@ -229,7 +400,7 @@ PktFilterInet::send(const Iface&, uint16_t sockfd,
     // define the IPv4 packet information. We could set the
     // source address if we wanted, but we can safely let the
     // kernel decide what that should be.
-    m.msg_control = &control_buf_[0];
+    m.msg_control = control;
     m.msg_controllen = control_buf_len_;
     struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
     cmsg->cmsg_level = IPPROTO_IP;
@@ -240,16 +411,6 @@ PktFilterInet::send(const Iface&, uint16_t sockfd,
     pktinfo->ipi_ifindex = pkt->getIndex();
     m.msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
 #endif
-
-    pkt->updateTimestamp();
-
-    int result = sendmsg(sockfd, &m, 0);
-    if (result < 0) {
-        isc_throw(SocketWriteError, "pkt4 send failed: sendmsg() returned "
-                  " with an error: " << strerror(errno));
-    }
-
-    return (result);
 }
 
 
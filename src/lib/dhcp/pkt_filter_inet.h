@@ -17,6 +17,11 @@
 
 #include <dhcp/pkt_filter.h>
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+
+struct iovec;
+struct msghdr;
+struct sockaddr_in;
 
 namespace isc {
 namespace dhcp {
@@ -33,6 +38,9 @@ public:
     /// Allocates control buffer.
     PktFilterInet();
 
+    /// @brief Destructor.
+    virtual ~PktFilterInet();
+
     /// @brief Check if packet can be sent to the host without address directly.
     ///
     /// This Packet Filter sends packets through AF_INET datagram sockets, so
@@ -73,6 +81,26 @@ public:
     /// message parsing fails.
     virtual Pkt4Ptr receive(const Iface& iface, const SocketInfo& socket_info);
 
+    /// @brief Receive the packets queued on the specified socket.
+    ///
+    /// On the systems supporting the @c recvmmsg system call, it receives
+    /// up to the specified number of packets with a single call. On other
+    /// systems, it receives a single packet.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param max_count maximum number of packets to be received
+    /// @param [out] pkts collection to which the received packets are
+    /// appended
+    ///
+    /// @throw isc::dhcp::SocketReadError if an error occurs during reception
+    /// of the packets. The packets received successfully are appended to the
+    /// collection before the exception is thrown.
+    virtual void receiveBatch(const Iface& iface,
+                              const SocketInfo& socket_info,
+                              const size_t max_count,
+                              Pkt4Collection& pkts);
+
     /// @brief Send packet over specified socket.
     ///
     /// @param iface interface to be used to send packet
@@ -85,11 +113,60 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt4Ptr& pkt);
 
+    /// @brief Send the packets over specified socket.
+    ///
+    /// On the systems supporting the @c sendmmsg system call, it sends
+    /// all packets with a single call. On other systems, it sends the
+    /// packets one by one.
+    ///
+    /// @param iface interface to be used to send packets
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    ///
+    /// @throw isc::dhcp::SocketWriteError if any of the packets couldn't be
+    /// sent. The exception is thrown after the remaining packets have been
+    /// sent.
+    virtual void sendBatch(const Iface& iface, uint16_t sockfd,
+                           const Pkt4Collection& pkts);
+
 private:
+
+    /// @brief Creates the packet from the received message.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param m message header filled by the system call
+    /// @param buf buffer holding the received data
+    /// @param length length of the received data
+    ///
+    /// @return Received packet
+    Pkt4Ptr createPacket(const Iface& iface, const SocketInfo& socket_info,
+                         struct msghdr& m, const uint8_t* buf,
+                         const size_t length) const;
+
+    /// @brief Initializes the message header used to send the packet.
+    ///
+    /// @param pkt packet to be sent
+    /// @param [out] m message header
+    /// @param [out] to destination address, pointed to by the header
+    /// @param [out] v vector pointing to the packet data
+    /// @param control control buffer of the @c control_buf_len_ length
+    void initSendMessage(const Pkt4Ptr& pkt, struct msghdr& m,
+                         struct sockaddr_in& to, struct iovec& v,
+                         char* control) const;
+
     /// Length of the control_buf_ array.
     size_t control_buf_len_;
-    /// Control buffer, used in transmission and reception.
+    /// Control buffer, used in reception. The messages being sent use
+    /// their own buffers, so as they may be sent concurrently.
     boost::scoped_array<char> control_buf_;
+
+    /// @brief Buffers used to receive multiple packets.
+    struct BatchBuffers;
+
+    /// @brief Buffers used to receive multiple packets, allocated on
+    /// the first use.
+    boost::scoped_ptr<BatchBuffers> batch_;
 };
 
 } // namespace isc::dhcp
@@ -15,20 +15,60 @@
 #include <dhcp/iface_mgr.h>
 #include <dhcp/pkt6.h>
 #include <dhcp/pkt_filter_inet6.h>
+#include <util/io/mmsg_utilities.h>
 #include <util/io/pktinfo_utilities.h>
 
 #include <netinet/in.h>
 
+#include <vector>
+
 using namespace isc::asiolink;
 
 namespace isc {
 namespace dhcp {
 
+#ifdef HAVE_RECVMMSG
+/// @brief Buffers used to receive multiple messages with @c recvmmsg.
+struct PktFilterInet6::BatchBuffers {
+    /// @brief Constructor.
+    ///
+    /// @param count Number of messages received with a single call.
+    /// @param control_buf_len Length of the control buffer of a message.
+    BatchBuffers(const size_t count, const size_t control_buf_len)
+        : control_buf_len_(control_buf_len),
+          data_(count * IfaceMgr::RCVBUFSIZE),
+          control_(count * control_buf_len), from_(count), iov_(count),
+          msgs_(count) {
+    }
+
+    /// @brief Length of the control buffer of a message.
+    size_t control_buf_len_;
+    /// @brief Data buffers of the messages.
+    std::vector<uint8_t> data_;
+    /// @brief Control buffers of the messages.
+    std::vector<char> control_;
+    /// @brief Source addresses of the messages.
+    std::vector<struct sockaddr_in6> from_;
+    /// @brief Vectors pointing to the data buffers.
+    std::vector<struct iovec> iov_;
+    /// @brief Message headers passed to @c recvmmsg.
+    std::vector<struct mmsghdr> msgs_;
+};
+#else
+/// @brief Buffers used to receive multiple messages, which are not used
+/// on the systems without @c recvmmsg.
+struct PktFilterInet6::BatchBuffers {
+};
+#endif
+
 PktFilterInet6::PktFilterInet6()
 : control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
     control_buf_(new char[control_buf_len_]) {
 }
 
+PktFilterInet6::~PktFilterInet6() {
+}
+
 SocketInfo
 PktFilterInet6::openSocket(const Iface& iface,
                            const isc::asiolink::IOAddress& addr,
@@ -161,39 +201,112 @@ PktFilterInet6::receive(const SocketInfo& socket_info) {
     m.msg_controllen = control_buf_len_;
 
     int result = recvmsg(socket_info.sockfd_, &m, 0);
+    if (result < 0) {
+        isc_throw(SocketReadError, "failed to receive data");
+    }
+
+    return (createPacket(socket_info, m, buf, result));
+}
+
+void
+PktFilterInet6::receiveBatch(const SocketInfo& socket_info,
+                             const size_t max_count, Pkt6Collection& pkts) {
+#ifdef HAVE_RECVMMSG
+    if (max_count == 0) {
+        return;
+    }
+    if (!batch_ || (batch_->msgs_.size() < max_count)) {
+        batch_.reset(new BatchBuffers(max_count, control_buf_len_));
+    }
+
+    // The message headers are modified by recvmmsg, so they are
+    // initialized for each call.
+    for (size_t i = 0; i < max_count; ++i) {
+        memset(&batch_->from_[i], 0, sizeof(batch_->from_[i]));
+        batch_->iov_[i].iov_base = &batch_->data_[i * IfaceMgr::RCVBUFSIZE];
+        batch_->iov_[i].iov_len = IfaceMgr::RCVBUFSIZE;
+
+        struct msghdr& m = batch_->msgs_[i].msg_hdr;
+        memset(&batch_->msgs_[i], 0, sizeof(batch_->msgs_[i]));
+        m.msg_name = &batch_->from_[i];
+        m.msg_namelen = sizeof(batch_->from_[i]);
+        m.msg_iov = &batch_->iov_[i];
+        m.msg_iovlen = 1;
+        m.msg_control = &batch_->control_[i * batch_->control_buf_len_];
+        m.msg_controllen = batch_->control_buf_len_;
+    }
+    memset(&batch_->control_[0], 0, batch_->control_.size());
+
+    // The socket has data to read, so the call returns at least one message
+    // and doesn't wait for more.
+    int result = 0;
+    do {
+        result = recvmmsg(socket_info.sockfd_, &batch_->msgs_[0], max_count,
+                          MSG_DONTWAIT, NULL);
+    } while ((result < 0) && (errno == EINTR));
+    if (result < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            return;
+        }
+        isc_throw(SocketReadError, "failed to receive data: "
+                  << strerror(errno));
+    }
+
+    // The malformed message doesn't prevent the other messages from being
+    // returned. The error is reported when all messages have been appended.
+    std::string error;
+    for (int i = 0; i < result; ++i) {
+        try {
+            Pkt6Ptr pkt = createPacket(socket_info, batch_->msgs_[i].msg_hdr,
+                                       &batch_->data_[i * IfaceMgr::RCVBUFSIZE],
+                                       batch_->msgs_[i].msg_len);
+            if (pkt) {
+                pkts.push_back(pkt);
+            }
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    if (!error.empty()) {
+        isc_throw(SocketReadError, error);
+    }
+#else
+    PktFilter6::receiveBatch(socket_info, max_count, pkts);
+#endif
+}
+
+Pkt6Ptr
+PktFilterInet6::createPacket(const SocketInfo& socket_info, struct msghdr& m,
+                             const uint8_t* buf, const size_t length) const {
+    const struct sockaddr_in6& from =
+        *static_cast<const struct sockaddr_in6*>(m.msg_name);
 
     struct in6_addr to_addr;
     memset(&to_addr, 0, sizeof(to_addr));
 
     int ifindex = -1;
-    if (result >= 0) {
-        struct in6_pktinfo* pktinfo = NULL;
-
-
-        // If we did read successfully, then we need to loop
-        // through the control messages we received and
-        // find the one with our destination address.
-        //
-        // We also keep a flag to see if we found it. If we
-        // didn't, then we consider this to be an error.
-        bool found_pktinfo = false;
-        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
-        while (cmsg != NULL) {
-            if ((cmsg->cmsg_level == IPPROTO_IPV6) &&
-                (cmsg->cmsg_type == IPV6_PKTINFO)) {
-                pktinfo = util::io::internal::convertPktInfo6(CMSG_DATA(cmsg));
-                to_addr = pktinfo->ipi6_addr;
-                ifindex = pktinfo->ipi6_ifindex;
-                found_pktinfo = true;
-                break;
-            }
-            cmsg = CMSG_NXTHDR(&m, cmsg);
-        }
-        if (!found_pktinfo) {
-            isc_throw(SocketReadError, "unable to find pktinfo");
+    struct in6_pktinfo* pktinfo = NULL;
+
+    // We need to loop through the control messages we received and
+    // find the one with our destination address.
+    //
+    // We also keep a flag to see if we found it. If we
+    // didn't, then we consider this to be an error.
+    bool found_pktinfo = false;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
+    while (cmsg != NULL) {
+        if ((cmsg->cmsg_level == IPPROTO_IPV6) &&
+            (cmsg->cmsg_type == IPV6_PKTINFO)) {
+            pktinfo = util::io::internal::convertPktInfo6(CMSG_DATA(cmsg));
+            to_addr = pktinfo->ipi6_addr;
+            ifindex = pktinfo->ipi6_ifindex;
+            found_pktinfo = true;
+            break;
         }
-    } else {
-        isc_throw(SocketReadError, "failed to receive data");
+        cmsg = CMSG_NXTHDR(&m, cmsg);
+    }
+    if (!found_pktinfo) {
+        isc_throw(SocketReadError, "unable to find pktinfo");
     }
 
     // Filter out packets sent to global unicast address (not link local and
@@ -210,7 +323,7 @@ PktFilterInet6::receive(const SocketInfo& socket_info) {
     // Let's create a packet.
     Pkt6Ptr pkt;
     try {
-        pkt = Pkt6Ptr(new Pkt6(buf, result));
+        pkt = Pkt6Ptr(new Pkt6(buf, length));
     } catch (const std::exception& ex) {
         isc_throw(SocketReadError, "failed to create new packet");
     }
@@ -238,11 +351,69 @@ PktFilterInet6::receive(const SocketInfo& socket_info) {
 
 int
 PktFilterInet6::send(const Iface&, uint16_t sockfd, const Pkt6Ptr& pkt) {
+    struct msghdr m;
+    sockaddr_in6 to;
+    struct iovec v;
+    // The control buffer is allocated on the stack rather than shared,
+    // because the messages may be sent by several threads at once.
+    union {
+        struct cmsghdr align;
+        char data[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    } control;
+    initSendMessage(pkt, m, to, v, control.data);
 
-    memset(&control_buf_[0], 0, control_buf_len_);
+    pkt->updateTimestamp();
+
+    int result = sendmsg(sockfd, &m, 0);
+    if  (result < 0) {
+        isc_throw(SocketWriteError, "pkt6 send failed: sendmsg() returned"
+                  " with an error: " << strerror(errno));
+    }
+
+    return (result);
+}
+
+void
+PktFilterInet6::sendBatch(const Iface& iface, uint16_t sockfd,
+                          const Pkt6Collection& pkts) {
+#ifdef HAVE_SENDMMSG
+    // The interface is only used by the generic implementation.
+    static_cast<void>(iface);
+
+    if (pkts.empty()) {
+        return;
+    }
+
+    const size_t count = pkts.size();
+    std::vector<struct mmsghdr> msgs(count);
+    std::vector<sockaddr_in6> to(count);
+    std::vector<struct iovec> iov(count);
+    std::vector<char> control(count * control_buf_len_);
+    for (size_t i = 0; i < count; ++i) {
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        initSendMessage(pkts[i], msgs[i].msg_hdr, to[i], iov[i],
+                        &control[i * control_buf_len_]);
+        pkts[i]->updateTimestamp();
+    }
+
+    const std::string error =
+        util::io::internal::sendMessages(sockfd, &msgs[0], count);
+    if (!error.empty()) {
+        isc_throw(SocketWriteError, "pkt6 send failed: sendmmsg() returned"
+                  " with an error: " << error);
+    }
+#else
+    PktFilter6::sendBatch(iface, sockfd, pkts);
+#endif
+}
+
+void
+PktFilterInet6::initSendMessage(const Pkt6Ptr& pkt, struct msghdr& m,
+                                sockaddr_in6& to, struct iovec& v,
+                                char* control) const {
+    memset(control, 0, control_buf_len_);
 
     // Set the target address we're sending to.
-    sockaddr_in6 to;
     memset(&to, 0, sizeof(to));
     to.sin6_family = AF_INET6;
     to.sin6_port = htons(pkt->getRemotePort());
@@ -252,7 +423,6 @@ PktFilterInet6::send(const Iface&, uint16_t sockfd, const Pkt6Ptr& pkt) {
     to.sin6_scope_id = pkt->getIndex();
 
     // Initialize our message header structure.
-    struct msghdr m;
     memset(&m, 0, sizeof(m));
     m.msg_name = &to;
     m.msg_namelen = sizeof(to);
@@ -268,7 +438,6 @@ PktFilterInet6::send(const Iface&, uint16_t sockfd, const Pkt6Ptr& pkt) {
     // (defined as void*) we must use const cast from void *.
     // Otherwise C++ compiler would complain that we are trying
     // to assign const void* to void*.
-    struct iovec v;
     memset(&v, 0, sizeof(v));
     v.iov_base = const_cast<void *>(pkt->getBuffer().getData());
     v.iov_len = pkt->getBuffer().getLength();
@@ -281,7 +450,7 @@ PktFilterInet6::send(const Iface&, uint16_t sockfd, const Pkt6Ptr& pkt) {
     // define the IPv6 packet information. We could set the
     // source address if we wanted, but we can safely let the
     // kernel decide what that should be.
-    m.msg_control = &control_buf_[0];
+    m.msg_control = control;
     m.msg_controllen = control_buf_len_;
     struct cmsghdr *cmsg = CMSG_FIRSTHDR(&m);
 
@@ -307,16 +476,6 @@ PktFilterInet6::send(const Iface&, uint16_t sockfd, const Pkt6Ptr& pkt) {
     // which causes sendmsg to return EINVAL if the CMSG_LEN is
     // used to set the msg_controllen value.
     m.msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
-
-    pkt->updateTimestamp();
-
-    int result = sendmsg(sockfd, &m, 0);
-    if  (result < 0) {
-        isc_throw(SocketWriteError, "pkt6 send failed: sendmsg() returned"
-                  " with an error: " << strerror(errno));
-    }
-
-    return (result);
 }
 
 
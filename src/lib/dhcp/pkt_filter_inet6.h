@@ -17,6 +17,11 @@
 
 #include <dhcp/pkt_filter6.h>
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+
+struct iovec;
+struct msghdr;
+struct sockaddr_in6;
 
 namespace isc {
 namespace dhcp {
@@ -34,6 +39,9 @@ public:
     /// Initializes a control buffer used in the message transmission.
     PktFilterInet6();
 
+    /// @brief Destructor.
+    virtual ~PktFilterInet6();
+
     /// @brief Opens a socket.
     ///
     /// This function opens an IPv6 socket on an interface and binds it to a
@@ -75,6 +83,26 @@ public:
     /// reception.
     virtual Pkt6Ptr receive(const SocketInfo& socket_info);
 
+    /// @brief Receives the DHCPv6 messages queued on the socket.
+    ///
+    /// On the systems supporting the @c recvmmsg system call, this function
+    /// receives up to the specified number of messages with a single call.
+    /// On other systems, it receives a single message. The messages which
+    /// would be dropped by the @c receive function are not appended to the
+    /// collection.
+    ///
+    /// @param socket_info A structure holding socket information.
+    /// @param max_count Maximum number of messages to be received.
+    /// @param [out] pkts Collection to which the received messages are
+    /// appended.
+    ///
+    /// @throw isc::dhcp::SocketReadError if error occurred during packet
+    /// reception. The messages received successfully are appended to the
+    /// collection before the exception is thrown.
+    virtual void receiveBatch(const SocketInfo& socket_info,
+                              const size_t max_count,
+                              Pkt6Collection& pkts);
+
     /// @brief Sends DHCPv6 message through a specified interface and socket.
     ///
     /// Thie function sends a DHCPv6 message through a specified interface and
@@ -91,11 +119,60 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt6Ptr& pkt);
 
+    /// @brief Sends DHCPv6 messages through a specified interface and socket.
+    ///
+    /// On the systems supporting the @c sendmmsg system call, this function
+    /// sends all messages with a single call. On other systems, it sends
+    /// the messages one by one.
+    ///
+    /// @param iface Interface to be used to send messages.
+    /// @param sockfd A socket descriptor.
+    /// @param pkts Messages to be sent.
+    ///
+    /// @throw isc::dhcp::SocketWriteError if any of the messages couldn't be
+    /// sent. The exception is thrown after the remaining messages have been
+    /// sent.
+    virtual void sendBatch(const Iface& iface, uint16_t sockfd,
+                           const Pkt6Collection& pkts);
+
 private:
+
+    /// @brief Creates the packet from the received message.
+    ///
+    /// @param socket_info A structure holding socket information.
+    /// @param m Message header filled by the system call.
+    /// @param buf Buffer holding the received data.
+    /// @param length Length of the received data.
+    ///
+    /// @return A pointer to received message or NULL if the message is
+    /// dropped.
+    /// @throw isc::dhcp::SocketReadError if the packet can't be created.
+    Pkt6Ptr createPacket(const SocketInfo& socket_info, struct msghdr& m,
+                         const uint8_t* buf, const size_t length) const;
+
+    /// @brief Initializes the message header used to send the message.
+    ///
+    /// @param pkt Message to be sent.
+    /// @param [out] m Message header.
+    /// @param [out] to Destination address, pointed to by the header.
+    /// @param [out] v Vector pointing to the message data.
+    /// @param control Control buffer of the @c control_buf_len_ length.
+    void initSendMessage(const Pkt6Ptr& pkt, struct msghdr& m,
+                         struct sockaddr_in6& to, struct iovec& v,
+                         char* control) const;
+
     /// Length of the control_buf_ array.
     size_t control_buf_len_;
-    /// Control buffer, used in transmission and reception.
+    /// Control buffer, used in reception. The messages being sent use
+    /// their own buffers, so as they may be sent concurrently.
     boost::scoped_array<char> control_buf_;
+
+    /// @brief Buffers used to receive multiple messages.
+    struct BatchBuffers;
+
+    /// @brief Buffers used to receive multiple messages, allocated on
+    /// the first use.
+    boost::scoped_ptr<BatchBuffers> batch_;
 };
 
 } // namespace isc::dhcp
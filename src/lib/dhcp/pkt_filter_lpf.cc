@@ -19,6 +19,7 @@
 #include <dhcp/pkt_filter_lpf.h>
 #include <dhcp/protocol_util.h>
 #include <exceptions/exceptions.h>
+#include <util/io/mmsg_utilities.h>
 #include <linux/filter.h>
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
@@ -240,7 +241,73 @@ int
 PktFilterLPF::send(const Iface& iface, uint16_t sockfd, const Pkt4Ptr& pkt) {
 
     OutputBuffer buf(14);
+    createFrame(iface, pkt, buf);
 
+    sockaddr_ll sa;
+    sa.sll_family = AF_PACKET;
+    sa.sll_ifindex = iface.getIndex();
+    sa.sll_protocol = htons(ETH_P_IP);
+    sa.sll_halen = 6;
+
+    int result = sendto(sockfd, buf.getData(), buf.getLength(), 0,
+                        reinterpret_cast<const struct sockaddr*>(&sa),
+                        sizeof(sockaddr_ll));
+    if (result < 0) {
+        isc_throw(SocketWriteError, "failed to send DHCPv4 packet, errno="
+                  << errno << " (check errno.h)");
+    }
+
+    return (0);
+
+}
+
+void
+PktFilterLPF::sendBatch(const Iface& iface, uint16_t sockfd,
+                        const Pkt4Collection& pkts) {
+#ifdef HAVE_SENDMMSG
+    if (pkts.empty()) {
+        return;
+    }
+
+    sockaddr_ll sa;
+    sa.sll_family = AF_PACKET;
+    sa.sll_ifindex = iface.getIndex();
+    sa.sll_protocol = htons(ETH_P_IP);
+    sa.sll_halen = 6;
+
+    // All frames are built before any of them is sent.
+    const size_t count = pkts.size();
+    std::vector<OutputBufferPtr> frames(count);
+    std::vector<struct iovec> iov(count);
+    std::vector<struct mmsghdr> msgs(count);
+    for (size_t i = 0; i < count; ++i) {
+        frames[i].reset(new OutputBuffer(14));
+        createFrame(iface, pkts[i], *frames[i]);
+
+        iov[i].iov_base = const_cast<void*>(frames[i]->getData());
+        iov[i].iov_len = frames[i]->getLength();
+
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_name = &sa;
+        msgs[i].msg_hdr.msg_namelen = sizeof(sa);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const std::string error =
+        util::io::internal::sendMessages(sockfd, &msgs[0], count);
+    if (!error.empty()) {
+        isc_throw(SocketWriteError, "failed to send DHCPv4 packets: "
+                  << error);
+    }
+#else
+    PktFilter::sendBatch(iface, sockfd, pkts);
+#endif
+}
+
+void
+PktFilterLPF::createFrame(const Iface& iface, const Pkt4Ptr& pkt,
+                          OutputBuffer& buf) const {
     // Some interfaces may have no HW address - e.g. loopback interface.
     // For these interfaces the HW address length is 0. If this is the case,
     // then we will rely on the functions which construct the IP/UDP headers
@@ -263,23 +330,6 @@ PktFilterLPF::send(const Iface& iface, uint16_t sockfd, const Pkt4Ptr& pkt) {
 
     // DHCPv4 message
     buf.writeData(pkt->getBuffer().getData(), pkt->getBuffer().getLength());
-
-    sockaddr_ll sa;
-    sa.sll_family = AF_PACKET;
-    sa.sll_ifindex = iface.getIndex();
-    sa.sll_protocol = htons(ETH_P_IP);
-    sa.sll_halen = 6;
-
-    int result = sendto(sockfd, buf.getData(), buf.getLength(), 0,
-                        reinterpret_cast<const struct sockaddr*>(&sa),
-                        sizeof(sockaddr_ll));
-    if (result < 0) {
-        isc_throw(SocketWriteError, "failed to send DHCPv4 packet, errno="
-                  << errno << " (check errno.h)");
-    }
-
-    return (0);
-
 }
 
 
@@ -75,6 +75,32 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt4Ptr& pkt);
 
+    /// @brief Send the packets over specified socket.
+    ///
+    /// The Ethernet frames of all packets are built first. On the systems
+    /// supporting the @c sendmmsg system call, the frames are then sent
+    /// with a single call. On other systems, they are sent one by one.
+    ///
+    /// @param iface interface to be used to send packets
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    ///
+    /// @throw isc::dhcp::SocketWriteError if any of the packets couldn't be
+    /// sent. The exception is thrown after the remaining packets have been
+    /// sent.
+    virtual void sendBatch(const Iface& iface, uint16_t sockfd,
+                           const Pkt4Collection& pkts);
+
+private:
+
+    /// @brief Builds the Ethernet frame holding the packet.
+    ///
+    /// @param iface interface to be used to send the packet
+    /// @param pkt packet to be sent
+    /// @param [out] buf buffer to which the frame is written
+    void createFrame(const Iface& iface, const Pkt4Ptr& pkt,
+                     util::OutputBuffer& buf) const;
+
 };
 
 } // namespace isc::dhcp
@@ -20,6 +20,7 @@
 #include <dhcp/option.h>
 #include <dhcp/pkt6.h>
 #include <dhcp/pkt_filter.h>
+#include <dhcp/pkt_filter_inet.h>
 #include <dhcp/tests/iface_mgr_test_config.h>
 #include <dhcp/tests/pkt_filter6_test_utils.h>
 
@@ -1224,6 +1225,237 @@ TEST_F(IfaceMgrTest, sendReceive4) {
     EXPECT_THROW(ifacemgr->send(sendPkt), SocketWriteError);
 }
 
+// This test verifies that the packets queued on the socket are received
+// by the receive4Batch function.
+TEST_F(IfaceMgrTest, sendReceive4Batch) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    // let's assume that every supported OS have lo interface
+    IOAddress loAddr("127.0.0.1");
+    int socket1 = 0;
+    ASSERT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr, DHCP4_SERVER_PORT + 10000);
+    );
+    ASSERT_GE(socket1, 0);
+
+    // Send three packets having different transaction ids.
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        Pkt4Ptr sendPkt(new Pkt4(DHCPDISCOVER, transid));
+        sendPkt->setLocalAddr(IOAddress("127.0.0.1"));
+        sendPkt->setLocalPort(DHCP4_SERVER_PORT + 10000 + 1);
+        sendPkt->setRemotePort(DHCP4_SERVER_PORT + 10000);
+        sendPkt->setRemoteAddr(IOAddress("127.0.0.1"));
+        sendPkt->setIndex(1);
+        sendPkt->setIface(string(LOOPBACK));
+        ASSERT_NO_THROW(sendPkt->pack());
+        ASSERT_NO_THROW(ifacemgr->send(sendPkt));
+    }
+
+    // The packets may be received by a single call or, on the systems
+    // without recvmmsg, one by one. They are never received beyond the
+    // specified limit.
+    Pkt4Collection rcvPkts;
+    for (int i = 0; (i < 10) && (rcvPkts.size() < 3); ++i) {
+        ASSERT_NO_THROW(ifacemgr->receive4Batch(rcvPkts, 2, 1));
+        ASSERT_LE(rcvPkts.size(), 2 * (i + 1));
+    }
+    ASSERT_EQ(3, rcvPkts.size());
+    for (uint32_t i = 0; i < rcvPkts.size(); ++i) {
+        ASSERT_TRUE(rcvPkts[i]);
+        ASSERT_NO_THROW(rcvPkts[i]->unpack());
+        EXPECT_EQ(i + 1, rcvPkts[i]->getTransid());
+        EXPECT_EQ("127.0.0.1", rcvPkts[i]->getRemoteAddr().toText());
+        EXPECT_EQ(DHCP4_SERVER_PORT + 10000, rcvPkts[i]->getLocalPort());
+        EXPECT_EQ(LOOPBACK, rcvPkts[i]->getIface());
+    }
+
+    // Nothing more is received when the timeout is reached.
+    ASSERT_NO_THROW(ifacemgr->receive4Batch(rcvPkts, 2, 0, 10000));
+    EXPECT_EQ(3, rcvPkts.size());
+
+    close(socket1);
+}
+
+// This test verifies that the packets are received over the sockets opened
+// after waiting for the data.
+TEST_F(IfaceMgrTest, receive4SocketsChanged) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    // let's assume that every supported OS have lo interface
+    IOAddress loAddr("127.0.0.1");
+    int socket1 = 0;
+    ASSERT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr, DHCP4_SERVER_PORT + 10000);
+    );
+    ASSERT_GE(socket1, 0);
+
+    // Nothing is received, but the socket is now in use.
+    Pkt4Ptr rcvPkt;
+    ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(0, 10000));
+    EXPECT_FALSE(rcvPkt);
+
+    // Close the socket and open the sockets again, using two ports.
+    ifacemgr->closeSockets();
+    int socket2 = 0;
+    ASSERT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr, DHCP4_SERVER_PORT + 10000);
+        socket2 = ifacemgr->openSocket(LOOPBACK, loAddr, DHCP4_SERVER_PORT + 10001);
+    );
+    ASSERT_GE(socket1, 0);
+    ASSERT_GE(socket2, 0);
+
+    // The packet sent to each port is received.
+    for (uint16_t port = DHCP4_SERVER_PORT + 10000;
+         port <= DHCP4_SERVER_PORT + 10001; ++port) {
+        Pkt4Ptr sendPkt(new Pkt4(DHCPDISCOVER, port));
+        sendPkt->setLocalAddr(IOAddress("127.0.0.1"));
+        sendPkt->setLocalPort(DHCP4_SERVER_PORT + 10002);
+        sendPkt->setRemotePort(port);
+        sendPkt->setRemoteAddr(IOAddress("127.0.0.1"));
+        sendPkt->setIndex(1);
+        sendPkt->setIface(string(LOOPBACK));
+        ASSERT_NO_THROW(sendPkt->pack());
+        ASSERT_NO_THROW(ifacemgr->send(sendPkt));
+
+        ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(1));
+        ASSERT_TRUE(rcvPkt);
+        ASSERT_NO_THROW(rcvPkt->unpack());
+        EXPECT_EQ(port, rcvPkt->getTransid());
+        EXPECT_EQ(port, rcvPkt->getLocalPort());
+    }
+
+    // The sockets closed by the interface manager are not waited on.
+    ifacemgr->closeSockets();
+    ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(0, 10000));
+    EXPECT_FALSE(rcvPkt);
+}
+
+// This test verifies that the packets are received over the socket added
+// directly to the interface after waiting for the data.
+TEST_F(IfaceMgrTest, receive4SocketAddedToIface) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    // let's assume that every supported OS have lo interface
+    IOAddress loAddr("127.0.0.1");
+    int socket1 = 0;
+    ASSERT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr, DHCP4_SERVER_PORT + 10000);
+    );
+    ASSERT_GE(socket1, 0);
+
+    // Nothing is received, but the socket is now in use.
+    Pkt4Ptr rcvPkt;
+    ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(0, 10000));
+    EXPECT_FALSE(rcvPkt);
+
+    // Open the socket bypassing the interface manager and add it to the
+    // interface.
+    Iface* iface = ifacemgr->getIface(LOOPBACK);
+    ASSERT_TRUE(iface);
+    SocketInfo info(loAddr, 0, -1);
+    ASSERT_NO_THROW(info = PktFilterInet().openSocket(*iface, loAddr,
+                                                      DHCP4_SERVER_PORT + 10001,
+                                                      false, false));
+    ASSERT_GE(info.sockfd_, 0);
+    iface->addSocket(info);
+
+    // The packet sent to the new socket is received without waiting for
+    // the timeout.
+    Pkt4Ptr sendPkt(new Pkt4(DHCPDISCOVER, 1234));
+    sendPkt->setLocalAddr(IOAddress("127.0.0.1"));
+    sendPkt->setLocalPort(DHCP4_SERVER_PORT + 10000);
+    sendPkt->setRemotePort(DHCP4_SERVER_PORT + 10001);
+    sendPkt->setRemoteAddr(IOAddress("127.0.0.1"));
+    sendPkt->setIndex(1);
+    sendPkt->setIface(string(LOOPBACK));
+    ASSERT_NO_THROW(sendPkt->pack());
+    ASSERT_NO_THROW(ifacemgr->send(sendPkt));
+
+    ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(10));
+    ASSERT_TRUE(rcvPkt);
+    ASSERT_NO_THROW(rcvPkt->unpack());
+    EXPECT_EQ(1234, rcvPkt->getTransid());
+    EXPECT_EQ(DHCP4_SERVER_PORT + 10001, rcvPkt->getLocalPort());
+
+    // The socket removed from the interface is no longer waited on.
+    EXPECT_TRUE(iface->delSocket(info.sockfd_));
+    ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(0, 10000));
+    EXPECT_FALSE(rcvPkt);
+
+    ifacemgr->closeSockets();
+}
+
+// This test verifies that the queued packets are sent together and that
+// the statistics of the send queue are updated.
+TEST_F(IfaceMgrTest, sendQueue4) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    // let's assume that every supported OS have lo interface
+    IOAddress loAddr("127.0.0.1");
+    int socket1 = 0;
+    ASSERT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr, DHCP4_SERVER_PORT + 10000);
+    );
+    ASSERT_GE(socket1, 0);
+
+    // Queue three packets having different transaction ids.
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        Pkt4Ptr sendPkt(new Pkt4(DHCPOFFER, transid));
+        sendPkt->setLocalAddr(IOAddress("127.0.0.1"));
+        sendPkt->setLocalPort(DHCP4_SERVER_PORT + 10000 + 1);
+        sendPkt->setRemotePort(DHCP4_SERVER_PORT + 10000);
+        sendPkt->setRemoteAddr(IOAddress("127.0.0.1"));
+        sendPkt->setIndex(1);
+        sendPkt->setIface(string(LOOPBACK));
+        ASSERT_NO_THROW(sendPkt->pack());
+        ifacemgr->queueSend(sendPkt);
+    }
+    EXPECT_EQ(3, ifacemgr->getSendQueueSize());
+    EXPECT_EQ(0, ifacemgr->getSendStatistics().batches_);
+
+    // The packets are sent over the same socket, so they make one batch.
+    ASSERT_NO_THROW(ifacemgr->flushSendQueue());
+    EXPECT_EQ(0, ifacemgr->getSendQueueSize());
+    EXPECT_EQ(1, ifacemgr->getSendStatistics().batches_);
+    EXPECT_EQ(3, ifacemgr->getSendStatistics().packets_);
+    EXPECT_DOUBLE_EQ(3.0, ifacemgr->getSendStatistics().getAverageBatchSize());
+
+    Pkt4Collection rcvPkts;
+    for (int i = 0; (i < 10) && (rcvPkts.size() < 3); ++i) {
+        ASSERT_NO_THROW(ifacemgr->receive4Batch(rcvPkts, 3, 1));
+    }
+    ASSERT_EQ(3, rcvPkts.size());
+    for (uint32_t i = 0; i < rcvPkts.size(); ++i) {
+        ASSERT_NO_THROW(rcvPkts[i]->unpack());
+        EXPECT_EQ(i + 1, rcvPkts[i]->getTransid());
+    }
+
+    // The packet specifying invalid interface doesn't prevent the other
+    // packets from being sent, but the error is reported.
+    Pkt4Ptr invalidPkt(new Pkt4(DHCPOFFER, 4));
+    invalidPkt->setIface("nonexistent");
+    ifacemgr->queueSend(invalidPkt);
+    Pkt4Ptr sendPkt(new Pkt4(DHCPOFFER, 5));
+    sendPkt->setRemotePort(DHCP4_SERVER_PORT + 10000);
+    sendPkt->setRemoteAddr(IOAddress("127.0.0.1"));
+    sendPkt->setIndex(1);
+    sendPkt->setIface(string(LOOPBACK));
+    ASSERT_NO_THROW(sendPkt->pack());
+    ifacemgr->queueSend(sendPkt);
+    EXPECT_THROW(ifacemgr->flushSendQueue(), SocketWriteError);
+    EXPECT_EQ(0, ifacemgr->getSendQueueSize());
+    EXPECT_EQ(2, ifacemgr->getSendStatistics().batches_);
+    EXPECT_EQ(4, ifacemgr->getSendStatistics().packets_);
+
+    rcvPkts.clear();
+    ASSERT_NO_THROW(ifacemgr->receive4Batch(rcvPkts, 3, 10));
+    ASSERT_EQ(1, rcvPkts.size());
+    ASSERT_NO_THROW(rcvPkts[0]->unpack());
+    EXPECT_EQ(5, rcvPkts[0]->getTransid());
+
+    close(socket1);
+}
+
 // Verifies that it is possible to set custom packet filter object
 // to handle sockets opening and send/receive operation.
 TEST_F(IfaceMgrTest, setPacketFilter) {
@@ -2600,6 +2832,59 @@ TEST_F(IfaceMgrTest, DeleteExternalSockets4) {
     close(secondpipe[0]);
 }
 
+// Tests that the external socket registered or changed after waiting for the
+// data is waited on by the subsequent calls to receive4().
+TEST_F(IfaceMgrTest, ChangeExternalSocket4) {
+
+    callback_ok = false;
+    callback2_ok = false;
+
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    int pipefd[2];
+    ASSERT_TRUE(pipe(pipefd) == 0);
+    EXPECT_NO_THROW(ifacemgr->addExternalSocket(pipefd[0], my_callback));
+
+    // Wait for the data, so as the external socket is in use.
+    Pkt4Ptr pkt4;
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(0, 10000));
+    EXPECT_FALSE(pkt4);
+    EXPECT_FALSE(callback_ok);
+
+    // Replace the callback and send some data over the pipe.
+    EXPECT_NO_THROW(ifacemgr->addExternalSocket(pipefd[0], my_callback2));
+    EXPECT_EQ(38, write(pipefd[1], "Hi, this is a message sent over a pipe", 38));
+
+    // The new callback should be called.
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(1));
+    EXPECT_FALSE(pkt4);
+    EXPECT_FALSE(callback_ok);
+    EXPECT_TRUE(callback2_ok);
+
+    // Register the second pipe after waiting for the data.
+    int secondpipe[2];
+    ASSERT_TRUE(pipe(secondpipe) == 0);
+    EXPECT_NO_THROW(ifacemgr->addExternalSocket(secondpipe[0], my_callback));
+
+    // Consume the data from the first pipe and send some data over the
+    // second one.
+    char buf[80];
+    EXPECT_EQ(38, read(pipefd[0], buf, 80));
+    EXPECT_EQ(38, write(secondpipe[1], "Hi, this is a message sent over a pipe", 38));
+
+    callback2_ok = false;
+    ASSERT_NO_THROW(pkt4 = ifacemgr->receive4(1));
+    EXPECT_FALSE(pkt4);
+    EXPECT_TRUE(callback_ok);
+    EXPECT_FALSE(callback2_ok);
+
+    close(pipefd[1]);
+    close(pipefd[0]);
+
+    close(secondpipe[1]);
+    close(secondpipe[0]);
+}
+
 
 // Tests if a single external socket and its callback can be passed and
 // it is supported properly by receive6() method.
@@ -537,6 +537,40 @@ TEST_F(LibDhcpTest, packOptions4) {
     EXPECT_EQ(0, memcmp(v4_opts, buf.getData(), sizeof(v4_opts)));
 }
 
+// This test verifies that the on-wire format of the packed options is
+// copied to the buffer instead of packing these options.
+TEST_F(LibDhcpTest, packOptionsPacked) {
+    OptionPtr opt1(new Option(Option::V4, 12, OptionBuffer(3, 1)));
+    OptionPtr opt2(new Option(Option::V4, 14, OptionBuffer(2, 2)));
+
+    OptionCollection opts;
+    opts.insert(make_pair(opt1->getType(), opt1));
+    opts.insert(make_pair(opt2->getType(), opt2));
+
+    // The on-wire format of the first option is known. It differs from
+    // the actual content of the option, so as we can tell that it has been
+    // copied to the buffer.
+    const uint8_t wire[] = { 12, 1, 0xAB };
+    PackedOption packed;
+    packed.option = opt1;
+    packed.wire.reset(new OptionBuffer(wire, wire + sizeof(wire)));
+    PackedOptionCollection packed_opts(1, packed);
+
+    // The other instance of the option with the same code isn't packed
+    // with this format.
+    PackedOption other;
+    other.option.reset(new Option(Option::V4, 14, OptionBuffer(2, 3)));
+    other.wire.reset(new OptionBuffer(wire, wire + sizeof(wire)));
+    packed_opts.push_back(other);
+
+    OutputBuffer buf(0);
+    ASSERT_NO_THROW(LibDHCP::packOptions(buf, opts, packed_opts));
+
+    const uint8_t expected[] = { 12, 1, 0xAB, 14, 2, 2, 2 };
+    ASSERT_EQ(sizeof(expected), buf.getLength());
+    EXPECT_EQ(0, memcmp(expected, buf.getData(), sizeof(expected)));
+}
+
 TEST_F(LibDhcpTest, unpackOptions4) {
 
     vector<uint8_t> v4packed(v4_opts, v4_opts + sizeof(v4_opts));
@@ -639,6 +673,55 @@ TEST_F(LibDhcpTest, unpackOptions4) {
 
 }
 
+// This test verifies that the locations of the DHCPv4 options are found
+// without creating the options.
+TEST_F(LibDhcpTest, indexOptions4) {
+    // Put the options after a 4-byte header, followed by the padding, the
+    // end option and an option which must not be found.
+    vector<uint8_t> v4packed(4, 0xFF);
+    v4packed.insert(v4packed.end(), v4_opts, v4_opts + sizeof(v4_opts));
+    v4packed.push_back(DHO_PAD);
+    v4packed.push_back(DHO_END);
+    v4packed.push_back(12);
+    v4packed.push_back(0);
+
+    OptionIndex index;
+    EXPECT_EQ(v4packed.size() - 2,
+              LibDHCP::indexOptions4(v4packed, 4, index));
+
+    ASSERT_EQ(6, index.size());
+    OptionIndex::const_iterator loc = index.begin();
+    EXPECT_EQ(12, loc->first);
+    EXPECT_EQ(4, loc->second.first);
+    EXPECT_EQ(5, loc->second.second);
+    ++loc;
+    EXPECT_EQ(14, loc->first);
+    EXPECT_EQ(14, loc->second.first);
+    EXPECT_EQ(5, loc->second.second);
+    ++loc;
+    EXPECT_EQ(60, loc->first);
+    EXPECT_EQ(9, loc->second.first);
+    EXPECT_EQ(5, loc->second.second);
+    ++loc;
+    EXPECT_EQ(DHO_DHCP_AGENT_OPTIONS, loc->first);
+    EXPECT_EQ(29, loc->second.first);
+    EXPECT_EQ(27, loc->second.second);
+    ++loc;
+    EXPECT_EQ(128, loc->first);
+    EXPECT_EQ(24, loc->second.first);
+    EXPECT_EQ(5, loc->second.second);
+    ++loc;
+    EXPECT_EQ(254, loc->first);
+    EXPECT_EQ(19, loc->second.first);
+    EXPECT_EQ(5, loc->second.second);
+
+    // The truncated options are rejected as by unpackOptions4.
+    vector<uint8_t> truncated(v4_opts, v4_opts + sizeof(v4_opts) - 1);
+    EXPECT_THROW(LibDHCP::indexOptions4(truncated, 0, index), OutOfRange);
+    truncated.resize(sizeof(v4_opts) - 26);
+    EXPECT_THROW(LibDHCP::indexOptions4(truncated, 0, index), OutOfRange);
+}
+
 TEST_F(LibDhcpTest, isStandardOption4) {
     // Get all option codes that are not occupied by standard options.
     const uint16_t unassigned_codes[] = { 84, 96, 102, 103, 104, 105, 106, 107, 108,
@@ -626,6 +626,84 @@ TEST_F(Pkt4Test, options) {
     EXPECT_NO_THROW(pkt.reset());
 }
 
+// This test verifies that the options added along with their on-wire format
+// are packed the same way as the other options.
+TEST_F(Pkt4Test, packedOptions) {
+    Pkt4 pkt(DHCPOFFER, 0);
+    Pkt4 packed_pkt(DHCPOFFER, 0);
+
+    OptionPtr opt1(new Option(Option::V4, 12, OptionBuffer(3, 1)));
+    OptionPtr opt2(new Option(Option::V4, 60, OptionBuffer(2, 2)));
+    pkt.addOption(opt1);
+    pkt.addOption(opt2);
+
+    // Add the first option with its on-wire format and the second one
+    // without it.
+    OutputBuffer wire(0);
+    opt1->pack(wire);
+    const uint8_t* data = static_cast<const uint8_t*>(wire.getData());
+    PackedOption packed;
+    packed.option = opt1;
+    packed.wire.reset(new OptionBuffer(data, data + wire.getLength()));
+    ASSERT_NO_THROW(packed_pkt.addPackedOption(packed));
+    packed.option = opt2;
+    packed.wire.reset();
+    ASSERT_NO_THROW(packed_pkt.addPackedOption(packed));
+    EXPECT_TRUE(packed_pkt.hasOption(12));
+    EXPECT_TRUE(packed_pkt.hasOption(60));
+    EXPECT_FALSE(packed_pkt.hasOption(61));
+
+    // Options are unique in DHCPv4.
+    packed.option = opt1;
+    EXPECT_THROW(packed_pkt.addPackedOption(packed), BadValue);
+
+    ASSERT_NO_THROW(pkt.pack());
+    ASSERT_NO_THROW(packed_pkt.pack());
+    ASSERT_EQ(pkt.getBuffer().getLength(), packed_pkt.getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(pkt.getBuffer().getData(),
+                        packed_pkt.getBuffer().getData(),
+                        pkt.getBuffer().getLength()));
+}
+
+// This test verifies that the on-wire format of the option is not used
+// once the option has been returned for modification.
+TEST_F(Pkt4Test, packedOptionsModified) {
+    OptionPtr opt(new Option(Option::V4, 12, OptionBuffer(3, 1)));
+    OutputBuffer wire(0);
+    opt->pack(wire);
+    const uint8_t* data = static_cast<const uint8_t*>(wire.getData());
+    PackedOption packed;
+    packed.option = opt;
+    packed.wire.reset(new OptionBuffer(data, data + wire.getLength()));
+
+    // The option returned by getOption is modified, so the new contents
+    // must be packed. The option is the first one in the packet.
+    const OptionBuffer modified(2, 5);
+    Pkt4 pkt(DHCPOFFER, 0);
+    ASSERT_NO_THROW(pkt.addPackedOption(packed));
+    OptionPtr returned = pkt.getOption(12);
+    ASSERT_TRUE(returned);
+    returned->setData(modified.begin(), modified.end());
+    ASSERT_NO_THROW(pkt.pack());
+    const uint8_t expected[] = { 12, 2, 5, 5 };
+    const uint8_t* out = static_cast<const uint8_t*>(pkt.getBuffer().getData());
+    const size_t offset = Pkt4::DHCPV4_PKT_HDR_LEN + 4;
+    ASSERT_LE(offset + sizeof(expected), pkt.getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(out + offset, expected, sizeof(expected)));
+
+    // The same applies to the options of the packet whose on-wire format
+    // has been cleared.
+    Pkt4 cleared(DHCPOFFER, 0);
+    packed.option.reset(new Option(Option::V4, 12, OptionBuffer(3, 1)));
+    ASSERT_NO_THROW(cleared.addPackedOption(packed));
+    cleared.clearPackedOptions();
+    packed.option->setData(modified.begin(), modified.end());
+    ASSERT_NO_THROW(cleared.pack());
+    out = static_cast<const uint8_t*>(cleared.getBuffer().getData());
+    ASSERT_LE(offset + sizeof(expected), cleared.getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(out + offset, expected, sizeof(expected)));
+}
+
 // This test verifies that the options are unpacked from the packet correctly.
 TEST_F(Pkt4Test, unpackOptions) {
 
@@ -693,6 +771,108 @@ TEST_F(Pkt4Test, unpackOptionsWithCallback) {
 
 }
 
+// This test verifies that the options are unpacked when they are first
+// accessed if the lazy unpacking is enabled.
+TEST_F(Pkt4Test, unpackOptionsLazy) {
+    vector<uint8_t> expectedFormat = generateTestPacket2();
+
+    expectedFormat.push_back(0x63);
+    expectedFormat.push_back(0x82);
+    expectedFormat.push_back(0x53);
+    expectedFormat.push_back(0x63);
+
+    for (int i = 0; i < sizeof(v4_opts); i++) {
+        expectedFormat.push_back(v4_opts[i]);
+    }
+
+    Pkt4Ptr pkt(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    pkt->setLazyUnpack(true);
+
+    CustomUnpackCallback cb;
+    pkt->setCallback(boost::bind(&CustomUnpackCallback::execute, &cb,
+                                 _1, _2, _3));
+
+    ASSERT_NO_THROW(pkt->unpack());
+    EXPECT_EQ(2, pkt->getType());
+
+    // The option is created with the callback when it is first accessed.
+    cb.executed_ = false;
+    EXPECT_TRUE(pkt->getOption(12));
+    EXPECT_TRUE(cb.executed_);
+
+    // Once created, the option is returned from the packet.
+    cb.executed_ = false;
+    EXPECT_TRUE(pkt->getOption(12));
+    EXPECT_FALSE(cb.executed_);
+
+    // The options which are not present are not created.
+    EXPECT_FALSE(pkt->getOption(13));
+    EXPECT_FALSE(cb.executed_);
+
+    verifyParsedOptions(pkt);
+
+    // The option which has not been accessed can be deleted.
+    pkt.reset(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    pkt->setLazyUnpack(true);
+    ASSERT_NO_THROW(pkt->unpack());
+    EXPECT_TRUE(pkt->delOption(254));
+    EXPECT_FALSE(pkt->getOption(254));
+    EXPECT_FALSE(pkt->delOption(254));
+
+    // The option which has not been accessed can't be added again.
+    OptionPtr opt(new Option(Option::V4, 128));
+    EXPECT_THROW(pkt->addOption(opt), BadValue);
+
+    // The packet unpacked lazily is packed as the packet unpacked at once.
+    Pkt4 eager(&expectedFormat[0], expectedFormat.size());
+    ASSERT_NO_THROW(eager.unpack());
+    ASSERT_TRUE(eager.delOption(254));
+    ASSERT_NO_THROW(eager.pack());
+    ASSERT_NO_THROW(pkt->pack());
+    ASSERT_EQ(eager.getBuffer().getLength(), pkt->getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(eager.getBuffer().getData(),
+                        pkt->getBuffer().getData(),
+                        pkt->getBuffer().getLength()));
+}
+
+// This test verifies that the malformed options are reported when they are
+// accessed if the lazy unpacking is enabled.
+TEST_F(Pkt4Test, unpackOptionsLazyMalformed) {
+    vector<uint8_t> expectedFormat = generateTestPacket2();
+
+    expectedFormat.push_back(0x63);
+    expectedFormat.push_back(0x82);
+    expectedFormat.push_back(0x53);
+    expectedFormat.push_back(0x63);
+
+    for (int i = 0; i < sizeof(v4_opts); i++) {
+        expectedFormat.push_back(v4_opts[i]);
+    }
+
+    // Lease time option carries a 32-bit value, so it is malformed.
+    expectedFormat.push_back(DHO_DHCP_LEASE_TIME);
+    expectedFormat.push_back(1);
+    expectedFormat.push_back(0);
+
+    Pkt4 eager(&expectedFormat[0], expectedFormat.size());
+    EXPECT_THROW(eager.unpack(), InvalidOptionValue);
+
+    // The malformed option is reported each time it is accessed.
+    Pkt4 lazy(&expectedFormat[0], expectedFormat.size());
+    lazy.setLazyUnpack(true);
+    ASSERT_NO_THROW(lazy.unpack());
+    EXPECT_TRUE(lazy.getOption(12));
+    EXPECT_THROW(lazy.getOption(DHO_DHCP_LEASE_TIME), InvalidOptionValue);
+    EXPECT_THROW(lazy.getOption(DHO_DHCP_LEASE_TIME), InvalidOptionValue);
+    EXPECT_THROW(lazy.pack(), InvalidOperation);
+
+    // The truncated option is reported by unpack.
+    expectedFormat[expectedFormat.size() - 2] = 4;
+    Pkt4 truncated(&expectedFormat[0], expectedFormat.size());
+    truncated.setLazyUnpack(true);
+    EXPECT_THROW(truncated.unpack(), OutOfRange);
+}
+
 // This test verifies methods that are used for manipulating meta fields
 // i.e. fields that are not part of DHCPv4 (e.g. interface name).
 TEST_F(Pkt4Test, metaFields) {
@@ -18,11 +18,15 @@
 #include <dhcp/pkt6.h>
 #include <dhcp/pkt_filter_inet6.h>
 #include <dhcp/tests/pkt_filter6_test_utils.h>
+#include <util/threads/thread.h>
 
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <gtest/gtest.h>
 
 using namespace isc::asiolink;
 using namespace isc::dhcp;
+using namespace isc::util::thread;
 
 namespace {
 
@@ -37,6 +41,19 @@ class PktFilterInet6Test : public isc::dhcp::test::PktFilter6Test {
 public:
     PktFilterInet6Test() : PktFilter6Test(PORT) {
     }
+
+    /// @brief Sends the copies of the message over the socket.
+    ///
+    /// @param pkt_filter packet filter used to send the message
+    /// @param iface interface over which the message is sent
+    /// @param pkt message to be sent, not shared with other threads
+    /// @param count number of the copies to be sent
+    void sendPackets(PktFilterInet6* pkt_filter, const Iface* iface,
+                     const Pkt6Ptr& pkt, const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            pkt_filter->send(*iface, sock_info_.sockfd_, pkt);
+        }
+    }
 };
 
 // This test verifies that the INET6 datagram socket is correctly opened and
@@ -105,6 +122,99 @@ TEST_F(PktFilterInet6Test, send) {
 
 }
 
+// This test verifies that the DHCPv6 messages are correctly sent by several
+// threads at once over the same INET6 datagram socket.
+TEST_F(PktFilterInet6Test, sendConcurrent) {
+    // Packets will be sent over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("::1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet6 pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, true);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Each thread sends its own copy of the test message. The send fails
+    // if the control message is corrupted by another thread.
+    const size_t thread_count = 4;
+    const size_t packet_count = 16;
+    std::vector<boost::shared_ptr<Thread> > threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        Pkt6Ptr pkt(new Pkt6(*test_message_));
+        threads.push_back(boost::shared_ptr<Thread>(new Thread(
+            boost::bind(&PktFilterInet6Test::sendPackets, this, &pkt_filter,
+                        &iface, pkt, packet_count))));
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        EXPECT_NO_THROW(threads[i]->wait());
+    }
+
+    // All messages should be received from loopback interface.
+    for (size_t i = 0; i < thread_count * packet_count; ++i) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sock_info_.sockfd_, &readfds);
+
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        int result = select(sock_info_.sockfd_ + 1, &readfds, NULL, NULL,
+                            &timeout);
+        ASSERT_GT(result, 0);
+
+        uint8_t rcv_buf[RECV_BUF_SIZE];
+        result = recv(sock_info_.sockfd_, rcv_buf, RECV_BUF_SIZE, 0);
+        ASSERT_GT(result, 0);
+
+        Pkt6Ptr rcvd_pkt(new Pkt6(rcv_buf, result));
+        ASSERT_NO_THROW(rcvd_pkt->unpack());
+        testRcvdMessage(rcvd_pkt);
+    }
+}
+
+// This test verifies that the DHCPv6 packets are correctly sent together over
+// the INET6 datagram socket.
+TEST_F(PktFilterInet6Test, sendBatch) {
+    // Packets will be sent over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("::1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet6 pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, true);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Send three packets over the socket.
+    Pkt6Collection pkts(3, test_message_);
+    ASSERT_NO_THROW(pkt_filter.sendBatch(iface, sock_info_.sockfd_, pkts));
+
+    // All packets should be received from loopback interface.
+    for (int i = 0; i < 3; ++i) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sock_info_.sockfd_, &readfds);
+
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        int result = select(sock_info_.sockfd_ + 1, &readfds, NULL, NULL,
+                            &timeout);
+        ASSERT_GT(result, 0);
+
+        uint8_t rcv_buf[RECV_BUF_SIZE];
+        result = recv(sock_info_.sockfd_, rcv_buf, RECV_BUF_SIZE, 0);
+        ASSERT_GT(result, 0);
+
+        Pkt6Ptr rcvd_pkt(new Pkt6(rcv_buf, result));
+        ASSERT_NO_THROW(rcvd_pkt->unpack());
+        testRcvdMessage(rcvd_pkt);
+    }
+
+    // Sending no packets is a no-op.
+    pkts.clear();
+    EXPECT_NO_THROW(pkt_filter.sendBatch(iface, sock_info_.sockfd_, pkts));
+}
+
 // This test verifies that the DHCPv6 packet is correctly received via
 // INET6 datagram socket and that it matches sent packet.
 TEST_F(PktFilterInet6Test, receive) {
@@ -137,4 +247,50 @@ TEST_F(PktFilterInet6Test, receive) {
     testRcvdMessage(rcvd_pkt);
     }
 
+// This test verifies that the DHCPv6 packets queued on the INET6 datagram
+// socket are received together.
+TEST_F(PktFilterInet6Test, receiveBatch) {
+
+    // Packets will be received over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("::1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet6 pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT + 1, true);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Send three DHCPv6 messages to the local loopback address and server's
+    // port.
+    for (int i = 0; i < 3; ++i) {
+        sendMessage();
+    }
+
+    // Receive the packets. The number of packets received with a single
+    // call is limited.
+    Pkt6Collection rcvd_pkts;
+    ASSERT_NO_THROW(pkt_filter.receiveBatch(sock_info_, 2, rcvd_pkts));
+#ifdef HAVE_RECVMMSG
+    ASSERT_EQ(2, rcvd_pkts.size());
+
+    // The remaining packet is received by the next call.
+    ASSERT_NO_THROW(pkt_filter.receiveBatch(sock_info_, 2, rcvd_pkts));
+    ASSERT_EQ(3, rcvd_pkts.size());
+
+    // The function doesn't block when there are no more packets.
+    ASSERT_NO_THROW(pkt_filter.receiveBatch(sock_info_, 2, rcvd_pkts));
+    EXPECT_EQ(3, rcvd_pkts.size());
+#else
+    // A single packet is received on the systems without recvmmsg.
+    ASSERT_EQ(1, rcvd_pkts.size());
+#endif
+
+    for (Pkt6Collection::const_iterator pkt = rcvd_pkts.begin();
+         pkt != rcvd_pkts.end(); ++pkt) {
+        ASSERT_TRUE(*pkt);
+        ASSERT_NO_THROW((*pkt)->unpack());
+        testRcvdMessage(*pkt);
+    }
+}
+
 } // anonymous namespace
@@ -18,13 +18,17 @@
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt_filter_inet.h>
 #include <dhcp/tests/pkt_filter_test_utils.h>
+#include <util/threads/thread.h>
 
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <gtest/gtest.h>
 
 #include <sys/socket.h>
 
 using namespace isc::asiolink;
 using namespace isc::dhcp;
+using namespace isc::util::thread;
 
 namespace {
 
@@ -39,6 +43,19 @@ class PktFilterInetTest : public isc::dhcp::test::PktFilterTest {
 public:
     PktFilterInetTest() : PktFilterTest(PORT) {
     }
+
+    /// @brief Sends the copies of the packet over the socket.
+    ///
+    /// @param pkt_filter packet filter used to send the packet
+    /// @param iface interface over which the packet is sent
+    /// @param pkt packet to be sent, not shared with other threads
+    /// @param count number of the copies to be sent
+    void sendPackets(PktFilterInet* pkt_filter, const Iface* iface,
+                     const Pkt4Ptr& pkt, const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            pkt_filter->send(*iface, sock_info_.sockfd_, pkt);
+        }
+    }
 };
 
 // This test verifies that the PktFilterInet class reports its lack
@@ -119,6 +136,99 @@ TEST_F(PktFilterInetTest, send) {
 
 }
 
+// This test verifies that the packets are correctly sent by several threads
+// at once over the same INET datagram socket.
+TEST_F(PktFilterInetTest, sendConcurrent) {
+    // Packets will be sent over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("127.0.0.1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, false, false);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Each thread sends its own copy of the test message. The send fails
+    // if the control message is corrupted by another thread.
+    const size_t thread_count = 4;
+    const size_t packet_count = 16;
+    std::vector<boost::shared_ptr<Thread> > threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        Pkt4Ptr pkt(new Pkt4(*test_message_));
+        threads.push_back(boost::shared_ptr<Thread>(new Thread(
+            boost::bind(&PktFilterInetTest::sendPackets, this, &pkt_filter,
+                        &iface, pkt, packet_count))));
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        EXPECT_NO_THROW(threads[i]->wait());
+    }
+
+    // All packets should be received from loopback interface.
+    for (size_t i = 0; i < thread_count * packet_count; ++i) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sock_info_.sockfd_, &readfds);
+
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        int result = select(sock_info_.sockfd_ + 1, &readfds, NULL, NULL,
+                            &timeout);
+        ASSERT_GT(result, 0);
+
+        uint8_t rcv_buf[RECV_BUF_SIZE];
+        result = recv(sock_info_.sockfd_, rcv_buf, RECV_BUF_SIZE, 0);
+        ASSERT_GT(result, 0);
+
+        Pkt4Ptr rcvd_pkt(new Pkt4(rcv_buf, result));
+        ASSERT_NO_THROW(rcvd_pkt->unpack());
+        testRcvdMessage(rcvd_pkt);
+    }
+}
+
+// This test verifies that the DHCPv4 packets are correctly sent together over
+// the INET datagram socket.
+TEST_F(PktFilterInetTest, sendBatch) {
+    // Packets will be sent over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("127.0.0.1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, false, false);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Send three packets over the socket.
+    Pkt4Collection pkts(3, test_message_);
+    ASSERT_NO_THROW(pkt_filter.sendBatch(iface, sock_info_.sockfd_, pkts));
+
+    // All packets should be received from loopback interface.
+    for (int i = 0; i < 3; ++i) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sock_info_.sockfd_, &readfds);
+
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        int result = select(sock_info_.sockfd_ + 1, &readfds, NULL, NULL,
+                            &timeout);
+        ASSERT_GT(result, 0);
+
+        uint8_t rcv_buf[RECV_BUF_SIZE];
+        result = recv(sock_info_.sockfd_, rcv_buf, RECV_BUF_SIZE, 0);
+        ASSERT_GT(result, 0);
+
+        Pkt4Ptr rcvd_pkt(new Pkt4(rcv_buf, result));
+        ASSERT_NO_THROW(rcvd_pkt->unpack());
+        testRcvdMessage(rcvd_pkt);
+    }
+
+    // Sending no packets is a no-op.
+    pkts.clear();
+    EXPECT_NO_THROW(pkt_filter.sendBatch(iface, sock_info_.sockfd_, pkts));
+}
+
 // This test verifies that the DHCPv4 packet is correctly received via
 // INET datagram socket and that it matches sent packet.
 TEST_F(PktFilterInetTest, receive) {
@@ -150,4 +260,50 @@ TEST_F(PktFilterInetTest, receive) {
     testRcvdMessage(rcvd_pkt);
 }
 
+// This test verifies that the DHCPv4 packets queued on the INET datagram
+// socket are received together.
+TEST_F(PktFilterInetTest, receiveBatch) {
+
+    // Packets will be received over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("127.0.0.1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, false, false);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Send three DHCPv4 messages to the local loopback address and server's
+    // port.
+    for (int i = 0; i < 3; ++i) {
+        sendMessage();
+    }
+
+    // Receive the packets. The number of packets received with a single
+    // call is limited.
+    Pkt4Collection rcvd_pkts;
+    ASSERT_NO_THROW(pkt_filter.receiveBatch(iface, sock_info_, 2, rcvd_pkts));
+#ifdef HAVE_RECVMMSG
+    ASSERT_EQ(2, rcvd_pkts.size());
+
+    // The remaining packet is received by the next call.
+    ASSERT_NO_THROW(pkt_filter.receiveBatch(iface, sock_info_, 2, rcvd_pkts));
+    ASSERT_EQ(3, rcvd_pkts.size());
+
+    // The function doesn't block when there are no more packets.
+    ASSERT_NO_THROW(pkt_filter.receiveBatch(iface, sock_info_, 2, rcvd_pkts));
+    EXPECT_EQ(3, rcvd_pkts.size());
+#else
+    // A single packet is received on the systems without recvmmsg.
+    ASSERT_EQ(1, rcvd_pkts.size());
+#endif
+
+    for (Pkt4Collection::const_iterator pkt = rcvd_pkts.begin();
+         pkt != rcvd_pkts.end(); ++pkt) {
+        ASSERT_TRUE(*pkt);
+        ASSERT_NO_THROW((*pkt)->unpack());
+        testRcvdMessage(*pkt);
+    }
+}
+
 } // anonymous namespace
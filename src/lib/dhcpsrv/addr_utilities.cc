@@ -15,6 +15,9 @@
 #include <dhcpsrv/addr_utilities.h>
 #include <exceptions/exceptions.h>
 
+#include <limits>
+#include <vector>
+
 #include <string.h>
 
 using namespace isc;
@@ -205,5 +208,98 @@ isc::asiolink::IOAddress getNetmask4(uint8_t len) {
     return (IOAddress(x));
 }
 
+uint64_t addrsInRange(const isc::asiolink::IOAddress& min,
+                      const isc::asiolink::IOAddress& max) {
+    if (min.getFamily() != max.getFamily()) {
+        isc_throw(BadValue, "Both addresses have to be the same family");
+    }
+
+    if (max < min) {
+        isc_throw(BadValue, min.toText() << " must not be greater than "
+                  << max.toText());
+    }
+
+    if (min.isV4()) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(max)) -
+                static_cast<uint32_t>(min) + 1);
+    }
+
+    // Compute the difference between the addresses as a pair of 64-bit
+    // values, starting from the most significant bytes.
+    const std::vector<uint8_t>& min_bytes = min.toBytes();
+    const std::vector<uint8_t>& max_bytes = max.toBytes();
+    uint64_t min_hi = 0, min_lo = 0, max_hi = 0, max_lo = 0;
+    for (int i = 0; i < 8; ++i) {
+        min_hi = (min_hi << 8) | min_bytes[i];
+        min_lo = (min_lo << 8) | min_bytes[i + 8];
+        max_hi = (max_hi << 8) | max_bytes[i];
+        max_lo = (max_lo << 8) | max_bytes[i + 8];
+    }
+    const uint64_t diff_hi = max_hi - min_hi - (max_lo < min_lo ? 1 : 0);
+    const uint64_t diff_lo = max_lo - min_lo;
+
+    // The number of addresses doesn't fit in 64 bits.
+    if ((diff_hi != 0) || (diff_lo == std::numeric_limits<uint64_t>::max())) {
+        return (std::numeric_limits<uint64_t>::max());
+    }
+    return (diff_lo + 1);
+}
+
+uint64_t prefixesInRange(const uint8_t pool_len, const uint8_t delegated_len) {
+    if ((delegated_len > 128) || (pool_len > delegated_len)) {
+        isc_throw(BadValue, "Invalid prefix lengths: pool /"
+                  << static_cast<int>(pool_len) << ", delegated /"
+                  << static_cast<int>(delegated_len));
+    }
+
+    const unsigned int bits = delegated_len - pool_len;
+    if (bits >= 64) {
+        return (std::numeric_limits<uint64_t>::max());
+    }
+    return (static_cast<uint64_t>(1) << bits);
+}
+
+isc::asiolink::IOAddress offsetAddress(const isc::asiolink::IOAddress& addr,
+                                       const uint64_t offset,
+                                       const uint8_t prefix_len) {
+    if (addr.isV4()) {
+        return (IOAddress(static_cast<uint32_t>(addr) +
+                          static_cast<uint32_t>(offset)));
+    }
+
+    if ((prefix_len == 0) || (prefix_len > 128)) {
+        isc_throw(BadValue, "Invalid prefix length: "
+                  << static_cast<int>(prefix_len));
+    }
+
+    // Shift the offset to the last bit of the prefix, splitting it
+    // into the upper and lower 64 bits.
+    const unsigned int shift = 128 - prefix_len;
+    uint64_t add_hi = 0, add_lo = offset;
+    if (shift >= 64) {
+        add_hi = offset << (shift - 64);
+        add_lo = 0;
+    } else if (shift > 0) {
+        add_hi = offset >> (64 - shift);
+        add_lo = offset << shift;
+    }
+
+    // Add the value starting from the least significant byte, carrying
+    // the overflow to the next byte.
+    uint8_t packed[V6ADDRESS_LEN];
+    memcpy(packed, &addr.toBytes()[0], V6ADDRESS_LEN);
+    unsigned int carry = 0;
+    for (int i = V6ADDRESS_LEN - 1; i >= 0; --i) {
+        const uint64_t part = (i >= 8 ? add_lo : add_hi);
+        const unsigned int byte_shift = ((V6ADDRESS_LEN - 1 - i) % 8) * 8;
+        const unsigned int sum = packed[i] + ((part >> byte_shift) & 0xff) +
+            carry;
+        packed[i] = static_cast<uint8_t>(sum);
+        carry = sum >> 8;
+    }
+
+    return (IOAddress::fromBytes(AF_INET6, packed));
+}
+
 };
 };
@@ -17,6 +17,8 @@
 
 #include <asiolink/io_address.h>
 
+#include <stdint.h>
+
 namespace isc {
 namespace dhcp {
 
@@ -57,6 +59,50 @@ isc::asiolink::IOAddress lastAddrInPrefix(const isc::asiolink::IOAddress& prefix
 /// @return netmask
 isc::asiolink::IOAddress getNetmask4(uint8_t len);
 
+/// @brief Returns the number of addresses in the specified range
+///
+/// Both addresses must belong to the same family and the first address
+/// must not be greater than the last one. If the range holds more than
+/// 2^64 - 1 addresses (which is possible for IPv6), the maximum value of
+/// the uint64_t is returned.
+///
+/// @param min the first address in the range
+/// @param max the last address in the range
+///
+/// @throw BadValue if the addresses belong to different families
+/// @return number of addresses in the range
+uint64_t addrsInRange(const isc::asiolink::IOAddress& min,
+                      const isc::asiolink::IOAddress& max);
+
+/// @brief Returns the number of prefixes delegated from the pool
+///
+/// If the pool holds more than 2^64 - 1 prefixes, the maximum value of
+/// the uint64_t is returned.
+///
+/// @param pool_len length of the pool prefix
+/// @param delegated_len length of the delegated prefixes
+///
+/// @throw BadValue if the delegated length is shorter than the pool length
+/// @return number of prefixes in the pool
+uint64_t prefixesInRange(const uint8_t pool_len, const uint8_t delegated_len);
+
+/// @brief Returns the address (prefix) at the given offset from another one
+///
+/// Example: For 2001:db8:1\:: and the offset 3 with the prefix length
+/// /64 the function will return 2001:db8:1:3\::. The result wraps around
+/// at the end of the address space.
+///
+/// @param addr the address (prefix) to which the offset is added
+/// @param offset number of addresses (prefixes) to add
+/// @param prefix_len length of the prefixes (IPv6 only). It is 128 for
+/// addresses.
+///
+/// @throw BadValue if the prefix length is invalid
+/// @return the address (prefix) at the given offset
+isc::asiolink::IOAddress offsetAddress(const isc::asiolink::IOAddress& addr,
+                                       const uint64_t offset,
+                                       const uint8_t prefix_len = 128);
+
 };
 };
 
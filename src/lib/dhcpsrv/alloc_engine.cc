@@ -12,19 +12,27 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <dhcpsrv/addr_utilities.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/lease_mgr_factory.h>
+#include <dhcpsrv/ncr_generator.h>
 
 #include <hooks/server_hooks.h>
 #include <hooks/hooks_manager.h>
 
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/random/uniform_int.hpp>
+
 #include <cstring>
+#include <limits>
 #include <vector>
 #include <string.h>
 
 using namespace isc::asiolink;
 using namespace isc::hooks;
+using namespace boost::posix_time;
 
 namespace {
 
@@ -53,6 +61,84 @@ AllocEngineHooks Hooks;
 namespace isc {
 namespace dhcp {
 
+uint64_t
+AllocEngine::Allocator::getTotalCapacity(const PoolCollection& pools) {
+    uint64_t total = 0;
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        const uint64_t capacity = (*pool)->getCapacity();
+        if (total > std::numeric_limits<uint64_t>::max() - capacity) {
+            return (std::numeric_limits<uint64_t>::max());
+        }
+        total += capacity;
+    }
+    return (total);
+}
+
+isc::asiolink::IOAddress
+AllocEngine::Allocator::getAddressAtOffset(const PoolCollection& pools,
+                                           uint64_t offset) const {
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        if (offset < (*pool)->getCapacity()) {
+            return (offsetAddress((*pool)->getFirstAddress(), offset,
+                                  getPrefixLength(*pool)));
+        }
+        offset -= (*pool)->getCapacity();
+    }
+
+    isc_throw(AllocFailed, "Offset out of range of the pools");
+}
+
+isc::asiolink::IOAddress
+AllocEngine::Allocator::getNextAddress(const PoolCollection& pools,
+                                       const IOAddress& addr) const {
+    if (pools.empty()) {
+        isc_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        if (!(*pool)->inRange(addr)) {
+            continue;
+        }
+
+        // The address must not be equal to the last address in the pool,
+        // because the next address could wrap around the address space.
+        if (addr != (*pool)->getLastAddress()) {
+            const IOAddress next = offsetAddress(addr, 1,
+                                                 getPrefixLength(*pool));
+            if ((*pool)->inRange(next)) {
+                return (next);
+            }
+        }
+
+        // We hit the pool boundary, so let's go to the next pool.
+        ++pool;
+        if (pool == pools.end()) {
+            pool = pools.begin();
+        }
+        return ((*pool)->getFirstAddress());
+    }
+
+    return (pools[0]->getFirstAddress());
+}
+
+uint8_t
+AllocEngine::Allocator::getPrefixLength(const PoolPtr& pool) const {
+    if (pool_type_ != Lease::TYPE_PD) {
+        return (128);
+    }
+
+    Pool6Ptr pool6 = boost::dynamic_pointer_cast<Pool6>(pool);
+    if (!pool6) {
+        // Something is gravely wrong here
+        isc_throw(Unexpected, "Wrong type of pool: " << pool->toText()
+                  << " is not Pool6");
+    }
+    return (pool6->getLength());
+}
+
 AllocEngine::IterativeAllocator::IterativeAllocator(Lease::Type lease_type)
     :Allocator(lease_type) {
 }
@@ -147,6 +233,9 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
                                              const DuidPtr&,
                                              const IOAddress&) {
 
+    // Two threads must not pick the same address from the subnet.
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     // Is this prefix allocation?
     bool prefix = pool_type_ == Lease::TYPE_PD;
 
@@ -218,29 +307,75 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
 }
 
 AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
-    :Allocator(lease_type) {
-    isc_throw(NotImplemented, "Hashed allocator is not implemented");
+    :Allocator(lease_type), generator_(static_cast<uint32_t>(time(NULL))) {
 }
 
+uint64_t
+AllocEngine::HashedAllocator::hash(const DUID& duid) {
+    const std::vector<uint8_t>& id = duid.getDuid();
+    uint64_t value = 14695981039346656037ull;
+    for (std::vector<uint8_t>::const_iterator byte = id.begin();
+         byte != id.end(); ++byte) {
+        value ^= *byte;
+        value *= 1099511628211ull;
+    }
+    return (value);
+}
 
 isc::asiolink::IOAddress
-AllocEngine::HashedAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
-                                          const IOAddress&) {
-    isc_throw(NotImplemented, "Hashed allocator is not implemented");
+AllocEngine::HashedAllocator::pickAddress(const SubnetPtr& subnet,
+                                          const DuidPtr& duid,
+                                          const IOAddress& hint) {
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+
+    if (pools.empty()) {
+        isc_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    // If the hint belongs to one of the pools, it is the address we have
+    // returned previously and it turned out to be in use. Let's try the
+    // next one.
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        if ((*pool)->inRange(hint)) {
+            return (getNextAddress(pools, hint));
+        }
+    }
+
+    const uint64_t total = getTotalCapacity(pools);
+
+    // The DHCPv4 client may not send the client identifier, in which case
+    // there is nothing to compute the hash from.
+    if (!duid) {
+        isc::util::thread::Mutex::Locker lock(mutex_);
+        boost::uniform_int<uint64_t> dist(0, total - 1);
+        return (getAddressAtOffset(pools, dist(generator_)));
+    }
+
+    return (getAddressAtOffset(pools, hash(*duid) % total));
 }
 
 AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type)
-    :Allocator(lease_type) {
-    isc_throw(NotImplemented, "Random allocator is not implemented");
+    :Allocator(lease_type), generator_(static_cast<uint32_t>(time(NULL))) {
 }
 
-
 isc::asiolink::IOAddress
-AllocEngine::RandomAllocator::pickAddress(const SubnetPtr&,
+AllocEngine::RandomAllocator::pickAddress(const SubnetPtr& subnet,
                                           const DuidPtr&,
                                           const IOAddress&) {
-    isc_throw(NotImplemented, "Random allocator is not implemented");
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+
+    if (pools.empty()) {
+        isc_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    uint64_t offset = 0;
+    {
+        isc::util::thread::Mutex::Locker lock(mutex_);
+        boost::uniform_int<uint64_t> dist(0, getTotalCapacity(pools) - 1);
+        offset = dist(generator_);
+    }
+    return (getAddressAtOffset(pools, offset));
 }
 
 
@@ -299,7 +434,7 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                              const bool rev_dns_update,
                              const std::string& hostname, bool fake_allocation,
                              const isc::hooks::CalloutHandlePtr& callout_handle,
-                             Lease6Collection& old_leases) {
+                             ConstLease6Collection& old_leases) {
 
     try {
         AllocatorPtr allocator = getAllocator(type);
@@ -320,8 +455,9 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // Check if there's existing lease for that subnet/duid/iaid
         // combination.
         /// @todo: Make this generic (cover temp. addrs and prefixes)
-        Lease6Collection existing = LeaseMgrFactory::instance().getLeases6(type,
-                                    *duid, iaid, subnet->getID());
+        ConstLease6Collection existing =
+            LeaseMgrFactory::instance().getConstLeases6(type, *duid, iaid,
+                                                        subnet->getID());
 
         // There is at least one lease for this client. We will return these
         // leases for the client, but we may need to update FQDN information.
@@ -339,17 +475,19 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
 
         if (pool) {
             /// @todo: We support only one hint for now
-            Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(type, hint);
-            if (!lease) {
+            ConstLease6Ptr existing =
+                LeaseMgrFactory::instance().getConstLease6(type, hint);
+            if (!existing) {
                 /// @todo: check if the hint is reserved once we have host
                 /// support implemented
 
                 // The hint is valid and not currently used, let's create a
                 // lease for it
-                lease = createLease6(subnet, duid, iaid, hint,
-                                     pool->getLength(), type,
-                                     fwd_dns_update, rev_dns_update,
-                                     hostname, callout_handle, fake_allocation);
+                Lease6Ptr lease = createLease6(subnet, duid, iaid, hint,
+                                               pool->getLength(), type,
+                                               fwd_dns_update, rev_dns_update,
+                                               hostname, callout_handle,
+                                               fake_allocation);
 
                 // It can happen that the lease allocation failed (we could
                 // have lost the race condition. That means that the hint is
@@ -358,7 +496,7 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 if (lease) {
                     // We are allocating a new lease (not renewing). So, the
                     // old lease should be NULL.
-                    old_leases.push_back(Lease6Ptr());
+                    old_leases.push_back(ConstLease6Ptr());
 
                     /// @todo: We support only one lease per ia for now
                     Lease6Collection collection;
@@ -366,13 +504,14 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     return (collection);
                 }
             } else {
-                if (lease->expired()) {
-                    // Copy an existing, expired lease so as it can be returned
-                    // to the caller.
-                    Lease6Ptr old_lease(new Lease6(*lease));
-                    old_leases.push_back(old_lease);
+                if (existing->expired()) {
+                    // The existing lease is not modified, so it is returned
+                    // to the caller as the old lease. The copy of it is
+                    // reused.
+                    old_leases.push_back(existing);
 
                     /// We found a lease and it is expired, so we can reuse it
+                    Lease6Ptr lease(new Lease6(*existing));
                     lease = reuseExpiredLease(lease, subnet, duid, iaid,
                                               pool->getLength(),
                                               fwd_dns_update, rev_dns_update,
@@ -404,9 +543,56 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // left), but this has one major problem. We exactly control allocation
         // moment, but we currently do not control expiration time at all
 
+        // If the free addresses are tracked, try the addresses known to be
+        // free first. The expired leases are left for the regular search.
+        if (CfgMgr::instance().freeAddressTracking()) {
+            IOAddress candidate("::");
+            PoolPtr free_pool;
+            while ((free_pool = pickFreeAddress(subnet, type, candidate))) {
+                // The lease may have been added by another server sharing
+                // the lease database.
+                if (LeaseMgrFactory::instance().getConstLease6(type, candidate)) {
+                    markAddressUsed(subnet, type, candidate);
+                    continue;
+                }
+
+                uint8_t prefix_len = 128;
+                if (type == Lease::TYPE_PD) {
+                    prefix_len = boost::dynamic_pointer_cast<
+                        Pool6>(free_pool)->getLength();
+                }
+
+                Lease6Ptr lease = createLease6(subnet, duid, iaid, candidate,
+                                               prefix_len, type, fwd_dns_update,
+                                               rev_dns_update, hostname,
+                                               callout_handle, fake_allocation);
+                if (lease) {
+                    old_leases.push_back(ConstLease6Ptr());
+
+                    Lease6Collection collection;
+                    collection.push_back(lease);
+                    return (collection);
+                }
+
+                // Unless we have lost the race for this address, the
+                // allocation was refused (e.g. by the callout), so there is
+                // no point in trying other free addresses.
+                if (!LeaseMgrFactory::instance().getConstLease6(type, candidate)) {
+                    break;
+                }
+                markAddressUsed(subnet, type, candidate);
+            }
+        }
+
+        // The client's hint has been already checked. Instead, pass the
+        // previously picked address to the allocator, so as the hashed
+        // allocator can continue with the address following it.
+        IOAddress previous("::");
         unsigned int i = attempts_;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, duid, hint);
+            IOAddress candidate = allocator->pickAddress(subnet, duid,
+                                                         previous);
+            previous = candidate;
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
@@ -420,8 +606,10 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 prefix_len = pool->getLength();
             }
 
-            Lease6Ptr existing = LeaseMgrFactory::instance().getLease6(type,
-                                 candidate);
+            // Most candidates are only checked, so the lease is not copied
+            // unless it is going to be reused.
+            ConstLease6Ptr existing =
+                LeaseMgrFactory::instance().getConstLease6(type, candidate);
             if (!existing) {
 
                 // there's no existing lease for selected candidate, so it is
@@ -434,7 +622,7 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 if (lease) {
                     // We are allocating a new lease (not renewing). So, the
                     // old lease should be NULL.
-                    old_leases.push_back(Lease6Ptr());
+                    old_leases.push_back(ConstLease6Ptr());
 
                     Lease6Collection collection;
                     collection.push_back(lease);
@@ -446,17 +634,18 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 // allocation attempts.
             } else {
                 if (existing->expired()) {
-                    // Copy an existing, expired lease so as it can be returned
-                    // to the caller.
-                    Lease6Ptr old_lease(new Lease6(*existing));
-                    old_leases.push_back(old_lease);
-
-                    existing = reuseExpiredLease(existing, subnet, duid, iaid,
-                                                 prefix_len, fwd_dns_update,
-                                                 rev_dns_update, hostname,
-                                                 callout_handle, fake_allocation);
+                    // The existing lease is not modified, so it is returned
+                    // to the caller as the old lease. The copy of it is
+                    // reused.
+                    old_leases.push_back(existing);
+
+                    Lease6Ptr lease(new Lease6(*existing));
+                    lease = reuseExpiredLease(lease, subnet, duid, iaid,
+                                              prefix_len, fwd_dns_update,
+                                              rev_dns_update, hostname,
+                                              callout_handle, fake_allocation);
                     Lease6Collection collection;
-                    collection.push_back(existing);
+                    collection.push_back(lease);
                     return (collection);
                 }
             }
@@ -484,7 +673,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                             const bool fwd_dns_update, const bool rev_dns_update,
                             const std::string& hostname, bool fake_allocation,
                             const isc::hooks::CalloutHandlePtr& callout_handle,
-                            Lease4Ptr& old_lease) {
+                            ConstLease4Ptr& old_lease) {
 
     // The NULL pointer indicates that the old lease didn't exist. It may
     // be later set to non NULL value if existing lease is found in the
@@ -510,17 +699,23 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
         }
 
         // Check if there's existing lease for that subnet/clientid/hwaddr combination.
-        Lease4Ptr existing = LeaseMgrFactory::instance().getLease4(*hwaddr, subnet->getID());
+        // The existing lease is not modified, so it is returned as the old
+        // lease and only its copy is renewed.
+        ConstLease4Ptr existing =
+            LeaseMgrFactory::instance().getConstLease4(*hwaddr,
+                                                       subnet->getID());
         if (existing) {
             // Save the old lease, before renewal.
-            old_lease.reset(new Lease4(*existing));
+            old_lease = existing;
             // We have a lease already. This is a returning client, probably after
             // its reboot.
-            existing = renewLease4(subnet, clientid, hwaddr,
-                                   fwd_dns_update, rev_dns_update, hostname,
-                                   existing, callout_handle, fake_allocation);
-            if (existing) {
-                return (existing);
+            Lease4Ptr lease = renewLease4(subnet, clientid, hwaddr,
+                                          fwd_dns_update, rev_dns_update,
+                                          hostname,
+                                          Lease4Ptr(new Lease4(*existing)),
+                                          callout_handle, fake_allocation);
+            if (lease) {
+                return (lease);
             }
 
             // If renewal failed (e.g. the lease no longer matches current configuration)
@@ -528,27 +723,30 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
         }
 
         if (clientid) {
-            existing = LeaseMgrFactory::instance().getLease4(*clientid, subnet->getID());
+            existing =
+                LeaseMgrFactory::instance().getConstLease4(*clientid,
+                                                           subnet->getID());
             if (existing) {
                 // Save the old lease before renewal.
-                old_lease.reset(new Lease4(*existing));
+                old_lease = existing;
                 // we have a lease already. This is a returning client, probably after
                 // its reboot.
-                existing = renewLease4(subnet, clientid, hwaddr,
-                                       fwd_dns_update, rev_dns_update,
-                                       hostname, existing, callout_handle,
-                                       fake_allocation);
+                Lease4Ptr lease = renewLease4(subnet, clientid, hwaddr,
+                                              fwd_dns_update, rev_dns_update,
+                                              hostname,
+                                              Lease4Ptr(new Lease4(*existing)),
+                                              callout_handle, fake_allocation);
                 // @todo: produce a warning. We haven't found him using MAC address, but
                 // we found him using client-id
-                if (existing) {
-                    return (existing);
+                if (lease) {
+                    return (lease);
                 }
             }
         }
 
         // check if the hint is in pool and is available
         if (subnet->inPool(Lease::TYPE_V4, hint)) {
-            existing = LeaseMgrFactory::instance().getLease4(hint);
+            existing = LeaseMgrFactory::instance().getConstLease4(hint);
             if (!existing) {
                 /// @todo: Check if the hint is reserved once we have host support
                 /// implemented
@@ -567,9 +765,10 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 }
             } else {
                 if (existing->expired()) {
-                    // Save the old lease, before reusing it.
-                    old_lease.reset(new Lease4(*existing));
-                    return (reuseExpiredLease(existing, subnet, clientid, hwaddr,
+                    // Save the old lease, before reusing its copy.
+                    old_lease = existing;
+                    Lease4Ptr expired(new Lease4(*existing));
+                    return (reuseExpiredLease(expired, subnet, clientid, hwaddr,
                                               fwd_dns_update, rev_dns_update,
                                               hostname, callout_handle,
                                               fake_allocation));
@@ -594,14 +793,52 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
         // left), but this has one major problem. We exactly control allocation
         // moment, but we currently do not control expiration time at all
 
+        // If the free addresses are tracked, try the addresses known to be
+        // free first. The expired leases are left for the regular search.
+        if (CfgMgr::instance().freeAddressTracking()) {
+            IOAddress candidate("0.0.0.0");
+            while (pickFreeAddress(subnet, Lease::TYPE_V4, candidate)) {
+                // The lease may have been added by another server sharing
+                // the lease database.
+                if (LeaseMgrFactory::instance().getConstLease4(candidate)) {
+                    markAddressUsed(subnet, Lease::TYPE_V4, candidate);
+                    continue;
+                }
+
+                Lease4Ptr lease = createLease4(subnet, clientid, hwaddr,
+                                               candidate, fwd_dns_update,
+                                               rev_dns_update, hostname,
+                                               callout_handle, fake_allocation);
+                if (lease) {
+                    return (lease);
+                }
+
+                // Unless we have lost the race for this address, the
+                // allocation was refused (e.g. by the callout), so there is
+                // no point in trying other free addresses.
+                if (!LeaseMgrFactory::instance().getConstLease4(candidate)) {
+                    break;
+                }
+                markAddressUsed(subnet, Lease::TYPE_V4, candidate);
+            }
+        }
+
+        // The client's hint has been already checked. Instead, pass the
+        // previously picked address to the allocator, so as the hashed
+        // allocator can continue with the address following it.
+        IOAddress previous("0.0.0.0");
         unsigned int i = attempts_;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, clientid, hint);
+            IOAddress candidate = allocator->pickAddress(subnet, clientid,
+                                                         previous);
+            previous = candidate;
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
 
-            Lease4Ptr existing = LeaseMgrFactory::instance().getLease4(candidate);
+            // Most candidates are only checked, so the lease is not copied
+            // unless it is going to be reused.
+            existing = LeaseMgrFactory::instance().getConstLease4(candidate);
             if (!existing) {
                 // there's no existing lease for selected candidate, so it is
                 // free. Let's allocate it.
@@ -618,9 +855,10 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 // allocation attempts.
             } else {
                 if (existing->expired()) {
-                    // Save old lease before reusing it.
-                    old_lease.reset(new Lease4(*existing));
-                    return (reuseExpiredLease(existing, subnet, clientid, hwaddr,
+                    // Save old lease before reusing its copy.
+                    old_lease = existing;
+                    Lease4Ptr expired(new Lease4(*existing));
+                    return (reuseExpiredLease(expired, subnet, clientid, hwaddr,
                                               fwd_dns_update, rev_dns_update,
                                               hostname, callout_handle,
                                               fake_allocation));
@@ -946,7 +1184,7 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
         bool status = LeaseMgrFactory::instance().addLease(lease);
 
         if (status) {
-
+            markAddressUsed(subnet, lease->type_, lease->addr_);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -960,8 +1198,8 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
 
         // It is for advertise only. We should not insert the lease into LeaseMgr,
         // but rather check that we could have inserted it.
-        Lease6Ptr existing = LeaseMgrFactory::instance().getLease6(
-                             Lease::TYPE_NA, addr);
+        ConstLease6Ptr existing = LeaseMgrFactory::instance().getConstLease6(
+                                  Lease::TYPE_NA, addr);
         if (!existing) {
             return (lease);
         } else {
@@ -1042,6 +1280,7 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
         // That is a real (REQUEST) allocation
         bool status = LeaseMgrFactory::instance().addLease(lease);
         if (status) {
+            markAddressUsed(subnet, Lease::TYPE_V4, lease->addr_);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -1055,7 +1294,8 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
 
         // It is for OFFER only. We should not insert the lease into LeaseMgr,
         // but rather check that we could have inserted it.
-        Lease4Ptr existing = LeaseMgrFactory::instance().getLease4(addr);
+        ConstLease4Ptr existing =
+            LeaseMgrFactory::instance().getConstLease4(addr);
         if (!existing) {
             return (lease);
         } else {
@@ -1065,13 +1305,13 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
 }
 
 Lease6Collection
-AllocEngine::updateFqdnData(const Lease6Collection& leases,
+AllocEngine::updateFqdnData(const ConstLease6Collection& leases,
                             const bool fwd_dns_update,
                             const bool rev_dns_update,
                             const std::string& hostname,
                             const bool fake_allocation) {
     Lease6Collection updated_leases;
-    for (Lease6Collection::const_iterator lease_it = leases.begin();
+    for (ConstLease6Collection::const_iterator lease_it = leases.begin();
          lease_it != leases.end(); ++lease_it) {
         Lease6Ptr lease(new Lease6(**lease_it));
         lease->fqdn_fwd_ = fwd_dns_update;
@@ -1088,6 +1328,256 @@ AllocEngine::updateFqdnData(const Lease6Collection& leases,
     return (updated_leases);
 }
 
+size_t
+AllocEngine::reclaimExpiredLeases4(const size_t max_leases,
+                                   const uint32_t timeout) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_RECLAIM_LEASES4_START).arg(max_leases).arg(timeout);
+
+    const ptime start_time = microsec_clock::universal_time();
+    LeaseMgr& lease_mgr = LeaseMgrFactory::instance();
+
+    Lease4Collection leases;
+    lease_mgr.getExpiredLeases4(leases, max_leases);
+
+    size_t reclaimed = 0;
+    for (Lease4Collection::const_iterator lease = leases.begin();
+         lease != leases.end(); ++lease) {
+        // The remaining leases will be reclaimed in the next cycle.
+        const int64_t elapsed = (microsec_clock::universal_time() -
+                              start_time).total_milliseconds();
+        if ((timeout > 0) && (elapsed >= static_cast<int64_t>(timeout))) {
+            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                      DHCPSRV_RECLAIM_LEASES4_TIMEOUT).arg(elapsed);
+            break;
+        }
+
+        try {
+            // The lease may have been renewed by the client or reused by
+            // another client since it was retrieved. Such lease must be
+            // left in the database. The lease is also checked when it is
+            // deleted, because it can be renewed by the packet processed
+            // concurrently after it has been read.
+            Lease4Ptr current = lease_mgr.getLease4((*lease)->addr_);
+            if (!current || !current->expired()) {
+                continue;
+            }
+            if (lease_mgr.deleteExpiredLease(current->addr_)) {
+                leaseRemoved(current);
+                queueRemovalNCR(current);
+                ++reclaimed;
+                LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+                          DHCPSRV_RECLAIM_LEASE4)
+                    .arg(current->addr_.toText());
+            }
+
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_RECLAIM_LEASE4_FAILED)
+                .arg((*lease)->addr_.toText()).arg(ex.what());
+        }
+    }
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_RECLAIM_LEASES4_COMPLETE).arg(reclaimed)
+        .arg((microsec_clock::universal_time() -
+              start_time).total_milliseconds());
+
+    return (reclaimed);
+}
+
+size_t
+AllocEngine::reclaimExpiredLeases6(const size_t max_leases,
+                                   const uint32_t timeout) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_RECLAIM_LEASES6_START).arg(max_leases).arg(timeout);
+
+    const ptime start_time = microsec_clock::universal_time();
+    LeaseMgr& lease_mgr = LeaseMgrFactory::instance();
+
+    Lease6Collection leases;
+    lease_mgr.getExpiredLeases6(leases, max_leases);
+
+    size_t reclaimed = 0;
+    for (Lease6Collection::const_iterator lease = leases.begin();
+         lease != leases.end(); ++lease) {
+        // The remaining leases will be reclaimed in the next cycle.
+        const int64_t elapsed = (microsec_clock::universal_time() -
+                              start_time).total_milliseconds();
+        if ((timeout > 0) && (elapsed >= static_cast<int64_t>(timeout))) {
+            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                      DHCPSRV_RECLAIM_LEASES6_TIMEOUT).arg(elapsed);
+            break;
+        }
+
+        try {
+            // The lease may have been renewed by the client or reused by
+            // another client since it was retrieved. Such lease must be
+            // left in the database. The lease is also checked when it is
+            // deleted, because it can be renewed by the packet processed
+            // concurrently after it has been read.
+            Lease6Ptr current = lease_mgr.getLease6((*lease)->type_,
+                                                    (*lease)->addr_);
+            if (!current || !current->expired()) {
+                continue;
+            }
+            if (lease_mgr.deleteExpiredLease(current->addr_)) {
+                leaseRemoved(current);
+                queueRemovalNCR(current);
+                ++reclaimed;
+                LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+                          DHCPSRV_RECLAIM_LEASE6)
+                    .arg(current->addr_.toText());
+            }
+
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_RECLAIM_LEASE6_FAILED)
+                .arg((*lease)->addr_.toText()).arg(ex.what());
+        }
+    }
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_RECLAIM_LEASES6_COMPLETE).arg(reclaimed)
+        .arg((microsec_clock::universal_time() -
+              start_time).total_milliseconds());
+
+    return (reclaimed);
+}
+
+void
+AllocEngine::leaseRemoved(const Lease4Ptr& lease) {
+    if (!CfgMgr::instance().freeAddressTracking()) {
+        return;
+    }
+
+    const Subnet4Collection* subnets = CfgMgr::instance().getSubnets4();
+    for (Subnet4Collection::const_iterator subnet = subnets->begin();
+         subnet != subnets->end(); ++subnet) {
+        if ((*subnet)->getID() == lease->subnet_id_) {
+            markAddressFree(*subnet, Lease::TYPE_V4, lease->addr_);
+            return;
+        }
+    }
+}
+
+void
+AllocEngine::leaseRemoved(const Lease6Ptr& lease) {
+    if (!CfgMgr::instance().freeAddressTracking()) {
+        return;
+    }
+
+    const Subnet6Collection* subnets = CfgMgr::instance().getSubnets6();
+    for (Subnet6Collection::const_iterator subnet = subnets->begin();
+         subnet != subnets->end(); ++subnet) {
+        if ((*subnet)->getID() == lease->subnet_id_) {
+            markAddressFree(*subnet, lease->type_, lease->addr_);
+            return;
+        }
+    }
+}
+
+PoolPtr
+AllocEngine::pickFreeAddress(const SubnetPtr& subnet, const Lease::Type type,
+                             IOAddress& address) {
+    isc::util::thread::Mutex::Locker lock(free_addresses_mutex_);
+
+    const PoolCollection& pools = subnet->getPools(type);
+
+    // Create the bitmaps for the pools which haven't been tracked yet. The
+    // bitmaps are attached to the pools after they have been populated with
+    // the leases, so as a database error doesn't leave empty bitmaps behind.
+    std::vector<std::pair<PoolPtr, FreeAddressBitmapPtr> > untracked;
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        if ((*pool)->getFreeAddresses()) {
+            continue;
+        }
+        uint8_t prefix_len = 128;
+        if (type == Lease::TYPE_PD) {
+            prefix_len = boost::dynamic_pointer_cast<Pool6>(*pool)->getLength();
+        }
+        if (FreeAddressBitmap::canTrack((*pool)->getFirstAddress(),
+                                        (*pool)->getLastAddress(),
+                                        prefix_len)) {
+            FreeAddressBitmapPtr bitmap(new FreeAddressBitmap(
+                (*pool)->getFirstAddress(), (*pool)->getLastAddress(),
+                prefix_len));
+            untracked.push_back(std::make_pair(*pool, bitmap));
+        }
+    }
+
+    if (!untracked.empty()) {
+        std::vector<IOAddress> used;
+        if (type == Lease::TYPE_V4) {
+            Lease4Collection leases =
+                LeaseMgrFactory::instance().getLeases4(subnet->getID());
+            for (Lease4Collection::const_iterator lease = leases.begin();
+                 lease != leases.end(); ++lease) {
+                used.push_back((*lease)->addr_);
+            }
+
+        } else {
+            Lease6Collection leases =
+                LeaseMgrFactory::instance().getLeases6(subnet->getID());
+            for (Lease6Collection::const_iterator lease = leases.begin();
+                 lease != leases.end(); ++lease) {
+                if ((*lease)->type_ == type) {
+                    used.push_back((*lease)->addr_);
+                }
+            }
+        }
+
+        for (std::vector<IOAddress>::const_iterator addr = used.begin();
+             addr != used.end(); ++addr) {
+            for (size_t i = 0; i < untracked.size(); ++i) {
+                if (untracked[i].first->inRange(*addr)) {
+                    untracked[i].second->markUsed(*addr);
+                    break;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < untracked.size(); ++i) {
+            untracked[i].first->setFreeAddresses(untracked[i].second);
+        }
+    }
+
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        FreeAddressBitmapPtr bitmap = (*pool)->getFreeAddresses();
+        if (bitmap && (bitmap->getFreeCount() > 0)) {
+            address = bitmap->pickFree();
+            return (*pool);
+        }
+    }
+    return (PoolPtr());
+}
+
+void
+AllocEngine::markAddressUsed(const SubnetPtr& subnet, const Lease::Type type,
+                             const IOAddress& address) {
+    PoolPtr pool = subnet->getPool(type, address, false);
+    if (pool) {
+        isc::util::thread::Mutex::Locker lock(free_addresses_mutex_);
+        FreeAddressBitmapPtr bitmap = pool->getFreeAddresses();
+        if (bitmap) {
+            bitmap->markUsed(address);
+        }
+    }
+}
+
+void
+AllocEngine::markAddressFree(const SubnetPtr& subnet, const Lease::Type type,
+                             const IOAddress& address) {
+    PoolPtr pool = subnet->getPool(type, address, false);
+    if (pool) {
+        isc::util::thread::Mutex::Locker lock(free_addresses_mutex_);
+        FreeAddressBitmapPtr bitmap = pool->getFreeAddresses();
+        if (bitmap) {
+            bitmap->markFree(address);
+        }
+    }
+}
+
 AllocEngine::AllocatorPtr AllocEngine::getAllocator(Lease::Type type) {
     std::map<Lease::Type, AllocatorPtr>::const_iterator alloc = allocators_.find(type);
 
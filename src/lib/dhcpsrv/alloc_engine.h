@@ -21,9 +21,11 @@
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <hooks/callout_handle.h>
+#include <util/threads/sync.h>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/random/mersenne_twister.hpp>
 
 #include <map>
 
@@ -100,6 +102,47 @@ protected:
         }
     protected:
 
+        /// @brief Returns the number of addresses (prefixes) in all pools
+        ///
+        /// If the sum doesn't fit in 64 bits, the maximum value of the
+        /// uint64_t is returned.
+        ///
+        /// @param pools collection of pools
+        /// @return total number of addresses (prefixes) in the pools
+        static uint64_t getTotalCapacity(const PoolCollection& pools);
+
+        /// @brief Returns the address (prefix) at the given offset in pools
+        ///
+        /// The pools are treated as a single contiguous range of addresses,
+        /// in the order in which they appear in the collection.
+        ///
+        /// @param pools collection of pools
+        /// @param offset offset of the address within the pools, which must
+        /// be lower than the total capacity of the pools
+        /// @return selected address (prefix)
+        isc::asiolink::IOAddress
+        getAddressAtOffset(const PoolCollection& pools, uint64_t offset) const;
+
+        /// @brief Returns the address (prefix) following the specified one
+        ///
+        /// If the address is the last one in its pool, the first address of
+        /// the next pool is returned. The search wraps around after the last
+        /// pool.
+        ///
+        /// @param pools collection of pools
+        /// @param addr the address (prefix) within one of the pools
+        /// @return the next address (prefix) or the address of the first
+        /// pool if the address doesn't belong to any of the pools
+        isc::asiolink::IOAddress
+        getNextAddress(const PoolCollection& pools,
+                       const isc::asiolink::IOAddress& addr) const;
+
+        /// @brief Returns the length of the prefixes delegated from the pool
+        ///
+        /// @param pool the pool
+        /// @return delegated length for the prefix pools, 128 otherwise
+        uint8_t getPrefixLength(const PoolPtr& pool) const;
+
         /// @brief defines pool type allocation
         Lease::Type pool_type_;
     };
@@ -128,6 +171,10 @@ protected:
         /// @param duid Client's DUID (ignored)
         /// @param hint client's hint (ignored)
         /// @return the next address
+        ///
+        /// @note This method may be called by multiple packet processing
+        /// threads. The last allocated address stored in the subnet is
+        /// read and updated under the allocator's mutex.
         virtual isc::asiolink::IOAddress
             pickAddress(const SubnetPtr& subnet,
                         const DuidPtr& duid,
@@ -157,45 +204,79 @@ protected:
         static isc::asiolink::IOAddress
         increasePrefix(const isc::asiolink::IOAddress& prefix,
                        const uint8_t prefix_len);
+
+    private:
+
+        /// @brief Mutex serializing the calls to pickAddress.
+        isc::util::thread::Mutex mutex_;
     };
 
     /// @brief Address/prefix allocator that gets an address based on a hash
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// This allocator computes a hash of the client's DUID (client identifier
+    /// for DHCPv4) and uses it as an offset within the subnet's pools. The
+    /// client is therefore offered the same address on the first attempt
+    /// every time it asks for one, as long as the pools are unchanged.
+    /// When this address is in use, the engine calls the allocator again
+    /// with the previously returned address as a hint and the allocator
+    /// returns the following address (linear probing).
+    ///
+    /// DHCPv4 clients which don't send a client identifier are given
+    /// a random address.
     class HashedAllocator : public Allocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief default constructor
         /// @param type - specifies allocation type
         HashedAllocator(Lease::Type type);
 
         /// @brief returns an address based on hash calculated from client's DUID.
         ///
-        /// @todo: Implement this method
-        ///
         /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID
-        /// @param hint a hint (last address that was picked)
+        /// @param hint the address that was picked previously for this client
+        /// within the current allocation. If it doesn't belong to any of the
+        /// pools, the address is computed from the DUID.
         /// @return selected address
         virtual isc::asiolink::IOAddress pickAddress(const SubnetPtr& subnet,
                                                      const DuidPtr& duid,
                                                      const isc::asiolink::IOAddress& hint);
+
+        /// @brief Computes the hash of the client identifier
+        ///
+        /// The 64-bit FNV-1a hash is used because it is fast for the short
+        /// identifiers and spreads them well across the pools.
+        ///
+        /// @param duid Client's DUID or client identifier
+        /// @return hash value
+        static uint64_t hash(const DUID& duid);
+
+    private:
+
+        /// @brief Random number generator used for clients without DUID.
+        boost::mt19937 generator_;
+
+        /// @brief Mutex protecting the random number generator.
+        isc::util::thread::Mutex mutex_;
     };
 
     /// @brief Random allocator that picks address randomly
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// The addresses are picked uniformly across all pools of the subnet.
+    /// Compared to the @c IterativeAllocator, concurrent allocations rarely
+    /// try the same address and the number of attempts doesn't grow with
+    /// the length of the sequence of used addresses in the pool.
     class RandomAllocator : public Allocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief default constructor
+        ///
+        /// Seeds the random number generator with the current time.
         /// @param type - specifies allocation type
         RandomAllocator(Lease::Type type);
 
         /// @brief returns an random address from pool of specified subnet
         ///
-        /// @todo: Implement this method
-        ///
         /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID (ignored)
         /// @param hint the last address that was picked (ignored)
@@ -203,6 +284,14 @@ protected:
         virtual isc::asiolink::IOAddress
         pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
                     const isc::asiolink::IOAddress& hint);
+
+    private:
+
+        /// @brief Random number generator.
+        boost::mt19937 generator_;
+
+        /// @brief Mutex protecting the random number generator.
+        isc::util::thread::Mutex mutex_;
     };
 
     public:
@@ -281,7 +370,7 @@ protected:
                    const bool fwd_dns_update, const bool rev_dns_update,
                    const std::string& hostname, bool fake_allocation,
                    const isc::hooks::CalloutHandlePtr& callout_handle,
-                   Lease4Ptr& old_lease);
+                   ConstLease4Ptr& old_lease);
 
     /// @brief Renews a IPv4 lease
     ///
@@ -352,7 +441,61 @@ protected:
                     const bool fwd_dns_update, const bool rev_dns_update,
                     const std::string& hostname, bool fake_allocation,
                     const isc::hooks::CalloutHandlePtr& callout_handle,
-                    Lease6Collection& old_leases);
+                    ConstLease6Collection& old_leases);
+
+    /// @brief Reclaims expired IPv4 leases.
+    ///
+    /// This method retrieves a batch of expired leases from the lease
+    /// database, starting from the leases which expired first, and removes
+    /// them from the database, so as the addresses can be allocated to other
+    /// clients. If the DNS updates have been performed for the reclaimed
+    /// lease, the request to remove the DNS records is sent to the
+    /// DHCP-DDNS server. The leases which have been renewed since they were
+    /// retrieved from the database are not reclaimed.
+    ///
+    /// The reclamation is limited by the number of leases and by the time,
+    /// so as the server doesn't stop responding to the clients when there
+    /// are many expired leases. The remaining leases are reclaimed when this
+    /// method is called again.
+    ///
+    /// @param max_leases Maximum number of leases to be reclaimed. The value
+    ///        of 0 means that all expired leases are reclaimed.
+    /// @param timeout Maximum amount of time in milliseconds the reclamation
+    ///        may take. The value of 0 means no limit.
+    ///
+    /// @return Number of leases reclaimed.
+    size_t reclaimExpiredLeases4(const size_t max_leases,
+                                 const uint32_t timeout);
+
+    /// @brief Reclaims expired IPv6 leases.
+    ///
+    /// This is a counterpart of @c reclaimExpiredLeases4 for the IPv6
+    /// leases, including the delegated prefixes.
+    ///
+    /// @param max_leases Maximum number of leases to be reclaimed. The value
+    ///        of 0 means that all expired leases are reclaimed.
+    /// @param timeout Maximum amount of time in milliseconds the reclamation
+    ///        may take. The value of 0 means no limit.
+    ///
+    /// @return Number of leases reclaimed.
+    size_t reclaimExpiredLeases6(const size_t max_leases,
+                                 const uint32_t timeout);
+
+    /// @brief Marks the address of the removed IPv4 lease free.
+    ///
+    /// This method must be called when a lease is deleted from the lease
+    /// database outside of the allocation engine, e.g. when the client
+    /// releases it, so as the address can be allocated again when the
+    /// free address tracking is enabled. It is a no-op if the address
+    /// doesn't belong to any pool with tracked free addresses.
+    ///
+    /// @param lease Removed lease.
+    void leaseRemoved(const Lease4Ptr& lease);
+
+    /// @brief Marks the address or prefix of the removed IPv6 lease free.
+    ///
+    /// @param lease Removed lease.
+    void leaseRemoved(const Lease6Ptr& lease);
 
     /// @brief returns allocator for a given pool type
     /// @param type type of pool (V4, IA, TA or PD)
@@ -364,6 +507,37 @@ protected:
     virtual ~AllocEngine();
 private:
 
+    /// @brief Picks a free address using the bitmaps of free addresses.
+    ///
+    /// The bitmaps are created for the pools of the subnet on first use,
+    /// using the leases stored in the lease database. The pools which are
+    /// too large to be tracked are ignored.
+    ///
+    /// @param subnet Subnet the address is allocated from.
+    /// @param type Lease type.
+    /// @param [out] address Free address (prefix).
+    ///
+    /// @return pointer to the pool the address belongs to or NULL if there
+    /// are no free addresses in the tracked pools.
+    PoolPtr pickFreeAddress(const SubnetPtr& subnet, const Lease::Type type,
+                            isc::asiolink::IOAddress& address);
+
+    /// @brief Marks the address used in the bitmap of free addresses.
+    ///
+    /// @param subnet Subnet the address belongs to.
+    /// @param type Lease type.
+    /// @param address Allocated address (prefix).
+    void markAddressUsed(const SubnetPtr& subnet, const Lease::Type type,
+                         const isc::asiolink::IOAddress& address);
+
+    /// @brief Marks the address free in the bitmap of free addresses.
+    ///
+    /// @param subnet Subnet the address belongs to.
+    /// @param type Lease type.
+    /// @param address Released address (prefix).
+    void markAddressFree(const SubnetPtr& subnet, const Lease::Type type,
+                         const isc::asiolink::IOAddress& address);
+
     /// @brief Creates a lease and inserts it in LeaseMgr if necessary
     ///
     /// Creates a lease based on specified parameters and tries to insert it
@@ -512,7 +686,7 @@ private:
     ///
     /// @return Collection of leases with updated FQDN data. Note that returned
     /// collection holds updated FQDN data even for fake allocation.
-    Lease6Collection updateFqdnData(const Lease6Collection& leases,
+    Lease6Collection updateFqdnData(const ConstLease6Collection& leases,
                                     const bool fwd_dns_update,
                                     const bool rev_dns_update,
                                     const std::string& hostname,
@@ -530,6 +704,9 @@ private:
     // hook name indexes (used in hooks callouts)
     int hook_index_lease4_select_; ///< index for lease4_select hook
     int hook_index_lease6_select_; ///< index for lease6_select hook
+
+    /// @brief Mutex protecting the bitmaps of free addresses.
+    isc::util::thread::Mutex free_addresses_mutex_;
 };
 
 }; // namespace isc::dhcp
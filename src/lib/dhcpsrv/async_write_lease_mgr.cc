@@ -0,0 +1,360 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/async_write_lease_mgr.h>
+#include <dhcpsrv/dhcpsrv_log.h>
+
+#include <boost/bind.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sstream>
+
+using namespace isc::asiolink;
+using namespace isc::util::thread;
+
+namespace isc {
+namespace dhcp {
+
+AsyncWriteLeaseMgr::AsyncWriteLeaseMgr(const ParameterMap& parameters,
+                                       LeaseMgr* backend, bool async_lookups)
+    : LeaseMgr(parameters), backend_(backend), async_lookups_(async_lookups),
+      stop_(false), dead_(false) {
+    thread_.reset(new Thread(boost::bind(&AsyncWriteLeaseMgr::run, this)));
+}
+
+AsyncWriteLeaseMgr::~AsyncWriteLeaseMgr() {
+    {
+        Mutex::Locker lock(mutex_);
+        stop_ = true;
+        try {
+            queued_ready_.markReady();
+        } catch (...) {
+            // The thread notices the broken descriptor and stops anyway.
+        }
+    }
+    try {
+        thread_->wait();
+    } catch (...) {
+        // The thread doesn't throw, and we can't throw here anyway.
+    }
+    thread_.reset();
+}
+
+bool
+AsyncWriteLeaseMgr::addLease(const Lease4Ptr& lease) {
+    Request request(Request::ADD_LEASE);
+    request.lease4_ = lease;
+    perform(request);
+    return (request.result_);
+}
+
+bool
+AsyncWriteLeaseMgr::addLease(const Lease6Ptr& lease) {
+    Request request(Request::ADD_LEASE);
+    request.lease6_ = lease;
+    perform(request);
+    return (request.result_);
+}
+
+void
+AsyncWriteLeaseMgr::updateLease4(const Lease4Ptr& lease4) {
+    Request request(Request::UPDATE_LEASE);
+    request.lease4_ = lease4;
+    perform(request);
+    if (!request.result_) {
+        isc_throw(NoSuchLease, "unable to update lease for address " <<
+                  lease4->addr_ << " as it does not exist");
+    }
+}
+
+void
+AsyncWriteLeaseMgr::updateLease6(const Lease6Ptr& lease6) {
+    Request request(Request::UPDATE_LEASE);
+    request.lease6_ = lease6;
+    perform(request);
+    if (!request.result_) {
+        isc_throw(NoSuchLease, "unable to update lease for address " <<
+                  lease6->addr_ << " as it does not exist");
+    }
+}
+
+bool
+AsyncWriteLeaseMgr::deleteLease(const IOAddress& addr) {
+    Request request(Request::DELETE_LEASE);
+    request.addr_ = addr;
+    perform(request);
+    return (request.result_);
+}
+
+Lease4Ptr
+AsyncWriteLeaseMgr::getLease4(const IOAddress& addr) const {
+    if (!async_lookups_) {
+        return (backend_->getLease4(addr));
+    }
+    Request request(Request::GET_LEASE4_ADDR);
+    request.addr_ = addr;
+    perform(request);
+    return (request.lease4_);
+}
+
+Lease4Ptr
+AsyncWriteLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
+    if (!async_lookups_) {
+        return (backend_->getLease4(hwaddr, subnet_id));
+    }
+    Request request(Request::GET_LEASE4_HWADDR);
+    request.hwaddr_ = &hwaddr;
+    request.subnet_id_ = subnet_id;
+    perform(request);
+    return (request.lease4_);
+}
+
+Lease4Ptr
+AsyncWriteLeaseMgr::getLease4(const ClientId& clientid,
+                              SubnetID subnet_id) const {
+    if (!async_lookups_) {
+        return (backend_->getLease4(clientid, subnet_id));
+    }
+    Request request(Request::GET_LEASE4_CLIENTID);
+    request.clientid_ = &clientid;
+    request.subnet_id_ = subnet_id;
+    perform(request);
+    return (request.lease4_);
+}
+
+Lease6Ptr
+AsyncWriteLeaseMgr::getLease6(Lease::Type type, const IOAddress& addr) const {
+    if (!async_lookups_) {
+        return (backend_->getLease6(type, addr));
+    }
+    Request request(Request::GET_LEASE6_ADDR);
+    request.lease_type_ = type;
+    request.addr_ = addr;
+    perform(request);
+    return (request.lease6_);
+}
+
+std::string
+AsyncWriteLeaseMgr::getDescription() const {
+    std::ostringstream s;
+    s << backend_->getDescription() << " written"
+      << (async_lookups_ ? " and read" : "") << " asynchronously";
+    return (s.str());
+}
+
+void
+AsyncWriteLeaseMgr::perform(Request& request) const {
+    {
+        Mutex::Locker lock(mutex_);
+        if (dead_) {
+            isc_throw(DbOperationError, "the thread performing the lease"
+                      " database operations has terminated");
+        }
+        // The descriptor is cleared by the thread when it takes the queued
+        // operations, so it only needs to be marked for the first one.
+        if (queued_.empty()) {
+            queued_ready_.markReady();
+        }
+        queued_.push_back(&request);
+        while (!request.done_) {
+            completed_.wait(mutex_);
+        }
+    }
+
+    if (!request.error_.empty()) {
+        isc_throw(DbOperationError, request.error_);
+    }
+}
+
+void
+AsyncWriteLeaseMgr::run() {
+    // Signals are handled by the main thread of the server.
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    for (;;) {
+        std::deque<Request*> requests;
+        try {
+            Mutex::Locker lock(mutex_);
+            requests.swap(queued_);
+            queued_ready_.clearReady();
+            if (requests.empty() && stop_ &&
+                (backend_->getAsyncPendingCount() == 0)) {
+                return;
+            }
+
+        } catch (const std::exception& ex) {
+            // The descriptor is broken, so nothing can be queued anymore.
+            // Fail the taken operations and those queued in the meantime,
+            // and make the subsequent operations fail rather than wait.
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_ASYNC_WRITE_FAILED)
+                .arg(ex.what());
+            {
+                Mutex::Locker lock(mutex_);
+                dead_ = true;
+                requests.insert(requests.end(), queued_.begin(),
+                                queued_.end());
+                queued_.clear();
+                for (std::deque<Request*>::const_iterator request =
+                         requests.begin(); request != requests.end();
+                     ++request) {
+                    (*request)->error_ = ex.what();
+                    (*request)->done_ = true;
+                }
+                completed_.broadcast();
+            }
+
+            // The operations in flight are completed by the backend.
+            while (backend_->getAsyncPendingCount() > 0) {
+                waitForResults();
+            }
+            return;
+        }
+
+        for (std::deque<Request*>::const_iterator request =
+                 requests.begin(); request != requests.end(); ++request) {
+            start(*request);
+        }
+        waitForResults();
+    }
+}
+
+void
+AsyncWriteLeaseMgr::start(Request* request) {
+    const LeaseMgr::ResultCallback callback =
+        boost::bind(&AsyncWriteLeaseMgr::complete, this, request, _1, _2);
+    const LeaseMgr::Lease4Callback lease4_callback =
+        boost::bind(&AsyncWriteLeaseMgr::completeLease4, this, request, _1, _2);
+    const LeaseMgr::Lease6Callback lease6_callback =
+        boost::bind(&AsyncWriteLeaseMgr::completeLease6, this, request, _1, _2);
+    try {
+        switch (request->type_) {
+        case Request::ADD_LEASE:
+            if (request->lease4_) {
+                backend_->asyncAddLease(request->lease4_, callback);
+            } else {
+                backend_->asyncAddLease(request->lease6_, callback);
+            }
+            break;
+
+        case Request::UPDATE_LEASE:
+            if (request->lease4_) {
+                backend_->asyncUpdateLease4(request->lease4_, callback);
+            } else {
+                backend_->asyncUpdateLease6(request->lease6_, callback);
+            }
+            break;
+
+        case Request::DELETE_LEASE:
+            backend_->asyncDeleteLease(request->addr_, callback);
+            break;
+
+        case Request::GET_LEASE4_ADDR:
+            backend_->asyncGetLease4(request->addr_, lease4_callback);
+            break;
+
+        case Request::GET_LEASE4_HWADDR:
+            backend_->asyncGetLease4(*request->hwaddr_, request->subnet_id_,
+                                     lease4_callback);
+            break;
+
+        case Request::GET_LEASE4_CLIENTID:
+            backend_->asyncGetLease4(*request->clientid_, request->subnet_id_,
+                                     lease4_callback);
+            break;
+
+        case Request::GET_LEASE6_ADDR:
+            backend_->asyncGetLease6(request->lease_type_, request->addr_,
+                                     lease6_callback);
+            break;
+        }
+
+    } catch (const std::exception& ex) {
+        // The operation hasn't been started, e.g. the connection to the
+        // database couldn't be opened.
+        complete(request, false, ex.what());
+    }
+}
+
+void
+AsyncWriteLeaseMgr::waitForResults() {
+    // The dead_ flag is only set by this thread, so it may be read
+    // without locking the mutex.
+    struct pollfd fds[2];
+    fds[0].fd = dead_ ? -1 : queued_ready_.getSelectFd();
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = -1;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    try {
+        // The descriptor of the backend is ignored by poll when negative,
+        // e.g. if the backend completes the operations before returning.
+        if (backend_->getAsyncPendingCount() > 0) {
+            fds[1].fd = backend_->getAsyncSocket();
+        }
+        if (poll(fds, 2, -1) < 0) {
+            if (errno != EINTR) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_ASYNC_WRITE_FAILED)
+                    .arg(strerror(errno));
+            }
+            return;
+        }
+        if (fds[1].revents != 0) {
+            backend_->processAsyncResults();
+        }
+
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_ASYNC_WRITE_FAILED).arg(ex.what());
+    }
+}
+
+void
+AsyncWriteLeaseMgr::complete(Request* request, bool result,
+                             const std::string& error) {
+    Mutex::Locker lock(mutex_);
+    request->result_ = result;
+    request->error_ = error;
+    request->done_ = true;
+    completed_.broadcast();
+}
+
+void
+AsyncWriteLeaseMgr::completeLease4(Request* request, const Lease4Ptr& lease,
+                                   const std::string& error) {
+    Mutex::Locker lock(mutex_);
+    request->lease4_ = lease;
+    request->error_ = error;
+    request->done_ = true;
+    completed_.broadcast();
+}
+
+void
+AsyncWriteLeaseMgr::completeLease6(Request* request, const Lease6Ptr& lease,
+                                   const std::string& error) {
+    Mutex::Locker lock(mutex_);
+    request->lease6_ = lease;
+    request->error_ = error;
+    request->done_ = true;
+    completed_.broadcast();
+}
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
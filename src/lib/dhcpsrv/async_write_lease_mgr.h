@@ -0,0 +1,386 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ASYNC_WRITE_LEASE_MGR_H
+#define ASYNC_WRITE_LEASE_MGR_H
+
+#include <dhcp_ddns/watch_socket.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <deque>
+#include <string>
+#include <utility>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Lease manager writing (and optionally looking up) the leases
+/// through the asynchronous operations of another lease manager.
+///
+/// The server threads process the packets with the synchronous lease
+/// operations: each of them waits for its write to complete before it
+/// sends the response. The SQL backends can have more operations in flight
+/// when they are started with the asynchronous API (the PostgreSQL backend
+/// pipelines them, the MySQL backend commits them in groups), but this API
+/// must be used from a single thread.
+///
+/// This lease manager owns the thread which uses the asynchronous API of
+/// the backend lease manager:
+/// - the added, updated and deleted leases are handed over to this thread,
+///   which starts the asynchronous operation and collects its result. The
+///   calling thread waits for the result and returns it the same way as
+///   the synchronous operation of the backend does, so the writes of all
+///   server threads are in flight at the same time,
+/// - if enabled by the constructor, the lookups used on the allocation
+///   path (the IPv4 lease by address, by hardware address and subnet and
+///   by client identifier and subnet, the IPv6 lease by address) are
+///   handed over to the thread the same way. This is only useful if the
+///   backend pipelines the lookups (PostgreSQL), as the backends which
+///   run them synchronously would serialize them in the thread,
+/// - all other calls are forwarded to the backend synchronously.
+///
+/// The asynchronous API of this lease manager is implemented by the
+/// @c LeaseMgr in terms of the synchronous operations, because the backend
+/// API is already used by the thread of this lease manager.
+class AsyncWriteLeaseMgr : public LeaseMgr {
+public:
+
+    /// @brief Constructor
+    ///
+    /// Starts the thread writing the leases.
+    ///
+    /// @param parameters A data structure relating keywords and values
+    ///        concerned with the database.
+    /// @param backend Lease manager holding the leases. This lease manager
+    ///        takes the ownership of it and destroys it along with itself.
+    /// @param async_lookups Indicates if the lookups on the allocation path
+    ///        use the asynchronous API of the backend too.
+    AsyncWriteLeaseMgr(const ParameterMap& parameters, LeaseMgr* backend,
+                       bool async_lookups = false);
+
+    /// @brief Destructor
+    ///
+    /// Waits for the outstanding writes, stops the thread and destroys
+    /// the backend lease manager.
+    virtual ~AsyncWriteLeaseMgr();
+
+    /// @brief Adds an IPv4 lease asynchronously and waits for the result.
+    ///
+    /// @param lease lease to be added
+    ///
+    /// @return true if the lease has been added, false if it already exists.
+    /// @throw isc::dhcp::DbOperationError if the operation has failed.
+    virtual bool addLease(const Lease4Ptr& lease);
+
+    /// @brief Adds an IPv6 lease asynchronously and waits for the result.
+    ///
+    /// @param lease lease to be added
+    ///
+    /// @return true if the lease has been added, false if it already exists.
+    /// @throw isc::dhcp::DbOperationError if the operation has failed.
+    virtual bool addLease(const Lease6Ptr& lease);
+
+    /// @brief Returns an IPv4 lease for the specified address.
+    ///
+    /// The lookup uses the asynchronous API of the backend if enabled.
+    ///
+    /// @param addr address of the searched lease
+    ///
+    /// @return smart pointer to the lease (or NULL if a lease is not found)
+    /// @throw isc::dhcp::DbOperationError if the lookup has failed.
+    virtual Lease4Ptr getLease4(const isc::asiolink::IOAddress& addr) const;
+
+    virtual Lease4Collection getLease4(const isc::dhcp::HWAddr& hwaddr) const {
+        return (backend_->getLease4(hwaddr));
+    }
+
+    /// @brief Returns an IPv4 lease for the specified hardware address
+    /// and subnet.
+    ///
+    /// The lookup uses the asynchronous API of the backend if enabled.
+    ///
+    /// @param hwaddr hardware address of the client
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    ///
+    /// @return a pointer to the lease (or NULL if a lease is not found)
+    /// @throw isc::dhcp::DbOperationError if the lookup has failed.
+    virtual Lease4Ptr getLease4(const HWAddr& hwaddr,
+                                SubnetID subnet_id) const;
+
+    virtual Lease4Collection getLease4(const ClientId& client_id) const {
+        return (backend_->getLease4(client_id));
+    }
+
+    virtual Lease4Ptr getLease4(const ClientId& clientid,
+                                const HWAddr& hwaddr,
+                                SubnetID subnet_id) const {
+        return (backend_->getLease4(clientid, hwaddr, subnet_id));
+    }
+
+    /// @brief Returns an IPv4 lease for the specified client identifier
+    /// and subnet.
+    ///
+    /// The lookup uses the asynchronous API of the backend if enabled.
+    ///
+    /// @param clientid client identifier
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    ///
+    /// @return a pointer to the lease (or NULL if a lease is not found)
+    /// @throw isc::dhcp::DbOperationError if the lookup has failed.
+    virtual Lease4Ptr getLease4(const ClientId& clientid,
+                                SubnetID subnet_id) const;
+
+    virtual Lease4Collection getLeases4(SubnetID subnet_id) const {
+        return (backend_->getLeases4(subnet_id));
+    }
+
+    /// @brief Returns an IPv6 lease for the specified address.
+    ///
+    /// The lookup uses the asynchronous API of the backend if enabled.
+    ///
+    /// @param type type of the lease
+    /// @param addr address of the searched lease
+    ///
+    /// @return smart pointer to the lease (or NULL if a lease is not found)
+    /// @throw isc::dhcp::DbOperationError if the lookup has failed.
+    virtual Lease6Ptr getLease6(Lease::Type type,
+                                const isc::asiolink::IOAddress& addr) const;
+
+    virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
+                                        uint32_t iaid) const {
+        return (backend_->getLeases6(type, duid, iaid));
+    }
+
+    virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
+                                        uint32_t iaid,
+                                        SubnetID subnet_id) const {
+        return (backend_->getLeases6(type, duid, iaid, subnet_id));
+    }
+
+    virtual Lease6Collection getLeases6(SubnetID subnet_id) const {
+        return (backend_->getLeases6(subnet_id));
+    }
+
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const {
+        backend_->getExpiredLeases4(expired_leases, max_leases);
+    }
+
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const {
+        backend_->getExpiredLeases6(expired_leases, max_leases);
+    }
+
+    /// @brief Updates an IPv4 lease asynchronously and waits for the
+    /// result.
+    ///
+    /// @param lease4 The lease to be updated.
+    ///
+    /// @throw isc::dhcp::NoSuchLease if the lease doesn't exist.
+    /// @throw isc::dhcp::DbOperationError if the operation has failed.
+    virtual void updateLease4(const Lease4Ptr& lease4);
+
+    /// @brief Updates an IPv6 lease asynchronously and waits for the
+    /// result.
+    ///
+    /// @param lease6 The lease to be updated.
+    ///
+    /// @throw isc::dhcp::NoSuchLease if the lease doesn't exist.
+    /// @throw isc::dhcp::DbOperationError if the operation has failed.
+    virtual void updateLease6(const Lease6Ptr& lease6);
+
+    /// @brief Deletes a lease asynchronously and waits for the result.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    ///
+    /// @return true if the lease has been deleted, false if it doesn't
+    ///         exist.
+    /// @throw isc::dhcp::DbOperationError if the operation has failed.
+    virtual bool deleteLease(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Deletes a lease if it has expired.
+    ///
+    /// There is no asynchronous variant of this operation, so it is
+    /// forwarded to the backend synchronously.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    virtual bool deleteExpiredLease(const isc::asiolink::IOAddress& addr) {
+        return (backend_->deleteExpiredLease(addr));
+    }
+
+    /// @brief Returns the type of the backend.
+    virtual std::string getType() const {
+        return (backend_->getType());
+    }
+
+    /// @brief Returns the name of the backend.
+    virtual std::string getName() const {
+        return (backend_->getName());
+    }
+
+    /// @brief Returns the description of the backend.
+    virtual std::string getDescription() const;
+
+    /// @brief Returns the version of the backend.
+    virtual std::pair<uint32_t, uint32_t> getVersion() const {
+        return (backend_->getVersion());
+    }
+
+    /// @brief Commits the transactions of the backend.
+    virtual void commit() {
+        backend_->commit();
+    }
+
+    /// @brief Rolls back the transactions of the backend.
+    virtual void rollback() {
+        backend_->rollback();
+    }
+
+    /// @brief Returns the backend lease manager.
+    LeaseMgr& getBackend() const {
+        return (*backend_);
+    }
+
+private:
+
+    /// @brief Operation handed over to the thread of the lease manager.
+    ///
+    /// The request lives on the stack of the calling thread, which waits
+    /// until it is completed.
+    struct Request {
+        /// @brief Type of the operation.
+        enum Type {
+            ADD_LEASE,
+            UPDATE_LEASE,
+            DELETE_LEASE,
+            GET_LEASE4_ADDR,
+            GET_LEASE4_HWADDR,
+            GET_LEASE4_CLIENTID,
+            GET_LEASE6_ADDR
+        };
+
+        /// @brief Constructor
+        ///
+        /// @param type Type of the operation.
+        explicit Request(Type type)
+            : type_(type), addr_("::"), hwaddr_(NULL), clientid_(NULL),
+              subnet_id_(0), lease_type_(Lease::TYPE_NA), done_(false),
+              result_(false) {
+        }
+
+        Type type_;                     ///< Type of the operation
+        Lease4Ptr lease4_;              ///< Written or found IPv4 lease
+        Lease6Ptr lease6_;              ///< Written or found IPv6 lease
+        isc::asiolink::IOAddress addr_; ///< Address of the lease
+        const HWAddr* hwaddr_;          ///< Hardware address of the client
+        const ClientId* clientid_;      ///< Client identifier
+        SubnetID subnet_id_;            ///< Subnet of the searched lease
+        Lease::Type lease_type_;        ///< Type of the searched IPv6 lease
+        bool done_;                     ///< Indicates that it has completed
+        bool result_;                   ///< Result passed to the callback
+        std::string error_;             ///< Error passed to the callback
+    };
+
+    /// @brief Hands the operation over to the thread and waits for its
+    /// result.
+    ///
+    /// @param request Operation to be performed.
+    ///
+    /// @throw isc::dhcp::DbOperationError if the operation has failed or
+    /// the thread has terminated because of an error.
+    void perform(Request& request) const;
+
+    /// @brief Main loop of the thread.
+    ///
+    /// It starts the queued writes and collects the results of the
+    /// writes in flight until the lease manager is destroyed. If the
+    /// descriptor used to queue the operations breaks, it fails the
+    /// queued operations, collects the results of the operations in
+    /// flight and terminates.
+    void run();
+
+    /// @brief Starts the asynchronous operation of the backend.
+    ///
+    /// @param request Operation to be performed.
+    void start(Request* request);
+
+    /// @brief Waits for the queued operations or the results of the
+    /// operations in flight and collects the results.
+    ///
+    /// The queued operations are not waited for if the thread is
+    /// terminating because of an error.
+    void waitForResults();
+
+    /// @brief Callback completing the write.
+    ///
+    /// @param request Completed write.
+    /// @param result Result of the operation.
+    /// @param error Error message or empty string.
+    void complete(Request* request, bool result, const std::string& error);
+
+    /// @brief Callback completing the IPv4 lookup.
+    ///
+    /// @param request Completed lookup.
+    /// @param lease Found lease or NULL.
+    /// @param error Error message or empty string.
+    void completeLease4(Request* request, const Lease4Ptr& lease,
+                        const std::string& error);
+
+    /// @brief Callback completing the IPv6 lookup.
+    ///
+    /// @param request Completed lookup.
+    /// @param lease Found lease or NULL.
+    /// @param error Error message or empty string.
+    void completeLease6(Request* request, const Lease6Ptr& lease,
+                        const std::string& error);
+
+    /// Lease manager holding the leases.
+    boost::scoped_ptr<LeaseMgr> backend_;
+
+    /// Indicates if the lookups use the asynchronous API of the backend.
+    bool async_lookups_;
+
+    /// Operations waiting for the thread.
+    mutable std::deque<Request*> queued_;
+
+    /// Indicates that the thread should terminate.
+    bool stop_;
+
+    /// Indicates that the thread has terminated because of an error, so
+    /// as the operations are no longer performed.
+    bool dead_;
+
+    /// Mutex protecting the queued operations and their results.
+    mutable isc::util::thread::Mutex mutex_;
+
+    /// Condition variable signalled when the operations complete.
+    mutable isc::util::thread::CondVar completed_;
+
+    /// Descriptor marked ready when an operation is queued.
+    mutable isc::dhcp_ddns::WatchSocket queued_ready_;
+
+    /// Thread using the asynchronous API of the backend.
+    boost::scoped_ptr<isc::util::thread::Thread> thread_;
+};
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // ASYNC_WRITE_LEASE_MGR_H
@@ -0,0 +1,228 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/lease_mgr_factory.h>
+#include <log/logger_support.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <sys/time.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+
+// Measures the cost of allocating a DHCPv4 lease by the allocation engine
+// using the iterative, hashed and random allocators, for pools which are
+// 50%, 90% and 99% full. The pool is filled with leases for randomly
+// selected addresses before each measurement. Each allocated lease is
+// released afterwards, so as the pool utilization doesn't change during
+// the measurement.
+//
+// For every allocation, the same client asks for a lease again after the
+// release and the percentage of clients getting their previous address
+// back is also reported.
+//
+// Usage: alloc_engine_bench [-n allocations] [pool_size]
+//
+// The pool size defaults to 65536 addresses.
+
+namespace {
+
+/// @brief Returns current time in microseconds.
+double
+now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1e6 + tv.tv_usec);
+}
+
+/// @brief Returns a client identifier for the client with the given index.
+///
+/// The identifier is used both as a MAC address and as a client id.
+std::vector<uint8_t>
+identifier(const uint32_t index) {
+    std::vector<uint8_t> id(6, 0);
+    for (int i = 0; i < 4; ++i) {
+        id[5 - i] = (index >> (i * 8)) & 0xFF;
+    }
+    return (id);
+}
+
+/// @brief Returns the name of the allocator.
+const char*
+allocatorName(const AllocEngine::AllocType type) {
+    switch (type) {
+    case AllocEngine::ALLOC_ITERATIVE:
+        return ("iterative");
+    case AllocEngine::ALLOC_HASHED:
+        return ("hashed");
+    default:
+        return ("random");
+    }
+}
+
+/// @brief Runs the benchmark for a single allocator and pool utilization.
+///
+/// @param subnet Subnet holding the pool.
+/// @param pool_size Number of addresses in the pool.
+/// @param type Type of the allocator.
+/// @param utilization Percentage of addresses in use.
+/// @param allocations Number of allocations to perform.
+void
+run(const Subnet4Ptr& subnet, const uint32_t pool_size,
+    const AllocEngine::AllocType type, const unsigned int utilization,
+    const size_t allocations) {
+    LeaseMgrFactory::destroy();
+    LeaseMgrFactory::create("type=memfile universe=4 persist=false");
+    LeaseMgr& lease_mgr = LeaseMgrFactory::instance();
+
+    // Mark randomly selected addresses used. The same addresses are used
+    // for all allocators.
+    std::vector<uint32_t> offsets(pool_size);
+    for (uint32_t i = 0; i < pool_size; ++i) {
+        offsets[i] = i;
+    }
+    srandom(1);
+    for (uint32_t i = pool_size - 1; i > 0; --i) {
+        std::swap(offsets[i], offsets[random() % (i + 1)]);
+    }
+    const uint32_t first = subnet->getPools(Lease::TYPE_V4)[0]->
+        getFirstAddress();
+    const uint32_t used = static_cast<uint64_t>(pool_size) * utilization / 100;
+    for (uint32_t i = 0; i < used; ++i) {
+        const std::vector<uint8_t> id = identifier(i);
+        Lease4Ptr lease(new Lease4(IOAddress(first + offsets[i]), &id[0],
+                                   id.size(), &id[0], id.size(), 3600, 900,
+                                   1800, time(NULL), subnet->getID()));
+        lease_mgr.addLease(lease);
+    }
+
+    // Create the clients in advance, so as it is not measured.
+    std::vector<ClientIdPtr> clientids;
+    std::vector<HWAddrPtr> hwaddrs;
+    for (size_t i = 0; i < allocations; ++i) {
+        const std::vector<uint8_t> id = identifier(pool_size + i);
+        clientids.push_back(ClientIdPtr(new ClientId(id)));
+        hwaddrs.push_back(HWAddrPtr(new HWAddr(id, HTYPE_ETHER)));
+    }
+
+    // Allow as many attempts as there are addresses in the pool, so as
+    // the allocation doesn't fail when there is a free address.
+    AllocEngine engine(type, pool_size, false);
+    ConstLease4Ptr old_lease;
+    size_t failed = 0;
+    size_t returned = 0;
+    double elapsed = 0;
+    for (size_t i = 0; i < allocations; ++i) {
+        const double start = now();
+        Lease4Ptr lease = engine.allocateLease4(subnet, clientids[i],
+                                                hwaddrs[i],
+                                                IOAddress("0.0.0.0"), false,
+                                                false, "", false,
+                                                isc::hooks::CalloutHandlePtr(),
+                                                old_lease);
+        elapsed += now() - start;
+        if (!lease) {
+            ++failed;
+            continue;
+        }
+
+        // Release the lease and let the client come back.
+        const IOAddress addr = lease->addr_;
+        lease_mgr.deleteLease(addr);
+        lease = engine.allocateLease4(subnet, clientids[i], hwaddrs[i],
+                                      IOAddress("0.0.0.0"), false, false,
+                                      "", false,
+                                      isc::hooks::CalloutHandlePtr(),
+                                      old_lease);
+        if (lease) {
+            if (lease->addr_ == addr) {
+                ++returned;
+            }
+            lease_mgr.deleteLease(lease->addr_);
+        }
+    }
+
+    cout << "  " << setw(10) << left << allocatorName(type) << right
+         << setw(4) << utilization << "% full" << setw(12) << fixed
+         << setprecision(3) << (elapsed / allocations) << " us/allocation"
+         << setw(8) << setprecision(1)
+         << (100.0 * returned / allocations) << "% returned";
+    if (failed > 0) {
+        cout << ", " << failed << " failed";
+    }
+    cout << endl;
+}
+
+} // end of anonymous namespace
+
+int
+main(int argc, char* argv[]) {
+    isc::log::initLogger("alloc_engine_bench", isc::log::WARN);
+
+    size_t allocations = 1000;
+    uint32_t pool_size = 65536;
+    for (int i = 1; i < argc; ++i) {
+        if ((std::string(argv[i]) == "-n") && (i + 1 < argc)) {
+            allocations = strtoul(argv[++i], NULL, 10);
+        } else {
+            pool_size = strtoul(argv[i], NULL, 10);
+        }
+    }
+    if (allocations == 0) {
+        cerr << "number of allocations must be greater than 0" << endl;
+        return (1);
+    }
+    if ((pool_size < 100) || (pool_size > 0x1000000)) {
+        cerr << "pool size must be between 100 and 16777216" << endl;
+        return (1);
+    }
+
+    // The pool starts at the beginning of the subnet.
+    Subnet4Ptr subnet(new Subnet4(IOAddress("10.0.0.0"), 8, 1800, 2700,
+                                  3600, 1));
+    subnet->addPool(Pool4Ptr(new Pool4(IOAddress("10.0.0.0"),
+                                       IOAddress(0x0A000000 + pool_size - 1))));
+    CfgMgr::instance().addSubnet4(subnet);
+
+    cout << pool_size << " addresses in the pool:" << endl;
+    const unsigned int utilizations[] = { 50, 90, 99 };
+    const AllocEngine::AllocType types[] = {
+        AllocEngine::ALLOC_ITERATIVE,
+        AllocEngine::ALLOC_HASHED,
+        AllocEngine::ALLOC_RANDOM
+    };
+    for (int u = 0; u < 3; ++u) {
+        for (int t = 0; t < 3; ++t) {
+            run(subnet, pool_size, types[t], utilizations[u], allocations);
+        }
+    }
+
+    LeaseMgrFactory::destroy();
+    return (0);
+}
@@ -0,0 +1,175 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/csv_lease_file4.h>
+#include <log/logger_support.h>
+#include <util/csv_file.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <sys/time.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::util;
+
+// Measures the time it takes to load the DHCPv4 lease file, using the
+// parser which copies each row into strings and converts the values
+// with the lexical casts and the text constructors of the address
+// classes (which is how the lease files used to be read), and using
+// the @c CSVLeaseFile4, which parses the rows in place.
+//
+// Usage: csv_lease_file_bench [-f filename] [lease_count]
+//
+// The lease count defaults to 1000000. The lease file is created in the
+// current directory, unless the file name is specified, and is removed
+// when the benchmark completes.
+
+namespace {
+
+/// @brief Returns current time in microseconds.
+double
+now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1e6 + tv.tv_usec);
+}
+
+/// @brief Creates the DHCPv4 lease with the given index.
+Lease4
+createLease4(const uint32_t index) {
+    std::vector<uint8_t> id(6, 0);
+    for (int i = 0; i < 4; ++i) {
+        id[5 - i] = (index >> (i * 8)) & 0xFF;
+    }
+    return (Lease4(IOAddress(0x0A000000 + index), &id[0], id.size(),
+                   &id[0], id.size(), 3600, 900, 1800, time(NULL), 1,
+                   true, true, "host.example.com"));
+}
+
+/// @brief Reads the lease file by copying each row.
+///
+/// The values are converted the way the @c CSVLeaseFile4 used to convert
+/// them.
+///
+/// @param filename Path to the lease file.
+/// @return Number of leases read.
+size_t
+readCopy(const std::string& filename) {
+    CSVFile csv(filename);
+    csv.open();
+
+    size_t count = 0;
+    CSVRow row;
+    while (csv.next(row) && (row != CSVFile::EMPTY_ROW())) {
+        HWAddr hwaddr = HWAddr::fromText(row.readAt(1));
+        ClientIdPtr client_id = ClientId::fromText(row.readAt(2));
+        const std::vector<uint8_t> client_id_vec = client_id->getClientId();
+        const uint32_t valid = row.readAndConvertAt<uint32_t>(3);
+        Lease4Ptr lease(new Lease4(IOAddress(row.readAt(0)),
+                                   &hwaddr.hwaddr_[0], hwaddr.hwaddr_.size(),
+                                   &client_id_vec[0], client_id_vec.size(),
+                                   valid, 0, 0,
+                                   row.readAndConvertAt<uint32_t>(4) - valid,
+                                   row.readAndConvertAt<SubnetID>(5),
+                                   row.readAndConvertAt<bool>(6),
+                                   row.readAndConvertAt<bool>(7),
+                                   row.readAt(8)));
+        ++count;
+    }
+    csv.close();
+    return (count);
+}
+
+/// @brief Reads the lease file using the @c CSVLeaseFile4.
+///
+/// @param filename Path to the lease file.
+/// @return Number of leases read.
+size_t
+readInPlace(const std::string& filename) {
+    CSVLeaseFile4 lease_file(filename);
+    lease_file.open();
+
+    size_t count = 0;
+    Lease4Ptr lease;
+    while (lease_file.next(lease) && lease) {
+        ++count;
+    }
+    lease_file.close();
+    return (count);
+}
+
+/// @brief Prints a single result.
+void
+report(const char* name, const size_t count, const double start,
+       const double end) {
+    cout << "  " << setw(36) << left << name << right << setw(10)
+         << fixed << setprecision(3) << ((end - start) / 1e6) << " s, "
+         << setprecision(3) << ((end - start) / count) << " us/lease"
+         << endl;
+}
+
+} // end of anonymous namespace
+
+int
+main(int argc, char* argv[]) {
+    isc::log::initLogger("csv_lease_file_bench", isc::log::WARN);
+
+    std::string filename = "csv_lease_file_bench.csv";
+    uint32_t lease_count = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        if ((std::string(argv[i]) == "-f") && (i + 1 < argc)) {
+            filename = argv[++i];
+        } else {
+            lease_count = strtoul(argv[i], NULL, 10);
+        }
+    }
+    if (lease_count == 0) {
+        cerr << "number of leases must be greater than 0" << endl;
+        return (1);
+    }
+
+    {
+        CSVLeaseFile4 lease_file(filename);
+        lease_file.recreate();
+        for (uint32_t i = 0; i < lease_count; ++i) {
+            lease_file.append(createLease4(i));
+        }
+        lease_file.close();
+    }
+
+    cout << lease_count << " leases:" << endl;
+
+    double start = now();
+    size_t count = readCopy(filename);
+    report("copying parser", count, start, now());
+
+    start = now();
+    count = readInPlace(filename);
+    report("in-place parser", count, start, now());
+
+    remove(filename.c_str());
+
+    return (0);
+}
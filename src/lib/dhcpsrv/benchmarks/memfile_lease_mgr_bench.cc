@@ -0,0 +1,285 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/memfile_lease_mgr.h>
+#include <log/logger_support.h>
+
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/mem_fun.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index_container.hpp>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+
+// Measures the cost of the lookups performed by the Memfile lease manager
+// for each allocated lease, for a growing number of leases in the lease
+// database. For comparison, the same lookups are performed on containers
+// with ordered indexes holding Lease4 and Lease6 objects, which is how
+// the Memfile lease manager used to store leases. The memory taken by
+// the Memfile lease manager and by these containers is also reported.
+//
+// Usage: memfile_lease_mgr_bench [-n lookups] [lease_count ...]
+//
+// The lease counts default to 100000, 1000000 and 5000000. The memory
+// is measured as the growth of the peak resident set size, so it is only
+// accurate for the first lease count given.
+
+namespace {
+
+/// @brief Ordered container of DHCPv4 leases, used as a baseline.
+typedef boost::multi_index_container<
+    Lease4Ptr,
+    boost::multi_index::indexed_by<
+        boost::multi_index::ordered_unique<
+            boost::multi_index::member<Lease, IOAddress, &Lease::addr_>
+        >,
+        boost::multi_index::ordered_unique<
+            boost::multi_index::composite_key<
+                Lease4,
+                boost::multi_index::member<Lease4, std::vector<uint8_t>,
+                                           &Lease4::hwaddr_>,
+                boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
+            >
+        >
+    >
+> OrderedLease4Storage;
+
+/// @brief Ordered container of DHCPv6 leases, used as a baseline.
+typedef boost::multi_index_container<
+    Lease6Ptr,
+    boost::multi_index::indexed_by<
+        boost::multi_index::ordered_unique<
+            boost::multi_index::member<Lease, IOAddress, &Lease::addr_>
+        >,
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::composite_key<
+                Lease6,
+                boost::multi_index::const_mem_fun<Lease6,
+                                                  const std::vector<uint8_t>&,
+                                                  &Lease6::getDuidVector>,
+                boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>,
+                boost::multi_index::member<Lease6, Lease::Type, &Lease6::type_>
+            >
+        >
+    >
+> OrderedLease6Storage;
+
+/// @brief Returns current time in microseconds.
+double
+now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1e6 + tv.tv_usec);
+}
+
+/// @brief Returns an IPv4 address for the lease with the given index.
+IOAddress
+address4(const uint32_t index) {
+    return (IOAddress(0x0A000000 + index));
+}
+
+/// @brief Returns an IPv6 address for the lease with the given index.
+IOAddress
+address6(const uint32_t index) {
+    uint8_t bytes[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+    for (int i = 0; i < 4; ++i) {
+        bytes[15 - i] = (index >> (i * 8)) & 0xFF;
+    }
+    return (IOAddress::fromBytes(AF_INET6, bytes));
+}
+
+/// @brief Returns a client identifier for the lease with the given index.
+///
+/// The identifier is used both as a MAC address and as a DUID.
+std::vector<uint8_t>
+identifier(const uint32_t index) {
+    std::vector<uint8_t> id(6, 0);
+    for (int i = 0; i < 4; ++i) {
+        id[5 - i] = (index >> (i * 8)) & 0xFF;
+    }
+    return (id);
+}
+
+/// @brief Creates the DHCPv4 lease with the given index.
+Lease4Ptr
+createLease4(const uint32_t index) {
+    const std::vector<uint8_t> id = identifier(index);
+    return (Lease4Ptr(new Lease4(address4(index), &id[0], id.size(), &id[0],
+                                 id.size(), 3600, 900, 1800, time(NULL), 1)));
+}
+
+/// @brief Creates the DHCPv6 lease with the given index.
+Lease6Ptr
+createLease6(const uint32_t index) {
+    DuidPtr duid(new DUID(identifier(index)));
+    return (Lease6Ptr(new Lease6(Lease::TYPE_NA, address6(index), duid, 1,
+                                 1800, 3600, 900, 1800, 1)));
+}
+
+/// @brief Returns the maximum resident set size of the process in kB.
+long
+maxRss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_maxrss);
+}
+
+/// @brief Prints a single result.
+void
+report(const char* name, const size_t lookups, const double start,
+       const double end) {
+    cout << "  " << setw(36) << left << name << right << setw(10)
+         << fixed << setprecision(3) << ((end - start) / lookups)
+         << " us/lookup" << endl;
+}
+
+/// @brief Runs the benchmark for the specified number of leases.
+///
+/// @param lease_count Number of leases in each container.
+/// @param lookups Number of lookups per measurement.
+void
+run(const uint32_t lease_count, const size_t lookups) {
+    cout << lease_count << " leases:" << endl;
+
+    Memfile_LeaseMgr::ParameterMap params;
+    params["type"] = "memfile";
+    params["universe"] = "4";
+    params["persist"] = "false";
+    Memfile_LeaseMgr lease_mgr(params);
+    OrderedLease4Storage ordered4;
+    OrderedLease6Storage ordered6;
+
+    // Populate the lease manager first and then the ordered containers,
+    // measuring how much memory each of them takes.
+    long rss = maxRss();
+    for (uint32_t i = 0; i < lease_count; ++i) {
+        lease_mgr.addLease(createLease4(i));
+        lease_mgr.addLease(createLease6(i));
+    }
+    const long memfile_rss = maxRss() - rss;
+
+    rss = maxRss();
+    for (uint32_t i = 0; i < lease_count; ++i) {
+        ordered4.insert(createLease4(i));
+        ordered6.insert(createLease6(i));
+    }
+    const long ordered_rss = maxRss() - rss;
+
+    cout << "  memory per lease pair (v4 + v6): Memfile "
+         << (memfile_rss * 1024 / lease_count) << " bytes, ordered containers "
+         << (ordered_rss * 1024 / lease_count) << " bytes" << endl;
+
+    // Pick the leases to look up in advance, so as the cost of generating
+    // the keys is not measured.
+    std::vector<IOAddress> addrs4;
+    std::vector<HWAddr> hwaddrs;
+    std::vector<std::vector<uint8_t> > duids;
+    for (size_t i = 0; i < lookups; ++i) {
+        const uint32_t index = static_cast<uint32_t>(random()) % lease_count;
+        addrs4.push_back(address4(index));
+        hwaddrs.push_back(HWAddr(identifier(index), HTYPE_ETHER));
+        duids.push_back(identifier(index));
+    }
+
+    double start = now();
+    for (size_t i = 0; i < lookups; ++i) {
+        lease_mgr.getLease4(addrs4[i]);
+    }
+    report("Memfile getLease4(addr)", lookups, start, now());
+
+    start = now();
+    for (size_t i = 0; i < lookups; ++i) {
+        ordered4.find(addrs4[i]);
+    }
+    report("ordered index by address (v4)", lookups, start, now());
+
+    start = now();
+    for (size_t i = 0; i < lookups; ++i) {
+        lease_mgr.getLease4(hwaddrs[i], 1);
+    }
+    report("Memfile getLease4(hwaddr, subnet)", lookups, start, now());
+
+    start = now();
+    for (size_t i = 0; i < lookups; ++i) {
+        ordered4.get<1>().find(boost::make_tuple(hwaddrs[i].hwaddr_,
+                                                 SubnetID(1)));
+    }
+    report("ordered index by hwaddr and subnet", lookups, start, now());
+
+    start = now();
+    for (size_t i = 0; i < lookups; ++i) {
+        lease_mgr.getLeases6(Lease::TYPE_NA, DUID(duids[i]), 1);
+    }
+    report("Memfile getLeases6(duid, iaid)", lookups, start, now());
+
+    start = now();
+    for (size_t i = 0; i < lookups; ++i) {
+        ordered6.get<1>().equal_range(boost::make_tuple(duids[i], 1,
+                                                        Lease::TYPE_NA));
+    }
+    report("ordered index by duid and iaid", lookups, start, now());
+}
+
+} // end of anonymous namespace
+
+int
+main(int argc, char* argv[]) {
+    isc::log::initLogger("memfile_lease_mgr_bench", isc::log::WARN);
+
+    size_t lookups = 100000;
+    std::vector<uint32_t> lease_counts;
+    for (int i = 1; i < argc; ++i) {
+        if ((std::string(argv[i]) == "-n") && (i + 1 < argc)) {
+            lookups = strtoul(argv[++i], NULL, 10);
+        } else {
+            lease_counts.push_back(strtoul(argv[i], NULL, 10));
+        }
+    }
+    if (lease_counts.empty()) {
+        lease_counts.push_back(100000);
+        lease_counts.push_back(1000000);
+        lease_counts.push_back(5000000);
+    }
+    if (lookups == 0) {
+        cerr << "number of lookups must be greater than 0" << endl;
+        return (1);
+    }
+
+    for (std::vector<uint32_t>::const_iterator count = lease_counts.begin();
+         count != lease_counts.end(); ++count) {
+        if (*count == 0) {
+            cerr << "number of leases must be greater than 0" << endl;
+            return (1);
+        }
+        run(*count, lookups);
+    }
+
+    return (0);
+}
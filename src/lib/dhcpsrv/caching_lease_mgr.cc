@@ -0,0 +1,599 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/caching_lease_mgr.h>
+
+#include <boost/bind.hpp>
+#include <boost/tuple/tuple.hpp>
+
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+using namespace isc::asiolink;
+using namespace isc::util::thread;
+
+namespace isc {
+namespace dhcp {
+
+const size_t CachingLeaseMgr::WRITES_SIZE;
+
+CachingLeaseMgr::CachingLeaseMgr(const ParameterMap& parameters,
+                                 LeaseMgr* backend)
+    : LeaseMgr(parameters), backend_(backend), capacity_(0), hits_(0),
+      misses_(0), generation_(0), writes_(WRITES_SIZE, IOAddress("::")) {
+    // The backend is destroyed along with the members if the parameter
+    // is invalid.
+    capacity_ = getIntegerParameter("cache-size", 0, 1, 0xFFFFFFFF);
+}
+
+CachingLeaseMgr::~CachingLeaseMgr() {
+}
+
+bool
+CachingLeaseMgr::addLease(const Lease4Ptr& lease) {
+    startWrite(lease->addr_);
+    const bool added = backend_->addLease(lease);
+
+    Mutex::Locker lock(mutex_);
+    written(lease->addr_);
+    if (added) {
+        store4(*lease);
+    }
+    return (added);
+}
+
+bool
+CachingLeaseMgr::addLease(const Lease6Ptr& lease) {
+    startWrite(lease->addr_);
+    const bool added = backend_->addLease(lease);
+
+    Mutex::Locker lock(mutex_);
+    written(lease->addr_);
+    if (added) {
+        store6(*lease);
+    }
+    return (added);
+}
+
+Lease4Ptr
+CachingLeaseMgr::getLease4(const IOAddress& addr) const {
+    uint64_t generation = 0;
+    Lease4Ptr lease = find4(addr, generation);
+    if (lease) {
+        return (lease);
+    }
+    return (fetched4(backend_->getLease4(addr), generation));
+}
+
+Lease4Collection
+CachingLeaseMgr::getLease4(const HWAddr& hwaddr) const {
+    return (backend_->getLease4(hwaddr));
+}
+
+Lease4Ptr
+CachingLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
+    uint64_t generation = 0;
+    Lease4Ptr lease = find4(hwaddr, subnet_id, generation);
+    if (lease) {
+        return (lease);
+    }
+    return (fetched4(backend_->getLease4(hwaddr, subnet_id), generation));
+}
+
+Lease4Collection
+CachingLeaseMgr::getLease4(const ClientId& client_id) const {
+    return (backend_->getLease4(client_id));
+}
+
+Lease4Ptr
+CachingLeaseMgr::getLease4(const ClientId& clientid, const HWAddr& hwaddr,
+                           SubnetID subnet_id) const {
+    uint64_t generation = 0;
+    Lease4Ptr lease = find4(clientid, &hwaddr, subnet_id, generation);
+    if (lease) {
+        return (lease);
+    }
+    return (fetched4(backend_->getLease4(clientid, hwaddr, subnet_id),
+                     generation));
+}
+
+Lease4Ptr
+CachingLeaseMgr::getLease4(const ClientId& clientid,
+                           SubnetID subnet_id) const {
+    uint64_t generation = 0;
+    Lease4Ptr lease = find4(clientid, NULL, subnet_id, generation);
+    if (lease) {
+        return (lease);
+    }
+    return (fetched4(backend_->getLease4(clientid, subnet_id), generation));
+}
+
+Lease4Collection
+CachingLeaseMgr::getLeases4(SubnetID subnet_id) const {
+    return (backend_->getLeases4(subnet_id));
+}
+
+Lease6Ptr
+CachingLeaseMgr::getLease6(Lease::Type type, const IOAddress& addr) const {
+    uint64_t generation = 0;
+    Lease6Ptr lease = find6(type, addr, generation);
+    if (lease) {
+        return (lease);
+    }
+    return (fetched6(backend_->getLease6(type, addr), generation));
+}
+
+Lease6Collection
+CachingLeaseMgr::getLeases6(Lease::Type type, const DUID& duid,
+                            uint32_t iaid) const {
+    return (backend_->getLeases6(type, duid, iaid));
+}
+
+Lease6Collection
+CachingLeaseMgr::getLeases6(Lease::Type type, const DUID& duid,
+                            uint32_t iaid, SubnetID subnet_id) const {
+    return (backend_->getLeases6(type, duid, iaid, subnet_id));
+}
+
+Lease6Collection
+CachingLeaseMgr::getLeases6(SubnetID subnet_id) const {
+    return (backend_->getLeases6(subnet_id));
+}
+
+void
+CachingLeaseMgr::getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const {
+    backend_->getExpiredLeases4(expired_leases, max_leases);
+}
+
+void
+CachingLeaseMgr::getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const {
+    backend_->getExpiredLeases6(expired_leases, max_leases);
+}
+
+void
+CachingLeaseMgr::updateLease4(const Lease4Ptr& lease) {
+    // The lease remains removed from the cache if the update fails.
+    startWrite(lease->addr_);
+    backend_->updateLease4(lease);
+
+    Mutex::Locker lock(mutex_);
+    written(lease->addr_);
+    store4(*lease);
+}
+
+void
+CachingLeaseMgr::updateLease6(const Lease6Ptr& lease) {
+    // The lease remains removed from the cache if the update fails.
+    startWrite(lease->addr_);
+    backend_->updateLease6(lease);
+
+    Mutex::Locker lock(mutex_);
+    written(lease->addr_);
+    store6(*lease);
+}
+
+bool
+CachingLeaseMgr::deleteLease(const IOAddress& addr) {
+    startWrite(addr);
+    const bool deleted = backend_->deleteLease(addr);
+
+    // The lease might have been fetched again while it was being deleted.
+    Mutex::Locker lock(mutex_);
+    written(addr);
+    remove(addr);
+    return (deleted);
+}
+
+bool
+CachingLeaseMgr::deleteExpiredLease(const IOAddress& addr) {
+    startWrite(addr);
+    const bool deleted = backend_->deleteExpiredLease(addr);
+
+    // The lease is removed from the cache even if it hasn't been deleted,
+    // because it might have been renewed in the backend.
+    Mutex::Locker lock(mutex_);
+    written(addr);
+    remove(addr);
+    return (deleted);
+}
+
+std::string
+CachingLeaseMgr::getDescription() const {
+    std::ostringstream s;
+    s << backend_->getDescription() << " with the cache of " << capacity_
+      << " leases";
+    return (s.str());
+}
+
+void
+CachingLeaseMgr::rollback() {
+    backend_->rollback();
+
+    Mutex::Locker lock(mutex_);
+    // The lookups in progress must not store the fetched leases, as if
+    // all remembered writes had been made.
+    generation_ += WRITES_SIZE;
+    cache4_.clear();
+    cache6_.clear();
+}
+
+void
+CachingLeaseMgr::asyncGetLease4(const IOAddress& addr,
+                                const Lease4Callback& callback) {
+    uint64_t generation = 0;
+    Lease4Ptr lease = find4(addr, generation);
+    if (lease) {
+        callback(lease, "");
+        return;
+    }
+    backend_->asyncGetLease4(addr,
+        boost::bind(&CachingLeaseMgr::asyncLease4Fetched, this, callback,
+                    generation, _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                                const Lease4Callback& callback) {
+    uint64_t generation = 0;
+    Lease4Ptr lease = find4(hwaddr, subnet_id, generation);
+    if (lease) {
+        callback(lease, "");
+        return;
+    }
+    backend_->asyncGetLease4(hwaddr, subnet_id,
+        boost::bind(&CachingLeaseMgr::asyncLease4Fetched, this, callback,
+                    generation, _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                                const Lease4Callback& callback) {
+    uint64_t generation = 0;
+    Lease4Ptr lease = find4(clientid, NULL, subnet_id, generation);
+    if (lease) {
+        callback(lease, "");
+        return;
+    }
+    backend_->asyncGetLease4(clientid, subnet_id,
+        boost::bind(&CachingLeaseMgr::asyncLease4Fetched, this, callback,
+                    generation, _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncGetLease6(Lease::Type type, const IOAddress& addr,
+                                const Lease6Callback& callback) {
+    uint64_t generation = 0;
+    Lease6Ptr lease = find6(type, addr, generation);
+    if (lease) {
+        callback(lease, "");
+        return;
+    }
+    backend_->asyncGetLease6(type, addr,
+        boost::bind(&CachingLeaseMgr::asyncLease6Fetched, this, callback,
+                    generation, _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncAddLease(const Lease4Ptr& lease,
+                               const ResultCallback& callback) {
+    // The caller may modify the lease before the operation completes.
+    startWrite(lease->addr_);
+    backend_->asyncAddLease(lease,
+        boost::bind(&CachingLeaseMgr::asyncLease4Written, this, callback,
+                    Lease4Ptr(new Lease4(*lease)), _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncAddLease(const Lease6Ptr& lease,
+                               const ResultCallback& callback) {
+    startWrite(lease->addr_);
+    backend_->asyncAddLease(lease,
+        boost::bind(&CachingLeaseMgr::asyncLease6Written, this, callback,
+                    Lease6Ptr(new Lease6(*lease)), _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncUpdateLease4(const Lease4Ptr& lease4,
+                                   const ResultCallback& callback) {
+    startWrite(lease4->addr_);
+    backend_->asyncUpdateLease4(lease4,
+        boost::bind(&CachingLeaseMgr::asyncLease4Written, this, callback,
+                    Lease4Ptr(new Lease4(*lease4)), _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncUpdateLease6(const Lease6Ptr& lease6,
+                                   const ResultCallback& callback) {
+    startWrite(lease6->addr_);
+    backend_->asyncUpdateLease6(lease6,
+        boost::bind(&CachingLeaseMgr::asyncLease6Written, this, callback,
+                    Lease6Ptr(new Lease6(*lease6)), _1, _2));
+}
+
+void
+CachingLeaseMgr::asyncDeleteLease(const IOAddress& addr,
+                                  const ResultCallback& callback) {
+    startWrite(addr);
+    backend_->asyncDeleteLease(addr,
+        boost::bind(&CachingLeaseMgr::asyncLeaseDeleted, this, callback,
+                    addr, _1, _2));
+}
+
+size_t
+CachingLeaseMgr::getSize() const {
+    Mutex::Locker lock(mutex_);
+    return (cache4_.size() + cache6_.size());
+}
+
+uint64_t
+CachingLeaseMgr::getHits() const {
+    Mutex::Locker lock(mutex_);
+    return (hits_);
+}
+
+uint64_t
+CachingLeaseMgr::getMisses() const {
+    Mutex::Locker lock(mutex_);
+    return (misses_);
+}
+
+void
+CachingLeaseMgr::store4(const Lease4& lease) const {
+    Lease4LruIndex& lru = cache4_.get<3>();
+    Lease4Cache::iterator cached =
+        cache4_.find(static_cast<uint32_t>(lease.addr_));
+    if (cached != cache4_.end()) {
+        // The lease must not be modified in place because the hashed
+        // indexes wouldn't reflect the new values of the indexed members.
+        cache4_.replace(cached, CompactLease4(lease, strings_));
+        lru.relocate(lru.begin(), cache4_.project<3>(cached));
+        return;
+    }
+
+    lru.push_front(CompactLease4(lease, strings_));
+    if (lru.size() > capacity_) {
+        lru.pop_back();
+    }
+}
+
+void
+CachingLeaseMgr::store6(const Lease6& lease) const {
+    Lease6LruIndex& lru = cache6_.get<1>();
+    Lease6Cache::iterator cached =
+        cache6_.find(CompactLease6::toAddress(lease.addr_));
+    if (cached != cache6_.end()) {
+        cache6_.replace(cached, CompactLease6(lease, strings_));
+        lru.relocate(lru.begin(), cache6_.project<1>(cached));
+        return;
+    }
+
+    lru.push_front(CompactLease6(lease, strings_));
+    if (lru.size() > capacity_) {
+        lru.pop_back();
+    }
+}
+
+void
+CachingLeaseMgr::remove(const IOAddress& addr) const {
+    if (addr.isV4()) {
+        cache4_.erase(static_cast<uint32_t>(addr));
+    } else {
+        cache6_.erase(CompactLease6::toAddress(addr));
+    }
+}
+
+template<typename Iterator>
+Lease4Ptr
+CachingLeaseMgr::use4(const Iterator& lease) const {
+    Lease4LruIndex& lru = cache4_.get<3>();
+    lru.relocate(lru.begin(), cache4_.project<3>(lease));
+    ++hits_;
+    return (lease->toLease());
+}
+
+Lease4Ptr
+CachingLeaseMgr::find4(const IOAddress& addr, uint64_t& generation) const {
+    Mutex::Locker lock(mutex_);
+    generation = generation_;
+    Lease4Cache::const_iterator lease =
+        cache4_.find(static_cast<uint32_t>(addr));
+    if (lease != cache4_.end()) {
+        return (use4(lease));
+    }
+    ++misses_;
+    return (Lease4Ptr());
+}
+
+Lease4Ptr
+CachingLeaseMgr::find4(const HWAddr& hwaddr, SubnetID subnet_id,
+                       uint64_t& generation) const {
+    typedef Lease4Cache::nth_index<1>::type SearchIndex;
+
+    Mutex::Locker lock(mutex_);
+    generation = generation_;
+    const SearchIndex& idx = cache4_.get<1>();
+    std::pair<SearchIndex::const_iterator, SearchIndex::const_iterator> range =
+        idx.equal_range(boost::make_tuple(CompactId(hwaddr.hwaddr_),
+                                          subnet_id));
+    // Let the backend decide if there are multiple leases.
+    if (std::distance(range.first, range.second) == 1) {
+        return (use4(range.first));
+    }
+    ++misses_;
+    return (Lease4Ptr());
+}
+
+Lease4Ptr
+CachingLeaseMgr::find4(const ClientId& clientid, const HWAddr* hwaddr,
+                       SubnetID subnet_id, uint64_t& generation) const {
+    typedef Lease4Cache::nth_index<2>::type SearchIndex;
+
+    Mutex::Locker lock(mutex_);
+    generation = generation_;
+    const SearchIndex& idx = cache4_.get<2>();
+    std::pair<SearchIndex::const_iterator, SearchIndex::const_iterator> range =
+        idx.equal_range(boost::make_tuple(CompactId(clientid.getClientId()),
+                                          subnet_id));
+    const CompactId compact_hwaddr(hwaddr ? hwaddr->hwaddr_ :
+                                   std::vector<uint8_t>());
+    SearchIndex::const_iterator found = idx.end();
+    for (SearchIndex::const_iterator lease = range.first;
+         lease != range.second; ++lease) {
+        if (hwaddr && (lease->hwaddr_ != compact_hwaddr)) {
+            continue;
+        }
+        // Let the backend decide if there are multiple leases.
+        if (found != idx.end()) {
+            found = idx.end();
+            break;
+        }
+        found = lease;
+    }
+    if (found != idx.end()) {
+        return (use4(found));
+    }
+    ++misses_;
+    return (Lease4Ptr());
+}
+
+Lease6Ptr
+CachingLeaseMgr::find6(Lease::Type type, const IOAddress& addr,
+                       uint64_t& generation) const {
+    Mutex::Locker lock(mutex_);
+    generation = generation_;
+    Lease6Cache::const_iterator lease =
+        cache6_.find(CompactLease6::toAddress(addr));
+    if ((lease != cache6_.end()) && (lease->type_ == type)) {
+        Lease6LruIndex& lru = cache6_.get<1>();
+        lru.relocate(lru.begin(), cache6_.project<1>(lease));
+        ++hits_;
+        return (lease->toLease());
+    }
+    ++misses_;
+    return (Lease6Ptr());
+}
+
+Lease4Ptr
+CachingLeaseMgr::fetched4(const Lease4Ptr& lease,
+                          const uint64_t generation) const {
+    if (lease) {
+        Mutex::Locker lock(mutex_);
+        if (!writtenSince(lease->addr_, generation)) {
+            store4(*lease);
+        }
+    }
+    return (lease);
+}
+
+Lease6Ptr
+CachingLeaseMgr::fetched6(const Lease6Ptr& lease,
+                          const uint64_t generation) const {
+    if (lease) {
+        Mutex::Locker lock(mutex_);
+        if (!writtenSince(lease->addr_, generation)) {
+            store6(*lease);
+        }
+    }
+    return (lease);
+}
+
+void
+CachingLeaseMgr::startWrite(const IOAddress& addr) {
+    Mutex::Locker lock(mutex_);
+    written(addr);
+    remove(addr);
+}
+
+void
+CachingLeaseMgr::written(const IOAddress& addr) {
+    writes_[generation_ % WRITES_SIZE] = addr;
+    ++generation_;
+}
+
+bool
+CachingLeaseMgr::writtenSince(const IOAddress& addr,
+                              const uint64_t generation) const {
+    // The oldest writes made since the lookup started have been forgotten.
+    if (generation_ - generation > WRITES_SIZE) {
+        return (true);
+    }
+    for (uint64_t write = generation; write < generation_; ++write) {
+        if (writes_[write % WRITES_SIZE] == addr) {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+void
+CachingLeaseMgr::asyncLease4Fetched(const Lease4Callback& callback,
+                                    const uint64_t generation,
+                                    const Lease4Ptr& lease,
+                                    const std::string& error) {
+    callback(fetched4(lease, generation), error);
+}
+
+void
+CachingLeaseMgr::asyncLease6Fetched(const Lease6Callback& callback,
+                                    const uint64_t generation,
+                                    const Lease6Ptr& lease,
+                                    const std::string& error) {
+    callback(fetched6(lease, generation), error);
+}
+
+void
+CachingLeaseMgr::asyncLease4Written(const ResultCallback& callback,
+                                    const Lease4Ptr& lease, const bool result,
+                                    const std::string& error) {
+    {
+        Mutex::Locker lock(mutex_);
+        written(lease->addr_);
+        if (result) {
+            store4(*lease);
+        }
+    }
+    callback(result, error);
+}
+
+void
+CachingLeaseMgr::asyncLease6Written(const ResultCallback& callback,
+                                    const Lease6Ptr& lease, const bool result,
+                                    const std::string& error) {
+    {
+        Mutex::Locker lock(mutex_);
+        written(lease->addr_);
+        if (result) {
+            store6(*lease);
+        }
+    }
+    callback(result, error);
+}
+
+void
+CachingLeaseMgr::asyncLeaseDeleted(const ResultCallback& callback,
+                                   const IOAddress& addr, const bool result,
+                                   const std::string& error) {
+    {
+        Mutex::Locker lock(mutex_);
+        written(addr);
+        remove(addr);
+    }
+    callback(result, error);
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
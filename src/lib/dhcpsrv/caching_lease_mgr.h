@@ -0,0 +1,630 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef CACHING_LEASE_MGR_H
+#define CACHING_LEASE_MGR_H
+
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/compact_lease.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <util/threads/sync.h>
+
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/indexed_by.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Read-through cache of leases in front of another lease manager.
+///
+/// The SQL backends make a round trip to the database for every lookup,
+/// even though the server looks up the same leases over and over again,
+/// e.g. each renewal looks for the client's lease by the HW address and by
+/// the client identifier. This lease manager holds the recently used leases
+/// in memory and forwards all calls it can't answer itself to the backend
+/// lease manager:
+/// - the lookups of a single lease by address, by HW address and subnet id
+///   and by client identifier (and HW address) and subnet id are answered
+///   from the cache if the lease is there; otherwise the lease is fetched
+///   from the backend and stored in the cache,
+/// - the added and updated leases are written to the backend and then
+///   stored in the cache; the deleted leases are removed from both,
+/// - the lookups returning collections of leases always go to the backend,
+///   as the cache can't tell if it holds all matching leases.
+///
+/// The leases are held in the compact form and indexed the same way as in
+/// the @c Memfile_LeaseMgr. The number of the cached leases of each type
+/// is limited by the "cache-size" parameter: when the cache is full, the
+/// least recently used lease is evicted.
+///
+/// The cache is coherent with the backend as long as the leases are only
+/// modified through this lease manager, i.e. the server is the only writer
+/// to the lease database.
+class CachingLeaseMgr : public LeaseMgr {
+public:
+
+    /// @brief Constructor
+    ///
+    /// Uses the "cache-size" parameter, holding the maximum number of the
+    /// DHCPv4 and DHCPv6 leases (each) held in the cache.
+    ///
+    /// @param parameters A data structure relating keywords and values
+    ///        concerned with the database.
+    /// @param backend Lease manager holding the leases. The cache takes the
+    ///        ownership of it and destroys it along with itself.
+    ///
+    /// @throw isc::BadValue if the cache size is not a number between 1 and
+    ///        4294967295.
+    CachingLeaseMgr(const ParameterMap& parameters, LeaseMgr* backend);
+
+    /// @brief Destructor. Destroys the backend lease manager.
+    virtual ~CachingLeaseMgr();
+
+    /// @brief Adds an IPv4 lease to the backend and to the cache.
+    ///
+    /// @param lease lease to be added
+    virtual bool addLease(const Lease4Ptr& lease);
+
+    /// @brief Adds an IPv6 lease to the backend and to the cache.
+    ///
+    /// @param lease lease to be added
+    virtual bool addLease(const Lease6Ptr& lease);
+
+    /// @brief Returns existing IPv4 lease for specified IPv4 address.
+    ///
+    /// @param addr An address of the searched lease.
+    virtual Lease4Ptr getLease4(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns existing IPv4 leases for specified hardware address.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param hwaddr hardware address of the client
+    virtual Lease4Collection getLease4(const isc::dhcp::HWAddr& hwaddr) const;
+
+    /// @brief Returns existing IPv4 lease for specified hardware address
+    ///        and a subnet.
+    ///
+    /// @param hwaddr hardware address of the client
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    virtual Lease4Ptr getLease4(const HWAddr& hwaddr,
+                                SubnetID subnet_id) const;
+
+    /// @brief Returns existing IPv4 leases for specified client-id.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param client_id client identifier
+    virtual Lease4Collection getLease4(const ClientId& client_id) const;
+
+    /// @brief Returns IPv4 lease for specified client-id/hwaddr/subnet-id
+    ///        tuple.
+    ///
+    /// @param clientid client identifier
+    /// @param hwaddr hardware address of the client
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    virtual Lease4Ptr getLease4(const ClientId& clientid,
+                                const HWAddr& hwaddr,
+                                SubnetID subnet_id) const;
+
+    /// @brief Returns existing IPv4 lease for specified client-id and
+    ///        subnet.
+    ///
+    /// @param clientid client identifier
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    virtual Lease4Ptr getLease4(const ClientId& clientid,
+                                SubnetID subnet_id) const;
+
+    /// @brief Returns all IPv4 leases for the particular subnet identifier.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param subnet_id subnet identifier.
+    virtual Lease4Collection getLeases4(SubnetID subnet_id) const;
+
+    /// @brief Returns existing IPv6 lease for a given IPv6 address.
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param addr An address of the searched lease.
+    virtual Lease6Ptr getLease6(Lease::Type type,
+                                const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns existing IPv6 leases for a given DUID+IA combination.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param duid client DUID
+    /// @param iaid IA identifier
+    virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
+                                        uint32_t iaid) const;
+
+    /// @brief Returns existing IPv6 lease for a given DUID+IA+subnet-id
+    ///        combination.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param duid client DUID
+    /// @param iaid IA identifier
+    /// @param subnet_id identifier of the subnet the lease must belong to
+    virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
+                                        uint32_t iaid,
+                                        SubnetID subnet_id) const;
+
+    /// @brief Returns all IPv6 leases for the particular subnet identifier.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param subnet_id subnet identifier.
+    virtual Lease6Collection getLeases6(SubnetID subnet_id) const;
+
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// The leases are always fetched from the backend.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Updates IPv4 lease in the backend and in the cache.
+    ///
+    /// If the backend fails to update the lease, it is removed from the
+    /// cache, as its state in the backend is unknown.
+    ///
+    /// @param lease4 The lease to be updated.
+    virtual void updateLease4(const Lease4Ptr& lease4);
+
+    /// @brief Updates IPv6 lease in the backend and in the cache.
+    ///
+    /// If the backend fails to update the lease, it is removed from the
+    /// cache, as its state in the backend is unknown.
+    ///
+    /// @param lease6 The lease to be updated.
+    virtual void updateLease6(const Lease6Ptr& lease6);
+
+    /// @brief Deletes a lease from the backend and from the cache.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    virtual bool deleteLease(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Deletes a lease if it has expired.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    ///         or it has not expired.
+    virtual bool deleteExpiredLease(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Returns the type of the backend.
+    virtual std::string getType() const {
+        return (backend_->getType());
+    }
+
+    /// @brief Returns the name of the backend.
+    virtual std::string getName() const {
+        return (backend_->getName());
+    }
+
+    /// @brief Returns the description of the backend.
+    virtual std::string getDescription() const;
+
+    /// @brief Returns the version of the backend.
+    virtual std::pair<uint32_t, uint32_t> getVersion() const {
+        return (backend_->getVersion());
+    }
+
+    /// @brief Commits the transactions of the backend.
+    virtual void commit() {
+        backend_->commit();
+    }
+
+    /// @brief Rolls back the transactions of the backend.
+    ///
+    /// The cache is cleared, as it may hold the leases whose changes have
+    /// been rolled back.
+    virtual void rollback();
+
+    /// @name Asynchronous lease operations
+    ///
+    /// The lookups answered from the cache invoke the callbacks before
+    /// returning. All other operations are started in the backend and the
+    /// cache is updated when they complete. The address of a lease being
+    /// written is removed from the cache until the write completes.
+    //@{
+
+    virtual void asyncGetLease4(const isc::asiolink::IOAddress& addr,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease6(Lease::Type type,
+                                const isc::asiolink::IOAddress& addr,
+                                const Lease6Callback& callback);
+
+    virtual void asyncAddLease(const Lease4Ptr& lease,
+                               const ResultCallback& callback);
+
+    virtual void asyncAddLease(const Lease6Ptr& lease,
+                               const ResultCallback& callback);
+
+    virtual void asyncUpdateLease4(const Lease4Ptr& lease4,
+                                   const ResultCallback& callback);
+
+    virtual void asyncUpdateLease6(const Lease6Ptr& lease6,
+                                   const ResultCallback& callback);
+
+    virtual void asyncDeleteLease(const isc::asiolink::IOAddress& addr,
+                                  const ResultCallback& callback);
+
+    virtual int getAsyncSocket() {
+        return (backend_->getAsyncSocket());
+    }
+
+    virtual void processAsyncResults() {
+        backend_->processAsyncResults();
+    }
+
+    virtual size_t getAsyncPendingCount() const {
+        return (backend_->getAsyncPendingCount());
+    }
+
+    //@}
+
+    /// @brief Returns the backend lease manager.
+    LeaseMgr& getBackend() const {
+        return (*backend_);
+    }
+
+    /// @brief Returns the maximum number of leases of each type in the
+    /// cache.
+    size_t getCapacity() const {
+        return (capacity_);
+    }
+
+    /// @brief Returns the number of DHCPv4 and DHCPv6 leases in the cache.
+    size_t getSize() const;
+
+    /// @brief Returns the number of lookups answered from the cache.
+    uint64_t getHits() const;
+
+    /// @brief Returns the number of lookups forwarded to the backend.
+    uint64_t getMisses() const;
+
+private:
+
+    // This is a multi-index container holding the cached DHCPv4 leases with
+    // the same hashed indexes as the Memfile_LeaseMgr::Lease4Storage and the
+    // list of the leases in the order of their use.
+    typedef boost::multi_index_container<
+        CompactLease4,
+        boost::multi_index::indexed_by<
+            // This index hashes leases by IPv4 addresses held as integers.
+            boost::multi_index::hashed_unique<
+                boost::multi_index::member<CompactLease4, uint32_t,
+                                           &CompactLease4::addr_>
+            >,
+
+            // This index combines the hardware address and subnet id. It is
+            // not unique because the cache may briefly hold a lease which has
+            // already been replaced in the backend by a lease with another
+            // address.
+            boost::multi_index::hashed_non_unique<
+                boost::multi_index::composite_key<
+                    CompactLease4,
+                    boost::multi_index::member<CompactLease4, CompactId,
+                                               &CompactLease4::hwaddr_>,
+                    boost::multi_index::member<CompactLease4, SubnetID,
+                                               &CompactLease4::subnet_id_>
+                >
+            >,
+
+            // This index combines the client id and subnet id.
+            boost::multi_index::hashed_non_unique<
+                boost::multi_index::composite_key<
+                    CompactLease4,
+                    boost::multi_index::member<CompactLease4, CompactId,
+                                               &CompactLease4::client_id_>,
+                    boost::multi_index::member<CompactLease4, SubnetID,
+                                               &CompactLease4::subnet_id_>
+                >
+            >,
+
+            // The leases in the order of their use, starting from the most
+            // recently used one.
+            boost::multi_index::sequenced<>
+        >,
+        SlabAllocator<CompactLease4>
+    > Lease4Cache;
+
+    // This is a multi-index container holding the cached DHCPv6 leases.
+    // Only the single lease lookups are served from the cache, so the
+    // leases are only indexed by address.
+    typedef boost::multi_index_container<
+        CompactLease6,
+        boost::multi_index::indexed_by<
+            // This index hashes leases by IPv6 addresses held in the
+            // binary form.
+            boost::multi_index::hashed_unique<
+                boost::multi_index::member<CompactLease6, CompactLease6::Address,
+                                           &CompactLease6::addr_>
+            >,
+
+            // The leases in the order of their use, starting from the most
+            // recently used one.
+            boost::multi_index::sequenced<>
+        >,
+        SlabAllocator<CompactLease6>
+    > Lease6Cache;
+
+    /// @brief Index of the DHCPv4 leases in the order of their use.
+    typedef Lease4Cache::nth_index<3>::type Lease4LruIndex;
+
+    /// @brief Index of the DHCPv6 leases in the order of their use.
+    typedef Lease6Cache::nth_index<1>::type Lease6LruIndex;
+
+    /// @brief Stores the DHCPv4 lease in the cache.
+    ///
+    /// The cached lease with the same address is replaced. The least
+    /// recently used lease is evicted if the cache is full. The caller
+    /// must hold the mutex.
+    ///
+    /// @param lease Lease to be stored.
+    void store4(const Lease4& lease) const;
+
+    /// @brief Stores the DHCPv6 lease in the cache.
+    ///
+    /// The cached lease with the same address is replaced. The least
+    /// recently used lease is evicted if the cache is full. The caller
+    /// must hold the mutex.
+    ///
+    /// @param lease Lease to be stored.
+    void store6(const Lease6& lease) const;
+
+    /// @brief Removes the lease for the address from the cache.
+    ///
+    /// The caller must hold the mutex.
+    ///
+    /// @param addr IPv4 or IPv6 address of the lease.
+    void remove(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns the copy of the cached DHCPv4 lease and marks it as
+    /// the most recently used one.
+    ///
+    /// The caller must hold the mutex.
+    ///
+    /// @param lease Iterator pointing to the lease.
+    template<typename Iterator>
+    Lease4Ptr use4(const Iterator& lease) const;
+
+    /// @brief Looks up the cached DHCPv4 lease by the address.
+    ///
+    /// It counts the cache hits and misses.
+    ///
+    /// @param addr Address of the lease.
+    /// @param [out] generation Number of the writes made so far.
+    /// @return copy of the lease or NULL if it's not in the cache.
+    Lease4Ptr find4(const isc::asiolink::IOAddress& addr,
+                    uint64_t& generation) const;
+
+    /// @brief Looks up the cached DHCPv4 lease by the HW address and subnet.
+    ///
+    /// It counts the cache hits and misses. The lease is returned only if
+    /// it is the only one matching in the cache.
+    ///
+    /// @param hwaddr HW address of the client.
+    /// @param subnet_id identifier of the subnet the lease belongs to.
+    /// @param [out] generation Number of the writes made so far.
+    /// @return copy of the lease or NULL if it's not in the cache.
+    Lease4Ptr find4(const HWAddr& hwaddr, SubnetID subnet_id,
+                    uint64_t& generation) const;
+
+    /// @brief Looks up the cached DHCPv4 lease by the client id, optional
+    /// HW address and subnet.
+    ///
+    /// It counts the cache hits and misses. The lease is returned only if
+    /// it is the only one matching in the cache.
+    ///
+    /// @param clientid client identifier.
+    /// @param hwaddr HW address of the client or NULL if any HW address
+    ///        matches.
+    /// @param subnet_id identifier of the subnet the lease belongs to.
+    /// @param [out] generation Number of the writes made so far.
+    /// @return copy of the lease or NULL if it's not in the cache.
+    Lease4Ptr find4(const ClientId& clientid, const HWAddr* hwaddr,
+                    SubnetID subnet_id, uint64_t& generation) const;
+
+    /// @brief Looks up the cached DHCPv6 lease by type and address.
+    ///
+    /// It counts the cache hits and misses.
+    ///
+    /// @param type Type of the lease.
+    /// @param addr Address of the lease.
+    /// @param [out] generation Number of the writes made so far.
+    /// @return copy of the lease or NULL if it's not in the cache.
+    Lease6Ptr find6(Lease::Type type, const isc::asiolink::IOAddress& addr,
+                    uint64_t& generation) const;
+
+    /// @brief Stores the DHCPv4 lease fetched from the backend in the cache.
+    ///
+    /// The lease is not stored if it has been written since the lookup
+    /// started, as the fetched lease may be outdated.
+    ///
+    /// @param lease Lease returned by the backend or NULL.
+    /// @param generation Number of the writes made before the lookup.
+    /// @return the lease.
+    Lease4Ptr fetched4(const Lease4Ptr& lease,
+                       const uint64_t generation) const;
+
+    /// @brief Stores the DHCPv6 lease fetched from the backend in the cache.
+    ///
+    /// The lease is not stored if it has been written since the lookup
+    /// started, as the fetched lease may be outdated.
+    ///
+    /// @param lease Lease returned by the backend or NULL.
+    /// @param generation Number of the writes made before the lookup.
+    /// @return the lease.
+    Lease6Ptr fetched6(const Lease6Ptr& lease,
+                       const uint64_t generation) const;
+
+    /// @brief Marks the start of the write of the lease.
+    ///
+    /// Removes the lease from the cache, so as it is not returned until
+    /// the write completes, and records the write.
+    ///
+    /// @param addr IPv4 or IPv6 address of the lease.
+    void startWrite(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Records the start or the completion of the write of the lease.
+    ///
+    /// The caller must hold the mutex.
+    ///
+    /// @param addr IPv4 or IPv6 address of the lease.
+    void written(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Checks if the lease has been written since the lookup started.
+    ///
+    /// The caller must hold the mutex.
+    ///
+    /// @param addr IPv4 or IPv6 address of the lease.
+    /// @param generation Number of the writes made before the lookup.
+    /// @return true if the lease has been written or if the writes made
+    ///         since the lookup started are no longer remembered.
+    bool writtenSince(const isc::asiolink::IOAddress& addr,
+                      const uint64_t generation) const;
+
+    /// @brief Completes the asynchronous DHCPv4 lookup.
+    ///
+    /// @param callback Callback of the caller.
+    /// @param generation Number of the writes made before the lookup.
+    /// @param lease Lease returned by the backend or NULL.
+    /// @param error Error message or empty string.
+    void asyncLease4Fetched(const Lease4Callback& callback,
+                            const uint64_t generation,
+                            const Lease4Ptr& lease, const std::string& error);
+
+    /// @brief Completes the asynchronous DHCPv6 lookup.
+    ///
+    /// @param callback Callback of the caller.
+    /// @param generation Number of the writes made before the lookup.
+    /// @param lease Lease returned by the backend or NULL.
+    /// @param error Error message or empty string.
+    void asyncLease6Fetched(const Lease6Callback& callback,
+                            const uint64_t generation,
+                            const Lease6Ptr& lease, const std::string& error);
+
+    /// @brief Completes the asynchronous write of the DHCPv4 lease.
+    ///
+    /// @param callback Callback of the caller.
+    /// @param lease Copy of the written lease.
+    /// @param result Result of the write.
+    /// @param error Error message or empty string.
+    void asyncLease4Written(const ResultCallback& callback,
+                            const Lease4Ptr& lease, const bool result,
+                            const std::string& error);
+
+    /// @brief Completes the asynchronous write of the DHCPv6 lease.
+    ///
+    /// @param callback Callback of the caller.
+    /// @param lease Copy of the written lease.
+    /// @param result Result of the write.
+    /// @param error Error message or empty string.
+    void asyncLease6Written(const ResultCallback& callback,
+                            const Lease6Ptr& lease, const bool result,
+                            const std::string& error);
+
+    /// @brief Completes the asynchronous deletion of the lease.
+    ///
+    /// @param callback Callback of the caller.
+    /// @param addr Address of the deleted lease.
+    /// @param result Result of the deletion.
+    /// @param error Error message or empty string.
+    void asyncLeaseDeleted(const ResultCallback& callback,
+                           const isc::asiolink::IOAddress& addr,
+                           const bool result, const std::string& error);
+
+    /// @brief Lease manager holding the leases.
+    boost::scoped_ptr<LeaseMgr> backend_;
+
+    /// @brief Maximum number of the leases of each type in the cache.
+    size_t capacity_;
+
+    /// @brief Pool of the hostnames and comments of the cached leases.
+    ///
+    /// It must outlive the cached leases referencing it.
+    mutable StringPool strings_;
+
+    /// @brief Cached DHCPv4 leases.
+    mutable Lease4Cache cache4_;
+
+    /// @brief Cached DHCPv6 leases.
+    mutable Lease6Cache cache6_;
+
+    /// @brief Number of lookups answered from the cache.
+    mutable uint64_t hits_;
+
+    /// @brief Number of lookups forwarded to the backend.
+    mutable uint64_t misses_;
+
+    /// @brief Number of the recent writes whose addresses are remembered.
+    static const size_t WRITES_SIZE = 256;
+
+    /// @brief Number of the started and completed writes.
+    uint64_t generation_;
+
+    /// @brief Addresses of the recent writes.
+    ///
+    /// The address of the write numbered N is held at the position N modulo
+    /// @c WRITES_SIZE. The leases fetched from the backend are only stored
+    /// in the cache if they haven't been written during the lookup.
+    std::vector<isc::asiolink::IOAddress> writes_;
+
+    /// @brief Mutex protecting the cache and the counters.
+    ///
+    /// The backend is called without holding the mutex.
+    mutable isc::util::thread::Mutex mutex_;
+};
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // CACHING_LEASE_MGR_H
@@ -17,6 +17,14 @@
 
 #include <hooks/hooks_manager.h>
 #include <hooks/callout_handle.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <map>
+#include <utility>
+
+#include <pthread.h>
 
 namespace isc {
 namespace dhcp {
@@ -27,23 +35,23 @@ namespace dhcp {
 /// isc::hooks::CalloutHandle object with each request passing through the
 /// server.  For the DHCP servers, the association is provided by this function.
 ///
-/// The DHCP servers process a single request at a time. At points where the
+/// Each thread processes a single request at a time. At points where the
 /// CalloutHandle is required, the pointer to the current request (packet) is
-/// passed to this function.  If the request is a new one, a pointer to
-/// the request is stored, a new CalloutHandle is allocated (and stored) and
-/// a pointer to the latter object returned to the caller.  If the request
-/// matches the one stored, the pointer to the stored CalloutHandle is
-/// returned.
+/// passed to this function.  If the request is a new one for the calling
+/// thread, a pointer to the request is stored, a new CalloutHandle is
+/// allocated (and stored) and a pointer to the latter object returned to the
+/// caller.  If the request matches the one stored for the calling thread,
+/// the pointer to the stored CalloutHandle is returned.
 ///
 /// A special case is a null pointer being passed.  This has the effect of
-/// clearing the stored pointers to the packet being processed and
-/// CalloutHandle.  As the stored pointers are shared pointers, clearing them
-/// removes one reference that keeps the pointed-to objects in existence.
+/// clearing the stored pointers to the packet being processed by the calling
+/// thread and its CalloutHandle.  As the stored pointers are shared pointers,
+/// clearing them removes one reference that keeps the pointed-to objects in
+/// existence.
 ///
-/// @note If the behaviour of the server changes so that multiple packets can
-///       be active at the same time, this simplistic approach will no longer
-///       be adequate and a more complicated structure (such as a map) will
-///       be needed.
+/// @note The pointers are stored per thread, in a map indexed by the thread
+///       identifier, so as the server can process packets on multiple
+///       threads concurrently.
 ///
 /// @param pktptr Pointer to the packet being processed.  This is typically a
 ///        Pkt4Ptr or Pkt6Ptr object.  An empty pointer is passed to clear
@@ -51,40 +59,73 @@ namespace dhcp {
 ///
 /// @return Shared pointer to a CalloutHandle.  This is the previously-stored
 ///         CalloutHandle if pktptr points to a packet that has been seen
-///         before or a new CalloutHandle if it points to a new one.  An empty
-///         pointer is returned if pktptr is itself an empty pointer.
+///         before by the calling thread or a new CalloutHandle if it points
+///         to a new one.  An empty pointer is returned if pktptr is itself an
+///         empty pointer.
 
 template <typename T>
 isc::hooks::CalloutHandlePtr getCalloutHandle(const T& pktptr) {
 
+    // Pointer to the last packet seen by a thread and pointer to the handle
+    // created for this packet.
+    typedef std::pair<T, isc::hooks::CalloutHandlePtr> StoredData;
+
     // Stored data is declared static, so is initialized when first accessed
-    static T stored_pointer;                // Pointer to last packet seen
-    static isc::hooks::CalloutHandlePtr stored_handle;
-                                            // Pointer to stored handle
+    static isc::util::thread::Mutex store_mutex;
+    static std::map<pthread_t, StoredData> store;
+
+    isc::util::thread::Mutex::Locker lock(store_mutex);
 
     if (pktptr) {
 
-        // Pointer given, have we seen it before? (If we have, we don't need to
-        // do anything as we will automatically return the stored handle.)
-        if (pktptr != stored_pointer) {
+        // Pointer given, has this thread seen it before? (If it has, we don't
+        // need to do anything as we will automatically return the stored
+        // handle.)
+        StoredData& stored = store[pthread_self()];
+        if (pktptr != stored.first) {
 
             // Not seen before, so store the pointer passed to us and get a new
             // CalloutHandle.  (The latter operation frees and probably deletes
             // (depending on other pointers) the stored one.)
-            stored_pointer = pktptr;
-            stored_handle = isc::hooks::HooksManager::createCalloutHandle();
+            stored.first = pktptr;
+            stored.second = isc::hooks::HooksManager::createCalloutHandle();
         }
-        
-    } else {
+        return (stored.second);
 
-        // Empty pointer passed, clear stored data
-        stored_pointer.reset();
-        stored_handle.reset();
     }
 
-    return (stored_handle);
+    // Empty pointer passed, clear stored data
+    store.erase(pthread_self());
+    return (isc::hooks::CalloutHandlePtr());
 }
 
+/// @brief Clears the pointers stored by @c getCalloutHandle for the
+/// calling thread when it goes out of scope.
+///
+/// The server creates this object when it starts processing a packet, so
+/// as the stored packet and its CalloutHandle are released when the
+/// processing ends, whichever way it ends. Otherwise each thread would
+/// keep them until it processes the next packet, and the handles would
+/// keep referring to the hooks libraries after they have been reloaded.
+///
+/// @tparam T Type of the packet pointer, e.g. Pkt4Ptr or Pkt6Ptr.
+template <typename T>
+class CalloutHandleReleaser : public boost::noncopyable {
+public:
+
+    /// @brief Destructor.
+    ///
+    /// Clears the pointers stored for the calling thread.
+    ~CalloutHandleReleaser() {
+        try {
+            getCalloutHandle(T());
+        } catch (...) {
+            // The mutex can't fail unless it is misused, and we can't
+            // throw here anyway.
+        }
+    }
+};
+
 } // namespace shcp
 } // namespace isc
 
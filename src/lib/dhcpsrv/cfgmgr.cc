@@ -17,6 +17,9 @@
 #include <dhcp/libdhcp++.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
+
+#include <algorithm>
+#include <iterator>
 #include <string>
 
 using namespace isc::asiolink;
@@ -25,6 +28,10 @@ using namespace isc::util;
 namespace isc {
 namespace dhcp {
 
+const uint32_t CfgMgr::DEFAULT_RECLAIM_TIMER_WAIT_TIME;
+const uint32_t CfgMgr::DEFAULT_MAX_RECLAIM_LEASES;
+const uint32_t CfgMgr::DEFAULT_MAX_RECLAIM_TIME;
+
 CfgMgr&
 CfgMgr::instance() {
     static CfgMgr cfg_mgr;
@@ -134,20 +141,20 @@ CfgMgr::getSubnet6(const std::string& iface,
     }
 
     // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    const SubnetIndex::Positions& positions = subnets6_index_.getByIface(iface);
+    for (SubnetIndex::Positions::const_iterator pos = positions.begin();
+         pos != positions.end(); ++pos) {
+        const Subnet6Ptr& subnet = subnets6_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
-        if (iface == (*subnet)->getIface()) {
-            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
-                      DHCPSRV_CFGMGR_SUBNET6_IFACE)
-                .arg((*subnet)->toText()).arg(iface);
-            return (*subnet);
-        }
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_CFGMGR_SUBNET6_IFACE)
+            .arg(subnet->toText()).arg(iface);
+        return (subnet);
     }
     return (Subnet6Ptr());
 }
@@ -157,28 +164,34 @@ CfgMgr::getSubnet6(const isc::asiolink::IOAddress& hint,
                    const isc::dhcp::ClientClasses& classes,
                    const bool relay) {
 
+    // Find the subnets containing the address and, for relays, the subnets
+    // with the matching relay address, in the configuration order.
+    SubnetIndex::Positions positions;
+    getCandidates(subnets6_index_, hint, relay, positions);
+
     // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    for (SubnetIndex::Positions::const_iterator pos = positions.begin();
+         pos != positions.end(); ++pos) {
+        const Subnet6Ptr& subnet = subnets6_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
         // If the hint is a relay address, and there is relay info specified
         // for this subnet and those two match, then use this subnet.
-        if (relay && ((*subnet)->getRelayInfo().addr_ == hint) ) {
+        if (relay && (subnet->getRelayInfo().addr_ == hint) ) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET6_RELAY)
-                .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
 
-        if ((*subnet)->inRange(hint)) {
+        if (subnet->inRange(hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_SUBNET6)
-                      .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                      .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
     }
 
@@ -194,22 +207,25 @@ Subnet6Ptr CfgMgr::getSubnet6(OptionPtr iface_id_option,
         return (Subnet6Ptr());
     }
 
-    // Let's iterate over all subnets and for those that have interface-id
-    // defined, check if the interface-id is equal to what we are looking for
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    // Let's iterate over the subnets which have the interface-id with the
+    // same contents and check if it is equal to what we are looking for
+    const SubnetIndex::Positions& positions =
+        subnets6_index_.getByInterfaceId(iface_id_option);
+    for (SubnetIndex::Positions::const_iterator pos = positions.begin();
+         pos != positions.end(); ++pos) {
+        const Subnet6Ptr& subnet = subnets6_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
-        if ( (*subnet)->getInterfaceId() &&
-             ((*subnet)->getInterfaceId()->equal(iface_id_option))) {
+        if (subnet->getInterfaceId() &&
+            subnet->getInterfaceId()->equal(iface_id_option)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET6_IFACE_ID)
-                .arg((*subnet)->toText());
-            return (*subnet);
+                .arg(subnet->toText());
+            return (subnet);
         }
     }
     return (Subnet6Ptr());
@@ -226,37 +242,44 @@ void CfgMgr::addSubnet6(const Subnet6Ptr& subnet) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET6)
               .arg(subnet->toText());
     subnets6_.push_back(subnet);
+    subnets6_index_.add(*subnet, subnets6_.size() - 1);
 }
 
 Subnet4Ptr
 CfgMgr::getSubnet4(const isc::asiolink::IOAddress& hint,
                    const isc::dhcp::ClientClasses& classes,
                    bool relay) const {
-    // Iterate over existing subnets to find a suitable one for the
+    // Find the subnets containing the address and, for relays, the subnets
+    // with the matching relay address, in the configuration order.
+    SubnetIndex::Positions positions;
+    getCandidates(subnets4_index_, hint, relay, positions);
+
+    // Iterate over these subnets to find a suitable one for the
     // given address.
-    for (Subnet4Collection::const_iterator subnet = subnets4_.begin();
-         subnet != subnets4_.end(); ++subnet) {
+    for (SubnetIndex::Positions::const_iterator pos = positions.begin();
+         pos != positions.end(); ++pos) {
+        const Subnet4Ptr& subnet = subnets4_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
         // If the hint is a relay address, and there is relay info specified
         // for this subnet and those two match, then use this subnet.
-        if (relay && ((*subnet)->getRelayInfo().addr_ == hint) ) {
+        if (relay && (subnet->getRelayInfo().addr_ == hint) ) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET4_RELAY)
-                .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
 
         // Let's check if the client belongs to the given subnet
-        if ((*subnet)->inRange(hint)) {
+        if (subnet->inRange(hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET4)
-                      .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                      .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
     }
 
@@ -293,6 +316,7 @@ void CfgMgr::addSubnet4(const Subnet4Ptr& subnet) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET4)
               .arg(subnet->toText());
     subnets4_.push_back(subnet);
+    subnets4_index_.add(*subnet, subnets4_.size() - 1);
 }
 
 void CfgMgr::deleteOptionDefs() {
@@ -302,11 +326,21 @@ void CfgMgr::deleteOptionDefs() {
 void CfgMgr::deleteSubnets4() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET4);
     subnets4_.clear();
+    subnets4_index_.clear();
+}
+
+void CfgMgr::commitSubnets4() {
+    subnets4_index_.build(subnets4_);
 }
 
 void CfgMgr::deleteSubnets6() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET6);
     subnets6_.clear();
+    subnets6_index_.clear();
+}
+
+void CfgMgr::commitSubnets6() {
+    subnets6_index_.build(subnets6_);
 }
 
 
@@ -314,6 +348,23 @@ std::string CfgMgr::getDataDir() {
     return (datadir_);
 }
 
+void
+CfgMgr::getCandidates(const SubnetIndex& index,
+                      const isc::asiolink::IOAddress& hint, const bool relay,
+                      SubnetIndex::Positions& positions) {
+    index.getByAddress(hint, positions);
+    if (relay) {
+        const SubnetIndex::Positions& relayed = index.getByRelay(hint);
+        if (!relayed.empty()) {
+            SubnetIndex::Positions in_range;
+            in_range.swap(positions);
+            std::set_union(in_range.begin(), in_range.end(),
+                           relayed.begin(), relayed.end(),
+                           std::back_inserter(positions));
+        }
+    }
+}
+
 bool
 CfgMgr::isDuplicate(const Subnet4& subnet) const {
     for (Subnet4Collection::const_iterator subnet_it = subnets4_.begin();
@@ -364,6 +415,11 @@ CfgMgr::getConfiguration() {
 
 CfgMgr::CfgMgr()
     : datadir_(DHCP_DATA_DIR), echo_v4_client_id_(true),
+      worker_threads_(0),
+      reclaim_timer_wait_time_(DEFAULT_RECLAIM_TIMER_WAIT_TIME),
+      max_reclaim_leases_(DEFAULT_MAX_RECLAIM_LEASES),
+      max_reclaim_time_(DEFAULT_MAX_RECLAIM_TIME),
+      free_address_tracking_(false),
       d2_client_mgr_(), configuration_(new Configuration()) {
     // DHCP_DATA_DIR must be set set with -DDHCP_DATA_DIR="..." in Makefile.am
     // Note: the definition of DHCP_DATA_DIR needs to include quotation marks
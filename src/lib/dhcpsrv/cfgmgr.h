@@ -24,6 +24,7 @@
 #include <dhcpsrv/option_space_container.h>
 #include <dhcpsrv/pool.h>
 #include <dhcpsrv/subnet.h>
+#include <dhcpsrv/subnet_index.h>
 #include <dhcpsrv/configuration.h>
 #include <util/buffer.h>
 
@@ -95,6 +96,17 @@ public:
 class CfgMgr : public boost::noncopyable {
 public:
 
+    /// @name Default values of the expired leases reclamation parameters.
+    ///
+    //@{
+    /// Interval between the reclamations of expired leases (seconds).
+    static const uint32_t DEFAULT_RECLAIM_TIMER_WAIT_TIME = 10;
+    /// Maximum number of leases reclaimed in one cycle.
+    static const uint32_t DEFAULT_MAX_RECLAIM_LEASES = 100;
+    /// Maximum duration of one reclamation cycle (milliseconds).
+    static const uint32_t DEFAULT_MAX_RECLAIM_TIME = 250;
+    //@}
+
     /// @brief returns a single instance of Configuration Manager
     ///
     /// CfgMgr is a singleton and this method is the only way of
@@ -250,6 +262,14 @@ public:
     /// completely new?
     void deleteSubnets6();
 
+    /// @brief Rebuilds the index used to select the IPv6 subnets.
+    ///
+    /// The subnets are indexed when they are added, using their relay
+    /// address, interface name and interface-id. This method is called
+    /// when the configuration of the subnets is committed, so as these
+    /// values set after adding the subnets are used to select them.
+    void commitSubnets6();
+
     /// @brief Returns pointer to the collection of all IPv4 subnets.
     ///
     /// This is used in a hook (subnet4_select), where the hook is able
@@ -326,6 +346,14 @@ public:
     /// completely new?
     void deleteSubnets4();
 
+    /// @brief Rebuilds the index used to select the IPv4 subnets.
+    ///
+    /// The subnets are indexed when they are added, using their relay
+    /// address and interface name. This method is called when the
+    /// configuration of the subnets is committed, so as these values set
+    /// after adding the subnets are used to select them.
+    void commitSubnets4();
+
 
     /// @brief returns path do the data directory
     ///
@@ -350,6 +378,79 @@ public:
         return (echo_v4_client_id_);
     }
 
+    /// @brief Sets the number of threads processing received packets.
+    ///
+    /// The value of 0 (default) means that the packets are processed by
+    /// the thread receiving them, one at a time.
+    ///
+    /// @param threads number of packet processing threads
+    void workerThreads(const uint32_t threads) {
+        worker_threads_ = threads;
+    }
+
+    /// @brief Returns the number of threads processing received packets.
+    /// @return number of packet processing threads (0 if none).
+    uint32_t workerThreads() const {
+        return (worker_threads_);
+    }
+
+    /// @brief Sets the interval between the reclamations of expired leases.
+    ///
+    /// The value of 0 disables the reclamation of expired leases.
+    ///
+    /// @param wait_time interval in seconds
+    void reclaimTimerWaitTime(const uint32_t wait_time) {
+        reclaim_timer_wait_time_ = wait_time;
+    }
+
+    /// @brief Returns the interval between the reclamations of expired leases.
+    /// @return interval in seconds (0 if the reclamation is disabled).
+    uint32_t reclaimTimerWaitTime() const {
+        return (reclaim_timer_wait_time_);
+    }
+
+    /// @brief Sets the maximum number of leases reclaimed in one cycle.
+    ///
+    /// @param max_leases maximum number of leases (0 means no limit)
+    void maxReclaimLeases(const uint32_t max_leases) {
+        max_reclaim_leases_ = max_leases;
+    }
+
+    /// @brief Returns the maximum number of leases reclaimed in one cycle.
+    /// @return maximum number of leases (0 if not limited).
+    uint32_t maxReclaimLeases() const {
+        return (max_reclaim_leases_);
+    }
+
+    /// @brief Sets the maximum duration of one reclamation cycle.
+    ///
+    /// @param max_time maximum duration in milliseconds (0 means no limit)
+    void maxReclaimTime(const uint32_t max_time) {
+        max_reclaim_time_ = max_time;
+    }
+
+    /// @brief Returns the maximum duration of one reclamation cycle.
+    /// @return maximum duration in milliseconds (0 if not limited).
+    uint32_t maxReclaimTime() const {
+        return (max_reclaim_time_);
+    }
+
+    /// @brief Enables or disables the tracking of free addresses in pools.
+    ///
+    /// When enabled, the allocation engine keeps a bitmap of free addresses
+    /// for each pool and uses it to pick new addresses.
+    ///
+    /// @param enabled true if the free addresses should be tracked
+    void freeAddressTracking(const bool enabled) {
+        free_address_tracking_ = enabled;
+    }
+
+    /// @brief Checks if the free addresses in pools are tracked.
+    /// @return true if the free address tracking is enabled.
+    bool freeAddressTracking() const {
+        return (free_address_tracking_);
+    }
+
     /// @brief Updates the DHCP-DDNS client configuration to the given value.
     ///
     /// @param new_config pointer to the new client configuration.
@@ -394,22 +495,46 @@ protected:
 
     /// @brief a container for IPv6 subnets.
     ///
-    /// That is a simple vector of pointers. It does not make much sense to
-    /// optimize access time (e.g. using a map), because typical search
-    /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
+    /// That is a simple vector of pointers, which keeps the subnets in the
+    /// configuration order. The subnets are selected using the
+    /// @c subnets6_index_.
     Subnet6Collection subnets6_;
 
     /// @brief a container for IPv4 subnets.
     ///
-    /// That is a simple vector of pointers. It does not make much sense to
-    /// optimize access time (e.g. using a map), because typical search
-    /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
+    /// That is a simple vector of pointers, which keeps the subnets in the
+    /// configuration order. The subnets are selected using the
+    /// @c subnets4_index_.
     Subnet4Collection subnets4_;
 
+    /// @brief Index of the IPv6 subnets held in @c subnets6_.
+    ///
+    /// The index is only read by the lookups, which are performed
+    /// concurrently by the worker threads. It is modified along with
+    /// the subnets, when the server is configured.
+    SubnetIndex subnets6_index_;
+
+    /// @brief Index of the IPv4 subnets held in @c subnets4_.
+    ///
+    /// The index is only read by the lookups, which are performed
+    /// concurrently by the worker threads. It is modified along with
+    /// the subnets, when the server is configured.
+    SubnetIndex subnets4_index_;
+
 private:
 
+    /// @brief Returns positions of the subnets matching the address.
+    ///
+    /// @param index Index of the subnets.
+    /// @param hint Address which belongs to the searched subnet.
+    /// @param relay true if the address is a relay address, in which case
+    /// the subnets with the matching relay address are also returned.
+    /// @param [out] positions Sorted positions of the subnets.
+    static void getCandidates(const SubnetIndex& index,
+                              const isc::asiolink::IOAddress& hint,
+                              const bool relay,
+                              SubnetIndex::Positions& positions);
+
     /// @brief Checks that the IPv4 subnet with the given id already exists.
     ///
     /// @param subnet Subnet for which this function will check if the other
@@ -443,6 +568,21 @@ private:
     /// Indicates whether v4 server should send back client-id
     bool echo_v4_client_id_;
 
+    /// Number of threads processing received packets
+    uint32_t worker_threads_;
+
+    /// Interval between the reclamations of expired leases (seconds)
+    uint32_t reclaim_timer_wait_time_;
+
+    /// Maximum number of leases reclaimed in one cycle
+    uint32_t max_reclaim_leases_;
+
+    /// Maximum duration of one reclamation cycle (milliseconds)
+    uint32_t max_reclaim_time_;
+
+    /// Indicates whether the free addresses in pools are tracked
+    bool free_address_tracking_;
+
     /// @brief Manages the DHCP-DDNS client and its configuration.
     D2ClientMgr d2_client_mgr_;
 
@@ -0,0 +1,75 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/client_lock_mgr.h>
+
+using namespace isc::util::thread;
+
+namespace isc {
+namespace dhcp {
+
+ClientLockMgr::Locker::Locker(ClientLockMgr& mgr, const ClientId& client_id,
+                              const bool block)
+    : mgr_(mgr), client_id_(client_id), busy_(false) {
+    if (client_id_.empty()) {
+        return;
+    }
+    if (block) {
+        mgr_.lock(client_id_);
+    } else {
+        busy_ = !mgr_.tryLock(client_id_);
+    }
+}
+
+ClientLockMgr::Locker::~Locker() {
+    if (!client_id_.empty() && !busy_) {
+        mgr_.unlock(client_id_);
+    }
+}
+
+ClientLockMgr::ClientLockMgr()
+    : locked_() {
+}
+
+bool
+ClientLockMgr::isLocked(const ClientId& client_id) const {
+    Mutex::Locker lock(mutex_);
+    return (locked_.count(client_id) > 0);
+}
+
+void
+ClientLockMgr::lock(const ClientId& client_id) {
+    Mutex::Locker lock(mutex_);
+    while (!locked_.insert(client_id).second) {
+        cond_var_.wait(mutex_);
+    }
+}
+
+bool
+ClientLockMgr::tryLock(const ClientId& client_id) {
+    Mutex::Locker lock(mutex_);
+    return (locked_.insert(client_id).second);
+}
+
+void
+ClientLockMgr::unlock(const ClientId& client_id) {
+    Mutex::Locker lock(mutex_);
+    locked_.erase(client_id);
+    // The waiting threads may wait for different clients, so all of them
+    // have to be woken up to check if their client has been released.
+    cond_var_.broadcast();
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
@@ -0,0 +1,149 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef CLIENT_LOCK_MGR_H
+#define CLIENT_LOCK_MGR_H
+
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Serializes processing of packets sent by the same client.
+///
+/// When the server processes packets on multiple threads, two packets sent
+/// by the same client (e.g. a retransmitted Request) may be processed at the
+/// same time. Such packets would race for the same leases. This class
+/// allows a thread to "lock" a client identified by an opaque identifier
+/// (typically the DUID or client identifier). Another thread trying to lock
+/// the same client is either blocked until the first thread releases the
+/// lock or, if it doesn't block, finds out that the client is busy.
+/// Packets sent by different clients are processed concurrently.
+///
+/// The lock is acquired and released using the @c ClientLockMgr::Locker
+/// object. The server threads should not block, as a client sending
+/// packets quickly would hold all of them waiting for the same lock. The
+/// packet is rather dropped if the client is busy:
+///
+/// @code
+///     {
+///         ClientLockMgr::Locker lock(client_lock_mgr, duid->getDuid(),
+///                                    false);
+///         if (lock.busy()) {
+///             // Drop the packet.
+///             return;
+///         }
+///         // Process the packet.
+///     }
+/// @endcode
+class ClientLockMgr : public boost::noncopyable {
+public:
+
+    /// @brief Type of the client identifier.
+    typedef std::vector<uint8_t> ClientId;
+
+    /// @brief Locks the client for the lifetime of this object.
+    class Locker : public boost::noncopyable {
+    public:
+
+        /// @brief Constructor.
+        ///
+        /// Locks the client. If the client is locked by another thread,
+        /// blocks until it is released if @c block is true. Otherwise, the
+        /// client is not locked by this object and @ref busy returns true.
+        /// An empty identifier is not locked.
+        ///
+        /// @param mgr Lock manager.
+        /// @param client_id Client identifier.
+        /// @param block true if the constructor should wait for the client
+        /// to be released by other thread.
+        Locker(ClientLockMgr& mgr, const ClientId& client_id,
+               const bool block = true);
+
+        /// @brief Destructor.
+        ///
+        /// Releases the lock, if held.
+        ~Locker();
+
+        /// @brief Checks if the client was locked by other thread.
+        ///
+        /// @return true if the non-blocking constructor found the client
+        /// locked by other thread, false if the client is now locked by
+        /// this object or the identifier is empty.
+        bool busy() const {
+            return (busy_);
+        }
+
+    private:
+
+        /// @brief Lock manager.
+        ClientLockMgr& mgr_;
+
+        /// @brief Locked client identifier.
+        ClientId client_id_;
+
+        /// @brief Indicates if the client was locked by other thread.
+        bool busy_;
+    };
+
+    /// @brief Constructor.
+    ClientLockMgr();
+
+    /// @brief Checks if the client is locked.
+    ///
+    /// @param client_id Client identifier.
+    ///
+    /// @return true if the client is locked by any thread.
+    bool isLocked(const ClientId& client_id) const;
+
+private:
+
+    /// @brief Locks the client, waiting until it is released by other thread.
+    ///
+    /// @param client_id Client identifier.
+    void lock(const ClientId& client_id);
+
+    /// @brief Locks the client unless it is locked by other thread.
+    ///
+    /// @param client_id Client identifier.
+    ///
+    /// @return true if the client has been locked, false if it is locked
+    /// by other thread.
+    bool tryLock(const ClientId& client_id);
+
+    /// @brief Releases the client and wakes up the waiting threads.
+    ///
+    /// @param client_id Client identifier.
+    void unlock(const ClientId& client_id);
+
+    /// @brief Identifiers of the locked clients.
+    std::set<ClientId> locked_;
+
+    /// @brief Mutex protecting the set of locked clients.
+    mutable isc::util::thread::Mutex mutex_;
+
+    /// @brief Condition variable used to wake up threads waiting for a lock.
+    isc::util::thread::CondVar cond_var_;
+};
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
+
+#endif // CLIENT_LOCK_MGR_H
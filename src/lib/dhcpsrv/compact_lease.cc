@@ -0,0 +1,237 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/compact_lease.h>
+#include <exceptions/exceptions.h>
+
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace isc::asiolink;
+
+namespace isc {
+namespace dhcp {
+
+CompactId::CompactId()
+    : size_(0) {
+}
+
+CompactId::CompactId(const std::vector<uint8_t>& id)
+    : size_(0) {
+    assign(id.empty() ? NULL : &id[0], id.size());
+}
+
+CompactId::CompactId(const CompactId& other)
+    : size_(0) {
+    assign(other.data(), other.size());
+}
+
+CompactId::~CompactId() {
+    release();
+}
+
+CompactId&
+CompactId::operator=(const CompactId& other) {
+    if (this != &other) {
+        release();
+        assign(other.data(), other.size());
+    }
+    return (*this);
+}
+
+bool
+CompactId::operator==(const CompactId& other) const {
+    return ((size_ == other.size_) &&
+            (std::memcmp(data(), other.data(), size_) == 0));
+}
+
+void
+CompactId::assign(const uint8_t* data, const size_t size) {
+    if (size > MAX_SIZE) {
+        isc_throw(BadValue, "identifier length " << size << " exceeds the"
+                  " maximum length of " << MAX_SIZE);
+    }
+    if (size > INLINE_CAPACITY) {
+        data_.external_ = new uint8_t[size];
+        std::memcpy(data_.external_, data, size);
+    } else if (size > 0) {
+        std::memcpy(data_.inline_, data, size);
+    }
+    size_ = static_cast<uint8_t>(size);
+}
+
+void
+CompactId::release() {
+    if (size_ > INLINE_CAPACITY) {
+        delete[] data_.external_;
+    }
+    size_ = 0;
+}
+
+size_t
+hash_value(const CompactId& id) {
+    return (boost::hash_range(id.data(), id.data() + id.size()));
+}
+
+InternedString
+StringPool::intern(const std::string& str) {
+    if (str.empty()) {
+        return (InternedString());
+    }
+    std::pair<StringMap::iterator, bool> entry =
+        strings_.insert(StringMap::value_type(str, Counter(this)));
+    return (InternedString(&(*entry.first)));
+}
+
+InternedString::InternedString(StringPool::StringMap::value_type* entry)
+    : entry_(entry) {
+    ++entry_->second.refs_;
+}
+
+InternedString::InternedString(const InternedString& other)
+    : entry_(other.entry_) {
+    if (entry_) {
+        ++entry_->second.refs_;
+    }
+}
+
+InternedString&
+InternedString::operator=(const InternedString& other) {
+    if (entry_ != other.entry_) {
+        release();
+        entry_ = other.entry_;
+        if (entry_) {
+            ++entry_->second.refs_;
+        }
+    }
+    return (*this);
+}
+
+const std::string&
+InternedString::str() const {
+    static const std::string empty;
+    return (entry_ ? entry_->first : empty);
+}
+
+void
+InternedString::release() {
+    if (entry_ && (--entry_->second.refs_ == 0)) {
+        StringPool::StringMap& strings = entry_->second.pool_->strings_;
+        strings.erase(strings.find(entry_->first));
+    }
+    entry_ = NULL;
+}
+
+CompactLease4::CompactLease4(const Lease4& lease, StringPool& strings)
+    : addr_(static_cast<uint32_t>(lease.addr_)), t1_(lease.t1_),
+      t2_(lease.t2_), valid_lft_(lease.valid_lft_), cltt_(lease.cltt_),
+      subnet_id_(lease.subnet_id_), ext_(lease.ext_),
+      hwaddr_(lease.hwaddr_), client_id_(lease.getClientIdVector()),
+      hostname_(strings.intern(lease.hostname_)),
+      comments_(strings.intern(lease.comments_)), fixed_(lease.fixed_),
+      fqdn_fwd_(lease.fqdn_fwd_), fqdn_rev_(lease.fqdn_rev_) {
+}
+
+Lease4Ptr
+CompactLease4::toLease() const {
+    Lease4Ptr lease(new Lease4());
+    lease->addr_ = IOAddress(addr_);
+    lease->t1_ = t1_;
+    lease->t2_ = t2_;
+    lease->valid_lft_ = valid_lft_;
+    lease->cltt_ = cltt_;
+    lease->subnet_id_ = subnet_id_;
+    lease->ext_ = ext_;
+    lease->hwaddr_.assign(hwaddr_.data(), hwaddr_.data() + hwaddr_.size());
+    if (!client_id_.empty()) {
+        lease->client_id_.reset(new ClientId(client_id_.data(),
+                                             client_id_.size()));
+    }
+    lease->hostname_ = hostname_.str();
+    lease->comments_ = comments_.str();
+    lease->fixed_ = fixed_;
+    lease->fqdn_fwd_ = fqdn_fwd_;
+    lease->fqdn_rev_ = fqdn_rev_;
+    return (lease);
+}
+
+ConstLease4Ptr
+CompactLease4::getShared() const {
+    ConstLease4Ptr lease = shared_.lock();
+    if (!lease) {
+        lease = toLease();
+        shared_ = lease;
+    }
+    return (lease);
+}
+
+CompactLease6::CompactLease6(const Lease6& lease, StringPool& strings)
+    : addr_(toAddress(lease.addr_)), t1_(lease.t1_), t2_(lease.t2_),
+      valid_lft_(lease.valid_lft_), preferred_lft_(lease.preferred_lft_),
+      cltt_(lease.cltt_), subnet_id_(lease.subnet_id_), iaid_(lease.iaid_),
+      duid_(lease.getDuidVector()), hostname_(strings.intern(lease.hostname_)),
+      comments_(strings.intern(lease.comments_)), type_(lease.type_),
+      prefixlen_(lease.prefixlen_), fixed_(lease.fixed_),
+      fqdn_fwd_(lease.fqdn_fwd_), fqdn_rev_(lease.fqdn_rev_) {
+}
+
+Lease6Ptr
+CompactLease6::toLease() const {
+    Lease6Ptr lease(new Lease6());
+    lease->addr_ = IOAddress(asio::ip::address_v6(addr_));
+    lease->t1_ = t1_;
+    lease->t2_ = t2_;
+    lease->valid_lft_ = valid_lft_;
+    lease->preferred_lft_ = preferred_lft_;
+    lease->cltt_ = cltt_;
+    lease->subnet_id_ = subnet_id_;
+    lease->iaid_ = iaid_;
+    if (!duid_.empty()) {
+        lease->duid_.reset(new DUID(duid_.data(), duid_.size()));
+    }
+    lease->hostname_ = hostname_.str();
+    lease->comments_ = comments_.str();
+    lease->type_ = type_;
+    lease->prefixlen_ = prefixlen_;
+    lease->fixed_ = fixed_;
+    lease->fqdn_fwd_ = fqdn_fwd_;
+    lease->fqdn_rev_ = fqdn_rev_;
+    return (lease);
+}
+
+ConstLease6Ptr
+CompactLease6::getShared() const {
+    ConstLease6Ptr lease = shared_.lock();
+    if (!lease) {
+        lease = toLease();
+        shared_ = lease;
+    }
+    return (lease);
+}
+
+CompactLease6::Address
+CompactLease6::toAddress(const IOAddress& addr) {
+    if (!addr.isV6()) {
+        isc_throw(BadValue, addr << " is not an IPv6 address");
+    }
+    const std::vector<uint8_t> bytes = addr.toBytes();
+    Address binary;
+    std::copy(bytes.begin(), bytes.end(), binary.begin());
+    return (binary);
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
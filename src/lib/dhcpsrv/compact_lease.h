@@ -0,0 +1,506 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef COMPACT_LEASE_H
+#define COMPACT_LEASE_H
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/lease.h>
+
+#include <boost/array.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/pool/singleton_pool.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Variable length client identifier stored inline.
+///
+/// This class holds a hardware address, client identifier or DUID. The
+/// identifiers which are not longer than @c INLINE_CAPACITY bytes (e.g.
+/// Ethernet addresses, client identifiers built from them and the most
+/// common DUID types) are stored in the object itself, so as they don't
+/// require a separate heap allocation. Longer identifiers are copied to
+/// a buffer allocated on the heap.
+///
+/// The empty identifier denotes a lack of identifier.
+class CompactId {
+public:
+
+    /// @brief Maximum length of the identifier stored inline.
+    static const size_t INLINE_CAPACITY = 16;
+
+    /// @brief Maximum length of the identifier.
+    static const size_t MAX_SIZE = 255;
+
+    /// @brief Constructor. Creates an empty identifier.
+    CompactId();
+
+    /// @brief Constructor.
+    ///
+    /// @param id Identifier to be copied.
+    ///
+    /// @throw isc::BadValue if the identifier is longer than @c MAX_SIZE.
+    explicit CompactId(const std::vector<uint8_t>& id);
+
+    /// @brief Copy constructor.
+    ///
+    /// @param other Identifier to be copied.
+    CompactId(const CompactId& other);
+
+    /// @brief Destructor.
+    ~CompactId();
+
+    /// @brief Assignment operator.
+    ///
+    /// @param other Identifier to be copied.
+    CompactId& operator=(const CompactId& other);
+
+    /// @brief Returns pointer to the identifier data.
+    const uint8_t* data() const {
+        return (size_ > INLINE_CAPACITY ? data_.external_ : data_.inline_);
+    }
+
+    /// @brief Returns the length of the identifier.
+    size_t size() const {
+        return (size_);
+    }
+
+    /// @brief Checks if the identifier is empty.
+    bool empty() const {
+        return (size_ == 0);
+    }
+
+    /// @brief Returns the identifier as a vector.
+    std::vector<uint8_t> toVector() const {
+        return (std::vector<uint8_t>(data(), data() + size_));
+    }
+
+    /// @brief Compares two identifiers for equality.
+    ///
+    /// @param other Identifier to compare to.
+    bool operator==(const CompactId& other) const;
+
+    /// @brief Compares two identifiers for inequality.
+    ///
+    /// @param other Identifier to compare to.
+    bool operator!=(const CompactId& other) const {
+        return (!operator==(other));
+    }
+
+private:
+
+    /// @brief Copies the identifier data.
+    ///
+    /// @param data Pointer to the data.
+    /// @param size Length of the data.
+    void assign(const uint8_t* data, const size_t size);
+
+    /// @brief Frees the external buffer (if any) and clears the identifier.
+    void release();
+
+    /// @brief Identifier data, inline or on the heap.
+    union {
+        uint8_t inline_[INLINE_CAPACITY];
+        uint8_t* external_;
+    } data_;
+
+    /// @brief Length of the identifier.
+    uint8_t size_;
+};
+
+/// @brief Computes the hash value of the identifier.
+///
+/// This function allows for using @c CompactId in the hashed indexes.
+///
+/// @param id Identifier for which the hash should be computed.
+size_t hash_value(const CompactId& id);
+
+class InternedString;
+
+/// @brief Pool of interned strings.
+///
+/// The pool holds a single copy of each distinct string stored in it.
+/// The strings are referenced by the @c InternedString objects and
+/// are removed from the pool when the last reference is gone. This
+/// allows for storing hostnames and comments of many leases with only
+/// one pointer per lease.
+///
+/// The pool is not thread safe. The pool must outlive all strings which
+/// are interned in it.
+class StringPool : public boost::noncopyable {
+public:
+
+    /// @brief Interns the string.
+    ///
+    /// @param str String to be interned.
+    ///
+    /// @return Reference to the string in the pool. The empty string is
+    /// not stored in the pool.
+    InternedString intern(const std::string& str);
+
+    /// @brief Returns the number of distinct strings in the pool.
+    size_t size() const {
+        return (strings_.size());
+    }
+
+private:
+
+    friend class InternedString;
+
+    /// @brief Reference counter of the string in the pool.
+    struct Counter {
+
+        /// @brief Constructor.
+        ///
+        /// @param pool Pool holding the string.
+        Counter(StringPool* pool)
+            : refs_(0), pool_(pool) {
+        }
+
+        /// @brief Number of references to the string.
+        size_t refs_;
+
+        /// @brief Pool holding the string.
+        StringPool* pool_;
+    };
+
+    /// @brief Type of the container holding the strings.
+    typedef boost::unordered_map<std::string, Counter> StringMap;
+
+    /// @brief Strings held in the pool.
+    StringMap strings_;
+};
+
+/// @brief Reference to the string held in the @c StringPool.
+class InternedString {
+public:
+
+    /// @brief Constructor. Creates a reference to the empty string.
+    InternedString()
+        : entry_(NULL) {
+    }
+
+    /// @brief Copy constructor.
+    ///
+    /// @param other Reference to be copied.
+    InternedString(const InternedString& other);
+
+    /// @brief Destructor.
+    ///
+    /// Removes the string from the pool if this is the last reference.
+    ~InternedString() {
+        release();
+    }
+
+    /// @brief Assignment operator.
+    ///
+    /// @param other Reference to be copied.
+    InternedString& operator=(const InternedString& other);
+
+    /// @brief Returns the referenced string.
+    const std::string& str() const;
+
+private:
+
+    friend class StringPool;
+
+    /// @brief Constructor.
+    ///
+    /// @param entry Entry in the pool.
+    InternedString(StringPool::StringMap::value_type* entry);
+
+    /// @brief Releases the reference to the string.
+    void release();
+
+    /// @brief Entry in the pool or NULL for the empty string.
+    StringPool::StringMap::value_type* entry_;
+};
+
+/// @brief Compact representation of the DHCPv4 lease.
+///
+/// This structure holds the same information as the @c Lease4, but it is
+/// laid out to minimize the memory footprint and the number of memory
+/// allocations per lease: the address is stored as an integer, the
+/// identifiers are held in @c CompactId objects and the hostname and
+/// comments are interned in the @c StringPool. It is used by the
+/// @c Memfile_LeaseMgr to store the leases. The @c Lease4 objects are
+/// only created when the lease is returned to the caller.
+struct CompactLease4 {
+
+    /// @brief Constructor.
+    ///
+    /// @param lease Lease to be stored.
+    /// @param strings Pool in which hostname and comments are interned.
+    CompactLease4(const Lease4& lease, StringPool& strings);
+
+    /// @brief Creates the @c Lease4 object holding the lease.
+    Lease4Ptr toLease() const;
+
+    /// @brief Returns the shared @c Lease4 object holding the lease.
+    ///
+    /// The object is returned to all readers while any of them holds it,
+    /// so as they share it rather than getting their own copies. When the
+    /// last reader releases it, the object is destroyed and the next call
+    /// creates a new one: the compact lease doesn't keep it alive. The
+    /// object is never modified: the updated lease is stored as a new
+    /// compact lease, and the readers holding the previous version of the
+    /// lease keep it alive. The caller is responsible for serializing the
+    /// calls.
+    ConstLease4Ptr getShared() const;
+
+    /// @brief Returns the time at which the lease expires.
+    int64_t getExpirationTime() const {
+        return (static_cast<int64_t>(cltt_) + valid_lft_);
+    }
+
+    /// @brief IPv4 address.
+    uint32_t addr_;
+
+    /// @brief Renewal timer.
+    uint32_t t1_;
+
+    /// @brief Rebinding timer.
+    uint32_t t2_;
+
+    /// @brief Valid lifetime.
+    uint32_t valid_lft_;
+
+    /// @brief Client last transmission time.
+    time_t cltt_;
+
+    /// @brief Subnet identifier.
+    SubnetID subnet_id_;
+
+    /// @brief Address extension.
+    uint32_t ext_;
+
+    /// @brief Hardware address.
+    CompactId hwaddr_;
+
+    /// @brief Client identifier (empty if the lease has no client id).
+    CompactId client_id_;
+
+    /// @brief Client hostname.
+    InternedString hostname_;
+
+    /// @brief Comments.
+    InternedString comments_;
+
+    /// @brief Fixed lease flag.
+    bool fixed_;
+
+    /// @brief Forward DNS update flag.
+    bool fqdn_fwd_;
+
+    /// @brief Reverse DNS update flag.
+    bool fqdn_rev_;
+
+    /// @brief Shared lease object returned by @c getShared (if held by
+    /// any reader).
+    mutable boost::weak_ptr<const Lease4> shared_;
+};
+
+/// @brief Compact representation of the DHCPv6 lease.
+///
+/// This is a counterpart of the @c CompactLease4 for the @c Lease6.
+struct CompactLease6 {
+
+    /// @brief Type of the IPv6 address in the binary form.
+    typedef boost::array<uint8_t, 16> Address;
+
+    /// @brief Constructor.
+    ///
+    /// @param lease Lease to be stored.
+    /// @param strings Pool in which hostname and comments are interned.
+    CompactLease6(const Lease6& lease, StringPool& strings);
+
+    /// @brief Creates the @c Lease6 object holding the lease.
+    Lease6Ptr toLease() const;
+
+    /// @brief Returns the shared @c Lease6 object holding the lease.
+    ///
+    /// The object is returned to all readers while any of them holds it,
+    /// so as they share it rather than getting their own copies. When the
+    /// last reader releases it, the object is destroyed and the next call
+    /// creates a new one: the compact lease doesn't keep it alive. The
+    /// object is never modified: the updated lease is stored as a new
+    /// compact lease, and the readers holding the previous version of the
+    /// lease keep it alive. The caller is responsible for serializing the
+    /// calls.
+    ConstLease6Ptr getShared() const;
+
+    /// @brief Returns the time at which the lease expires.
+    int64_t getExpirationTime() const {
+        return (static_cast<int64_t>(cltt_) + valid_lft_);
+    }
+
+    /// @brief Converts IPv6 address to the binary form.
+    ///
+    /// @param addr IPv6 address.
+    static Address toAddress(const isc::asiolink::IOAddress& addr);
+
+    /// @brief IPv6 address or prefix.
+    Address addr_;
+
+    /// @brief Renewal timer.
+    uint32_t t1_;
+
+    /// @brief Rebinding timer.
+    uint32_t t2_;
+
+    /// @brief Valid lifetime.
+    uint32_t valid_lft_;
+
+    /// @brief Preferred lifetime.
+    uint32_t preferred_lft_;
+
+    /// @brief Client last transmission time.
+    time_t cltt_;
+
+    /// @brief Subnet identifier.
+    SubnetID subnet_id_;
+
+    /// @brief IAID.
+    uint32_t iaid_;
+
+    /// @brief DUID (empty if the lease has no DUID).
+    CompactId duid_;
+
+    /// @brief Client hostname.
+    InternedString hostname_;
+
+    /// @brief Comments.
+    InternedString comments_;
+
+    /// @brief Lease type.
+    Lease::Type type_;
+
+    /// @brief Prefix length.
+    uint8_t prefixlen_;
+
+    /// @brief Fixed lease flag.
+    bool fixed_;
+
+    /// @brief Forward DNS update flag.
+    bool fqdn_fwd_;
+
+    /// @brief Reverse DNS update flag.
+    bool fqdn_rev_;
+
+    /// @brief Shared lease object returned by @c getShared (if held by
+    /// any reader).
+    mutable boost::weak_ptr<const Lease6> shared_;
+};
+
+/// @brief Tag of the memory pools used by the @c SlabAllocator.
+struct SlabAllocatorTag {
+};
+
+/// @brief Allocator taking single objects from the slabs of memory.
+///
+/// Single objects (e.g. nodes of the lease containers) are allocated
+/// from the pool of chunks of the size of the object, which are carved out of large
+/// blocks of memory. This avoids the overhead of the general purpose
+/// allocator for each lease. Arrays (e.g. buckets of the hashed indexes)
+/// are allocated with the operator new.
+///
+/// The memory taken from the pool is reused for the new objects, but
+/// it is not returned to the system until the program exits.
+template<typename T>
+class SlabAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind {
+        typedef SlabAllocator<U> other;
+    };
+
+    SlabAllocator() {
+    }
+
+    template<typename U>
+    SlabAllocator(const SlabAllocator<U>&) {
+    }
+
+    pointer address(reference value) const {
+        return (&value);
+    }
+
+    const_pointer address(const_reference value) const {
+        return (&value);
+    }
+
+    pointer allocate(const size_type n, const void* = 0) {
+        if (n == 1) {
+            void* p = boost::singleton_pool<SlabAllocatorTag,
+                                            sizeof(T)>::malloc();
+            if (p == NULL) {
+                throw std::bad_alloc();
+            }
+            return (static_cast<pointer>(p));
+        }
+        return (static_cast<pointer>(::operator new(n * sizeof(T))));
+    }
+
+    void deallocate(pointer p, const size_type n) {
+        if (n == 1) {
+            boost::singleton_pool<SlabAllocatorTag, sizeof(T)>::free(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    size_type max_size() const {
+        return (std::numeric_limits<size_type>::max() / sizeof(T));
+    }
+
+    void construct(pointer p, const T& value) {
+        new (p) T(value);
+    }
+
+    void destroy(pointer p) {
+        p->~T();
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const SlabAllocator<T>&, const SlabAllocator<U>&) {
+    return (true);
+}
+
+template<typename T, typename U>
+bool operator!=(const SlabAllocator<T>&, const SlabAllocator<U>&) {
+    return (false);
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
+
+#endif // COMPACT_LEASE_H
@@ -17,6 +17,25 @@
 using namespace isc::asiolink;
 using namespace isc::util;
 
+namespace {
+
+/// @brief Indexes of the columns of the lease file, in the order in which
+/// they are added by @c CSVLeaseFile4::initColumns. The header of the file
+/// being opened must match the columns, so the indexes are fixed.
+enum Column {
+    COLUMN_ADDRESS,
+    COLUMN_HWADDR,
+    COLUMN_CLIENT_ID,
+    COLUMN_VALID_LIFETIME,
+    COLUMN_EXPIRE,
+    COLUMN_SUBNET_ID,
+    COLUMN_FQDN_FWD,
+    COLUMN_FQDN_REV,
+    COLUMN_HOSTNAME
+};
+
+}
+
 namespace isc {
 namespace dhcp {
 
@@ -25,6 +44,42 @@ CSVLeaseFile4::CSVLeaseFile4(const std::string& filename)
     initColumns();
 }
 
+void
+CSVLeaseFile4::setSyncPolicy(const LeaseJournal::SyncPolicy policy,
+                             const uint32_t sync_interval) {
+    journal_.reset(new LeaseJournal(getFilename(), policy, sync_interval));
+}
+
+void
+CSVLeaseFile4::open() {
+    CSVFile::open();
+    if (journal_) {
+        journal_->open();
+    }
+}
+
+void
+CSVLeaseFile4::recreate() {
+    CSVFile::recreate();
+    if (journal_) {
+        journal_->open();
+    }
+}
+
+void
+CSVLeaseFile4::close() {
+    // The journal writes the buffered records before the file is closed.
+    if (journal_) {
+        try {
+            journal_->close();
+        } catch (...) {
+            CSVFile::close();
+            throw;
+        }
+    }
+    CSVFile::close();
+}
+
 void
 CSVLeaseFile4::append(const Lease4& lease) const {
     CSVRow row(getColumnCount());
@@ -41,7 +96,11 @@ CSVLeaseFile4::append(const Lease4& lease) const {
     row.writeAt(getColumnIndex("fqdn_fwd"), lease.fqdn_fwd_);
     row.writeAt(getColumnIndex("fqdn_rev"), lease.fqdn_rev_);
     row.writeAt(getColumnIndex("hostname"), lease.hostname_);
-    CSVFile::append(row);
+    if (journal_) {
+        journal_->write(row.render());
+    } else {
+        CSVFile::append(row);
+    }
 }
 
 bool
@@ -51,39 +110,37 @@ CSVLeaseFile4::next(Lease4Ptr& lease) {
     // to throw exceptions, so we catch them all and rather return the
     // false value.
     try {
-        // Get the row of CSV values.
-        CSVRow row;
-        CSVFile::next(row);
+        // Get the row of CSV values. The values are read in place from the
+        // read buffer of the file.
+        if (!CSVFile::next(row_, true)) {
+            lease.reset();
+            return (false);
+        }
         // The empty row signals EOF.
-        if (row == CSVFile::EMPTY_ROW()) {
+        if (row_.getValuesCount() == 0) {
             lease.reset();
             return (true);
         }
 
-        // Get client id. It is possible that the client id is empty and the
-        // returned pointer is NULL. This is ok, but if the client id is NULL,
-        // we need to be careful to not use the NULL pointer.
-        ClientIdPtr client_id = readClientId(row);
-        std::vector<uint8_t> client_id_vec;
-        if (client_id) {
-            client_id_vec = client_id->getClientId();
-        }
-        size_t client_id_len = client_id_vec.size();
+        // Get client id. It is possible that the client id is empty. This
+        // is ok, but if the client id is empty, we need to be careful to
+        // not use the pointer to its data.
+        const std::vector<uint8_t>& client_id = readClientId(row_);
 
         // Get the HW address. It should never be empty and the readHWAddr checks
         // that.
-        HWAddr hwaddr = readHWAddr(row);
-        lease.reset(new Lease4(readAddress(row),
-                               &hwaddr.hwaddr_[0], hwaddr.hwaddr_.size(),
-                               client_id_vec.empty() ? NULL : &client_id_vec[0],
-                               client_id_len,
-                               readValid(row),
+        const std::vector<uint8_t>& hwaddr = readHWAddr(row_);
+        lease.reset(new Lease4(readAddress(row_),
+                               &hwaddr[0], hwaddr.size(),
+                               client_id.empty() ? NULL : &client_id[0],
+                               client_id.size(),
+                               readValid(row_),
                                0, 0, // t1, t2 = 0
-                               readCltt(row),
-                               readSubnetID(row),
-                               readFqdnFwd(row),
-                               readFqdnRev(row),
-                               readHostname(row)));
+                               readCltt(row_),
+                               readSubnetID(row_),
+                               readFqdnFwd(row_),
+                               readFqdnRev(row_),
+                               readHostname(row_)));
 
     } catch (std::exception& ex) {
         // The lease might have been created, so let's set it back to NULL to
@@ -109,68 +166,66 @@ CSVLeaseFile4::initColumns() {
 }
 
 IOAddress
-CSVLeaseFile4::readAddress(const CSVRow& row) {
-    IOAddress address(row.readAt(getColumnIndex("address")));
+CSVLeaseFile4::readAddress(const CSVRowView& row) {
+    IOAddress address(row.readIPv4At(COLUMN_ADDRESS));
     return (address);
 }
 
-HWAddr
-CSVLeaseFile4::readHWAddr(const CSVRow& row) {
-    HWAddr hwaddr = HWAddr::fromText(row.readAt(getColumnIndex("hwaddr")));
-    if (hwaddr.hwaddr_.empty()) {
+const std::vector<uint8_t>&
+CSVLeaseFile4::readHWAddr(const CSVRowView& row) {
+    row.readHexAt(COLUMN_HWADDR, hwaddr_buffer_);
+    if (hwaddr_buffer_.empty()) {
         isc_throw(isc::BadValue, "hardware address in the lease file"
                   " must not be empty");
+    } else if (hwaddr_buffer_.size() > HWAddr::MAX_HWADDR_LEN) {
+        isc_throw(isc::BadValue, "hardware address in the lease file"
+                  " is too long");
     }
-    return (hwaddr);
+    return (hwaddr_buffer_);
 }
 
-ClientIdPtr
-CSVLeaseFile4::readClientId(const CSVRow& row) {
-    std::string client_id = row.readAt(getColumnIndex("client_id"));
-    // NULL client ids are allowed in DHCPv4.
-    if (client_id.empty()) {
-        return (ClientIdPtr());
-    }
-    ClientIdPtr cid = ClientId::fromText(client_id);
-    return (cid);
+const std::vector<uint8_t>&
+CSVLeaseFile4::readClientId(const CSVRowView& row) {
+    // Empty client ids are allowed in DHCPv4. The length of the client
+    // id is verified when the lease is created.
+    row.readHexAt(COLUMN_CLIENT_ID, client_id_buffer_);
+    return (client_id_buffer_);
 }
 
 uint32_t
-CSVLeaseFile4::readValid(const CSVRow& row) {
-    uint32_t valid =
-        row.readAndConvertAt<uint32_t>(getColumnIndex("valid_lifetime"));
+CSVLeaseFile4::readValid(const CSVRowView& row) {
+    uint32_t valid = row.readAndConvertAt<uint32_t>(COLUMN_VALID_LIFETIME);
     return (valid);
 }
 
 time_t
-CSVLeaseFile4::readCltt(const CSVRow& row) {
-    uint32_t cltt = row.readAndConvertAt<uint32_t>(getColumnIndex("expire"))
+CSVLeaseFile4::readCltt(const CSVRowView& row) {
+    uint32_t cltt = row.readAndConvertAt<uint32_t>(COLUMN_EXPIRE)
         - readValid(row);
     return (cltt);
 }
 
 SubnetID
-CSVLeaseFile4::readSubnetID(const CSVRow& row) {
-    SubnetID subnet_id =
-        row.readAndConvertAt<SubnetID>(getColumnIndex("subnet_id"));
+CSVLeaseFile4::readSubnetID(const CSVRowView& row) {
+    SubnetID subnet_id = row.readAndConvertAt<SubnetID>(COLUMN_SUBNET_ID);
     return (subnet_id);
 }
 
 bool
-CSVLeaseFile4::readFqdnFwd(const CSVRow& row) {
-    bool fqdn_fwd = row.readAndConvertAt<bool>(getColumnIndex("fqdn_fwd"));
+CSVLeaseFile4::readFqdnFwd(const CSVRowView& row) {
+    bool fqdn_fwd = row.readAndConvertAt<bool>(COLUMN_FQDN_FWD);
     return (fqdn_fwd);
 }
 
 bool
-CSVLeaseFile4::readFqdnRev(const CSVRow& row) {
-    bool fqdn_rev = row.readAndConvertAt<bool>(getColumnIndex("fqdn_rev"));
+CSVLeaseFile4::readFqdnRev(const CSVRowView& row) {
+    bool fqdn_rev = row.readAndConvertAt<bool>(COLUMN_FQDN_REV);
     return (fqdn_rev);
 }
 
 std::string
-CSVLeaseFile4::readHostname(const CSVRow& row) {
-    std::string hostname = row.readAt(getColumnIndex("hostname"));
+CSVLeaseFile4::readHostname(const CSVRowView& row) {
+    std::string hostname = row.readAt(COLUMN_HOSTNAME);
     return (hostname);
 }
 
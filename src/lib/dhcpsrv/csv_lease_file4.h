@@ -18,10 +18,12 @@
 #include <asiolink/io_address.h>
 #include <dhcp/duid.h>
 #include <dhcpsrv/lease.h>
+#include <dhcpsrv/lease_journal.h>
 #include <dhcpsrv/subnet.h>
 #include <util/csv_file.h>
 #include <stdint.h>
 #include <string>
+#include <vector>
 #include <time.h>
 
 namespace isc {
@@ -48,6 +50,38 @@ public:
     /// @param filename Name of the lease file.
     CSVLeaseFile4(const std::string& filename);
 
+    /// @brief Sets the durability policy of the writes to the lease file.
+    ///
+    /// When the policy is set, the lease records are appended to the file
+    /// by the @c LeaseJournal, which is opened and closed along with the
+    /// file. The records written this way are not returned by @c next.
+    /// The policy must be set before the file is opened.
+    ///
+    /// @param policy Durability policy.
+    /// @param sync_interval Synchronization interval in milliseconds, used
+    /// with the @c LeaseJournal::SYNC_INTERVAL policy.
+    ///
+    /// @throw BadValue if the interval is invalid for the policy.
+    void setSyncPolicy(const LeaseJournal::SyncPolicy policy,
+                       const uint32_t sync_interval = 0);
+
+    /// @brief Returns the journal writing to the lease file.
+    ///
+    /// @return Pointer to the journal or NULL pointer if the durability
+    /// policy hasn't been set.
+    LeaseJournalPtr getJournal() const {
+        return (journal_);
+    }
+
+    /// @brief Opens the lease file and the journal, if used.
+    virtual void open();
+
+    /// @brief Creates the new lease file and opens the journal, if used.
+    virtual void recreate();
+
+    /// @brief Closes the journal, if used, and the lease file.
+    virtual void close();
+
     /// @brief Appends the lease record to the CSV file.
     ///
     /// This function doesn't throw exceptions itself. In theory, exceptions
@@ -102,49 +136,69 @@ private:
     /// @brief Reads lease address from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    asiolink::IOAddress readAddress(const util::CSVRow& row);
+    asiolink::IOAddress readAddress(const util::CSVRowView& row);
 
     /// @brief Reads HW address from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    HWAddr readHWAddr(const util::CSVRow& row);
+    ///
+    /// @return Reference to the buffer holding the HW address. It is valid
+    /// until the next row is read.
+    const std::vector<uint8_t>& readHWAddr(const util::CSVRowView& row);
 
     /// @brief Reads client identifier from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    ClientIdPtr readClientId(const util::CSVRow& row);
+    ///
+    /// @return Reference to the buffer holding the client identifier or
+    /// the empty buffer if the lease has no client identifier. It is valid
+    /// until the next row is read.
+    const std::vector<uint8_t>& readClientId(const util::CSVRowView& row);
 
     /// @brief Reads valid lifetime from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    uint32_t readValid(const util::CSVRow& row);
+    uint32_t readValid(const util::CSVRowView& row);
 
     /// @brief Reads cltt value from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    time_t readCltt(const util::CSVRow& row);
+    time_t readCltt(const util::CSVRowView& row);
 
     /// @brief Reads subnet id from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    SubnetID readSubnetID(const util::CSVRow& row);
+    SubnetID readSubnetID(const util::CSVRowView& row);
 
     /// @brief Reads the FQDN forward flag from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    bool readFqdnFwd(const util::CSVRow& row);
+    bool readFqdnFwd(const util::CSVRowView& row);
 
     /// @brief Reads the FQDN reverse flag from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    bool readFqdnRev(const util::CSVRow& row);
+    bool readFqdnRev(const util::CSVRowView& row);
 
     /// @brief Reads hostname from the CSV file row.
     ///
     /// @param row CSV file holding lease values.
-    std::string readHostname(const util::CSVRow& row);
+    std::string readHostname(const util::CSVRowView& row);
     //@}
 
+    /// @brief Row being parsed, reused for all rows of the file.
+    util::CSVRowView row_;
+
+    /// @brief Journal appending the lease records to the file or NULL
+    /// pointer if the records are appended by the @c CSVFile.
+    LeaseJournalPtr journal_;
+
+    /// @brief Buffer holding the HW address read from the row.
+    std::vector<uint8_t> hwaddr_buffer_;
+
+    /// @brief Buffer holding the client identifier read from the row.
+    std::vector<uint8_t> client_id_buffer_;
+
 };
 
 } // namespace isc::dhcp
@@ -17,6 +17,28 @@
 using namespace isc::asiolink;
 using namespace isc::util;
 
+namespace {
+
+/// @brief Indexes of the columns of the lease file, in the order in which
+/// they are added by @c CSVLeaseFile6::initColumns. The header of the file
+/// being opened must match the columns, so the indexes are fixed.
+enum Column {
+    COLUMN_ADDRESS,
+    COLUMN_DUID,
+    COLUMN_VALID_LIFETIME,
+    COLUMN_EXPIRE,
+    COLUMN_SUBNET_ID,
+    COLUMN_PREF_LIFETIME,
+    COLUMN_LEASE_TYPE,
+    COLUMN_IAID,
+    COLUMN_PREFIX_LEN,
+    COLUMN_FQDN_FWD,
+    COLUMN_FQDN_REV,
+    COLUMN_HOSTNAME
+};
+
+}
+
 namespace isc {
 namespace dhcp {
 
@@ -25,6 +47,42 @@ CSVLeaseFile6::CSVLeaseFile6(const std::string& filename)
     initColumns();
 }
 
+void
+CSVLeaseFile6::setSyncPolicy(const LeaseJournal::SyncPolicy policy,
+                             const uint32_t sync_interval) {
+    journal_.reset(new LeaseJournal(getFilename(), policy, sync_interval));
+}
+
+void
+CSVLeaseFile6::open() {
+    CSVFile::open();
+    if (journal_) {
+        journal_->open();
+    }
+}
+
+void
+CSVLeaseFile6::recreate() {
+    CSVFile::recreate();
+    if (journal_) {
+        journal_->open();
+    }
+}
+
+void
+CSVLeaseFile6::close() {
+    // The journal writes the buffered records before the file is closed.
+    if (journal_) {
+        try {
+            journal_->close();
+        } catch (...) {
+            CSVFile::close();
+            throw;
+        }
+    }
+    CSVFile::close();
+}
+
 void
 CSVLeaseFile6::append(const Lease6& lease) const {
     CSVRow row(getColumnCount());
@@ -41,7 +99,11 @@ CSVLeaseFile6::append(const Lease6& lease) const {
     row.writeAt(getColumnIndex("fqdn_fwd"), lease.fqdn_fwd_);
     row.writeAt(getColumnIndex("fqdn_rev"), lease.fqdn_rev_);
     row.writeAt(getColumnIndex("hostname"), lease.hostname_);
-    CSVFile::append(row);
+    if (journal_) {
+        journal_->write(row.render());
+    } else {
+        CSVFile::append(row);
+    }
 }
 
 bool
@@ -51,24 +113,28 @@ CSVLeaseFile6::next(Lease6Ptr& lease) {
     // to throw exceptions, so we catch them all and rather return the
     // false value.
     try {
-        // Get the row of CSV values.
-        CSVRow row;
-        CSVFile::next(row);
+        // Get the row of CSV values. The values are read in place from the
+        // read buffer of the file.
+        if (!CSVFile::next(row_, true)) {
+            lease.reset();
+            return (false);
+        }
         // The empty row signals EOF.
-        if (row == CSVFile::EMPTY_ROW()) {
+        if (row_.getValuesCount() == 0) {
             lease.reset();
             return (true);
         }
 
-        lease.reset(new Lease6(readType(row), readAddress(row), readDUID(row),
-                               readIAID(row), readPreferred(row),
-                               readValid(row), 0, 0, // t1, t2 = 0
-                               readSubnetID(row),
-                               readPrefixLen(row)));
-        lease->cltt_ = readCltt(row);
-        lease->fqdn_fwd_ = readFqdnFwd(row);
-        lease->fqdn_rev_ = readFqdnRev(row);
-        lease->hostname_ = readHostname(row);
+        lease.reset(new Lease6(readType(row_), readAddress(row_),
+                               readDUID(row_), readIAID(row_),
+                               readPreferred(row_),
+                               readValid(row_), 0, 0, // t1, t2 = 0
+                               readSubnetID(row_),
+                               readPrefixLen(row_)));
+        lease->cltt_ = readCltt(row_);
+        lease->fqdn_fwd_ = readFqdnFwd(row_);
+        lease->fqdn_rev_ = readFqdnRev(row_);
+        lease->hostname_ = readHostname(row_);
 
     } catch (std::exception& ex) {
         // The lease might have been created, so let's set it back to NULL to
@@ -97,78 +163,78 @@ CSVLeaseFile6::initColumns() {
 }
 
 Lease::Type
-CSVLeaseFile6::readType(const CSVRow& row) {
+CSVLeaseFile6::readType(const CSVRowView& row) {
     return (static_cast<Lease::Type>
-            (row.readAndConvertAt<int>(getColumnIndex("lease_type"))));
+            (row.readAndConvertAt<int>(COLUMN_LEASE_TYPE)));
 }
 
 IOAddress
-CSVLeaseFile6::readAddress(const CSVRow& row) {
-    IOAddress address(row.readAt(getColumnIndex("address")));
-    return (address);
+CSVLeaseFile6::readAddress(const CSVRowView& row) {
+    uint8_t address[V6ADDRESS_LEN];
+    row.readIPv6At(COLUMN_ADDRESS, address);
+    return (IOAddress::fromBytes(AF_INET6, address));
 }
 
 DuidPtr
-CSVLeaseFile6::readDUID(const util::CSVRow& row) {
-    DuidPtr duid(new DUID(DUID::fromText(row.readAt(getColumnIndex("duid")))));
+CSVLeaseFile6::readDUID(const CSVRowView& row) {
+    // The DUID constructor verifies the length of the DUID.
+    row.readHexAt(COLUMN_DUID, duid_buffer_);
+    DuidPtr duid(new DUID(duid_buffer_));
     return (duid);
 }
 
 uint32_t
-CSVLeaseFile6::readIAID(const CSVRow& row) {
-    uint32_t iaid = row.readAndConvertAt<uint32_t>(getColumnIndex("iaid"));
+CSVLeaseFile6::readIAID(const CSVRowView& row) {
+    uint32_t iaid = row.readAndConvertAt<uint32_t>(COLUMN_IAID);
     return (iaid);
 }
 
 uint32_t
-CSVLeaseFile6::readPreferred(const CSVRow& row) {
-    uint32_t pref =
-        row.readAndConvertAt<uint32_t>(getColumnIndex("pref_lifetime"));
+CSVLeaseFile6::readPreferred(const CSVRowView& row) {
+    uint32_t pref = row.readAndConvertAt<uint32_t>(COLUMN_PREF_LIFETIME);
     return (pref);
 }
 
 uint32_t
-CSVLeaseFile6::readValid(const CSVRow& row) {
-    uint32_t valid =
-        row.readAndConvertAt<uint32_t>(getColumnIndex("valid_lifetime"));
+CSVLeaseFile6::readValid(const CSVRowView& row) {
+    uint32_t valid = row.readAndConvertAt<uint32_t>(COLUMN_VALID_LIFETIME);
     return (valid);
 }
 
 uint32_t
-CSVLeaseFile6::readCltt(const CSVRow& row) {
-    uint32_t cltt = row.readAndConvertAt<uint32_t>(getColumnIndex("expire"))
+CSVLeaseFile6::readCltt(const CSVRowView& row) {
+    uint32_t cltt = row.readAndConvertAt<uint32_t>(COLUMN_EXPIRE)
         - readValid(row);
     return (cltt);
 }
 
 SubnetID
-CSVLeaseFile6::readSubnetID(const CSVRow& row) {
-    SubnetID subnet_id =
-        row.readAndConvertAt<SubnetID>(getColumnIndex("subnet_id"));
+CSVLeaseFile6::readSubnetID(const CSVRowView& row) {
+    SubnetID subnet_id = row.readAndConvertAt<SubnetID>(COLUMN_SUBNET_ID);
     return (subnet_id);
 }
 
 uint8_t
-CSVLeaseFile6::readPrefixLen(const CSVRow& row) {
-    int prefixlen = row.readAndConvertAt<int>(getColumnIndex("prefix_len"));
+CSVLeaseFile6::readPrefixLen(const CSVRowView& row) {
+    int prefixlen = row.readAndConvertAt<int>(COLUMN_PREFIX_LEN);
     return (static_cast<uint8_t>(prefixlen));
 }
 
 bool
-CSVLeaseFile6::readFqdnFwd(const CSVRow& row) {
-    bool fqdn_fwd = row.readAndConvertAt<bool>(getColumnIndex("fqdn_fwd"));
+CSVLeaseFile6::readFqdnFwd(const CSVRowView& row) {
+    bool fqdn_fwd = row.readAndConvertAt<bool>(COLUMN_FQDN_FWD);
     return (fqdn_fwd);
 }
 
 bool
-CSVLeaseFile6::readFqdnRev(const CSVRow& row) {
-    bool fqdn_rev = row.readAndConvertAt<bool>(getColumnIndex("fqdn_rev"));
+CSVLeaseFile6::readFqdnRev(const CSVRowView& row) {
+    bool fqdn_rev = row.readAndConvertAt<bool>(COLUMN_FQDN_REV);
     return (fqdn_rev);
 }
 
 std::string
-CSVLeaseFile6::readHostname(const CSVRow& row) {
-    std::string hostname = row.readAt(getColumnIndex("hostname"));
+CSVLeaseFile6::readHostname(const CSVRowView& row) {
+    std::string hostname = row.readAt(COLUMN_HOSTNAME);
     return (hostname);
 }
 
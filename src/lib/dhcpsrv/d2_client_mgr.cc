@@ -267,6 +267,8 @@ D2ClientMgr::sendRequest(dhcp_ddns::NameChangeRequestPtr& ncr) {
         isc_throw(D2ClientError, "D2ClientMgr::sendRequest not in send mode");
     }
 
+    // The requests may be sent by multiple packet processing threads.
+    isc::util::thread::Mutex::Locker lock(sender_mutex_);
     try {
         name_change_sender_->sendRequest(ncr);
     } catch (const std::exception& ex) {
@@ -361,6 +363,7 @@ D2ClientMgr::runReadyIO() {
                   " name_change_sender is null");
     }
 
+    isc::util::thread::Mutex::Locker lock(sender_mutex_);
     name_change_sender_->runReadyIO();
 }
 
@@ -0,0 +1,244 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DB_CONNECTION_POOL_H
+#define DB_CONNECTION_POOL_H
+
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <exception>
+#include <vector>
+#include <time.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Pool of connections to the lease database.
+///
+/// The SQL lease managers hold several connections to the database, each
+/// with its own set of prepared statements, so as the packet processing
+/// threads can run their queries concurrently. A thread checks out an idle
+/// connection for the duration of a lease operation using the
+/// @c DbConnectionPool::Locker and returns it when the operation completes.
+/// If all connections are in use, the thread waits until one of them is
+/// returned.
+///
+/// Before a connection is handed out, its health is verified by the health
+/// check function supplied by the lease manager when:
+/// - the connection was returned while an exception was propagating, i.e.
+///   the last operation on the connection has failed, or
+/// - the connection hasn't been used for the configured check interval.
+///
+/// If the health check fails, the connection is discarded and a new one
+/// is opened in its place using the connection factory function.
+///
+/// @tparam Connection Type of the connection object. It holds all the state
+/// which can only be used by one thread at a time.
+template<typename Connection>
+class DbConnectionPool : public boost::noncopyable {
+public:
+
+    /// @brief Pointer to the connection.
+    typedef boost::shared_ptr<Connection> ConnectionPtr;
+
+    /// @brief Function opening a new connection.
+    ///
+    /// It throws an exception if the connection can't be opened.
+    typedef boost::function<ConnectionPtr()> ConnectionFactory;
+
+    /// @brief Function checking if the connection is still usable.
+    typedef boost::function<bool(Connection&)> HealthCheck;
+
+    /// @brief Default interval in seconds after which an idle connection
+    /// is checked before use.
+    static const time_t DEFAULT_CHECK_INTERVAL = 60;
+
+    /// @brief Checks out a connection for the lifetime of the object.
+    ///
+    /// The connection is returned to the pool by the destructor.
+    class Locker : public boost::noncopyable {
+    public:
+
+        /// @brief Constructor.
+        ///
+        /// Waits for an idle connection, verifies it and checks it out.
+        ///
+        /// @param pool Pool from which the connection is checked out.
+        ///
+        /// @throw Any exception thrown by the connection factory if a broken
+        /// connection can't be reopened.
+        explicit Locker(DbConnectionPool& pool)
+            : pool_(pool), index_(pool.checkout()) {
+        }
+
+        /// @brief Destructor.
+        ///
+        /// Returns the connection to the pool. If an exception is being
+        /// propagated, the connection is verified before it is used again.
+        ~Locker() {
+            pool_.release(index_, std::uncaught_exception());
+        }
+
+        /// @brief Returns the checked out connection.
+        Connection& operator*() const {
+            return (*pool_.slots_[index_].connection_);
+        }
+
+        /// @brief Returns the pointer to the checked out connection.
+        Connection* operator->() const {
+            return (pool_.slots_[index_].connection_.get());
+        }
+
+    private:
+        /// @brief Pool which the connection belongs to.
+        DbConnectionPool& pool_;
+
+        /// @brief Index of the connection in the pool.
+        size_t index_;
+    };
+
+    /// @brief Constructor.
+    ///
+    /// Opens all connections of the pool.
+    ///
+    /// @param factory Function opening a new connection.
+    /// @param health_check Function checking if the connection is usable.
+    /// @param size Number of connections in the pool.
+    /// @param check_interval Interval in seconds after which an idle
+    /// connection is checked before use. The value of 0 disables the
+    /// check of idle connections.
+    ///
+    /// @throw isc::BadValue if the size is 0.
+    /// @throw Any exception thrown by the connection factory.
+    DbConnectionPool(const ConnectionFactory& factory,
+                     const HealthCheck& health_check,
+                     const size_t size,
+                     const time_t check_interval = DEFAULT_CHECK_INTERVAL)
+        : factory_(factory), health_check_(health_check),
+          check_interval_(check_interval), slots_(size) {
+        if (size == 0) {
+            isc_throw(BadValue, "database connection pool must hold at"
+                      " least one connection");
+        }
+        for (size_t i = 0; i < size; ++i) {
+            slots_[i].connection_ = factory_();
+            slots_[i].released_ = time(NULL);
+            slots_[i].verify_ = false;
+            idle_.push_back(size - i - 1);
+        }
+    }
+
+    /// @brief Returns the number of connections in the pool.
+    size_t getSize() const {
+        return (slots_.size());
+    }
+
+    /// @brief Returns the number of connections which are not in use.
+    size_t getIdleCount() const {
+        isc::util::thread::Mutex::Locker lock(mutex_);
+        return (idle_.size());
+    }
+
+private:
+
+    /// @brief Connection held in the pool along with its state.
+    struct Slot {
+        /// @brief The connection or NULL if it couldn't be reopened.
+        ConnectionPtr connection_;
+
+        /// @brief Time when the connection was returned to the pool.
+        time_t released_;
+
+        /// @brief Indicates that the connection must be verified before use.
+        bool verify_;
+    };
+
+    /// @brief Checks out an idle connection.
+    ///
+    /// @return Index of the connection.
+    size_t checkout() {
+        size_t index = 0;
+        {
+            isc::util::thread::Mutex::Locker lock(mutex_);
+            while (idle_.empty()) {
+                cond_var_.wait(mutex_);
+            }
+            index = idle_.back();
+            idle_.pop_back();
+        }
+
+        // The slot is not accessed by other threads until it is released.
+        Slot& slot = slots_[index];
+        try {
+            const bool expired = (check_interval_ > 0) &&
+                (time(NULL) - slot.released_ >= check_interval_);
+            if (!slot.connection_ ||
+                ((slot.verify_ || expired) && !health_check_(*slot.connection_))) {
+                // Close the broken connection before opening a new one.
+                slot.connection_.reset();
+                slot.connection_ = factory_();
+            }
+            slot.verify_ = false;
+
+        } catch (...) {
+            release(index, true);
+            throw;
+        }
+        return (index);
+    }
+
+    /// @brief Returns the connection to the pool.
+    ///
+    /// @param index Index of the connection.
+    /// @param verify Indicates if the connection must be verified before
+    /// it is used again.
+    void release(const size_t index, const bool verify) {
+        isc::util::thread::Mutex::Locker lock(mutex_);
+        slots_[index].released_ = time(NULL);
+        slots_[index].verify_ = slots_[index].verify_ || verify;
+        idle_.push_back(index);
+        cond_var_.signal();
+    }
+
+    /// @brief Function opening a new connection.
+    ConnectionFactory factory_;
+
+    /// @brief Function checking if the connection is usable.
+    HealthCheck health_check_;
+
+    /// @brief Interval after which an idle connection is checked.
+    time_t check_interval_;
+
+    /// @brief All connections of the pool.
+    std::vector<Slot> slots_;
+
+    /// @brief Indexes of the connections which are not in use.
+    std::vector<size_t> idle_;
+
+    /// @brief Mutex protecting the collection of idle connections.
+    mutable isc::util::thread::Mutex mutex_;
+
+    /// @brief Condition variable used to wait for an idle connection.
+    isc::util::thread::CondVar cond_var_;
+};
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
+
+#endif // DB_CONNECTION_POOL_H
@@ -18,6 +18,7 @@
 #include <dhcpsrv/lease_mgr_factory.h>
 
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <map>
 #include <string>
@@ -26,6 +27,31 @@
 using namespace std;
 using namespace isc::data;
 
+namespace {
+
+/// @brief Returns the integer parameter as a string, checking its range.
+///
+/// @param value Configuration element holding the value.
+/// @param name Name of the parameter, used in the error message.
+/// @param min Minimum allowed value.
+/// @param max Maximum allowed value.
+///
+/// @throw isc::BadValue if the value is out of range.
+/// @throw isc::data::TypeError if the value is not an integer.
+std::string
+getIntegerValue(const ConstElementPtr& value, const std::string& name,
+                const int64_t min, const int64_t max) {
+    const int64_t number = value->intValue();
+    if ((number < min) || (number > max)) {
+        isc_throw(isc::BadValue, name << " value " << number
+                  << " is out of range (" << min << " - " << max << ") ("
+                  << value->getPosition() << ")");
+    }
+    return (boost::lexical_cast<std::string>(number));
+}
+
+} // end of anonymous namespace
+
 namespace isc {
 namespace dhcp {
 
@@ -58,14 +84,39 @@ DbAccessParser::build(isc::data::ConstElementPtr config_value) {
     // 3. Update the copy with the passed keywords.
     BOOST_FOREACH(ConfigPair param, config_value->mapValue()) {
         try {
-            // The persist parameter is the only boolean parameter at the
-            // moment. It needs special handling.
-            if (param.first != "persist") {
-                values_copy[param.first] = param.second->stringValue();
-
-            } else {
+            // The persist, snapshot and pipeline parameters are boolean.
+            // They and the integer parameters need special handling.
+            if ((param.first == "persist") || (param.first == "snapshot") ||
+                (param.first == "pipeline")) {
                 values_copy[param.first] = (param.second->boolValue() ?
                                             "true" : "false");
+
+            } else if (param.first == "lfc-interval") {
+                values_copy[param.first] =
+                    getIntegerValue(param.second, param.first, 0, 0xFFFFFFFF);
+
+            } else if (param.first == "sync-interval") {
+                values_copy[param.first] =
+                    getIntegerValue(param.second, param.first, 1, 60000);
+
+            } else if (param.first == "connections") {
+                values_copy[param.first] =
+                    getIntegerValue(param.second, param.first, 1, 65535);
+
+            } else if (param.first == "group-commit-size") {
+                values_copy[param.first] =
+                    getIntegerValue(param.second, param.first, 0, 65535);
+
+            } else if (param.first == "group-commit-delay") {
+                values_copy[param.first] =
+                    getIntegerValue(param.second, param.first, 0, 60000);
+
+            } else if (param.first == "cache-size") {
+                values_copy[param.first] =
+                    getIntegerValue(param.second, param.first, 0, 0xFFFFFFFF);
+
+            } else {
+                values_copy[param.first] = param.second->stringValue();
             }
         } catch (const isc::data::TypeError& ex) {
             // Append position of the element.
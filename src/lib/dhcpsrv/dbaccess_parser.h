@@ -107,11 +107,11 @@ public:
         return (new DbAccessParser(param_name, ctx));
     }
 
-protected:
     /// @brief Get database access parameters
     ///
-    /// Used in testing to check that the configuration information has been
-    /// parsed correctly.
+    /// Used to check the parameters against the other parts of the
+    /// configuration before the database is opened, and in testing to
+    /// check that the configuration information has been parsed correctly.
     ///
     /// @return Reference to the internal map of keyword/value pairs
     ///         representing database access information.  This is valid only
@@ -120,6 +120,7 @@ protected:
         return (values_);
     }
 
+protected:
     /// @brief Construct database access string
     ///
     /// Constructs the database access string from the stored parameters.
@@ -0,0 +1,236 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+#include <dhcpsrv/free_address_bitmap.h>
+
+#include <sys/socket.h>
+
+using namespace isc::asiolink;
+
+namespace {
+
+/// @brief Number of bits in a single word of the bitmap.
+const uint64_t WORD_BITS = 64;
+
+/// @brief Returns the position of the lowest bit set in a non-zero word.
+inline unsigned int
+lowestBit(const uint64_t word) {
+#ifdef __GNUC__
+    return (static_cast<unsigned int>(__builtin_ctzll(word)));
+#else
+    unsigned int bit = 0;
+    while ((word & (static_cast<uint64_t>(1) << bit)) == 0) {
+        ++bit;
+    }
+    return (bit);
+#endif
+}
+
+} // end of anonymous namespace
+
+namespace isc {
+namespace dhcp {
+
+const uint64_t FreeAddressBitmap::MAX_CAPACITY = 0x1000000;
+
+FreeAddressBitmap::FreeAddressBitmap(const IOAddress& first,
+                                     const IOAddress& last,
+                                     const uint8_t prefix_len)
+    : v4_(first.isV4()), shift_(v4_ ? 0 : 128 - prefix_len),
+      first_(), capacity_(0), free_count_(0), words_(), cursor_(0) {
+    if (!canTrack(first, last, prefix_len)) {
+        isc_throw(BadValue, "unable to track free addresses in the range "
+                  << first << " - " << last << "/"
+                  << static_cast<unsigned int>(prefix_len));
+    }
+
+    first_ = toUint128(first, shift_);
+    capacity_ = toUint128(last, shift_).second - first_.second + 1;
+    free_count_ = capacity_;
+
+    // Mark all addresses free, except for the trailing bits of the last
+    // word which do not represent any address.
+    words_.resize((capacity_ + WORD_BITS - 1) / WORD_BITS,
+                  ~static_cast<uint64_t>(0));
+    const uint64_t trailing = capacity_ % WORD_BITS;
+    if (trailing != 0) {
+        words_.back() = (static_cast<uint64_t>(1) << trailing) - 1;
+    }
+}
+
+bool
+FreeAddressBitmap::canTrack(const IOAddress& first, const IOAddress& last,
+                            const uint8_t prefix_len) {
+    if (first.isV4() != last.isV4()) {
+        return (false);
+    }
+    if (!first.isV4() && ((prefix_len == 0) || (prefix_len > 128))) {
+        return (false);
+    }
+
+    const unsigned int shift = first.isV4() ? 0 : 128 - prefix_len;
+    const Uint128 f = toUint128(first, shift);
+    const Uint128 l = toUint128(last, shift);
+    if (l < f) {
+        return (false);
+    }
+
+    // Compute the difference between the last and the first value. The
+    // range is too large if it doesn't fit in the lower half.
+    const uint64_t hi = l.first - f.first - (l.second < f.second ? 1 : 0);
+    const uint64_t lo = l.second - f.second;
+    return ((hi == 0) && (lo < MAX_CAPACITY));
+}
+
+bool
+FreeAddressBitmap::isFree(const IOAddress& addr) const {
+    const uint64_t index = getIndex(addr);
+    const uint64_t mask = static_cast<uint64_t>(1) << (index % WORD_BITS);
+    return ((words_[index / WORD_BITS] & mask) != 0);
+}
+
+void
+FreeAddressBitmap::markUsed(const IOAddress& addr) {
+    const uint64_t index = getIndex(addr);
+    const uint64_t mask = static_cast<uint64_t>(1) << (index % WORD_BITS);
+    uint64_t& word = words_[index / WORD_BITS];
+    if ((word & mask) != 0) {
+        word &= ~mask;
+        --free_count_;
+    }
+}
+
+void
+FreeAddressBitmap::markFree(const IOAddress& addr) {
+    const uint64_t index = getIndex(addr);
+    const uint64_t mask = static_cast<uint64_t>(1) << (index % WORD_BITS);
+    uint64_t& word = words_[index / WORD_BITS];
+    if ((word & mask) == 0) {
+        word |= mask;
+        ++free_count_;
+    }
+}
+
+IOAddress
+FreeAddressBitmap::pickFree() {
+    if (free_count_ == 0) {
+        isc_throw(InvalidOperation, "no free addresses in the range");
+    }
+
+    // Start the search after the address returned previously. The
+    // addresses preceding the cursor in its word are examined at the end
+    // of the search, after wrapping around.
+    const size_t count = words_.size();
+    size_t current = cursor_ / WORD_BITS;
+    uint64_t word = words_[current] &
+        (~static_cast<uint64_t>(0) << (cursor_ % WORD_BITS));
+    for (size_t i = 0; i <= count; ++i) {
+        if (word != 0) {
+            const uint64_t index = current * WORD_BITS + lowestBit(word);
+            cursor_ = (index + 1) % capacity_;
+            return (getAddress(index));
+        }
+        current = (current + 1) % count;
+        word = words_[current];
+    }
+
+    // The free count says that there is a free address so we should
+    // never get here.
+    isc_throw(Unexpected, "inconsistent free address bitmap");
+}
+
+FreeAddressBitmap::Uint128
+FreeAddressBitmap::toUint128(const IOAddress& addr, const unsigned int shift) {
+    const std::vector<uint8_t> bytes = addr.toBytes();
+    Uint128 value(0, 0);
+    // IPv4 addresses only take the lower half.
+    const size_t split = bytes.size() > 8 ? bytes.size() - 8 : 0;
+    for (size_t i = 0; i < split; ++i) {
+        value.first = (value.first << 8) | bytes[i];
+    }
+    for (size_t i = split; i < bytes.size(); ++i) {
+        value.second = (value.second << 8) | bytes[i];
+    }
+
+    if (shift >= 128) {
+        return (Uint128(0, 0));
+
+    } else if (shift >= 64) {
+        return (Uint128(0, value.first >> (shift - 64)));
+
+    } else if (shift > 0) {
+        return (Uint128(value.first >> shift,
+                        (value.second >> shift) |
+                        (value.first << (64 - shift))));
+    }
+    return (value);
+}
+
+uint64_t
+FreeAddressBitmap::getIndex(const IOAddress& addr) const {
+    if (addr.isV4() != v4_) {
+        isc_throw(BadValue, "address " << addr << " has a different family"
+                  " than the tracked range");
+    }
+
+    const Uint128 value = toUint128(addr, shift_);
+    if (!(value < first_)) {
+        const uint64_t hi = value.first - first_.first -
+            (value.second < first_.second ? 1 : 0);
+        const uint64_t lo = value.second - first_.second;
+        if ((hi == 0) && (lo < capacity_)) {
+            return (lo);
+        }
+    }
+    isc_throw(BadValue, "address " << addr << " is out of the tracked range");
+}
+
+IOAddress
+FreeAddressBitmap::getAddress(const uint64_t index) const {
+    Uint128 value(first_.first, first_.second + index);
+    if (value.second < index) {
+        ++value.first;
+    }
+
+    if (shift_ >= 64) {
+        value = Uint128(value.second << (shift_ - 64), 0);
+
+    } else if (shift_ > 0) {
+        value = Uint128((value.first << shift_) |
+                        (value.second >> (64 - shift_)),
+                        value.second << shift_);
+    }
+
+    if (v4_) {
+        uint8_t bytes[4];
+        for (int i = 3; i >= 0; --i) {
+            bytes[i] = static_cast<uint8_t>(value.second);
+            value.second >>= 8;
+        }
+        return (IOAddress::fromBytes(AF_INET, bytes));
+    }
+
+    uint8_t bytes[16];
+    for (int i = 7; i >= 0; --i) {
+        bytes[i] = static_cast<uint8_t>(value.first);
+        value.first >>= 8;
+        bytes[i + 8] = static_cast<uint8_t>(value.second);
+        value.second >>= 8;
+    }
+    return (IOAddress::fromBytes(AF_INET6, bytes));
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
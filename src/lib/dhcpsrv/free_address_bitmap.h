@@ -0,0 +1,171 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef FREE_ADDRESS_BITMAP_H
+#define FREE_ADDRESS_BITMAP_H
+
+#include <asiolink/io_address.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Bitmap of free addresses (or prefixes) within a pool.
+///
+/// Each address of the range is represented by a single bit, which is
+/// set when the address is free and cleared when it is in use. This allows
+/// the allocation engine to find a free address in a pool without querying
+/// the lease database for every candidate address. For prefix pools, each
+/// bit represents a single delegated prefix.
+///
+/// The bitmap is only used for ranges holding at most @c MAX_CAPACITY
+/// addresses (prefixes), which limits its size to 2MB. The @c canTrack
+/// function checks whether a range qualifies.
+///
+/// This class is not thread safe. The caller must serialize the access
+/// to the bitmap.
+class FreeAddressBitmap : public boost::noncopyable {
+public:
+
+    /// @brief Maximum number of addresses (prefixes) tracked by a bitmap.
+    static const uint64_t MAX_CAPACITY;
+
+    /// @brief Constructor.
+    ///
+    /// All addresses within the range are initially marked free.
+    ///
+    /// @param first first address (prefix) of the range
+    /// @param last last address (prefix) of the range
+    /// @param prefix_len length of the prefixes within the range. It must
+    /// be 128 for IPv6 addresses and is ignored for IPv4 addresses.
+    ///
+    /// @throw isc::BadValue if the range can't be tracked.
+    FreeAddressBitmap(const isc::asiolink::IOAddress& first,
+                      const isc::asiolink::IOAddress& last,
+                      const uint8_t prefix_len = 128);
+
+    /// @brief Checks if the range of addresses can be tracked by a bitmap.
+    ///
+    /// @param first first address (prefix) of the range
+    /// @param last last address (prefix) of the range
+    /// @param prefix_len length of the prefixes within the range
+    ///
+    /// @return true if the addresses belong to the same family, the range is
+    /// not empty and holds no more than @c MAX_CAPACITY addresses (prefixes).
+    static bool canTrack(const isc::asiolink::IOAddress& first,
+                         const isc::asiolink::IOAddress& last,
+                         const uint8_t prefix_len = 128);
+
+    /// @brief Returns the number of addresses (prefixes) in the range.
+    uint64_t getCapacity() const {
+        return (capacity_);
+    }
+
+    /// @brief Returns the number of addresses (prefixes) marked free.
+    uint64_t getFreeCount() const {
+        return (free_count_);
+    }
+
+    /// @brief Checks if the address is marked free.
+    ///
+    /// @param addr address (prefix) within the range
+    ///
+    /// @throw isc::BadValue if the address is out of range.
+    bool isFree(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Marks the address used.
+    ///
+    /// @param addr address (prefix) within the range
+    ///
+    /// @throw isc::BadValue if the address is out of range.
+    void markUsed(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Marks the address free.
+    ///
+    /// @param addr address (prefix) within the range
+    ///
+    /// @throw isc::BadValue if the address is out of range.
+    void markFree(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Returns a free address.
+    ///
+    /// The search starts after the address returned previously, so the
+    /// addresses are handed out in the ascending order and the search
+    /// wraps around at the end of the range. The returned address remains
+    /// marked free until the @c markUsed is called for it.
+    ///
+    /// @return free address (prefix)
+    ///
+    /// @throw isc::InvalidOperation if there are no free addresses.
+    isc::asiolink::IOAddress pickFree();
+
+private:
+
+    /// @brief 128-bit unsigned value held as a (high, low) pair.
+    typedef std::pair<uint64_t, uint64_t> Uint128;
+
+    /// @brief Converts an address to a 128-bit value, shifted right by the
+    /// number of bits not belonging to the prefix.
+    ///
+    /// @param addr address (prefix) to be converted
+    /// @param shift number of bits to shift the value by
+    static Uint128 toUint128(const isc::asiolink::IOAddress& addr,
+                             const unsigned int shift);
+
+    /// @brief Returns the index of the bit representing the address.
+    ///
+    /// @param addr address (prefix) within the range
+    ///
+    /// @throw isc::BadValue if the address is out of range.
+    uint64_t getIndex(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns the address represented by the bit.
+    ///
+    /// @param index index of the bit
+    isc::asiolink::IOAddress getAddress(const uint64_t index) const;
+
+    /// @brief Indicates if this is a bitmap of IPv4 addresses.
+    bool v4_;
+
+    /// @brief Number of bits not belonging to the prefix.
+    unsigned int shift_;
+
+    /// @brief First address of the range, shifted right by @c shift_.
+    Uint128 first_;
+
+    /// @brief Number of addresses (prefixes) in the range.
+    uint64_t capacity_;
+
+    /// @brief Number of addresses (prefixes) marked free.
+    uint64_t free_count_;
+
+    /// @brief The bitmap: a bit is set when the address is free.
+    std::vector<uint64_t> words_;
+
+    /// @brief Index of the bit where the next search starts.
+    uint64_t cursor_;
+};
+
+/// @brief Pointer to the @c FreeAddressBitmap.
+typedef boost::shared_ptr<FreeAddressBitmap> FreeAddressBitmapPtr;
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
+
+#endif // FREE_ADDRESS_BITMAP_H
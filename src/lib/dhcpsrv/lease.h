@@ -270,6 +270,9 @@ struct Lease4 : public Lease {
 /// @brief Pointer to a Lease4 structure.
 typedef boost::shared_ptr<Lease4> Lease4Ptr;
 
+/// @brief Pointer to a const Lease4 structure.
+typedef boost::shared_ptr<const Lease4> ConstLease4Ptr;
+
 /// @brief A collection of IPv4 leases.
 typedef std::vector<Lease4Ptr> Lease4Collection;
 
@@ -401,6 +404,9 @@ typedef boost::shared_ptr<const Lease6> ConstLease6Ptr;
 /// @brief A collection of IPv6 leases.
 typedef std::vector<Lease6Ptr> Lease6Collection;
 
+/// @brief A collection of read-only IPv6 leases.
+typedef std::vector<ConstLease6Ptr> ConstLease6Collection;
+
 /// @brief Stream output operator.
 ///
 /// Dumps the output of Lease::toText to the given stream.
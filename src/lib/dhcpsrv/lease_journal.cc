@@ -0,0 +1,315 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/lease_journal.h>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace boost::posix_time;
+using namespace isc::util::thread;
+
+namespace isc {
+namespace dhcp {
+
+LeaseJournal::LeaseJournal(const std::string& filename,
+                           const SyncPolicy policy,
+                           const uint32_t sync_interval,
+                           const size_t buffer_size)
+    : filename_(filename), policy_(policy), sync_interval_(sync_interval),
+      buffer_size_(buffer_size), fd_(-1), unsynced_(false),
+      stopping_(false) {
+    if ((policy_ == SYNC_INTERVAL) && (sync_interval_ == 0)) {
+        isc_throw(BadValue, "the synchronization interval of the lease"
+                  " journal '" << filename_ << "' must be greater than 0");
+    }
+}
+
+LeaseJournal::~LeaseJournal() {
+    try {
+        close();
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_JOURNAL_SYNC_FAILED)
+            .arg(filename_).arg(ex.what());
+    }
+}
+
+LeaseJournal::SyncPolicy
+LeaseJournal::policyFromText(const std::string& name) {
+    if (name == "write") {
+        return (SYNC_WRITE);
+
+    } else if (name == "interval") {
+        return (SYNC_INTERVAL);
+
+    } else if (name == "os") {
+        return (SYNC_OS);
+    }
+    isc_throw(BadValue, "invalid lease journal synchronization policy '"
+              << name << "'");
+}
+
+void
+LeaseJournal::open() {
+    close();
+
+    {
+        Mutex::Locker lock(mutex_);
+        fd_ = ::open(filename_.c_str(), O_WRONLY | O_APPEND | O_CREAT,
+                     S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd_ < 0) {
+            isc_throw(LeaseJournalError, "unable to open the lease journal '"
+                      << filename_ << "': " << strerror(errno));
+        }
+        if (policy_ == SYNC_INTERVAL) {
+            buffer_.reserve(buffer_size_);
+        }
+        stopping_ = false;
+    }
+
+    if (policy_ == SYNC_INTERVAL) {
+        sync_thread_.reset(new Thread(boost::bind(&LeaseJournal::runSync,
+                                                  this)));
+    }
+}
+
+void
+LeaseJournal::close() {
+    if (sync_thread_) {
+        {
+            Mutex::Locker lock(mutex_);
+            stopping_ = true;
+            cond_var_.signal();
+        }
+        sync_thread_->wait();
+        sync_thread_.reset();
+    }
+
+    Mutex::Locker lock(mutex_);
+    if (fd_ < 0) {
+        return;
+    }
+
+    try {
+        writeBuffer(NULL, 0);
+        if ((policy_ != SYNC_OS) && unsynced_) {
+            updateSyncStatistics(syncFile(fd_));
+        }
+    } catch (...) {
+        ::close(fd_);
+        fd_ = -1;
+        buffer_.clear();
+        unsynced_ = false;
+        throw;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    unsynced_ = false;
+    std::vector<char>().swap(buffer_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_LEASE_JOURNAL_CLOSE)
+        .arg(filename_).arg(stats_.bytes_written_).arg(stats_.syncs_)
+        .arg(stats_.syncs_ > 0 ? stats_.sync_time_ / stats_.syncs_ : 0)
+        .arg(stats_.max_sync_time_);
+}
+
+void
+LeaseJournal::write(const std::string& row) {
+    Mutex::Locker lock(mutex_);
+    if (fd_ < 0) {
+        isc_throw(LeaseJournalError, "the lease journal '" << filename_
+                  << "' is not open");
+    }
+
+    switch (policy_) {
+    case SYNC_INTERVAL:
+        // The row is written by the synchronization thread, unless the
+        // buffer is full.
+        if (buffer_.size() + row.size() < buffer_size_) {
+            buffer_.insert(buffer_.end(), row.begin(), row.end());
+            buffer_.push_back('\n');
+        } else {
+            writeBuffer(row.data(), row.size());
+        }
+        break;
+
+    case SYNC_WRITE:
+        writeBuffer(row.data(), row.size());
+        updateSyncStatistics(syncFile(fd_));
+        unsynced_ = false;
+        break;
+
+    default:
+        writeBuffer(row.data(), row.size());
+    }
+}
+
+void
+LeaseJournal::sync() {
+    Mutex::Locker lock(mutex_);
+    if (fd_ < 0) {
+        isc_throw(LeaseJournalError, "the lease journal '" << filename_
+                  << "' is not open");
+    }
+    writeBuffer(NULL, 0);
+    if (unsynced_) {
+        updateSyncStatistics(syncFile(fd_));
+        unsynced_ = false;
+    }
+}
+
+LeaseJournal::Statistics
+LeaseJournal::getStatistics() const {
+    Mutex::Locker lock(mutex_);
+    return (stats_);
+}
+
+void
+LeaseJournal::writeBuffer(const char* row, const size_t row_length) {
+    char end_of_line = '\n';
+    struct iovec iov[3];
+    int count = 0;
+    if (!buffer_.empty()) {
+        iov[count].iov_base = &buffer_[0];
+        iov[count].iov_len = buffer_.size();
+        ++count;
+    }
+    if (row != NULL) {
+        iov[count].iov_base = const_cast<char*>(row);
+        iov[count].iov_len = row_length;
+        ++count;
+        iov[count].iov_base = &end_of_line;
+        iov[count].iov_len = 1;
+        ++count;
+    }
+
+    // Write the data, resuming after the partial writes.
+    size_t written = 0;
+    int first = 0;
+    while (first < count) {
+        const ssize_t result = writev(fd_, iov + first, count - first);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const int error = errno;
+            // Keep the buffered data which hasn't been written, so as it
+            // is written with the next row.
+            buffer_.erase(buffer_.begin(), buffer_.begin() +
+                          std::min(written, buffer_.size()));
+            isc_throw(LeaseJournalError, "failed to write to the lease"
+                      " journal '" << filename_ << "': " << strerror(error));
+        }
+
+        written += result;
+        stats_.bytes_written_ += result;
+        unsynced_ = true;
+        size_t remaining = result;
+        while ((first < count) && (remaining >= iov[first].iov_len)) {
+            remaining -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < count) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) +
+                remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+    buffer_.clear();
+}
+
+uint64_t
+LeaseJournal::syncFile(const int fd) const {
+    const ptime start = microsec_clock::universal_time();
+    if (fsync(fd) != 0) {
+        isc_throw(LeaseJournalError, "failed to synchronize the lease"
+                  " journal '" << filename_ << "': " << strerror(errno));
+    }
+    return ((microsec_clock::universal_time() - start).total_microseconds());
+}
+
+void
+LeaseJournal::updateSyncStatistics(const uint64_t sync_time) {
+    ++stats_.syncs_;
+    stats_.sync_time_ += sync_time;
+    stats_.max_sync_time_ = std::max(stats_.max_sync_time_, sync_time);
+}
+
+void
+LeaseJournal::runSync() {
+    // Signals are handled by the main thread of the server.
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    for (;;) {
+        int fd = -1;
+        {
+            Mutex::Locker lock(mutex_);
+            while (!stopping_ && cond_var_.timedWait(mutex_,
+                                                     sync_interval_)) {
+                ;
+            }
+            // The remaining rows are written by close.
+            if (stopping_) {
+                return;
+            }
+            if (buffer_.empty() && !unsynced_) {
+                continue;
+            }
+
+            try {
+                writeBuffer(NULL, 0);
+            } catch (const std::exception& ex) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_JOURNAL_SYNC_FAILED)
+                    .arg(filename_).arg(ex.what());
+                continue;
+            }
+            // The rows written from now on are synchronized next time.
+            unsynced_ = false;
+            fd = fd_;
+        }
+
+        // The file is synchronized without blocking the writers. It is not
+        // closed before this thread terminates.
+        try {
+            const uint64_t sync_time = syncFile(fd);
+            Mutex::Locker lock(mutex_);
+            updateSyncStatistics(sync_time);
+
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_LEASE_JOURNAL_SYNC_FAILED)
+                .arg(filename_).arg(ex.what());
+            Mutex::Locker lock(mutex_);
+            unsynced_ = true;
+        }
+    }
+}
+
+} // namespace isc::dhcp
+} // namespace isc
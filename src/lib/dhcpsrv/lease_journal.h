@@ -0,0 +1,244 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LEASE_JOURNAL_H
+#define LEASE_JOURNAL_H
+
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Exception thrown when the lease journal can't be opened or
+/// written.
+class LeaseJournalError : public Exception {
+public:
+    LeaseJournalError(const char* file, size_t line, const char* what) :
+        isc::Exception(file, line, what) { };
+};
+
+/// @brief Writer of the rows appended to the lease file.
+///
+/// The journal appends the rows to the lease file through its own file
+/// descriptor, in place of the stream used by the @c CSVFile. It controls
+/// when the rows are written to the file and when the file is synchronized
+/// to disk, according to the durability policy:
+/// - @c SYNC_WRITE - each row is written and synchronized to disk before
+///   the @c write function returns,
+/// - @c SYNC_INTERVAL - the rows are collected in the buffer, which is
+///   written and synchronized to disk by the background thread at the
+///   configured interval, or by the @c write function when the buffer
+///   is full. The changes made within the interval are lost when the
+///   server crashes,
+/// - @c SYNC_OS - each row is written before the @c write function returns,
+///   but the file is not synchronized, so the operating system decides
+///   when the data reaches the disk.
+///
+/// The buffered data is written together with the row which doesn't fit
+/// into the buffer by a single @c writev call. The journal counts the
+/// bytes written to the file and measures the time taken by the disk
+/// synchronization.
+///
+/// The functions of the journal may be called from multiple threads.
+class LeaseJournal : public boost::noncopyable {
+public:
+
+    /// @brief Durability policy of the journal.
+    enum SyncPolicy {
+        SYNC_WRITE,
+        SYNC_INTERVAL,
+        SYNC_OS
+    };
+
+    /// @brief Statistics of the journal.
+    struct Statistics {
+        /// @brief Constructor.
+        Statistics()
+            : bytes_written_(0), syncs_(0), sync_time_(0),
+              max_sync_time_(0) {
+        }
+
+        /// @brief Number of bytes written to the file.
+        uint64_t bytes_written_;
+
+        /// @brief Number of the disk synchronizations.
+        uint64_t syncs_;
+
+        /// @brief Total time of the disk synchronizations in microseconds.
+        uint64_t sync_time_;
+
+        /// @brief Longest disk synchronization in microseconds.
+        uint64_t max_sync_time_;
+    };
+
+    /// @brief Default size of the buffer.
+    static const size_t DEFAULT_BUFFER_SIZE = 1048576;
+
+    /// @brief Constructor.
+    ///
+    /// @param filename Path to the lease file.
+    /// @param policy Durability policy.
+    /// @param sync_interval Interval in milliseconds at which the buffered
+    /// rows are written and synchronized to disk, used with the
+    /// @c SYNC_INTERVAL policy.
+    /// @param buffer_size Size of the buffer.
+    ///
+    /// @throw BadValue if the interval is 0 for the @c SYNC_INTERVAL policy.
+    LeaseJournal(const std::string& filename, const SyncPolicy policy,
+                 const uint32_t sync_interval = 0,
+                 const size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    /// @brief Destructor.
+    ///
+    /// Closes the journal, writing the buffered rows to the file.
+    ~LeaseJournal();
+
+    /// @brief Converts the name of the durability policy to the policy.
+    ///
+    /// @param name Name of the policy: "write", "interval" or "os".
+    ///
+    /// @throw BadValue if the name is invalid.
+    static SyncPolicy policyFromText(const std::string& name);
+
+    /// @brief Returns the durability policy.
+    SyncPolicy getSyncPolicy() const {
+        return (policy_);
+    }
+
+    /// @brief Returns the path to the lease file.
+    const std::string& getFilename() const {
+        return (filename_);
+    }
+
+    /// @brief Opens the lease file for appending.
+    ///
+    /// If the journal is open, it is closed first.
+    ///
+    /// @throw LeaseJournalError if the file can't be opened.
+    void open();
+
+    /// @brief Closes the lease file.
+    ///
+    /// The buffered rows are written to the file, which is synchronized
+    /// to disk unless the policy is @c SYNC_OS.
+    ///
+    /// @throw LeaseJournalError if the buffered rows can't be written.
+    void close();
+
+    /// @brief Appends the row to the lease file.
+    ///
+    /// @param row Row of the lease file, without the end of line.
+    ///
+    /// @throw LeaseJournalError if the journal is not open or the row
+    /// can't be written.
+    void write(const std::string& row);
+
+    /// @brief Writes the buffered rows and synchronizes the file to disk.
+    ///
+    /// @throw LeaseJournalError if the journal is not open or the rows
+    /// can't be written.
+    void sync();
+
+    /// @brief Returns the statistics of the journal.
+    Statistics getStatistics() const;
+
+private:
+
+    /// @brief Writes the data to the file.
+    ///
+    /// It must be called with the mutex locked.
+    ///
+    /// @param row Row to be written after the buffered data or NULL.
+    /// @param row_length Length of the row.
+    ///
+    /// @throw LeaseJournalError if the data can't be written. The buffered
+    /// data which hasn't been written is kept in the buffer.
+    void writeBuffer(const char* row, const size_t row_length);
+
+    /// @brief Synchronizes the file to disk.
+    ///
+    /// @param fd File descriptor of the lease file.
+    ///
+    /// @return Time taken by the synchronization in microseconds.
+    /// @throw LeaseJournalError if the synchronization fails.
+    uint64_t syncFile(const int fd) const;
+
+    /// @brief Updates the statistics after the synchronization.
+    ///
+    /// It must be called with the mutex locked.
+    ///
+    /// @param sync_time Time taken by the synchronization in microseconds.
+    void updateSyncStatistics(const uint64_t sync_time);
+
+    /// @brief Writes and synchronizes the buffered rows periodically.
+    ///
+    /// It is run by the background thread for the @c SYNC_INTERVAL policy.
+    void runSync();
+
+    /// @brief Path to the lease file.
+    std::string filename_;
+
+    /// @brief Durability policy.
+    SyncPolicy policy_;
+
+    /// @brief Interval of the synchronization in milliseconds.
+    uint32_t sync_interval_;
+
+    /// @brief Size of the buffer.
+    size_t buffer_size_;
+
+    /// @brief File descriptor of the lease file or -1.
+    int fd_;
+
+    /// @brief Rows which haven't been written to the file.
+    std::vector<char> buffer_;
+
+    /// @brief Indicates that the rows have been written to the file since
+    /// the last synchronization.
+    bool unsynced_;
+
+    /// @brief Statistics of the journal.
+    Statistics stats_;
+
+    /// @brief Indicates that the synchronization thread should terminate.
+    bool stopping_;
+
+    /// @brief Mutex protecting the file, the buffer and the statistics.
+    mutable isc::util::thread::Mutex mutex_;
+
+    /// @brief Condition variable used to stop the synchronization thread.
+    isc::util::thread::CondVar cond_var_;
+
+    /// @brief Thread synchronizing the file for the @c SYNC_INTERVAL
+    /// policy.
+    boost::scoped_ptr<isc::util::thread::Thread> sync_thread_;
+};
+
+/// @brief Pointer to the lease journal.
+typedef boost::shared_ptr<LeaseJournal> LeaseJournalPtr;
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // LEASE_JOURNAL_H
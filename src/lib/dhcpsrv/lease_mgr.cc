@@ -17,6 +17,7 @@
 
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <algorithm>
 #include <iostream>
@@ -42,6 +43,36 @@ std::string LeaseMgr::getParameter(const std::string& name) const {
     return (param->second);
 }
 
+size_t
+LeaseMgr::getConnectionCount() const {
+    // A single connection is used by default.
+    return (static_cast<size_t>(getIntegerParameter("connections", 1, 1,
+                                                    65535)));
+}
+
+int64_t
+LeaseMgr::getIntegerParameter(const std::string& name,
+                              const int64_t default_value,
+                              const int64_t min, const int64_t max) const {
+    std::string value;
+    try {
+        value = getParameter(name);
+    } catch (const Exception&) {
+        return (default_value);
+    }
+
+    int64_t number = 0;
+    try {
+        number = boost::lexical_cast<int64_t>(value);
+    } catch (const boost::bad_lexical_cast&) {
+        isc_throw(BadValue, "invalid value '" << name << "=" << value << "'");
+    }
+    if ((number < min) || (number > max)) {
+        isc_throw(BadValue, "invalid value '" << name << "=" << value << "'");
+    }
+    return (number);
+}
+
 Lease6Ptr
 LeaseMgr::getLease6(Lease::Type type, const DUID& duid,
                     uint32_t iaid, SubnetID subnet_id) const {
@@ -59,5 +90,127 @@ LeaseMgr::getLease6(Lease::Type type, const DUID& duid,
     return (*col.begin());
 }
 
+void
+LeaseMgr::asyncGetLease4(const isc::asiolink::IOAddress& addr,
+                         const Lease4Callback& callback) {
+    Lease4Ptr lease;
+    try {
+        lease = getLease4(addr);
+    } catch (const std::exception& ex) {
+        callback(Lease4Ptr(), ex.what());
+        return;
+    }
+    callback(lease, "");
+}
+
+void
+LeaseMgr::asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                         const Lease4Callback& callback) {
+    Lease4Ptr lease;
+    try {
+        lease = getLease4(hwaddr, subnet_id);
+    } catch (const std::exception& ex) {
+        callback(Lease4Ptr(), ex.what());
+        return;
+    }
+    callback(lease, "");
+}
+
+void
+LeaseMgr::asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                         const Lease4Callback& callback) {
+    Lease4Ptr lease;
+    try {
+        lease = getLease4(clientid, subnet_id);
+    } catch (const std::exception& ex) {
+        callback(Lease4Ptr(), ex.what());
+        return;
+    }
+    callback(lease, "");
+}
+
+void
+LeaseMgr::asyncGetLease6(Lease::Type type,
+                         const isc::asiolink::IOAddress& addr,
+                         const Lease6Callback& callback) {
+    Lease6Ptr lease;
+    try {
+        lease = getLease6(type, addr);
+    } catch (const std::exception& ex) {
+        callback(Lease6Ptr(), ex.what());
+        return;
+    }
+    callback(lease, "");
+}
+
+void
+LeaseMgr::asyncAddLease(const Lease4Ptr& lease,
+                        const ResultCallback& callback) {
+    bool added = false;
+    try {
+        added = addLease(lease);
+    } catch (const std::exception& ex) {
+        callback(false, ex.what());
+        return;
+    }
+    callback(added, "");
+}
+
+void
+LeaseMgr::asyncAddLease(const Lease6Ptr& lease,
+                        const ResultCallback& callback) {
+    bool added = false;
+    try {
+        added = addLease(lease);
+    } catch (const std::exception& ex) {
+        callback(false, ex.what());
+        return;
+    }
+    callback(added, "");
+}
+
+void
+LeaseMgr::asyncUpdateLease4(const Lease4Ptr& lease4,
+                            const ResultCallback& callback) {
+    try {
+        updateLease4(lease4);
+    } catch (const NoSuchLease&) {
+        callback(false, "");
+        return;
+    } catch (const std::exception& ex) {
+        callback(false, ex.what());
+        return;
+    }
+    callback(true, "");
+}
+
+void
+LeaseMgr::asyncUpdateLease6(const Lease6Ptr& lease6,
+                            const ResultCallback& callback) {
+    try {
+        updateLease6(lease6);
+    } catch (const NoSuchLease&) {
+        callback(false, "");
+        return;
+    } catch (const std::exception& ex) {
+        callback(false, ex.what());
+        return;
+    }
+    callback(true, "");
+}
+
+void
+LeaseMgr::asyncDeleteLease(const isc::asiolink::IOAddress& addr,
+                           const ResultCallback& callback) {
+    bool deleted = false;
+    try {
+        deleted = deleteLease(addr);
+    } catch (const std::exception& ex) {
+        callback(false, ex.what());
+        return;
+    }
+    callback(deleted, "");
+}
+
 } // namespace isc::dhcp
 } // namespace isc
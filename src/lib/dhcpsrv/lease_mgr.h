@@ -23,6 +23,7 @@
 #include <dhcpsrv/subnet.h>
 #include <exceptions/exceptions.h>
 
+#include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -129,6 +130,32 @@ public:
     /// Database configuration parameter map
     typedef std::map<std::string, std::string> ParameterMap;
 
+    /// @brief Callback receiving the result of an asynchronous IPv4 lease
+    /// query.
+    ///
+    /// The first argument is the lease or NULL if no lease has been found.
+    /// The second argument is the error message if the query has failed or
+    /// an empty string otherwise.
+    typedef boost::function<void(const Lease4Ptr&,
+                                 const std::string&)> Lease4Callback;
+
+    /// @brief Callback receiving the result of an asynchronous IPv6 lease
+    /// query.
+    ///
+    /// The arguments are the same as for the @c Lease4Callback.
+    typedef boost::function<void(const Lease6Ptr&,
+                                 const std::string&)> Lease6Callback;
+
+    /// @brief Callback receiving the result of an asynchronous operation
+    /// modifying the lease database.
+    ///
+    /// The first argument indicates if the lease has been added, updated or
+    /// deleted. It is false if the lease already exists (add) or doesn't
+    /// exist (update, delete), or if the operation has failed. The second
+    /// argument is the error message if the operation has failed or an
+    /// empty string otherwise.
+    typedef boost::function<void(bool, const std::string&)> ResultCallback;
+
     /// @brief Constructor
     ///
     /// @param parameters A data structure relating keywords and values
@@ -170,6 +197,23 @@ public:
     /// @return smart pointer to the lease (or NULL if a lease is not found)
     virtual Lease4Ptr getLease4(const isc::asiolink::IOAddress& addr) const = 0;
 
+    /// @brief Returns a read-only IPv4 lease for specified address.
+    ///
+    /// This is a counterpart of the @c getLease4 for the callers which only
+    /// inspect the lease. The lease manager may return the object it holds
+    /// (and other callers share) rather than a copy of it, so the returned
+    /// lease must not be modified: a caller that needs to modify the lease
+    /// must copy it first. The default implementation returns the lease
+    /// returned by @c getLease4.
+    ///
+    /// @param addr address of the searched lease
+    ///
+    /// @return smart pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease4Ptr
+    getConstLease4(const isc::asiolink::IOAddress& addr) const {
+        return (getLease4(addr));
+    }
+
     /// @brief Returns existing IPv4 leases for specified hardware address.
     ///
     /// Although in the usual case there will be only one lease, for mobile
@@ -195,6 +239,21 @@ public:
     virtual Lease4Ptr getLease4(const isc::dhcp::HWAddr& hwaddr,
                                 SubnetID subnet_id) const = 0;
 
+    /// @brief Returns a read-only IPv4 lease for specified hardware address
+    ///        and a subnet
+    ///
+    /// This is a counterpart of the @c getLease4 for the callers which only
+    /// inspect the lease (see @c getConstLease4).
+    ///
+    /// @param hwaddr hardware address of the client
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    ///
+    /// @return a pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease4Ptr
+    getConstLease4(const isc::dhcp::HWAddr& hwaddr, SubnetID subnet_id) const {
+        return (getLease4(hwaddr, subnet_id));
+    }
+
     /// @brief Returns existing IPv4 lease for specified client-id
     ///
     /// Although in the usual case there will be only one lease, for mobile
@@ -233,6 +292,28 @@ public:
     virtual Lease4Ptr getLease4(const ClientId& clientid,
                                 SubnetID subnet_id) const = 0;
 
+    /// @brief Returns a read-only IPv4 lease for specified client-id and
+    ///        a subnet
+    ///
+    /// This is a counterpart of the @c getLease4 for the callers which only
+    /// inspect the lease (see @c getConstLease4).
+    ///
+    /// @param clientid client identifier
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    ///
+    /// @return a pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease4Ptr
+    getConstLease4(const ClientId& clientid, SubnetID subnet_id) const {
+        return (getLease4(clientid, subnet_id));
+    }
+
+    /// @brief Returns all IPv4 leases belonging to a subnet.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    virtual Lease4Collection getLeases4(SubnetID subnet_id) const = 0;
+
     /// @brief Returns existing IPv6 lease for a given IPv6 address.
     ///
     /// For a given address, we assume that there will be only one lease.
@@ -246,6 +327,21 @@ public:
     virtual Lease6Ptr getLease6(Lease::Type type,
                                 const isc::asiolink::IOAddress& addr) const = 0;
 
+    /// @brief Returns a read-only IPv6 lease for a given address.
+    ///
+    /// This is a counterpart of the @c getLease6 for the callers which only
+    /// inspect the lease (see @c getConstLease4).
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param addr address of the searched lease
+    ///
+    /// @return smart pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease6Ptr
+    getConstLease6(Lease::Type type,
+                   const isc::asiolink::IOAddress& addr) const {
+        return (getLease6(type, addr));
+    }
+
     /// @brief Returns existing IPv6 leases for a given DUID+IA combination
     ///
     /// Although in the usual case there will be only one lease, for mobile
@@ -275,6 +371,35 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const = 0;
 
+    /// @brief Returns read-only IPv6 leases for a given DUID+IA combination
+    ///
+    /// This is a counterpart of the @c getLeases6 for the callers which only
+    /// inspect the leases (see @c getConstLease4).
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param duid client DUID
+    /// @param iaid IA identifier
+    /// @param subnet_id subnet id of the subnet the lease belongs to
+    ///
+    /// @return Lease collection (may be empty if no lease is found)
+    virtual ConstLease6Collection
+    getConstLeases6(Lease::Type type, const DUID& duid, uint32_t iaid,
+                    SubnetID subnet_id) const {
+        const Lease6Collection leases = getLeases6(type, duid, iaid,
+                                                   subnet_id);
+        return (ConstLease6Collection(leases.begin(), leases.end()));
+    }
+
+    /// @brief Returns all IPv6 leases belonging to a subnet.
+    ///
+    /// The returned collection holds leases of all types, i.e. addresses,
+    /// temporary addresses and prefixes.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    virtual Lease6Collection getLeases6(SubnetID subnet_id) const = 0;
+
 
     /// @brief returns zero or one IPv6 lease for a given duid+iaid+subnet_id
     ///
@@ -302,6 +427,32 @@ public:
     Lease6Ptr getLease6(Lease::Type type, const DUID& duid,
                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are returned in the order of their expiration times,
+    /// starting from the lease which expired first. Each backend maintains
+    /// an index by expiration time, so as the expired leases can be
+    /// retrieved without examining all leases in the database.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const = 0;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// The leases are returned in the order of their expiration times,
+    /// starting from the lease which expired first.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const = 0;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
@@ -322,6 +473,20 @@ public:
     /// @return true if deletion was successful, false if no such lease exists
     virtual bool deleteLease(const isc::asiolink::IOAddress& addr) = 0;
 
+    /// @brief Deletes a lease if it has expired.
+    ///
+    /// The lease is only deleted if its expiration time is still in the
+    /// past when it is deleted. The check and the deletion are done as a
+    /// single operation, so as the lease renewed or reused after it has
+    /// been found expired is not deleted.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    ///         or it has not expired.
+    virtual bool deleteExpiredLease(const isc::asiolink::IOAddress& addr) = 0;
+
     /// @brief Return backend type
     ///
     /// Returns the type of the backend (e.g. "mysql", "memfile" etc.)
@@ -372,6 +537,120 @@ public:
     /// support transactions, this is a no-op.
     virtual void rollback() = 0;
 
+    /// @name Asynchronous lease operations
+    ///
+    /// The following methods start the lease operation and return without
+    /// waiting for its result. The result is passed to the callback when it
+    /// is available, so as the caller can carry on, e.g. receive more
+    /// packets, while the database is processing the query. The backends
+    /// which can have multiple queries outstanding return the descriptor
+    /// from @c getAsyncSocket. The caller watches this descriptor for
+    /// readiness and calls @c processAsyncResults, which invokes the
+    /// callbacks of the completed operations in the order in which the
+    /// operations were started.
+    ///
+    /// The default implementations perform the operations synchronously and
+    /// invoke the callbacks before returning. Exceptions thrown by the
+    /// synchronous operations are passed to the callbacks as error messages.
+    ///
+    /// The asynchronous operations, @c getAsyncSocket and
+    /// @c processAsyncResults must be called from the same thread.
+    //@{
+
+    /// @brief Starts the query for the IPv4 lease by address.
+    ///
+    /// @param addr address of the searched lease
+    /// @param callback function receiving the lease
+    virtual void asyncGetLease4(const isc::asiolink::IOAddress& addr,
+                                const Lease4Callback& callback);
+
+    /// @brief Starts the query for the IPv4 lease by hardware address and
+    /// subnet.
+    ///
+    /// @param hwaddr hardware address of the client
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    /// @param callback function receiving the lease
+    virtual void asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    /// @brief Starts the query for the IPv4 lease by client identifier and
+    /// subnet.
+    ///
+    /// @param clientid client identifier
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    /// @param callback function receiving the lease
+    virtual void asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    /// @brief Starts the query for the IPv6 lease by address.
+    ///
+    /// @param type type of the lease
+    /// @param addr address of the searched lease
+    /// @param callback function receiving the lease
+    virtual void asyncGetLease6(Lease::Type type,
+                                const isc::asiolink::IOAddress& addr,
+                                const Lease6Callback& callback);
+
+    /// @brief Starts adding the IPv4 lease.
+    ///
+    /// @param lease lease to be added
+    /// @param callback function receiving the result
+    virtual void asyncAddLease(const Lease4Ptr& lease,
+                               const ResultCallback& callback);
+
+    /// @brief Starts adding the IPv6 lease.
+    ///
+    /// @param lease lease to be added
+    /// @param callback function receiving the result
+    virtual void asyncAddLease(const Lease6Ptr& lease,
+                               const ResultCallback& callback);
+
+    /// @brief Starts updating the IPv4 lease.
+    ///
+    /// @param lease4 lease to be updated
+    /// @param callback function receiving the result
+    virtual void asyncUpdateLease4(const Lease4Ptr& lease4,
+                                   const ResultCallback& callback);
+
+    /// @brief Starts updating the IPv6 lease.
+    ///
+    /// @param lease6 lease to be updated
+    /// @param callback function receiving the result
+    virtual void asyncUpdateLease6(const Lease6Ptr& lease6,
+                                   const ResultCallback& callback);
+
+    /// @brief Starts deleting the lease.
+    ///
+    /// @param addr address of the lease to be deleted (IPv4 or IPv6)
+    /// @param callback function receiving the result
+    virtual void asyncDeleteLease(const isc::asiolink::IOAddress& addr,
+                                  const ResultCallback& callback);
+
+    /// @brief Returns the descriptor signalling the completed asynchronous
+    /// operations.
+    ///
+    /// @return descriptor which becomes readable when the results of the
+    /// asynchronous operations arrive or -1 if the backend completes the
+    /// operations before returning.
+    virtual int getAsyncSocket() {
+        return (-1);
+    }
+
+    /// @brief Invokes the callbacks of the completed asynchronous
+    /// operations.
+    ///
+    /// It doesn't block when no results are available.
+    virtual void processAsyncResults() {
+    }
+
+    /// @brief Returns the number of the asynchronous operations which
+    /// haven't completed yet.
+    virtual size_t getAsyncPendingCount() const {
+        return (0);
+    }
+
+    //@}
+
     /// @todo: Add host management here
     /// As host reservation is outside of scope for 2012, support for hosts
     /// is currently postponed.
@@ -379,6 +658,32 @@ public:
     /// @brief returns value of the parameter
     virtual std::string getParameter(const std::string& name) const;
 
+protected:
+    /// @brief Returns the number of database connections to be opened.
+    ///
+    /// The number is taken from the "connections" parameter. It is used by
+    /// the SQL backends, which hold a pool of connections to the database.
+    ///
+    /// @return number of connections, 1 if the parameter is not specified.
+    /// @throw isc::BadValue if the value is not a number between 1 and
+    /// 65535.
+    size_t getConnectionCount() const;
+
+    /// @brief Returns the value of the integer parameter.
+    ///
+    /// @param name Name of the parameter.
+    /// @param default_value Value returned if the parameter is not
+    ///        specified.
+    /// @param min Minimum allowed value.
+    /// @param max Maximum allowed value.
+    ///
+    /// @return value of the parameter.
+    /// @throw isc::BadValue if the value is not a number in the allowed
+    ///        range.
+    int64_t getIntegerParameter(const std::string& name,
+                                const int64_t default_value,
+                                const int64_t min, const int64_t max) const;
+
 private:
     /// @brief list of parameters passed in dbconfig
     ///
@@ -14,6 +14,8 @@
 
 #include "config.h"
 
+#include <dhcpsrv/async_write_lease_mgr.h>
+#include <dhcpsrv/caching_lease_mgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/lease_mgr_factory.h>
 #include <dhcpsrv/memfile_lease_mgr.h>
@@ -124,14 +126,35 @@ LeaseMgrFactory::create(const std::string& dbaccess) {
 #ifdef HAVE_MYSQL
     if (parameters[type] == string("mysql")) {
         LOG_INFO(dhcpsrv_logger, DHCPSRV_MYSQL_DB).arg(redacted);
-        getLeaseMgrPtr().reset(new MySqlLeaseMgr(parameters));
+        LeaseMgr* lease_mgr = addCache(parameters,
+                                       new MySqlLeaseMgr(parameters));
+
+        // The group commit applies to the asynchronous writes only.
+        LeaseMgr::ParameterMap::const_iterator group_commit_size =
+            parameters.find("group-commit-size");
+        if ((group_commit_size != parameters.end()) &&
+            (group_commit_size->second != "0")) {
+            lease_mgr = addAsyncWriter(parameters, lease_mgr, false);
+        }
+        getLeaseMgrPtr().reset(lease_mgr);
         return;
     }
 #endif
 #ifdef HAVE_PGSQL
     if (parameters[type] == string("postgresql")) {
         LOG_INFO(dhcpsrv_logger, DHCPSRV_PGSQL_DB).arg(redacted);
-        getLeaseMgrPtr().reset(new PgSqlLeaseMgr(parameters));
+        LeaseMgr* lease_mgr = addCache(parameters,
+                                       new PgSqlLeaseMgr(parameters));
+
+        // The pipelining is disabled by default. When enabled, the
+        // lookups on the allocation path are pipelined as well as the
+        // writes.
+        LeaseMgr::ParameterMap::const_iterator pipeline =
+            parameters.find("pipeline");
+        if ((pipeline != parameters.end()) && (pipeline->second == "true")) {
+            lease_mgr = addAsyncWriter(parameters, lease_mgr, true);
+        }
+        getLeaseMgrPtr().reset(lease_mgr);
         return;
     }
 #endif
@@ -147,6 +170,55 @@ LeaseMgrFactory::create(const std::string& dbaccess) {
               "not specify a supported database backend");
 }
 
+void
+LeaseMgrFactory::checkWorkerThreads(const LeaseMgr::ParameterMap& parameters,
+                                    const uint32_t worker_threads) {
+    if (worker_threads > 0) {
+        return;
+    }
+
+    LeaseMgr::ParameterMap::const_iterator type = parameters.find("type");
+    if ((type == parameters.end()) || (type->second != "mysql")) {
+        return;
+    }
+
+    LeaseMgr::ParameterMap::const_iterator group_commit_size =
+        parameters.find("group-commit-size");
+    if ((group_commit_size != parameters.end()) &&
+        (group_commit_size->second != "0")) {
+        isc_throw(InvalidParameter, "the group commit of the lease database"
+                  " (group-commit-size) requires worker-threads to be"
+                  " greater than 0");
+    }
+}
+
+LeaseMgr*
+LeaseMgrFactory::addCache(const LeaseMgr::ParameterMap& parameters,
+                          LeaseMgr* backend) {
+    // The cache is disabled by default.
+    LeaseMgr::ParameterMap::const_iterator cache_size =
+        parameters.find("cache-size");
+    if ((cache_size == parameters.end()) || (cache_size->second == "0")) {
+        return (backend);
+    }
+
+    // The cache destroys the backend if it can't be created.
+    CachingLeaseMgr* cache = new CachingLeaseMgr(parameters, backend);
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_CACHE_DB).arg(cache->getCapacity())
+        .arg(backend->getType());
+    return (cache);
+}
+
+LeaseMgr*
+LeaseMgrFactory::addAsyncWriter(const LeaseMgr::ParameterMap& parameters,
+                                LeaseMgr* backend, bool async_lookups) {
+    // The backend is destroyed if the thread can't be started.
+    AsyncWriteLeaseMgr* writer = new AsyncWriteLeaseMgr(parameters, backend,
+                                                        async_lookups);
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_ASYNC_WRITE_DB).arg(backend->getType());
+    return (writer);
+}
+
 void
 LeaseMgrFactory::destroy() {
     // Destroy current lease manager.  This is a no-op if no lease manager
@@ -98,6 +98,13 @@ public:
     ///        create() to create one before calling this method.
     static LeaseMgr& instance();
 
+    /// @brief Indicates if the lease manager has been instantiated.
+    ///
+    /// @return true if the lease manager is available.
+    static bool haveInstance() {
+        return (getLeaseMgrPtr().get() != NULL);
+    }
+
     /// @brief Parse database access string
     ///
     /// Parses the string of "keyword=value" pairs and separates them
@@ -119,7 +126,57 @@ public:
     static std::string redactedAccessString(
             const LeaseMgr::ParameterMap& parameters);
 
+    /// @brief Checks the database access parameters against the number of
+    /// the worker threads
+    ///
+    /// The MySQL group commit holds each lease write until the transaction
+    /// is full or the delay elapses. Without the worker threads, nothing
+    /// else can fill the transaction, so the thread processing the packets
+    /// would wait for the delay on every write.
+    ///
+    /// @param parameters Database access parameters (output of "parse").
+    /// @param worker_threads Number of the threads processing the packets.
+    ///
+    /// @throw isc::InvalidParameter if the group commit is configured and
+    ///        there are no worker threads.
+    static void checkWorkerThreads(const LeaseMgr::ParameterMap& parameters,
+                                   const uint32_t worker_threads);
+
 private:
+    /// @brief Puts the lease cache in front of the SQL backend
+    ///
+    /// The cache is created if the "cache-size" parameter is specified and
+    /// it is not 0.
+    ///
+    /// @param parameters Database access parameters.
+    /// @param backend Lease manager of the SQL backend.
+    ///
+    /// @return the cache holding the backend or the backend itself.
+    /// @throw isc::BadValue if the cache size is invalid. The backend is
+    ///        destroyed in this case.
+    static LeaseMgr* addCache(const LeaseMgr::ParameterMap& parameters,
+                              LeaseMgr* backend);
+
+    /// @brief Makes the lease writes go through the asynchronous API of
+    /// the SQL backend
+    ///
+    /// The writes of all server threads are handed over to the single
+    /// thread which keeps them in flight at the same time. This is used
+    /// by the MySQL backend when the "group-commit-size" parameter is not
+    /// 0, and by the PostgreSQL backend when the "pipeline" parameter is
+    /// true. The PostgreSQL backend pipelines the lookups on the
+    /// allocation path too.
+    ///
+    /// @param parameters Database access parameters.
+    /// @param backend Lease manager of the SQL backend, possibly behind
+    ///        the cache.
+    /// @param async_lookups Indicates if the lookups on the allocation
+    ///        path go through the asynchronous API too.
+    ///
+    /// @return the lease manager holding the backend.
+    static LeaseMgr* addAsyncWriter(const LeaseMgr::ParameterMap& parameters,
+                                    LeaseMgr* backend, bool async_lookups);
+
     /// @brief Hold pointer to lease manager
     ///
     /// Holds a pointer to the singleton lease manager.  The singleton
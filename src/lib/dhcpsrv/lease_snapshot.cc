@@ -0,0 +1,474 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcpsrv/lease_snapshot.h>
+
+#include <boost/static_assert.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace isc::asiolink;
+
+namespace {
+
+/// @brief Magic string beginning the snapshot file.
+const char SNAPSHOT_MAGIC[8] = { 'K', 'E', 'A', 'L', 'E', 'A', 'S', 'E' };
+
+/// @brief Byte order mark, used to reject the snapshots written on the
+/// hosts with a different byte order.
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+/// @brief Header of the snapshot file.
+struct SnapshotHeader {
+    char magic_[8];
+    uint32_t byte_order_;
+    uint16_t version_;
+    uint8_t universe_;
+    uint8_t reserved_;
+    uint32_t record_size_;
+    uint32_t reserved2_;
+    uint64_t record_count_;
+    uint64_t data_size_;
+};
+
+/// @brief Record holding the DHCPv4 lease.
+struct Lease4Record {
+    int64_t cltt_;
+    uint32_t addr_;
+    uint32_t valid_lft_;
+    uint32_t subnet_id_;
+    uint32_t hwaddr_offset_;
+    uint32_t client_id_offset_;
+    uint32_t hostname_offset_;
+    uint16_t hwaddr_len_;
+    uint16_t client_id_len_;
+    uint16_t hostname_len_;
+    uint8_t fqdn_fwd_;
+    uint8_t fqdn_rev_;
+};
+
+/// @brief Record holding the DHCPv6 lease.
+struct Lease6Record {
+    int64_t cltt_;
+    uint8_t addr_[16];
+    uint32_t valid_lft_;
+    uint32_t preferred_lft_;
+    uint32_t subnet_id_;
+    uint32_t iaid_;
+    uint32_t duid_offset_;
+    uint32_t hostname_offset_;
+    uint16_t duid_len_;
+    uint16_t hostname_len_;
+    uint8_t type_;
+    uint8_t prefixlen_;
+    uint8_t fqdn_fwd_;
+    uint8_t fqdn_rev_;
+};
+
+// The records following the header are read in place, so they must
+// remain aligned.
+BOOST_STATIC_ASSERT(sizeof(SnapshotHeader) % 8 == 0);
+BOOST_STATIC_ASSERT(sizeof(Lease4Record) % 8 == 0);
+BOOST_STATIC_ASSERT(sizeof(Lease6Record) % 8 == 0);
+
+/// @brief Writes the buffer to the file.
+///
+/// @param fd Descriptor of the file.
+/// @param data Pointer to the buffer.
+/// @param length Length of the buffer.
+///
+/// @return true if the buffer has been written, false otherwise.
+bool
+writeAll(const int fd, const void* data, size_t length) {
+    const uint8_t* buf = static_cast<const uint8_t*>(data);
+    while (length > 0) {
+        const ssize_t written = write(fd, buf, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (false);
+        }
+        buf += written;
+        length -= written;
+    }
+    return (true);
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+LeaseSnapshot::LeaseSnapshot(const std::string& filename,
+                             const uint8_t universe,
+                             const size_t record_size)
+    : filename_(filename), universe_(universe), record_size_(record_size),
+      map_(NULL), map_size_(0), records_(NULL), data_(NULL), data_size_(0),
+      count_(0), position_(0), creating_(false) {
+}
+
+LeaseSnapshot::~LeaseSnapshot() {
+    unmap();
+}
+
+bool
+LeaseSnapshot::isSnapshot(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return (false);
+    }
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    const bool is_snapshot = (read(fd, magic, sizeof(magic)) ==
+                              static_cast<ssize_t>(sizeof(magic))) &&
+        (memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0);
+    ::close(fd);
+    return (is_snapshot);
+}
+
+void
+LeaseSnapshot::open() {
+    unmap();
+    creating_ = false;
+
+    const int fd = ::open(filename_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        isc_throw(LeaseSnapshotError, "unable to open the lease snapshot '"
+                  << filename_ << "': " << strerror(errno));
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        const int error = errno;
+        ::close(fd);
+        isc_throw(LeaseSnapshotError, "unable to read the size of the lease"
+                  " snapshot '" << filename_ << "': " << strerror(error));
+    }
+    map_size_ = file_stat.st_size;
+    if (map_size_ < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        isc_throw(LeaseSnapshotError, "lease snapshot '" << filename_
+                  << "' is truncated");
+    }
+    void* map = mmap(NULL, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    // The mapping remains valid after the file is closed.
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        isc_throw(LeaseSnapshotError, "unable to map the lease snapshot '"
+                  << filename_ << "': " << strerror(error));
+    }
+    map_ = map;
+    // The leases are read sequentially.
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(map_);
+    std::string error_msg;
+    if (memcmp(header->magic_, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        error_msg = "is not a lease snapshot";
+    } else if (header->byte_order_ != SNAPSHOT_BYTE_ORDER) {
+        error_msg = "has been written on a host with a different byte order";
+    } else if (header->version_ != FORMAT_VERSION) {
+        error_msg = "has unsupported version";
+    } else if (header->universe_ != universe_) {
+        error_msg = "holds leases of the wrong universe";
+    } else if (header->record_size_ != record_size_) {
+        error_msg = "has invalid record size";
+    } else {
+        const uint64_t available = map_size_ - sizeof(SnapshotHeader);
+        if ((header->record_count_ > available / record_size_) ||
+            (header->data_size_ != available -
+             header->record_count_ * record_size_)) {
+            error_msg = "is truncated";
+        }
+    }
+    if (!error_msg.empty()) {
+        unmap();
+        isc_throw(LeaseSnapshotError, "lease snapshot '" << filename_
+                  << "' " << error_msg);
+    }
+
+    records_ = static_cast<const uint8_t*>(map_) + sizeof(SnapshotHeader);
+    count_ = header->record_count_;
+    data_ = records_ + count_ * record_size_;
+    data_size_ = header->data_size_;
+    position_ = 0;
+}
+
+void
+LeaseSnapshot::create() {
+    unmap();
+    creating_ = true;
+    count_ = 0;
+    record_buffer_.clear();
+    data_buffer_.clear();
+}
+
+void
+LeaseSnapshot::close() {
+    if (!creating_) {
+        unmap();
+        return;
+    }
+    creating_ = false;
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic_, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.byte_order_ = SNAPSHOT_BYTE_ORDER;
+    header.version_ = FORMAT_VERSION;
+    header.universe_ = universe_;
+    header.record_size_ = record_size_;
+    header.record_count_ = count_;
+    header.data_size_ = data_buffer_.size();
+
+    const int fd = ::open(filename_.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                          0644);
+    if (fd < 0) {
+        isc_throw(LeaseSnapshotError, "unable to create the lease snapshot '"
+                  << filename_ << "': " << strerror(errno));
+    }
+    // The snapshot replaces the lease files once it is written, so it
+    // must be on disk before it is renamed.
+    const bool written = writeAll(fd, &header, sizeof(header)) &&
+        (record_buffer_.empty() ||
+         writeAll(fd, &record_buffer_[0], record_buffer_.size())) &&
+        (data_buffer_.empty() ||
+         writeAll(fd, &data_buffer_[0], data_buffer_.size())) &&
+        (fsync(fd) == 0);
+    const int error = errno;
+    ::close(fd);
+    std::vector<uint8_t>().swap(record_buffer_);
+    std::vector<uint8_t>().swap(data_buffer_);
+    if (!written) {
+        isc_throw(LeaseSnapshotError, "unable to write the lease snapshot '"
+                  << filename_ << "': " << strerror(error));
+    }
+}
+
+const void*
+LeaseSnapshot::nextRecord() {
+    if (!map_ || (position_ >= count_)) {
+        return (NULL);
+    }
+    return (records_ + record_size_ * position_++);
+}
+
+const uint8_t*
+LeaseSnapshot::getData(const uint32_t offset, const uint16_t length) const {
+    if (static_cast<uint64_t>(offset) + length > data_size_) {
+        return (NULL);
+    }
+    return (data_ + offset);
+}
+
+void
+LeaseSnapshot::appendRecord(const void* record) {
+    const uint8_t* buf = static_cast<const uint8_t*>(record);
+    record_buffer_.insert(record_buffer_.end(), buf, buf + record_size_);
+    ++count_;
+}
+
+void
+LeaseSnapshot::appendData(const uint8_t* data, const size_t length,
+                          uint32_t& offset, uint16_t& stored_length) {
+    if (length > std::numeric_limits<uint16_t>::max()) {
+        isc_throw(LeaseSnapshotError, "lease value of " << length
+                  << " bytes is too long for the lease snapshot");
+    }
+    if (data_buffer_.size() + length > std::numeric_limits<uint32_t>::max()) {
+        isc_throw(LeaseSnapshotError, "lease snapshot '" << filename_
+                  << "' is full");
+    }
+    offset = data_buffer_.size();
+    stored_length = length;
+    data_buffer_.insert(data_buffer_.end(), data, data + length);
+}
+
+void
+LeaseSnapshot::unmap() {
+    if (map_) {
+        munmap(map_, map_size_);
+        map_ = NULL;
+    }
+    map_size_ = 0;
+    records_ = NULL;
+    data_ = NULL;
+    data_size_ = 0;
+    position_ = 0;
+}
+
+LeaseSnapshot4::LeaseSnapshot4(const std::string& filename)
+    : LeaseSnapshot(filename, 4, sizeof(Lease4Record)) {
+}
+
+void
+LeaseSnapshot4::append(const Lease4& lease) {
+    Lease4Record record;
+    memset(&record, 0, sizeof(record));
+    record.cltt_ = lease.cltt_;
+    record.addr_ = static_cast<uint32_t>(lease.addr_);
+    record.valid_lft_ = lease.valid_lft_;
+    record.subnet_id_ = lease.subnet_id_;
+    record.fqdn_fwd_ = lease.fqdn_fwd_ ? 1 : 0;
+    record.fqdn_rev_ = lease.fqdn_rev_ ? 1 : 0;
+    if (!lease.hwaddr_.empty()) {
+        appendData(&lease.hwaddr_[0], lease.hwaddr_.size(),
+                   record.hwaddr_offset_, record.hwaddr_len_);
+    }
+    // Client id may be unset (NULL).
+    if (lease.client_id_) {
+        const std::vector<uint8_t>& client_id = lease.client_id_->getClientId();
+        appendData(&client_id[0], client_id.size(), record.client_id_offset_,
+                   record.client_id_len_);
+    }
+    appendData(reinterpret_cast<const uint8_t*>(lease.hostname_.data()),
+               lease.hostname_.size(), record.hostname_offset_,
+               record.hostname_len_);
+    appendRecord(&record);
+}
+
+bool
+LeaseSnapshot4::next(Lease4Ptr& lease) {
+    lease.reset();
+    const Lease4Record* record = static_cast<const Lease4Record*>(nextRecord());
+    if (!record) {
+        return (true);
+    }
+    const uint8_t* hwaddr = getData(record->hwaddr_offset_, record->hwaddr_len_);
+    const uint8_t* client_id = getData(record->client_id_offset_,
+                                       record->client_id_len_);
+    const uint8_t* hostname = getData(record->hostname_offset_,
+                                      record->hostname_len_);
+    if (!hwaddr || !client_id || !hostname) {
+        setReadMsg("lease record refers to the data beyond the end of"
+                   " the lease snapshot");
+        return (false);
+    }
+
+    // The lease constructor may throw if the values are invalid. We don't
+    // want this function to throw, like the CSVLeaseFile4::next.
+    try {
+        lease.reset(new Lease4(IOAddress(record->addr_),
+                               hwaddr, record->hwaddr_len_,
+                               record->client_id_len_ > 0 ? client_id : NULL,
+                               record->client_id_len_,
+                               record->valid_lft_, 0, 0, // t1, t2 = 0
+                               static_cast<time_t>(record->cltt_),
+                               record->subnet_id_,
+                               record->fqdn_fwd_ != 0,
+                               record->fqdn_rev_ != 0,
+                               std::string(reinterpret_cast<const char*>
+                                           (hostname),
+                                           record->hostname_len_)));
+    } catch (const std::exception& ex) {
+        lease.reset();
+        setReadMsg(ex.what());
+        return (false);
+    }
+    return (true);
+}
+
+LeaseSnapshot6::LeaseSnapshot6(const std::string& filename)
+    : LeaseSnapshot(filename, 6, sizeof(Lease6Record)) {
+}
+
+void
+LeaseSnapshot6::append(const Lease6& lease) {
+    Lease6Record record;
+    memset(&record, 0, sizeof(record));
+    record.cltt_ = lease.cltt_;
+    const std::vector<uint8_t> addr = lease.addr_.toBytes();
+    if (addr.size() != sizeof(record.addr_)) {
+        isc_throw(LeaseSnapshotError, "invalid address of the DHCPv6 lease: "
+                  << lease.addr_.toText());
+    }
+    memcpy(record.addr_, &addr[0], sizeof(record.addr_));
+    record.valid_lft_ = lease.valid_lft_;
+    record.preferred_lft_ = lease.preferred_lft_;
+    record.subnet_id_ = lease.subnet_id_;
+    record.iaid_ = lease.iaid_;
+    record.type_ = static_cast<uint8_t>(lease.type_);
+    record.prefixlen_ = lease.prefixlen_;
+    record.fqdn_fwd_ = lease.fqdn_fwd_ ? 1 : 0;
+    record.fqdn_rev_ = lease.fqdn_rev_ ? 1 : 0;
+    if (lease.duid_) {
+        const std::vector<uint8_t>& duid = lease.duid_->getDuid();
+        appendData(&duid[0], duid.size(), record.duid_offset_,
+                   record.duid_len_);
+    }
+    appendData(reinterpret_cast<const uint8_t*>(lease.hostname_.data()),
+               lease.hostname_.size(), record.hostname_offset_,
+               record.hostname_len_);
+    appendRecord(&record);
+}
+
+bool
+LeaseSnapshot6::next(Lease6Ptr& lease) {
+    lease.reset();
+    const Lease6Record* record = static_cast<const Lease6Record*>(nextRecord());
+    if (!record) {
+        return (true);
+    }
+    const uint8_t* duid = getData(record->duid_offset_, record->duid_len_);
+    const uint8_t* hostname = getData(record->hostname_offset_,
+                                      record->hostname_len_);
+    if (!duid || !hostname) {
+        setReadMsg("lease record refers to the data beyond the end of"
+                   " the lease snapshot");
+        return (false);
+    }
+    if (record->type_ > Lease::TYPE_PD) {
+        setReadMsg("invalid lease type in the lease snapshot");
+        return (false);
+    }
+
+    // The lease constructor throws if the DUID is empty.
+    try {
+        DuidPtr duid_ptr;
+        if (record->duid_len_ > 0) {
+            duid_ptr.reset(new DUID(duid, record->duid_len_));
+        }
+        lease.reset(new Lease6(static_cast<Lease::Type>(record->type_),
+                               IOAddress::fromBytes(AF_INET6, record->addr_),
+                               duid_ptr, record->iaid_,
+                               record->preferred_lft_, record->valid_lft_,
+                               0, 0, // t1, t2 = 0
+                               record->subnet_id_,
+                               record->fqdn_fwd_ != 0,
+                               record->fqdn_rev_ != 0,
+                               std::string(reinterpret_cast<const char*>
+                                           (hostname),
+                                           record->hostname_len_),
+                               record->prefixlen_));
+        lease->cltt_ = static_cast<time_t>(record->cltt_);
+    } catch (const std::exception& ex) {
+        lease.reset();
+        setReadMsg(ex.what());
+        return (false);
+    }
+    return (true);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
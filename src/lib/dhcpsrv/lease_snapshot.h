@@ -0,0 +1,275 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LEASE_SNAPSHOT_H
+#define LEASE_SNAPSHOT_H
+
+#include <dhcpsrv/lease.h>
+#include <exceptions/exceptions.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Exception thrown when the lease snapshot can't be opened or
+/// written.
+class LeaseSnapshotError : public Exception {
+public:
+    LeaseSnapshotError(const char* file, size_t line, const char* what) :
+        isc::Exception(file, line, what) { };
+};
+
+/// @brief Base class for the binary snapshots of the lease database.
+///
+/// The snapshot holds the same lease data as the CSV lease file, but in
+/// a binary form which can be loaded without parsing text. It is written
+/// by the Lease File Cleanup of the Memfile backend in place of the CSV
+/// file holding the result of the cleanup. The snapshot file consists of:
+/// - the header, holding the magic string, the byte order mark, the
+///   version of the format, the universe and the size and number of the
+///   lease records,
+/// - the fixed-width lease records,
+/// - the area holding the variable length data of the leases, i.e. the
+///   hardware addresses, client identifiers, DUIDs and hostnames, which
+///   the lease records refer to by offset and length.
+///
+/// The numbers are stored in the host byte order and the records are
+/// aligned, so as the snapshot is memory mapped and the records are read
+/// in place. A snapshot written on the host with a different byte order
+/// is rejected.
+///
+/// The snapshot is written in one go: the records appended with the
+/// @c append functions of the derived classes are buffered and the file
+/// is written and synchronized to disk by @c close.
+class LeaseSnapshot : public boost::noncopyable {
+public:
+
+    /// @brief Version of the snapshot format.
+    static const uint16_t FORMAT_VERSION = 1;
+
+    /// @brief Destructor.
+    ///
+    /// Unmaps the snapshot. The records which have been appended, but not
+    /// written by @c close, are discarded.
+    virtual ~LeaseSnapshot();
+
+    /// @brief Checks if the file is a lease snapshot.
+    ///
+    /// @param filename Path to the file.
+    ///
+    /// @return true if the file begins with the magic string of the
+    /// snapshot, false if it doesn't or if it can't be read.
+    static bool isSnapshot(const std::string& filename);
+
+    /// @brief Returns the path to the snapshot file.
+    const std::string& getFilename() const {
+        return (filename_);
+    }
+
+    /// @brief Opens the existing snapshot for reading.
+    ///
+    /// Maps the file to memory and verifies its header.
+    ///
+    /// @throw LeaseSnapshotError if the file can't be mapped or if it is
+    /// not a valid snapshot for the universe of the derived class.
+    void open();
+
+    /// @brief Creates a new snapshot.
+    ///
+    /// The leases appended to the snapshot are written to the file when
+    /// it is closed. The existing file is replaced.
+    void create();
+
+    /// @brief Closes the snapshot.
+    ///
+    /// If the snapshot has been created, it writes the appended records
+    /// to the file and synchronizes the file to disk.
+    ///
+    /// @throw LeaseSnapshotError if the file can't be written.
+    void close();
+
+    /// @brief Returns the number of the leases in the snapshot.
+    ///
+    /// For the snapshot being created, it returns the number of leases
+    /// appended so far.
+    uint64_t getLeaseCount() const {
+        return (count_);
+    }
+
+    /// @brief Returns the description of the last error reading a lease.
+    std::string getReadMsg() const {
+        return (read_msg_);
+    }
+
+protected:
+
+    /// @brief Constructor.
+    ///
+    /// @param filename Path to the snapshot file.
+    /// @param universe Universe of the leases: 4 or 6.
+    /// @param record_size Size of the lease record.
+    LeaseSnapshot(const std::string& filename, const uint8_t universe,
+                  const size_t record_size);
+
+    /// @brief Returns the next lease record of the open snapshot.
+    ///
+    /// @return Pointer to the record or NULL if all records have been read.
+    const void* nextRecord();
+
+    /// @brief Returns the variable length data of the lease.
+    ///
+    /// @param offset Offset of the data in the data area of the snapshot.
+    /// @param length Length of the data.
+    ///
+    /// @return Pointer to the data or NULL if the data exceeds the data
+    /// area. The non-NULL pointer is also returned for zero length data.
+    const uint8_t* getData(const uint32_t offset, const uint16_t length) const;
+
+    /// @brief Appends the lease record to the snapshot being created.
+    ///
+    /// @param record Pointer to the record of the size specified in the
+    /// constructor.
+    void appendRecord(const void* record);
+
+    /// @brief Appends the variable length data of the lease.
+    ///
+    /// @param data Pointer to the data.
+    /// @param length Length of the data.
+    /// @param [out] offset Offset of the data in the data area.
+    /// @param [out] stored_length Length of the data, as stored in the
+    /// record.
+    ///
+    /// @throw LeaseSnapshotError if the data is too long or the data area
+    /// is full.
+    void appendData(const uint8_t* data, const size_t length,
+                    uint32_t& offset, uint16_t& stored_length);
+
+    /// @brief Sets the description of the error reading a lease.
+    void setReadMsg(const std::string& read_msg) {
+        read_msg_ = read_msg;
+    }
+
+private:
+
+    /// @brief Unmaps the open snapshot.
+    void unmap();
+
+    /// @brief Path to the snapshot file.
+    std::string filename_;
+
+    /// @brief Universe of the leases: 4 or 6.
+    uint8_t universe_;
+
+    /// @brief Size of the lease record.
+    size_t record_size_;
+
+    /// @brief Address of the mapped snapshot or NULL.
+    void* map_;
+
+    /// @brief Size of the mapped snapshot.
+    size_t map_size_;
+
+    /// @brief Pointer to the first record of the mapped snapshot.
+    const uint8_t* records_;
+
+    /// @brief Pointer to the data area of the mapped snapshot.
+    const uint8_t* data_;
+
+    /// @brief Size of the data area of the mapped snapshot.
+    uint64_t data_size_;
+
+    /// @brief Number of the leases in the snapshot.
+    uint64_t count_;
+
+    /// @brief Index of the next record to be read.
+    uint64_t position_;
+
+    /// @brief Indicates that the snapshot is being created.
+    bool creating_;
+
+    /// @brief Records appended to the snapshot being created.
+    std::vector<uint8_t> record_buffer_;
+
+    /// @brief Data area of the snapshot being created.
+    std::vector<uint8_t> data_buffer_;
+
+    /// @brief Description of the last error reading a lease.
+    std::string read_msg_;
+};
+
+/// @brief Binary snapshot of the DHCPv4 leases.
+///
+/// It holds the lease values written to the @c CSVLeaseFile4.
+class LeaseSnapshot4 : public LeaseSnapshot {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// @param filename Path to the snapshot file.
+    explicit LeaseSnapshot4(const std::string& filename);
+
+    /// @brief Appends the lease to the snapshot being created.
+    ///
+    /// @param lease Lease to be appended.
+    ///
+    /// @throw LeaseSnapshotError if the lease values can't be stored.
+    void append(const Lease4& lease);
+
+    /// @brief Reads the next lease from the snapshot.
+    ///
+    /// @param [out] lease Pointer to the lease read or NULL pointer if
+    /// all leases have been read or the error has occurred.
+    ///
+    /// @return false if the record is malformed, true otherwise. The error
+    /// may be read using @c getReadMsg.
+    bool next(Lease4Ptr& lease);
+};
+
+/// @brief Binary snapshot of the DHCPv6 leases.
+///
+/// It holds the lease values written to the @c CSVLeaseFile6.
+class LeaseSnapshot6 : public LeaseSnapshot {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// @param filename Path to the snapshot file.
+    explicit LeaseSnapshot6(const std::string& filename);
+
+    /// @brief Appends the lease to the snapshot being created.
+    ///
+    /// @param lease Lease to be appended.
+    ///
+    /// @throw LeaseSnapshotError if the lease values can't be stored.
+    void append(const Lease6& lease);
+
+    /// @brief Reads the next lease from the snapshot.
+    ///
+    /// @param [out] lease Pointer to the lease read or NULL pointer if
+    /// all leases have been read or the error has occurred.
+    ///
+    /// @return false if the record is malformed, true otherwise. The error
+    /// may be read using @c getReadMsg.
+    bool next(Lease6Ptr& lease);
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // LEASE_SNAPSHOT_H
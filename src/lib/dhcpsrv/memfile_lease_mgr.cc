@@ -14,21 +14,252 @@
 
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/lease_snapshot.h>
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <exceptions/exceptions.h>
 
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iostream>
+#include <map>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Suffix of the lease file being the input of the cleanup.
+const char* LFC_INPUT_SUFFIX = ".1";
+
+/// @brief Suffix of the lease file holding the result of the last cleanup.
+const char* LFC_PREVIOUS_SUFFIX = ".2";
+
+/// @brief Suffix of the file to which the cleanup writes the leases.
+const char* LFC_OUTPUT_SUFFIX = ".output";
+
+/// @brief Suffix of the file holding the complete result of the cleanup.
+const char* LFC_FINISH_SUFFIX = ".completed";
+
+/// @brief Checks if the file exists.
+///
+/// @param filename Path to the file.
+bool
+fileExists(const std::string& filename) {
+    struct stat file_stat;
+    return (stat(filename.c_str(), &file_stat) == 0);
+}
+
+/// @brief Renames the file.
+///
+/// @param from Current path to the file.
+/// @param to New path to the file.
+///
+/// @throw isc::dhcp::DbOperationError if the file can't be renamed.
+void
+renameFile(const std::string& from, const std::string& to) {
+    if (rename(from.c_str(), to.c_str()) != 0) {
+        isc_throw(DbOperationError, "failed to rename '" << from << "' to '"
+                  << to << "': " << strerror(errno));
+    }
+}
+
+/// @brief Synchronizes the file or directory to disk.
+///
+/// @param path Path to the file or directory.
+///
+/// @throw isc::dhcp::DbOperationError if it can't be synchronized.
+void
+syncPath(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if ((fd < 0) || (fsync(fd) != 0)) {
+        const int error = errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+        isc_throw(DbOperationError, "failed to synchronize '" << path
+                  << "' to disk: " << strerror(error));
+    }
+    close(fd);
+}
+
+/// @brief Returns the directory holding the file.
+///
+/// @param filename Path to the file.
+std::string
+getDirectory(const std::string& filename) {
+    const size_t slash = filename.find_last_of('/');
+    if (slash == std::string::npos) {
+        return (".");
+    }
+    return (slash == 0 ? "/" : filename.substr(0, slash));
+}
+
+/// @brief Replays the lease file, updating the set of live leases.
+///
+/// @param filename Path to the lease file. If it doesn't exist, the
+/// set of leases is not modified.
+/// @param [out] leases Leases indexed by address.
+///
+/// @tparam LeaseObjectType @c Lease4 or @c Lease6.
+/// @tparam LeaseFileType @c CSVLeaseFile4, @c CSVLeaseFile6,
+/// @c LeaseSnapshot4 or @c LeaseSnapshot6.
+template<typename LeaseObjectType, typename LeaseFileType>
+void
+replayLeaseFile(const std::string& filename,
+                std::map<isc::asiolink::IOAddress,
+                         boost::shared_ptr<LeaseObjectType> >& leases) {
+    if (!fileExists(filename)) {
+        return;
+    }
+
+    LeaseFileType lease_file(filename);
+    lease_file.open();
+    boost::shared_ptr<LeaseObjectType> lease;
+    do {
+        if (!lease_file.next(lease)) {
+            isc_throw(DbOperationError, "failed to parse the lease in the"
+                      " lease file " << filename << ": "
+                      << lease_file.getReadMsg());
+        }
+        if (lease) {
+            // As in the lease file loaded at startup, the valid lifetime
+            // of 0 indicates that the lease has been removed.
+            if (lease->valid_lft_ == 0) {
+                leases.erase(lease->addr_);
+            } else {
+                leases[lease->addr_] = lease;
+            }
+        }
+    } while (lease);
+    lease_file.close();
+}
+
+/// @brief Writes the leases to the new lease file or snapshot.
+///
+/// @param output_file Open lease file or created snapshot.
+/// @param leases Leases indexed by address.
+///
+/// @tparam LeaseMap Type of the map holding the leases.
+/// @tparam OutputFileType @c CSVLeaseFile4, @c CSVLeaseFile6,
+/// @c LeaseSnapshot4 or @c LeaseSnapshot6.
+template<typename LeaseMap, typename OutputFileType>
+void
+writeLeaseFile(OutputFileType& output_file, const LeaseMap& leases) {
+    for (typename LeaseMap::const_iterator lease = leases.begin();
+         lease != leases.end(); ++lease) {
+        output_file.append(*lease->second);
+    }
+    output_file.close();
+}
+
+/// @brief Runs the Lease File Cleanup for the lease file.
+///
+/// @param lease_file Lease file used by the lease manager.
+/// @param mutex Mutex protecting the lease file.
+/// @param snapshot Indicates if the result of the cleanup is written as
+/// the binary lease snapshot rather than the CSV file.
+///
+/// @tparam LeaseObjectType @c Lease4 or @c Lease6.
+/// @tparam LeaseFileType @c CSVLeaseFile4 or @c CSVLeaseFile6.
+/// @tparam SnapshotType @c LeaseSnapshot4 or @c LeaseSnapshot6.
+template<typename LeaseObjectType, typename LeaseFileType,
+         typename SnapshotType>
+void
+compactLeaseFile(LeaseFileType& lease_file, Mutex& mutex,
+                 const bool snapshot) {
+    const std::string filename = lease_file.getFilename();
+    const std::string input = filename + LFC_INPUT_SUFFIX;
+    const std::string previous = filename + LFC_PREVIOUS_SUFFIX;
+    const std::string output = filename + LFC_OUTPUT_SUFFIX;
+    const std::string finish = filename + LFC_FINISH_SUFFIX;
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START).arg(filename);
+
+    // Start a new lease file. If the input file exists, the previous
+    // cleanup has failed, so the input file is processed again and the
+    // current lease file is left to the next cleanup.
+    {
+        Mutex::Locker lock(mutex);
+        if (!fileExists(input)) {
+            lease_file.close();
+            try {
+                renameFile(filename, input);
+            } catch (...) {
+                lease_file.open();
+                throw;
+            }
+            lease_file.open();
+        }
+    }
+
+    // The rest is done without locking the lease database.
+    typedef std::map<isc::asiolink::IOAddress,
+                     boost::shared_ptr<LeaseObjectType> > LeaseMap;
+    LeaseMap leases;
+    // The result of the previous cleanup is a snapshot or a CSV file,
+    // depending on the configuration at the time it was written.
+    if (LeaseSnapshot::isSnapshot(previous)) {
+        replayLeaseFile<LeaseObjectType, SnapshotType>(previous, leases);
+    } else {
+        replayLeaseFile<LeaseObjectType, LeaseFileType>(previous, leases);
+    }
+    replayLeaseFile<LeaseObjectType, LeaseFileType>(input, leases);
+
+    // Remove the output of the cleanup which has been interrupted.
+    unlink(output.c_str());
+    if (snapshot) {
+        SnapshotType output_file(output);
+        output_file.create();
+        writeLeaseFile(output_file, leases);
+    } else {
+        LeaseFileType output_file(output);
+        output_file.open();
+        writeLeaseFile(output_file, leases);
+        // The output replaces the input files once it is renamed, so it
+        // must be on disk before (the snapshot synchronizes itself).
+        syncPath(output);
+    }
+
+    // From now on, the finish file replaces the input files, also when
+    // the server is restarted before the cleanup completes. The rename
+    // must be on disk before the input files are removed.
+    const std::string directory = getDirectory(filename);
+    renameFile(output, finish);
+    syncPath(directory);
+    unlink(previous.c_str());
+    unlink(input.c_str());
+    renameFile(finish, previous);
+    syncPath(directory);
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_COMPLETE).arg(filename)
+        .arg(leases.size());
+}
+
+} // end of anonymous namespace
 
 Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
-    : LeaseMgr(parameters) {
+    : LeaseMgr(parameters), lfc_interval_(0), snapshot_(false),
+      sync_policy_(LeaseJournal::SYNC_OS), sync_interval_(0),
+      lfc_stopping_(false) {
+    initSyncPolicy();
     // Check the universe and use v4 file or v6 file.
     std::string universe = getParameter("universe");
     if (universe == "4") {
         std::string file4 = initLeaseFilePath(V4);
         if (!file4.empty()) {
             lease_file4_.reset(new CSVLeaseFile4(file4));
+            lease_file4_->setSyncPolicy(sync_policy_, sync_interval_);
             lease_file4_->open();
             load4();
         }
@@ -36,6 +267,7 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
         std::string file6 = initLeaseFilePath(V6);
         if (!file6.empty()) {
             lease_file6_.reset(new CSVLeaseFile6(file6));
+            lease_file6_->setSyncPolicy(sync_policy_, sync_interval_);
             lease_file6_->open();
             load6();
         }
@@ -47,10 +279,32 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
     // operation.
     if (!persistLeases(V4) && !persistLeases(V6)) {
         LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_NO_STORAGE);
+
+    } else {
+        initLfcInterval();
+        initSnapshot();
+        if (lfc_interval_ > 0) {
+            LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_SETUP)
+                .arg(lfc_interval_);
+            lfc_thread_.reset(new Thread(boost::bind(&Memfile_LeaseMgr::runLfc,
+                                                     this)));
+        }
     }
 }
 
 Memfile_LeaseMgr::~Memfile_LeaseMgr() {
+    if (lfc_thread_) {
+        {
+            Mutex::Locker lock(lfc_mutex_);
+            lfc_stopping_ = true;
+            lfc_cond_var_.signal();
+        }
+        // The cleanup in progress (if any) is completed before the thread
+        // terminates.
+        lfc_thread_->wait();
+        lfc_thread_.reset();
+    }
+
     if (lease_file4_) {
         lease_file4_->close();
         lease_file4_.reset();
@@ -63,14 +317,35 @@ Memfile_LeaseMgr::~Memfile_LeaseMgr() {
 
 bool
 Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR4).arg(lease->addr_.toText());
 
-    if (getLease4(lease->addr_)) {
+    // The leases are stored by the numeric value of the address, which
+    // can't be obtained for the IPv6 address.
+    if (!lease->addr_.isV4()) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_ADD_INVALID_ADDR)
+            .arg(lease->addr_.toText());
+        return (false);
+    }
+
+    if (storage4_.find(static_cast<uint32_t>(lease->addr_)) !=
+        storage4_.end()) {
         // there is a lease with specified address already
         return (false);
     }
 
+    // The hardware address and subnet id are unique too, so the lease
+    // can't be added if they are used by another lease. This is checked
+    // before the lease is written to disk (see updateLease4).
+    typedef Lease4Storage::nth_index<1>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<1>();
+    if (idx.find(boost::make_tuple(CompactId(lease->hwaddr_),
+                                   lease->subnet_id_)) != idx.end()) {
+        return (false);
+    }
+
     // Try to write a lease to disk first. If this fails, the lease will
     // not be inserted to the memory and the disk and in-memory data will
     // remain consistent.
@@ -78,16 +353,30 @@ Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
         lease_file4_->append(*lease);
     }
 
-    storage4_.insert(lease);
+    if (!storage4_.insert(CompactLease4(*lease, strings_)).second) {
+        isc_throw(DbOperationError, "failed to add the lease with address "
+                  << lease->addr_);
+    }
     return (true);
 }
 
 bool
 Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR6).arg(lease->addr_.toText());
 
-    if (getLease6(lease->type_, lease->addr_)) {
+    // The leases are stored by the binary form of the IPv6 address (see
+    // addLease(const Lease4Ptr&)).
+    if (!lease->addr_.isV6()) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_ADD_INVALID_ADDR)
+            .arg(lease->addr_.toText());
+        return (false);
+    }
+
+    if (storage6_.find(CompactLease6::toAddress(lease->addr_)) !=
+        storage6_.end()) {
         // there is a lease with specified address already
         return (false);
     }
@@ -99,38 +388,72 @@ Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
         lease_file6_->append(*lease);
     }
 
-    storage6_.insert(lease);
+    // The address is the only unique member, so the lease can't conflict
+    // with another one once the address has been checked.
+    if (!storage6_.insert(CompactLease6(*lease, strings_)).second) {
+        isc_throw(DbOperationError, "failed to add the lease with address "
+                  << lease->addr_);
+    }
     return (true);
 }
 
 Lease4Ptr
 Memfile_LeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR4).arg(addr.toText());
 
+    if (!addr.isV4()) {
+        return (Lease4Ptr());
+    }
+
     typedef Lease4Storage::nth_index<0>::type SearchIndex;
     const SearchIndex& idx = storage4_.get<0>();
-    Lease4Storage::iterator l = idx.find(addr);
+    Lease4Storage::iterator l = idx.find(static_cast<uint32_t>(addr));
     if (l == storage4_.end()) {
         return (Lease4Ptr());
     } else {
-        return (Lease4Ptr(new Lease4(**l)));
+        return (l->toLease());
     }
 }
 
+ConstLease4Ptr
+Memfile_LeaseMgr::getConstLease4(const isc::asiolink::IOAddress& addr) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_ADDR4).arg(addr.toText());
+
+    if (!addr.isV4()) {
+        return (ConstLease4Ptr());
+    }
+
+    Lease4Storage::iterator l = storage4_.find(static_cast<uint32_t>(addr));
+    if (l == storage4_.end()) {
+        return (ConstLease4Ptr());
+    }
+    return (l->getShared());
+}
+
 Lease4Collection
 Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_HWADDR).arg(hwaddr.toText());
     typedef Lease4Storage::nth_index<0>::type SearchIndex;
     Lease4Collection collection;
     const SearchIndex& idx = storage4_.get<0>();
+    // Compare the stored hardware addresses with the compact form of the
+    // searched one, so as the lease objects are only created for matches.
+    const CompactId searched_hwaddr(hwaddr.hwaddr_);
     for(SearchIndex::const_iterator lease = idx.begin();
         lease != idx.end(); ++lease) {
 
         // Every Lease4 has a hardware address, so we can compare it
-        if ((*lease)->hwaddr_ == hwaddr.hwaddr_) {
-            collection.push_back((*lease));
+        if (lease->hwaddr_ == searched_hwaddr) {
+            collection.push_back(lease->toLease());
         }
     }
 
@@ -139,6 +462,8 @@ Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
 Lease4Ptr
 Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_SUBID_HWADDR).arg(subnet_id)
         .arg(hwaddr.toText());
@@ -151,30 +476,53 @@ Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
     const SearchIndex& idx = storage4_.get<1>();
     // Try to find the lease using HWAddr and subnet id.
     SearchIndex::const_iterator lease =
-        idx.find(boost::make_tuple(hwaddr.hwaddr_, subnet_id));
+        idx.find(boost::make_tuple(CompactId(hwaddr.hwaddr_), subnet_id));
     // Lease was not found. Return empty pointer to the caller.
     if (lease == idx.end()) {
         return (Lease4Ptr());
     }
 
     // Lease was found. Return it to the caller.
-    return (Lease4Ptr(new Lease4(**lease)));
+    return (lease->toLease());
+}
+
+ConstLease4Ptr
+Memfile_LeaseMgr::getConstLease4(const HWAddr& hwaddr,
+                                 SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_SUBID_HWADDR).arg(subnet_id)
+        .arg(hwaddr.toText());
+
+    typedef Lease4Storage::nth_index<1>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<1>();
+    SearchIndex::const_iterator lease =
+        idx.find(boost::make_tuple(CompactId(hwaddr.hwaddr_), subnet_id));
+    if (lease == idx.end()) {
+        return (ConstLease4Ptr());
+    }
+    return (lease->getShared());
 }
 
 Lease4Collection
 Memfile_LeaseMgr::getLease4(const ClientId& client_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_CLIENTID).arg(client_id.toText());
     typedef Memfile_LeaseMgr::Lease4Storage::nth_index<0>::type SearchIndex;
     Lease4Collection collection;
     const SearchIndex& idx = storage4_.get<0>();
+    const CompactId searched_client_id(client_id.getClientId());
     for(SearchIndex::const_iterator lease = idx.begin();
         lease != idx.end(); ++ lease) {
 
-        // client-id is not mandatory in DHCPv4. There can be a lease that does
-        // not have a client-id. Dereferencing null pointer would be a bad thing
-        if((*lease)->client_id_ && *(*lease)->client_id_ == client_id) {
-            collection.push_back((*lease));
+        // client-id is not mandatory in DHCPv4. The lease that does not
+        // have a client-id holds an empty identifier, which never matches
+        // the searched (non-empty) client-id.
+        if (lease->client_id_ == searched_client_id) {
+            collection.push_back(lease->toLease());
         }
     }
 
@@ -185,6 +533,8 @@ Lease4Ptr
 Memfile_LeaseMgr::getLease4(const ClientId& client_id,
                             const HWAddr& hwaddr,
                             SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_CLIENTID_HWADDR_SUBID).arg(client_id.toText())
                                                         .arg(hwaddr.toText())
@@ -198,8 +548,8 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     const SearchIndex& idx = storage4_.get<3>();
     // Try to get the lease using client id, hardware address and subnet id.
     SearchIndex::const_iterator lease =
-        idx.find(boost::make_tuple(client_id.getClientId(), hwaddr.hwaddr_,
-                                   subnet_id));
+        idx.find(boost::make_tuple(CompactId(client_id.getClientId()),
+                                   CompactId(hwaddr.hwaddr_), subnet_id));
 
     if (lease == idx.end()) {
         // Lease was not found. Return empty pointer to the caller.
@@ -207,12 +557,14 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     }
 
     // Lease was found. Return it to the caller.
-    return (*lease);
+    return (lease->toLease());
 }
 
 Lease4Ptr
 Memfile_LeaseMgr::getLease4(const ClientId& client_id,
                             SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_SUBID_CLIENTID).arg(subnet_id)
               .arg(client_id.toText());
@@ -225,33 +577,100 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     const SearchIndex& idx = storage4_.get<2>();
     // Try to get the lease using client id and subnet id.
     SearchIndex::const_iterator lease =
-        idx.find(boost::make_tuple(client_id.getClientId(), subnet_id));
+        idx.find(boost::make_tuple(CompactId(client_id.getClientId()),
+                                   subnet_id));
     // Lease was not found. Return empty pointer to the caller.
     if (lease == idx.end()) {
         return (Lease4Ptr());
     }
     // Lease was found. Return it to the caller.
-    return (Lease4Ptr(new Lease4(**lease)));
+    return (lease->toLease());
+}
+
+ConstLease4Ptr
+Memfile_LeaseMgr::getConstLease4(const ClientId& client_id,
+                                 SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_SUBID_CLIENTID).arg(subnet_id)
+              .arg(client_id.toText());
+
+    typedef Lease4Storage::nth_index<2>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<2>();
+    SearchIndex::const_iterator lease =
+        idx.find(boost::make_tuple(CompactId(client_id.getClientId()),
+                                   subnet_id));
+    if (lease == idx.end()) {
+        return (ConstLease4Ptr());
+    }
+    return (lease->getShared());
+}
+
+Lease4Collection
+Memfile_LeaseMgr::getLeases4(SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_SUBID4).arg(subnet_id);
+
+    Lease4Collection collection;
+    for (Lease4Storage::const_iterator lease = storage4_.begin();
+         lease != storage4_.end(); ++lease) {
+        if (lease->subnet_id_ == subnet_id) {
+            collection.push_back(lease->toLease());
+        }
+    }
+
+    return (collection);
 }
 
 Lease6Ptr
 Memfile_LeaseMgr::getLease6(Lease::Type type,
                             const isc::asiolink::IOAddress& addr) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR6)
         .arg(addr.toText())
         .arg(Lease::typeToText(type));
-    Lease6Storage::iterator l = storage6_.find(addr);
-    if (l == storage6_.end() || !(*l) || ((*l)->type_ != type)) {
+    if (!addr.isV6()) {
+        return (Lease6Ptr());
+    }
+
+    Lease6Storage::iterator l = storage6_.find(CompactLease6::toAddress(addr));
+    if (l == storage6_.end() || (l->type_ != type)) {
         return (Lease6Ptr());
     } else {
-        return (Lease6Ptr(new Lease6(**l)));
+        return (l->toLease());
+    }
+}
+
+ConstLease6Ptr
+Memfile_LeaseMgr::getConstLease6(Lease::Type type,
+                                 const isc::asiolink::IOAddress& addr) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_ADDR6)
+        .arg(addr.toText())
+        .arg(Lease::typeToText(type));
+    if (!addr.isV6()) {
+        return (ConstLease6Ptr());
     }
+
+    Lease6Storage::iterator l = storage6_.find(CompactLease6::toAddress(addr));
+    if (l == storage6_.end() || (l->type_ != type)) {
+        return (ConstLease6Ptr());
+    }
+    return (l->getShared());
 }
 
 Lease6Collection
 Memfile_LeaseMgr::getLeases6(Lease::Type type,
                             const DUID& duid, uint32_t iaid) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_IAID_DUID)
         .arg(iaid)
@@ -264,10 +683,11 @@ Memfile_LeaseMgr::getLeases6(Lease::Type type,
     const SearchIndex& idx = storage6_.get<1>();
     // Try to get the lease using the DUID, IAID and lease type.
     std::pair<SearchIndex::iterator, SearchIndex::iterator> l =
-        idx.equal_range(boost::make_tuple(duid.getDuid(), iaid, type));
+        idx.equal_range(boost::make_tuple(CompactId(duid.getDuid()), iaid,
+                                          type));
     Lease6Collection collection;
     for(SearchIndex::iterator lease = l.first; lease != l.second; ++lease) {
-        collection.push_back(Lease6Ptr(new Lease6(**lease)));
+        collection.push_back(lease->toLease());
     }
 
     return (collection);
@@ -277,6 +697,8 @@ Lease6Collection
 Memfile_LeaseMgr::getLeases6(Lease::Type type,
                              const DUID& duid, uint32_t iaid,
                              SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_IAID_SUBID_DUID)
         .arg(iaid)
@@ -290,29 +712,138 @@ Memfile_LeaseMgr::getLeases6(Lease::Type type,
     const SearchIndex& idx = storage6_.get<1>();
     // Try to get the lease using the DUID, IAID and lease type.
     std::pair<SearchIndex::iterator, SearchIndex::iterator> l =
-        idx.equal_range(boost::make_tuple(duid.getDuid(), iaid, type));
+        idx.equal_range(boost::make_tuple(CompactId(duid.getDuid()), iaid,
+                                          type));
     Lease6Collection collection;
     for(SearchIndex::iterator lease = l.first; lease != l.second; ++lease) {
         // Filter out the leases which subnet id doesn't match.
-        if((*lease)->subnet_id_ == subnet_id) {
-            collection.push_back(Lease6Ptr(new Lease6(**lease)));
+        if(lease->subnet_id_ == subnet_id) {
+            collection.push_back(lease->toLease());
         }
     }
 
     return (collection);
 }
 
+ConstLease6Collection
+Memfile_LeaseMgr::getConstLeases6(Lease::Type type, const DUID& duid,
+                                  uint32_t iaid, SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_IAID_SUBID_DUID)
+        .arg(iaid)
+        .arg(subnet_id)
+        .arg(duid.toText())
+        .arg(Lease::typeToText(type));
+
+    typedef Lease6Storage::nth_index<1>::type SearchIndex;
+    const SearchIndex& idx = storage6_.get<1>();
+    std::pair<SearchIndex::iterator, SearchIndex::iterator> l =
+        idx.equal_range(boost::make_tuple(CompactId(duid.getDuid()), iaid,
+                                          type));
+    ConstLease6Collection collection;
+    for (SearchIndex::iterator lease = l.first; lease != l.second; ++lease) {
+        if (lease->subnet_id_ == subnet_id) {
+            collection.push_back(lease->getShared());
+        }
+    }
+
+    return (collection);
+}
+
+Lease6Collection
+Memfile_LeaseMgr::getLeases6(SubnetID subnet_id) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_SUBID6).arg(subnet_id);
+
+    Lease6Collection collection;
+    for (Lease6Storage::const_iterator lease = storage6_.begin();
+         lease != storage6_.end(); ++lease) {
+        if (lease->subnet_id_ == subnet_id) {
+            collection.push_back(lease->toLease());
+        }
+    }
+
+    return (collection);
+}
+
+void
+Memfile_LeaseMgr::getExpiredLeases4(Lease4Collection& expired_leases,
+                                    const size_t max_leases) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED4).arg(max_leases);
+
+    // The leases which expiration time is lower than the current time are
+    // at the beginning of the index.
+    typedef Lease4Storage::nth_index<4>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<4>();
+    SearchIndex::const_iterator end =
+        idx.lower_bound(static_cast<int64_t>(time(NULL)));
+    size_t count = 0;
+    for (SearchIndex::const_iterator lease = idx.begin();
+         (lease != end) && ((max_leases == 0) || (count < max_leases));
+         ++lease, ++count) {
+        expired_leases.push_back(lease->toLease());
+    }
+}
+
+void
+Memfile_LeaseMgr::getExpiredLeases6(Lease6Collection& expired_leases,
+                                    const size_t max_leases) const {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED6).arg(max_leases);
+
+    typedef Lease6Storage::nth_index<2>::type SearchIndex;
+    const SearchIndex& idx = storage6_.get<2>();
+    SearchIndex::const_iterator end =
+        idx.lower_bound(static_cast<int64_t>(time(NULL)));
+    size_t count = 0;
+    for (SearchIndex::const_iterator lease = idx.begin();
+         (lease != end) && ((max_leases == 0) || (count < max_leases));
+         ++lease, ++count) {
+        expired_leases.push_back(lease->toLease());
+    }
+}
+
 void
 Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR4).arg(lease->addr_.toText());
 
-    Lease4Storage::iterator lease_it = storage4_.find(lease->addr_);
+    // The lease with the IPv6 address can't have been added.
+    Lease4Storage::iterator lease_it = storage4_.end();
+    if (lease->addr_.isV4()) {
+        lease_it = storage4_.find(static_cast<uint32_t>(lease->addr_));
+    }
     if (lease_it == storage4_.end()) {
         isc_throw(NoSuchLease, "failed to update the lease with address "
                   << lease->addr_ << " - no such lease");
     }
 
+    // The hardware address and subnet id are unique, so the update fails
+    // if they are used by another lease. This is checked before the lease
+    // is written to disk, so as the disk and in-memory data remain
+    // consistent.
+    typedef Lease4Storage::nth_index<1>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<1>();
+    SearchIndex::const_iterator other =
+        idx.find(boost::make_tuple(CompactId(lease->hwaddr_),
+                                   lease->subnet_id_));
+    if ((other != idx.end()) && (other->addr_ != lease_it->addr_)) {
+        isc_throw(DbOperationError, "failed to update the lease with address "
+                  << lease->addr_ << " - the hardware address and subnet"
+                  " id are in use by another lease");
+    }
+
     // Try to write a lease to disk first. If this fails, the lease will
     // not be inserted to the memory and the disk and in-memory data will
     // remain consistent.
@@ -320,15 +851,27 @@ Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
         lease_file4_->append(*lease);
     }
 
-    **lease_it = *lease;
+    // The stored lease must not be modified in place because the hashed
+    // indexes wouldn't reflect the new values of the indexed members.
+    // Replace it with the compact copy of the updated lease instead.
+    if (!storage4_.replace(lease_it, CompactLease4(*lease, strings_))) {
+        isc_throw(DbOperationError, "failed to update the lease with address "
+                  << lease->addr_);
+    }
 }
 
 void
 Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR6).arg(lease->addr_.toText());
 
-    Lease6Storage::iterator lease_it = storage6_.find(lease->addr_);
+    // The lease with the IPv4 address can't have been added.
+    Lease6Storage::iterator lease_it = storage6_.end();
+    if (lease->addr_.isV6()) {
+        lease_it = storage6_.find(CompactLease6::toAddress(lease->addr_));
+    }
     if (lease_it == storage6_.end()) {
         isc_throw(NoSuchLease, "failed to update the lease with address "
                   << lease->addr_ << " - no such lease");
@@ -341,28 +884,58 @@ Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
         lease_file6_->append(*lease);
     }
 
-    **lease_it = *lease;
+    // Replace the stored lease with the copy of the updated lease, so as
+    // the indexes are updated (see updateLease4). The address is the only
+    // unique member, so the lease can't conflict with another one.
+    if (!storage6_.replace(lease_it, CompactLease6(*lease, strings_))) {
+        isc_throw(DbOperationError, "failed to update the lease with address "
+                  << lease->addr_);
+    }
 }
 
 bool
 Memfile_LeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_DELETE_ADDR).arg(addr.toText());
+    return (deleteLeaseInternal(addr, false));
+}
+
+bool
+Memfile_LeaseMgr::deleteExpiredLease(const isc::asiolink::IOAddress& addr) {
+    isc::util::thread::Mutex::Locker lock(mutex_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_DELETE_EXPIRED_ADDR).arg(addr.toText());
+    return (deleteLeaseInternal(addr, true));
+}
+
+bool
+Memfile_LeaseMgr::deleteLeaseInternal(const isc::asiolink::IOAddress& addr,
+                                      const bool expired_only) {
+    // The lease expires when its expiration time is lower than the
+    // current time (see Lease::expired).
+    const int64_t now = static_cast<int64_t>(time(NULL));
     if (addr.isV4()) {
         // v4 lease
-        Lease4Storage::iterator l = storage4_.find(addr);
+        Lease4Storage::iterator l =
+            storage4_.find(static_cast<uint32_t>(addr));
         if (l == storage4_.end()) {
             // No such lease
             return (false);
+        } else if (expired_only && (l->getExpirationTime() >= now)) {
+            // The lease has been renewed or reused.
+            return (false);
         } else {
             if (persistLeases(V4)) {
                 // Copy the lease. The valid lifetime needs to be modified and
                 // we don't modify the original lease.
-                Lease4 lease_copy = **l;
+                Lease4Ptr lease_copy = l->toLease();
                 // Setting valid lifetime to 0 means that lease is being
                 // removed.
-                lease_copy.valid_lft_ = 0;
-                lease_file4_->append(lease_copy);
+                lease_copy->valid_lft_ = 0;
+                lease_file4_->append(*lease_copy);
             }
             storage4_.erase(l);
             return (true);
@@ -370,19 +943,23 @@ Memfile_LeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
 
     } else {
         // v6 lease
-        Lease6Storage::iterator l = storage6_.find(addr);
+        Lease6Storage::iterator l =
+            storage6_.find(CompactLease6::toAddress(addr));
         if (l == storage6_.end()) {
             // No such lease
             return (false);
+        } else if (expired_only && (l->getExpirationTime() >= now)) {
+            // The lease has been renewed or reused.
+            return (false);
         } else {
             if (persistLeases(V6)) {
                 // Copy the lease. The lifetimes need to be modified and we
                 // don't modify the original lease.
-                Lease6 lease_copy = **l;
+                Lease6Ptr lease_copy = l->toLease();
                 // Setting lifetimes to 0 means that lease is being removed.
-                lease_copy.valid_lft_ = 0;
-                lease_copy.preferred_lft_ = 0;
-                lease_file6_->append(lease_copy);
+                lease_copy->valid_lft_ = 0;
+                lease_copy->preferred_lft_ = 0;
+                lease_file6_->append(*lease_copy);
             }
 
             storage6_.erase(l);
@@ -427,6 +1004,15 @@ Memfile_LeaseMgr::getLeaseFilePath(Universe u) const {
     return (lease_file6_ ? lease_file6_->getFilename() : "");
 }
 
+LeaseJournalPtr
+Memfile_LeaseMgr::getLeaseJournal(Universe u) const {
+    if (u == V4) {
+        return (lease_file4_ ? lease_file4_->getJournal() : LeaseJournalPtr());
+    }
+
+    return (lease_file6_ ? lease_file6_->getJournal() : LeaseJournalPtr());
+}
+
 bool
 Memfile_LeaseMgr::persistLeases(Universe u) const {
     // Currently, if the lease file IO is not created, it means that writes to
@@ -468,6 +1054,123 @@ Memfile_LeaseMgr::initLeaseFilePath(Universe u) {
     return (lease_file);
 }
 
+void
+Memfile_LeaseMgr::initLfcInterval() {
+    std::string lfc_interval;
+    try {
+        lfc_interval = getParameter("lfc-interval");
+    } catch (const Exception&) {
+        // The periodic lease file cleanup is disabled by default.
+        return;
+    }
+
+    int64_t interval = -1;
+    try {
+        interval = boost::lexical_cast<int64_t>(lfc_interval);
+    } catch (const boost::bad_lexical_cast&) {
+        // Reported below.
+    }
+    if ((interval < 0) || (interval > 0xFFFFFFFF)) {
+        isc_throw(isc::BadValue, "invalid value 'lfc-interval="
+                  << lfc_interval << "'");
+    }
+    lfc_interval_ = static_cast<uint32_t>(interval);
+}
+
+void
+Memfile_LeaseMgr::initSnapshot() {
+    std::string snapshot;
+    try {
+        snapshot = getParameter("snapshot");
+    } catch (const Exception&) {
+        // The cleanup writes the CSV file by default.
+        return;
+    }
+
+    if (snapshot == "true") {
+        snapshot_ = true;
+    } else if (snapshot != "false") {
+        isc_throw(isc::BadValue, "invalid value 'snapshot="
+                  << snapshot << "'");
+    }
+}
+
+void
+Memfile_LeaseMgr::initSyncPolicy() {
+    std::string sync_policy;
+    try {
+        sync_policy = getParameter("sync-policy");
+    } catch (const Exception&) {
+        // The synchronization is left to the operating system by default.
+        return;
+    }
+
+    sync_policy_ = LeaseJournal::policyFromText(sync_policy);
+    if (sync_policy_ == LeaseJournal::SYNC_INTERVAL) {
+        sync_interval_ = static_cast<uint32_t>(
+            getIntegerParameter("sync-interval", 100, 1, 60000));
+    }
+}
+
+void
+Memfile_LeaseMgr::compactLeaseFiles() {
+    Mutex::Locker lfc_lock(lfc_run_mutex_);
+    if (persistLeases(V4)) {
+        compactLeaseFile<Lease4, CSVLeaseFile4,
+                         LeaseSnapshot4>(*lease_file4_, mutex_, snapshot_);
+    }
+    if (persistLeases(V6)) {
+        compactLeaseFile<Lease6, CSVLeaseFile6,
+                         LeaseSnapshot6>(*lease_file6_, mutex_, snapshot_);
+    }
+}
+
+void
+Memfile_LeaseMgr::runLfc() {
+    // Signals are handled by the main thread of the server.
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    for (;;) {
+        {
+            Mutex::Locker lock(lfc_mutex_);
+            // Wait for the next cleanup, unless the lease manager is being
+            // destroyed in the meantime.
+            while (!lfc_stopping_ &&
+                   lfc_cond_var_.timedWait(lfc_mutex_,
+                                           lfc_interval_ * 1000ULL)) {
+            }
+            if (lfc_stopping_) {
+                return;
+            }
+        }
+
+        try {
+            compactLeaseFiles();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_FAILED)
+                .arg(ex.what());
+        }
+    }
+}
+
+void
+Memfile_LeaseMgr::recoverLeaseFiles(const std::string& filename) {
+    const std::string finish = filename + LFC_FINISH_SUFFIX;
+    if (fileExists(finish)) {
+        // The cleanup has written all leases, but it was interrupted before
+        // replacing the input files.
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_RECOVER).arg(filename);
+        unlink((filename + LFC_INPUT_SUFFIX).c_str());
+        unlink((filename + LFC_PREVIOUS_SUFFIX).c_str());
+        renameFile(finish, filename + LFC_PREVIOUS_SUFFIX);
+    }
+    // The output of the interrupted cleanup may be incomplete. The input
+    // files are still in place, so the output can be safely removed.
+    unlink((filename + LFC_OUTPUT_SUFFIX).c_str());
+}
+
 void
 Memfile_LeaseMgr::load4() {
     // If lease file hasn't been opened, we are working in non-persistent mode.
@@ -483,15 +1186,44 @@ Memfile_LeaseMgr::load4() {
     // data on disk.
     storage4_.clear();
 
+    // The leases written by the lease file cleanup and the leases in the
+    // lease file being cleaned up precede the leases in the current file.
+    const std::string filename = lease_file4_->getFilename();
+    recoverLeaseFiles(filename);
+    const char* suffixes[] = { LFC_PREVIOUS_SUFFIX, LFC_INPUT_SUFFIX };
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+        const std::string previous_file = filename + suffixes[i];
+        if (LeaseSnapshot::isSnapshot(previous_file)) {
+            // The snapshot is read in place, without parsing.
+            LeaseSnapshot4 snapshot(previous_file);
+            snapshot.open();
+            LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_SNAPSHOT_LOAD)
+                .arg(snapshot.getLeaseCount()).arg(previous_file);
+            loadSnapshot4(snapshot);
+            snapshot.close();
+
+        } else if (fileExists(previous_file)) {
+            CSVLeaseFile4 lease_file(previous_file);
+            lease_file.open();
+            loadLeaseFile4(lease_file);
+            lease_file.close();
+        }
+    }
+
+    loadLeaseFile4(*lease_file4_);
+}
+
+void
+Memfile_LeaseMgr::loadLeaseFile4(CSVLeaseFile4& lease_file) {
     Lease4Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file4_->next(lease)) {
+        if (!lease_file.next(lease)) {
             isc_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file4_->getReadMsg());
+                      " the lease file: " << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
@@ -504,27 +1236,55 @@ Memfile_LeaseMgr::load4() {
     } while (lease);
 }
 
+void
+Memfile_LeaseMgr::loadSnapshot4(LeaseSnapshot4& snapshot) {
+    Lease4Ptr lease;
+    do {
+        if (!snapshot.next(lease)) {
+            isc_throw(DbOperationError, "Failed to read the DHCPv4 lease from"
+                      " the lease snapshot " << snapshot.getFilename()
+                      << ": " << snapshot.getReadMsg());
+        }
+        if (lease) {
+            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
+                      DHCPSRV_MEMFILE_LEASE_LOAD4)
+                .arg(lease->toText());
+            loadLease4(lease);
+        }
+    } while (lease);
+}
+
 void
 Memfile_LeaseMgr::loadLease4(Lease4Ptr& lease) {
     // Check if the lease already exists.
-    Lease4Storage::iterator lease_it = storage4_.find(lease->addr_);
+    Lease4Storage::iterator lease_it =
+        storage4_.find(static_cast<uint32_t>(lease->addr_));
     // Lease doesn't exist.
     if (lease_it == storage4_.end()) {
         // Add the lease only if valid lifetime is greater than 0.
         // We use valid lifetime of 0 to indicate that lease should
         // be removed.
-        if (lease->valid_lft_ > 0) {
-           storage4_.insert(lease);
-       }
+        if ((lease->valid_lft_ > 0) &&
+            !storage4_.insert(CompactLease4(*lease, strings_)).second) {
+            // The hardware address and subnet id are in use by another
+            // lease.
+            LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASE_CONFLICT)
+                .arg(lease->addr_.toText());
+        }
     } else {
         // We use valid lifetime of 0 to indicate that the lease is
         // to be removed. In such case, erase the lease.
         if (lease->valid_lft_ == 0) {
             storage4_.erase(lease_it);
 
-        } else {
-            // Update existing lease.
-            **lease_it = *lease;
+        } else if (!storage4_.replace(lease_it,
+                                      CompactLease4(*lease, strings_))) {
+            // Update existing lease. Replace it rather than modify it in
+            // place, so as the indexes are updated. The previous version
+            // of the lease is kept if the hardware address and subnet id
+            // are in use by another lease.
+            LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASE_CONFLICT)
+                .arg(lease->addr_.toText());
         }
     }
 }
@@ -544,15 +1304,44 @@ Memfile_LeaseMgr::load6() {
     // data on disk.
     storage6_.clear();
 
+    // The leases written by the lease file cleanup and the leases in the
+    // lease file being cleaned up precede the leases in the current file.
+    const std::string filename = lease_file6_->getFilename();
+    recoverLeaseFiles(filename);
+    const char* suffixes[] = { LFC_PREVIOUS_SUFFIX, LFC_INPUT_SUFFIX };
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+        const std::string previous_file = filename + suffixes[i];
+        if (LeaseSnapshot::isSnapshot(previous_file)) {
+            // The snapshot is read in place, without parsing.
+            LeaseSnapshot6 snapshot(previous_file);
+            snapshot.open();
+            LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_SNAPSHOT_LOAD)
+                .arg(snapshot.getLeaseCount()).arg(previous_file);
+            loadSnapshot6(snapshot);
+            snapshot.close();
+
+        } else if (fileExists(previous_file)) {
+            CSVLeaseFile6 lease_file(previous_file);
+            lease_file.open();
+            loadLeaseFile6(lease_file);
+            lease_file.close();
+        }
+    }
+
+    loadLeaseFile6(*lease_file6_);
+}
+
+void
+Memfile_LeaseMgr::loadLeaseFile6(CSVLeaseFile6& lease_file) {
     Lease6Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file6_->next(lease)) {
+        if (!lease_file.next(lease)) {
             isc_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file6_->getReadMsg());
+                      " the lease file: " << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
@@ -566,17 +1355,36 @@ Memfile_LeaseMgr::load6() {
     } while (lease);
 }
 
+void
+Memfile_LeaseMgr::loadSnapshot6(LeaseSnapshot6& snapshot) {
+    Lease6Ptr lease;
+    do {
+        if (!snapshot.next(lease)) {
+            isc_throw(DbOperationError, "Failed to read the DHCPv6 lease from"
+                      " the lease snapshot " << snapshot.getFilename()
+                      << ": " << snapshot.getReadMsg());
+        }
+        if (lease) {
+            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
+                      DHCPSRV_MEMFILE_LEASE_LOAD6)
+                .arg(lease->toText());
+            loadLease6(lease);
+        }
+    } while (lease);
+}
+
 void
 Memfile_LeaseMgr::loadLease6(Lease6Ptr& lease) {
     // Check if the lease already exists.
-    Lease6Storage::iterator lease_it = storage6_.find(lease->addr_);
+    Lease6Storage::iterator lease_it =
+        storage6_.find(CompactLease6::toAddress(lease->addr_));
     // Lease doesn't exist.
     if (lease_it == storage6_.end()) {
         // Add the lease only if valid lifetime is greater than 0.
         // We use valid lifetime of 0 to indicate that lease should
         // be removed.
         if (lease->valid_lft_ > 0) {
-            storage6_.insert(lease);
+            storage6_.insert(CompactLease6(*lease, strings_));
        }
     } else {
         // We use valid lifetime of 0 to indicate that the lease is
@@ -584,9 +1392,12 @@ Memfile_LeaseMgr::loadLease6(Lease6Ptr& lease) {
         if (lease->valid_lft_ == 0) {
             storage6_.erase(lease_it);
 
-        } else {
-            // Update existing lease.
-            **lease_it = *lease;
+        } else if (!storage6_.replace(lease_it,
+                                      CompactLease6(*lease, strings_))) {
+            // Update existing lease. Replace it rather than modify it in
+            // place, so as the indexes are updated.
+            LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASE_CONFLICT)
+                .arg(lease->addr_.toText());
         }
     }
 
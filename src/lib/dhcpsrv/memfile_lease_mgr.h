@@ -16,11 +16,19 @@
 #define MEMFILE_LEASE_MGR_H
 
 #include <dhcp/hwaddr.h>
+#include <dhcpsrv/compact_lease.h>
 #include <dhcpsrv/csv_lease_file4.h>
 #include <dhcpsrv/csv_lease_file6.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/lease_journal.h>
+#include <dhcpsrv/lease_snapshot.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/indexed_by.hpp>
+#include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
@@ -55,6 +63,14 @@ namespace dhcp {
 /// removal or addition of the lease is appended to the lease file
 /// synchronously.
 ///
+/// The "sync-policy" parameter controls the durability of the writes to
+/// the lease file (see @c LeaseJournal). With "sync-policy=write", each
+/// change is synchronized to disk before the function modifying the lease
+/// returns. With "sync-policy=interval", the changes are buffered and the
+/// buffer is written and synchronized to disk every "sync-interval"
+/// milliseconds (100 by default). The default "sync-policy=os" writes each
+/// change to the file, leaving the synchronization to the operating system.
+///
 /// Originally, the Memfile backend didn't write leases to disk. This was
 /// particularly useful for testing server performance in non-disk bound
 /// conditions. In order to preserve this capability, the new parameter
@@ -62,6 +78,41 @@ namespace dhcp {
 /// For example, database access string: "type=memfile persist=true"
 /// enables writes of leases to a disk.
 ///
+/// Since the lease file only grows, the backend periodically runs the Lease
+/// File Cleanup (LFC) if the "lfc-interval=[seconds]" parameter is specified
+/// in the database access string. The cleanup renames the lease file to
+/// [path].1 and creates the new lease file, to which the subsequent updates
+/// are appended. This is the only step performed with the lease database
+/// locked. Next, on a background thread, the [path].2 file (holding the
+/// result of the previous cleanup) and the [path].1 file are replayed and
+/// the leases which are still present are written to [path].output. This
+/// file is renamed to [path].completed, the input files are removed and
+/// the [path].completed file is renamed to [path].2. When the backend starts
+/// up, it loads the [path].2, [path].1 and [path] files in this order, so
+/// the startup time is proportional to the number of leases rather than to
+/// the number of lease updates since the server was first started. If the
+/// server was stopped during the cleanup, the cleanup is completed (if the
+/// [path].completed file exists) or abandoned when the backend starts up.
+///
+/// If the "snapshot=true" parameter is specified, the cleanup writes its
+/// result to the [path].2 file as the binary lease snapshot (see
+/// @c LeaseSnapshot) rather than as the CSV file. The snapshot is mapped
+/// to memory and read without parsing at startup, so only the lease files
+/// written after the snapshot are parsed. The format of the [path].2 file
+/// is recognized when it is read, so the parameter can be changed at any
+/// time.
+///
+/// The leases are held in memory in the compact form (see
+/// @c CompactLease4 and @c CompactLease6), which takes much less memory
+/// than the @c Lease4 and @c Lease6 objects. The lease objects are
+/// created only when they are returned to the caller. The read-only
+/// getters (e.g. @c getConstLease4) return the immutable lease object
+/// shared by all readers which hold it at the same time. The object is
+/// destroyed when the last reader releases it, so the compact form is the
+/// only copy of the lease kept in memory. An update stores a new version
+/// of the lease rather than modifying the shared object, so the readers
+/// holding the previous version are not affected.
+///
 /// The lease file locations can be specified with the "name=[path]"
 /// parameter in the database access string. The [path] is the
 /// absolute path to the file (including file name). If this parameter
@@ -115,6 +166,17 @@ public:
     /// @return a collection of leases
     virtual Lease4Ptr getLease4(const isc::asiolink::IOAddress& addr) const;
 
+    /// @brief Returns the shared IPv4 lease for specified IPv4 address.
+    ///
+    /// This function doesn't copy the lease: all callers get the same
+    /// immutable object until the lease is updated or deleted.
+    ///
+    /// @param addr An address of the searched lease.
+    ///
+    /// @return smart pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease4Ptr
+    getConstLease4(const isc::asiolink::IOAddress& addr) const;
+
     /// @brief Returns existing IPv4 leases for specified hardware address.
     ///
     /// Although in the usual case there will be only one lease, for mobile
@@ -143,6 +205,18 @@ public:
     virtual Lease4Ptr getLease4(const HWAddr& hwaddr,
                                 SubnetID subnet_id) const;
 
+    /// @brief Returns the shared IPv4 lease for specified hardware address
+    ///        and a subnet
+    ///
+    /// This function doesn't copy the lease (see @c getConstLease4).
+    ///
+    /// @param hwaddr hardware address of the client
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    ///
+    /// @return a pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease4Ptr getConstLease4(const HWAddr& hwaddr,
+                                          SubnetID subnet_id) const;
+
     /// @brief Returns existing IPv4 lease for specified client-id
     ///
     /// @param client_id client identifier
@@ -178,6 +252,28 @@ public:
     virtual Lease4Ptr getLease4(const ClientId& clientid,
                                 SubnetID subnet_id) const;
 
+    /// @brief Returns the shared IPv4 lease for specified client-id and
+    ///        a subnet
+    ///
+    /// This function doesn't copy the lease (see @c getConstLease4).
+    ///
+    /// @param clientid client identifier
+    /// @param subnet_id identifier of the subnet that lease must belong to
+    ///
+    /// @return a pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease4Ptr getConstLease4(const ClientId& clientid,
+                                          SubnetID subnet_id) const;
+
+    /// @brief Returns all IPv4 leases belonging to a subnet.
+    ///
+    /// There is no index by subnet identifier, so all leases are examined.
+    /// This method is not meant to be used for processing client requests.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    virtual Lease4Collection getLeases4(SubnetID subnet_id) const;
+
     /// @brief Returns existing IPv6 lease for a given IPv6 address.
     ///
     /// This function returns a copy of the lease. The modification in the
@@ -190,6 +286,19 @@ public:
     virtual Lease6Ptr getLease6(Lease::Type type,
                                 const isc::asiolink::IOAddress& addr) const;
 
+    /// @brief Returns the shared IPv6 lease for a given IPv6 address.
+    ///
+    /// This function doesn't copy the lease: all callers get the same
+    /// immutable object until the lease is updated or deleted.
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param addr An address of the searched lease.
+    ///
+    /// @return smart pointer to the lease (or NULL if a lease is not found)
+    virtual ConstLease6Ptr
+    getConstLease6(Lease::Type type,
+                   const isc::asiolink::IOAddress& addr) const;
+
     /// @brief Returns existing IPv6 lease for a given DUID + IA + lease type
     /// combination
     ///
@@ -217,6 +326,52 @@ public:
                                         uint32_t iaid,
                                         SubnetID subnet_id) const;
 
+    /// @brief Returns the shared IPv6 leases for a given DUID + IA +
+    /// subnet-id + lease type combination.
+    ///
+    /// This function doesn't copy the leases (see @c getConstLease6).
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param duid client DUID
+    /// @param iaid IA identifier
+    /// @param subnet_id identifier of the subnet the lease must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    virtual ConstLease6Collection
+    getConstLeases6(Lease::Type type, const DUID& duid, uint32_t iaid,
+                    SubnetID subnet_id) const;
+
+    /// @brief Returns all IPv6 leases belonging to a subnet.
+    ///
+    /// There is no index by subnet identifier, so all leases are examined.
+    /// This method is not meant to be used for processing client requests.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    virtual Lease6Collection getLeases6(SubnetID subnet_id) const;
+
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are found using the index by expiration time, so as
+    /// only the returned leases are examined.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @warning This function does not validate the pointer to the lease.
@@ -245,6 +400,15 @@ public:
     /// @return true if deletion was successful, false if no such lease exists
     virtual bool deleteLease(const isc::asiolink::IOAddress& addr);
 
+    /// @brief Deletes a lease if it has expired.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    ///         or it has not expired.
+    virtual bool deleteExpiredLease(const isc::asiolink::IOAddress& addr);
+
     /// @brief Return backend type
     ///
     /// Returns the type of the backend.
@@ -316,17 +480,84 @@ public:
     /// server shut down.
     bool persistLeases(Universe u) const;
 
+    /// @brief Returns the interval between the lease file cleanups.
+    ///
+    /// @return Interval in seconds or 0 if the periodic cleanup is disabled.
+    uint32_t getLfcInterval() const {
+        return (lfc_interval_);
+    }
+
+    /// @brief Checks if the lease file cleanup writes the lease snapshot.
+    ///
+    /// @return true if the result of the cleanup is written as the binary
+    /// lease snapshot, false if it is written as the CSV file.
+    bool useSnapshot() const {
+        return (snapshot_);
+    }
+
+    /// @brief Returns the journal writing to the lease file.
+    ///
+    /// @param u Universe (V4 or V6).
+    ///
+    /// @return Pointer to the journal or NULL pointer if the leases are
+    /// not written to disk.
+    LeaseJournalPtr getLeaseJournal(Universe u) const;
+
+    /// @brief Runs the Lease File Cleanup.
+    ///
+    /// This method removes the redundant lease records from the lease file
+    /// as described in the class description. It is called periodically on
+    /// the background thread, if the "lfc-interval" parameter is specified,
+    /// but it may also be called directly. The lease database is locked
+    /// only while the lease file is renamed, so the leases can be accessed
+    /// while the cleanup is in progress.
+    ///
+    /// @throw isc::DbOperationError if the lease file can't be renamed or
+    /// parsed.
+    void compactLeaseFiles();
+
 protected:
 
+    /// @brief Deletes a lease.
+    ///
+    /// The caller must hold the lock protecting the leases.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    /// @param expired_only Indicates if the lease is only deleted if it
+    ///        has expired.
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    ///         or it has not expired and the @c expired_only is true.
+    bool deleteLeaseInternal(const isc::asiolink::IOAddress& addr,
+                             const bool expired_only);
+
     /// @brief Load all DHCPv4 leases from the file.
     ///
     /// This method loads all DHCPv4 leases from a file to memory. It removes
-    /// existing leases before reading a file.
+    /// existing leases before reading a file. The files left by the lease
+    /// file cleanup are read before the lease file.
     ///
     /// @throw isc::DbOperationError If failed to read a lease from the lease
     /// file.
     void load4();
 
+    /// @brief Loads all DHCPv4 leases from the specified lease file.
+    ///
+    /// @param lease_file Open lease file.
+    ///
+    /// @throw isc::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile4(CSVLeaseFile4& lease_file);
+
+    /// @brief Loads all DHCPv4 leases from the lease snapshot.
+    ///
+    /// @param snapshot Open lease snapshot.
+    ///
+    /// @throw isc::DbOperationError If failed to read a lease from the
+    /// snapshot.
+    void loadSnapshot4(LeaseSnapshot4& snapshot);
+
     /// @brief Loads a single DHCPv4 lease from the file.
     ///
     /// This method reads a single lease record from the lease file. If the
@@ -343,12 +574,29 @@ protected:
     /// @brief Load all DHCPv6 leases from the file.
     ///
     /// This method loads all DHCPv6 leases from a file to memory. It removes
-    /// existing leases before reading a file.
+    /// existing leases before reading a file. The files left by the lease
+    /// file cleanup are read before the lease file.
     ///
     /// @throw isc::DbOperationError If failed to read a lease from the lease
     /// file.
     void load6();
 
+    /// @brief Loads all DHCPv6 leases from the specified lease file.
+    ///
+    /// @param lease_file Open lease file.
+    ///
+    /// @throw isc::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile6(CSVLeaseFile6& lease_file);
+
+    /// @brief Loads all DHCPv6 leases from the lease snapshot.
+    ///
+    /// @param snapshot Open lease snapshot.
+    ///
+    /// @throw isc::DbOperationError If failed to read a lease from the
+    /// snapshot.
+    void loadSnapshot6(LeaseSnapshot6& snapshot);
+
     /// @brief Loads a single DHCPv6 lease from the file.
     ///
     /// This method reads a single lease record from the lease file. If the
@@ -379,108 +627,161 @@ protected:
     /// argument to this function.
     std::string initLeaseFilePath(Universe u);
 
+    /// @brief Completes or abandons the interrupted lease file cleanup.
+    ///
+    /// This method is called before the leases are loaded from the files.
+    /// If the file holding the result of the cleanup exists, it replaces
+    /// the cleanup input files. Otherwise, the incomplete output of the
+    /// cleanup is removed and the input files are left untouched.
+    ///
+    /// @param filename Path to the lease file.
+    static void recoverLeaseFiles(const std::string& filename);
+
+    /// @brief Parses the "lfc-interval" parameter.
+    ///
+    /// @throw isc::BadValue if the interval is not a number of seconds.
+    void initLfcInterval();
+
+    /// @brief Parses the "snapshot" parameter.
+    ///
+    /// @throw isc::BadValue if the value is neither "true" nor "false".
+    void initSnapshot();
+
+    /// @brief Parses the "sync-policy" and "sync-interval" parameters.
+    ///
+    /// @throw isc::BadValue if the policy or the interval is invalid.
+    void initSyncPolicy();
+
+    /// @brief Runs the Lease File Cleanup periodically.
+    ///
+    /// This is the body of the background thread started when the
+    /// "lfc-interval" parameter is specified.
+    void runLfc();
+
     // This is a multi-index container, which holds elements that can
-    // be accessed using different search indexes.
+    // be accessed using different search indexes. Except for the search
+    // of expired leases, all lookups performed by the lease manager are
+    // exact matches, so hashed indexes are used rather than ordered
+    // indexes: the lookup cost doesn't grow with the number of leases.
+    // The leases are held in the compact form and the container nodes are
+    // allocated from the slabs of memory, to reduce the memory footprint
+    // of the large lease databases.
     typedef boost::multi_index_container<
-        // It holds pointers to Lease6 objects.
-        Lease6Ptr,
+        // It holds compact representations of the DHCPv6 leases.
+        CompactLease6,
         boost::multi_index::indexed_by<
             // Specification of the first index starts here.
-            // This index sorts leases by IPv6 addresses represented as
-            // IOAddress objects.
-            boost::multi_index::ordered_unique<
-                boost::multi_index::member<Lease, isc::asiolink::IOAddress, &Lease::addr_>
+            // This index hashes leases by IPv6 addresses held in the
+            // binary form.
+            boost::multi_index::hashed_unique<
+                boost::multi_index::member<CompactLease6, CompactLease6::Address,
+                                           &CompactLease6::addr_>
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_non_unique<
+            boost::multi_index::hashed_non_unique<
                 // This is a composite index that will be used to search for
                 // the lease using three attributes: DUID, IAID and lease type.
                 boost::multi_index::composite_key<
-                    Lease6,
-                    // The DUID can be retrieved from the Lease6 object using
-                    // a getDuidVector const function.
-                    boost::multi_index::const_mem_fun<Lease6, const std::vector<uint8_t>&,
-                                                      &Lease6::getDuidVector>,
-                    // The two other ingredients of this index are IAID and
-                    // lease type.
-                    boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>,
-                    boost::multi_index::member<Lease6, Lease::Type, &Lease6::type_>
+                    CompactLease6,
+                    boost::multi_index::member<CompactLease6, CompactId,
+                                               &CompactLease6::duid_>,
+                    boost::multi_index::member<CompactLease6, uint32_t,
+                                               &CompactLease6::iaid_>,
+                    boost::multi_index::member<CompactLease6, Lease::Type,
+                                               &CompactLease6::type_>
+                >
+            >,
+
+            // Specification of the third index starts here.
+            // This index orders leases by expiration time, so as the
+            // expired leases can be found without a full scan.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<
+                    CompactLease6, int64_t,
+                    &CompactLease6::getExpirationTime
                 >
             >
-        >
+        >,
+        SlabAllocator<CompactLease6>
      > Lease6Storage; // Specify the type name of this container.
 
     // This is a multi-index container, which holds elements that can
-    // be accessed using different search indexes.
+    // be accessed using different search indexes. As for the Lease6Storage,
+    // all indexes are hashed and the leases are held in the compact form.
     typedef boost::multi_index_container<
-        // It holds pointers to Lease4 objects.
-        Lease4Ptr,
+        // It holds compact representations of the DHCPv4 leases.
+        CompactLease4,
         // Specification of search indexes starts here.
         boost::multi_index::indexed_by<
             // Specification of the first index starts here.
-            // This index sorts leases by IPv4 addresses represented as
-            // IOAddress objects.
-            boost::multi_index::ordered_unique<
-                // The IPv4 address are held in addr_ members that belong to
-                // Lease class.
-                boost::multi_index::member<Lease, isc::asiolink::IOAddress, &Lease::addr_>
+            // This index hashes leases by IPv4 addresses held as integers.
+            boost::multi_index::hashed_unique<
+                boost::multi_index::member<CompactLease4, uint32_t,
+                                           &CompactLease4::addr_>
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 // This is a composite index that combines two attributes of the
-                // Lease4 object: hardware address and subnet id.
+                // lease: hardware address and subnet id.
                 boost::multi_index::composite_key<
-                    Lease4,
-                    // The hardware address is held in the hwaddr_ member of the
-                    // Lease4 object.
-                    boost::multi_index::member<Lease4, std::vector<uint8_t>,
-                                               &Lease4::hwaddr_>,
-                    // The subnet id is held in the subnet_id_ member of Lease4
-                    // class. Note that the subnet_id_ is defined in the base
-                    // class (Lease) so we have to point to this class rather
-                    // than derived class: Lease4.
-                    boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
+                    CompactLease4,
+                    boost::multi_index::member<CompactLease4, CompactId,
+                                               &CompactLease4::hwaddr_>,
+                    boost::multi_index::member<CompactLease4, SubnetID,
+                                               &CompactLease4::subnet_id_>
                 >
             >,
 
             // Specification of the third index starts here.
-            boost::multi_index::ordered_non_unique<
+            boost::multi_index::hashed_non_unique<
                 // This is a composite index that uses two values to search for a
-                // lease: client id and subnet id.
+                // lease: client id and subnet id. The client id is empty if
+                // the lease doesn't have one.
                 boost::multi_index::composite_key<
-                    Lease4,
-                    // The client id can be retrieved from the Lease4 object by
-                    // calling getClientIdVector const function.
-                    boost::multi_index::const_mem_fun<Lease4, const std::vector<uint8_t>&,
-                                                      &Lease4::getClientIdVector>,
-                    // The subnet id is accessed through the subnet_id_ member.
-                    boost::multi_index::member<Lease, uint32_t, &Lease::subnet_id_>
+                    CompactLease4,
+                    boost::multi_index::member<CompactLease4, CompactId,
+                                               &CompactLease4::client_id_>,
+                    boost::multi_index::member<CompactLease4, SubnetID,
+                                               &CompactLease4::subnet_id_>
                 >
             >,
 
             // Specification of the fourth index starts here.
-            boost::multi_index::ordered_non_unique<
-                // This is a composite index that uses two values to search for a
-                // lease: client id and subnet id.
+            boost::multi_index::hashed_non_unique<
+                // This is a composite index that uses three values to search
+                // for a lease: client id, hardware address and subnet id.
                 boost::multi_index::composite_key<
-                    Lease4,
-                    // The client id can be retrieved from the Lease4 object by
-                    // calling getClientIdVector const function.
-                    boost::multi_index::const_mem_fun<Lease4, const std::vector<uint8_t>&,
-                                                      &Lease4::getClientIdVector>,
-                    // The hardware address is held in the hwaddr_ member of the
-                    // Lease4 object.
-                    boost::multi_index::member<Lease4, std::vector<uint8_t>,
-                                               &Lease4::hwaddr_>,
-                    // The subnet id is accessed through the subnet_id_ member.
-                    boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
+                    CompactLease4,
+                    boost::multi_index::member<CompactLease4, CompactId,
+                                               &CompactLease4::client_id_>,
+                    boost::multi_index::member<CompactLease4, CompactId,
+                                               &CompactLease4::hwaddr_>,
+                    boost::multi_index::member<CompactLease4, SubnetID,
+                                               &CompactLease4::subnet_id_>
+                >
+            >,
+
+            // Specification of the fifth index starts here.
+            // This index orders leases by expiration time, so as the
+            // expired leases can be found without a full scan.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<
+                    CompactLease4, int64_t,
+                    &CompactLease4::getExpirationTime
                 >
             >
-        >
+        >,
+        SlabAllocator<CompactLease4>
     > Lease4Storage; // Specify the type name for this container.
 
+    /// @brief Pool of hostnames and comments of the stored leases.
+    ///
+    /// It must be declared before the containers holding the leases,
+    /// so as it is destroyed after them.
+    StringPool strings_;
+
     /// @brief stores IPv4 leases
     Lease4Storage storage4_;
 
@@ -493,6 +794,41 @@ protected:
     /// @brief Holds the pointer to the DHCPv6 lease file IO.
     boost::shared_ptr<CSVLeaseFile6> lease_file6_;
 
+    /// @brief Interval between the lease file cleanups in seconds.
+    uint32_t lfc_interval_;
+
+    /// @brief Indicates if the cleanup writes the binary lease snapshot.
+    bool snapshot_;
+
+    /// @brief Durability policy of the writes to the lease file.
+    LeaseJournal::SyncPolicy sync_policy_;
+
+    /// @brief Synchronization interval of the lease file in milliseconds.
+    uint32_t sync_interval_;
+
+    /// @brief Thread running the lease file cleanup periodically.
+    boost::scoped_ptr<isc::util::thread::Thread> lfc_thread_;
+
+    /// @brief Indicates that the lease file cleanup thread should stop.
+    bool lfc_stopping_;
+
+    /// @brief Mutex protecting the @c lfc_stopping_ flag.
+    isc::util::thread::Mutex lfc_mutex_;
+
+    /// @brief Condition variable used to stop the cleanup thread.
+    isc::util::thread::CondVar lfc_cond_var_;
+
+    /// @brief Mutex preventing concurrent runs of the lease file cleanup.
+    isc::util::thread::Mutex lfc_run_mutex_;
+
+    /// @brief Mutex protecting the lease containers and lease files.
+    ///
+    /// The lease manager is accessed by multiple packet processing threads
+    /// when the server runs worker threads. The public methods
+    /// reading or modifying the leases lock this mutex, and the getters
+    /// return copies of the stored leases or the immutable shared leases.
+    mutable isc::util::thread::Mutex mutex_;
+
 };
 
 }; // end of isc::dhcp namespace
@@ -20,17 +20,24 @@
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/mysql_lease_mgr.h>
 
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/static_assert.hpp>
 #include <mysqld_error.h>
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <pthread.h>
+#include <signal.h>
 #include <time.h>
 
 using namespace isc;
 using namespace isc::dhcp;
+using namespace isc::util::thread;
+using namespace boost::posix_time;
 using namespace std;
 
 /// @file
@@ -127,6 +134,10 @@ TaggedStatement tagged_statements[] = {
                     "DELETE FROM lease4 WHERE address = ?"},
     {MySqlLeaseMgr::DELETE_LEASE6,
                     "DELETE FROM lease6 WHERE address = ?"},
+    {MySqlLeaseMgr::DELETE_EXPIRED_LEASE4,
+                    "DELETE FROM lease4 WHERE address = ? AND expire < ?"},
+    {MySqlLeaseMgr::DELETE_EXPIRED_LEASE6,
+                    "DELETE FROM lease6 WHERE address = ? AND expire < ?"},
     {MySqlLeaseMgr::GET_LEASE4_ADDR,
                     "SELECT address, hwaddr, client_id, "
                         "valid_lifetime, expire, subnet_id, "
@@ -145,6 +156,14 @@ TaggedStatement tagged_statements[] = {
                         "fqdn_fwd, fqdn_rev, hostname "
                             "FROM lease4 "
                             "WHERE client_id = ? AND subnet_id = ?"},
+    {MySqlLeaseMgr::GET_LEASE4_EXPIRE,
+                    "SELECT address, hwaddr, client_id, "
+                        "valid_lifetime, expire, subnet_id, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease4 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire "
+                            "LIMIT ?"},
     {MySqlLeaseMgr::GET_LEASE4_HWADDR,
                     "SELECT address, hwaddr, client_id, "
                         "valid_lifetime, expire, subnet_id, "
@@ -157,6 +176,12 @@ TaggedStatement tagged_statements[] = {
                         "fqdn_fwd, fqdn_rev, hostname "
                             "FROM lease4 "
                             "WHERE hwaddr = ? AND subnet_id = ?"},
+    {MySqlLeaseMgr::GET_LEASE4_SUBID,
+                    "SELECT address, hwaddr, client_id, "
+                        "valid_lifetime, expire, subnet_id, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease4 "
+                            "WHERE subnet_id = ?"},
     {MySqlLeaseMgr::GET_LEASE6_ADDR,
                     "SELECT address, duid, valid_lifetime, "
                         "expire, subnet_id, pref_lifetime, "
@@ -179,6 +204,22 @@ TaggedStatement tagged_statements[] = {
                             "FROM lease6 "
                             "WHERE duid = ? AND iaid = ? AND subnet_id = ? "
                             "AND lease_type = ?"},
+    {MySqlLeaseMgr::GET_LEASE6_EXPIRE,
+                    "SELECT address, duid, valid_lifetime, "
+                        "expire, subnet_id, pref_lifetime, "
+                        "lease_type, iaid, prefix_len, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease6 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire "
+                            "LIMIT ?"},
+    {MySqlLeaseMgr::GET_LEASE6_SUBID,
+                    "SELECT address, duid, valid_lifetime, "
+                        "expire, subnet_id, pref_lifetime, "
+                        "lease_type, iaid, prefix_len, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease6 "
+                            "WHERE subnet_id = ?"},
     {MySqlLeaseMgr::GET_VERSION,
                     "SELECT version, minor FROM schema_version"},
     {MySqlLeaseMgr::INSERT_LEASE4,
@@ -1099,47 +1140,151 @@ private:
     MYSQL_STMT*     statement_;     ///< Statement for which results are freed
 };
 
+/// @brief Connection to the MySQL database
+///
+/// Holds the MySQL context object together with the prepared statements and
+/// the exchange objects, which can only be used by one thread at a time.
+/// The lease manager keeps a pool of these objects and checks one of them
+/// out for the duration of each lease operation.
+class MySqlConnection : public boost::noncopyable {
+public:
+
+    /// @brief Constructor
+    ///
+    /// Initializes the MySQL context object.  The database is opened and
+    /// the statements are prepared by the lease manager.
+    ///
+    /// @throw DbOpenError Unable to initialize MySql handle.
+    MySqlConnection()
+        : statements_(MySqlLeaseMgr::NUM_STATEMENTS, NULL),
+          exchange4_(new MySqlLease4Exchange()),
+          exchange6_(new MySqlLease6Exchange()) {
+    }
+
+    /// @brief Destructor
+    ///
+    /// Frees up the prepared statements, ignoring errors.  (What would we do
+    /// about them? We're destroying this object and are not really concerned
+    /// with errors on a database connection that is about to go away.)
+    /// The database is closed in the destructor of the mysql_ member.
+    ~MySqlConnection() {
+        for (int i = 0; i < statements_.size(); ++i) {
+            if (statements_[i] != NULL) {
+                (void) mysql_stmt_close(statements_[i]);
+                statements_[i] = NULL;
+            }
+        }
+    }
+
+    MySqlHolder mysql_;                     ///< MySQL context object
+    std::vector<MYSQL_STMT*> statements_;   ///< Prepared statements
+
+    /// The exchange objects are used for transfer of data to/from the
+    /// database.
+    boost::scoped_ptr<MySqlLease4Exchange> exchange4_; ///< Exchange object
+    boost::scoped_ptr<MySqlLease6Exchange> exchange6_; ///< Exchange object
+};
+
 // MySqlLeaseMgr Constructor and Destructor
 
 MySqlLeaseMgr::MySqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
-    : LeaseMgr(parameters) {
+    : LeaseMgr(parameters),
+      group_commit_size_(getIntegerParameter("group-commit-size", 0, 0,
+                                             65535)),
+      group_commit_delay_(getIntegerParameter("group-commit-delay", 0, 0,
+                                              60000)),
+      async_pending_(0), stop_group_commit_(false) {
+
+    // Store the text of all statements, used in the error messages.
+    text_statements_.resize(NUM_STATEMENTS, std::string(""));
+    for (int i = 0; tagged_statements[i].text != NULL; ++i) {
+        text_statements_[tagged_statements[i].index] =
+            tagged_statements[i].text;
+    }
+
+    // Open the connections to the database, each with its own set of
+    // prepared statements.
+    pool_.reset(new ConnectionPool(boost::bind(&MySqlLeaseMgr::openConnection,
+                                               this),
+                                   &MySqlLeaseMgr::checkConnection,
+                                   getConnectionCount()));
+
+    // Start committing the asynchronous operations in the background.
+    if (group_commit_size_ > 0) {
+        commit_ready_.reset(new isc::dhcp_ddns::WatchSocket());
+        group_commit_thread_.reset(new Thread(
+            boost::bind(&MySqlLeaseMgr::runGroupCommit, this)));
+    }
+}
+
+
+MySqlLeaseMgr::~MySqlLeaseMgr() {
+    // Let the group commit thread commit the queued operations and stop.
+    // The callbacks of the operations aren't invoked, as they may refer to
+    // the objects being destroyed.
+    if (group_commit_thread_) {
+        {
+            Mutex::Locker lock(group_commit_mutex_);
+            stop_group_commit_ = true;
+            group_commit_cond_.signal();
+        }
+        try {
+            group_commit_thread_->wait();
+        } catch (...) {
+            // The thread doesn't throw, and we can't throw here anyway.
+        }
+        group_commit_thread_.reset();
+    }
+
+    // Close all connections before the library is released.
+    pool_.reset();
+
+    // The library itself shouldn't be needed anymore
+    mysql_library_end();
+}
+
+boost::shared_ptr<MySqlConnection>
+MySqlLeaseMgr::openConnection() {
+    boost::shared_ptr<MySqlConnection> conn(new MySqlConnection());
 
     // Open the database.
-    openDatabase();
+    openDatabase(*conn);
 
     // Enable autocommit.  To avoid a flush to disk on every commit, the global
     // parameter innodb_flush_log_at_trx_commit should be set to 2.  This will
     // cause the changes to be written to the log, but flushed to disk in the
     // background every second.  Setting the parameter to that value will speed
     // up the system, but at the risk of losing data if the system crashes.
-    my_bool result = mysql_autocommit(mysql_, 1);
+    my_bool result = mysql_autocommit(conn->mysql_, 1);
     if (result != 0) {
-        isc_throw(DbOperationError, mysql_error(mysql_));
+        isc_throw(DbOperationError, mysql_error(conn->mysql_));
     }
 
     // Prepare all statements likely to be used.
-    prepareStatements();
+    prepareStatements(*conn);
 
-    // Create the exchange objects for use in exchanging data between the
-    // program and the database.
-    exchange4_.reset(new MySqlLease4Exchange());
-    exchange6_.reset(new MySqlLease6Exchange());
+    return (conn);
 }
 
-
-MySqlLeaseMgr::~MySqlLeaseMgr() {
-    // Free up the prepared statements, ignoring errors. (What would we do
-    // about them? We're destroying this object and are not really concerned
-    // with errors on a database connection that is about to go away.)
-    for (int i = 0; i < statements_.size(); ++i) {
-        if (statements_[i] != NULL) {
-            (void) mysql_stmt_close(statements_[i]);
-            statements_[i] = NULL;
-        }
+bool
+MySqlLeaseMgr::checkConnection(MySqlConnection& conn) {
+    if (mysql_ping(conn.mysql_) != 0) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MYSQL_CONNECTION_LOST)
+            .arg(mysql_error(conn.mysql_));
+        return (false);
     }
+    return (true);
+}
 
-    // There is no need to close the database in this destructor: it is
-    // closed in the destructor of the mysql_ member variable.
+void
+MySqlLeaseMgr::checkError(MySqlConnection& conn, int status,
+                          StatementIndex index, const char* what) const {
+    if (status != 0) {
+        isc_throw(DbOperationError, what << " for <" <<
+                  text_statements_[index] << ">, reason: " <<
+                  mysql_error(conn.mysql_) << " (error code " <<
+                  mysql_errno(conn.mysql_) << ")");
+    }
 }
 
 
@@ -1202,7 +1347,7 @@ MySqlLeaseMgr::convertFromDatabaseTime(const MYSQL_TIME& expire,
 // Open the database using the parameters passed to the constructor.
 
 void
-MySqlLeaseMgr::openDatabase() {
+MySqlLeaseMgr::openDatabase(MySqlConnection& conn) {
 
     // Set up the values of the parameters
     const char* host = "localhost";
@@ -1244,14 +1389,17 @@ MySqlLeaseMgr::openDatabase() {
 
     // Set options for the connection:
     //
-    // Automatic reconnection: after a period of inactivity, the client will
-    // disconnect from the database.  This option causes it to automatically
-    // reconnect when another operation is about to be done.
-    my_bool auto_reconnect = MLM_TRUE;
-    int result = mysql_options(mysql_, MYSQL_OPT_RECONNECT, &auto_reconnect);
+    // Automatic reconnection: it is disabled, because the prepared statements
+    // are lost when the client library reconnects.  Instead, the connection
+    // pool checks the connection after a failure or a period of inactivity
+    // and opens a new connection, with new prepared statements, if the
+    // server has gone away.
+    my_bool auto_reconnect = MLM_FALSE;
+    int result = mysql_options(conn.mysql_, MYSQL_OPT_RECONNECT,
+                               &auto_reconnect);
     if (result != 0) {
         isc_throw(DbOpenError, "unable to set auto-reconnect option: " <<
-                  mysql_error(mysql_));
+                  mysql_error(conn.mysql_));
     }
 
     // Set SQL mode options for the connection:  SQL mode governs how what
@@ -1259,10 +1407,10 @@ MySqlLeaseMgr::openDatabase() {
     // invalid data.  We want to ensure we get the strictest behavior and
     // to reject invalid data with an error.
     const char *sql_mode = "SET SESSION sql_mode ='STRICT_ALL_TABLES'";
-    result = mysql_options(mysql_, MYSQL_INIT_COMMAND, sql_mode);
+    result = mysql_options(conn.mysql_, MYSQL_INIT_COMMAND, sql_mode);
     if (result != 0) {
         isc_throw(DbOpenError, "unable to set SQL mode options: " <<
-                  mysql_error(mysql_));
+                  mysql_error(conn.mysql_));
     }
 
     // Open the database.
@@ -1275,58 +1423,54 @@ MySqlLeaseMgr::openDatabase() {
     // This makes it hard to distinguish whether the UPDATE changed no rows
     // because no row matching the WHERE clause was found, or because a
     // row was found but no data was altered.
-    MYSQL* status = mysql_real_connect(mysql_, host, user, password, name,
+    MYSQL* status = mysql_real_connect(conn.mysql_, host, user, password, name,
                                        0, NULL, CLIENT_FOUND_ROWS);
-    if (status != mysql_) {
-        isc_throw(DbOpenError, mysql_error(mysql_));
+    if (status != conn.mysql_) {
+        isc_throw(DbOpenError, mysql_error(conn.mysql_));
     }
 }
 
 // Prepared statement setup.  The textual form of an SQL statement is stored
 // in a vector of strings (text_statements_) and is used in the output of
 // error messages.  The SQL statement is also compiled into a "prepared
-// statement" (stored in statements_), which avoids the overhead of compilation
-// during use.  As prepared statements have resources allocated to them, the
-// class destructor explicitly destroys them.
+// statement" (stored in the statements_ of each connection), which avoids
+// the overhead of compilation during use.  As prepared statements have
+// resources allocated to them, the connection destructor explicitly destroys
+// them.
 
 void
-MySqlLeaseMgr::prepareStatement(StatementIndex index, const char* text) {
+MySqlLeaseMgr::prepareStatement(MySqlConnection& conn, StatementIndex index,
+                                const char* text) {
     // Validate that there is space for the statement in the statements array
     // and that nothing has been placed there before.
-    if ((index >= statements_.size()) || (statements_[index] != NULL)) {
+    if ((index >= conn.statements_.size()) ||
+        (conn.statements_[index] != NULL)) {
         isc_throw(InvalidParameter, "invalid prepared statement index (" <<
                   static_cast<int>(index) << ") or indexed prepared " <<
                   "statement is not null");
     }
 
     // All OK, so prepare the statement
-    text_statements_[index] = std::string(text);
-    statements_[index] = mysql_stmt_init(mysql_);
-    if (statements_[index] == NULL) {
+    conn.statements_[index] = mysql_stmt_init(conn.mysql_);
+    if (conn.statements_[index] == NULL) {
         isc_throw(DbOperationError, "unable to allocate MySQL prepared "
-                  "statement structure, reason: " << mysql_error(mysql_));
+                  "statement structure, reason: " << mysql_error(conn.mysql_));
     }
 
-    int status = mysql_stmt_prepare(statements_[index], text, strlen(text));
+    int status = mysql_stmt_prepare(conn.statements_[index], text,
+                                    strlen(text));
     if (status != 0) {
         isc_throw(DbOperationError, "unable to prepare MySQL statement <" <<
-                  text << ">, reason: " << mysql_error(mysql_));
+                  text << ">, reason: " << mysql_error(conn.mysql_));
     }
 }
 
 
 void
-MySqlLeaseMgr::prepareStatements() {
-    // Allocate space for all statements
-    statements_.clear();
-    statements_.resize(NUM_STATEMENTS, NULL);
-
-    text_statements_.clear();
-    text_statements_.resize(NUM_STATEMENTS, std::string(""));
-
+MySqlLeaseMgr::prepareStatements(MySqlConnection& conn) {
     // Created the MySQL prepared statements for each DML statement.
     for (int i = 0; tagged_statements[i].text != NULL; ++i) {
-        prepareStatement(tagged_statements[i].index,
+        prepareStatement(conn, tagged_statements[i].index,
                          tagged_statements[i].text);
     }
 }
@@ -1336,24 +1480,24 @@ MySqlLeaseMgr::prepareStatements() {
 // statement, then call common code to execute the statement.
 
 bool
-MySqlLeaseMgr::addLeaseCommon(StatementIndex stindex,
+MySqlLeaseMgr::addLeaseCommon(MySqlConnection& conn, StatementIndex stindex,
                               std::vector<MYSQL_BIND>& bind) {
 
     // Bind the parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], &bind[0]);
-    checkError(status, stindex, "unable to bind parameters");
+    int status = mysql_stmt_bind_param(conn.statements_[stindex], &bind[0]);
+    checkError(conn, status, stindex, "unable to bind parameters");
 
     // Execute the statement
-    status = mysql_stmt_execute(statements_[stindex]);
+    status = mysql_stmt_execute(conn.statements_[stindex]);
     if (status != 0) {
 
         // Failure: check for the special case of duplicate entry.  If this is
         // the case, we return false to indicate that the row was not added.
         // Otherwise we throw an exception.
-        if (mysql_errno(mysql_) == ER_DUP_ENTRY) {
+        if (mysql_errno(conn.mysql_) == ER_DUP_ENTRY) {
             return (false);
         }
-        checkError(status, stindex, "unable to execute");
+        checkError(conn, status, stindex, "unable to execute");
     }
 
     // Insert succeeded
@@ -1362,27 +1506,39 @@ MySqlLeaseMgr::addLeaseCommon(StatementIndex stindex,
 
 bool
 MySqlLeaseMgr::addLease(const Lease4Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+    return (addLease(*conn, lease));
+}
+
+bool
+MySqlLeaseMgr::addLease(MySqlConnection& conn, const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_ADD_ADDR4).arg(lease->addr_.toText());
 
     // Create the MYSQL_BIND array for the lease
-    std::vector<MYSQL_BIND> bind = exchange4_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind = conn.exchange4_->createBindForSend(lease);
 
     // ... and drop to common code.
-    return (addLeaseCommon(INSERT_LEASE4, bind));
+    return (addLeaseCommon(conn, INSERT_LEASE4, bind));
 }
 
 bool
 MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+    return (addLease(*conn, lease));
+}
+
+bool
+MySqlLeaseMgr::addLease(MySqlConnection& conn, const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_ADD_ADDR6).arg(lease->addr_.toText())
               .arg(lease->type_);
 
     // Create the MYSQL_BIND array for the lease
-    std::vector<MYSQL_BIND> bind = exchange6_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind = conn.exchange6_->createBindForSend(lease);
 
     // ... and drop to common code.
-    return (addLeaseCommon(INSERT_LEASE6, bind));
+    return (addLeaseCommon(conn, INSERT_LEASE6, bind));
 }
 
 // Extraction of leases from the database.
@@ -1400,10 +1556,9 @@ MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
 // objects,  so the code is templated.
 //
 // Methods that require a collection of objects access this method through
-// two interface methods (also called getLeaseCollection()).  These are
-// short enough as to be defined in the header file: all they do is to supply
-// the appropriate MySqlLeaseXExchange object depending on the type of the
-// LeaseCollection objects passed to them.
+// two interface methods (also called getLeaseCollection()).  All they do is
+// to supply the appropriate MySqlLeaseXExchange object of the connection
+// depending on the type of the LeaseCollection objects passed to them.
 //
 // Methods that require a single object to be returned access the method
 // through two interface methods (called getLease()).  As well as supplying
@@ -1411,37 +1566,38 @@ MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
 // holding zero or one leases into an appropriate Lease object.
 
 template <typename Exchange, typename LeaseCollection>
-void MySqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
+void MySqlLeaseMgr::getLeaseCollection(MySqlConnection& conn,
+                                       StatementIndex stindex,
                                        MYSQL_BIND* bind,
                                        Exchange& exchange,
                                        LeaseCollection& result,
                                        bool single) const {
 
     // Bind the selection parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], bind);
-    checkError(status, stindex, "unable to bind WHERE clause parameter");
+    int status = mysql_stmt_bind_param(conn.statements_[stindex], bind);
+    checkError(conn, status, stindex, "unable to bind WHERE clause parameter");
 
     // Set up the MYSQL_BIND array for the data being returned and bind it to
     // the statement.
     std::vector<MYSQL_BIND> outbind = exchange->createBindForReceive();
-    status = mysql_stmt_bind_result(statements_[stindex], &outbind[0]);
-    checkError(status, stindex, "unable to bind SELECT clause parameters");
+    status = mysql_stmt_bind_result(conn.statements_[stindex], &outbind[0]);
+    checkError(conn, status, stindex, "unable to bind SELECT clause parameters");
 
     // Execute the statement
-    status = mysql_stmt_execute(statements_[stindex]);
-    checkError(status, stindex, "unable to execute");
+    status = mysql_stmt_execute(conn.statements_[stindex]);
+    checkError(conn, status, stindex, "unable to execute");
 
     // Ensure that all the lease information is retrieved in one go to avoid
     // overhead of going back and forth between client and server.
-    status = mysql_stmt_store_result(statements_[stindex]);
-    checkError(status, stindex, "unable to set up for storing all results");
+    status = mysql_stmt_store_result(conn.statements_[stindex]);
+    checkError(conn, status, stindex, "unable to set up for storing all results");
 
     // Set up the fetch "release" object to release resources associated
     // with the call to mysql_stmt_fetch when this method exits, then
     // retrieve the data.
-    MySqlFreeResult fetch_release(statements_[stindex]);
+    MySqlFreeResult fetch_release(conn.statements_[stindex]);
     int count = 0;
-    while ((status = mysql_stmt_fetch(statements_[stindex])) == 0) {
+    while ((status = mysql_stmt_fetch(conn.statements_[stindex])) == 0) {
         try {
             result.push_back(exchange->getLeaseData());
 
@@ -1461,7 +1617,7 @@ void MySqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
     // How did the fetch end?
     if (status == 1) {
         // Error - unable to fetch results
-        checkError(status, stindex, "unable to fetch results");
+        checkError(conn, status, stindex, "unable to fetch results");
     } else if (status == MYSQL_DATA_TRUNCATED) {
         // Data truncated - throw an exception indicating what was at fault
         isc_throw(DataTruncated, text_statements_[stindex]
@@ -1470,16 +1626,30 @@ void MySqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
     }
 }
 
+void MySqlLeaseMgr::getLeaseCollection(MySqlConnection& conn,
+                                       StatementIndex stindex,
+                                       MYSQL_BIND* bind,
+                                       Lease4Collection& result) const {
+    getLeaseCollection(conn, stindex, bind, conn.exchange4_, result);
+}
+
+void MySqlLeaseMgr::getLeaseCollection(MySqlConnection& conn,
+                                       StatementIndex stindex,
+                                       MYSQL_BIND* bind,
+                                       Lease6Collection& result) const {
+    getLeaseCollection(conn, stindex, bind, conn.exchange6_, result);
+}
 
-void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
-                             Lease4Ptr& result) const {
+void MySqlLeaseMgr::getLease(MySqlConnection& conn, StatementIndex stindex,
+                             MYSQL_BIND* bind, Lease4Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" paraeter is true to indicate
     // that the called method should throw an exception if multiple
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease4Collection collection;
-    getLeaseCollection(stindex, bind, exchange4_, collection, true);
+    getLeaseCollection(conn, stindex, bind, conn.exchange4_, collection,
+                       true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -1490,15 +1660,16 @@ void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
 }
 
 
-void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
-                             Lease6Ptr& result) const {
+void MySqlLeaseMgr::getLease(MySqlConnection& conn, StatementIndex stindex,
+                             MYSQL_BIND* bind, Lease6Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" paraeter is true to indicate
     // that the called method should throw an exception if multiple
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease6Collection collection;
-    getLeaseCollection(stindex, bind, exchange6_, collection, true);
+    getLeaseCollection(conn, stindex, bind, conn.exchange6_, collection,
+                       true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -1514,6 +1685,13 @@ void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
 
 Lease4Ptr
 MySqlLeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
+    ConnectionPool::Locker conn(*pool_);
+    return (getLease4(*conn, addr));
+}
+
+Lease4Ptr
+MySqlLeaseMgr::getLease4(MySqlConnection& conn,
+                         const isc::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_ADDR4).arg(addr.toText());
 
@@ -1528,7 +1706,7 @@ MySqlLeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_ADDR, inbind, result);
+    getLease(conn, GET_LEASE4_ADDR, inbind, result);
 
     return (result);
 }
@@ -1536,6 +1714,8 @@ MySqlLeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
 
 Lease4Collection
 MySqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_HWADDR).arg(hwaddr.toText());
 
@@ -1558,7 +1738,7 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_HWADDR, inbind, result);
+    getLeaseCollection(*conn, GET_LEASE4_HWADDR, inbind, result);
 
     return (result);
 }
@@ -1566,6 +1746,13 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
 Lease4Ptr
 MySqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+    return (getLease4(*conn, hwaddr, subnet_id));
+}
+
+Lease4Ptr
+MySqlLeaseMgr::getLease4(MySqlConnection& conn,
+                         const HWAddr& hwaddr, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_SUBID_HWADDR)
         .arg(subnet_id).arg(hwaddr.toText());
@@ -1593,7 +1780,7 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_HWADDR_SUBID, inbind, result);
+    getLease(conn, GET_LEASE4_HWADDR_SUBID, inbind, result);
 
     return (result);
 }
@@ -1601,6 +1788,8 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
 
 Lease4Collection
 MySqlLeaseMgr::getLease4(const ClientId& clientid) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_CLIENTID).arg(clientid.toText());
 
@@ -1617,7 +1806,7 @@ MySqlLeaseMgr::getLease4(const ClientId& clientid) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_CLIENTID, inbind, result);
+    getLeaseCollection(*conn, GET_LEASE4_CLIENTID, inbind, result);
 
     return (result);
 }
@@ -1634,6 +1823,13 @@ MySqlLeaseMgr::getLease4(const ClientId&, const HWAddr&, SubnetID) const {
 
 Lease4Ptr
 MySqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+    return (getLease4(*conn, clientid, subnet_id));
+}
+
+Lease4Ptr
+MySqlLeaseMgr::getLease4(MySqlConnection& conn,
+                         const ClientId& clientid, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_SUBID_CLIENTID)
               .arg(subnet_id).arg(clientid.toText());
@@ -1655,7 +1851,29 @@ MySqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_CLIENTID_SUBID, inbind, result);
+    getLease(conn, GET_LEASE4_CLIENTID_SUBID, inbind, result);
+
+    return (result);
+}
+
+Lease4Collection
+MySqlLeaseMgr::getLeases4(SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_SUBID4).arg(subnet_id);
+
+    // Set up the WHERE clause value
+    MYSQL_BIND inbind[1];
+    memset(inbind, 0, sizeof(inbind));
+
+    inbind[0].buffer_type = MYSQL_TYPE_LONG;
+    inbind[0].buffer = reinterpret_cast<char*>(&subnet_id);
+    inbind[0].is_unsigned = MLM_TRUE;
+
+    // ... and get the data
+    Lease4Collection result;
+    getLeaseCollection(*conn, GET_LEASE4_SUBID, inbind, result);
 
     return (result);
 }
@@ -1664,6 +1882,13 @@ MySqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
 Lease6Ptr
 MySqlLeaseMgr::getLease6(Lease::Type lease_type,
                          const isc::asiolink::IOAddress& addr) const {
+    ConnectionPool::Locker conn(*pool_);
+    return (getLease6(*conn, lease_type, addr));
+}
+
+Lease6Ptr
+MySqlLeaseMgr::getLease6(MySqlConnection& conn, Lease::Type lease_type,
+                         const isc::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_ADDR6).arg(addr.toText())
               .arg(lease_type);
@@ -1688,7 +1913,7 @@ MySqlLeaseMgr::getLease6(Lease::Type lease_type,
     inbind[1].is_unsigned = MLM_TRUE;
 
     Lease6Ptr result;
-    getLease(GET_LEASE6_ADDR, inbind, result);
+    getLease(conn, GET_LEASE6_ADDR, inbind, result);
 
     return (result);
 }
@@ -1697,6 +1922,8 @@ MySqlLeaseMgr::getLease6(Lease::Type lease_type,
 Lease6Collection
 MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
                           const DUID& duid, uint32_t iaid) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_IAID_DUID).arg(iaid).arg(duid.toText())
               .arg(lease_type);
@@ -1737,7 +1964,7 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID, inbind, result);
+    getLeaseCollection(*conn, GET_LEASE6_DUID_IAID, inbind, result);
 
     return (result);
 }
@@ -1746,6 +1973,8 @@ Lease6Collection
 MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
                           const DUID& duid, uint32_t iaid,
                           SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText())
@@ -1782,31 +2011,109 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID_SUBID, inbind, result);
+    getLeaseCollection(*conn, GET_LEASE6_DUID_IAID_SUBID, inbind, result);
+
+    return (result);
+}
+
+Lease6Collection
+MySqlLeaseMgr::getLeases6(SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_SUBID6).arg(subnet_id);
+
+    // Set up the WHERE clause value
+    MYSQL_BIND inbind[1];
+    memset(inbind, 0, sizeof(inbind));
+
+    inbind[0].buffer_type = MYSQL_TYPE_LONG;
+    inbind[0].buffer = reinterpret_cast<char*>(&subnet_id);
+    inbind[0].is_unsigned = MLM_TRUE;
+
+    // ... and get the data
+    Lease6Collection result;
+    getLeaseCollection(*conn, GET_LEASE6_SUBID, inbind, result);
 
     return (result);
 }
 
+template <typename LeaseCollection>
+void
+MySqlLeaseMgr::getExpiredLeasesCommon(MySqlConnection& conn,
+                                      StatementIndex stindex,
+                                      const size_t max_leases,
+                                      LeaseCollection& expired_leases) const {
+    // Set up the WHERE clause value
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+
+    // The leases which expired before the current time are selected.
+    MYSQL_TIME expire;
+    convertToDatabaseTime(time(NULL), 0, expire);
+    inbind[0].buffer_type = MYSQL_TYPE_TIMESTAMP;
+    inbind[0].buffer = reinterpret_cast<char*>(&expire);
+    inbind[0].buffer_length = sizeof(expire);
+
+    // The MySQL LIMIT clause requires a value, so the highest possible
+    // value is used when the number of leases is not limited.
+    uint32_t limit = ((max_leases == 0) ||
+                      (max_leases > std::numeric_limits<uint32_t>::max()) ?
+                      std::numeric_limits<uint32_t>::max() :
+                      static_cast<uint32_t>(max_leases));
+    inbind[1].buffer_type = MYSQL_TYPE_LONG;
+    inbind[1].buffer = reinterpret_cast<char*>(&limit);
+    inbind[1].is_unsigned = MLM_TRUE;
+
+    // ... and get the data
+    getLeaseCollection(conn, stindex, inbind, expired_leases);
+}
+
+void
+MySqlLeaseMgr::getExpiredLeases4(Lease4Collection& expired_leases,
+                                 const size_t max_leases) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED4).arg(max_leases);
+
+    getExpiredLeasesCommon(*conn, GET_LEASE4_EXPIRE, max_leases,
+                           expired_leases);
+}
+
+void
+MySqlLeaseMgr::getExpiredLeases6(Lease6Collection& expired_leases,
+                                 const size_t max_leases) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED6).arg(max_leases);
+
+    getExpiredLeasesCommon(*conn, GET_LEASE6_EXPIRE, max_leases,
+                           expired_leases);
+}
+
 // Update lease methods.  These comprise common code that handles the actual
 // update, and type-specific methods that set up the parameters for the prepared
 // statement depending on the type of lease.
 
 template <typename LeasePtr>
 void
-MySqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind,
+MySqlLeaseMgr::updateLeaseCommon(MySqlConnection& conn,
+                                 StatementIndex stindex, MYSQL_BIND* bind,
                                  const LeasePtr& lease) {
 
     // Bind the parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], bind);
-    checkError(status, stindex, "unable to bind parameters");
+    int status = mysql_stmt_bind_param(conn.statements_[stindex], bind);
+    checkError(conn, status, stindex, "unable to bind parameters");
 
     // Execute
-    status = mysql_stmt_execute(statements_[stindex]);
-    checkError(status, stindex, "unable to execute");
+    status = mysql_stmt_execute(conn.statements_[stindex]);
+    checkError(conn, status, stindex, "unable to execute");
 
     // See how many rows were affected.  The statement should only update a
     // single row.
-    int affected_rows = mysql_stmt_affected_rows(statements_[stindex]);
+    int affected_rows = mysql_stmt_affected_rows(conn.statements_[stindex]);
     if (affected_rows == 0) {
         isc_throw(NoSuchLease, "unable to update lease for address " <<
                   lease->addr_ << " as it does not exist");
@@ -1821,13 +2128,19 @@ MySqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind,
 
 void
 MySqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+    updateLease4(*conn, lease);
+}
+
+void
+MySqlLeaseMgr::updateLease4(MySqlConnection& conn, const Lease4Ptr& lease) {
     const StatementIndex stindex = UPDATE_LEASE4;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_UPDATE_ADDR4).arg(lease->addr_.toText());
 
     // Create the MYSQL_BIND array for the data being updated
-    std::vector<MYSQL_BIND> bind = exchange4_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind = conn.exchange4_->createBindForSend(lease);
 
     // Set up the WHERE clause and append it to the MYSQL_BIND array
     MYSQL_BIND where;
@@ -1840,12 +2153,18 @@ MySqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
     bind.push_back(where);
 
     // Drop to common update code
-    updateLeaseCommon(stindex, &bind[0], lease);
+    updateLeaseCommon(conn, stindex, &bind[0], lease);
 }
 
 
 void
 MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+    updateLease6(*conn, lease);
+}
+
+void
+MySqlLeaseMgr::updateLease6(MySqlConnection& conn, const Lease6Ptr& lease) {
     const StatementIndex stindex = UPDATE_LEASE6;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1853,7 +2172,7 @@ MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
               .arg(lease->type_);
 
     // Create the MYSQL_BIND array for the data being updated
-    std::vector<MYSQL_BIND> bind = exchange6_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind = conn.exchange6_->createBindForSend(lease);
 
     // Set up the WHERE clause value
     MYSQL_BIND where;
@@ -1871,7 +2190,7 @@ MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
     bind.push_back(where);
 
     // Drop to common update code
-    updateLeaseCommon(stindex, &bind[0], lease);
+    updateLeaseCommon(conn, stindex, &bind[0], lease);
 }
 
 // Delete lease methods.  Similar to other groups of methods, these comprise
@@ -1880,24 +2199,32 @@ MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
 // handles the common processing.
 
 bool
-MySqlLeaseMgr::deleteLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind) {
+MySqlLeaseMgr::deleteLeaseCommon(MySqlConnection& conn,
+                                 StatementIndex stindex, MYSQL_BIND* bind) {
 
     // Bind the input parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], bind);
-    checkError(status, stindex, "unable to bind WHERE clause parameter");
+    int status = mysql_stmt_bind_param(conn.statements_[stindex], bind);
+    checkError(conn, status, stindex, "unable to bind WHERE clause parameter");
 
     // Execute
-    status = mysql_stmt_execute(statements_[stindex]);
-    checkError(status, stindex, "unable to execute");
+    status = mysql_stmt_execute(conn.statements_[stindex]);
+    checkError(conn, status, stindex, "unable to execute");
 
     // See how many rows were affected.  Note that the statement may delete
     // multiple rows.
-    return (mysql_stmt_affected_rows(statements_[stindex]) > 0);
+    return (mysql_stmt_affected_rows(conn.statements_[stindex]) > 0);
 }
 
 
 bool
 MySqlLeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
+    ConnectionPool::Locker conn(*pool_);
+    return (deleteLease(*conn, addr));
+}
+
+bool
+MySqlLeaseMgr::deleteLease(MySqlConnection& conn,
+                           const isc::asiolink::IOAddress& addr) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_DELETE_ADDR).arg(addr.toText());
 
@@ -1912,7 +2239,49 @@ MySqlLeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
         inbind[0].buffer = reinterpret_cast<char*>(&addr4);
         inbind[0].is_unsigned = MLM_TRUE;
 
-        return (deleteLeaseCommon(DELETE_LEASE4, inbind));
+        return (deleteLeaseCommon(conn, DELETE_LEASE4, inbind));
+
+    } else {
+        std::string addr6 = addr.toText();
+        unsigned long addr6_length = addr6.size();
+
+        // See the earlier description of the use of "const_cast" when accessing
+        // the address for an explanation of the reason.
+        inbind[0].buffer_type = MYSQL_TYPE_STRING;
+        inbind[0].buffer = const_cast<char*>(addr6.c_str());
+        inbind[0].buffer_length = addr6_length;
+        inbind[0].length = &addr6_length;
+
+        return (deleteLeaseCommon(conn, DELETE_LEASE6, inbind));
+    }
+}
+
+bool
+MySqlLeaseMgr::deleteExpiredLease(const isc::asiolink::IOAddress& addr) {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_DELETE_EXPIRED_ADDR).arg(addr.toText());
+
+    // Set up the WHERE clause values
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+
+    // The lease is only deleted if it expired before the current time.
+    MYSQL_TIME expire;
+    convertToDatabaseTime(time(NULL), 0, expire);
+    inbind[1].buffer_type = MYSQL_TYPE_TIMESTAMP;
+    inbind[1].buffer = reinterpret_cast<char*>(&expire);
+    inbind[1].buffer_length = sizeof(expire);
+
+    if (addr.isV4()) {
+        uint32_t addr4 = static_cast<uint32_t>(addr);
+
+        inbind[0].buffer_type = MYSQL_TYPE_LONG;
+        inbind[0].buffer = reinterpret_cast<char*>(&addr4);
+        inbind[0].is_unsigned = MLM_TRUE;
+
+        return (deleteLeaseCommon(*conn, DELETE_EXPIRED_LEASE4, inbind));
 
     } else {
         std::string addr6 = addr.toText();
@@ -1925,7 +2294,7 @@ MySqlLeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
         inbind[0].buffer_length = addr6_length;
         inbind[0].length = &addr6_length;
 
-        return (deleteLeaseCommon(DELETE_LEASE6, inbind));
+        return (deleteLeaseCommon(*conn, DELETE_EXPIRED_LEASE6, inbind));
     }
 }
 
@@ -1951,6 +2320,8 @@ MySqlLeaseMgr::getDescription() const {
 
 std::pair<uint32_t, uint32_t>
 MySqlLeaseMgr::getVersion() const {
+    ConnectionPool::Locker conn(*pool_);
+
     const StatementIndex stindex = GET_VERSION;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1960,11 +2331,11 @@ MySqlLeaseMgr::getVersion() const {
     uint32_t    minor;      // Minor version number
 
     // Execute the prepared statement
-    int status = mysql_stmt_execute(statements_[stindex]);
+    int status = mysql_stmt_execute(conn->statements_[stindex]);
     if (status != 0) {
         isc_throw(DbOperationError, "unable to execute <"
                   << text_statements_[stindex] << "> - reason: " <<
-                  mysql_error(mysql_));
+                  mysql_error(conn->mysql_));
     }
 
     // Bind the output of the statement to the appropriate variables.
@@ -1981,19 +2352,19 @@ MySqlLeaseMgr::getVersion() const {
     bind[1].buffer = &minor;
     bind[1].buffer_length = sizeof(minor);
 
-    status = mysql_stmt_bind_result(statements_[stindex], bind);
+    status = mysql_stmt_bind_result(conn->statements_[stindex], bind);
     if (status != 0) {
         isc_throw(DbOperationError, "unable to bind result set: " <<
-                  mysql_error(mysql_));
+                  mysql_error(conn->mysql_));
     }
 
     // Fetch the data and set up the "release" object to release associated
     // resources when this method exits then retrieve the data.
-    MySqlFreeResult fetch_release(statements_[stindex]);
-    status = mysql_stmt_fetch(statements_[stindex]);
+    MySqlFreeResult fetch_release(conn->statements_[stindex]);
+    status = mysql_stmt_fetch(conn->statements_[stindex]);
     if (status != 0) {
         isc_throw(DbOperationError, "unable to obtain result set: " <<
-                  mysql_error(mysql_));
+                  mysql_error(conn->mysql_));
     }
 
     return (std::make_pair(major, minor));
@@ -2002,18 +2373,340 @@ MySqlLeaseMgr::getVersion() const {
 
 void
 MySqlLeaseMgr::commit() {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MYSQL_COMMIT);
-    if (mysql_commit(mysql_) != 0) {
-        isc_throw(DbOperationError, "commit failed: " << mysql_error(mysql_));
+    if (mysql_commit(conn->mysql_) != 0) {
+        isc_throw(DbOperationError, "commit failed: " << mysql_error(conn->mysql_));
     }
 }
 
 
 void
 MySqlLeaseMgr::rollback() {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MYSQL_ROLLBACK);
-    if (mysql_rollback(mysql_) != 0) {
-        isc_throw(DbOperationError, "rollback failed: " << mysql_error(mysql_));
+    if (mysql_rollback(conn->mysql_) != 0) {
+        isc_throw(DbOperationError, "rollback failed: " << mysql_error(conn->mysql_));
+    }
+}
+
+// Asynchronous operations and the group commit.
+
+void
+MySqlLeaseMgr::asyncGetLease4(const isc::asiolink::IOAddress& addr,
+                              const Lease4Callback& callback) {
+    AsyncOperation operation(AsyncOperation::GET_LEASE4_ADDR);
+    operation.addr_ = addr;
+    operation.lease4_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                              const Lease4Callback& callback) {
+    AsyncOperation operation(AsyncOperation::GET_LEASE4_HWADDR);
+    operation.hwaddr_.reset(new HWAddr(hwaddr));
+    operation.subnet_id_ = subnet_id;
+    operation.lease4_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                              const Lease4Callback& callback) {
+    AsyncOperation operation(AsyncOperation::GET_LEASE4_CLIENTID);
+    operation.clientid_.reset(new ClientId(clientid.getClientId()));
+    operation.subnet_id_ = subnet_id;
+    operation.lease4_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncGetLease6(Lease::Type type,
+                              const isc::asiolink::IOAddress& addr,
+                              const Lease6Callback& callback) {
+    AsyncOperation operation(AsyncOperation::GET_LEASE6_ADDR);
+    operation.lease_type_ = type;
+    operation.addr_ = addr;
+    operation.lease6_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncAddLease(const Lease4Ptr& lease,
+                             const ResultCallback& callback) {
+    AsyncOperation operation(AsyncOperation::ADD_LEASE);
+    operation.lease4_ = lease;
+    operation.result_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncAddLease(const Lease6Ptr& lease,
+                             const ResultCallback& callback) {
+    AsyncOperation operation(AsyncOperation::ADD_LEASE);
+    operation.lease6_ = lease;
+    operation.result_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncUpdateLease4(const Lease4Ptr& lease4,
+                                 const ResultCallback& callback) {
+    AsyncOperation operation(AsyncOperation::UPDATE_LEASE);
+    operation.lease4_ = lease4;
+    operation.result_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncUpdateLease6(const Lease6Ptr& lease6,
+                                 const ResultCallback& callback) {
+    AsyncOperation operation(AsyncOperation::UPDATE_LEASE);
+    operation.lease6_ = lease6;
+    operation.result_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+void
+MySqlLeaseMgr::asyncDeleteLease(const isc::asiolink::IOAddress& addr,
+                                const ResultCallback& callback) {
+    AsyncOperation operation(AsyncOperation::DELETE_LEASE);
+    operation.addr_ = addr;
+    operation.result_callback_ = callback;
+    startAsyncOperation(operation);
+}
+
+int
+MySqlLeaseMgr::getAsyncSocket() {
+    return (commit_ready_ ? commit_ready_->getSelectFd() : -1);
+}
+
+void
+MySqlLeaseMgr::startAsyncOperation(const AsyncOperation& operation) {
+    if (group_commit_size_ == 0) {
+        AsyncOperation completed(operation);
+        {
+            ConnectionPool::Locker conn(*pool_);
+            executeOperation(*conn, completed);
+        }
+        invokeCallback(completed);
+        return;
+    }
+
+    Mutex::Locker lock(group_commit_mutex_);
+    queued_operations_.push_back(operation);
+    ++async_pending_;
+    group_commit_cond_.signal();
+}
+
+void
+MySqlLeaseMgr::processAsyncResults() {
+    if (!commit_ready_) {
+        return;
+    }
+
+    AsyncOperations completed;
+    {
+        Mutex::Locker lock(group_commit_mutex_);
+        completed.swap(committed_operations_);
+        commit_ready_->clearReady();
+    }
+    async_pending_ -= completed.size();
+    for (AsyncOperations::const_iterator operation = completed.begin();
+         operation != completed.end(); ++operation) {
+        invokeCallback(*operation);
+    }
+}
+
+void
+MySqlLeaseMgr::runGroupCommit() {
+    // Signals are handled by the main thread of the server.
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    for (;;) {
+        AsyncOperations operations;
+        {
+            Mutex::Locker lock(group_commit_mutex_);
+            while (queued_operations_.empty() && !stop_group_commit_) {
+                group_commit_cond_.wait(group_commit_mutex_);
+            }
+            if (queued_operations_.empty()) {
+                return;
+            }
+
+            // Wait for more operations, unless the transaction is full.
+            const ptime start = microsec_clock::universal_time();
+            while (!stop_group_commit_ &&
+                   (queued_operations_.size() < group_commit_size_)) {
+                const int64_t elapsed = (microsec_clock::universal_time() -
+                                         start).total_milliseconds();
+                if (elapsed >= static_cast<int64_t>(group_commit_delay_)) {
+                    break;
+                }
+                group_commit_cond_.timedWait(group_commit_mutex_,
+                                             group_commit_delay_ - elapsed);
+            }
+
+            const size_t count = std::min(queued_operations_.size(),
+                                          group_commit_size_);
+            operations.assign(queued_operations_.begin(),
+                              queued_operations_.begin() + count);
+            queued_operations_.erase(queued_operations_.begin(),
+                                     queued_operations_.begin() + count);
+        }
+
+        commitOperations(operations);
+
+        Mutex::Locker lock(group_commit_mutex_);
+        committed_operations_.insert(committed_operations_.end(),
+                                     operations.begin(), operations.end());
+        try {
+            commit_ready_->markReady();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_MYSQL_GROUP_COMMIT_FAILED)
+                .arg(operations.size()).arg(ex.what());
+        }
+    }
+}
+
+void
+MySqlLeaseMgr::commitOperations(AsyncOperations& operations) {
+    try {
+        ConnectionPool::Locker conn(*pool_);
+        if (!executeTransaction(*conn, operations)) {
+            // One of the operations has failed, which may have aborted the
+            // whole transaction, e.g. on a deadlock.  Execute them one by
+            // one in the autocommit mode to find out which ones succeed.
+            for (AsyncOperations::iterator operation = operations.begin();
+                 operation != operations.end(); ++operation) {
+                executeOperation(*conn, *operation);
+            }
+        }
+
+    } catch (const std::exception& ex) {
+        // The connection is checked before it is used again, as the
+        // exception passed through the locker.
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MYSQL_GROUP_COMMIT_FAILED)
+            .arg(operations.size()).arg(ex.what());
+        for (AsyncOperations::iterator operation = operations.begin();
+             operation != operations.end(); ++operation) {
+            operation->lease4_.reset();
+            operation->lease6_.reset();
+            operation->result_ = false;
+            operation->error_ = ex.what();
+        }
+    }
+}
+
+bool
+MySqlLeaseMgr::executeTransaction(MySqlConnection& conn,
+                                  AsyncOperations& operations) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GROUP_COMMIT).arg(operations.size());
+
+    if (mysql_query(conn.mysql_, "START TRANSACTION") != 0) {
+        isc_throw(DbOperationError, "unable to start transaction: "
+                  << mysql_error(conn.mysql_));
+    }
+
+    for (AsyncOperations::iterator operation = operations.begin();
+         operation != operations.end(); ++operation) {
+        if (!executeOperation(conn, *operation)) {
+            if (mysql_rollback(conn.mysql_) != 0) {
+                isc_throw(DbOperationError, "rollback failed: "
+                          << mysql_error(conn.mysql_));
+            }
+            return (false);
+        }
+    }
+
+    if (mysql_commit(conn.mysql_) != 0) {
+        isc_throw(DbOperationError, "commit failed: "
+                  << mysql_error(conn.mysql_));
+    }
+    return (true);
+}
+
+bool
+MySqlLeaseMgr::executeOperation(MySqlConnection& conn,
+                                AsyncOperation& operation) {
+    operation.result_ = false;
+    operation.error_.clear();
+    try {
+        switch (operation.type_) {
+        case AsyncOperation::GET_LEASE4_ADDR:
+            operation.lease4_ = getLease4(conn, operation.addr_);
+            break;
+
+        case AsyncOperation::GET_LEASE4_HWADDR:
+            operation.lease4_ = getLease4(conn, *operation.hwaddr_,
+                                          operation.subnet_id_);
+            break;
+
+        case AsyncOperation::GET_LEASE4_CLIENTID:
+            operation.lease4_ = getLease4(conn, *operation.clientid_,
+                                          operation.subnet_id_);
+            break;
+
+        case AsyncOperation::GET_LEASE6_ADDR:
+            operation.lease6_ = getLease6(conn, operation.lease_type_,
+                                          operation.addr_);
+            break;
+
+        case AsyncOperation::ADD_LEASE:
+            operation.result_ = (operation.lease4_ ?
+                                 addLease(conn, operation.lease4_) :
+                                 addLease(conn, operation.lease6_));
+            break;
+
+        case AsyncOperation::UPDATE_LEASE:
+            if (operation.lease4_) {
+                updateLease4(conn, operation.lease4_);
+            } else {
+                updateLease6(conn, operation.lease6_);
+            }
+            operation.result_ = true;
+            break;
+
+        case AsyncOperation::DELETE_LEASE:
+            operation.result_ = deleteLease(conn, operation.addr_);
+            break;
+        }
+
+    } catch (const NoSuchLease&) {
+        // Not an error: the result is false.
+
+    } catch (const std::exception& ex) {
+        operation.error_ = ex.what();
+        return (false);
+    }
+    return (true);
+}
+
+void
+MySqlLeaseMgr::invokeCallback(const AsyncOperation& operation) {
+    switch (operation.type_) {
+    case AsyncOperation::GET_LEASE4_ADDR:
+    case AsyncOperation::GET_LEASE4_HWADDR:
+    case AsyncOperation::GET_LEASE4_CLIENTID:
+        operation.lease4_callback_(operation.error_.empty() ?
+                                   operation.lease4_ : Lease4Ptr(),
+                                   operation.error_);
+        break;
+
+    case AsyncOperation::GET_LEASE6_ADDR:
+        operation.lease6_callback_(operation.error_.empty() ?
+                                   operation.lease6_ : Lease6Ptr(),
+                                   operation.error_);
+        break;
+
+    default:
+        operation.result_callback_(operation.result_, operation.error_);
     }
 }
 
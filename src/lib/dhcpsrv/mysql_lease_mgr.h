@@ -16,12 +16,19 @@
 #define MYSQL_LEASE_MGR_H
 
 #include <dhcp/hwaddr.h>
+#include <dhcp_ddns/watch_socket.h>
+#include <dhcpsrv/db_connection_pool.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
 #include <mysql.h>
 
+#include <string>
+#include <vector>
 #include <time.h>
 
 namespace isc {
@@ -32,7 +39,8 @@ namespace dhcp {
 /// Small RAII object for safer initialization, will close the database
 /// connection upon destruction.  This means that if an exception is thrown
 /// during database initialization, resources allocated to the database are
-/// guaranteed to be freed.
+/// guaranteed to be freed.  The MySQL library is not released, as other
+/// connections may still be open.
 ///
 /// It makes no sense to copy an object of this class.  After the copy, both
 /// objects would contain pointers to the same MySql context object.  The
@@ -59,8 +67,6 @@ public:
         if (mysql_ != NULL) {
             mysql_close(mysql_);
         }
-        // The library itself shouldn't be needed anymore
-        mysql_library_end();
     }
 
     /// @brief Conversion Operator
@@ -86,6 +92,10 @@ const uint32_t CURRENT_VERSION_MINOR = 0;
 class MySqlLease4Exchange;
 class MySqlLease6Exchange;
 
+// Forward declaration of the database connection object, also defined in
+// the .cc file.
+class MySqlConnection;
+
 
 /// @brief MySQL Lease Manager
 ///
@@ -103,12 +113,23 @@ public:
     /// - host - Host to which to connect (optional, defaults to "localhost")
     /// - user - Username under which to connect (optional)
     /// - password - Password for "user" on the database (optional)
+    /// - connections - Number of connections to the database (optional,
+    ///   defaults to 1)
+    /// - group-commit-size - Maximum number of asynchronous lease operations
+    ///   committed in a single transaction (optional, defaults to 0, which
+    ///   disables the group commit)
+    /// - group-commit-delay - Time in milliseconds to wait for more
+    ///   asynchronous operations before committing a transaction which
+    ///   isn't full (optional, defaults to 0)
     ///
     /// If the database is successfully opened, the version number in the
     /// schema_version table will be checked against hard-coded value in
     /// the implementation file.
     ///
-    /// Finally, all the SQL commands are pre-compiled.
+    /// Finally, all the SQL commands are pre-compiled.  Each connection
+    /// has its own set of prepared statements, so as the lease operations
+    /// invoked by different threads can run concurrently, each on its own
+    /// connection.
     ///
     /// @param parameters A data structure relating keywords and values
     ///        concerned with the database.
@@ -251,6 +272,19 @@ public:
     virtual Lease4Ptr getLease4(const ClientId& clientid,
                                 SubnetID subnet_id) const;
 
+    /// @brief Returns all IPv4 leases belonging to a subnet.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    ///
+    /// @throw isc::dhcp::DataTruncation Data was truncated on retrieval to
+    ///        fit into the space allocated for the result.  This indicates a
+    ///        programming error.
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease4Collection getLeases4(SubnetID subnet_id) const;
+
     /// @brief Returns existing IPv6 lease for a given IPv6 address.
     ///
     /// For a given address, we assume that there will be only one lease.
@@ -314,6 +348,47 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns all IPv6 leases belonging to a subnet.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    ///
+    /// @throw isc::BadValue record retrieved from database had an invalid
+    ///        lease type field.
+    /// @throw isc::dhcp::DataTruncation Data was truncated on retrieval to
+    ///        fit into the space allocated for the result.  This indicates a
+    ///        programming error.
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease6Collection getLeases6(SubnetID subnet_id) const;
+
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are selected using the index on the "expire" column.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// Updates the record of the lease in the database (as identified by the
@@ -351,6 +426,18 @@ public:
     ///        failed.
     virtual bool deleteLease(const isc::asiolink::IOAddress& addr);
 
+    /// @brief Deletes a lease if it has expired.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    ///         or it has not expired.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual bool deleteExpiredLease(const isc::asiolink::IOAddress& addr);
+
     /// @brief Return backend type
     ///
     /// Returns the type of the backend (e.g. "mysql", "memfile" etc.)
@@ -388,6 +475,9 @@ public:
     /// Commits all pending database operations.  On databases that don't
     /// support transactions, this is a no-op.
     ///
+    /// The autocommit mode is enabled on all connections, so this is
+    /// issued on any connection of the pool.
+    ///
     /// @throw DbOperationError Iif the commit failed.
     virtual void commit();
 
@@ -396,9 +486,81 @@ public:
     /// Rolls back all pending database operations.  On databases that don't
     /// support transactions, this is a no-op.
     ///
+    /// The autocommit mode is enabled on all connections, so this is
+    /// issued on any connection of the pool.
+    ///
     /// @throw DbOperationError If the rollback failed.
     virtual void rollback();
 
+    /// @name Asynchronous lease operations with the group commit
+    ///
+    /// If the group commit is enabled, the asynchronous operations are
+    /// queued and executed by a background thread.  The thread runs the
+    /// queued operations in a single transaction, so as many lease writes
+    /// share the cost of flushing the transaction log to the disk.  The
+    /// transaction is committed when it holds "group-commit-size"
+    /// operations or when "group-commit-delay" milliseconds elapse after
+    /// the thread has picked up its first operation.  The operations
+    /// queued while a transaction is being committed go to the next one,
+    /// so the transactions grow with the load even without the delay.
+    ///
+    /// The callbacks are invoked by @c processAsyncResults after the
+    /// transaction has been committed, so as the server responds to the
+    /// clients only when their leases are durably stored.  If any of the
+    /// operations fails, the transaction is rolled back and the operations
+    /// are retried one by one, so as only the failing operation is reported.
+    ///
+    /// The lookups are queued with the writes to preserve the order of the
+    /// operations.  The changes made by the queued writes aren't visible to
+    /// the synchronous lookups until they are committed.
+    ///
+    /// If the group commit is disabled, the operations run synchronously
+    /// as in the @c LeaseMgr.
+    //@{
+
+    virtual void asyncGetLease4(const isc::asiolink::IOAddress& addr,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease6(Lease::Type type,
+                                const isc::asiolink::IOAddress& addr,
+                                const Lease6Callback& callback);
+
+    virtual void asyncAddLease(const Lease4Ptr& lease,
+                               const ResultCallback& callback);
+
+    virtual void asyncAddLease(const Lease6Ptr& lease,
+                               const ResultCallback& callback);
+
+    virtual void asyncUpdateLease4(const Lease4Ptr& lease4,
+                                   const ResultCallback& callback);
+
+    virtual void asyncUpdateLease6(const Lease6Ptr& lease6,
+                                   const ResultCallback& callback);
+
+    virtual void asyncDeleteLease(const isc::asiolink::IOAddress& addr,
+                                  const ResultCallback& callback);
+
+    /// @brief Returns the descriptor marked ready when a transaction has
+    /// been committed or -1 if the group commit is disabled.
+    virtual int getAsyncSocket();
+
+    /// @brief Invokes the callbacks of the committed operations.
+    virtual void processAsyncResults();
+
+    /// @brief Returns the number of the operations whose callbacks haven't
+    /// been invoked yet.
+    virtual size_t getAsyncPendingCount() const {
+        return (async_pending_);
+    }
+
+    //@}
+
     ///@{
     /// The following methods are used to convert between times and time
     /// intervals stored in the Lease object, and the times stored in the
@@ -455,14 +617,20 @@ public:
     enum StatementIndex {
         DELETE_LEASE4,              // Delete from lease4 by address
         DELETE_LEASE6,              // Delete from lease6 by address
+        DELETE_EXPIRED_LEASE4,      // Delete expired lease4 by address
+        DELETE_EXPIRED_LEASE6,      // Delete expired lease6 by address
         GET_LEASE4_ADDR,            // Get lease4 by address
         GET_LEASE4_CLIENTID,        // Get lease4 by client ID
         GET_LEASE4_CLIENTID_SUBID,  // Get lease4 by client ID & subnet ID
+        GET_LEASE4_EXPIRE,          // Get expired lease4
         GET_LEASE4_HWADDR,          // Get lease4 by HW address
         GET_LEASE4_HWADDR_SUBID,    // Get lease4 by HW address & subnet ID
+        GET_LEASE4_SUBID,           // Get lease4 by subnet ID
         GET_LEASE6_ADDR,            // Get lease6 by address
         GET_LEASE6_DUID_IAID,       // Get lease6 by DUID and IAID
         GET_LEASE6_DUID_IAID_SUBID, // Get lease6 by DUID, IAID and subnet ID
+        GET_LEASE6_EXPIRE,          // Get expired lease6
+        GET_LEASE6_SUBID,           // Get lease6 by subnet ID
         GET_VERSION,                // Obtain version number
         INSERT_LEASE4,              // Add entry to lease4 table
         INSERT_LEASE6,              // Add entry to lease6 table
@@ -472,11 +640,80 @@ public:
     };
 
 private:
+    /// @brief Pool of the connections to the database.
+    typedef DbConnectionPool<MySqlConnection> ConnectionPool;
+
+    /// @brief Asynchronous operation waiting for the group commit.
+    struct AsyncOperation {
+        /// @brief Type of the operation.
+        enum Type {
+            GET_LEASE4_ADDR,        // Get lease4 by address
+            GET_LEASE4_HWADDR,      // Get lease4 by HW address & subnet ID
+            GET_LEASE4_CLIENTID,    // Get lease4 by client ID & subnet ID
+            GET_LEASE6_ADDR,        // Get lease6 by address
+            ADD_LEASE,              // Add lease4 or lease6
+            UPDATE_LEASE,           // Update lease4 or lease6
+            DELETE_LEASE            // Delete lease by address
+        };
+
+        /// @brief Constructor.
+        ///
+        /// @param type Type of the operation.
+        explicit AsyncOperation(const Type type)
+            : type_(type), addr_("::"), subnet_id_(0),
+              lease_type_(Lease::TYPE_NA), result_(false) {
+        }
+
+        Type type_;                         ///< Type of the operation
+        isc::asiolink::IOAddress addr_;     ///< Address of the lease
+        HWAddrPtr hwaddr_;                  ///< Hardware address
+        ClientIdPtr clientid_;              ///< Client identifier
+        SubnetID subnet_id_;                ///< Subnet identifier
+        Lease::Type lease_type_;            ///< Type of the IPv6 lease
+
+        Lease4Ptr lease4_;                  ///< Written or returned lease4
+        Lease6Ptr lease6_;                  ///< Written or returned lease6
+        Lease4Callback lease4_callback_;    ///< Callback of lease4 lookup
+        Lease6Callback lease6_callback_;    ///< Callback of lease6 lookup
+        ResultCallback result_callback_;    ///< Callback of the write
+
+        bool result_;                       ///< Result of the write
+        std::string error_;                 ///< Error message
+    };
+
+    /// @brief Collection of the asynchronous operations.
+    typedef std::vector<AsyncOperation> AsyncOperations;
+
+    /// @brief Opens a new connection to the database
+    ///
+    /// Opens the database, enables the autocommit mode and prepares all
+    /// statements.  It is used by the connection pool to open the
+    /// connections, initially and after a connection has been lost.
+    ///
+    /// @return Pointer to the opened connection.
+    ///
+    /// @throw NoDatabaseName Mandatory database name not given
+    /// @throw DbOpenError Error opening the database
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    boost::shared_ptr<MySqlConnection> openConnection();
+
+    /// @brief Checks if the connection to the database is still usable
+    ///
+    /// It is used by the connection pool to verify the connection after
+    /// a failed operation or a period of inactivity.
+    ///
+    /// @param conn Connection to be checked.
+    ///
+    /// @return true if the server responds, false otherwise.
+    static bool checkConnection(MySqlConnection& conn);
+
     /// @brief Prepare Single Statement
     ///
     /// Creates a prepared statement from the text given and adds it to the
-    /// statements_ vector at the given index.
+    /// statements_ vector of the connection at the given index.
     ///
+    /// @param conn Connection for which the statement is prepared.
     /// @param index Index into the statements_ vector into which the text
     ///        should be placed.  The vector must be big enough for the index
     ///        to be valid, else an exception will be thrown.
@@ -485,27 +722,32 @@ private:
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     /// @throw isc::InvalidParameter 'index' is not valid for the vector.
-    void prepareStatement(StatementIndex index, const char* text);
+    void prepareStatement(MySqlConnection& conn, StatementIndex index,
+                          const char* text);
 
     /// @brief Prepare statements
     ///
     /// Creates the prepared statements for all of the SQL statements used
     /// by the MySQL backend.
     ///
+    /// @param conn Connection for which the statements are prepared.
+    ///
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     /// @throw isc::InvalidParameter 'index' is not valid for the vector.  This
     ///        represents an internal error within the code.
-    void prepareStatements();
+    void prepareStatements(MySqlConnection& conn);
 
     /// @brief Open Database
     ///
     /// Opens the database using the information supplied in the parameters
     /// passed to the constructor.
     ///
+    /// @param conn Connection on which the database is opened.
+    ///
     /// @throw NoDatabaseName Mandatory database name not given
     /// @throw DbOpenError Error opening the database
-    void openDatabase();
+    void openDatabase(MySqlConnection& conn);
 
     /// @brief Add Lease Common Code
     ///
@@ -513,6 +755,7 @@ private:
     /// of the addLease method.  It binds the contents of the lease object to
     /// the prepared statement and adds it to the database.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statemnent being executed
     /// @param bind MYSQL_BIND array that has been created for the type
     ///        of lease in question.
@@ -522,13 +765,15 @@ private:
     ///
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool addLeaseCommon(StatementIndex stindex, std::vector<MYSQL_BIND>& bind);
+    bool addLeaseCommon(MySqlConnection& conn, StatementIndex stindex,
+                        std::vector<MYSQL_BIND>& bind);
 
     /// @brief Get Lease Collection Common Code
     ///
     /// This method performs the common actions for obtaining multiple leases
     /// from the database.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param exchange Exchange object to use
@@ -545,8 +790,9 @@ private:
     /// @throw isc::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
     template <typename Exchange, typename LeaseCollection>
-    void getLeaseCollection(StatementIndex stindex, MYSQL_BIND* bind,
-                            Exchange& exchange, LeaseCollection& result,
+    void getLeaseCollection(MySqlConnection& conn, StatementIndex stindex,
+                            MYSQL_BIND* bind, Exchange& exchange,
+                            LeaseCollection& result,
                             bool single = false) const;
 
     /// @brief Get Lease Collection
@@ -554,6 +800,7 @@ private:
     /// Gets a collection of Lease4 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease LeaseCollection object returned.  Note that any leases in
@@ -565,16 +812,15 @@ private:
     ///        failed.
     /// @throw isc::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, MYSQL_BIND* bind,
-                            Lease4Collection& result) const {
-        getLeaseCollection(stindex, bind, exchange4_, result);
-    }
+    void getLeaseCollection(MySqlConnection& conn, StatementIndex stindex,
+                            MYSQL_BIND* bind, Lease4Collection& result) const;
 
     /// @brief Get Lease Collection
     ///
     /// Gets a collection of Lease6 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease LeaseCollection object returned.  Note that any existing
@@ -585,10 +831,25 @@ private:
     ///        failed.
     /// @throw isc::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, MYSQL_BIND* bind,
-                            Lease6Collection& result) const {
-        getLeaseCollection(stindex, bind, exchange6_, result);
-    }
+    void getLeaseCollection(MySqlConnection& conn, StatementIndex stindex,
+                            MYSQL_BIND* bind, Lease6Collection& result) const;
+
+    /// @brief Get expired leases
+    ///
+    /// Common code for the getExpiredLeases4() and getExpiredLeases6()
+    /// methods. It selects the leases which expired before the current
+    /// time, ordered by the expiration time.
+    ///
+    /// @param conn Connection on which the statement is executed.
+    /// @param stindex Index of statement being executed
+    /// @param max_leases Maximum number of leases to be returned (0 means
+    ///        no limit).
+    /// @param [out] expired_leases Collection to which the leases are
+    ///        appended.
+    template <typename LeaseCollection>
+    void getExpiredLeasesCommon(MySqlConnection& conn, StatementIndex stindex,
+                                const size_t max_leases,
+                                LeaseCollection& expired_leases) const;
 
     /// @brief Get Lease4 Common Code
     ///
@@ -596,11 +857,12 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease Lease4 object returned
-    void getLease(StatementIndex stindex, MYSQL_BIND* bind,
-                  Lease4Ptr& result) const;
+    void getLease(MySqlConnection& conn, StatementIndex stindex,
+                  MYSQL_BIND* bind, Lease4Ptr& result) const;
 
     /// @brief Get Lease6 Common Code
     ///
@@ -608,11 +870,12 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease Lease6 object returned
-    void getLease(StatementIndex stindex, MYSQL_BIND* bind,
-                   Lease6Ptr& result) const;
+    void getLease(MySqlConnection& conn, StatementIndex stindex,
+                  MYSQL_BIND* bind, Lease6Ptr& result) const;
 
     /// @brief Update lease common code
     ///
@@ -620,6 +883,7 @@ private:
     /// to the prepared statement, executes it, then checks how many rows
     /// were affected.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of prepared statement to be executed
     /// @param bind Array of MYSQL_BIND objects representing the parameters.
     ///        (Note that the number is determined by the number of parameters
@@ -631,8 +895,8 @@ private:
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     template <typename LeasePtr>
-    void updateLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind,
-                           const LeasePtr& lease);
+    void updateLeaseCommon(MySqlConnection& conn, StatementIndex stindex,
+                           MYSQL_BIND* bind, const LeasePtr& lease);
 
     /// @brief Delete lease common code
     ///
@@ -640,6 +904,7 @@ private:
     /// to the prepared statement, executes the statement and checks to
     /// see how many rows were deleted.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of prepared statement to be executed
     /// @param bind Array of MYSQL_BIND objects representing the parameters.
     ///        (Note that the number is determined by the number of parameters
@@ -650,41 +915,135 @@ private:
     ///
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool deleteLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind);
+    bool deleteLeaseCommon(MySqlConnection& conn, StatementIndex stindex,
+                           MYSQL_BIND* bind);
 
     /// @brief Check Error and Throw Exception
     ///
     /// Virtually all MySQL functions return a status which, if non-zero,
-    /// indicates an error.  This inline function conceals a lot of error
+    /// indicates an error.  This function conceals a lot of error
     /// checking/exception-throwing code.
     ///
+    /// @param conn Connection on which the error occurred
     /// @param status Status code: non-zero implies an error
     /// @param index Index of statement that caused the error
     /// @param what High-level description of the error
     ///
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    inline void checkError(int status, StatementIndex index,
-                           const char* what) const {
-        if (status != 0) {
-            isc_throw(DbOperationError, what << " for <" <<
-                      text_statements_[index] << ">, reason: " <<
-                      mysql_error(mysql_) << " (error code " <<
-                      mysql_errno(mysql_) << ")");
-        }
-    }
+    void checkError(MySqlConnection& conn, int status, StatementIndex index,
+                    const char* what) const;
+
+    /// @name Lease operations on the given connection
+    ///
+    /// These methods implement the public methods of the same names, using
+    /// the connection checked out by the caller.  They are also used to
+    /// execute the asynchronous operations in a single transaction.
+    //@{
+    Lease4Ptr getLease4(MySqlConnection& conn,
+                        const isc::asiolink::IOAddress& addr) const;
+    Lease4Ptr getLease4(MySqlConnection& conn, const HWAddr& hwaddr,
+                        SubnetID subnet_id) const;
+    Lease4Ptr getLease4(MySqlConnection& conn, const ClientId& clientid,
+                        SubnetID subnet_id) const;
+    Lease6Ptr getLease6(MySqlConnection& conn, Lease::Type type,
+                        const isc::asiolink::IOAddress& addr) const;
+    bool addLease(MySqlConnection& conn, const Lease4Ptr& lease);
+    bool addLease(MySqlConnection& conn, const Lease6Ptr& lease);
+    void updateLease4(MySqlConnection& conn, const Lease4Ptr& lease4);
+    void updateLease6(MySqlConnection& conn, const Lease6Ptr& lease6);
+    bool deleteLease(MySqlConnection& conn,
+                     const isc::asiolink::IOAddress& addr);
+    //@}
+
+    /// @brief Queues the asynchronous operation for the group commit.
+    ///
+    /// If the group commit is disabled, the operation is executed and its
+    /// callback is invoked before returning.
+    ///
+    /// @param operation Operation to be queued.
+    void startAsyncOperation(const AsyncOperation& operation);
+
+    /// @brief Body of the group commit thread.
+    ///
+    /// Waits for the queued operations, commits them in batches and passes
+    /// them back to the caller thread, until the lease manager is destroyed.
+    void runGroupCommit();
+
+    /// @brief Executes the operations, committing them in one transaction
+    /// if possible.
+    ///
+    /// @param operations Operations to be executed.  Their results and
+    ///        errors are set.
+    void commitOperations(AsyncOperations& operations);
+
+    /// @brief Executes the operations in a single transaction.
+    ///
+    /// @param conn Connection on which the operations are executed.
+    /// @param operations Operations to be executed.
+    ///
+    /// @return true if the transaction has been committed, false if one of
+    ///         the operations has failed and the transaction has been rolled
+    ///         back.
+    ///
+    /// @throw isc::dhcp::DbOperationError if the transaction couldn't be
+    ///        started, committed or rolled back.
+    bool executeTransaction(MySqlConnection& conn,
+                            AsyncOperations& operations);
+
+    /// @brief Executes a single asynchronous operation.
+    ///
+    /// @param conn Connection on which the operation is executed.
+    /// @param operation Operation to be executed.  Its result and error are
+    ///        set.
+    ///
+    /// @return false if the operation has failed, true otherwise.
+    bool executeOperation(MySqlConnection& conn, AsyncOperation& operation);
+
+    /// @brief Invokes the callback of the completed operation.
+    ///
+    /// @param operation Completed operation.
+    static void invokeCallback(const AsyncOperation& operation);
 
     // Members
 
-    /// The exchange objects are used for transfer of data to/from the database.
-    /// They are pointed-to objects as the contents may change in "const" calls,
-    /// while the rest of this object does not.  (At alternative would be to
-    /// declare them as "mutable".)
-    boost::scoped_ptr<MySqlLease4Exchange> exchange4_; ///< Exchange object
-    boost::scoped_ptr<MySqlLease6Exchange> exchange6_; ///< Exchange object
-    MySqlHolder mysql_;
-    std::vector<MYSQL_STMT*> statements_;       ///< Prepared statements
+    /// Pool of the connections to the database.  Each connection holds its
+    /// own prepared statements and exchange objects, used for transfer of
+    /// data to/from the database.
+    boost::scoped_ptr<ConnectionPool> pool_;
     std::vector<std::string> text_statements_;  ///< Raw text of statements
+
+    /// Maximum number of operations in a group commit or 0 if the group
+    /// commit is disabled.
+    size_t group_commit_size_;
+
+    /// Time to wait for more operations before committing, in milliseconds.
+    size_t group_commit_delay_;
+
+    /// Operations waiting for the group commit thread.
+    AsyncOperations queued_operations_;
+
+    /// Committed operations waiting for their callbacks to be invoked.
+    AsyncOperations committed_operations_;
+
+    /// Number of operations whose callbacks haven't been invoked.  It is
+    /// only used by the caller thread.
+    size_t async_pending_;
+
+    /// Indicates that the group commit thread should terminate.
+    bool stop_group_commit_;
+
+    /// Mutex protecting the queued and committed operations.
+    isc::util::thread::Mutex group_commit_mutex_;
+
+    /// Condition variable signalled when an operation is queued.
+    isc::util::thread::CondVar group_commit_cond_;
+
+    /// Descriptor marked ready when committed operations are available.
+    boost::scoped_ptr<isc::dhcp_ddns::WatchSocket> commit_ready_;
+
+    /// Group commit thread or NULL if the group commit is disabled.
+    boost::scoped_ptr<isc::util::thread::Thread> group_commit_thread_;
 };
 
 }; // end of isc::dhcp namespace
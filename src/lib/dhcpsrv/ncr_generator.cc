@@ -0,0 +1,120 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/option_data_types.h>
+#include <dhcp_ddns/ncr_msg.h>
+#include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/ncr_generator.h>
+#include <exceptions/exceptions.h>
+
+#include <vector>
+
+using namespace isc::dhcp_ddns;
+
+namespace {
+
+using namespace isc::dhcp;
+
+/// @brief Computes the DHCID for the DHCPv4 lease.
+///
+/// The client identifier is preferred to the hardware address.
+///
+/// @param lease DHCPv4 lease.
+/// @param fqdn_wire Hostname of the client in the canonical wire format.
+D2Dhcid
+computeDhcid(const Lease4& lease, const std::vector<uint8_t>& fqdn_wire) {
+    if (lease.client_id_) {
+        return (D2Dhcid(lease.client_id_->getClientId(), fqdn_wire));
+    }
+    HWAddrPtr hwaddr(new HWAddr(lease.hwaddr_, HTYPE_ETHER));
+    return (D2Dhcid(hwaddr, fqdn_wire));
+}
+
+/// @brief Computes the DHCID for the DHCPv6 lease.
+///
+/// @param lease DHCPv6 lease.
+/// @param fqdn_wire Hostname of the client in the canonical wire format.
+///
+/// @throw isc::Unexpected if the lease has no DUID.
+D2Dhcid
+computeDhcid(const Lease6& lease, const std::vector<uint8_t>& fqdn_wire) {
+    if (!lease.duid_) {
+        isc_throw(isc::Unexpected, "DUID must be set to compute the DHCID"
+                  " for the lease " << lease.addr_);
+    }
+    return (D2Dhcid(*lease.duid_, fqdn_wire));
+}
+
+/// @brief Sends the request to remove the DNS records for the lease.
+///
+/// @param lease DHCPv4 or DHCPv6 lease.
+/// @tparam LeasePtrType @c Lease4Ptr or @c Lease6Ptr.
+template<typename LeasePtrType>
+void
+queueRemovalNCRCommon(const LeasePtrType& lease) {
+    // Nothing to do if the DNS updates haven't been performed for the lease
+    // or they are disabled.
+    if (!lease || lease->hostname_.empty() ||
+        (!lease->fqdn_fwd_ && !lease->fqdn_rev_) ||
+        !CfgMgr::instance().ddnsEnabled()) {
+        return;
+    }
+
+    try {
+        // The DHCID is computed from the hostname in the canonical wire
+        // format, which is converted to lower case as required by the
+        // RFC4701, section 3.5.
+        std::vector<uint8_t> fqdn_wire;
+        OptionDataTypeUtil::writeFqdn(lease->hostname_, fqdn_wire, true);
+
+        NameChangeRequestPtr ncr(new NameChangeRequest(CHG_REMOVE,
+                                                       lease->fqdn_fwd_,
+                                                       lease->fqdn_rev_,
+                                                       lease->hostname_,
+                                                       lease->addr_.toText(),
+                                                       computeDhcid(*lease,
+                                                                    fqdn_wire),
+                                                       lease->cltt_ +
+                                                       lease->valid_lft_,
+                                                       lease->valid_lft_));
+
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
+                  DHCPSRV_QUEUE_REMOVAL_NCR).arg(ncr->toText());
+
+        CfgMgr::instance().getD2ClientMgr().sendRequest(ncr);
+
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_QUEUE_REMOVAL_NCR_FAILED)
+            .arg(lease->addr_.toText()).arg(ex.what());
+    }
+}
+
+} // end of anonymous namespace
+
+namespace isc {
+namespace dhcp {
+
+void
+queueRemovalNCR(const Lease4Ptr& lease) {
+    queueRemovalNCRCommon(lease);
+}
+
+void
+queueRemovalNCR(const Lease6Ptr& lease) {
+    queueRemovalNCRCommon(lease);
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
@@ -0,0 +1,46 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef NCR_GENERATOR_H
+#define NCR_GENERATOR_H
+
+#include <dhcpsrv/lease.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Sends the request to remove the DNS records for the DHCPv4 lease.
+///
+/// The NameChangeRequest is created and passed to the @c D2ClientMgr if
+/// the DNS updates are enabled and the forward or reverse DNS update has
+/// been performed for the lease. This function is used when the lease is
+/// removed by the server without the client's involvement, e.g. when the
+/// expired lease is reclaimed. The errors are logged and not propagated
+/// to the caller.
+///
+/// @param lease Lease for which the DNS records should be removed.
+void queueRemovalNCR(const Lease4Ptr& lease);
+
+/// @brief Sends the request to remove the DNS records for the DHCPv6 lease.
+///
+/// This is a counterpart of the function removing the DNS records for the
+/// DHCPv4 lease.
+///
+/// @param lease Lease for which the DNS records should be removed.
+void queueRemovalNCR(const Lease6Ptr& lease);
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
+
+#endif // NCR_GENERATOR_H
@@ -20,12 +20,16 @@
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/pgsql_lease_mgr.h>
 
+#include <boost/bind.hpp>
 #include <boost/static_assert.hpp>
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <errno.h>
+#include <poll.h>
 #include <time.h>
 
 // PostgreSQL errors should be tested based on the SQL state code.  Each state
@@ -96,6 +100,16 @@ TaggedStatement tagged_statements[] = {
       "delete_lease6",
       "DELETE FROM lease6 WHERE address = $1"},
 
+    // DELETE_EXPIRED_LEASE4
+    { 2, { OID_INT8, OID_TIMESTAMP },
+      "delete_expired_lease4",
+      "DELETE FROM lease4 WHERE address = $1 AND expire < $2"},
+
+    // DELETE_EXPIRED_LEASE6
+    { 2, { OID_VARCHAR, OID_TIMESTAMP },
+      "delete_expired_lease6",
+      "DELETE FROM lease6 WHERE address = $1 AND expire < $2"},
+
     // GET_LEASE4_ADDR
     { 1, { OID_INT8 },
       "get_lease4_addr",
@@ -123,6 +137,17 @@ TaggedStatement tagged_statements[] = {
       "FROM lease4 "
       "WHERE client_id = $1 AND subnet_id = $2"},
 
+    // GET_LEASE4_EXPIRE
+    { 2, { OID_TIMESTAMP, OID_INT8 },
+      "get_lease4_expire",
+      "SELECT address, hwaddr, client_id, "
+        "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, "
+        "fqdn_fwd, fqdn_rev, hostname "
+      "FROM lease4 "
+      "WHERE expire < $1 "
+      "ORDER BY expire "
+      "LIMIT $2"},
+
     // GET_LEASE4_HWADDR
     { 1, { OID_BYTEA },
       "get_lease4_hwaddr",
@@ -141,6 +166,15 @@ TaggedStatement tagged_statements[] = {
       "FROM lease4 "
       "WHERE hwaddr = $1 AND subnet_id = $2"},
 
+    // GET_LEASE4_SUBID
+    { 1, { OID_INT8 },
+      "get_lease4_subid",
+      "SELECT address, hwaddr, client_id, "
+        "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, "
+        "fqdn_fwd, fqdn_rev, hostname "
+      "FROM lease4 "
+      "WHERE subnet_id = $1"},
+
     // GET_LEASE6_ADDR
     { 2, { OID_VARCHAR, OID_INT2 },
       "get_lease6_addr",
@@ -169,6 +203,26 @@ TaggedStatement tagged_statements[] = {
       "WHERE lease_type = $1 "
         "AND duid = $2 AND iaid = $3 AND subnet_id = $4"},
 
+    // GET_LEASE6_EXPIRE
+    { 2, { OID_TIMESTAMP, OID_INT8 },
+      "get_lease6_expire",
+      "SELECT address, duid, valid_lifetime, "
+        "extract(epoch from expire)::bigint, subnet_id, pref_lifetime, "
+        "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
+      "FROM lease6 "
+      "WHERE expire < $1 "
+      "ORDER BY expire "
+      "LIMIT $2"},
+
+    // GET_LEASE6_SUBID
+    { 1, { OID_INT8 },
+      "get_lease6_subid",
+      "SELECT address, duid, valid_lifetime, "
+        "extract(epoch from expire)::bigint, subnet_id, pref_lifetime, "
+        "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
+      "FROM lease6 "
+      "WHERE subnet_id = $1"},
+
     // GET_VERSION
     { 0, { OID_NONE },
       "get_version",
@@ -300,7 +354,7 @@ public:
     ///
     /// @param time_val timestamp to be converted
     /// @return std::string containing the stringified time
-    std::string
+    static std::string
     convertToDatabaseTime(const time_t& time_val) {
         // PostgreSQL does funny things with time if you get past Y2038.  It
         // will accept the values (unlike MySQL which throws) but it
@@ -921,34 +975,102 @@ private:
     //@}
 };
 
+/// @brief Connection to the PostgreSQL database
+///
+/// Holds the PostgreSQL connection handle together with the exchange
+/// objects, which can only be used by one thread at a time.  The statements
+/// are prepared on the server side, separately for each connection.  The
+/// lease manager keeps a pool of these objects and checks one of them out
+/// for the duration of each lease operation.
+class PgSqlConnection : public boost::noncopyable {
+public:
+
+    /// @brief Constructor
+    ///
+    /// The connection is opened and the statements are prepared by the
+    /// lease manager.
+    PgSqlConnection()
+        : pgconn_(NULL), exchange4_(new PgSqlLease4Exchange()),
+          exchange6_(new PgSqlLease6Exchange()) {
+    }
+
+    /// @brief Destructor
+    ///
+    /// Deallocates the prepared statements and closes the connection.
+    ~PgSqlConnection() {
+        if (pgconn_) {
+            // Deallocate the prepared queries.
+            PGresult* r = PQexec(pgconn_, "DEALLOCATE all");
+            if(PQresultStatus(r) != PGRES_COMMAND_OK) {
+                // Highly unlikely but we'll log it and go on.
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_PGSQL_DEALLOC_ERROR)
+                          .arg(PQerrorMessage(pgconn_));
+            }
+
+            PQclear(r);
+            PQfinish(pgconn_);
+            pgconn_ = NULL;
+        }
+    }
+
+    /// PostgreSQL connection handle
+    PGconn* pgconn_;
+
+    /// The exchange objects are used for transfer of data to/from the
+    /// database.
+    boost::scoped_ptr<PgSqlLease4Exchange> exchange4_; ///< Exchange object
+    boost::scoped_ptr<PgSqlLease6Exchange> exchange6_; ///< Exchange object
+};
+
 PgSqlLeaseMgr::PgSqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
-    : LeaseMgr(parameters), exchange4_(new PgSqlLease4Exchange()),
-    exchange6_(new PgSqlLease6Exchange()), conn_(NULL) {
-    openDatabase();
-    prepareStatements();
+    : LeaseMgr(parameters) {
+    // Open the connections to the database, each with its own set of
+    // prepared statements.
+    pool_.reset(new ConnectionPool(boost::bind(&PgSqlLeaseMgr::openConnection,
+                                               this),
+                                   &PgSqlLeaseMgr::checkConnection,
+                                   getConnectionCount()));
 }
 
 PgSqlLeaseMgr::~PgSqlLeaseMgr() {
-    if (conn_) {
-        // Deallocate the prepared queries.
-        PGresult* r = PQexec(conn_, "DEALLOCATE all");
-        if(PQresultStatus(r) != PGRES_COMMAND_OK) {
-            // Highly unlikely but we'll log it and go on.
-            LOG_ERROR(dhcpsrv_logger, DHCPSRV_PGSQL_DEALLOC_ERROR)
-                      .arg(PQerrorMessage(conn_));
-        }
+    // The outstanding asynchronous queries are discarded without invoking
+    // their callbacks, which may refer to the objects being destroyed.
+    for (std::deque<AsyncQuery>::iterator query = async_queries_.begin();
+         query != async_queries_.end(); ++query) {
+        PQclear(query->result_);
+    }
+    closeAsyncConnection();
 
-        PQclear(r);
-        PQfinish(conn_);
-        conn_ = NULL;
+    // The connections are closed by the destructor of the pool.
+}
+
+boost::shared_ptr<PgSqlConnection>
+PgSqlLeaseMgr::openConnection() {
+    boost::shared_ptr<PgSqlConnection> conn(new PgSqlConnection());
+    openDatabase(*conn);
+    prepareStatements(*conn);
+    return (conn);
+}
+
+bool
+PgSqlLeaseMgr::checkConnection(PgSqlConnection& conn) {
+    // Issue a trivial query: the status of the connection is only updated
+    // by the library when the connection is used.
+    PGresult* r = PQexec(conn.pgconn_, "SELECT 1");
+    const bool ok = (PQresultStatus(r) == PGRES_TUPLES_OK);
+    PQclear(r);
+    if (!ok) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_PGSQL_CONNECTION_LOST)
+            .arg(PQerrorMessage(conn.pgconn_));
     }
+    return (ok);
 }
 
 void
-PgSqlLeaseMgr::prepareStatements() {
+PgSqlLeaseMgr::prepareStatements(PgSqlConnection& conn) {
     for(int i = 0; tagged_statements[i].text != NULL; ++ i) {
         // Prepare all statements queries with all known fields datatype
-        PGresult* r = PQprepare(conn_, tagged_statements[i].name,
+        PGresult* r = PQprepare(conn.pgconn_, tagged_statements[i].name,
                                 tagged_statements[i].text,
                                 tagged_statements[i].nbparams,
                                 tagged_statements[i].types);
@@ -958,7 +1080,7 @@ PgSqlLeaseMgr::prepareStatements() {
             isc_throw(DbOperationError,
                       "unable to prepare PostgreSQL statement: "
                       << tagged_statements[i].text << ", reason: "
-                      << PQerrorMessage(conn_));
+                      << PQerrorMessage(conn.pgconn_));
         }
 
         PQclear(r);
@@ -966,7 +1088,7 @@ PgSqlLeaseMgr::prepareStatements() {
 }
 
 void
-PgSqlLeaseMgr::openDatabase() {
+PgSqlLeaseMgr::openDatabase(PgSqlConnection& conn) {
     string dbconnparameters;
     string shost = "localhost";
     try {
@@ -1002,25 +1124,25 @@ PgSqlLeaseMgr::openDatabase() {
         isc_throw(NoDatabaseName, "must specify a name for the database");
     }
 
-    conn_ = PQconnectdb(dbconnparameters.c_str());
-    if (conn_ == NULL) {
+    conn.pgconn_ = PQconnectdb(dbconnparameters.c_str());
+    if (conn.pgconn_ == NULL) {
         isc_throw(DbOpenError, "could not allocate connection object");
     }
 
-    if (PQstatus(conn_) != CONNECTION_OK) {
+    if (PQstatus(conn.pgconn_) != CONNECTION_OK) {
         // If we have a connection object, we have to call finish
         // to release it, but grab the error message first.
-        std::string error_message = PQerrorMessage(conn_);
-        PQfinish(conn_);
-        conn_ = NULL;
+        std::string error_message = PQerrorMessage(conn.pgconn_);
+        PQfinish(conn.pgconn_);
+        conn.pgconn_ = NULL;
         isc_throw(DbOpenError, error_message);
     }
 }
 
 bool
-PgSqlLeaseMgr::addLeaseCommon(StatementIndex stindex,
+PgSqlLeaseMgr::addLeaseCommon(PgSqlConnection& conn, StatementIndex stindex,
                               PsqlBindArray& bind_array) {
-    PGresult* r = PQexecPrepared(conn_, tagged_statements[stindex].name,
+    PGresult* r = PQexecPrepared(conn.pgconn_, tagged_statements[stindex].name,
                                   tagged_statements[stindex].nbparams,
                                   &bind_array.values_[0],
                                   &bind_array.lengths_[0],
@@ -1037,7 +1159,7 @@ PgSqlLeaseMgr::addLeaseCommon(StatementIndex stindex,
             return (false);
         }
 
-        const char* errorMsg = PQerrorMessage(conn_);
+        const char* errorMsg = PQerrorMessage(conn.pgconn_);
         PQclear(r);
         isc_throw(DbOperationError, "unable to INSERT for " <<
                   tagged_statements[stindex].name << ", reason: " <<
@@ -1058,26 +1180,31 @@ bool PgSqlLeaseMgr::compareError(PGresult*& r, const char* error_state) {
 
 bool
 PgSqlLeaseMgr::addLease(const Lease4Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_ADD_ADDR4).arg(lease->addr_.toText());
 
     PsqlBindArray bind_array;
-    exchange4_->createBindForSend(lease, bind_array);
-    return (addLeaseCommon(INSERT_LEASE4, bind_array));
+    conn->exchange4_->createBindForSend(lease, bind_array);
+    return (addLeaseCommon(*conn, INSERT_LEASE4, bind_array));
 }
 
 bool
 PgSqlLeaseMgr::addLease(const Lease6Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_ADD_ADDR6).arg(lease->addr_.toText());
     PsqlBindArray bind_array;
-    exchange6_->createBindForSend(lease, bind_array);
+    conn->exchange6_->createBindForSend(lease, bind_array);
 
-    return (addLeaseCommon(INSERT_LEASE6, bind_array));
+    return (addLeaseCommon(*conn, INSERT_LEASE6, bind_array));
 }
 
 template <typename Exchange, typename LeaseCollection>
-void PgSqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
+void PgSqlLeaseMgr::getLeaseCollection(PgSqlConnection& conn,
+                                       StatementIndex stindex,
                                        PsqlBindArray& bind_array,
                                        Exchange& exchange,
                                        LeaseCollection& result,
@@ -1085,13 +1212,13 @@ void PgSqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_ADDR4).arg(tagged_statements[stindex].name);
 
-    PGresult* r = PQexecPrepared(conn_, tagged_statements[stindex].name,
+    PGresult* r = PQexecPrepared(conn.pgconn_, tagged_statements[stindex].name,
                        tagged_statements[stindex].nbparams,
                        &bind_array.values_[0],
                        &bind_array.lengths_[0],
                        &bind_array.formats_[0], 0);
 
-    checkStatementError(r, stindex);
+    checkStatementError(conn, r, stindex);
 
     int rows = PQntuples(r);
     if (single && rows > 1) {
@@ -1108,17 +1235,33 @@ void PgSqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
     PQclear(r);
 }
 
+void
+PgSqlLeaseMgr::getLeaseCollection(PgSqlConnection& conn,
+                                  StatementIndex stindex,
+                                  PsqlBindArray& bind_array,
+                                  Lease4Collection& result) const {
+    getLeaseCollection(conn, stindex, bind_array, conn.exchange4_, result);
+}
+
+void
+PgSqlLeaseMgr::getLeaseCollection(PgSqlConnection& conn,
+                                  StatementIndex stindex,
+                                  PsqlBindArray& bind_array,
+                                  Lease6Collection& result) const {
+    getLeaseCollection(conn, stindex, bind_array, conn.exchange6_, result);
+}
 
 void
-PgSqlLeaseMgr::getLease(StatementIndex stindex, PsqlBindArray& bind_array,
-                             Lease4Ptr& result) const {
+PgSqlLeaseMgr::getLease(PgSqlConnection& conn, StatementIndex stindex,
+                        PsqlBindArray& bind_array, Lease4Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" parameter is true to indicate
     // that the called method should throw an exception if multiple
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease4Collection collection;
-    getLeaseCollection(stindex, bind_array, exchange4_, collection, true);
+    getLeaseCollection(conn, stindex, bind_array, conn.exchange4_, collection,
+                       true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -1130,15 +1273,16 @@ PgSqlLeaseMgr::getLease(StatementIndex stindex, PsqlBindArray& bind_array,
 
 
 void
-PgSqlLeaseMgr::getLease(StatementIndex stindex, PsqlBindArray& bind_array,
-                             Lease6Ptr& result) const {
+PgSqlLeaseMgr::getLease(PgSqlConnection& conn, StatementIndex stindex,
+                        PsqlBindArray& bind_array, Lease6Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" parameter is true to indicate
     // that the called method should throw an exception if multiple
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease6Collection collection;
-    getLeaseCollection(stindex, bind_array, exchange6_, collection, true);
+    getLeaseCollection(conn, stindex, bind_array, conn.exchange6_, collection,
+                       true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -1150,6 +1294,8 @@ PgSqlLeaseMgr::getLease(StatementIndex stindex, PsqlBindArray& bind_array,
 
 Lease4Ptr
 PgSqlLeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_ADDR4).arg(addr.toText());
 
@@ -1163,13 +1309,15 @@ PgSqlLeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_ADDR, bind_array, result);
+    getLease(*conn, GET_LEASE4_ADDR, bind_array, result);
 
     return (result);
 }
 
 Lease4Collection
 PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_HWADDR).arg(hwaddr.toText());
 
@@ -1185,13 +1333,15 @@ PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_HWADDR, bind_array, result);
+    getLeaseCollection(*conn, GET_LEASE4_HWADDR, bind_array, result);
 
     return (result);
 }
 
 Lease4Ptr
 PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_SUBID_HWADDR)
               .arg(subnet_id).arg(hwaddr.toText());
@@ -1212,13 +1362,15 @@ PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_HWADDR_SUBID, bind_array, result);
+    getLease(*conn, GET_LEASE4_HWADDR_SUBID, bind_array, result);
 
     return (result);
 }
 
 Lease4Collection
 PgSqlLeaseMgr::getLease4(const ClientId& clientid) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_CLIENTID).arg(clientid.toText());
 
@@ -1230,13 +1382,15 @@ PgSqlLeaseMgr::getLease4(const ClientId& clientid) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_CLIENTID, bind_array, result);
+    getLeaseCollection(*conn, GET_LEASE4_CLIENTID, bind_array, result);
 
     return (result);
 }
 
 Lease4Ptr
 PgSqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_SUBID_CLIENTID)
               .arg(subnet_id).arg(clientid.toText());
@@ -1253,7 +1407,28 @@ PgSqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_CLIENTID_SUBID, bind_array, result);
+    getLease(*conn, GET_LEASE4_CLIENTID_SUBID, bind_array, result);
+
+    return (result);
+}
+
+Lease4Collection
+PgSqlLeaseMgr::getLeases4(SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_SUBID4).arg(subnet_id);
+
+    // Set up the WHERE clause value
+    PsqlBindArray bind_array;
+
+    // SUBNET_ID
+    std::string subnet_id_str = boost::lexical_cast<std::string>(subnet_id);
+    bind_array.add(subnet_id_str);
+
+    // ... and get the data
+    Lease4Collection result;
+    getLeaseCollection(*conn, GET_LEASE4_SUBID, bind_array, result);
 
     return (result);
 }
@@ -1271,6 +1446,8 @@ PgSqlLeaseMgr::getLease4(const ClientId&, const HWAddr&, SubnetID) const {
 Lease6Ptr
 PgSqlLeaseMgr::getLease6(Lease::Type lease_type,
                          const isc::asiolink::IOAddress& addr) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_PGSQL_GET_ADDR6)
               .arg(addr.toText()).arg(lease_type);
 
@@ -1287,7 +1464,7 @@ PgSqlLeaseMgr::getLease6(Lease::Type lease_type,
 
     // ... and get the data
     Lease6Ptr result;
-    getLease(GET_LEASE6_ADDR, bind_array, result);
+    getLease(*conn, GET_LEASE6_ADDR, bind_array, result);
 
     return (result);
 }
@@ -1295,6 +1472,8 @@ PgSqlLeaseMgr::getLease6(Lease::Type lease_type,
 Lease6Collection
 PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
                           uint32_t iaid) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_IAID_DUID)
               .arg(iaid).arg(duid.toText()).arg(lease_type);
@@ -1315,7 +1494,7 @@ PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID, bind_array, result);
+    getLeaseCollection(*conn, GET_LEASE6_DUID_IAID, bind_array, result);
 
     return (result);
 }
@@ -1323,6 +1502,8 @@ PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
 Lease6Collection
 PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
                           uint32_t iaid, SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText()).arg(lease_type);
@@ -1347,26 +1528,96 @@ PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID_SUBID, bind_array, result);
+    getLeaseCollection(*conn, GET_LEASE6_DUID_IAID_SUBID, bind_array, result);
 
     return (result);
 }
 
+Lease6Collection
+PgSqlLeaseMgr::getLeases6(SubnetID subnet_id) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_SUBID6).arg(subnet_id);
+
+    // Set up the WHERE clause value
+    PsqlBindArray bind_array;
+
+    // SUBNET_ID
+    std::string subnet_id_str = boost::lexical_cast<std::string>(subnet_id);
+    bind_array.add(subnet_id_str);
+
+    // ... and get the data
+    Lease6Collection result;
+    getLeaseCollection(*conn, GET_LEASE6_SUBID, bind_array, result);
+
+    return (result);
+}
+
+template <typename LeaseCollection>
+void
+PgSqlLeaseMgr::getExpiredLeasesCommon(PgSqlConnection& conn,
+                                      StatementIndex stindex,
+                                      const size_t max_leases,
+                                      LeaseCollection& expired_leases) const {
+    // Set up the WHERE clause value
+    PsqlBindArray bind_array;
+
+    // EXPIRE: the leases which expired before the current time are selected.
+    std::string expire_str =
+        PgSqlLeaseExchange::convertToDatabaseTime(time(NULL));
+    bind_array.add(expire_str);
+
+    // LIMIT: the highest possible value is used when the number of leases
+    // is not limited.
+    std::string limit_str = boost::lexical_cast<std::string>
+        (max_leases == 0 ? std::numeric_limits<uint32_t>::max() : max_leases);
+    bind_array.add(limit_str);
+
+    // ... and get the data
+    getLeaseCollection(conn, stindex, bind_array, expired_leases);
+}
+
+void
+PgSqlLeaseMgr::getExpiredLeases4(Lease4Collection& expired_leases,
+                                 const size_t max_leases) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED4).arg(max_leases);
+
+    getExpiredLeasesCommon(*conn, GET_LEASE4_EXPIRE, max_leases,
+                           expired_leases);
+}
+
+void
+PgSqlLeaseMgr::getExpiredLeases6(Lease6Collection& expired_leases,
+                                 const size_t max_leases) const {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED6).arg(max_leases);
+
+    getExpiredLeasesCommon(*conn, GET_LEASE6_EXPIRE, max_leases,
+                           expired_leases);
+}
+
 template <typename LeasePtr>
 void
-PgSqlLeaseMgr::updateLeaseCommon(StatementIndex stindex,
+PgSqlLeaseMgr::updateLeaseCommon(PgSqlConnection& conn,
+                                 StatementIndex stindex,
                                  PsqlBindArray& bind_array,
                                  const LeasePtr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_ADD_ADDR4).arg(tagged_statements[stindex].name);
 
-    PGresult* r = PQexecPrepared(conn_, tagged_statements[stindex].name,
+    PGresult* r = PQexecPrepared(conn.pgconn_, tagged_statements[stindex].name,
                                   tagged_statements[stindex].nbparams,
                                   &bind_array.values_[0],
                                   &bind_array.lengths_[0],
                                   &bind_array.formats_[0], 0);
 
-    checkStatementError(r, stindex);
+    checkStatementError(conn, r, stindex);
 
     int affected_rows = boost::lexical_cast<int>(PQcmdTuples(r));
     PQclear(r);
@@ -1391,6 +1642,8 @@ PgSqlLeaseMgr::updateLeaseCommon(StatementIndex stindex,
 
 void
 PgSqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+
     const StatementIndex stindex = UPDATE_LEASE4;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1398,7 +1651,7 @@ PgSqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
 
     // Create the BIND array for the data being updated
     PsqlBindArray bind_array;
-    exchange4_->createBindForSend(lease, bind_array);
+    conn->exchange4_->createBindForSend(lease, bind_array);
 
     // Set up the WHERE clause and append it to the SQL_BIND array
     std::string addr4_ = boost::lexical_cast<std::string>
@@ -1406,11 +1659,13 @@ PgSqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
     bind_array.add(addr4_);
 
     // Drop to common update code
-    updateLeaseCommon(stindex, bind_array, lease);
+    updateLeaseCommon(*conn, stindex, bind_array, lease);
 }
 
 void
 PgSqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
+    ConnectionPool::Locker conn(*pool_);
+
     const StatementIndex stindex = UPDATE_LEASE6;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1418,26 +1673,27 @@ PgSqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
 
     // Create the BIND array for the data being updated
     PsqlBindArray bind_array;
-    exchange6_->createBindForSend(lease, bind_array);
+    conn->exchange6_->createBindForSend(lease, bind_array);
 
     // Set up the WHERE clause and append it to the BIND array
     std::string addr_str = lease->addr_.toText();
     bind_array.add(addr_str);
 
     // Drop to common update code
-    updateLeaseCommon(stindex, bind_array, lease);
+    updateLeaseCommon(*conn, stindex, bind_array, lease);
 }
 
 bool
-PgSqlLeaseMgr::deleteLeaseCommon(StatementIndex stindex,
+PgSqlLeaseMgr::deleteLeaseCommon(PgSqlConnection& conn,
+                                 StatementIndex stindex,
                                  PsqlBindArray& bind_array) {
-    PGresult* r = PQexecPrepared(conn_, tagged_statements[stindex].name,
+    PGresult* r = PQexecPrepared(conn.pgconn_, tagged_statements[stindex].name,
                                   tagged_statements[stindex].nbparams,
                                   &bind_array.values_[0],
                                   &bind_array.lengths_[0],
                                   &bind_array.formats_[0], 0);
 
-    checkStatementError(r, stindex);
+    checkStatementError(conn, r, stindex);
     int affected_rows = boost::lexical_cast<int>(PQcmdTuples(r));
     PQclear(r);
 
@@ -1446,6 +1702,8 @@ PgSqlLeaseMgr::deleteLeaseCommon(StatementIndex stindex,
 
 bool
 PgSqlLeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_DELETE_ADDR).arg(addr.toText());
 
@@ -1456,12 +1714,40 @@ PgSqlLeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
         std::string addr4_str = boost::lexical_cast<std::string>
                                  (static_cast<uint32_t>(addr));
         bind_array.add(addr4_str);
-        return (deleteLeaseCommon(DELETE_LEASE4, bind_array));
+        return (deleteLeaseCommon(*conn, DELETE_LEASE4, bind_array));
     }
 
     std::string addr6_str = addr.toText();
     bind_array.add(addr6_str);
-    return (deleteLeaseCommon(DELETE_LEASE6, bind_array));
+    return (deleteLeaseCommon(*conn, DELETE_LEASE6, bind_array));
+}
+
+bool
+PgSqlLeaseMgr::deleteExpiredLease(const isc::asiolink::IOAddress& addr) {
+    ConnectionPool::Locker conn(*pool_);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_DELETE_EXPIRED_ADDR).arg(addr.toText());
+
+    // Set up the WHERE clause values
+    PsqlBindArray bind_array;
+
+    // The lease is only deleted if it expired before the current time.
+    std::string expire_str =
+        PgSqlLeaseExchange::convertToDatabaseTime(time(NULL));
+
+    if (addr.isV4()) {
+        std::string addr4_str = boost::lexical_cast<std::string>
+                                 (static_cast<uint32_t>(addr));
+        bind_array.add(addr4_str);
+        bind_array.add(expire_str);
+        return (deleteLeaseCommon(*conn, DELETE_EXPIRED_LEASE4, bind_array));
+    }
+
+    std::string addr6_str = addr.toText();
+    bind_array.add(addr6_str);
+    bind_array.add(expire_str);
+    return (deleteLeaseCommon(*conn, DELETE_EXPIRED_LEASE6, bind_array));
 }
 
 string
@@ -1476,10 +1762,11 @@ PgSqlLeaseMgr::getName() const {
 }
 
 void
-PgSqlLeaseMgr::checkStatementError(PGresult*& r, StatementIndex index) const {
+PgSqlLeaseMgr::checkStatementError(PgSqlConnection& conn, PGresult*& r,
+                                   StatementIndex index) const {
     int s = PQresultStatus(r);
     if (s != PGRES_COMMAND_OK && s != PGRES_TUPLES_OK) {
-        const char* error_message = PQerrorMessage(conn_);
+        const char* error_message = PQerrorMessage(conn.pgconn_);
         PQclear(r);
         isc_throw(DbOperationError, "Statement exec faild:" << " for: "
                   << tagged_statements[index].name << ", reason: "
@@ -1494,11 +1781,13 @@ PgSqlLeaseMgr::getDescription() const {
 
 pair<uint32_t, uint32_t>
 PgSqlLeaseMgr::getVersion() const {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_VERSION);
 
-    PGresult* r = PQexecPrepared(conn_, "get_version", 0, NULL, NULL, NULL, 0);
-    checkStatementError(r, GET_VERSION);
+    PGresult* r = PQexecPrepared(conn->pgconn_, "get_version", 0, NULL, NULL, NULL, 0);
+    checkStatementError(*conn, r, GET_VERSION);
 
     istringstream tmp;
     uint32_t version;
@@ -1518,10 +1807,12 @@ PgSqlLeaseMgr::getVersion() const {
 
 void
 PgSqlLeaseMgr::commit() {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_PGSQL_COMMIT);
-    PGresult* r = PQexec(conn_, "COMMIT");
+    PGresult* r = PQexec(conn->pgconn_, "COMMIT");
     if (PQresultStatus(r) != PGRES_COMMAND_OK) {
-        const char* error_message = PQerrorMessage(conn_);
+        const char* error_message = PQerrorMessage(conn->pgconn_);
         PQclear(r);
         isc_throw(DbOperationError, "commit failed: " << error_message);
     }
@@ -1531,10 +1822,12 @@ PgSqlLeaseMgr::commit() {
 
 void
 PgSqlLeaseMgr::rollback() {
+    ConnectionPool::Locker conn(*pool_);
+
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_PGSQL_ROLLBACK);
-    PGresult* r = PQexec(conn_, "ROLLBACK");
+    PGresult* r = PQexec(conn->pgconn_, "ROLLBACK");
     if (PQresultStatus(r) != PGRES_COMMAND_OK) {
-        const char* error_message = PQerrorMessage(conn_);
+        const char* error_message = PQerrorMessage(conn->pgconn_);
         PQclear(r);
         isc_throw(DbOperationError, "rollback failed: " << error_message);
     }
@@ -1542,5 +1835,449 @@ PgSqlLeaseMgr::rollback() {
     PQclear(r);
 }
 
+PgSqlConnection&
+PgSqlLeaseMgr::getAsyncConnection() {
+    if (!async_conn_) {
+        boost::shared_ptr<PgSqlConnection> conn = openConnection();
+        if (PQsetnonblocking(conn->pgconn_, 1) != 0) {
+            isc_throw(DbOpenError, "unable to set the non-blocking mode: "
+                      << PQerrorMessage(conn->pgconn_));
+        }
+#ifdef LIBPQ_HAS_PIPELINING
+        if (PQenterPipelineMode(conn->pgconn_) != 1) {
+            isc_throw(DbOpenError, "unable to enter the pipeline mode: "
+                      << PQerrorMessage(conn->pgconn_));
+        }
+#endif
+        async_conn_ = conn;
+    }
+    return (*async_conn_);
+}
+
+void
+PgSqlLeaseMgr::closeAsyncConnection() {
+    if (async_conn_) {
+        // The statements can't be deallocated while the connection is in
+        // the pipeline mode, but they are dropped by the server along with
+        // the session anyway.
+        PQfinish(async_conn_->pgconn_);
+        async_conn_->pgconn_ = NULL;
+        async_conn_.reset();
+    }
+}
+
+void
+PgSqlLeaseMgr::startAsyncQuery(StatementIndex stindex,
+                               PsqlBindArray& bind_array,
+                               const AsyncHandler& handler) {
+    getAsyncConnection();
+
+    AsyncQuery query;
+    query.stindex_ = stindex;
+    for (size_t i = 0; i < bind_array.size(); ++i) {
+        query.values_.push_back(std::string(bind_array.values_[i],
+                                            bind_array.lengths_[i]));
+    }
+    query.lengths_ = bind_array.lengths_;
+    query.formats_ = bind_array.formats_;
+    query.handler_ = handler;
+    query.result_ = NULL;
+    query.sent_ = false;
+    async_queries_.push_back(query);
+
+#ifdef LIBPQ_HAS_PIPELINING
+    // Queries are sent right away and the server pipelines them.
+    if (!sendAsyncQuery(async_queries_.back())) {
+        failAsyncQueries(PQerrorMessage(async_conn_->pgconn_));
+    }
+#else
+    // Only one query may be outstanding at a time.
+    sendNextAsyncQuery();
+#endif
+}
+
+bool
+PgSqlLeaseMgr::sendAsyncQuery(AsyncQuery& query) {
+    PGconn* pgconn = async_conn_->pgconn_;
+
+    std::vector<const char*> values;
+    for (size_t i = 0; i < query.values_.size(); ++i) {
+        values.push_back(query.values_[i].c_str());
+    }
+    if (!PQsendQueryPrepared(pgconn, tagged_statements[query.stindex_].name,
+                             tagged_statements[query.stindex_].nbparams,
+                             values.empty() ? NULL : &values[0],
+                             query.lengths_.empty() ? NULL :
+                             &query.lengths_[0],
+                             query.formats_.empty() ? NULL :
+                             &query.formats_[0], 0)) {
+        return (false);
+    }
+#ifdef LIBPQ_HAS_PIPELINING
+    // The synchronization point ends the implicit transaction of the query
+    // and makes the server flush its results.
+    if (!PQpipelineSync(pgconn)) {
+        return (false);
+    }
+#endif
+    query.sent_ = true;
+
+    // In the non-blocking mode the query may be left in the output buffer
+    // if the socket buffer is full. Wait until it is sent, consuming the
+    // input in the meantime, so as the server isn't blocked on sending the
+    // results either.
+    int flushed = 0;
+    while ((flushed = PQflush(pgconn)) == 1) {
+        struct pollfd pfd;
+        pfd.fd = PQsocket(pgconn);
+        pfd.events = POLLIN | POLLOUT;
+        pfd.revents = 0;
+        if ((poll(&pfd, 1, -1) < 0) && (errno != EINTR)) {
+            return (false);
+        }
+        if ((pfd.revents & POLLIN) && !PQconsumeInput(pgconn)) {
+            return (false);
+        }
+    }
+    return (flushed == 0);
+}
+
+void
+PgSqlLeaseMgr::sendNextAsyncQuery() {
+    if (!async_queries_.empty() && !async_queries_.front().sent_ &&
+        !sendAsyncQuery(async_queries_.front())) {
+        failAsyncQueries(PQerrorMessage(async_conn_->pgconn_));
+    }
+}
+
+void
+PgSqlLeaseMgr::completeAsyncQuery() {
+    // Remove the query first, as the handler may start new queries.
+    AsyncQuery query = async_queries_.front();
+    async_queries_.pop_front();
+    try {
+        query.handler_(query.result_, "");
+    } catch (...) {
+        PQclear(query.result_);
+        throw;
+    }
+    PQclear(query.result_);
+}
+
+void
+PgSqlLeaseMgr::failAsyncQueries(const std::string& error) {
+    LOG_WARN(dhcpsrv_logger, DHCPSRV_PGSQL_CONNECTION_LOST).arg(error);
+
+    // The handlers may start new queries, which reopen the connection.
+    std::deque<AsyncQuery> queries;
+    queries.swap(async_queries_);
+    closeAsyncConnection();
+
+    for (std::deque<AsyncQuery>::iterator query = queries.begin();
+         query != queries.end(); ++query) {
+        PQclear(query->result_);
+        query->result_ = NULL;
+    }
+    for (std::deque<AsyncQuery>::iterator query = queries.begin();
+         query != queries.end(); ++query) {
+        query->handler_(NULL, error.empty() ? "connection failed" : error);
+    }
+}
+
+int
+PgSqlLeaseMgr::getAsyncSocket() {
+    return (PQsocket(getAsyncConnection().pgconn_));
+}
+
+void
+PgSqlLeaseMgr::processAsyncResults() {
+    if (!async_conn_) {
+        return;
+    }
+
+    if (!PQconsumeInput(async_conn_->pgconn_)) {
+        failAsyncQueries(PQerrorMessage(async_conn_->pgconn_));
+        return;
+    }
+
+    // The callbacks may start new queries, which may replace the failed
+    // connection, so the connection is not cached across the iterations.
+#ifdef LIBPQ_HAS_PIPELINING
+    bool end_of_query = false;
+#endif
+    while (async_conn_ && !async_queries_.empty() &&
+           async_queries_.front().sent_ && !PQisBusy(async_conn_->pgconn_)) {
+        PGresult* r = PQgetResult(async_conn_->pgconn_);
+#ifdef LIBPQ_HAS_PIPELINING
+        // The results of the query are followed by NULL and then by the
+        // result of the synchronization point, which completes the query.
+        if (r == NULL) {
+            // Two NULLs in a row mean that nothing more is available.
+            if (end_of_query) {
+                break;
+            }
+            end_of_query = true;
+            continue;
+        }
+        end_of_query = false;
+        if (PQresultStatus(r) == PGRES_PIPELINE_SYNC) {
+            PQclear(r);
+            completeAsyncQuery();
+            continue;
+        }
+#else
+        // The results of the query are followed by NULL.
+        if (r == NULL) {
+            completeAsyncQuery();
+            sendNextAsyncQuery();
+            continue;
+        }
+#endif
+        // Only the first result is relevant for the lease queries.
+        AsyncQuery& query = async_queries_.front();
+        if (query.result_ == NULL) {
+            query.result_ = r;
+        } else {
+            PQclear(r);
+        }
+    }
+}
+
+namespace {
+
+/// @brief Returns the lease from the result of the asynchronous query.
+///
+/// @param r Result of the query
+/// @param exchange Exchange object converting the lease
+/// @param [out] lease Returned lease or NULL if the query returned no rows
+///
+/// @throw isc::dhcp::DbOperationError if the query has failed.
+/// @throw isc::dhcp::MultipleRecords if more than one lease was returned.
+template<typename Exchange, typename LeasePtr>
+void getAsyncLease(PGresult* r, Exchange& exchange, LeasePtr& lease) {
+    if (r == NULL) {
+        isc_throw(DbOperationError, "no result received");
+    }
+    if (PQresultStatus(r) != PGRES_TUPLES_OK) {
+        isc_throw(DbOperationError, PQresultErrorMessage(r));
+    }
+    const int rows = PQntuples(r);
+    if (rows > 1) {
+        isc_throw(MultipleRecords, "multiple records were found in the "
+                  "database where only one was expected");
+    }
+    if (rows == 1) {
+        lease = exchange->convertFromDatabase(r, 0);
+    }
+}
+
+}
+
+void
+PgSqlLeaseMgr::handleAsyncLease4(PGresult* r, const std::string& error,
+                                 const Lease4Callback& callback) {
+    Lease4Ptr lease;
+    std::string message = error;
+    if (message.empty()) {
+        try {
+            getAsyncLease(r, async_conn_->exchange4_, lease);
+        } catch (const std::exception& ex) {
+            message = ex.what();
+        }
+    }
+    callback(lease, message);
+}
+
+void
+PgSqlLeaseMgr::handleAsyncLease6(PGresult* r, const std::string& error,
+                                 const Lease6Callback& callback) {
+    Lease6Ptr lease;
+    std::string message = error;
+    if (message.empty()) {
+        try {
+            getAsyncLease(r, async_conn_->exchange6_, lease);
+        } catch (const std::exception& ex) {
+            message = ex.what();
+        }
+    }
+    callback(lease, message);
+}
+
+void
+PgSqlLeaseMgr::handleAsyncAdd(PGresult* r, const std::string& error,
+                              const ResultCallback& callback) {
+    if (!error.empty()) {
+        callback(false, error);
+    } else if (r == NULL) {
+        callback(false, "no result received");
+    } else if (PQresultStatus(r) == PGRES_COMMAND_OK) {
+        callback(true, "");
+    } else if (compareError(r, DUPLICATE_KEY)) {
+        callback(false, "");
+    } else {
+        callback(false, PQresultErrorMessage(r));
+    }
+}
+
+void
+PgSqlLeaseMgr::handleAsyncModify(PGresult* r, const std::string& error,
+                                 const ResultCallback& callback) {
+    if (!error.empty()) {
+        callback(false, error);
+    } else if (r == NULL) {
+        callback(false, "no result received");
+    } else if (PQresultStatus(r) != PGRES_COMMAND_OK) {
+        callback(false, PQresultErrorMessage(r));
+    } else {
+        callback(boost::lexical_cast<int>(PQcmdTuples(r)) > 0, "");
+    }
+}
+
+void
+PgSqlLeaseMgr::asyncGetLease4(const isc::asiolink::IOAddress& addr,
+                              const Lease4Callback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_ADDR4).arg(addr.toText());
+
+    PsqlBindArray bind_array;
+    std::string addr_str = boost::lexical_cast<std::string>
+                           (static_cast<uint32_t>(addr));
+    bind_array.add(addr_str);
+
+    startAsyncQuery(GET_LEASE4_ADDR, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncLease4, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                              const Lease4Callback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_SUBID_HWADDR)
+              .arg(subnet_id).arg(hwaddr.toText());
+
+    PsqlBindArray bind_array;
+    if (!hwaddr.hwaddr_.empty()) {
+        bind_array.add(hwaddr.hwaddr_);
+    } else {
+        bind_array.add("");
+    }
+    std::string subnet_id_str = boost::lexical_cast<std::string>(subnet_id);
+    bind_array.add(subnet_id_str);
+
+    startAsyncQuery(GET_LEASE4_HWADDR_SUBID, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncLease4, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                              const Lease4Callback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_SUBID_CLIENTID)
+              .arg(subnet_id).arg(clientid.toText());
+
+    PsqlBindArray bind_array;
+    bind_array.add(clientid.getClientId());
+    std::string subnet_id_str = boost::lexical_cast<std::string>(subnet_id);
+    bind_array.add(subnet_id_str);
+
+    startAsyncQuery(GET_LEASE4_CLIENTID_SUBID, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncLease4, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncGetLease6(Lease::Type lease_type,
+                              const isc::asiolink::IOAddress& addr,
+                              const Lease6Callback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_PGSQL_GET_ADDR6)
+              .arg(addr.toText()).arg(lease_type);
+
+    PsqlBindArray bind_array;
+    std::string addr_str = addr.toText();
+    bind_array.add(addr_str);
+    std::string type_str = boost::lexical_cast<std::string>(lease_type);
+    bind_array.add(type_str);
+
+    startAsyncQuery(GET_LEASE6_ADDR, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncLease6, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncAddLease(const Lease4Ptr& lease,
+                             const ResultCallback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_ADD_ADDR4).arg(lease->addr_.toText());
+
+    // The exchange object holds the bound values until they are copied.
+    PsqlBindArray bind_array;
+    getAsyncConnection().exchange4_->createBindForSend(lease, bind_array);
+    startAsyncQuery(INSERT_LEASE4, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncAdd, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncAddLease(const Lease6Ptr& lease,
+                             const ResultCallback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_ADD_ADDR6).arg(lease->addr_.toText());
+
+    PsqlBindArray bind_array;
+    getAsyncConnection().exchange6_->createBindForSend(lease, bind_array);
+    startAsyncQuery(INSERT_LEASE6, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncAdd, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncUpdateLease4(const Lease4Ptr& lease,
+                                 const ResultCallback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_UPDATE_ADDR4).arg(lease->addr_.toText());
+
+    PsqlBindArray bind_array;
+    getAsyncConnection().exchange4_->createBindForSend(lease, bind_array);
+    std::string addr4_str = boost::lexical_cast<std::string>
+                            (static_cast<uint32_t>(lease->addr_));
+    bind_array.add(addr4_str);
+    startAsyncQuery(UPDATE_LEASE4, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncModify, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncUpdateLease6(const Lease6Ptr& lease,
+                                 const ResultCallback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_UPDATE_ADDR6).arg(lease->addr_.toText());
+
+    PsqlBindArray bind_array;
+    getAsyncConnection().exchange6_->createBindForSend(lease, bind_array);
+    std::string addr_str = lease->addr_.toText();
+    bind_array.add(addr_str);
+    startAsyncQuery(UPDATE_LEASE6, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncModify, this,
+                                _1, _2, callback));
+}
+
+void
+PgSqlLeaseMgr::asyncDeleteLease(const isc::asiolink::IOAddress& addr,
+                                const ResultCallback& callback) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_DELETE_ADDR).arg(addr.toText());
+
+    PsqlBindArray bind_array;
+    std::string addr_str = addr.isV4() ?
+        boost::lexical_cast<std::string>(static_cast<uint32_t>(addr)) :
+        addr.toText();
+    bind_array.add(addr_str);
+    startAsyncQuery(addr.isV4() ? DELETE_LEASE4 : DELETE_LEASE6, bind_array,
+                    boost::bind(&PgSqlLeaseMgr::handleAsyncModify, this,
+                                _1, _2, callback));
+}
+
 }; // end of isc::dhcp namespace
 }; // end of isc namespace
@@ -16,12 +16,16 @@
 #define PGSQL_LEASE_MGR_H
 
 #include <dhcp/hwaddr.h>
+#include <dhcpsrv/db_connection_pool.h>
 #include <dhcpsrv/lease_mgr.h>
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
 #include <libpq-fe.h>
 
+#include <deque>
+#include <string>
 #include <vector>
 
 namespace isc {
@@ -111,6 +115,7 @@ struct PsqlBindArray {
 // See pgsql_lease_mgr.cc file for actual class definitions
 class PgSqlLease4Exchange;
 class PgSqlLease6Exchange;
+class PgSqlConnection;
 
 /// Defines PostgreSQL backend version: 1.0
 const uint32_t PG_CURRENT_VERSION = 1;
@@ -132,12 +137,17 @@ public:
     /// - host - Host to which to connect (optional, defaults to "localhost")
     /// - user - Username under which to connect (optional)
     /// - password - Password for "user" on the database (optional)
+    /// - connections - Number of connections to the database (optional,
+    ///   defaults to 1)
     ///
     /// If the database is successfully opened, the version number in the
     /// schema_version table will be checked against hard-coded value in
     /// the implementation file.
     ///
-    /// Finally, all the SQL commands are pre-compiled.
+    /// Finally, all the SQL commands are pre-compiled.  The statements are
+    /// prepared separately for each connection, so as the lease operations
+    /// invoked by different threads can run concurrently, each on its own
+    /// connection.
     ///
     /// @param parameters A data structure relating keywords and values
     ///        concerned with the database.
@@ -265,6 +275,19 @@ public:
     virtual Lease4Ptr getLease4(const ClientId& clientid,
                                 SubnetID subnet_id) const;
 
+    /// @brief Returns all IPv4 leases belonging to a subnet.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    ///
+    /// @throw isc::dhcp::DataTruncation Data was truncated on retrieval to
+    ///        fit into the space allocated for the result.  This indicates a
+    ///        programming error.
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease4Collection getLeases4(SubnetID subnet_id) const;
+
     /// @brief Returns existing IPv6 lease for a given IPv6 address.
     ///
     /// For a given address, we assume that there will be only one lease.
@@ -319,6 +342,47 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns all IPv6 leases belonging to a subnet.
+    ///
+    /// @param subnet_id identifier of the subnet that leases must belong to
+    ///
+    /// @return lease collection (may be empty if no lease is found)
+    ///
+    /// @throw isc::BadValue record retrieved from database had an invalid
+    ///        lease type field.
+    /// @throw isc::dhcp::DataTruncation Data was truncated on retrieval to
+    ///        fit into the space allocated for the result.  This indicates a
+    ///        programming error.
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease6Collection getLeases6(SubnetID subnet_id) const;
+
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are selected using the index on the "expire" column.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// @param [out] expired_leases Collection to which the expired leases
+    ///        are appended.
+    /// @param max_leases Maximum number of leases to be returned. The value
+    ///        of 0 means that all expired leases are returned.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// Updates the record of the lease in the database (as identified by the
@@ -356,6 +420,18 @@ public:
     ///        failed.
     virtual bool deleteLease(const isc::asiolink::IOAddress& addr);
 
+    /// @brief Deletes a lease if it has expired.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be IPv4 or
+    ///        IPv6.)
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    ///         or it has not expired.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual bool deleteExpiredLease(const isc::asiolink::IOAddress& addr);
+
     /// @brief Return backend type
     ///
     /// Returns the type of the backend (e.g. "mysql", "memfile" etc.)
@@ -388,18 +464,83 @@ public:
 
     /// @brief Commit Transactions
     ///
-    /// Commits all pending database operations.
+    /// Commits all pending database operations.  The statements are run
+    /// in the autocommit mode, so this is issued on any connection of the
+    /// pool.
     ///
     /// @throw DbOperationError Iif the commit failed.
     virtual void commit();
 
     /// @brief Rollback Transactions
     ///
-    /// Rolls back all pending database operations.
+    /// Rolls back all pending database operations.  The statements are run
+    /// in the autocommit mode, so this is issued on any connection of the
+    /// pool.
     ///
     /// @throw DbOperationError If the rollback failed.
     virtual void rollback();
 
+    /// @name Asynchronous lease operations
+    ///
+    /// The asynchronous operations are sent over a separate connection,
+    /// which is opened on first use and runs in the non-blocking mode.
+    /// When the PostgreSQL client library supports pipelining, all queries
+    /// are sent to the server as soon as they are started and the server
+    /// processes them while the results of the preceding queries are
+    /// being received. Otherwise, the queries are queued and sent one at a
+    /// time. Each query is followed by a synchronization point, so it runs
+    /// in its own transaction and its failure doesn't affect other queries.
+    ///
+    /// If the connection fails, all outstanding operations fail and the
+    /// connection is reopened by the next operation.
+    ///
+    /// @throw isc::dhcp::DbOpenError if the connection can't be opened.
+    //@{
+
+    virtual void asyncGetLease4(const isc::asiolink::IOAddress& addr,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease4(const HWAddr& hwaddr, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease4(const ClientId& clientid, SubnetID subnet_id,
+                                const Lease4Callback& callback);
+
+    virtual void asyncGetLease6(Lease::Type type,
+                                const isc::asiolink::IOAddress& addr,
+                                const Lease6Callback& callback);
+
+    virtual void asyncAddLease(const Lease4Ptr& lease,
+                               const ResultCallback& callback);
+
+    virtual void asyncAddLease(const Lease6Ptr& lease,
+                               const ResultCallback& callback);
+
+    virtual void asyncUpdateLease4(const Lease4Ptr& lease4,
+                                   const ResultCallback& callback);
+
+    virtual void asyncUpdateLease6(const Lease6Ptr& lease6,
+                                   const ResultCallback& callback);
+
+    virtual void asyncDeleteLease(const isc::asiolink::IOAddress& addr,
+                                  const ResultCallback& callback);
+
+    /// @brief Returns the socket of the asynchronous connection.
+    ///
+    /// Opens the connection if it isn't open yet.
+    virtual int getAsyncSocket();
+
+    /// @brief Receives the available results and invokes the callbacks of
+    /// the completed operations.
+    virtual void processAsyncResults();
+
+    /// @brief Returns the number of the outstanding asynchronous operations.
+    virtual size_t getAsyncPendingCount() const {
+        return (async_queries_.size());
+    }
+
+    //@}
+
     /// @brief Checks a result set's SQL state against an error state.
     ///
     /// @param r result set to check
@@ -416,14 +557,20 @@ public:
     enum StatementIndex {
         DELETE_LEASE4,              // Delete from lease4 by address
         DELETE_LEASE6,              // Delete from lease6 by address
+        DELETE_EXPIRED_LEASE4,      // Delete expired lease4 by address
+        DELETE_EXPIRED_LEASE6,      // Delete expired lease6 by address
         GET_LEASE4_ADDR,            // Get lease4 by address
         GET_LEASE4_CLIENTID,        // Get lease4 by client ID
         GET_LEASE4_CLIENTID_SUBID,  // Get lease4 by client ID & subnet ID
+        GET_LEASE4_EXPIRE,          // Get expired lease4
         GET_LEASE4_HWADDR,          // Get lease4 by HW address
         GET_LEASE4_HWADDR_SUBID,    // Get lease4 by HW address & subnet ID
+        GET_LEASE4_SUBID,           // Get lease4 by subnet ID
         GET_LEASE6_ADDR,            // Get lease6 by address
         GET_LEASE6_DUID_IAID,       // Get lease6 by DUID and IAID
         GET_LEASE6_DUID_IAID_SUBID, // Get lease6 by DUID, IAID and subnet ID
+        GET_LEASE6_EXPIRE,          // Get expired lease6
+        GET_LEASE6_SUBID,           // Get lease6 by subnet ID
         GET_VERSION,                // Obtain version number
         INSERT_LEASE4,              // Add entry to lease4 table
         INSERT_LEASE6,              // Add entry to lease6 table
@@ -433,26 +580,90 @@ public:
     };
 
 private:
+    /// @brief Pool of the connections to the database.
+    typedef DbConnectionPool<PgSqlConnection> ConnectionPool;
+
+    /// @brief Function processing the result of the asynchronous query.
+    ///
+    /// The first argument is the result of the query, which may be NULL if
+    /// the query has failed. The second argument is the error message if
+    /// the query has failed or an empty string otherwise.
+    typedef boost::function<void(PGresult*, const std::string&)> AsyncHandler;
+
+    /// @brief Asynchronous query waiting for its result.
+    ///
+    /// The query holds copies of its parameters, as it may be sent after
+    /// the values bound by the caller are gone.
+    struct AsyncQuery {
+        /// @brief Index of the prepared statement.
+        StatementIndex stindex_;
+
+        /// @brief Values of the parameters.
+        std::vector<std::string> values_;
+
+        /// @brief Lengths of the parameters.
+        std::vector<int> lengths_;
+
+        /// @brief Formats of the parameters.
+        std::vector<int> formats_;
+
+        /// @brief Function processing the result.
+        AsyncHandler handler_;
+
+        /// @brief First result received for the query or NULL.
+        PGresult* result_;
+
+        /// @brief Indicates if the query has been sent to the server.
+        bool sent_;
+    };
+
+    /// @brief Opens a new connection to the database
+    ///
+    /// Opens the database and prepares all statements.  It is used by the
+    /// connection pool to open the connections, initially and after
+    /// a connection has been lost.
+    ///
+    /// @return Pointer to the opened connection.
+    ///
+    /// @throw NoDatabaseName Mandatory database name not given
+    /// @throw DbOpenError Error opening the database
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    boost::shared_ptr<PgSqlConnection> openConnection();
+
+    /// @brief Checks if the connection to the database is still usable
+    ///
+    /// It is used by the connection pool to verify the connection after
+    /// a failed operation or a period of inactivity.
+    ///
+    /// @param conn Connection to be checked.
+    ///
+    /// @return true if the server responds, false otherwise.
+    static bool checkConnection(PgSqlConnection& conn);
 
     /// @brief Prepare statements
     ///
     /// Creates the prepared statements for all of the SQL statements used
     /// by the PostgreSQL backend.
     ///
+    /// @param conn Connection for which the statements are prepared.
+    ///
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     /// @throw isc::InvalidParameter 'index' is not valid for the vector.  This
     ///        represents an internal error within the code.
-    void prepareStatements();
+    void prepareStatements(PgSqlConnection& conn);
 
     /// @brief Open Database
     ///
     /// Opens the database using the information supplied in the parameters
     /// passed to the constructor.
     ///
+    /// @param conn Connection on which the database is opened.
+    ///
     /// @throw NoDatabaseName Mandatory database name not given
     /// @throw DbOpenError Error opening the database
-    void openDatabase();
+    void openDatabase(PgSqlConnection& conn);
 
     /// @brief Add Lease Common Code
     ///
@@ -460,6 +671,7 @@ private:
     /// of the addLease method.  It binds the contents of the lease object to
     /// the prepared statement and adds it to the database.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind_array array that has been created for the type
     ///        of lease in question.
@@ -469,13 +681,15 @@ private:
     ///
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool addLeaseCommon(StatementIndex stindex, PsqlBindArray& bind_array);
+    bool addLeaseCommon(PgSqlConnection& conn, StatementIndex stindex,
+                        PsqlBindArray& bind_array);
 
     /// @brief Get Lease Collection Common Code
     ///
     /// This method performs the common actions for obtaining multiple leases
     /// from the database.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind_array array containing the where clause input parameters
     /// @param exchange Exchange object to use
@@ -492,8 +706,9 @@ private:
     /// @throw isc::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
     template <typename Exchange, typename LeaseCollection>
-    void getLeaseCollection(StatementIndex stindex, PsqlBindArray& bind_array,
-                            Exchange& exchange, LeaseCollection& result,
+    void getLeaseCollection(PgSqlConnection& conn, StatementIndex stindex,
+                            PsqlBindArray& bind_array, Exchange& exchange,
+                            LeaseCollection& result,
                             bool single = false) const;
 
     /// @brief Gets Lease4 Collection
@@ -501,6 +716,7 @@ private:
     /// Gets a collection of Lease4 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind_array array containing the where clause input parameters
     /// @param lease LeaseCollection object returned.  Note that any leases in
@@ -512,16 +728,16 @@ private:
     ///        failed.
     /// @throw isc::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, PsqlBindArray& bind_array,
-                            Lease4Collection& result) const {
-        getLeaseCollection(stindex, bind_array, exchange4_, result);
-    }
+    void getLeaseCollection(PgSqlConnection& conn, StatementIndex stindex,
+                            PsqlBindArray& bind_array,
+                            Lease4Collection& result) const;
 
     /// @brief Get Lease6 Collection
     ///
     /// Gets a collection of Lease6 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind_array array containing input parameters for the query
     /// @param lease LeaseCollection object returned.  Note that any existing
@@ -532,21 +748,39 @@ private:
     ///        failed.
     /// @throw isc::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, PsqlBindArray& bind_array,
-                            Lease6Collection& result) const {
-        getLeaseCollection(stindex, bind_array, exchange6_, result);
-    }
+    void getLeaseCollection(PgSqlConnection& conn, StatementIndex stindex,
+                            PsqlBindArray& bind_array,
+                            Lease6Collection& result) const;
+
+    /// @brief Get expired leases
+    ///
+    /// Common code for the getExpiredLeases4() and getExpiredLeases6()
+    /// methods. It selects the leases which expired before the current
+    /// time, ordered by the expiration time.
+    ///
+    /// @param conn Connection on which the statement is executed.
+    /// @param stindex Index of statement being executed
+    /// @param max_leases Maximum number of leases to be returned (0 means
+    ///        no limit).
+    /// @param [out] expired_leases Collection to which the leases are
+    ///        appended.
+    template <typename LeaseCollection>
+    void getExpiredLeasesCommon(PgSqlConnection& conn, StatementIndex stindex,
+                                const size_t max_leases,
+                                LeaseCollection& expired_leases) const;
 
     /// @brief Checks result of the r object
     ///
     /// Checks status of the operation passed as first argument and throws
     /// DbOperationError with details if it is non-success.
     ///
+    /// @param conn Connection on which the operation was performed
     /// @param r result of the last PostgreSQL operation
     /// @param index will be used to print out compiled statement name
     ///
     /// @throw isc::dhcp::DbOperationError Detailed PostgreSQL failure
-    void checkStatementError(PGresult*& r, StatementIndex index) const;
+    void checkStatementError(PgSqlConnection& conn, PGresult*& r,
+                             StatementIndex index) const;
 
     /// @brief Get Lease4 Common Code
     ///
@@ -554,11 +788,12 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind_array array containing input parameters for the query
     /// @param lease Lease4 object returned
-    void getLease(StatementIndex stindex, PsqlBindArray& bind_array,
-                  Lease4Ptr& result) const;
+    void getLease(PgSqlConnection& conn, StatementIndex stindex,
+                  PsqlBindArray& bind_array, Lease4Ptr& result) const;
 
     /// @brief Get Lease6 Common Code
     ///
@@ -566,11 +801,12 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of statement being executed
     /// @param bind_array array containing input parameters for the query
     /// @param lease Lease6 object returned
-    void getLease(StatementIndex stindex, PsqlBindArray& bind_array,
-                  Lease6Ptr& result) const;
+    void getLease(PgSqlConnection& conn, StatementIndex stindex,
+                  PsqlBindArray& bind_array, Lease6Ptr& result) const;
 
 
     /// @brief Update lease common code
@@ -579,6 +815,7 @@ private:
     /// to the prepared statement, executes it, then checks how many rows
     /// were affected.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of prepared statement to be executed
     /// @param bind_array array containing lease values and where clause
     /// parameters for the update.
@@ -589,8 +826,8 @@ private:
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     template <typename LeasePtr>
-    void updateLeaseCommon(StatementIndex stindex, PsqlBindArray& bind_array,
-                           const LeasePtr& lease);
+    void updateLeaseCommon(PgSqlConnection& conn, StatementIndex stindex,
+                           PsqlBindArray& bind_array, const LeasePtr& lease);
 
     /// @brief Delete lease common code
     ///
@@ -598,6 +835,7 @@ private:
     /// to the prepared statement, executes the statement and checks to
     /// see how many rows were deleted.
     ///
+    /// @param conn Connection on which the statement is executed.
     /// @param stindex Index of prepared statement to be executed
     /// @param bind_array array containing lease values and where clause
     /// parameters for the delete
@@ -607,17 +845,103 @@ private:
     ///
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool deleteLeaseCommon(StatementIndex stindex, PsqlBindArray& bind_array);
+    bool deleteLeaseCommon(PgSqlConnection& conn, StatementIndex stindex,
+                           PsqlBindArray& bind_array);
+
+    /// @brief Returns the connection used by the asynchronous operations.
+    ///
+    /// Opens the connection, switches it to the non-blocking mode and, if
+    /// supported, to the pipeline mode if it isn't open yet.
+    ///
+    /// @throw isc::dhcp::DbOpenError if the connection can't be opened.
+    PgSqlConnection& getAsyncConnection();
+
+    /// @brief Closes the connection used by the asynchronous operations.
+    void closeAsyncConnection();
+
+    /// @brief Starts the asynchronous query.
+    ///
+    /// Copies the parameters and sends the query, unless it must wait for
+    /// the preceding queries to complete.
+    ///
+    /// @param stindex Index of the prepared statement
+    /// @param bind_array Parameters of the statement
+    /// @param handler Function processing the result
+    void startAsyncQuery(StatementIndex stindex, PsqlBindArray& bind_array,
+                         const AsyncHandler& handler);
+
+    /// @brief Sends the asynchronous query to the server.
+    ///
+    /// Blocks only if the socket buffer can't hold the query.
+    ///
+    /// @param query Query to be sent
+    ///
+    /// @return true if the query has been sent, false if the connection
+    /// has failed.
+    bool sendAsyncQuery(AsyncQuery& query);
+
+    /// @brief Sends the first query in the queue if it hasn't been sent.
+    ///
+    /// Fails all outstanding queries if the connection has failed.
+    void sendNextAsyncQuery();
+
+    /// @brief Removes the first query from the queue and passes its result
+    /// to the handler.
+    void completeAsyncQuery();
+
+    /// @brief Fails all outstanding queries and closes the connection.
+    ///
+    /// @param error Error message passed to the handlers.
+    void failAsyncQueries(const std::string& error);
+
+    /// @brief Passes the lease returned by the query to the callback.
+    ///
+    /// @param r Result of the query
+    /// @param error Error message or an empty string
+    /// @param callback Function receiving the lease
+    void handleAsyncLease4(PGresult* r, const std::string& error,
+                           const Lease4Callback& callback);
+
+    /// @brief Passes the lease returned by the query to the callback.
+    ///
+    /// @param r Result of the query
+    /// @param error Error message or an empty string
+    /// @param callback Function receiving the lease
+    void handleAsyncLease6(PGresult* r, const std::string& error,
+                           const Lease6Callback& callback);
+
+    /// @brief Passes the result of the INSERT to the callback.
+    ///
+    /// The duplicate key error is reported as the lease which hasn't been
+    /// added, rather than as an error.
+    ///
+    /// @param r Result of the query
+    /// @param error Error message or an empty string
+    /// @param callback Function receiving the result
+    void handleAsyncAdd(PGresult* r, const std::string& error,
+                        const ResultCallback& callback);
+
+    /// @brief Passes the result of the UPDATE or DELETE to the callback.
+    ///
+    /// @param r Result of the query
+    /// @param error Error message or an empty string
+    /// @param callback Function receiving the result, i.e. true if any row
+    /// has been affected.
+    void handleAsyncModify(PGresult* r, const std::string& error,
+                           const ResultCallback& callback);
+
+    /// Pool of the connections to the database.  Each connection holds its
+    /// own prepared statements and exchange objects, used for transfer of
+    /// data to/from the database.
+    boost::scoped_ptr<ConnectionPool> pool_;
 
-    /// The exchange objects are used for transfer of data to/from the database.
-    /// They are pointed-to objects as the contents may change in "const" calls,
-    /// while the rest of this object does not.  (At alternative would be to
-    /// declare them as "mutable".)
-    boost::scoped_ptr<PgSqlLease4Exchange> exchange4_; ///< Exchange object
-    boost::scoped_ptr<PgSqlLease6Exchange> exchange6_; ///< Exchange object
+    /// Connection used by the asynchronous operations or NULL if it is not
+    /// open.
+    boost::shared_ptr<PgSqlConnection> async_conn_;
 
-    /// PostgreSQL connection handle
-    PGconn* conn_;
+    /// Asynchronous queries waiting for their results, in the order in
+    /// which they have been started.
+    std::deque<AsyncQuery> async_queries_;
 };
 
 }; // end of isc::dhcp namespace
@@ -17,6 +17,7 @@
 
 #include <asiolink/io_address.h>
 #include <boost/shared_ptr.hpp>
+#include <dhcpsrv/free_address_bitmap.h>
 #include <dhcpsrv/lease.h>
 
 #include <vector>
@@ -60,6 +61,16 @@ public:
     /// @return true, if the address is in pool
     bool inRange(const isc::asiolink::IOAddress& addr) const;
 
+    /// @brief Returns the number of addresses (prefixes) in the pool.
+    ///
+    /// For the pools holding more than 2^64 - 1 addresses (prefixes), the
+    /// maximum value of the uint64_t is returned.
+    ///
+    /// @return number of addresses (prefixes) in the pool
+    uint64_t getCapacity() const {
+        return (capacity_);
+    }
+
     /// @brief Returns pool type (v4, v6 non-temporary, v6 temp, v6 prefix)
     /// @return returns pool type
     Lease::Type getType() const {
@@ -71,6 +82,24 @@ public:
     /// @return textual representation
     virtual std::string toText() const;
 
+    /// @brief Returns the bitmap of free addresses in this pool.
+    ///
+    /// The bitmap is created by the allocation engine when the free
+    /// address tracking is enabled.
+    ///
+    /// @return pointer to the bitmap or NULL if the free addresses are not
+    /// tracked for this pool
+    FreeAddressBitmapPtr getFreeAddresses() const {
+        return (free_addresses_);
+    }
+
+    /// @brief Sets the bitmap of free addresses in this pool.
+    ///
+    /// @param free_addresses pointer to the bitmap
+    void setFreeAddresses(const FreeAddressBitmapPtr& free_addresses) {
+        free_addresses_ = free_addresses;
+    }
+
     /// @brief virtual destructor
     ///
     /// We need Pool to be a polymorphic class, so we could dynamic cast
@@ -113,6 +142,9 @@ protected:
     /// @brief The last address in a pool
     isc::asiolink::IOAddress last_;
 
+    /// @brief Number of addresses (prefixes) in the pool
+    uint64_t capacity_;
+
     /// @brief Comments field
     ///
     /// @todo: This field is currently not used.
@@ -120,6 +152,9 @@ protected:
 
     /// @brief defines a lease type that will be served from this pool
     Lease::Type type_;
+
+    /// @brief Bitmap of free addresses in this pool (may be NULL).
+    FreeAddressBitmapPtr free_addresses_;
 };
 
 /// @brief Pool information for IPv4 addresses
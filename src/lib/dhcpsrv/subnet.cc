@@ -17,10 +17,24 @@
 #include <dhcpsrv/addr_utilities.h>
 #include <dhcpsrv/subnet.h>
 
+#include <algorithm>
 #include <sstream>
 
 using namespace isc::asiolink;
 
+namespace {
+
+/// @brief Compares the code of the packed option with the option code.
+///
+/// This function is used to search the packed options of the subnet,
+/// which are sorted by option code.
+bool
+packedOptionCodeLess(const isc::dhcp::PackedOption& packed, uint16_t code) {
+    return (packed.option->getType() < code);
+}
+
+}
+
 namespace isc {
 namespace dhcp {
 
@@ -70,6 +84,37 @@ Subnet::addOption(const OptionPtr& option, bool persistent,
 
     // Actually add new option descriptor.
     option_spaces_.addItem(OptionDescriptor(option, persistent), option_space);
+
+    // Pack the option of the DHCP option space. If there are several
+    // options with this code, the one returned by the getOptionDescriptor
+    // is held.
+    if (option_space != (option->getUniverse() == Option::V4 ?
+                         "dhcp4" : "dhcp6")) {
+        return;
+    }
+    PackedOption packed;
+    packed.option = getOptionDescriptor(option_space,
+                                        option->getType()).option;
+    PackedOptionCollection::iterator it =
+        std::lower_bound(packed_options_.begin(), packed_options_.end(),
+                         option->getType(), packedOptionCodeLess);
+    if ((it != packed_options_.end()) &&
+        (it->option->getType() == option->getType())) {
+        if (it->option == packed.option) {
+            return;
+        }
+        it = packed_options_.erase(it);
+    }
+    try {
+        isc::util::OutputBuffer buf(0);
+        packed.option->pack(buf);
+        const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+        packed.wire.reset(new OptionBuffer(data, data + buf.getLength()));
+    } catch (const Exception&) {
+        // The option will be packed when it is sent, which reports the
+        // error then.
+    }
+    packed_options_.insert(it, packed);
 }
 
 void
@@ -102,6 +147,7 @@ Subnet::allowClientClass(const isc::dhcp::ClientClass& class_name) {
 void
 Subnet::delOptions() {
     option_spaces_.clearItems();
+    packed_options_.clear();
 }
 
 Subnet::OptionContainerPtr
@@ -125,6 +171,18 @@ Subnet::getOptionDescriptor(const std::string& option_space,
     return (*range.first);
 }
 
+PackedOption
+Subnet::getPackedOption(const uint16_t option_code) const {
+    PackedOptionCollection::const_iterator it =
+        std::lower_bound(packed_options_.begin(), packed_options_.end(),
+                         option_code, packedOptionCodeLess);
+    if ((it == packed_options_.end()) ||
+        (it->option->getType() != option_code)) {
+        return (PackedOption());
+    }
+    return (*it);
+}
+
 void Subnet::addVendorOption(const OptionPtr& option, bool persistent,
                              uint32_t vendor_id){
 
@@ -270,29 +328,91 @@ PoolCollection& Subnet::getPoolsWritable(Lease::Type type) {
     }
 }
 
-const PoolPtr Subnet::getPool(Lease::Type type, const isc::asiolink::IOAddress& hint,
-                        bool anypool /* true */) const {
+const Subnet::PoolIndex&
+Subnet::getPoolIndex(Lease::Type type) const {
     // check if the type is valid (and throw if it isn't)
     checkType(type);
 
-    const PoolCollection& pools = getPools(type);
+    switch (type) {
+    case Lease::TYPE_V4:
+    case Lease::TYPE_NA:
+        return (pool_index_);
+    case Lease::TYPE_TA:
+        return (pool_index_ta_);
+    case Lease::TYPE_PD:
+        return (pool_index_pd_);
+    default:
+        isc_throw(BadValue, "Unsupported pool type: "
+                  << static_cast<int>(type));
+    }
+}
+
+Subnet::PoolIndex&
+Subnet::getPoolIndexWritable(Lease::Type type) {
+    // check if the type is valid (and throw if it isn't)
+    checkType(type);
 
-    PoolPtr candidate;
-    for (PoolCollection::const_iterator pool = pools.begin();
-         pool != pools.end(); ++pool) {
+    switch (type) {
+    case Lease::TYPE_V4:
+    case Lease::TYPE_NA:
+        return (pool_index_);
+    case Lease::TYPE_TA:
+        return (pool_index_ta_);
+    case Lease::TYPE_PD:
+        return (pool_index_pd_);
+    default:
+        isc_throw(BadValue, "Invalid pool type specified: "
+                  << static_cast<int>(type));
+    }
+}
 
-        // if we won't find anything better, then let's just use the first pool
-        if (anypool && !candidate) {
-            candidate = *pool;
+PoolPtr
+Subnet::findPool(Lease::Type type, const isc::asiolink::IOAddress& addr) const {
+    const PoolIndex& index = getPoolIndex(type);
+
+    // Find the first pool starting above the address. Only the pools
+    // preceding it may hold the address.
+    PoolIndex::const_iterator entry =
+        std::upper_bound(index.begin(), index.end(), addr,
+                         &PoolIndexEntry::lessThanFirst);
+
+    // Walk back over the pools which may hold the address. Unless the pools
+    // overlap, this stops at the first visited pool. For overlapping pools,
+    // the one which was added first wins.
+    size_t position = index.size();
+    while (entry != index.begin()) {
+        --entry;
+        if (entry->max_last_.lessThan(addr)) {
+            break;
+        }
+        if (addr.smallerEqual(entry->last_) && (entry->position_ < position)) {
+            position = entry->position_;
         }
+    }
 
-        // if the client provided a pool and there's a pool that hint is valid
-        // in, then let's use that pool
-        if ((*pool)->inRange(hint)) {
-            return (*pool);
+    if (position == index.size()) {
+        return (PoolPtr());
+    }
+    return (getPools(type)[position]);
+}
+
+const PoolPtr Subnet::getPool(Lease::Type type, const isc::asiolink::IOAddress& hint,
+                        bool anypool /* true */) const {
+    // check if the type is valid (and throw if it isn't)
+    checkType(type);
+
+    // if the client provided a pool and there's a pool that hint is valid
+    // in, then let's use that pool
+    PoolPtr pool = findPool(type, hint);
+
+    // if we won't find anything better, then let's just use the first pool
+    if (!pool && anypool) {
+        const PoolCollection& pools = getPools(type);
+        if (!pools.empty()) {
+            pool = pools.front();
         }
     }
-    return (candidate);
+    return (pool);
 }
 
 void
@@ -312,12 +432,31 @@ Subnet::addPool(const PoolPtr& pool) {
     checkType(pool->getType());
 
     // Add the pool to the appropriate pools collection
-    getPoolsWritable(pool->getType()).push_back(pool);
+    PoolCollection& pools = getPoolsWritable(pool->getType());
+    pools.push_back(pool);
+
+    // Insert the pool into the index, after the pools starting at the same
+    // address, and update the highest last addresses from there on.
+    PoolIndex& index = getPoolIndexWritable(pool->getType());
+    const PoolIndexEntry new_entry = { first_addr, last_addr, last_addr,
+                                       pools.size() - 1 };
+    PoolIndex::iterator entry =
+        index.insert(std::upper_bound(index.begin(), index.end(), first_addr,
+                                      &PoolIndexEntry::lessThanFirst),
+                     new_entry);
+    for (; entry != index.end(); ++entry) {
+        if (entry != index.begin()) {
+            const IOAddress& previous = (entry - 1)->max_last_;
+            entry->max_last_ = entry->last_.lessThan(previous) ? previous :
+                entry->last_;
+        }
+    }
 }
 
 void
 Subnet::delPools(Lease::Type type) {
     getPoolsWritable(type).clear();
+    getPoolIndexWritable(type).clear();
 }
 
 void
@@ -349,16 +488,8 @@ Subnet::inPool(Lease::Type type, const isc::asiolink::IOAddress& addr) const {
         return (false);
     }
 
-    const PoolCollection& pools = getPools(type);
-
-    for (PoolCollection::const_iterator pool = pools.begin();
-         pool != pools.end(); ++pool) {
-        if ((*pool)->inRange(addr)) {
-            return (true);
-        }
-    }
-    // There's no pool that address belongs to
-    return (false);
+    // Check if there's a pool that the address belongs to
+    return (static_cast<bool>(findPool(type, addr)));
 }
 
 Subnet6::Subnet6(const isc::asiolink::IOAddress& prefix, uint8_t length,
@@ -274,6 +274,24 @@ public:
     getOptionDescriptor(const std::string& option_space,
                         const uint16_t option_code);
 
+    /// @brief Return single option of the DHCP option space along with
+    /// its on-wire format.
+    ///
+    /// The options of the "dhcp4" (for the DHCPv4 options) and "dhcp6"
+    /// (for the DHCPv6 options) option spaces are packed when they are
+    /// added to the subnet, and they are held in the table sorted by
+    /// option code. The server appends them to the responses along with
+    /// their on-wire format, so as they are copied to the packets rather
+    /// than packed for each response. The options must not be modified
+    /// after they are added to the subnet.
+    ///
+    /// @param option_code code of the option to be returned.
+    ///
+    /// @return the option and its on-wire format (both NULL if the option
+    /// is not configured). The on-wire format is NULL if the option could
+    /// not be packed.
+    PackedOption getPackedOption(const uint16_t option_code) const;
+
     /// @brief Return single vendor option descriptor.
     ///
     /// @param vendor_id enterprise id of the option space.
@@ -424,7 +442,7 @@ public:
     /// returned it is valid.
     ///
     /// @return const reference to the relay information
-    const isc::dhcp::Subnet::RelayInfo& getRelayInfo() {
+    const isc::dhcp::Subnet::RelayInfo& getRelayInfo() const {
         return (relay_);
     }
 
@@ -464,6 +482,64 @@ protected:
     /// @return a collection of all pools
     PoolCollection& getPoolsWritable(Lease::Type type);
 
+    /// @brief Entry of the index used to find the pool holding an address.
+    ///
+    /// The entries are sorted by the first address of the pool. Each entry
+    /// also holds the highest last address of all pools sorted before it
+    /// (including this one), so as the search for overlapping pools can stop
+    /// as soon as no earlier pool can hold the address.
+    struct PoolIndexEntry {
+        /// @brief First address of the pool.
+        isc::asiolink::IOAddress first_;
+
+        /// @brief Last address of the pool.
+        isc::asiolink::IOAddress last_;
+
+        /// @brief Highest last address of this and all preceding entries.
+        isc::asiolink::IOAddress max_last_;
+
+        /// @brief Position of the pool in the pool collection.
+        size_t position_;
+
+        /// @brief Compares the address with the first address of the pool.
+        ///
+        /// @param addr Address to be compared.
+        /// @param entry Index entry to be compared.
+        /// @return true if the address is lower than the first address.
+        static bool lessThanFirst(const isc::asiolink::IOAddress& addr,
+                                  const PoolIndexEntry& entry) {
+            return (addr.lessThan(entry.first_));
+        }
+    };
+
+    /// @brief Collection of the pool index entries.
+    typedef std::vector<PoolIndexEntry> PoolIndex;
+
+    /// @brief Returns the pool index for the pools of the specified type.
+    ///
+    /// @param type lease type of the pools
+    /// @return index of the pools
+    const PoolIndex& getPoolIndex(Lease::Type type) const;
+
+    /// @brief Returns the pool index for the pools of the specified type
+    /// (non-const variant).
+    ///
+    /// @param type lease type of the pools
+    /// @return index of the pools
+    PoolIndex& getPoolIndexWritable(Lease::Type type);
+
+    /// @brief Returns the pool which the address belongs to.
+    ///
+    /// If several pools hold the address, the one added first is returned.
+    /// The lookup is logarithmic in the number of pools, unless the pools
+    /// overlap.
+    ///
+    /// @param type lease type of the pool
+    /// @param addr address to be searched
+    /// @return the pool or NULL if there is no pool holding the address
+    PoolPtr findPool(Lease::Type type,
+                     const isc::asiolink::IOAddress& addr) const;
+
     /// @brief Protected constructor
     //
     /// By making the constructor protected, we make sure that no one will
@@ -546,6 +622,15 @@ protected:
     /// @brief collection of IPv6 prefix pools in that subnet
     PoolCollection pools_pd_;
 
+    /// @brief index of the IPv4 or non-temporary IPv6 pools
+    PoolIndex pool_index_;
+
+    /// @brief index of the IPv6 temporary address pools
+    PoolIndex pool_index_ta_;
+
+    /// @brief index of the IPv6 prefix pools
+    PoolIndex pool_index_pd_;
+
     /// @brief a prefix of the subnet
     isc::asiolink::IOAddress prefix_;
 
@@ -620,6 +705,10 @@ private:
 
     /// Vendor options are kept here
     VendorOptionSpaceCollection vendor_option_spaces_;
+
+    /// Options of the DHCP option space along with their on-wire format,
+    /// sorted by option code.
+    PackedOptionCollection packed_options_;
 };
 
 /// @brief A generic pointer to either Subnet4 or Subnet6 object
@@ -0,0 +1,129 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/subnet_index.h>
+
+#include <algorithm>
+
+using namespace isc::asiolink;
+
+namespace isc {
+namespace dhcp {
+
+SubnetIndex::SubnetIndex() {
+    clear();
+}
+
+void
+SubnetIndex::add(const Subnet& subnet, const size_t position) {
+    // Walk down the trie along the subnet prefix, creating the missing
+    // nodes on the way.
+    const std::pair<IOAddress, uint8_t> prefix = subnet.get();
+    const std::vector<uint8_t> bytes = prefix.first.toBytes();
+    const unsigned int len = std::min(static_cast<unsigned int>(prefix.second),
+                                      static_cast<unsigned int>(bytes.size() * 8));
+    uint32_t node = 0;
+    for (unsigned int bit = 0; bit < len; ++bit) {
+        const unsigned int value = getBit(bytes, bit);
+        if (nodes_[node].children_[value] == 0) {
+            const Node child = { { 0, 0 }, -1 };
+            nodes_.push_back(child);
+            nodes_[node].children_[value] = nodes_.size() - 1;
+        }
+        node = nodes_[node].children_[value];
+    }
+    if (nodes_[node].positions_ < 0) {
+        node_positions_.push_back(Positions());
+        nodes_[node].positions_ = node_positions_.size() - 1;
+    }
+    node_positions_[nodes_[node].positions_].push_back(position);
+
+    relays_[subnet.getRelayInfo().addr_].push_back(position);
+
+    const std::string iface = subnet.getIface();
+    if (!iface.empty()) {
+        ifaces_[iface].push_back(position);
+    }
+
+    const Subnet6* subnet6 = dynamic_cast<const Subnet6*>(&subnet);
+    if (subnet6 && subnet6->getInterfaceId()) {
+        interface_ids_[subnet6->getInterfaceId()->getData()].push_back(position);
+    }
+}
+
+void
+SubnetIndex::clear() {
+    const Node root = { { 0, 0 }, -1 };
+    nodes_.assign(1, root);
+    node_positions_.clear();
+    relays_.clear();
+    ifaces_.clear();
+    interface_ids_.clear();
+}
+
+void
+SubnetIndex::getByAddress(const IOAddress& addr, Positions& positions) const {
+    positions.clear();
+
+    // Collect the subnets from all nodes on the path of the address.
+    // Each of them holds a prefix of the address.
+    const std::vector<uint8_t> bytes = addr.toBytes();
+    const unsigned int len = bytes.size() * 8;
+    uint32_t node = 0;
+    for (unsigned int bit = 0; ; ++bit) {
+        if (nodes_[node].positions_ >= 0) {
+            const Positions& found = node_positions_[nodes_[node].positions_];
+            positions.insert(positions.end(), found.begin(), found.end());
+        }
+        if (bit == len) {
+            break;
+        }
+        node = nodes_[node].children_[getBit(bytes, bit)];
+        if (node == 0) {
+            break;
+        }
+    }
+
+    // The subnets with shorter prefixes may appear later in the
+    // configuration.
+    if (positions.size() > 1) {
+        std::sort(positions.begin(), positions.end());
+    }
+}
+
+const SubnetIndex::Positions&
+SubnetIndex::getByRelay(const IOAddress& addr) const {
+    return (find(relays_, addr));
+}
+
+const SubnetIndex::Positions&
+SubnetIndex::getByIface(const std::string& iface) const {
+    return (find(ifaces_, iface));
+}
+
+const SubnetIndex::Positions&
+SubnetIndex::getByInterfaceId(const OptionPtr& interface_id) const {
+    return (find(interface_ids_, interface_id->getData()));
+}
+
+template<typename MapType>
+const SubnetIndex::Positions&
+SubnetIndex::find(const MapType& map, const typename MapType::key_type& key) {
+    static const Positions empty;
+    typename MapType::const_iterator it = map.find(key);
+    return (it == map.end() ? empty : it->second);
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
@@ -0,0 +1,155 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SUBNET_INDEX_H
+#define SUBNET_INDEX_H
+
+#include <asiolink/io_address.h>
+#include <dhcp/option.h>
+#include <dhcpsrv/subnet.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Index used to select the subnet for a client.
+///
+/// The configuration manager holds subnets in a vector and the subnet
+/// which appears first in the configuration is selected when there are
+/// several matching subnets. This index holds positions of the subnets
+/// in the vector, so as the configuration manager can find the matching
+/// subnets without iterating over all of them:
+/// - by address: a binary trie of the subnet prefixes returns all subnets
+///   containing the address in the time proportional to the prefix length,
+/// - by relay address, interface name and interface-id: hash tables.
+///
+/// The subnet is indexed using the values it holds when it is added to
+/// the index. The index is built when the configuration is committed and
+/// it is only read afterwards, so as the lookups need no locking.
+class SubnetIndex : public boost::noncopyable {
+public:
+
+    /// @brief Collection of positions of subnets in the configuration.
+    ///
+    /// The positions are sorted in the ascending order.
+    typedef std::vector<size_t> Positions;
+
+    /// @brief Constructor. Creates an empty index.
+    SubnetIndex();
+
+    /// @brief Adds the subnet to the index.
+    ///
+    /// @param subnet Subnet to be added.
+    /// @param position Position of the subnet in the configuration. It must
+    /// be greater than the positions of all subnets added previously.
+    void add(const Subnet& subnet, const size_t position);
+
+    /// @brief Removes all subnets from the index.
+    void clear();
+
+    /// @brief Rebuilds the index from the subnets.
+    ///
+    /// @param subnets Subnets to be indexed, in the configuration order.
+    /// @tparam SubnetCollectionType Type of the collection of pointers to
+    /// subnets.
+    template<typename SubnetCollectionType>
+    void build(const SubnetCollectionType& subnets) {
+        clear();
+        for (size_t position = 0; position < subnets.size(); ++position) {
+            add(*subnets[position], position);
+        }
+    }
+
+    /// @brief Returns positions of the subnets containing the address.
+    ///
+    /// @param addr Address for which the subnets are searched.
+    /// @param [out] positions Sorted positions of the subnets. The collection
+    /// is cleared before the positions are added.
+    void getByAddress(const isc::asiolink::IOAddress& addr,
+                      Positions& positions) const;
+
+    /// @brief Returns positions of the subnets for the relay address.
+    ///
+    /// @param addr Relay address.
+    /// @return Positions of the subnets with the matching relay address.
+    const Positions& getByRelay(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns positions of the subnets for the interface.
+    ///
+    /// @param iface Interface name.
+    /// @return Positions of the subnets reachable over the interface.
+    const Positions& getByIface(const std::string& iface) const;
+
+    /// @brief Returns positions of the subnets for the interface-id.
+    ///
+    /// The subnets are selected by the contents of the interface-id option.
+    /// The caller is responsible for checking the option type.
+    ///
+    /// @param interface_id Interface-id option inserted by the relay.
+    /// @return Positions of the subnets with the matching interface-id.
+    const Positions& getByInterfaceId(const OptionPtr& interface_id) const;
+
+private:
+
+    /// @brief Single node of the binary trie.
+    struct Node {
+        /// @brief Indexes of the child nodes for the bits 0 and 1. The value
+        /// of 0 denotes no child, as the root is never a child.
+        uint32_t children_[2];
+
+        /// @brief Index of the positions of subnets with the prefix ending in
+        /// this node or -1 if there are no such subnets.
+        int32_t positions_;
+    };
+
+    /// @brief Returns the value of the bit of the address.
+    ///
+    /// @param bytes Address in the network byte order.
+    /// @param bit Index of the bit, starting from the most significant one.
+    static unsigned int getBit(const std::vector<uint8_t>& bytes,
+                               const unsigned int bit) {
+        return ((bytes[bit / 8] >> (7 - bit % 8)) & 1);
+    }
+
+    /// @brief Returns the positions for the key or an empty collection.
+    template<typename MapType>
+    static const Positions& find(const MapType& map,
+                                 const typename MapType::key_type& key);
+
+    /// @brief Nodes of the binary trie. The first node is the root.
+    std::vector<Node> nodes_;
+
+    /// @brief Positions of the subnets referenced by the trie nodes.
+    std::vector<Positions> node_positions_;
+
+    /// @brief Positions of the subnets by relay address.
+    boost::unordered_map<isc::asiolink::IOAddress, Positions> relays_;
+
+    /// @brief Positions of the subnets by interface name.
+    boost::unordered_map<std::string, Positions> ifaces_;
+
+    /// @brief Positions of the subnets by interface-id contents.
+    boost::unordered_map<OptionBuffer, Positions> interface_ids_;
+};
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
+
+#endif // SUBNET_INDEX_H
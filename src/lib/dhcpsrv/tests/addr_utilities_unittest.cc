@@ -20,6 +20,7 @@
 
 #include <gtest/gtest.h>
 
+#include <limits>
 #include <vector>
 
 #include <stdint.h>
@@ -200,4 +201,67 @@ TEST(AddrUtilitiesTest, getNetmask4) {
     EXPECT_THROW(getNetmask4(33), isc::BadValue);
 }
 
+// This test verifies that the number of addresses in the range is computed.
+TEST(AddrUtilitiesTest, addrsInRange) {
+    EXPECT_EQ(1, addrsInRange(IOAddress("192.0.2.1"), IOAddress("192.0.2.1")));
+    EXPECT_EQ(256, addrsInRange(IOAddress("192.0.2.0"),
+                                IOAddress("192.0.2.255")));
+    EXPECT_EQ(0x100000000ull, addrsInRange(IOAddress("0.0.0.0"),
+                                           IOAddress("255.255.255.255")));
+
+    EXPECT_EQ(16, addrsInRange(IOAddress("2001:db8:1::"),
+                               IOAddress("2001:db8:1::f")));
+    // Range crossing the boundary of the lower 64 bits.
+    EXPECT_EQ(32, addrsInRange(IOAddress("2001:db8:1:0:ffff:ffff:ffff:fff0"),
+                               IOAddress("2001:db8:1:1::f")));
+    // Too many addresses to fit in 64 bits.
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+              addrsInRange(IOAddress("2001:db8:1::"),
+                           IOAddress("2001:db8:1:0:ffff:ffff:ffff:ffff")));
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+              addrsInRange(IOAddress("2001:db8:1::"),
+                           IOAddress("2001:db8:2::")));
+
+    EXPECT_THROW(addrsInRange(IOAddress("192.0.2.1"),
+                              IOAddress("2001:db8:1::")), isc::BadValue);
+    EXPECT_THROW(addrsInRange(IOAddress("192.0.2.10"),
+                              IOAddress("192.0.2.1")), isc::BadValue);
+}
+
+// This test verifies that the number of prefixes in the pool is computed.
+TEST(AddrUtilitiesTest, prefixesInRange) {
+    EXPECT_EQ(1, prefixesInRange(64, 64));
+    EXPECT_EQ(256, prefixesInRange(48, 56));
+    EXPECT_EQ(0x8000000000000000ull, prefixesInRange(1, 64));
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), prefixesInRange(0, 64));
+    EXPECT_THROW(prefixesInRange(64, 56), isc::BadValue);
+    EXPECT_THROW(prefixesInRange(64, 129), isc::BadValue);
+}
+
+// This test verifies that an offset can be added to an address or prefix.
+TEST(AddrUtilitiesTest, offsetAddress) {
+    EXPECT_EQ("192.0.2.1", offsetAddress(IOAddress("192.0.2.1"), 0).toText());
+    EXPECT_EQ("192.0.3.4", offsetAddress(IOAddress("192.0.2.1"), 259).toText());
+
+    EXPECT_EQ("2001:db8:1::10",
+              offsetAddress(IOAddress("2001:db8:1::1"), 15).toText());
+    EXPECT_EQ("2001:db8:1:1::f",
+              offsetAddress(IOAddress("2001:db8:1:0:ffff:ffff:ffff:fff0"),
+                            31).toText());
+    EXPECT_EQ("2001:db8:1:1:ffff:ffff:ffff:fffe",
+              offsetAddress(IOAddress("2001:db8:1:0:ffff:ffff:ffff:ffff"),
+                            std::numeric_limits<uint64_t>::max()).toText());
+
+    // Prefixes.
+    EXPECT_EQ("2001:db8:1:3::",
+              offsetAddress(IOAddress("2001:db8:1::"), 3, 64).toText());
+    EXPECT_EQ("2001:db8:1:100::",
+              offsetAddress(IOAddress("2001:db8:1:ff::"), 1, 64).toText());
+    EXPECT_EQ("2001:db8:1:1280::",
+              offsetAddress(IOAddress("2001:db8:1::"), 0x25, 57).toText());
+    EXPECT_EQ("2001:db9::",
+              offsetAddress(IOAddress("2001:db8::"), 1, 32).toText());
+    EXPECT_THROW(offsetAddress(IOAddress("2001:db8::"), 1, 0), isc::BadValue);
+}
+
 }; // end of anonymous namespace
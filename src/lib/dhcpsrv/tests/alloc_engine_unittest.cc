@@ -64,6 +64,8 @@ public:
     // Expose internal classes for testing purposes
     using AllocEngine::Allocator;
     using AllocEngine::IterativeAllocator;
+    using AllocEngine::HashedAllocator;
+    using AllocEngine::RandomAllocator;
     using AllocEngine::getAllocator;
 
     /// @brief IterativeAllocator with internal methods exposed
@@ -381,6 +383,7 @@ public:
 
     virtual ~AllocEngine6Test() {
         factory_.destroy();
+        CfgMgr::instance().freeAddressTracking(false);
     }
 
     DuidPtr duid_;            ///< client-identifier (value used in tests)
@@ -395,7 +398,7 @@ public:
 
     /// @brief Collection of leases being replaced by newly allocated or renewed
     /// leases.
-    Lease6Collection old_leases_;
+    ConstLease6Collection old_leases_;
 };
 
 /// @brief Used in Allocation Engine tests for IPv4
@@ -455,6 +458,7 @@ public:
 
     virtual ~AllocEngine4Test() {
         factory_.destroy();
+        CfgMgr::instance().freeAddressTracking(false);
     }
 
     ClientIdPtr clientid_;    ///< Client-identifier (value used in tests)
@@ -462,7 +466,7 @@ public:
     Subnet4Ptr subnet_;       ///< Subnet4 (used in tests)
     Pool4Ptr pool_;           ///< Pool belonging to subnet_
     LeaseMgrFactory factory_; ///< Pointer to LeaseMgr factory
-    Lease4Ptr old_lease_;     ///< Holds previous instance of the lease.
+    ConstLease4Ptr old_lease_; ///< Holds previous instance of the lease.
 };
 
 // This test checks if the v6 Allocation Engine can be instantiated, parses
@@ -470,9 +474,11 @@ public:
 TEST_F(AllocEngine6Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)), NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)), NotImplemented);
+    // Hashed and random allocators can be used as well.
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_PD));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_PD));
 
     ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100, true)));
 
@@ -800,6 +806,147 @@ TEST_F(AllocEngine6Test, IterativeAllocator_manyPools6) {
     }
 }
 
+// This test verifies that the hashed allocator picks the same address for
+// the same DUID and that it walks over all addresses in all pools when the
+// previously picked address is passed as a hint.
+TEST_F(AllocEngine6Test, HashedAllocator) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+
+    Pool6Ptr pool(new Pool6(Lease::TYPE_NA, IOAddress("2001:db8:1::100"),
+                            IOAddress("2001:db8:1::104")));
+    subnet_->addPool(pool);
+
+    // The same address is returned for the same DUID, regardless of the
+    // hint which doesn't belong to any pool.
+    IOAddress home = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, home));
+    EXPECT_EQ(home, alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+    EXPECT_EQ(home, alloc.pickAddress(subnet_, duid_,
+                                      IOAddress("2001:db8:1::abcd")));
+
+    // The hash is computed from the DUID contents.
+    DuidPtr duid(new DUID(duid_->getDuid()));
+    EXPECT_EQ(home, alloc.pickAddress(subnet_, duid, IOAddress("::")));
+
+    // Different DUIDs should be spread across the pools.
+    std::set<IOAddress> homes;
+    for (int i = 0; i < 100; ++i) {
+        DuidPtr other(new DUID(vector<uint8_t>(8, i)));
+        IOAddress candidate = alloc.pickAddress(subnet_, other,
+                                                IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        homes.insert(candidate);
+    }
+    EXPECT_GT(homes.size(), 10);
+
+    // Passing the previous address walks over all addresses, moving to
+    // the next pool at the pool boundary and wrapping around.
+    EXPECT_EQ("2001:db8:1::11",
+              alloc.pickAddress(subnet_, duid_,
+                                IOAddress("2001:db8:1::10")).toText());
+    EXPECT_EQ("2001:db8:1::100",
+              alloc.pickAddress(subnet_, duid_,
+                                IOAddress("2001:db8:1::20")).toText());
+    EXPECT_EQ("2001:db8:1::10",
+              alloc.pickAddress(subnet_, duid_,
+                                IOAddress("2001:db8:1::104")).toText());
+
+    std::set<IOAddress> generated_addrs;
+    IOAddress candidate = home;
+    for (int i = 0; i < 17 + 5; ++i) {
+        EXPECT_TRUE(generated_addrs.insert(candidate).second)
+            << "address " << candidate << " picked twice";
+        candidate = alloc.pickAddress(subnet_, duid_, candidate);
+    }
+    EXPECT_EQ(home, candidate);
+}
+
+// This test verifies that the hashed allocator picks prefixes.
+TEST_F(AllocEngine6Test, HashedAllocatorPrefix) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_PD);
+
+    IOAddress home = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, home));
+    EXPECT_EQ(home, alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+
+    EXPECT_EQ("2001:db8:1:1::",
+              alloc.pickAddress(subnet_, duid_,
+                                IOAddress("2001:db8:1::")).toText());
+    EXPECT_EQ("2001:db8:1::",
+              alloc.pickAddress(subnet_, duid_,
+                                IOAddress("2001:db8:1:ff::")).toText());
+
+    std::set<IOAddress> generated_prefixes;
+    IOAddress candidate = home;
+    for (int i = 0; i < 256; ++i) {
+        EXPECT_TRUE(generated_prefixes.insert(candidate).second)
+            << "prefix " << candidate << " picked twice";
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, candidate));
+        candidate = alloc.pickAddress(subnet_, duid_, candidate);
+    }
+    EXPECT_EQ(home, candidate);
+}
+
+// This test verifies that the random allocator picks addresses and prefixes
+// from all pools.
+TEST_F(AllocEngine6Test, RandomAllocator) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_NA);
+
+    Pool6Ptr pool(new Pool6(Lease::TYPE_NA, IOAddress("2001:db8:1::100"),
+                            IOAddress("2001:db8:1::104")));
+    subnet_->addPool(pool);
+
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_,
+                                                IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        generated_addrs.insert(candidate);
+    }
+    // With 1000 attempts, it is very unlikely that any of the 22 addresses
+    // has not been picked.
+    EXPECT_EQ(17 + 5, generated_addrs.size());
+
+    NakedAllocEngine::RandomAllocator alloc_pd(Lease::TYPE_PD);
+    for (int i = 0; i < 100; ++i) {
+        IOAddress candidate = alloc_pd.pickAddress(subnet_, duid_,
+                                                   IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, candidate));
+    }
+}
+
+// This test verifies that the engine using the hashed allocator gives the
+// client the same address and continues with the following addresses
+// when this address is in use.
+TEST_F(AllocEngine6Test, hashedAlloc6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_HASHED,
+                                                 100)));
+
+    // Find out which address is computed for the client.
+    Lease6Ptr lease;
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", true, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    const IOAddress home = lease->addr_;
+
+    // Another client takes this address.
+    DuidPtr other(new DUID(vector<uint8_t>(8, 0x12)));
+    Lease6Ptr used(new Lease6(Lease::TYPE_NA, home, other, 1, 501, 502, 503,
+                              504, subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+
+    // The client gets the address following it.
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", false, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    checkLease6(lease, Lease::TYPE_NA, 128);
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+    EXPECT_EQ(alloc.pickAddress(subnet_, duid_, home), lease->addr_);
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine6Test, smallPool6) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -968,7 +1115,9 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
     EXPECT_FALSE(lease->fqdn_rev_);
 
     // Check that the old lease has been returned.
-    Lease6Ptr old_lease = expectOneLease(old_leases_);
+    ASSERT_EQ(1, old_leases_.size());
+    ConstLease6Ptr old_lease = old_leases_[0];
+    ASSERT_TRUE(old_lease);
     // It should at least have the same IPv6 address.
     EXPECT_EQ(lease->addr_, old_lease->addr_);
     // Check that it carries not updated FQDN data.
@@ -985,6 +1134,149 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
     detailCompareLease(lease, from_mgr);
 }
 
+// This test checks that the expired leases are reclaimed, i.e. removed
+// from the lease database, and that the leases which haven't expired
+// are left intact.
+TEST_F(AllocEngine6Test, reclaimExpiredLeases6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    // Add ten leases, every other of them expired.
+    std::vector<Lease6Ptr> leases;
+    for (int i = 0; i < 10; ++i) {
+        std::ostringstream addr;
+        addr << "2001:db8:1::" << (0x10 + i);
+        DuidPtr duid(new DUID(std::vector<uint8_t>(8, 0x10 + i)));
+        Lease6Ptr lease(new Lease6(Lease::TYPE_NA, IOAddress(addr.str()),
+                                   duid, iaid_, 300, 400, 100, 200,
+                                   subnet_->getID()));
+        if (i % 2 == 0) {
+            lease->cltt_ = time(NULL) - 500 - i;
+        }
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        leases.push_back(lease);
+    }
+
+    // Reclaim at most two leases. The two leases which expired first
+    // should be removed.
+    EXPECT_EQ(2, engine->reclaimExpiredLeases6(2, 0));
+    LeaseMgr& lease_mgr = LeaseMgrFactory::instance();
+    EXPECT_FALSE(lease_mgr.getLease6(Lease::TYPE_NA, leases[8]->addr_));
+    EXPECT_FALSE(lease_mgr.getLease6(Lease::TYPE_NA, leases[6]->addr_));
+    EXPECT_TRUE(lease_mgr.getLease6(Lease::TYPE_NA, leases[4]->addr_));
+
+    // Reclaim the remaining expired leases.
+    EXPECT_EQ(3, engine->reclaimExpiredLeases6(0, 0));
+    for (int i = 0; i < leases.size(); ++i) {
+        if (i % 2 == 0) {
+            EXPECT_FALSE(lease_mgr.getLease6(Lease::TYPE_NA, leases[i]->addr_));
+        } else {
+            EXPECT_TRUE(lease_mgr.getLease6(Lease::TYPE_NA, leases[i]->addr_));
+        }
+    }
+
+    // There is nothing more to reclaim.
+    EXPECT_EQ(0, engine->reclaimExpiredLeases6(0, 0));
+}
+
+// This test checks that the free addresses are picked from the bitmap of
+// free addresses when the free address tracking is enabled.
+TEST_F(AllocEngine6Test, freeAddressTracking6) {
+    // Use a single attempt, so as the regular allocation would fail when
+    // the first address picked is in use.
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 1)));
+    ASSERT_TRUE(engine);
+    CfgMgr::instance().freeAddressTracking(true);
+
+    // Allocate all addresses but the last one to other clients.
+    std::vector<Lease6Ptr> leases;
+    for (int i = 0; i < 16; ++i) {
+        std::ostringstream addr;
+        addr << "2001:db8:1::" << std::hex << (0x10 + i);
+        DuidPtr duid(new DUID(std::vector<uint8_t>(8, 0x10 + i)));
+        Lease6Ptr lease(new Lease6(Lease::TYPE_NA, IOAddress(addr.str()),
+                                   duid, iaid_, 300, 400, 100, 200,
+                                   subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        leases.push_back(lease);
+    }
+
+    // The only free address should be advertised.
+    Lease6Ptr lease;
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false, false,
+                    "", true, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("2001:db8:1::20", lease->addr_.toText());
+
+    // The bitmap has been created using the leases in the database. The
+    // advertised address remains free.
+    FreeAddressBitmapPtr free_addresses = pool_->getFreeAddresses();
+    ASSERT_TRUE(free_addresses);
+    EXPECT_EQ(1, free_addresses->getFreeCount());
+
+    // Allocate the address.
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false, false,
+                    "", false, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("2001:db8:1::20", lease->addr_.toText());
+    checkLease6(lease, Lease::TYPE_NA);
+    EXPECT_EQ(0, free_addresses->getFreeCount());
+
+    // There are no more free addresses.
+    DuidPtr other_duid(new DUID(std::vector<uint8_t>(12, 0xff)));
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    other_duid, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", false, CalloutHandlePtr(), old_leases_)));
+    EXPECT_FALSE(lease);
+
+    // Release one of the leases. Its address should be allocated.
+    ASSERT_TRUE(LeaseMgrFactory::instance().deleteLease(leases[5]->addr_));
+    engine->leaseRemoved(leases[5]);
+    EXPECT_EQ(1, free_addresses->getFreeCount());
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    other_duid, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", false, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(leases[5]->addr_.toText(), lease->addr_.toText());
+}
+
+// This test checks that the free prefixes are picked from the bitmap of
+// free prefixes when the free address tracking is enabled.
+TEST_F(AllocEngine6Test, pdFreeAddressTracking6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 1)));
+    ASSERT_TRUE(engine);
+    CfgMgr::instance().freeAddressTracking(true);
+
+    // Delegate the first prefix of the pool to another client.
+    DuidPtr other_duid(new DUID(std::vector<uint8_t>(12, 0xff)));
+    Lease6Ptr other(new Lease6(Lease::TYPE_PD, IOAddress("2001:db8:1::"),
+                               other_duid, iaid_, 300, 400, 100, 200,
+                               subnet_->getID(), 64));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(other));
+
+    Lease6Ptr lease;
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_PD, false, false,
+                    "", false, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("2001:db8:1:1::", lease->addr_.toText());
+    checkLease6(lease, Lease::TYPE_PD, 64);
+
+    // The pool holds 256 prefixes and two of them are in use.
+    FreeAddressBitmapPtr free_prefixes = pd_pool_->getFreeAddresses();
+    ASSERT_TRUE(free_prefixes);
+    EXPECT_EQ(256, free_prefixes->getCapacity());
+    EXPECT_EQ(254, free_prefixes->getFreeCount());
+}
+
 // --- IPv4 ---
 
 // This test checks if the v4 Allocation Engine can be instantiated, parses
@@ -992,11 +1284,13 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
 TEST_F(AllocEngine4Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5, false)),
-                 NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5, false)),
-                 NotImplemented);
+    // Hashed and random allocators can be used as well.
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5,
+                                            false)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_V4));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5,
+                                            false)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_V4));
 
     // Create V4 (ipv6=false) Allocation Engine that will try at most
     // 100 attempts to pick up a lease
@@ -1310,6 +1604,83 @@ TEST_F(AllocEngine4Test, IterativeAllocator_manyPools4) {
 }
 
 
+// This test verifies that the hashed allocator picks the same address for
+// the same client identifier and picks addresses from all pools.
+TEST_F(AllocEngine4Test, HashedAllocator) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+
+    Pool4Ptr pool(new Pool4(IOAddress("192.0.2.200"),
+                            IOAddress("192.0.2.204")));
+    subnet_->addPool(pool);
+
+    IOAddress home = alloc.pickAddress(subnet_, clientid_,
+                                       IOAddress("0.0.0.0"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, home));
+    EXPECT_EQ(home, alloc.pickAddress(subnet_, clientid_,
+                                      IOAddress("0.0.0.0")));
+
+    // Walk over all addresses starting from the computed one.
+    std::set<IOAddress> generated_addrs;
+    IOAddress candidate = home;
+    for (int i = 0; i < 10 + 5; ++i) {
+        EXPECT_TRUE(generated_addrs.insert(candidate).second)
+            << "address " << candidate << " picked twice";
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+        candidate = alloc.pickAddress(subnet_, clientid_, candidate);
+    }
+    EXPECT_EQ(home, candidate);
+
+    // Clients which don't send the client identifier get random addresses.
+    for (int i = 0; i < 100; ++i) {
+        candidate = alloc.pickAddress(subnet_, ClientIdPtr(),
+                                      IOAddress("0.0.0.0"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+    }
+}
+
+// This test verifies that the random allocator picks addresses from all
+// pools.
+TEST_F(AllocEngine4Test, RandomAllocator) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_V4);
+
+    Pool4Ptr pool(new Pool4(IOAddress("192.0.2.200"),
+                            IOAddress("192.0.2.204")));
+    subnet_->addPool(pool);
+
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, clientid_,
+                                                IOAddress("0.0.0.0"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+        generated_addrs.insert(candidate);
+    }
+    EXPECT_EQ(10 + 5, generated_addrs.size());
+}
+
+// This test verifies that the engine using the hashed allocator gives the
+// client the same address, also after the lease has been released.
+TEST_F(AllocEngine4Test, hashedAlloc4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_HASHED,
+                                                 100, false)));
+
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "",
+                                             false, CalloutHandlePtr(),
+                                             old_lease_);
+    ASSERT_TRUE(lease);
+    checkLease4(lease);
+    const IOAddress addr = lease->addr_;
+
+    ASSERT_TRUE(LeaseMgrFactory::instance().deleteLease(addr));
+    lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   false, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(addr, lease->addr_);
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine4Test, smallPool4) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -1556,6 +1927,120 @@ TEST_F(AllocEngine4Test, renewLease4) {
     detailCompareLease(lease, from_mgr);
 }
 
+// This test checks that the expired leases are reclaimed, i.e. removed
+// from the lease database, and that the leases which haven't expired
+// are left intact.
+TEST_F(AllocEngine4Test, reclaimExpiredLeases4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    // Add ten leases, every other of them expired.
+    std::vector<Lease4Ptr> leases;
+    for (int i = 0; i < 10; ++i) {
+        const uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe,
+                                   static_cast<uint8_t>(i) };
+        time_t cltt = time(NULL);
+        if (i % 2 == 0) {
+            cltt -= 500 + i;
+        }
+        Lease4Ptr lease(new Lease4(IOAddress(0xC0000264 + i), hwaddr,
+                                   sizeof(hwaddr), NULL, 0, 300, 100, 200,
+                                   cltt, subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        leases.push_back(lease);
+    }
+
+    // Reclaim at most two leases. The two leases which expired first
+    // should be removed.
+    EXPECT_EQ(2, engine->reclaimExpiredLeases4(2, 0));
+    LeaseMgr& lease_mgr = LeaseMgrFactory::instance();
+    EXPECT_FALSE(lease_mgr.getLease4(leases[8]->addr_));
+    EXPECT_FALSE(lease_mgr.getLease4(leases[6]->addr_));
+    EXPECT_TRUE(lease_mgr.getLease4(leases[4]->addr_));
+
+    // Reclaim the remaining expired leases.
+    EXPECT_EQ(3, engine->reclaimExpiredLeases4(0, 0));
+    for (int i = 0; i < leases.size(); ++i) {
+        if (i % 2 == 0) {
+            EXPECT_FALSE(lease_mgr.getLease4(leases[i]->addr_));
+        } else {
+            EXPECT_TRUE(lease_mgr.getLease4(leases[i]->addr_));
+        }
+    }
+
+    // There is nothing more to reclaim.
+    EXPECT_EQ(0, engine->reclaimExpiredLeases4(0, 0));
+}
+
+// This test checks that the free addresses are picked from the bitmap of
+// free addresses when the free address tracking is enabled.
+TEST_F(AllocEngine4Test, freeAddressTracking4) {
+    // Use a single attempt, so as the regular allocation would fail when
+    // the first address picked is in use.
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 1, false)));
+    ASSERT_TRUE(engine);
+    CfgMgr::instance().freeAddressTracking(true);
+
+    // Allocate all addresses but the last one to other clients.
+    std::vector<Lease4Ptr> leases;
+    for (int i = 0; i < 9; ++i) {
+        const uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe,
+                                   static_cast<uint8_t>(i) };
+        Lease4Ptr lease(new Lease4(IOAddress(0xC0000264 + i), hwaddr,
+                                   sizeof(hwaddr), NULL, 0, 300, 100, 200,
+                                   time(NULL), subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        leases.push_back(lease);
+    }
+
+    // The only free address should be offered.
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "",
+                                             true, CalloutHandlePtr(),
+                                             old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.109", lease->addr_.toText());
+
+    // The bitmap has been created using the leases in the database. The
+    // offered address remains free.
+    FreeAddressBitmapPtr free_addresses = pool_->getFreeAddresses();
+    ASSERT_TRUE(free_addresses);
+    EXPECT_EQ(1, free_addresses->getFreeCount());
+
+    // Allocate the address.
+    lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   false, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.109", lease->addr_.toText());
+    checkLease4(lease);
+    EXPECT_EQ(0, free_addresses->getFreeCount());
+
+    // There are no more free addresses.
+    const uint8_t other_mac[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    HWAddrPtr other_hwaddr(new HWAddr(other_mac, sizeof(other_mac),
+                                      HTYPE_ETHER));
+    lease = engine->allocateLease4(subnet_, ClientIdPtr(), other_hwaddr,
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   false, CalloutHandlePtr(), old_lease_);
+    EXPECT_FALSE(lease);
+
+    // Release one of the leases. Its address should be allocated.
+    ASSERT_TRUE(LeaseMgrFactory::instance().deleteLease(leases[4]->addr_));
+    engine->leaseRemoved(leases[4]);
+    EXPECT_EQ(1, free_addresses->getFreeCount());
+    lease = engine->allocateLease4(subnet_, ClientIdPtr(), other_hwaddr,
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   false, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(leases[4]->addr_.toText(), lease->addr_.toText());
+}
+
 /// @brief helper class used in Hooks testing in AllocEngine6
 ///
 /// It features a couple of callout functions and buffers to store
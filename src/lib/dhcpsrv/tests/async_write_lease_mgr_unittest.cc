@@ -0,0 +1,386 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp_ddns/watch_socket.h>
+#include <dhcpsrv/async_write_lease_mgr.h>
+#include <dhcpsrv/memfile_lease_mgr.h>
+#include <dhcpsrv/tests/lease_file_io.h>
+#include <dhcpsrv/tests/test_utils.h>
+#include <dhcpsrv/tests/generic_lease_mgr_unittest.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::dhcp::test;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Memfile lease manager completing the asynchronous additions
+/// and lookups by address of the DHCPv4 leases only when the test releases
+/// them.
+class DeferringLeaseMgr : public Memfile_LeaseMgr {
+public:
+
+    using Memfile_LeaseMgr::asyncAddLease;
+    using Memfile_LeaseMgr::asyncGetLease4;
+
+    /// @brief Constructor.
+    ///
+    /// @param parameters Parameters of the Memfile backend.
+    explicit DeferringLeaseMgr(const ParameterMap& parameters)
+        : Memfile_LeaseMgr(parameters), max_pending_(0), fail_(false) {
+    }
+
+    /// @brief Defers the addition of the lease.
+    virtual void asyncAddLease(const Lease4Ptr& lease,
+                               const ResultCallback& callback) {
+        Mutex::Locker lock(mutex_);
+        deferred_.push_back(boost::bind(&DeferringLeaseMgr::add, this,
+                                        lease, callback));
+        max_pending_ = std::max(max_pending_, deferred_.size());
+    }
+
+    /// @brief Defers the lookup of the lease.
+    virtual void asyncGetLease4(const IOAddress& addr,
+                                const Lease4Callback& callback) {
+        Mutex::Locker lock(mutex_);
+        deferred_.push_back(boost::bind(&DeferringLeaseMgr::get, this,
+                                        addr, callback));
+        max_pending_ = std::max(max_pending_, deferred_.size());
+    }
+
+    /// @brief Returns the descriptor marked ready by @c release.
+    virtual int getAsyncSocket() {
+        return (released_.getSelectFd());
+    }
+
+    /// @brief Completes the released additions.
+    virtual void processAsyncResults() {
+        std::vector<boost::function<void()> > deferred;
+        {
+            Mutex::Locker lock(mutex_);
+            deferred.swap(deferred_);
+            released_.clearReady();
+        }
+        for (size_t i = 0; i < deferred.size(); ++i) {
+            deferred[i]();
+        }
+    }
+
+    /// @brief Returns the number of the deferred additions.
+    virtual size_t getAsyncPendingCount() const {
+        Mutex::Locker lock(mutex_);
+        return (deferred_.size());
+    }
+
+    /// @brief Lets the deferred additions complete.
+    void release() {
+        Mutex::Locker lock(mutex_);
+        released_.markReady();
+    }
+
+    /// @brief Waits until the number of the deferred additions reaches
+    /// the specified value.
+    ///
+    /// @param count Expected number of the deferred additions.
+    /// @return true if the number has been reached within 10 seconds.
+    bool waitForPending(const size_t count) const {
+        for (int i = 0; i < 10000; ++i) {
+            if (getAsyncPendingCount() == count) {
+                return (true);
+            }
+            usleep(1000);
+        }
+        return (false);
+    }
+
+    /// @brief Maximum number of the additions deferred at the same time.
+    size_t max_pending_;
+
+    /// @brief Indicates that the additions should fail.
+    bool fail_;
+
+private:
+
+    /// @brief Adds the lease and invokes the callback.
+    void add(const Lease4Ptr& lease, const ResultCallback& callback) {
+        if (fail_) {
+            callback(false, "database failure");
+        } else {
+            callback(Memfile_LeaseMgr::addLease(lease), "");
+        }
+    }
+
+    /// @brief Looks up the lease and invokes the callback.
+    void get(const IOAddress& addr, const Lease4Callback& callback) {
+        callback(Memfile_LeaseMgr::getLease4(addr), "");
+    }
+
+    /// @brief Deferred additions and lookups.
+    std::vector<boost::function<void()> > deferred_;
+
+    /// @brief Descriptor marked ready when the additions are released.
+    isc::dhcp_ddns::WatchSocket released_;
+
+    /// @brief Mutex protecting the deferred additions.
+    mutable Mutex mutex_;
+};
+
+/// @brief Adds the lease in a separate thread.
+///
+/// @param lease_mgr Lease manager to which the lease is added.
+/// @param lease Lease to be added.
+/// @param [out] added Result of the addition.
+void addLease(LeaseMgr* lease_mgr, const Lease4Ptr& lease, bool* added) {
+    *added = lease_mgr->addLease(lease);
+}
+
+/// @brief Looks up the lease in a separate thread.
+///
+/// @param lease_mgr Lease manager in which the lease is searched.
+/// @param addr Address of the lease.
+/// @param [out] found Indicates if the lease has been found.
+void getLease(LeaseMgr* lease_mgr, const IOAddress& addr, bool* found) {
+    *found = static_cast<bool>(lease_mgr->getLease4(addr));
+}
+
+/// @brief Test fixture class for the @c AsyncWriteLeaseMgr.
+///
+/// The lease manager is put in front of the Memfile backend storing the
+/// leases in the lease files, so as the leases survive reopening it.
+class AsyncWriteLeaseMgrTest : public GenericLeaseMgrTest {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// Opens the lease manager in front of the DHCPv4 backend.
+    AsyncWriteLeaseMgrTest()
+        : async_lookups_(false),
+          io4_(getLeaseFilePath("leasefile4_async.csv")),
+          io6_(getLeaseFilePath("leasefile6_async.csv")) {
+        io4_.removeFile();
+        io6_.removeFile();
+        reopen(V4);
+    }
+
+    /// @brief Destructor.
+    ///
+    /// Destroys the lease manager and removes the lease files.
+    virtual ~AsyncWriteLeaseMgrTest() {
+        writer_.reset();
+        io4_.removeFile();
+        io6_.removeFile();
+    }
+
+    /// @brief Return path to the lease file used by unit tests.
+    ///
+    /// @param filename Name of the lease file.
+    static std::string getLeaseFilePath(const std::string& filename) {
+        std::ostringstream s;
+        s << TEST_DATA_BUILDDIR << "/" << filename;
+        return (s.str());
+    }
+
+    /// @brief Returns the parameters of the Memfile backend.
+    ///
+    /// @param u Universe (V4 or V6).
+    static LeaseMgr::ParameterMap getParameters(Universe u) {
+        LeaseMgr::ParameterMap parameters;
+        parameters["type"] = "memfile";
+        parameters["universe"] = (u == V4 ? "4" : "6");
+        parameters["name"] = getLeaseFilePath(u == V4 ? "leasefile4_async.csv" :
+                                              "leasefile6_async.csv");
+        return (parameters);
+    }
+
+    /// @brief Reopens the lease manager and the backend.
+    ///
+    /// @param u Universe (V4 or V6).
+    virtual void reopen(Universe u) {
+        writer_.reset();
+        writer_.reset(new AsyncWriteLeaseMgr(getParameters(u),
+                                             new Memfile_LeaseMgr(getParameters(u)),
+                                             async_lookups_));
+        lmptr_ = writer_.get();
+    }
+
+    /// @brief Reopens the lease manager with the asynchronous lookups.
+    ///
+    /// @param u Universe (V4 or V6).
+    void reopenAsyncLookups(Universe u) {
+        async_lookups_ = true;
+        reopen(u);
+    }
+
+    /// @brief Indicates if the lookups use the asynchronous API.
+    bool async_lookups_;
+
+    /// @brief Object providing access to v4 lease IO.
+    LeaseFileIO io4_;
+
+    /// @brief Object providing access to v6 lease IO.
+    LeaseFileIO io6_;
+
+    /// @brief Lease manager under test.
+    boost::scoped_ptr<AsyncWriteLeaseMgr> writer_;
+};
+
+// Checks that the writes of several threads are in flight at the same time.
+TEST_F(AsyncWriteLeaseMgrTest, concurrentWrites) {
+    LeaseMgr::ParameterMap parameters = getParameters(V4);
+    parameters["persist"] = "false";
+    DeferringLeaseMgr* backend = new DeferringLeaseMgr(parameters);
+    writer_.reset(new AsyncWriteLeaseMgr(parameters, backend));
+
+    std::vector<Lease4Ptr> leases = createLeases4();
+    bool added[4] = { false, false, false, false };
+    std::vector<boost::shared_ptr<Thread> > threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(boost::shared_ptr<Thread>(new Thread(
+            boost::bind(&addLease, writer_.get(), leases[i], &added[i]))));
+    }
+
+    // None of the threads returns until the additions are released.
+    ASSERT_TRUE(backend->waitForPending(4));
+    EXPECT_FALSE(backend->getLease4(leases[0]->addr_));
+    backend->release();
+    for (int i = 0; i < 4; ++i) {
+        threads[i]->wait();
+        EXPECT_TRUE(added[i]);
+        EXPECT_TRUE(writer_->getLease4(leases[i]->addr_));
+    }
+    EXPECT_EQ(4, backend->max_pending_);
+}
+
+// Checks that the lookups of several threads are in flight at the same
+// time when enabled.
+TEST_F(AsyncWriteLeaseMgrTest, concurrentLookups) {
+    LeaseMgr::ParameterMap parameters = getParameters(V4);
+    parameters["persist"] = "false";
+    DeferringLeaseMgr* backend = new DeferringLeaseMgr(parameters);
+    writer_.reset(new AsyncWriteLeaseMgr(parameters, backend, true));
+
+    std::vector<Lease4Ptr> leases = createLeases4();
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(backend->Memfile_LeaseMgr::addLease(leases[i]));
+    }
+    bool found[4] = { false, false, false, false };
+    std::vector<boost::shared_ptr<Thread> > threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(boost::shared_ptr<Thread>(new Thread(
+            boost::bind(&getLease, writer_.get(), leases[i]->addr_,
+                        &found[i]))));
+    }
+
+    // None of the threads returns until the lookups are released.
+    ASSERT_TRUE(backend->waitForPending(4));
+    backend->release();
+    for (int i = 0; i < 4; ++i) {
+        threads[i]->wait();
+        EXPECT_TRUE(found[i]);
+    }
+    EXPECT_EQ(4, backend->max_pending_);
+}
+
+// Checks that the lookups are synchronous unless enabled.
+TEST_F(AsyncWriteLeaseMgrTest, syncLookups) {
+    LeaseMgr::ParameterMap parameters = getParameters(V4);
+    parameters["persist"] = "false";
+    DeferringLeaseMgr* backend = new DeferringLeaseMgr(parameters);
+    writer_.reset(new AsyncWriteLeaseMgr(parameters, backend));
+
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(backend->Memfile_LeaseMgr::addLease(leases[1]));
+    EXPECT_TRUE(writer_->getLease4(leases[1]->addr_));
+    EXPECT_EQ(0, backend->max_pending_);
+}
+
+// Checks that the errors of the asynchronous operations are thrown.
+TEST_F(AsyncWriteLeaseMgrTest, writeError) {
+    LeaseMgr::ParameterMap parameters = getParameters(V4);
+    parameters["persist"] = "false";
+    DeferringLeaseMgr* backend = new DeferringLeaseMgr(parameters);
+    backend->fail_ = true;
+    writer_.reset(new AsyncWriteLeaseMgr(parameters, backend));
+
+    std::vector<Lease4Ptr> leases = createLeases4();
+    bool added = false;
+    Thread thread(boost::bind(&addLease, writer_.get(), leases[1], &added));
+    ASSERT_TRUE(backend->waitForPending(1));
+    backend->release();
+    EXPECT_THROW(thread.wait(), Thread::UncaughtException);
+    EXPECT_FALSE(backend->getLease4(leases[1]->addr_));
+
+    // The results of the update and delete of the non-existing lease are
+    // the same as of the synchronous operations.
+    EXPECT_THROW(writer_->updateLease4(leases[2]), NoSuchLease);
+    EXPECT_FALSE(writer_->deleteLease(leases[2]->addr_));
+}
+
+// The following tests run the generic lease manager tests. The tests
+// expecting the SQL backend errors are not run, as the Memfile backend
+// doesn't report them.
+
+TEST_F(AsyncWriteLeaseMgrTest, basicLease4) {
+    testBasicLease4();
+}
+
+TEST_F(AsyncWriteLeaseMgrTest, updateLease4) {
+    testUpdateLease4();
+}
+
+TEST_F(AsyncWriteLeaseMgrTest, recreateLease4) {
+    testRecreateLease4();
+}
+
+TEST_F(AsyncWriteLeaseMgrTest, basicLease6) {
+    reopen(V6);
+    testBasicLease6();
+}
+
+TEST_F(AsyncWriteLeaseMgrTest, updateLease6) {
+    reopen(V6);
+    testUpdateLease6();
+}
+
+TEST_F(AsyncWriteLeaseMgrTest, basicLease4AsyncLookups) {
+    reopenAsyncLookups(V4);
+    testBasicLease4();
+}
+
+TEST_F(AsyncWriteLeaseMgrTest, basicLease6AsyncLookups) {
+    reopenAsyncLookups(V6);
+    testBasicLease6();
+}
+
+} // end of anonymous namespace
@@ -0,0 +1,371 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/caching_lease_mgr.h>
+#include <dhcpsrv/memfile_lease_mgr.h>
+#include <dhcpsrv/tests/lease_file_io.h>
+#include <dhcpsrv/tests/test_utils.h>
+#include <dhcpsrv/tests/generic_lease_mgr_unittest.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::dhcp::test;
+
+namespace {
+
+/// @brief Memfile lease manager counting the single lease lookups.
+class CountingLeaseMgr : public Memfile_LeaseMgr {
+public:
+
+    using Memfile_LeaseMgr::getLease4;
+
+    /// @brief Constructor.
+    ///
+    /// @param parameters Parameters of the Memfile backend.
+    explicit CountingLeaseMgr(const ParameterMap& parameters)
+        : Memfile_LeaseMgr(parameters), lookups_(0), writer_(NULL) {
+    }
+
+    /// @brief Counts the lookup and returns the lease by address.
+    ///
+    /// If the concurrent write is set, the lease is updated through the
+    /// writer after it has been looked up, as if it was updated by another
+    /// thread during the lookup.
+    virtual Lease4Ptr getLease4(const IOAddress& addr) const {
+        ++lookups_;
+        Lease4Ptr lease = Memfile_LeaseMgr::getLease4(addr);
+        if (concurrent_write_) {
+            Lease4Ptr written;
+            written.swap(concurrent_write_);
+            writer_->updateLease4(written);
+        }
+        return (lease);
+    }
+
+    /// @brief Counts the lookup and returns the lease by HW address.
+    virtual Lease4Ptr getLease4(const HWAddr& hwaddr,
+                                SubnetID subnet_id) const {
+        ++lookups_;
+        return (Memfile_LeaseMgr::getLease4(hwaddr, subnet_id));
+    }
+
+    /// @brief Counts the lookup and returns the lease by client id.
+    virtual Lease4Ptr getLease4(const ClientId& clientid,
+                                SubnetID subnet_id) const {
+        ++lookups_;
+        return (Memfile_LeaseMgr::getLease4(clientid, subnet_id));
+    }
+
+    /// @brief Counts the lookup and returns the lease by address.
+    virtual Lease6Ptr getLease6(Lease::Type type,
+                                const IOAddress& addr) const {
+        ++lookups_;
+        return (Memfile_LeaseMgr::getLease6(type, addr));
+    }
+
+    /// @brief Number of the lookups.
+    mutable int lookups_;
+
+    /// @brief Lease manager writing the concurrent write.
+    LeaseMgr* writer_;
+
+    /// @brief Lease updated during the next lookup by address or NULL.
+    mutable Lease4Ptr concurrent_write_;
+};
+
+/// @brief Test fixture class for the @c CachingLeaseMgr.
+///
+/// The cache is put in front of the Memfile backend storing the leases
+/// in the lease files, so as the leases survive reopening the cache.
+class CachingLeaseMgrTest : public GenericLeaseMgrTest {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// Opens the cache of 4 leases in front of the DHCPv4 backend.
+    CachingLeaseMgrTest()
+        : io4_(getLeaseFilePath("leasefile4_cache.csv")),
+          io6_(getLeaseFilePath("leasefile6_cache.csv")),
+          backend_(NULL) {
+        io4_.removeFile();
+        io6_.removeFile();
+        open(V4, 4);
+    }
+
+    /// @brief Destructor.
+    ///
+    /// Destroys the cache and removes the lease files.
+    virtual ~CachingLeaseMgrTest() {
+        cache_.reset();
+        io4_.removeFile();
+        io6_.removeFile();
+    }
+
+    /// @brief Return path to the lease file used by unit tests.
+    ///
+    /// @param filename Name of the lease file.
+    static std::string getLeaseFilePath(const std::string& filename) {
+        std::ostringstream s;
+        s << TEST_DATA_BUILDDIR << "/" << filename;
+        return (s.str());
+    }
+
+    /// @brief Opens the cache and the backend.
+    ///
+    /// @param u Universe (V4 or V6).
+    /// @param cache_size Maximum number of leases in the cache.
+    void open(Universe u, const size_t cache_size) {
+        LeaseMgr::ParameterMap parameters;
+        parameters["type"] = "memfile";
+        parameters["universe"] = (u == V4 ? "4" : "6");
+        parameters["name"] = getLeaseFilePath(u == V4 ? "leasefile4_cache.csv" :
+                                              "leasefile6_cache.csv");
+        std::ostringstream cache_size_text;
+        cache_size_text << cache_size;
+        parameters["cache-size"] = cache_size_text.str();
+
+        cache_.reset();
+        backend_ = new CountingLeaseMgr(parameters);
+        cache_.reset(new CachingLeaseMgr(parameters, backend_));
+        lmptr_ = cache_.get();
+    }
+
+    /// @brief Reopens the cache and the backend.
+    ///
+    /// @param u Universe (V4 or V6).
+    virtual void reopen(Universe u) {
+        open(u, cache_->getCapacity());
+    }
+
+    /// @brief Object providing access to v4 lease IO.
+    LeaseFileIO io4_;
+
+    /// @brief Object providing access to v6 lease IO.
+    LeaseFileIO io6_;
+
+    /// @brief Backend of the cache, owned by the cache.
+    CountingLeaseMgr* backend_;
+
+    /// @brief Cache under test.
+    boost::scoped_ptr<CachingLeaseMgr> cache_;
+};
+
+// Checks that the cache size is validated.
+TEST_F(CachingLeaseMgrTest, constructor) {
+    LeaseMgr::ParameterMap parameters;
+    parameters["type"] = "memfile";
+    parameters["universe"] = "4";
+    parameters["persist"] = "false";
+    parameters["cache-size"] = "0";
+    EXPECT_THROW(CachingLeaseMgr(parameters, new Memfile_LeaseMgr(parameters)),
+                 isc::BadValue);
+    parameters["cache-size"] = "many";
+    EXPECT_THROW(CachingLeaseMgr(parameters, new Memfile_LeaseMgr(parameters)),
+                 isc::BadValue);
+
+    parameters["cache-size"] = "1000";
+    CachingLeaseMgr cache(parameters, new Memfile_LeaseMgr(parameters));
+    EXPECT_EQ(1000, cache.getCapacity());
+    EXPECT_EQ("memfile", cache.getType());
+}
+
+// Checks that the added leases are returned from the cache and the other
+// leases are fetched from the backend.
+TEST_F(CachingLeaseMgrTest, readThrough) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(cache_->addLease(leases[1]));
+    ASSERT_TRUE(backend_->addLease(leases[2]));
+
+    // The added lease is in the cache.
+    Lease4Ptr lease = cache_->getLease4(leases[1]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases[1], lease);
+    lease = cache_->getLease4(*leases[1]->client_id_, leases[1]->subnet_id_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases[1], lease);
+    EXPECT_EQ(0, backend_->lookups_);
+    EXPECT_EQ(2, cache_->getHits());
+    EXPECT_EQ(0, cache_->getMisses());
+
+    // The lease added to the backend is fetched and then cached.
+    lease = cache_->getLease4(HWAddr(leases[2]->hwaddr_, HTYPE_ETHER),
+                              leases[2]->subnet_id_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases[2], lease);
+    lease = cache_->getLease4(leases[2]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases[2], lease);
+    EXPECT_EQ(1, backend_->lookups_);
+    EXPECT_EQ(3, cache_->getHits());
+    EXPECT_EQ(1, cache_->getMisses());
+
+    // The non-existing lease is looked up in the backend every time.
+    EXPECT_FALSE(cache_->getLease4(leases[3]->addr_));
+    EXPECT_FALSE(cache_->getLease4(leases[3]->addr_));
+    EXPECT_EQ(3, backend_->lookups_);
+    EXPECT_EQ(3, cache_->getMisses());
+
+    // The caller can't modify the cached lease.
+    lease->valid_lft_ = 1;
+    lease = cache_->getLease4(leases[2]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(leases[2]->valid_lft_, lease->valid_lft_);
+}
+
+// Checks that the updated and deleted leases are written to the backend
+// and the cache.
+TEST_F(CachingLeaseMgrTest, writeThrough) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(cache_->addLease(leases[1]));
+    EXPECT_FALSE(cache_->addLease(leases[1]));
+
+    leases[1]->valid_lft_ += 100;
+    leases[1]->hostname_ = "renewed.example.com";
+    ASSERT_NO_THROW(cache_->updateLease4(leases[1]));
+    Lease4Ptr lease = cache_->getLease4(leases[1]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases[1], lease);
+    lease = backend_->getLease4(leases[1]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases[1], lease);
+
+    // The failed update doesn't leave the lease in the cache.
+    EXPECT_THROW(cache_->updateLease4(leases[2]), NoSuchLease);
+    backend_->lookups_ = 0;
+    EXPECT_FALSE(cache_->getLease4(leases[2]->addr_));
+    EXPECT_EQ(1, backend_->lookups_);
+
+    EXPECT_TRUE(cache_->deleteLease(leases[1]->addr_));
+    EXPECT_FALSE(cache_->getLease4(leases[1]->addr_));
+    EXPECT_FALSE(backend_->getLease4(leases[1]->addr_));
+    EXPECT_FALSE(cache_->deleteLease(leases[1]->addr_));
+    EXPECT_EQ(0, cache_->getSize());
+}
+
+// Checks that the fetched lease is cached unless it has been written
+// during the lookup.
+TEST_F(CachingLeaseMgrTest, writeDuringLookup) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(backend_->addLease(leases[1]));
+    ASSERT_TRUE(backend_->addLease(leases[2]));
+    ASSERT_TRUE(backend_->addLease(leases[3]));
+    backend_->writer_ = cache_.get();
+
+    // The write of another lease doesn't prevent caching the fetched lease.
+    backend_->concurrent_write_.reset(new Lease4(*leases[2]));
+    ASSERT_TRUE(cache_->getLease4(leases[1]->addr_));
+    ASSERT_TRUE(cache_->getLease4(leases[1]->addr_));
+    EXPECT_EQ(1, backend_->lookups_);
+
+    // The fetched lease written during the lookup is outdated, so it
+    // must not replace the written lease in the cache.
+    Lease4Ptr renewed(new Lease4(*leases[3]));
+    renewed->valid_lft_ += 100;
+    backend_->concurrent_write_ = renewed;
+    Lease4Ptr lease = cache_->getLease4(leases[3]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(leases[3]->valid_lft_, lease->valid_lft_);
+    lease = cache_->getLease4(leases[3]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(renewed, lease);
+    EXPECT_EQ(2, backend_->lookups_);
+}
+
+// Checks that the least recently used leases are evicted from the full
+// cache.
+TEST_F(CachingLeaseMgrTest, lruEviction) {
+    open(V4, 2);
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(cache_->addLease(leases[1]));
+    ASSERT_TRUE(cache_->addLease(leases[2]));
+
+    // Use the first lease, so as the second one is evicted.
+    ASSERT_TRUE(cache_->getLease4(leases[1]->addr_));
+    ASSERT_TRUE(cache_->addLease(leases[3]));
+    EXPECT_EQ(2, cache_->getSize());
+
+    ASSERT_TRUE(cache_->getLease4(leases[1]->addr_));
+    ASSERT_TRUE(cache_->getLease4(leases[3]->addr_));
+    EXPECT_EQ(0, backend_->lookups_);
+
+    // The evicted lease is still in the backend.
+    ASSERT_TRUE(cache_->getLease4(leases[2]->addr_));
+    EXPECT_EQ(1, backend_->lookups_);
+    EXPECT_EQ(2, cache_->getSize());
+}
+
+// Checks that the cached DHCPv6 leases are matched by type.
+TEST_F(CachingLeaseMgrTest, lease6Type) {
+    open(V6, 4);
+    std::vector<Lease6Ptr> leases = createLeases6();
+    ASSERT_TRUE(cache_->addLease(leases[1]));
+
+    Lease6Ptr lease = cache_->getLease6(leases[1]->type_, leases[1]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases[1], lease);
+    EXPECT_EQ(0, backend_->lookups_);
+
+    const Lease::Type other_type = (leases[1]->type_ == Lease::TYPE_NA ?
+                                    Lease::TYPE_TA : Lease::TYPE_NA);
+    EXPECT_FALSE(cache_->getLease6(other_type, leases[1]->addr_));
+    EXPECT_EQ(1, backend_->lookups_);
+}
+
+// The following tests run the generic lease manager tests with the cache
+// of 4 leases, so as some of the leases used by the tests are evicted.
+// The tests expecting the SQL backend errors are not run, as the Memfile
+// backend doesn't report them.
+
+TEST_F(CachingLeaseMgrTest, basicLease4) {
+    testBasicLease4();
+}
+
+TEST_F(CachingLeaseMgrTest, getLease4ClientIdSubnetId) {
+    testGetLease4ClientIdSubnetId();
+}
+
+TEST_F(CachingLeaseMgrTest, getLease4ClientIdHWAddrSubnetId) {
+    testGetLease4ClientIdHWAddrSubnetId();
+}
+
+TEST_F(CachingLeaseMgrTest, recreateLease4) {
+    testRecreateLease4();
+}
+
+TEST_F(CachingLeaseMgrTest, asyncLease4) {
+    testAsyncLease4();
+}
+
+TEST_F(CachingLeaseMgrTest, basicLease6) {
+    open(V6, 4);
+    testBasicLease6();
+}
+
+TEST_F(CachingLeaseMgrTest, asyncLease6) {
+    open(V6, 4);
+    testAsyncLease6();
+}
+
+} // end of anonymous namespace
@@ -102,6 +102,22 @@ TEST(CalloutHandleStoreTest, StoreRetrieve) {
     EXPECT_EQ(1, pktptr_2.use_count());
 }
 
+// Checks that the releaser clears the pointers stored for the thread, so as
+// the packet and its handle are destroyed.
+TEST(CalloutHandleStoreTest, Releaser) {
+    Pkt4Ptr pktptr(new Pkt4(DHCPDISCOVER, 1234));
+    CalloutHandlePtr chptr;
+    {
+        CalloutHandleReleaser<Pkt4Ptr> releaser;
+        chptr = getCalloutHandle(pktptr);
+        ASSERT_TRUE(chptr);
+        EXPECT_EQ(2, pktptr.use_count());
+        EXPECT_EQ(2, chptr.use_count());
+    }
+    EXPECT_EQ(1, pktptr.use_count());
+    EXPECT_EQ(1, chptr.use_count());
+}
+
 // The followings is a trival test to check that if the template function
 // is referred to in a separate compilation unit, only one copy of the static
 // objects stored in it are returned.  (For a change, we'll use a Pkt6 as the
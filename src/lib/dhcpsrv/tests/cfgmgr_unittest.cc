@@ -525,6 +525,37 @@ TEST_F(CfgMgrTest, subnet4) {
     EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.85"), classify_));
 }
 
+// This test verifies that the first subnet in the configuration order is
+// selected when the subnets overlap, regardless of their prefix lengths.
+TEST_F(CfgMgrTest, subnet4Overlapping) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet4Ptr subnet1(new Subnet4(IOAddress("192.0.2.0"), 26, 1, 2, 3));
+    Subnet4Ptr subnet2(new Subnet4(IOAddress("192.0.0.0"), 16, 1, 2, 3));
+    Subnet4Ptr subnet3(new Subnet4(IOAddress("192.0.2.128"), 26, 1, 2, 3));
+    subnet3->setRelayInfo(IOAddress("192.0.2.10"));
+
+    cfg_mgr.addSubnet4(subnet1);
+    cfg_mgr.addSubnet4(subnet2);
+    cfg_mgr.addSubnet4(subnet3);
+
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet4(IOAddress("192.0.2.10"), classify_));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4(IOAddress("192.0.2.130"), classify_));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4(IOAddress("192.0.3.1"), classify_));
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet4(IOAddress("192.0.2.10"), classify_,
+                                          true));
+
+    // The subnet which doesn't support the client is skipped.
+    subnet1->allowClientClass("foo");
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4(IOAddress("192.0.2.10"), classify_));
+    subnet2->allowClientClass("foo");
+    EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.10"), classify_));
+
+    // The relay address matches the last subnet.
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnet4(IOAddress("192.0.2.10"), classify_,
+                                          true));
+}
+
 // This test verifies if the configuration manager is able to hold subnets with
 // their classifier information and return proper subnets, based on those
 // classes.
@@ -603,6 +634,7 @@ TEST_F(CfgMgrTest, subnet4RelayOverride) {
     subnet1->setRelayInfo(IOAddress("10.0.0.1"));
     subnet2->setRelayInfo(IOAddress("10.0.0.2"));
     subnet3->setRelayInfo(IOAddress("10.0.0.3"));
+    cfg_mgr.commitSubnets4();
 
     // And try again. This time relay-info is there and should match.
     EXPECT_EQ(subnet1, cfg_mgr.getSubnet4(IOAddress("10.0.0.1"), classify_, true));
@@ -639,6 +671,7 @@ TEST_F(CfgMgrTest, subnet6RelayOverride) {
     subnet1->setRelayInfo(IOAddress("2001:db8:ff::1"));
     subnet2->setRelayInfo(IOAddress("2001:db8:ff::2"));
     subnet3->setRelayInfo(IOAddress("2001:db8:ff::3"));
+    cfg_mgr.commitSubnets6();
 
     // And try again. This time relay-info is there and should match.
     EXPECT_EQ(subnet1, cfg_mgr.getSubnet6(IOAddress("2001:db8:ff::1"), classify_, true));
@@ -869,6 +902,40 @@ TEST_F(CfgMgrTest, subnet6Interface) {
     EXPECT_FALSE(cfg_mgr.getSubnet6("foobar", classify_));
 }
 
+// This test verifies that the subnets are selected using the interface
+// name and interface-id set after the subnets have been added, once the
+// subnets have been committed.
+TEST_F(CfgMgrTest, subnet6InterfaceChange) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet6Ptr subnet1(new Subnet6(IOAddress("2000::"), 48, 1, 2, 3, 4));
+    Subnet6Ptr subnet2(new Subnet6(IOAddress("3000::"), 48, 1, 2, 3, 4));
+    OptionPtr ifaceid1 = generateInterfaceId("relay1.eth0");
+    OptionPtr ifaceid2 = generateInterfaceId("VL32");
+    subnet1->setIface("foo");
+    subnet1->setInterfaceId(ifaceid1);
+
+    cfg_mgr.addSubnet6(subnet1);
+    cfg_mgr.addSubnet6(subnet2);
+
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet6("foo", classify_));
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet6(ifaceid1, classify_));
+    EXPECT_FALSE(cfg_mgr.getSubnet6("bar", classify_));
+    EXPECT_FALSE(cfg_mgr.getSubnet6(ifaceid2, classify_));
+
+    // Move the interface and interface-id to the second subnet.
+    subnet1->setIface("");
+    subnet1->setInterfaceId(OptionPtr());
+    subnet2->setIface("bar");
+    subnet2->setInterfaceId(ifaceid2);
+    cfg_mgr.commitSubnets6();
+
+    EXPECT_FALSE(cfg_mgr.getSubnet6("foo", classify_));
+    EXPECT_FALSE(cfg_mgr.getSubnet6(ifaceid1, classify_));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet6("bar", classify_));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet6(ifaceid2, classify_));
+}
+
 // This test verifies if the configuration manager is able to hold, select
 // and return valid leases, based on interface-id option values
 TEST_F(CfgMgrTest, subnet6InterfaceId) {
@@ -999,6 +1066,63 @@ TEST_F(CfgMgrTest, echoClientId) {
     EXPECT_TRUE(cfg_mgr.echoClientId());
 }
 
+// This test verifies that the number of packet processing threads may be
+// configured.
+TEST_F(CfgMgrTest, workerThreads) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    // Check that by default the packets are processed by the main thread.
+    EXPECT_EQ(0, cfg_mgr.workerThreads());
+
+    // Check that it can be modified.
+    cfg_mgr.workerThreads(4);
+    EXPECT_EQ(4, cfg_mgr.workerThreads());
+
+    // Check that the default value can be restored
+    cfg_mgr.workerThreads(0);
+    EXPECT_EQ(0, cfg_mgr.workerThreads());
+}
+
+// This test verifies that the parameters controlling the reclamation of
+// the expired leases can be set and retrieved.
+TEST_F(CfgMgrTest, reclaimParameters) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    // Check the default values.
+    EXPECT_EQ(CfgMgr::DEFAULT_RECLAIM_TIMER_WAIT_TIME,
+              cfg_mgr.reclaimTimerWaitTime());
+    EXPECT_EQ(CfgMgr::DEFAULT_MAX_RECLAIM_LEASES, cfg_mgr.maxReclaimLeases());
+    EXPECT_EQ(CfgMgr::DEFAULT_MAX_RECLAIM_TIME, cfg_mgr.maxReclaimTime());
+
+    // Check that they can be modified.
+    cfg_mgr.reclaimTimerWaitTime(20);
+    cfg_mgr.maxReclaimLeases(500);
+    cfg_mgr.maxReclaimTime(100);
+    EXPECT_EQ(20, cfg_mgr.reclaimTimerWaitTime());
+    EXPECT_EQ(500, cfg_mgr.maxReclaimLeases());
+    EXPECT_EQ(100, cfg_mgr.maxReclaimTime());
+
+    // Restore the default values.
+    cfg_mgr.reclaimTimerWaitTime(CfgMgr::DEFAULT_RECLAIM_TIMER_WAIT_TIME);
+    cfg_mgr.maxReclaimLeases(CfgMgr::DEFAULT_MAX_RECLAIM_LEASES);
+    cfg_mgr.maxReclaimTime(CfgMgr::DEFAULT_MAX_RECLAIM_TIME);
+}
+
+// This test verifies that the free address tracking can be enabled.
+TEST_F(CfgMgrTest, freeAddressTracking) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    // It is disabled by default.
+    EXPECT_FALSE(cfg_mgr.freeAddressTracking());
+
+    cfg_mgr.freeAddressTracking(true);
+    EXPECT_TRUE(cfg_mgr.freeAddressTracking());
+
+    // Restore the default value.
+    cfg_mgr.freeAddressTracking(false);
+    EXPECT_FALSE(cfg_mgr.freeAddressTracking());
+}
+
 // This test checks the D2ClientMgr wrapper methods.
 TEST_F(CfgMgrTest, d2ClientConfig) {
     // After CfgMgr construction, D2ClientMgr member should be initialized
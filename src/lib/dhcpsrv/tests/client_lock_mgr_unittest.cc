@@ -0,0 +1,200 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/client_lock_mgr.h>
+#include <dhcpsrv/worker_pool.h>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Test fixture class for @c ClientLockMgr.
+class ClientLockMgrTest : public ::testing::Test {
+public:
+
+    /// @brief Constructor.
+    ClientLockMgrTest()
+        : active_(0), max_active_(0), dropped_(0) {
+    }
+
+    /// @brief Simulates processing of a packet sent by the specified client.
+    ///
+    /// Records the maximum number of threads processing packets at the same
+    /// time.
+    ///
+    /// @param client_id Identifier of the client.
+    void process(const ClientLockMgr::ClientId& client_id) {
+        ClientLockMgr::Locker client_lock(lock_mgr_, client_id);
+        {
+            Mutex::Locker lock(mutex_);
+            ++active_;
+            max_active_ = std::max(max_active_, active_);
+        }
+        usleep(1000);
+        {
+            Mutex::Locker lock(mutex_);
+            --active_;
+        }
+    }
+
+    /// @brief Simulates processing of a packet by a server which drops
+    /// the packet if the client is busy.
+    ///
+    /// Records the number of dropped packets.
+    ///
+    /// @param client_id Identifier of the client.
+    void processOrDrop(const ClientLockMgr::ClientId& client_id) {
+        ClientLockMgr::Locker client_lock(lock_mgr_, client_id, false);
+        if (client_lock.busy()) {
+            Mutex::Locker lock(mutex_);
+            ++dropped_;
+            return;
+        }
+        usleep(1000);
+    }
+
+    /// @brief Lock manager under test.
+    ClientLockMgr lock_mgr_;
+
+    /// @brief Number of threads currently processing packets.
+    int active_;
+
+    /// @brief Maximum number of threads processing packets concurrently.
+    int max_active_;
+
+    /// @brief Number of packets dropped because the client was busy.
+    int dropped_;
+
+    /// @brief Mutex protecting the counters.
+    Mutex mutex_;
+};
+
+// This test verifies that the client is locked for the lifetime of
+// the locker object.
+TEST_F(ClientLockMgrTest, lockUnlock) {
+    ClientLockMgr::ClientId client1(6, 1);
+    ClientLockMgr::ClientId client2(6, 2);
+    {
+        ClientLockMgr::Locker lock(lock_mgr_, client1);
+        EXPECT_TRUE(lock_mgr_.isLocked(client1));
+        EXPECT_FALSE(lock_mgr_.isLocked(client2));
+    }
+    EXPECT_FALSE(lock_mgr_.isLocked(client1));
+
+    // Empty identifier is never locked.
+    ClientLockMgr::ClientId empty;
+    ClientLockMgr::Locker lock(lock_mgr_, empty);
+    EXPECT_FALSE(lock_mgr_.isLocked(empty));
+}
+
+// This test verifies that the non-blocking locker doesn't lock the client
+// locked by other locker and doesn't release it.
+TEST_F(ClientLockMgrTest, tryLock) {
+    ClientLockMgr::ClientId client1(6, 1);
+    ClientLockMgr::ClientId client2(6, 2);
+    {
+        ClientLockMgr::Locker lock1(lock_mgr_, client1, false);
+        EXPECT_FALSE(lock1.busy());
+        EXPECT_TRUE(lock_mgr_.isLocked(client1));
+        {
+            ClientLockMgr::Locker lock2(lock_mgr_, client1, false);
+            EXPECT_TRUE(lock2.busy());
+            ClientLockMgr::Locker lock3(lock_mgr_, client2, false);
+            EXPECT_FALSE(lock3.busy());
+        }
+        // The busy locker must not release the client locked by other
+        // locker.
+        EXPECT_TRUE(lock_mgr_.isLocked(client1));
+        EXPECT_FALSE(lock_mgr_.isLocked(client2));
+    }
+    EXPECT_FALSE(lock_mgr_.isLocked(client1));
+
+    // Empty identifier is never busy.
+    ClientLockMgr::ClientId empty;
+    ClientLockMgr::Locker lock1(lock_mgr_, empty, false);
+    ClientLockMgr::Locker lock2(lock_mgr_, empty, false);
+    EXPECT_FALSE(lock2.busy());
+}
+
+// This test verifies that the packets sent by a busy client are dropped
+// rather than holding the worker threads.
+TEST_F(ClientLockMgrTest, busyClient) {
+    // Lock the client as if its packet was being processed.
+    ClientLockMgr::ClientId client(6, 1);
+    ClientLockMgr::Locker lock(lock_mgr_, client);
+
+    WorkerPool pool;
+    ASSERT_NO_THROW(pool.start(4));
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(pool.add(boost::bind(&ClientLockMgrTest::processOrDrop,
+                                         this, client)));
+    }
+    // The packets from other clients are processed.
+    for (uint8_t i = 2; i <= 5; ++i) {
+        ASSERT_TRUE(pool.add(boost::bind(&ClientLockMgrTest::processOrDrop,
+                                         this, ClientLockMgr::ClientId(6, i))));
+    }
+    // This would never return if the workers waited for the client.
+    ASSERT_NO_THROW(pool.stop());
+    EXPECT_EQ(20, dropped_);
+    EXPECT_TRUE(lock_mgr_.isLocked(client));
+}
+
+// This test verifies that packets sent by the same client are never
+// processed concurrently.
+TEST_F(ClientLockMgrTest, sameClient) {
+    WorkerPool pool;
+    ASSERT_NO_THROW(pool.start(4));
+    ClientLockMgr::ClientId client(6, 1);
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(pool.add(boost::bind(&ClientLockMgrTest::process, this,
+                                         client)));
+    }
+    ASSERT_NO_THROW(pool.stop());
+    EXPECT_EQ(1, max_active_);
+    EXPECT_FALSE(lock_mgr_.isLocked(client));
+}
+
+// This test verifies that packets sent by different clients are processed
+// without waiting for each other.
+TEST_F(ClientLockMgrTest, differentClients) {
+    // Hold the lock for one client. This must not prevent processing
+    // packets from other clients.
+    ClientLockMgr::ClientId locked_client(6, 0);
+    ClientLockMgr::Locker lock(lock_mgr_, locked_client);
+
+    WorkerPool pool;
+    ASSERT_NO_THROW(pool.start(4));
+    for (uint8_t i = 1; i <= 20; ++i) {
+        ASSERT_TRUE(pool.add(boost::bind(&ClientLockMgrTest::process, this,
+                                         ClientLockMgr::ClientId(6, i))));
+    }
+    ASSERT_NO_THROW(pool.stop());
+    EXPECT_GE(max_active_, 1);
+    EXPECT_TRUE(lock_mgr_.isLocked(locked_client));
+}
+
+} // end of anonymous namespace
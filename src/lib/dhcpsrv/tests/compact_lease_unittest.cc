@@ -0,0 +1,156 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/compact_lease.h>
+
+#include <boost/functional/hash.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+
+namespace {
+
+// This test verifies that the short and long identifiers are stored,
+// copied and compared correctly.
+TEST(CompactIdTest, storage) {
+    CompactId empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(0, empty.size());
+
+    // Identifier stored inline.
+    std::vector<uint8_t> short_vec(6, 0xAB);
+    CompactId short_id(short_vec);
+    EXPECT_FALSE(short_id.empty());
+    EXPECT_TRUE(short_id.toVector() == short_vec);
+
+    // Identifier stored on the heap.
+    std::vector<uint8_t> long_vec(CompactId::INLINE_CAPACITY + 10, 0xCD);
+    long_vec[0] = 1;
+    CompactId long_id(long_vec);
+    EXPECT_TRUE(long_id.toVector() == long_vec);
+
+    // Copies are equal to the originals and have equal hashes.
+    CompactId short_copy(short_id);
+    CompactId long_copy(long_id);
+    EXPECT_TRUE(short_copy == short_id);
+    EXPECT_TRUE(long_copy == long_id);
+    EXPECT_TRUE(short_copy != long_copy);
+    EXPECT_EQ(boost::hash<CompactId>()(long_id),
+              boost::hash<CompactId>()(long_copy));
+
+    // Assignment replaces the long identifier with the short one and
+    // vice versa.
+    short_copy = long_id;
+    long_copy = short_id;
+    EXPECT_TRUE(short_copy == long_id);
+    EXPECT_TRUE(long_copy == short_id);
+
+    // The identifier must not be longer than 255 bytes.
+    EXPECT_THROW(CompactId(std::vector<uint8_t>(256, 1)), isc::BadValue);
+}
+
+// This test verifies that the strings are shared and removed from the
+// pool when they are no longer referenced.
+TEST(StringPoolTest, intern) {
+    StringPool pool;
+    {
+        InternedString empty = pool.intern("");
+        EXPECT_TRUE(empty.str().empty());
+        EXPECT_EQ(0, pool.size());
+
+        InternedString foo = pool.intern("foo.example.org");
+        InternedString bar = pool.intern("bar.example.org");
+        EXPECT_EQ(2, pool.size());
+        {
+            InternedString foo_copy = pool.intern("foo.example.org");
+            EXPECT_EQ(&foo.str(), &foo_copy.str());
+            EXPECT_EQ(2, pool.size());
+
+            foo_copy = bar;
+            EXPECT_EQ("bar.example.org", foo_copy.str());
+        }
+        EXPECT_EQ(2, pool.size());
+
+        bar = foo;
+        EXPECT_EQ("foo.example.org", bar.str());
+        EXPECT_EQ(1, pool.size());
+    }
+    EXPECT_EQ(0, pool.size());
+}
+
+// This test verifies that the DHCPv4 lease is converted to the compact
+// form and back without any loss.
+TEST(CompactLeaseTest, lease4) {
+    StringPool pool;
+    const uint8_t hwaddr[] = { 0, 1, 2, 3, 4, 5 };
+    const uint8_t clientid[] = { 1, 0, 1, 2, 3, 4, 5 };
+    Lease4 lease(IOAddress("192.0.2.3"), hwaddr, sizeof(hwaddr),
+                 clientid, sizeof(clientid), 3600, 900, 1800, 1234567,
+                 10, true, false, "myhost.example.org");
+    lease.ext_ = 7;
+    lease.fixed_ = true;
+    lease.comments_ = "comment";
+
+    CompactLease4 compact(lease, pool);
+    Lease4Ptr returned = compact.toLease();
+    ASSERT_TRUE(returned);
+    EXPECT_TRUE(*returned == lease);
+    EXPECT_EQ(lease.ext_, returned->ext_);
+    EXPECT_EQ(2, pool.size());
+
+    // The lease without client identifier.
+    lease.client_id_.reset();
+    lease.hostname_.clear();
+    CompactLease4 compact_no_clientid(lease, pool);
+    returned = compact_no_clientid.toLease();
+    ASSERT_TRUE(returned);
+    EXPECT_FALSE(returned->client_id_);
+    EXPECT_TRUE(*returned == lease);
+}
+
+// This test verifies that the DHCPv6 lease is converted to the compact
+// form and back without any loss.
+TEST(CompactLeaseTest, lease6) {
+    StringPool pool;
+    DuidPtr duid(new DUID(std::vector<uint8_t>(20, 0x42)));
+    Lease6 lease(Lease::TYPE_PD, IOAddress("2001:db8:1::"), duid, 123,
+                 1800, 3600, 900, 1200, 8, true, true, "myhost.example.org",
+                 56);
+    lease.cltt_ = 1234567;
+    lease.comments_ = "comment";
+
+    CompactLease6 compact(lease, pool);
+    Lease6Ptr returned = compact.toLease();
+    ASSERT_TRUE(returned);
+    EXPECT_TRUE(*returned == lease);
+    EXPECT_EQ(lease.type_, returned->type_);
+    EXPECT_EQ(lease.iaid_, returned->iaid_);
+    EXPECT_EQ(lease.prefixlen_, returned->prefixlen_);
+    ASSERT_TRUE(returned->duid_);
+    EXPECT_TRUE(*returned->duid_ == *duid);
+
+    // IPv4 address can't be converted to the IPv6 address.
+    EXPECT_THROW(CompactLease6::toAddress(IOAddress("192.0.2.1")),
+                 isc::BadValue);
+}
+
+} // end of anonymous namespace
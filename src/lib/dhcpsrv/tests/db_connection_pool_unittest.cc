@@ -0,0 +1,248 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/db_connection_pool.h>
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Connection object used in the tests.
+struct TestConnection {
+    /// @brief Constructor.
+    ///
+    /// @param id Identifier of the connection.
+    explicit TestConnection(const int id)
+        : id_(id), alive_(true) {
+    }
+
+    /// @brief Identifier of the connection, unique within the test.
+    int id_;
+
+    /// @brief Indicates if the health check should succeed.
+    bool alive_;
+};
+
+/// @brief Pool of the test connections.
+typedef DbConnectionPool<TestConnection> TestPool;
+
+/// @brief Test fixture class for @c DbConnectionPool.
+class DbConnectionPoolTest : public ::testing::Test {
+public:
+
+    /// @brief Constructor.
+    DbConnectionPoolTest()
+        : opened_(0), checked_(0), fail_open_(false), acquired_(false) {
+    }
+
+    /// @brief Connection factory counting the opened connections.
+    ///
+    /// @throw isc::Unexpected if @c fail_open_ is set.
+    TestPool::ConnectionPtr open() {
+        if (fail_open_) {
+            isc_throw(isc::Unexpected, "unable to open connection");
+        }
+        return (TestPool::ConnectionPtr(new TestConnection(++opened_)));
+    }
+
+    /// @brief Health check counting the checked connections.
+    bool check(TestConnection& conn) {
+        ++checked_;
+        return (conn.alive_);
+    }
+
+    /// @brief Creates the pool using the test factory and health check.
+    ///
+    /// @param size Number of connections in the pool.
+    /// @param check_interval Interval after which the idle connections are
+    /// checked.
+    TestPool* createPool(const size_t size, const time_t check_interval =
+                         TestPool::DEFAULT_CHECK_INTERVAL) {
+        return (new TestPool(boost::bind(&DbConnectionPoolTest::open, this),
+                             boost::bind(&DbConnectionPoolTest::check, this,
+                                         _1),
+                             size, check_interval));
+    }
+
+    /// @brief Checks out a connection and marks it acquired.
+    ///
+    /// @param pool Pool from which the connection is checked out.
+    void acquire(TestPool* pool) {
+        TestPool::Locker conn(*pool);
+        Mutex::Locker lock(mutex_);
+        acquired_ = true;
+    }
+
+    /// @brief Checks if the @c acquire function has checked out a
+    /// connection.
+    bool isAcquired() {
+        Mutex::Locker lock(mutex_);
+        return (acquired_);
+    }
+
+    /// @brief Number of opened connections.
+    int opened_;
+
+    /// @brief Number of performed health checks.
+    int checked_;
+
+    /// @brief Indicates if opening a connection should fail.
+    bool fail_open_;
+
+    /// @brief Indicates if the @c acquire function has completed.
+    bool acquired_;
+
+    /// @brief Mutex protecting the acquired flag.
+    Mutex mutex_;
+};
+
+// This test verifies that all connections are opened when the pool
+// is created.
+TEST_F(DbConnectionPoolTest, constructor) {
+    boost::scoped_ptr<TestPool> pool(createPool(4));
+    EXPECT_EQ(4, opened_);
+    EXPECT_EQ(4, pool->getSize());
+    EXPECT_EQ(4, pool->getIdleCount());
+
+    // The pool must hold at least one connection.
+    EXPECT_THROW(createPool(0), isc::BadValue);
+
+    // The errors opening the connections are propagated.
+    fail_open_ = true;
+    EXPECT_THROW(createPool(1), isc::Unexpected);
+}
+
+// This test verifies that the connections are checked out and returned.
+TEST_F(DbConnectionPoolTest, checkout) {
+    boost::scoped_ptr<TestPool> pool(createPool(2));
+    {
+        TestPool::Locker conn1(*pool);
+        EXPECT_EQ(1, pool->getIdleCount());
+        TestPool::Locker conn2(*pool);
+        EXPECT_EQ(0, pool->getIdleCount());
+
+        // Each thread gets its own connection.
+        EXPECT_NE(conn1->id_, conn2->id_);
+        EXPECT_EQ(conn1->id_, (*conn1).id_);
+    }
+    EXPECT_EQ(2, pool->getIdleCount());
+
+    // Healthy connections, used recently, are neither checked nor reopened.
+    EXPECT_EQ(0, checked_);
+    EXPECT_EQ(2, opened_);
+}
+
+// This test verifies that the connection is checked and reopened after
+// a failed operation.
+TEST_F(DbConnectionPoolTest, reopenAfterFailure) {
+    boost::scoped_ptr<TestPool> pool(createPool(1));
+
+    // The operation fails, but the connection is still alive.
+    try {
+        TestPool::Locker conn(*pool);
+        isc_throw(isc::Unexpected, "operation failed");
+    } catch (const isc::Unexpected&) {
+    }
+    {
+        TestPool::Locker conn(*pool);
+        EXPECT_EQ(1, checked_);
+        EXPECT_EQ(1, conn->id_);
+    }
+
+    // The connection is only checked once.
+    {
+        TestPool::Locker conn(*pool);
+        EXPECT_EQ(1, checked_);
+    }
+
+    // The operation fails because the connection is broken.
+    try {
+        TestPool::Locker conn(*pool);
+        conn->alive_ = false;
+        isc_throw(isc::Unexpected, "operation failed");
+    } catch (const isc::Unexpected&) {
+    }
+    TestPool::Locker conn(*pool);
+    EXPECT_EQ(2, checked_);
+    EXPECT_EQ(2, opened_);
+    EXPECT_EQ(2, conn->id_);
+    EXPECT_TRUE(conn->alive_);
+}
+
+// This test verifies that the connection which couldn't be reopened is
+// returned to the pool and reopened on the next checkout.
+TEST_F(DbConnectionPoolTest, reopenFailure) {
+    boost::scoped_ptr<TestPool> pool(createPool(1));
+    try {
+        TestPool::Locker conn(*pool);
+        conn->alive_ = false;
+        isc_throw(isc::Unexpected, "operation failed");
+    } catch (const isc::Unexpected&) {
+    }
+
+    fail_open_ = true;
+    EXPECT_THROW(TestPool::Locker conn(*pool), isc::Unexpected);
+    EXPECT_EQ(1, pool->getIdleCount());
+
+    fail_open_ = false;
+    TestPool::Locker conn(*pool);
+    EXPECT_EQ(2, conn->id_);
+}
+
+// This test verifies that the idle connection is checked before use.
+TEST_F(DbConnectionPoolTest, idleCheck) {
+    boost::scoped_ptr<TestPool> pool(createPool(1, 1));
+    {
+        TestPool::Locker conn(*pool);
+        conn->alive_ = false;
+    }
+    sleep(1);
+
+    TestPool::Locker conn(*pool);
+    EXPECT_EQ(1, checked_);
+    EXPECT_EQ(2, conn->id_);
+}
+
+// This test verifies that a thread waits for a connection when all
+// connections are in use.
+TEST_F(DbConnectionPoolTest, wait) {
+    boost::scoped_ptr<TestPool> pool(createPool(1));
+    boost::scoped_ptr<Thread> thread;
+    {
+        TestPool::Locker conn(*pool);
+        thread.reset(new Thread(boost::bind(&DbConnectionPoolTest::acquire,
+                                            this, pool.get())));
+        usleep(100000);
+        EXPECT_FALSE(isAcquired());
+    }
+    thread->wait();
+    EXPECT_TRUE(isAcquired());
+    EXPECT_EQ(1, pool->getIdleCount());
+}
+
+} // end of anonymous namespace
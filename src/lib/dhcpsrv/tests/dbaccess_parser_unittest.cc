@@ -87,10 +87,20 @@ public:
             }
 
             // Add the keyword and value - make sure that they are quoted.
-            // The only parameter which is not quoted is persist as it
-            // is a boolean value.
+            // The only parameters which are not quoted are persist,
+            // snapshot and pipeline, as they are boolean values, and
+            // lfc-interval, sync-interval, connections, the group commit
+            // parameters and cache-size, as they are integers.
             result += quote + keyval[i] + quote + colon + space;
-            if (std::string(keyval[i]) != "persist") {
+            if ((std::string(keyval[i]) != "persist") &&
+                (std::string(keyval[i]) != "snapshot") &&
+                (std::string(keyval[i]) != "pipeline") &&
+                (std::string(keyval[i]) != "lfc-interval") &&
+                (std::string(keyval[i]) != "sync-interval") &&
+                (std::string(keyval[i]) != "connections") &&
+                (std::string(keyval[i]) != "group-commit-size") &&
+                (std::string(keyval[i]) != "group-commit-delay") &&
+                (std::string(keyval[i]) != "cache-size")) {
                 result += quote + keyval[i + 1] + quote;
             } else {
                 result += keyval[i + 1];
@@ -281,6 +291,231 @@ TEST_F(DbAccessParserTest, persistV6Memfile) {
                       config, Option::V6);
 }
 
+// Check that the parser accepts the lease file cleanup interval.
+TEST_F(DbAccessParserTest, lfcInterval) {
+    const char* config[] = {"type", "memfile",
+                            "persist", "true",
+                            "lfc-interval", "3600",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+
+    checkAccessString("Valid memfile", parser.getDbAccessParameters(),
+                      config);
+}
+
+// Check that the parser rejects invalid lease file cleanup intervals.
+TEST_F(DbAccessParserTest, invalidLfcInterval) {
+    const char* negative[] = {"type", "memfile",
+                              "lfc-interval", "-1",
+                              NULL};
+    ConstElementPtr json_elements = Element::fromJSON(toJson(negative));
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+
+    const char* too_large[] = {"type", "memfile",
+                               "lfc-interval", "4294967296",
+                               NULL};
+    json_elements = Element::fromJSON(toJson(too_large));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+
+    const char* not_integer[] = {"type", "memfile",
+                                 "lfc-interval", "true",
+                                 NULL};
+    json_elements = Element::fromJSON(toJson(not_integer));
+    EXPECT_THROW(parser.build(json_elements), isc::data::TypeError);
+}
+
+// Check that the parser accepts the lease snapshot switch.
+TEST_F(DbAccessParserTest, snapshot) {
+    const char* config[] = {"type", "memfile",
+                            "lfc-interval", "3600",
+                            "snapshot", "true",
+                            NULL};
+
+    ConstElementPtr json_elements = Element::fromJSON(toJson(config));
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+
+    checkAccessString("Valid memfile", parser.getDbAccessParameters(),
+                      config);
+
+    // The snapshot switch is a boolean value.
+    const char* not_boolean[] = {"type", "memfile",
+                                 "snapshot", "1",
+                                 NULL};
+    json_elements = Element::fromJSON(toJson(not_boolean));
+    EXPECT_THROW(parser.build(json_elements), isc::data::TypeError);
+}
+
+// Check that the parser accepts the durability policy of the lease file.
+TEST_F(DbAccessParserTest, syncPolicy) {
+    const char* config[] = {"type", "memfile",
+                            "sync-policy", "interval",
+                            "sync-interval", "50",
+                            NULL};
+
+    ConstElementPtr json_elements = Element::fromJSON(toJson(config));
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+
+    checkAccessString("Valid memfile", parser.getDbAccessParameters(),
+                      config);
+
+    // The interval must be greater than 0.
+    const char* zero[] = {"type", "memfile",
+                          "sync-policy", "interval",
+                          "sync-interval", "0",
+                          NULL};
+    json_elements = Element::fromJSON(toJson(zero));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+}
+
+// Check that the parser accepts the number of database connections.
+TEST_F(DbAccessParserTest, connections) {
+    const char* config[] = {"type",        "mysql",
+                            "name",        "keatest",
+                            "connections", "8",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+    checkAccessString("Valid connections", parser.getDbAccessParameters(),
+                      config);
+}
+
+// Check that the parser rejects invalid numbers of database connections.
+TEST_F(DbAccessParserTest, invalidConnections) {
+    const char* zero[] = {"type", "mysql",
+                          "name", "keatest",
+                          "connections", "0",
+                          NULL};
+    ConstElementPtr json_elements = Element::fromJSON(toJson(zero));
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+
+    const char* too_large[] = {"type", "mysql",
+                               "name", "keatest",
+                               "connections", "65536",
+                               NULL};
+    json_elements = Element::fromJSON(toJson(too_large));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+
+    const char* not_integer[] = {"type", "mysql",
+                                 "name", "keatest",
+                                 "connections", "\"8\"",
+                                 NULL};
+    json_elements = Element::fromJSON(toJson(not_integer));
+    EXPECT_THROW(parser.build(json_elements), isc::data::TypeError);
+}
+
+// Check that the parser accepts the group commit parameters.
+TEST_F(DbAccessParserTest, groupCommit) {
+    const char* config[] = {"type",               "mysql",
+                            "name",               "keatest",
+                            "group-commit-size",  "64",
+                            "group-commit-delay", "2",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+    checkAccessString("Valid group commit", parser.getDbAccessParameters(),
+                      config);
+}
+
+// Check that the parser rejects invalid group commit parameters.
+TEST_F(DbAccessParserTest, invalidGroupCommit) {
+    const char* negative_size[] = {"type", "mysql",
+                                   "name", "keatest",
+                                   "group-commit-size", "-1",
+                                   NULL};
+    ConstElementPtr json_elements = Element::fromJSON(toJson(negative_size));
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+
+    const char* too_large_size[] = {"type", "mysql",
+                                    "name", "keatest",
+                                    "group-commit-size", "65536",
+                                    NULL};
+    json_elements = Element::fromJSON(toJson(too_large_size));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+
+    const char* too_large_delay[] = {"type", "mysql",
+                                     "name", "keatest",
+                                     "group-commit-delay", "60001",
+                                     NULL};
+    json_elements = Element::fromJSON(toJson(too_large_delay));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+
+    const char* not_integer[] = {"type", "mysql",
+                                 "name", "keatest",
+                                 "group-commit-delay", "true",
+                                 NULL};
+    json_elements = Element::fromJSON(toJson(not_integer));
+    EXPECT_THROW(parser.build(json_elements), isc::data::TypeError);
+}
+
+// Check that the parser accepts the lease cache size.
+TEST_F(DbAccessParserTest, cacheSize) {
+    const char* config[] = {"type",       "postgresql",
+                            "name",       "keatest",
+                            "cache-size", "100000",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+    checkAccessString("Valid cache size", parser.getDbAccessParameters(),
+                      config);
+
+    const char* negative[] = {"type", "postgresql",
+                              "name", "keatest",
+                              "cache-size", "-1",
+                              NULL};
+    json_elements = Element::fromJSON(toJson(negative));
+    EXPECT_THROW(parser.build(json_elements), isc::BadValue);
+}
+
+// Check that the parser accepts the pipelining switch.
+TEST_F(DbAccessParserTest, pipeline) {
+    const char* config[] = {"type",     "postgresql",
+                            "name",     "keatest",
+                            "pipeline", "true",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+    checkAccessString("Valid pipeline", parser.getDbAccessParameters(),
+                      config);
+
+    const char* not_boolean[] = {"type", "postgresql",
+                                 "name", "keatest",
+                                 "pipeline", "1",
+                                 NULL};
+    json_elements = Element::fromJSON(toJson(not_boolean));
+    EXPECT_THROW(parser.build(json_elements), isc::data::TypeError);
+}
+
 // Check that the parser works with a valid MySQL configuration
 TEST_F(DbAccessParserTest, validTypeMysql) {
     const char* config[] = {"type",     "mysql",
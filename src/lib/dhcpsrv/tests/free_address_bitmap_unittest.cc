@@ -0,0 +1,174 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/free_address_bitmap.h>
+
+#include <boost/lexical_cast.hpp>
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::asiolink;
+
+namespace {
+
+// This test verifies which ranges can be tracked.
+TEST(FreeAddressBitmapTest, canTrack) {
+    // IPv4 ranges.
+    EXPECT_TRUE(FreeAddressBitmap::canTrack(IOAddress("192.0.2.1"),
+                                            IOAddress("192.0.2.1")));
+    EXPECT_TRUE(FreeAddressBitmap::canTrack(IOAddress("10.0.0.0"),
+                                            IOAddress("10.255.255.255")));
+    EXPECT_FALSE(FreeAddressBitmap::canTrack(IOAddress("10.0.0.0"),
+                                             IOAddress("11.0.0.0")));
+    EXPECT_FALSE(FreeAddressBitmap::canTrack(IOAddress("192.0.2.10"),
+                                             IOAddress("192.0.2.1")));
+
+    // IPv6 address ranges.
+    EXPECT_TRUE(FreeAddressBitmap::canTrack(IOAddress("2001:db8:1::10"),
+                                            IOAddress("2001:db8:1::20")));
+    EXPECT_TRUE(FreeAddressBitmap::canTrack(IOAddress("2001:db8:1::"),
+                                            IOAddress("2001:db8:1::ff:ffff")));
+    EXPECT_FALSE(FreeAddressBitmap::canTrack(IOAddress("2001:db8:1::"),
+                                             IOAddress("2001:db8:1::1:0:0")));
+    EXPECT_FALSE(FreeAddressBitmap::canTrack(IOAddress("2001:db8:1::"),
+                                             IOAddress("2001:db8:1:0:ffff:ffff:ffff:ffff")));
+
+    // The range crossing the boundary of the lower 64 bits.
+    EXPECT_TRUE(FreeAddressBitmap::canTrack(IOAddress("2001:db8:1:0:ffff:ffff:ffff:fff0"),
+                                            IOAddress("2001:db8:1:1::10")));
+
+    // IPv6 prefix ranges.
+    EXPECT_TRUE(FreeAddressBitmap::canTrack(IOAddress("2001:db8::"),
+                                            IOAddress("2001:db8:0:ffff::"),
+                                            64));
+    EXPECT_FALSE(FreeAddressBitmap::canTrack(IOAddress("2001:db8::"),
+                                             IOAddress("2001:dbff:ffff:ffff::"),
+                                             64));
+    EXPECT_FALSE(FreeAddressBitmap::canTrack(IOAddress("2001:db8::"),
+                                             IOAddress("2001:db8::"), 0));
+
+    // Mixed families.
+    EXPECT_FALSE(FreeAddressBitmap::canTrack(IOAddress("192.0.2.1"),
+                                             IOAddress("2001:db8::1")));
+}
+
+// This test verifies that the bitmap can't be created for a range which
+// can't be tracked.
+TEST(FreeAddressBitmapTest, constructorInvalid) {
+    EXPECT_THROW(FreeAddressBitmap(IOAddress("192.0.2.10"),
+                                   IOAddress("192.0.2.1")), BadValue);
+    EXPECT_THROW(FreeAddressBitmap(IOAddress("10.0.0.0"),
+                                   IOAddress("11.0.0.0")), BadValue);
+}
+
+// This test verifies that the IPv4 addresses can be marked used and free
+// and that the free addresses are picked in the ascending order.
+TEST(FreeAddressBitmapTest, addresses4) {
+    FreeAddressBitmap bitmap(IOAddress("192.0.2.100"),
+                             IOAddress("192.0.2.199"));
+    EXPECT_EQ(100, bitmap.getCapacity());
+    EXPECT_EQ(100, bitmap.getFreeCount());
+    EXPECT_TRUE(bitmap.isFree(IOAddress("192.0.2.100")));
+    EXPECT_TRUE(bitmap.isFree(IOAddress("192.0.2.199")));
+
+    // Addresses out of range are rejected.
+    EXPECT_THROW(bitmap.isFree(IOAddress("192.0.2.99")), BadValue);
+    EXPECT_THROW(bitmap.markUsed(IOAddress("192.0.2.200")), BadValue);
+    EXPECT_THROW(bitmap.markFree(IOAddress("2001:db8::1")), BadValue);
+
+    // Picking an address doesn't mark it used.
+    EXPECT_EQ("192.0.2.100", bitmap.pickFree().toText());
+    EXPECT_EQ(100, bitmap.getFreeCount());
+
+    // The next address is picked because the search starts after the
+    // previously returned address.
+    EXPECT_EQ("192.0.2.101", bitmap.pickFree().toText());
+
+    // Mark the addresses up to 192.0.2.179 used.
+    for (uint32_t addr = 0xC0000264; addr < 0xC00002B4; ++addr) {
+        bitmap.markUsed(IOAddress(addr));
+        EXPECT_FALSE(bitmap.isFree(IOAddress(addr)));
+    }
+    EXPECT_EQ(20, bitmap.getFreeCount());
+    EXPECT_EQ("192.0.2.180", bitmap.pickFree().toText());
+
+    // Marking the address used twice doesn't change the counter.
+    bitmap.markUsed(IOAddress("192.0.2.100"));
+    EXPECT_EQ(20, bitmap.getFreeCount());
+
+    // Mark an address free again. It is picked after wrapping around.
+    bitmap.markFree(IOAddress("192.0.2.150"));
+    EXPECT_EQ(21, bitmap.getFreeCount());
+    bitmap.markFree(IOAddress("192.0.2.150"));
+    EXPECT_EQ(21, bitmap.getFreeCount());
+    for (int i = 181; i <= 199; ++i) {
+        EXPECT_EQ("192.0.2." + boost::lexical_cast<std::string>(i),
+                  bitmap.pickFree().toText());
+    }
+    EXPECT_EQ("192.0.2.150", bitmap.pickFree().toText());
+
+    // Mark all remaining addresses used.
+    for (int i = 180; i <= 199; ++i) {
+        bitmap.markUsed(IOAddress("192.0.2." +
+                                  boost::lexical_cast<std::string>(i)));
+    }
+    bitmap.markUsed(IOAddress("192.0.2.150"));
+    EXPECT_EQ(0, bitmap.getFreeCount());
+    EXPECT_THROW(bitmap.pickFree(), InvalidOperation);
+}
+
+// This test verifies that all addresses are returned once before any
+// address is returned again.
+TEST(FreeAddressBitmapTest, wrapAround) {
+    FreeAddressBitmap bitmap(IOAddress("2001:db8:1:0:ffff:ffff:ffff:ffc0"),
+                             IOAddress("2001:db8:1:1::3f"));
+    ASSERT_EQ(128, bitmap.getCapacity());
+
+    std::set<std::string> picked;
+    for (int i = 0; i < 128; ++i) {
+        IOAddress addr = bitmap.pickFree();
+        EXPECT_TRUE(bitmap.isFree(addr));
+        EXPECT_TRUE(picked.insert(addr.toText()).second)
+            << "address " << addr << " returned twice";
+    }
+    EXPECT_EQ(1, picked.count("2001:db8:1:0:ffff:ffff:ffff:ffff"));
+    EXPECT_EQ(1, picked.count("2001:db8:1:1::"));
+    EXPECT_EQ("2001:db8:1:0:ffff:ffff:ffff:ffc0",
+              bitmap.pickFree().toText());
+}
+
+// This test verifies that the bitmap can track delegated prefixes.
+TEST(FreeAddressBitmapTest, prefixes) {
+    FreeAddressBitmap bitmap(IOAddress("2001:db8:1::"),
+                             IOAddress("2001:db8:1:ff::"), 64);
+    EXPECT_EQ(256, bitmap.getCapacity());
+
+    bitmap.markUsed(IOAddress("2001:db8:1::"));
+    bitmap.markUsed(IOAddress("2001:db8:1:1::"));
+    EXPECT_EQ(254, bitmap.getFreeCount());
+    EXPECT_FALSE(bitmap.isFree(IOAddress("2001:db8:1:1::")));
+    EXPECT_TRUE(bitmap.isFree(IOAddress("2001:db8:1:ff::")));
+    EXPECT_EQ("2001:db8:1:2::", bitmap.pickFree().toText());
+
+    EXPECT_THROW(bitmap.isFree(IOAddress("2001:db8:1:100::")), BadValue);
+}
+
+} // end of anonymous namespace
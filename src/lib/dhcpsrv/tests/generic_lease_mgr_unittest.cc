@@ -16,8 +16,14 @@
 #include <dhcpsrv/tests/test_utils.h>
 #include <asiolink/io_address.h>
 #include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
 #include <sstream>
 
+#include <poll.h>
+
 using namespace std;
 using namespace isc::asiolink;
 
@@ -1564,6 +1570,436 @@ GenericLeaseMgrTest::testNullDuid() {
     ASSERT_THROW(lmptr_->addLease(leases[1]), DbOperationError);
 }
 
+void
+GenericLeaseMgrTest::testGetLeases4Subnet() {
+    // Get the leases to be used for the test and add them to the database.
+    vector<Lease4Ptr> leases = createLeases4();
+    for (int i = 0; i < leases.size(); ++i) {
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    // The leases 1 and 2 are the only ones belonging to the subnet 73.
+    Lease4Collection returned = lmptr_->getLeases4(leases[1]->subnet_id_);
+    ASSERT_EQ(2, returned.size());
+    vector<string> addresses;
+    for (Lease4Collection::const_iterator lease = returned.begin();
+         lease != returned.end(); ++lease) {
+        EXPECT_EQ(leases[1]->subnet_id_, (*lease)->subnet_id_);
+        addresses.push_back((*lease)->addr_.toText());
+    }
+    sort(addresses.begin(), addresses.end());
+    EXPECT_EQ(straddress4_[1], addresses[0]);
+    EXPECT_EQ(straddress4_[2], addresses[1]);
+
+    // There are no leases in this subnet.
+    returned = lmptr_->getLeases4(12345);
+    EXPECT_TRUE(returned.empty());
+}
+
+void
+GenericLeaseMgrTest::testGetLeases6Subnet() {
+    // Get the leases to be used for the test and add them to the database.
+    vector<Lease6Ptr> leases = createLeases6();
+    for (int i = 0; i < leases.size(); ++i) {
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    // The leases 1 and 2 are the only ones belonging to the subnet 73.
+    Lease6Collection returned = lmptr_->getLeases6(leases[1]->subnet_id_);
+    ASSERT_EQ(2, returned.size());
+    vector<string> addresses;
+    for (Lease6Collection::const_iterator lease = returned.begin();
+         lease != returned.end(); ++lease) {
+        EXPECT_EQ(leases[1]->subnet_id_, (*lease)->subnet_id_);
+        addresses.push_back((*lease)->addr_.toText());
+    }
+    sort(addresses.begin(), addresses.end());
+    EXPECT_EQ(straddress6_[1], addresses[0]);
+    EXPECT_EQ(straddress6_[2], addresses[1]);
+
+    // There are no leases in this subnet.
+    returned = lmptr_->getLeases6(12345);
+    EXPECT_TRUE(returned.empty());
+}
+
+void
+GenericLeaseMgrTest::testGetExpiredLeases4() {
+    // Get the leases to be used for the test.
+    vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_LE(6, leases.size());
+
+    // Make every other lease expired. The leases with the higher index
+    // expired earlier than the leases with the lower index.
+    const time_t current_time = time(NULL);
+    for (int i = 0; i < leases.size(); ++i) {
+        leases[i]->valid_lft_ = 1000;
+        if (i % 2 == 0) {
+            leases[i]->cltt_ = current_time - leases[i]->valid_lft_ -
+                10 * (i + 1);
+        } else {
+            leases[i]->cltt_ = current_time;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    // Retrieve all expired leases. The lease which expired first should
+    // be returned first.
+    Lease4Collection expired;
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases4(expired, 0));
+    ASSERT_EQ((leases.size() + 1) / 2, expired.size());
+    for (int i = 0; i < expired.size(); ++i) {
+        const int index = ((leases.size() - 1) / 2) * 2 - 2 * i;
+        EXPECT_EQ(leases[index]->addr_, expired[i]->addr_)
+            << "lease at position " << i << " returned in a wrong order";
+        EXPECT_TRUE(expired[i]->expired());
+    }
+
+    // Limit the number of leases to be returned.
+    expired.clear();
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases4(expired, 2));
+    ASSERT_EQ(2, expired.size());
+    const int first = ((leases.size() - 1) / 2) * 2;
+    EXPECT_EQ(leases[first]->addr_, expired[0]->addr_);
+    EXPECT_EQ(leases[first - 2]->addr_, expired[1]->addr_);
+
+    // Renew the lease which expired first. It should no longer be returned.
+    leases[first]->cltt_ = current_time;
+    ASSERT_NO_THROW(lmptr_->updateLease4(leases[first]));
+    lmptr_->commit();
+    expired.clear();
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases4(expired, 0));
+    ASSERT_EQ((leases.size() + 1) / 2 - 1, expired.size());
+    EXPECT_EQ(leases[first - 2]->addr_, expired[0]->addr_);
+
+    // Remove all expired leases. There should be none returned.
+    for (int i = 0; i < expired.size(); ++i) {
+        ASSERT_TRUE(lmptr_->deleteLease(expired[i]->addr_));
+    }
+    lmptr_->commit();
+    expired.clear();
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases4(expired, 0));
+    EXPECT_TRUE(expired.empty());
+}
+
+void
+GenericLeaseMgrTest::testGetExpiredLeases6() {
+    // Get the leases to be used for the test.
+    vector<Lease6Ptr> leases = createLeases6();
+    ASSERT_LE(6, leases.size());
+
+    // Make every other lease expired. The leases with the higher index
+    // expired earlier than the leases with the lower index.
+    const time_t current_time = time(NULL);
+    for (int i = 0; i < leases.size(); ++i) {
+        leases[i]->valid_lft_ = 1000;
+        if (i % 2 == 0) {
+            leases[i]->cltt_ = current_time - leases[i]->valid_lft_ -
+                10 * (i + 1);
+        } else {
+            leases[i]->cltt_ = current_time;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    // Retrieve all expired leases. The lease which expired first should
+    // be returned first.
+    Lease6Collection expired;
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases6(expired, 0));
+    ASSERT_EQ((leases.size() + 1) / 2, expired.size());
+    for (int i = 0; i < expired.size(); ++i) {
+        const int index = ((leases.size() - 1) / 2) * 2 - 2 * i;
+        EXPECT_EQ(leases[index]->addr_, expired[i]->addr_)
+            << "lease at position " << i << " returned in a wrong order";
+        EXPECT_TRUE(expired[i]->expired());
+    }
+
+    // Limit the number of leases to be returned.
+    expired.clear();
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases6(expired, 2));
+    ASSERT_EQ(2, expired.size());
+    const int first = ((leases.size() - 1) / 2) * 2;
+    EXPECT_EQ(leases[first]->addr_, expired[0]->addr_);
+    EXPECT_EQ(leases[first - 2]->addr_, expired[1]->addr_);
+
+    // Renew the lease which expired first. It should no longer be returned.
+    leases[first]->cltt_ = current_time;
+    ASSERT_NO_THROW(lmptr_->updateLease6(leases[first]));
+    lmptr_->commit();
+    expired.clear();
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases6(expired, 0));
+    ASSERT_EQ((leases.size() + 1) / 2 - 1, expired.size());
+    EXPECT_EQ(leases[first - 2]->addr_, expired[0]->addr_);
+
+    // Remove all expired leases. There should be none returned.
+    for (int i = 0; i < expired.size(); ++i) {
+        ASSERT_TRUE(lmptr_->deleteLease(expired[i]->addr_));
+    }
+    lmptr_->commit();
+    expired.clear();
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases6(expired, 0));
+    EXPECT_TRUE(expired.empty());
+}
+
+void
+GenericLeaseMgrTest::testDeleteExpiredLease4() {
+    // Get the leases to be used for the test.
+    vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_LE(2, leases.size());
+
+    // Make the first two leases expired.
+    const time_t current_time = time(NULL);
+    for (int i = 0; i < 2; ++i) {
+        leases[i]->valid_lft_ = 1000;
+        leases[i]->cltt_ = current_time - leases[i]->valid_lft_ - 10;
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    Lease4Collection expired;
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases4(expired, 0));
+    ASSERT_EQ(2, expired.size());
+
+    // Renew the first lease after it has been retrieved as expired.
+    leases[0]->cltt_ = current_time;
+    ASSERT_NO_THROW(lmptr_->updateLease4(leases[0]));
+    lmptr_->commit();
+
+    // The renewed lease must not be deleted.
+    EXPECT_FALSE(lmptr_->deleteExpiredLease(leases[0]->addr_));
+    lmptr_->commit();
+    Lease4Ptr lease = lmptr_->getLease4(leases[0]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(current_time, lease->cltt_);
+
+    // The lease which is still expired is deleted.
+    EXPECT_TRUE(lmptr_->deleteExpiredLease(leases[1]->addr_));
+    lmptr_->commit();
+    EXPECT_FALSE(lmptr_->deleteExpiredLease(leases[1]->addr_));
+}
+
+void
+GenericLeaseMgrTest::testDeleteExpiredLease6() {
+    // Get the leases to be used for the test.
+    vector<Lease6Ptr> leases = createLeases6();
+    ASSERT_LE(2, leases.size());
+
+    // Make the first two leases expired.
+    const time_t current_time = time(NULL);
+    for (int i = 0; i < 2; ++i) {
+        leases[i]->valid_lft_ = 1000;
+        leases[i]->cltt_ = current_time - leases[i]->valid_lft_ - 10;
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    Lease6Collection expired;
+    ASSERT_NO_THROW(lmptr_->getExpiredLeases6(expired, 0));
+    ASSERT_EQ(2, expired.size());
+
+    // Renew the first lease after it has been retrieved as expired.
+    leases[0]->cltt_ = current_time;
+    ASSERT_NO_THROW(lmptr_->updateLease6(leases[0]));
+    lmptr_->commit();
+
+    // The renewed lease must not be deleted.
+    EXPECT_FALSE(lmptr_->deleteExpiredLease(leases[0]->addr_));
+    lmptr_->commit();
+    Lease6Ptr lease = lmptr_->getLease6(leases[0]->type_,
+                                        leases[0]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(current_time, lease->cltt_);
+
+    // The lease which is still expired is deleted.
+    EXPECT_TRUE(lmptr_->deleteExpiredLease(leases[1]->addr_));
+    lmptr_->commit();
+    EXPECT_FALSE(lmptr_->deleteExpiredLease(leases[1]->addr_));
+}
+
+void
+GenericLeaseMgrTest::asyncLease4Callback(const Lease4Ptr& lease,
+                                         const std::string& error) {
+    async_leases4_.push_back(lease);
+    async_errors_.push_back(error);
+}
+
+void
+GenericLeaseMgrTest::asyncLease6Callback(const Lease6Ptr& lease,
+                                         const std::string& error) {
+    async_leases6_.push_back(lease);
+    async_errors_.push_back(error);
+}
+
+void
+GenericLeaseMgrTest::asyncResultCallback(bool result,
+                                         const std::string& error) {
+    async_results_.push_back(result);
+    async_errors_.push_back(error);
+}
+
+void
+GenericLeaseMgrTest::waitAsyncResults() {
+    // Give up after 10 seconds without any results.
+    while (lmptr_->getAsyncPendingCount() > 0) {
+        struct pollfd pfd;
+        pfd.fd = lmptr_->getAsyncSocket();
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        ASSERT_LT(0, poll(&pfd, 1, 10000)) << "timeout waiting for the"
+            " results of the asynchronous operations";
+        lmptr_->processAsyncResults();
+    }
+}
+
+void
+GenericLeaseMgrTest::testAsyncLease4() {
+    vector<Lease4Ptr> leases = createLeases4();
+
+    // Add the leases without waiting. Adding the existing lease is
+    // reported as the lease not being added rather than as an error.
+    for (int i = 0; i < leases.size(); ++i) {
+        lmptr_->asyncAddLease(leases[i],
+            boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this,
+                        _1, _2));
+    }
+    lmptr_->asyncAddLease(leases[0],
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    waitAsyncResults();
+    ASSERT_EQ(leases.size() + 1, async_results_.size());
+    for (int i = 0; i < leases.size(); ++i) {
+        EXPECT_TRUE(async_results_[i]) << "lease " << i << " not added";
+    }
+    EXPECT_FALSE(async_results_.back());
+
+    // Query the leases by address, including the one which doesn't exist,
+    // and by the client identifiers.
+    for (int i = 0; i < leases.size(); ++i) {
+        lmptr_->asyncGetLease4(leases[i]->addr_,
+            boost::bind(&GenericLeaseMgrTest::asyncLease4Callback, this,
+                        _1, _2));
+    }
+    lmptr_->asyncGetLease4(IOAddress("192.0.2.100"),
+        boost::bind(&GenericLeaseMgrTest::asyncLease4Callback, this, _1, _2));
+    lmptr_->asyncGetLease4(HWAddr(leases[1]->hwaddr_, HTYPE_ETHER),
+                           leases[1]->subnet_id_,
+        boost::bind(&GenericLeaseMgrTest::asyncLease4Callback, this, _1, _2));
+    lmptr_->asyncGetLease4(*leases[1]->client_id_, leases[1]->subnet_id_,
+        boost::bind(&GenericLeaseMgrTest::asyncLease4Callback, this, _1, _2));
+    waitAsyncResults();
+    ASSERT_EQ(leases.size() + 3, async_leases4_.size());
+    for (int i = 0; i < leases.size(); ++i) {
+        ASSERT_TRUE(async_leases4_[i]) << "lease " << i << " not returned";
+        detailCompareLease(leases[i], async_leases4_[i]);
+    }
+    EXPECT_FALSE(async_leases4_[leases.size()]);
+    ASSERT_TRUE(async_leases4_[leases.size() + 1]);
+    detailCompareLease(leases[1], async_leases4_[leases.size() + 1]);
+    ASSERT_TRUE(async_leases4_[leases.size() + 2]);
+    detailCompareLease(leases[1], async_leases4_[leases.size() + 2]);
+
+    // Update one lease and delete another, then check the results.
+    async_results_.clear();
+    async_leases4_.clear();
+    leases[2]->valid_lft_ = leases[2]->valid_lft_ + 100;
+    lmptr_->asyncUpdateLease4(leases[2],
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncDeleteLease(leases[3]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncDeleteLease(leases[3]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncUpdateLease4(leases[3],
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncGetLease4(leases[2]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncLease4Callback, this, _1, _2));
+    lmptr_->asyncGetLease4(leases[3]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncLease4Callback, this, _1, _2));
+    waitAsyncResults();
+    ASSERT_EQ(4, async_results_.size());
+    EXPECT_TRUE(async_results_[0]);
+    EXPECT_TRUE(async_results_[1]);
+    EXPECT_FALSE(async_results_[2]);
+    EXPECT_FALSE(async_results_[3]);
+    ASSERT_EQ(2, async_leases4_.size());
+    ASSERT_TRUE(async_leases4_[0]);
+    detailCompareLease(leases[2], async_leases4_[0]);
+    EXPECT_FALSE(async_leases4_[1]);
+
+    // None of the operations should have failed.
+    for (int i = 0; i < async_errors_.size(); ++i) {
+        EXPECT_TRUE(async_errors_[i].empty()) << async_errors_[i];
+    }
+}
+
+void
+GenericLeaseMgrTest::testAsyncLease6() {
+    vector<Lease6Ptr> leases = createLeases6();
+
+    // Add the leases without waiting, including a duplicate.
+    for (int i = 0; i < leases.size(); ++i) {
+        lmptr_->asyncAddLease(leases[i],
+            boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this,
+                        _1, _2));
+    }
+    lmptr_->asyncAddLease(leases[0],
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    waitAsyncResults();
+    ASSERT_EQ(leases.size() + 1, async_results_.size());
+    for (int i = 0; i < leases.size(); ++i) {
+        EXPECT_TRUE(async_results_[i]) << "lease " << i << " not added";
+    }
+    EXPECT_FALSE(async_results_.back());
+
+    // Query the leases by address, including the one which doesn't exist.
+    for (int i = 0; i < leases.size(); ++i) {
+        lmptr_->asyncGetLease6(leasetype6_[i], leases[i]->addr_,
+            boost::bind(&GenericLeaseMgrTest::asyncLease6Callback, this,
+                        _1, _2));
+    }
+    lmptr_->asyncGetLease6(Lease::TYPE_NA, IOAddress("2001:db8::100"),
+        boost::bind(&GenericLeaseMgrTest::asyncLease6Callback, this, _1, _2));
+    waitAsyncResults();
+    ASSERT_EQ(leases.size() + 1, async_leases6_.size());
+    for (int i = 0; i < leases.size(); ++i) {
+        ASSERT_TRUE(async_leases6_[i]) << "lease " << i << " not returned";
+        detailCompareLease(leases[i], async_leases6_[i]);
+    }
+    EXPECT_FALSE(async_leases6_.back());
+
+    // Update one lease and delete another, then check the results.
+    async_results_.clear();
+    async_leases6_.clear();
+    leases[2]->valid_lft_ = leases[2]->valid_lft_ + 100;
+    lmptr_->asyncUpdateLease6(leases[2],
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncDeleteLease(leases[3]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncDeleteLease(leases[3]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncUpdateLease6(leases[3],
+        boost::bind(&GenericLeaseMgrTest::asyncResultCallback, this, _1, _2));
+    lmptr_->asyncGetLease6(leasetype6_[2], leases[2]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncLease6Callback, this, _1, _2));
+    lmptr_->asyncGetLease6(leasetype6_[3], leases[3]->addr_,
+        boost::bind(&GenericLeaseMgrTest::asyncLease6Callback, this, _1, _2));
+    waitAsyncResults();
+    ASSERT_EQ(4, async_results_.size());
+    EXPECT_TRUE(async_results_[0]);
+    EXPECT_TRUE(async_results_[1]);
+    EXPECT_FALSE(async_results_[2]);
+    EXPECT_FALSE(async_results_[3]);
+    ASSERT_EQ(2, async_leases6_.size());
+    ASSERT_TRUE(async_leases6_[0]);
+    detailCompareLease(leases[2], async_leases6_[0]);
+    EXPECT_FALSE(async_leases6_[1]);
+
+    // None of the operations should have failed.
+    for (int i = 0; i < async_errors_.size(); ++i) {
+        EXPECT_TRUE(async_errors_[i].empty()) << async_errors_[i];
+    }
+}
 
 }; // namespace test
 }; // namespace dhcp
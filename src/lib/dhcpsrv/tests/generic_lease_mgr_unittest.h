@@ -255,6 +255,60 @@ public:
     /// @brief Verifies that a null DUID is not allowed.
     void testNullDuid();
 
+    /// @brief Checks that all DHCPv4 leases of a subnet can be retrieved.
+    void testGetLeases4Subnet();
+
+    /// @brief Checks that all DHCPv6 leases of a subnet can be retrieved.
+    void testGetLeases6Subnet();
+
+    /// @brief Checks that the expired DHCPv4 leases can be retrieved.
+    ///
+    /// This test adds a number of leases, every other of them expired,
+    /// and checks that the expired leases are returned in the order of
+    /// their expiration times and that the maximum number of leases to
+    /// be returned is respected.
+    void testGetExpiredLeases4();
+
+    /// @brief Checks that the expired DHCPv6 leases can be retrieved.
+    ///
+    /// See @c testGetExpiredLeases4 for the details.
+    void testGetExpiredLeases6();
+
+    /// @brief Checks that the expired DHCPv4 lease is not deleted if it
+    /// has been renewed after it was retrieved.
+    void testDeleteExpiredLease4();
+
+    /// @brief Checks that the expired DHCPv6 lease is not deleted if it
+    /// has been renewed after it was retrieved.
+    void testDeleteExpiredLease6();
+
+    /// @brief Checks the asynchronous operations on the DHCPv4 leases.
+    ///
+    /// This test starts many operations without waiting for their results
+    /// and checks that the results are passed to the callbacks in the order
+    /// in which the operations were started.
+    void testAsyncLease4();
+
+    /// @brief Checks the asynchronous operations on the DHCPv6 leases.
+    ///
+    /// See @c testAsyncLease4 for the details.
+    void testAsyncLease6();
+
+    /// @brief Callback recording the result of the asynchronous DHCPv4
+    /// lease query.
+    void asyncLease4Callback(const Lease4Ptr& lease, const std::string& error);
+
+    /// @brief Callback recording the result of the asynchronous DHCPv6
+    /// lease query.
+    void asyncLease6Callback(const Lease6Ptr& lease, const std::string& error);
+
+    /// @brief Callback recording the result of the asynchronous operation
+    /// modifying the lease database.
+    void asyncResultCallback(bool result, const std::string& error);
+
+    /// @brief Waits until all asynchronous operations complete.
+    void waitAsyncResults();
+
     /// @brief String forms of IPv4 addresses
     std::vector<std::string>  straddress4_;
 
@@ -270,6 +324,18 @@ public:
     /// @brief IOAddress forms of IPv6 addresses
     std::vector<isc::asiolink::IOAddress> ioaddress6_;
 
+    /// @brief DHCPv4 leases returned by the asynchronous queries
+    std::vector<Lease4Ptr> async_leases4_;
+
+    /// @brief DHCPv6 leases returned by the asynchronous queries
+    std::vector<Lease6Ptr> async_leases6_;
+
+    /// @brief Results of the asynchronous modifying operations
+    std::vector<bool> async_results_;
+
+    /// @brief Error messages passed to the asynchronous callbacks
+    std::vector<std::string> async_errors_;
+
     /// @brief Pointer to the lease manager
     LeaseMgr* lmptr_;
 };
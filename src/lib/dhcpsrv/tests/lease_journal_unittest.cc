@@ -0,0 +1,188 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+#include <asiolink/io_address.h>
+#include <dhcpsrv/csv_lease_file4.h>
+#include <dhcpsrv/lease_journal.h>
+#include <dhcpsrv/tests/lease_file_io.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::dhcp::test;
+
+namespace {
+
+// HWADDR value used by unit tests.
+const uint8_t HWADDR0[] = { 0, 1, 2, 3, 4, 5 };
+
+/// @brief Test fixture class for @c LeaseJournal.
+class LeaseJournalTest : public ::testing::Test {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// Removes the file used by unit tests.
+    LeaseJournalTest()
+        : io_(absolutePath("leases4.journal")) {
+        io_.removeFile();
+    }
+
+    /// @brief Prepends the absolute path to the file specified
+    /// as an argument.
+    ///
+    /// @param filename Name of the file.
+    /// @return Absolute path to the test file.
+    static std::string absolutePath(const std::string& filename) {
+        std::ostringstream s;
+        s << DHCP_DATA_DIR << "/" << filename;
+        return (s.str());
+    }
+
+    /// @brief Object providing access to the test file.
+    LeaseFileIO io_;
+};
+
+// This test checks that the policy names are converted.
+TEST_F(LeaseJournalTest, policyFromText) {
+    EXPECT_EQ(LeaseJournal::SYNC_WRITE, LeaseJournal::policyFromText("write"));
+    EXPECT_EQ(LeaseJournal::SYNC_INTERVAL,
+              LeaseJournal::policyFromText("interval"));
+    EXPECT_EQ(LeaseJournal::SYNC_OS, LeaseJournal::policyFromText("os"));
+    EXPECT_THROW(LeaseJournal::policyFromText("never"), BadValue);
+
+    // The interval must be specified for the interval policy.
+    EXPECT_THROW(LeaseJournal(io_.testfile_, LeaseJournal::SYNC_INTERVAL),
+                 BadValue);
+}
+
+// This test checks that each row is written and synchronized to disk with
+// the write policy.
+TEST_F(LeaseJournalTest, syncWrite) {
+    LeaseJournal journal(io_.testfile_, LeaseJournal::SYNC_WRITE);
+    EXPECT_THROW(journal.write("foo"), LeaseJournalError);
+
+    ASSERT_NO_THROW(journal.open());
+    ASSERT_NO_THROW(journal.write("foo,bar"));
+    EXPECT_EQ("foo,bar\n", io_.readFile());
+    ASSERT_NO_THROW(journal.write("baz"));
+    EXPECT_EQ("foo,bar\nbaz\n", io_.readFile());
+
+    LeaseJournal::Statistics stats = journal.getStatistics();
+    EXPECT_EQ(12, stats.bytes_written_);
+    EXPECT_EQ(2, stats.syncs_);
+    EXPECT_GE(stats.sync_time_, stats.max_sync_time_);
+
+    // Nothing is left to be synchronized when the journal is closed.
+    journal.close();
+    EXPECT_EQ(2, journal.getStatistics().syncs_);
+}
+
+// This test checks that the rows are written to the file without
+// synchronization with the os policy.
+TEST_F(LeaseJournalTest, syncOs) {
+    io_.writeFile("header\n");
+    LeaseJournal journal(io_.testfile_, LeaseJournal::SYNC_OS);
+    ASSERT_NO_THROW(journal.open());
+    ASSERT_NO_THROW(journal.write("foo"));
+    EXPECT_EQ("header\nfoo\n", io_.readFile());
+
+    journal.close();
+    LeaseJournal::Statistics stats = journal.getStatistics();
+    EXPECT_EQ(4, stats.bytes_written_);
+    EXPECT_EQ(0, stats.syncs_);
+}
+
+// This test checks that the rows are buffered and written together with
+// the interval policy.
+TEST_F(LeaseJournalTest, syncInterval) {
+    // The interval is long enough for the rows not to be written by the
+    // background thread during the test.
+    LeaseJournal journal(io_.testfile_, LeaseJournal::SYNC_INTERVAL, 60000,
+                         16);
+    ASSERT_NO_THROW(journal.open());
+    ASSERT_NO_THROW(journal.write("foo"));
+    ASSERT_NO_THROW(journal.write("bar"));
+    EXPECT_TRUE(io_.readFile().empty());
+
+    // The row which doesn't fit into the buffer is written together with
+    // the buffered rows.
+    ASSERT_NO_THROW(journal.write("0123456789"));
+    EXPECT_EQ("foo\nbar\n0123456789\n", io_.readFile());
+    EXPECT_EQ(19, journal.getStatistics().bytes_written_);
+
+    ASSERT_NO_THROW(journal.write("baz"));
+    ASSERT_NO_THROW(journal.sync());
+    EXPECT_EQ("foo\nbar\n0123456789\nbaz\n", io_.readFile());
+    EXPECT_EQ(1, journal.getStatistics().syncs_);
+
+    // The buffered rows are written when the journal is closed.
+    ASSERT_NO_THROW(journal.write("qux"));
+    journal.close();
+    EXPECT_EQ("foo\nbar\n0123456789\nbaz\nqux\n", io_.readFile());
+    EXPECT_EQ(2, journal.getStatistics().syncs_);
+}
+
+// This test checks that the buffered rows are written by the background
+// thread.
+TEST_F(LeaseJournalTest, syncIntervalThread) {
+    LeaseJournal journal(io_.testfile_, LeaseJournal::SYNC_INTERVAL, 10);
+    ASSERT_NO_THROW(journal.open());
+    ASSERT_NO_THROW(journal.write("foo"));
+
+    for (int i = 0; (i < 100) && (journal.getStatistics().syncs_ == 0); ++i) {
+        usleep(10000);
+    }
+    EXPECT_EQ(1, journal.getStatistics().syncs_);
+    EXPECT_EQ("foo\n", io_.readFile());
+}
+
+// This test checks that the lease file writes the leases through the
+// journal when the durability policy is set.
+TEST_F(LeaseJournalTest, leaseFile) {
+    CSVLeaseFile4 lease_file(io_.testfile_);
+    lease_file.setSyncPolicy(LeaseJournal::SYNC_INTERVAL, 60000);
+    ASSERT_TRUE(lease_file.getJournal());
+    ASSERT_NO_THROW(lease_file.recreate());
+
+    Lease4 lease(IOAddress("192.0.2.1"), HWADDR0, sizeof(HWADDR0), NULL, 0,
+                 200, 0, 0, 0, 8);
+    ASSERT_NO_THROW(lease_file.append(lease));
+    EXPECT_EQ("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+              "fqdn_fwd,fqdn_rev,hostname\n", io_.readFile());
+
+    lease_file.close();
+    EXPECT_EQ("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+              "fqdn_fwd,fqdn_rev,hostname\n"
+              "192.0.2.1,00:01:02:03:04:05,,200,200,8,0,0,\n",
+              io_.readFile());
+
+    // The leases appended after the file is reopened are written after
+    // the existing ones.
+    ASSERT_NO_THROW(lease_file.open());
+    lease.addr_ = IOAddress("192.0.2.2");
+    ASSERT_NO_THROW(lease_file.append(lease));
+    lease_file.close();
+    EXPECT_EQ("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+              "fqdn_fwd,fqdn_rev,hostname\n"
+              "192.0.2.1,00:01:02:03:04:05,,200,200,8,0,0,\n"
+              "192.0.2.2,00:01:02:03:04:05,,200,200,8,0,0,\n",
+              io_.readFile());
+}
+
+}; // end of anonymous namespace
@@ -140,6 +140,15 @@ public:
         return (Lease4Ptr());
     }
 
+    /// @brief Returns all IPv4 leases belonging to a subnet.
+    ///
+    /// @param subnet_id ignored
+    ///
+    /// @return an empty collection
+    virtual Lease4Collection getLeases4(SubnetID) const {
+        return (Lease4Collection());
+    }
+
     /// @brief Returns existing IPv6 lease for a given IPv6 address.
     ///
     /// @param addr address of the searched lease
@@ -173,6 +182,31 @@ public:
         return (leases6_);
     }
 
+    /// @brief Returns all IPv6 leases belonging to a subnet.
+    ///
+    /// @param subnet_id ignored
+    ///
+    /// @return whatever is set in leases6_ field
+    virtual Lease6Collection getLeases6(SubnetID) const {
+        return (leases6_);
+    }
+
+    /// @brief Returns expired DHCPv4 leases.
+    ///
+    /// This method is not implemented.
+    virtual void getExpiredLeases4(Lease4Collection&, const size_t) const {
+        isc_throw(NotImplemented, "ConcreteLeaseMgr::getExpiredLeases4 is not"
+                  " implemented");
+    }
+
+    /// @brief Returns expired DHCPv6 leases.
+    ///
+    /// This method is not implemented.
+    virtual void getExpiredLeases6(Lease6Collection&, const size_t) const {
+        isc_throw(NotImplemented, "ConcreteLeaseMgr::getExpiredLeases6 is not"
+                  " implemented");
+    }
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
@@ -197,6 +231,16 @@ public:
         return (false);
     }
 
+    /// @brief Deletes a lease if it has expired.
+    ///
+    /// @param addr Address of the lease to be deleted. (This can be either
+    ///        a V4 address or a V6 address.)
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    virtual bool deleteExpiredLease(const isc::asiolink::IOAddress&) {
+        return (false);
+    }
+
     /// @brief Returns backend type.
     ///
     /// Returns the type of the backend (e.g. "mysql", "memfile" etc.)
@@ -0,0 +1,209 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcpsrv/lease.h>
+#include <dhcpsrv/lease_snapshot.h>
+#include <dhcpsrv/tests/lease_file_io.h>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::dhcp::test;
+
+namespace {
+
+// HWADDR values used by unit tests.
+const uint8_t HWADDR0[] = { 0, 1, 2, 3, 4, 5 };
+const uint8_t HWADDR1[] = { 0xd, 0xe, 0xa, 0xd, 0xb, 0xe, 0xe, 0xf };
+
+const uint8_t CLIENTID0[] = { 1, 2, 3, 4 };
+
+const uint8_t DUID0[] = { 0, 1, 2, 3, 4, 5, 6, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf };
+
+/// @brief Test fixture class for @c LeaseSnapshot4 and @c LeaseSnapshot6.
+class LeaseSnapshotTest : public ::testing::Test {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// Initializes IO for the snapshot files used by unit tests.
+    LeaseSnapshotTest()
+        : io4_(absolutePath("leases4.snapshot")),
+          io6_(absolutePath("leases6.snapshot")) {
+        io4_.removeFile();
+        io6_.removeFile();
+    }
+
+    /// @brief Prepends the absolute path to the file specified
+    /// as an argument.
+    ///
+    /// @param filename Name of the file.
+    /// @return Absolute path to the test file.
+    static std::string absolutePath(const std::string& filename) {
+        std::ostringstream s;
+        s << DHCP_DATA_DIR << "/" << filename;
+        return (s.str());
+    }
+
+    /// @brief Writes the snapshot holding two DHCPv4 leases.
+    void writeSnapshot4() const {
+        LeaseSnapshot4 snapshot(io4_.testfile_);
+        snapshot.create();
+        snapshot.append(Lease4(IOAddress("192.0.2.1"), HWADDR0,
+                               sizeof(HWADDR0), CLIENTID0, sizeof(CLIENTID0),
+                               200, 0, 0, 1000, 8, true, false,
+                               "host.example.com"));
+        snapshot.append(Lease4(IOAddress("192.0.3.15"), HWADDR1,
+                               sizeof(HWADDR1), NULL, 0, 100, 0, 0, 2000, 7));
+        EXPECT_EQ(2, snapshot.getLeaseCount());
+        snapshot.close();
+    }
+
+    /// @brief Object providing access to the DHCPv4 snapshot.
+    LeaseFileIO io4_;
+
+    /// @brief Object providing access to the DHCPv6 snapshot.
+    LeaseFileIO io6_;
+};
+
+// This test checks that the DHCPv4 leases written to the snapshot are
+// read back.
+TEST_F(LeaseSnapshotTest, readWrite4) {
+    writeSnapshot4();
+    EXPECT_TRUE(LeaseSnapshot::isSnapshot(io4_.testfile_));
+
+    LeaseSnapshot4 snapshot(io4_.testfile_);
+    ASSERT_NO_THROW(snapshot.open());
+    EXPECT_EQ(2, snapshot.getLeaseCount());
+
+    Lease4Ptr lease;
+    ASSERT_TRUE(snapshot.next(lease));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.1", lease->addr_.toText());
+    EXPECT_TRUE(std::equal(HWADDR0, HWADDR0 + sizeof(HWADDR0),
+                           lease->hwaddr_.begin()));
+    ASSERT_TRUE(lease->client_id_);
+    EXPECT_EQ("01:02:03:04", lease->client_id_->toText());
+    EXPECT_EQ(200, lease->valid_lft_);
+    EXPECT_EQ(1000, lease->cltt_);
+    EXPECT_EQ(8, lease->subnet_id_);
+    EXPECT_TRUE(lease->fqdn_fwd_);
+    EXPECT_FALSE(lease->fqdn_rev_);
+    EXPECT_EQ("host.example.com", lease->hostname_);
+
+    ASSERT_TRUE(snapshot.next(lease));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.3.15", lease->addr_.toText());
+    EXPECT_EQ(sizeof(HWADDR1), lease->hwaddr_.size());
+    EXPECT_FALSE(lease->client_id_);
+    EXPECT_EQ(100, lease->valid_lft_);
+    EXPECT_EQ(2000, lease->cltt_);
+    EXPECT_EQ(7, lease->subnet_id_);
+    EXPECT_TRUE(lease->hostname_.empty());
+
+    // The end of the snapshot is signalled by the NULL lease.
+    EXPECT_TRUE(snapshot.next(lease));
+    EXPECT_FALSE(lease);
+    snapshot.close();
+}
+
+// This test checks that the DHCPv6 leases written to the snapshot are
+// read back.
+TEST_F(LeaseSnapshotTest, readWrite6) {
+    DuidPtr duid(new DUID(DUID0, sizeof(DUID0)));
+    {
+        LeaseSnapshot6 snapshot(io6_.testfile_);
+        snapshot.create();
+        Lease6 lease(Lease::TYPE_PD, IOAddress("2001:db8:2::"), duid, 7,
+                     150, 200, 0, 0, 8, false, true, "host.example.com", 64);
+        lease.cltt_ = 1000;
+        snapshot.append(lease);
+        snapshot.close();
+    }
+
+    LeaseSnapshot6 snapshot(io6_.testfile_);
+    ASSERT_NO_THROW(snapshot.open());
+    EXPECT_EQ(1, snapshot.getLeaseCount());
+
+    Lease6Ptr lease;
+    ASSERT_TRUE(snapshot.next(lease));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(Lease::TYPE_PD, lease->type_);
+    EXPECT_EQ("2001:db8:2::", lease->addr_.toText());
+    ASSERT_TRUE(lease->duid_);
+    EXPECT_TRUE(*duid == *lease->duid_);
+    EXPECT_EQ(7, lease->iaid_);
+    EXPECT_EQ(150, lease->preferred_lft_);
+    EXPECT_EQ(200, lease->valid_lft_);
+    EXPECT_EQ(1000, lease->cltt_);
+    EXPECT_EQ(8, lease->subnet_id_);
+    EXPECT_EQ(64, lease->prefixlen_);
+    EXPECT_FALSE(lease->fqdn_fwd_);
+    EXPECT_TRUE(lease->fqdn_rev_);
+    EXPECT_EQ("host.example.com", lease->hostname_);
+
+    EXPECT_TRUE(snapshot.next(lease));
+    EXPECT_FALSE(lease);
+}
+
+// This test checks that the empty snapshot is read.
+TEST_F(LeaseSnapshotTest, empty) {
+    {
+        LeaseSnapshot4 snapshot(io4_.testfile_);
+        snapshot.create();
+        snapshot.close();
+    }
+
+    LeaseSnapshot4 snapshot(io4_.testfile_);
+    ASSERT_NO_THROW(snapshot.open());
+    EXPECT_EQ(0, snapshot.getLeaseCount());
+    Lease4Ptr lease;
+    EXPECT_TRUE(snapshot.next(lease));
+    EXPECT_FALSE(lease);
+}
+
+// This test checks that the invalid snapshots are rejected.
+TEST_F(LeaseSnapshotTest, invalid) {
+    // The CSV file is not a snapshot.
+    io4_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,"
+                   "subnet_id,fqdn_fwd,fqdn_rev,hostname\n");
+    EXPECT_FALSE(LeaseSnapshot::isSnapshot(io4_.testfile_));
+    LeaseSnapshot4 snapshot4(io4_.testfile_);
+    EXPECT_THROW(snapshot4.open(), LeaseSnapshotError);
+
+    // The snapshot doesn't exist.
+    io4_.removeFile();
+    EXPECT_FALSE(LeaseSnapshot::isSnapshot(io4_.testfile_));
+    EXPECT_THROW(snapshot4.open(), LeaseSnapshotError);
+
+    // The DHCPv4 snapshot can't be read as the DHCPv6 snapshot.
+    writeSnapshot4();
+    LeaseSnapshot6 snapshot6(io4_.testfile_);
+    EXPECT_THROW(snapshot6.open(), LeaseSnapshotError);
+
+    // The truncated snapshot is rejected.
+    const std::string contents = io4_.readFile();
+    io4_.writeFile(contents.substr(0, contents.size() - 1));
+    EXPECT_TRUE(LeaseSnapshot::isSnapshot(io4_.testfile_));
+    EXPECT_THROW(snapshot4.open(), LeaseSnapshotError);
+    io4_.writeFile(contents.substr(0, 16));
+    EXPECT_THROW(snapshot4.open(), LeaseSnapshotError);
+}
+
+}; // end of anonymous namespace
@@ -17,14 +17,18 @@
 #include <asiolink/io_address.h>
 #include <dhcp/duid.h>
 #include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/lease_journal.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <dhcpsrv/lease_mgr_factory.h>
+#include <dhcpsrv/lease_snapshot.h>
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <dhcpsrv/tests/lease_file_io.h>
 #include <dhcpsrv/tests/test_utils.h>
 #include <dhcpsrv/tests/generic_lease_mgr_unittest.h>
 #include <gtest/gtest.h>
 
+#include <boost/weak_ptr.hpp>
+
 #include <iostream>
 #include <sstream>
 
@@ -142,6 +146,18 @@ TEST_F(MemfileLeaseMgrTest, constructor) {
     pmap["persist"] = "bogus";
     pmap["name"] = getLeaseFilePath("leasefile4_1.csv");
     EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), isc::BadValue);
+
+    // The lease file cleanup interval must be a non-negative number.
+    pmap["persist"] = "true";
+    pmap["lfc-interval"] = "bogus";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), isc::BadValue);
+
+    pmap["lfc-interval"] = "-1";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), isc::BadValue);
+
+    pmap["lfc-interval"] = "3600";
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)));
+    EXPECT_EQ(3600, lease_mgr->getLfcInterval());
 }
 
 // Checks if the getType() and getName() methods both return "memfile".
@@ -204,6 +220,386 @@ TEST_F(MemfileLeaseMgrTest, persistLeases) {
 }
 
 
+// Checks that the lease file cleanup removes redundant entries from the
+// DHCPv4 lease file and that the leases are loaded from the files it
+// produces.
+TEST_F(MemfileLeaseMgrTest, leaseFileCleanup4) {
+    LeaseFileIO io_input(io4_.testfile_ + ".1");
+    LeaseFileIO io_previous(io4_.testfile_ + ".2");
+    io_input.removeFile();
+    io_previous.removeFile();
+
+    // The first lease is updated, the second one is removed.
+    io4_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,"
+                   "subnet_id,fqdn_fwd,fqdn_rev,hostname\n"
+                   "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n"
+                   "192.0.2.2,06:07:08:09:0a:bd,,200,200,8,1,1,\n"
+                   "192.0.2.1,06:07:08:09:0a:bc,,300,300,8,1,1,\n"
+                   "192.0.2.2,06:07:08:09:0a:bd,,0,200,8,1,1,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    ASSERT_NO_THROW(lease_mgr->compactLeaseFiles());
+
+    // The leases are moved to the result of the cleanup and the lease
+    // file holds the header only.
+    EXPECT_FALSE(io_input.exists());
+    EXPECT_EQ("address,hwaddr,client_id,valid_lifetime,expire,"
+              "subnet_id,fqdn_fwd,fqdn_rev,hostname\n"
+              "192.0.2.1,06:07:08:09:0a:bc,,300,300,8,1,1,\n",
+              io_previous.readFile());
+    EXPECT_EQ("address,hwaddr,client_id,valid_lifetime,expire,"
+              "subnet_id,fqdn_fwd,fqdn_rev,hostname\n",
+              io4_.readFile());
+
+    // The new leases are written to the new lease file.
+    const uint8_t hwaddr[] = { 6, 7, 8, 9, 10, 0xbe };
+    Lease4Ptr lease(new Lease4(IOAddress("192.0.2.3"), hwaddr, sizeof(hwaddr),
+                               NULL, 0, 400, 100, 200, 0, 8));
+    ASSERT_TRUE(lease_mgr->addLease(lease));
+
+    // Both files are loaded when the lease manager is recreated.
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    Lease4Ptr returned = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(returned);
+    EXPECT_EQ(300, returned->valid_lft_);
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.2")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+
+    // The second cleanup merges the result of the first one with the
+    // new leases.
+    ASSERT_NO_THROW(lease_mgr->compactLeaseFiles());
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.1")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+}
+
+// Checks that the update of the DHCPv4 lease which would conflict with
+// another lease fails before the lease is written to the lease file, and
+// that the conflicting leases in the lease file are ignored.
+TEST_F(MemfileLeaseMgrTest, updateLease4Conflict) {
+    const std::string contents =
+        "address,hwaddr,client_id,valid_lifetime,expire,"
+        "subnet_id,fqdn_fwd,fqdn_rev,hostname\n"
+        "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n"
+        "192.0.2.2,06:07:08:09:0a:bd,,200,200,8,1,1,\n";
+    io4_.writeFile(contents);
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    // Use the hardware address of the second lease in the first one.
+    Lease4Ptr lease = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(lease);
+    const std::vector<uint8_t> hwaddr = lease->hwaddr_;
+    lease->hwaddr_[5] = 0xbd;
+    EXPECT_THROW(lease_mgr->updateLease4(lease), DbOperationError);
+
+    // Neither the stored lease nor the lease file have been modified.
+    Lease4Ptr returned = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(returned);
+    EXPECT_TRUE(hwaddr == returned->hwaddr_);
+    lease_mgr.reset();
+    EXPECT_EQ(contents, io4_.readFile());
+
+    // The lease conflicting with another lease in the lease file is
+    // ignored and the previous version of the lease is kept.
+    io4_.writeFile(contents +
+                   "192.0.2.1,06:07:08:09:0a:bd,,300,300,8,1,1,\n"
+                   "192.0.2.3,06:07:08:09:0a:bc,,300,300,8,1,1,\n");
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    returned = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(returned);
+    EXPECT_TRUE(hwaddr == returned->hwaddr_);
+    EXPECT_EQ(200, returned->valid_lft_);
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+}
+
+// Checks that the lease whose hardware address and subnet id are in use by
+// another lease isn't added and isn't written to the lease file.
+TEST_F(MemfileLeaseMgrTest, addLease4Conflict) {
+    const std::string contents =
+        "address,hwaddr,client_id,valid_lifetime,expire,"
+        "subnet_id,fqdn_fwd,fqdn_rev,hostname\n"
+        "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n";
+    io4_.writeFile(contents);
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    Lease4Ptr lease = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(lease);
+    lease->addr_ = IOAddress("192.0.2.2");
+    EXPECT_FALSE(lease_mgr->addLease(lease));
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.2")));
+
+    // The lease in another subnet is added.
+    lease->subnet_id_ = 9;
+    EXPECT_TRUE(lease_mgr->addLease(lease));
+    lease_mgr.reset();
+    EXPECT_EQ(contents, io4_.readFile().substr(0, contents.size()));
+    EXPECT_EQ(std::string::npos,
+              io4_.readFile().find("192.0.2.2,06:07:08:09:0a:bc,,200,200,8"));
+}
+
+// Checks that the lease holding the address of the other family is neither
+// added nor updated.
+TEST_F(MemfileLeaseMgrTest, addLeaseInvalidFamily) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["persist"] = "false";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    Lease4Ptr lease4 = initializeLease4(straddress4_[1]);
+    lease4->addr_ = IOAddress("2001:db8::1");
+    bool added = true;
+    ASSERT_NO_THROW(added = lease_mgr->addLease(lease4));
+    EXPECT_FALSE(added);
+    EXPECT_THROW(lease_mgr->updateLease4(lease4), NoSuchLease);
+
+    pmap["universe"] = "6";
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+
+    Lease6Ptr lease6 = initializeLease6(straddress6_[1]);
+    lease6->addr_ = IOAddress("192.0.2.1");
+    added = true;
+    ASSERT_NO_THROW(added = lease_mgr->addLease(lease6));
+    EXPECT_FALSE(added);
+    EXPECT_THROW(lease_mgr->updateLease6(lease6), NoSuchLease);
+    EXPECT_FALSE(lease_mgr->deleteLease(IOAddress("192.0.2.1")));
+}
+
+// Checks that the lease file cleanup removes redundant entries from the
+// DHCPv6 lease file.
+TEST_F(MemfileLeaseMgrTest, leaseFileCleanup6) {
+    LeaseFileIO io_input(io6_.testfile_ + ".1");
+    LeaseFileIO io_previous(io6_.testfile_ + ".2");
+    io_input.removeFile();
+    io_previous.removeFile();
+
+    io6_.writeFile("address,duid,valid_lifetime,expire,subnet_id,"
+                   "pref_lifetime,lease_type,iaid,prefix_len,fqdn_fwd,"
+                   "fqdn_rev,hostname\n"
+                   "2001:db8:1::1,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "200,200,8,100,0,7,0,1,1,\n"
+                   "2001:db8:1::2,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "200,200,8,100,0,7,0,1,1,\n"
+                   "2001:db8:1::1,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "0,200,8,100,0,7,0,1,1,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "6";
+    pmap["name"] = io6_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    ASSERT_NO_THROW(lease_mgr->compactLeaseFiles());
+
+    EXPECT_FALSE(io_input.exists());
+    EXPECT_EQ("address,duid,valid_lifetime,expire,subnet_id,"
+              "pref_lifetime,lease_type,iaid,prefix_len,fqdn_fwd,"
+              "fqdn_rev,hostname\n"
+              "2001:db8:1::2,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+              "200,200,8,100,0,7,0,1,1,\n",
+              io_previous.readFile());
+
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->getLease6(Lease::TYPE_NA,
+                                      IOAddress("2001:db8:1::1")));
+    EXPECT_TRUE(lease_mgr->getLease6(Lease::TYPE_NA,
+                                     IOAddress("2001:db8:1::2")));
+}
+
+// Checks that the lease file cleanup writes the binary lease snapshot
+// when configured to do so and that the leases are loaded from it.
+TEST_F(MemfileLeaseMgrTest, leaseFileSnapshot4) {
+    LeaseFileIO io_previous(io4_.testfile_ + ".2");
+    io_previous.removeFile();
+
+    // The result of the previous cleanup is the CSV file.
+    io_previous.writeFile("address,hwaddr,client_id,valid_lifetime,expire,"
+                          "subnet_id,fqdn_fwd,fqdn_rev,hostname\n"
+                          "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n"
+                          "192.0.2.2,06:07:08:09:0a:bd,,200,200,8,1,1,\n");
+    io4_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,"
+                   "subnet_id,fqdn_fwd,fqdn_rev,hostname\n"
+                   "192.0.2.1,06:07:08:09:0a:bc,01:02:03:04,300,400,8,1,0,"
+                   "host.example.com\n"
+                   "192.0.2.2,06:07:08:09:0a:bd,,0,200,8,1,1,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    pmap["snapshot"] = "true";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    EXPECT_TRUE(lease_mgr->useSnapshot());
+    ASSERT_NO_THROW(lease_mgr->compactLeaseFiles());
+    EXPECT_TRUE(LeaseSnapshot::isSnapshot(io_previous.testfile_));
+
+    // The lease written after the snapshot is loaded along with it.
+    const uint8_t hwaddr[] = { 6, 7, 8, 9, 10, 0xbe };
+    Lease4Ptr lease(new Lease4(IOAddress("192.0.2.3"), hwaddr, sizeof(hwaddr),
+                               NULL, 0, 400, 100, 200, 0, 8));
+    ASSERT_TRUE(lease_mgr->addLease(lease));
+
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    Lease4Ptr returned = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(returned);
+    EXPECT_EQ(300, returned->valid_lft_);
+    EXPECT_EQ(100, returned->cltt_);
+    ASSERT_TRUE(returned->client_id_);
+    EXPECT_EQ("01:02:03:04", returned->client_id_->toText());
+    EXPECT_TRUE(returned->fqdn_fwd_);
+    EXPECT_FALSE(returned->fqdn_rev_);
+    EXPECT_EQ("host.example.com", returned->hostname_);
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.2")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+
+    // The next cleanup merges the snapshot with the new leases. When the
+    // snapshot is disabled, the CSV file is written again.
+    pmap["snapshot"] = "false";
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    ASSERT_NO_THROW(lease_mgr->compactLeaseFiles());
+    EXPECT_FALSE(LeaseSnapshot::isSnapshot(io_previous.testfile_));
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.1")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+
+    // The value of the snapshot parameter is verified.
+    pmap["snapshot"] = "yes";
+    EXPECT_THROW(Memfile_LeaseMgr lease_mgr(pmap), isc::BadValue);
+}
+
+// Checks that the lease file cleanup writes the binary snapshot of the
+// DHCPv6 leases.
+TEST_F(MemfileLeaseMgrTest, leaseFileSnapshot6) {
+    LeaseFileIO io_previous(io6_.testfile_ + ".2");
+    io_previous.removeFile();
+
+    io6_.writeFile("address,duid,valid_lifetime,expire,subnet_id,"
+                   "pref_lifetime,lease_type,iaid,prefix_len,fqdn_fwd,"
+                   "fqdn_rev,hostname\n"
+                   "2001:db8:1::1,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "200,200,8,100,0,7,0,1,1,\n"
+                   "2001:db8:2::,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "200,300,8,100,2,7,64,0,1,host.example.com\n"
+                   "2001:db8:1::1,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "0,200,8,100,0,7,0,1,1,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "6";
+    pmap["name"] = io6_.testfile_;
+    pmap["snapshot"] = "true";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    ASSERT_NO_THROW(lease_mgr->compactLeaseFiles());
+    EXPECT_TRUE(LeaseSnapshot::isSnapshot(io_previous.testfile_));
+
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->getLease6(Lease::TYPE_NA,
+                                      IOAddress("2001:db8:1::1")));
+    Lease6Ptr returned = lease_mgr->getLease6(Lease::TYPE_PD,
+                                              IOAddress("2001:db8:2::"));
+    ASSERT_TRUE(returned);
+    EXPECT_EQ(64, returned->prefixlen_);
+    EXPECT_EQ(7, returned->iaid_);
+    EXPECT_EQ(100, returned->preferred_lft_);
+    EXPECT_EQ(200, returned->valid_lft_);
+    EXPECT_EQ(100, returned->cltt_);
+    EXPECT_FALSE(returned->fqdn_fwd_);
+    EXPECT_TRUE(returned->fqdn_rev_);
+    EXPECT_EQ("host.example.com", returned->hostname_);
+}
+
+// Checks that the lease changes are written through the lease journal
+// with the configured durability policy.
+TEST_F(MemfileLeaseMgrTest, syncPolicy) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    pmap["sync-policy"] = "write";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    LeaseJournalPtr journal = lease_mgr->getLeaseJournal(Memfile_LeaseMgr::V4);
+    ASSERT_TRUE(journal);
+    EXPECT_EQ(LeaseJournal::SYNC_WRITE, journal->getSyncPolicy());
+
+    const uint8_t hwaddr[] = { 6, 7, 8, 9, 10, 0xbe };
+    Lease4Ptr lease(new Lease4(IOAddress("192.0.2.3"), hwaddr, sizeof(hwaddr),
+                               NULL, 0, 400, 100, 200, 0, 8));
+    ASSERT_TRUE(lease_mgr->addLease(lease));
+    EXPECT_EQ(1, journal->getStatistics().syncs_);
+    EXPECT_EQ("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+              "fqdn_fwd,fqdn_rev,hostname\n"
+              "192.0.2.3,06:07:08:09:0a:be,,400,400,8,0,0,\n",
+              io4_.readFile());
+
+    // The buffered changes are written when the lease manager is destroyed
+    // and they are loaded by the new instance.
+    pmap["sync-policy"] = "interval";
+    pmap["sync-interval"] = "60000";
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    ASSERT_TRUE(lease_mgr->deleteLease(lease->addr_));
+    lease_mgr.reset();
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->getLease4(lease->addr_));
+
+    // Invalid values are rejected.
+    lease_mgr.reset();
+    pmap["sync-interval"] = "0";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), BadValue);
+    pmap["sync-interval"] = "100";
+    pmap["sync-policy"] = "never";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), BadValue);
+}
+
+// Checks that the files left by the interrupted lease file cleanup are
+// recovered when the leases are loaded.
+TEST_F(MemfileLeaseMgrTest, leaseFileCleanupRecover) {
+    const std::string header = "address,hwaddr,client_id,valid_lifetime,"
+        "expire,subnet_id,fqdn_fwd,fqdn_rev,hostname\n";
+    LeaseFileIO io_input(io4_.testfile_ + ".1");
+    LeaseFileIO io_previous(io4_.testfile_ + ".2");
+    LeaseFileIO io_output(io4_.testfile_ + ".output");
+    LeaseFileIO io_finish(io4_.testfile_ + ".completed");
+
+    // The cleanup has written all leases to the finish file, so the input
+    // files are stale.
+    io_input.writeFile(header + "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n");
+    io_previous.writeFile(header +
+                          "192.0.2.2,06:07:08:09:0a:bd,,200,200,8,1,1,\n");
+    io_finish.writeFile(header +
+                        "192.0.2.3,06:07:08:09:0a:be,,200,200,8,1,1,\n");
+    io_output.writeFile(header);
+    io4_.writeFile(header + "192.0.2.4,06:07:08:09:0a:bf,,200,200,8,1,1,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    EXPECT_FALSE(io_input.exists());
+    EXPECT_FALSE(io_output.exists());
+    EXPECT_FALSE(io_finish.exists());
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.1")));
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.2")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.4")));
+
+    // The cleanup was interrupted before the finish file was written, so
+    // both input files are loaded.
+    io_input.writeFile(header + "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n");
+    io_output.writeFile(header);
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(io_output.exists());
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.1")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.4")));
+}
+
+
 // Checks that adding/getting/deleting a Lease6 object works.
 TEST_F(MemfileLeaseMgrTest, addGetDelete6) {
     startBackend(V6);
@@ -404,6 +800,164 @@ TEST_F(MemfileLeaseMgrTest, testRecreateLease6) {
     testRecreateLease6();
 }
 
+/// @brief Checks that all DHCPv4 leases of a subnet can be retrieved.
+TEST_F(MemfileLeaseMgrTest, getLeases4Subnet) {
+    startBackend(V4);
+    testGetLeases4Subnet();
+}
+
+/// @brief Checks that all DHCPv6 leases of a subnet can be retrieved.
+TEST_F(MemfileLeaseMgrTest, getLeases6Subnet) {
+    startBackend(V6);
+    testGetLeases6Subnet();
+}
+
+/// @brief Checks that the expired DHCPv4 leases are returned in the order
+/// of their expiration times.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases4) {
+    startBackend(V4);
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that the expired DHCPv6 leases are returned in the order
+/// of their expiration times.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases6) {
+    startBackend(V6);
+    testGetExpiredLeases6();
+}
+
+/// @brief Checks that the expired DHCPv4 lease is not deleted if it has
+/// been renewed after it was retrieved.
+TEST_F(MemfileLeaseMgrTest, deleteExpiredLease4) {
+    startBackend(V4);
+    testDeleteExpiredLease4();
+}
+
+/// @brief Checks that the expired DHCPv6 lease is not deleted if it has
+/// been renewed after it was retrieved.
+TEST_F(MemfileLeaseMgrTest, deleteExpiredLease6) {
+    startBackend(V6);
+    testDeleteExpiredLease6();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv4 leases.
+TEST_F(MemfileLeaseMgrTest, asyncLease4) {
+    startBackend(V4);
+    testAsyncLease4();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv6 leases.
+TEST_F(MemfileLeaseMgrTest, asyncLease6) {
+    startBackend(V6);
+    testAsyncLease6();
+}
+
+/// @brief Checks that the readers share the immutable DHCPv4 lease and
+/// that the update replaces it with the new version.
+TEST_F(MemfileLeaseMgrTest, getConstLease4) {
+    startBackend(V4);
+    vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+
+    // The lookups by the address, hardware address and client identifier
+    // return the same object, holding the stored lease.
+    ConstLease4Ptr lease = lmptr_->getConstLease4(ioaddress4_[1]);
+    ASSERT_TRUE(lease);
+    EXPECT_TRUE(*lease == *leases[1]);
+    EXPECT_EQ(lease, lmptr_->getConstLease4(ioaddress4_[1]));
+    ConstLease4Ptr by_hwaddr =
+        lmptr_->getConstLease4(HWAddr(leases[1]->hwaddr_, HTYPE_ETHER),
+                               leases[1]->subnet_id_);
+    EXPECT_EQ(lease, by_hwaddr);
+    ConstLease4Ptr by_clientid =
+        lmptr_->getConstLease4(*leases[1]->client_id_, leases[1]->subnet_id_);
+    EXPECT_EQ(lease, by_clientid);
+
+    // The mutable getter returns a private copy.
+    EXPECT_NE(lease.get(), lmptr_->getLease4(ioaddress4_[1]).get());
+
+    // The storage doesn't keep the shared object: it is destroyed when
+    // the readers release it and the next lookup creates a new one.
+    ASSERT_TRUE(lmptr_->addLease(leases[2]));
+    ConstLease4Ptr other = lmptr_->getConstLease4(ioaddress4_[2]);
+    ASSERT_TRUE(other);
+    boost::weak_ptr<const Lease4> released(other);
+    other.reset();
+    EXPECT_TRUE(released.expired());
+    other = lmptr_->getConstLease4(ioaddress4_[2]);
+    ASSERT_TRUE(other);
+    EXPECT_TRUE(*other == *leases[2]);
+    ASSERT_TRUE(lmptr_->deleteLease(ioaddress4_[2]));
+
+    // The update doesn't modify the lease returned earlier, but the new
+    // version of the lease is returned by the subsequent lookups.
+    Lease4Ptr copy = lmptr_->getLease4(ioaddress4_[1]);
+    ASSERT_TRUE(copy);
+    copy->valid_lft_ += 100;
+    copy->hostname_ = "updated.example.com.";
+    ASSERT_NO_THROW(lmptr_->updateLease4(copy));
+    EXPECT_EQ(leases[1]->valid_lft_, lease->valid_lft_);
+    EXPECT_EQ(leases[1]->hostname_, lease->hostname_);
+    ConstLease4Ptr updated = lmptr_->getConstLease4(ioaddress4_[1]);
+    ASSERT_TRUE(updated);
+    EXPECT_NE(lease, updated);
+    EXPECT_TRUE(*updated == *copy);
+
+    // There is no lease for the address which isn't in use or isn't IPv4.
+    EXPECT_FALSE(lmptr_->getConstLease4(ioaddress4_[2]));
+    EXPECT_FALSE(lmptr_->getConstLease4(IOAddress("2001:db8::1")));
+
+    // The deleted lease is no longer returned, but the readers holding it
+    // can still use it.
+    ASSERT_TRUE(lmptr_->deleteLease(ioaddress4_[1]));
+    EXPECT_FALSE(lmptr_->getConstLease4(ioaddress4_[1]));
+    EXPECT_FALSE(lmptr_->getConstLease4(HWAddr(leases[1]->hwaddr_,
+                                               HTYPE_ETHER),
+                                        leases[1]->subnet_id_));
+    EXPECT_EQ(copy->hostname_, updated->hostname_);
+}
+
+/// @brief Checks that the readers share the immutable DHCPv6 lease and
+/// that the update replaces it with the new version.
+TEST_F(MemfileLeaseMgrTest, getConstLease6) {
+    startBackend(V6);
+    vector<Lease6Ptr> leases = createLeases6();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+
+    // The lookups by the address and by the DUID and IAID return the same
+    // object.
+    ConstLease6Ptr lease = lmptr_->getConstLease6(leases[1]->type_,
+                                                  ioaddress6_[1]);
+    ASSERT_TRUE(lease);
+    EXPECT_TRUE(*lease == *leases[1]);
+    ConstLease6Collection by_duid =
+        lmptr_->getConstLeases6(leases[1]->type_, *leases[1]->duid_,
+                                leases[1]->iaid_, leases[1]->subnet_id_);
+    ASSERT_EQ(1, by_duid.size());
+    EXPECT_EQ(lease, by_duid[0]);
+
+    // The lease of the other type is not returned.
+    EXPECT_FALSE(lmptr_->getConstLease6(Lease::TYPE_PD, ioaddress6_[1]));
+
+    // The update doesn't modify the lease returned earlier.
+    Lease6Ptr copy = lmptr_->getLease6(leases[1]->type_, ioaddress6_[1]);
+    ASSERT_TRUE(copy);
+    copy->preferred_lft_ += 100;
+    ASSERT_NO_THROW(lmptr_->updateLease6(copy));
+    EXPECT_EQ(leases[1]->preferred_lft_, lease->preferred_lft_);
+    ConstLease6Ptr updated = lmptr_->getConstLease6(leases[1]->type_,
+                                                    ioaddress6_[1]);
+    ASSERT_TRUE(updated);
+    EXPECT_NE(lease, updated);
+    EXPECT_TRUE(*updated == *copy);
+
+    ASSERT_TRUE(lmptr_->deleteLease(ioaddress6_[1]));
+    EXPECT_FALSE(lmptr_->getConstLease6(leases[1]->type_, ioaddress6_[1]));
+    EXPECT_TRUE(lmptr_->getConstLeases6(leases[1]->type_, *leases[1]->duid_,
+                                        leases[1]->iaid_,
+                                        leases[1]->subnet_id_).empty());
+}
+
 // The following tests are not applicable for memfile. When adding
 // new tests to the list here, make sure to provide brief explanation
 // why they are not applicable:
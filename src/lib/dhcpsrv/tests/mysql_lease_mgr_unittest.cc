@@ -15,6 +15,7 @@
 #include <config.h>
 
 #include <asiolink/io_address.h>
+#include <dhcpsrv/async_write_lease_mgr.h>
 #include <dhcpsrv/lease_mgr_factory.h>
 #include <dhcpsrv/mysql_lease_mgr.h>
 #include <dhcpsrv/tests/test_utils.h>
@@ -192,6 +193,32 @@ public:
         lmptr_ = &(LeaseMgrFactory::instance());
     }
 
+    /// @brief Reopen the database with the group commit enabled
+    ///
+    /// @param size Maximum number of operations in a transaction.
+    /// @param delay Time in milliseconds to wait for more operations.
+    void reopenGroupCommit(const unsigned int size, const unsigned int delay) {
+        std::ostringstream params;
+        params << validConnectionString() << " group-commit-size=" << size
+               << " group-commit-delay=" << delay;
+        LeaseMgrFactory::destroy();
+        LeaseMgrFactory::create(params.str());
+        lmptr_ = &(LeaseMgrFactory::instance());
+    }
+
+    /// @brief Uses the MySQL lease manager directly
+    ///
+    /// With the group commit enabled, the factory puts the lease manager
+    /// writing the leases asynchronously in front of the MySQL lease
+    /// manager. The tests of the asynchronous API use the MySQL lease
+    /// manager directly.
+    void useBackend() {
+        AsyncWriteLeaseMgr* writer =
+            dynamic_cast<AsyncWriteLeaseMgr*>(&LeaseMgrFactory::instance());
+        ASSERT_TRUE(writer);
+        lmptr_ = &writer->getBackend();
+    }
+
 };
 
 /// @brief Check that database can be opened
@@ -522,4 +549,92 @@ TEST_F(MySqlLeaseMgrTest, DISABLED_nullDuid) {
     testNullDuid();
 }
 
+/// @brief Checks that all DHCPv4 leases of a subnet can be retrieved.
+TEST_F(MySqlLeaseMgrTest, getLeases4Subnet) {
+    testGetLeases4Subnet();
+}
+
+/// @brief Checks that all DHCPv6 leases of a subnet can be retrieved.
+TEST_F(MySqlLeaseMgrTest, getLeases6Subnet) {
+    testGetLeases6Subnet();
+}
+
+/// @brief Checks that the expired DHCPv4 leases are returned in the order
+/// of their expiration times.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases4) {
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that the expired DHCPv6 leases are returned in the order
+/// of their expiration times.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases6) {
+    testGetExpiredLeases6();
+}
+
+/// @brief Checks that the expired DHCPv4 lease is not deleted if it has
+/// been renewed after it was retrieved.
+TEST_F(MySqlLeaseMgrTest, deleteExpiredLease4) {
+    testDeleteExpiredLease4();
+}
+
+/// @brief Checks that the expired DHCPv6 lease is not deleted if it has
+/// been renewed after it was retrieved.
+TEST_F(MySqlLeaseMgrTest, deleteExpiredLease6) {
+    testDeleteExpiredLease6();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv4 leases.
+TEST_F(MySqlLeaseMgrTest, asyncLease4) {
+    testAsyncLease4();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv6 leases.
+TEST_F(MySqlLeaseMgrTest, asyncLease6) {
+    testAsyncLease6();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv4 leases committed
+/// in groups.
+TEST_F(MySqlLeaseMgrTest, asyncLease4GroupCommit) {
+    reopenGroupCommit(4, 10);
+    useBackend();
+    EXPECT_LE(0, lmptr_->getAsyncSocket());
+    testAsyncLease4();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv6 leases committed
+/// in groups.
+TEST_F(MySqlLeaseMgrTest, asyncLease6GroupCommit) {
+    reopenGroupCommit(4, 10);
+    useBackend();
+    EXPECT_LE(0, lmptr_->getAsyncSocket());
+    testAsyncLease6();
+}
+
+/// @brief Checks that the server writes go through the group commit.
+TEST_F(MySqlLeaseMgrTest, basicLease4GroupCommit) {
+    reopenGroupCommit(4, 10);
+    EXPECT_TRUE(dynamic_cast<AsyncWriteLeaseMgr*>(lmptr_));
+    testBasicLease4();
+}
+
+/// @brief Checks that the server writes go through the group commit.
+TEST_F(MySqlLeaseMgrTest, basicLease6GroupCommit) {
+    reopenGroupCommit(4, 10);
+    EXPECT_TRUE(dynamic_cast<AsyncWriteLeaseMgr*>(lmptr_));
+    testBasicLease6();
+}
+
+/// @brief Checks that the group commit parameters are validated.
+TEST_F(MySqlLeaseMgrTest, invalidGroupCommit) {
+    LeaseMgrFactory::destroy();
+    EXPECT_THROW(LeaseMgrFactory::create(validConnectionString() +
+                                         " group-commit-size=65536"),
+                 isc::BadValue);
+    EXPECT_THROW(LeaseMgrFactory::create(validConnectionString() +
+                                         " group-commit-delay=abc"),
+                 isc::BadValue);
+    reopen(V4);
+}
+
 }; // Of anonymous namespace
@@ -15,6 +15,7 @@
 #include <config.h>
 
 #include <asiolink/io_address.h>
+#include <dhcpsrv/async_write_lease_mgr.h>
 #include <dhcpsrv/lease_mgr_factory.h>
 #include <dhcpsrv/pgsql_lease_mgr.h>
 #include <dhcpsrv/tests/test_utils.h>
@@ -197,6 +198,18 @@ public:
         lmptr_ = &(LeaseMgrFactory::instance());
     }
 
+    /// @brief Uses the PostgreSQL lease manager directly
+    ///
+    /// The factory puts the lease manager writing the leases asynchronously
+    /// in front of the PostgreSQL lease manager. The tests of the
+    /// asynchronous API use the PostgreSQL lease manager directly.
+    void useBackend() {
+        AsyncWriteLeaseMgr* writer =
+            dynamic_cast<AsyncWriteLeaseMgr*>(&LeaseMgrFactory::instance());
+        ASSERT_TRUE(writer);
+        lmptr_ = &writer->getBackend();
+    }
+
 };
 
 /// @brief Check that database can be opened
@@ -468,4 +481,51 @@ TEST_F(PgSqlLeaseMgrTest, nullDuid) {
     testNullDuid();
 }
 
+/// @brief Checks that all DHCPv4 leases of a subnet can be retrieved.
+TEST_F(PgSqlLeaseMgrTest, getLeases4Subnet) {
+    testGetLeases4Subnet();
+}
+
+/// @brief Checks that all DHCPv6 leases of a subnet can be retrieved.
+TEST_F(PgSqlLeaseMgrTest, getLeases6Subnet) {
+    testGetLeases6Subnet();
+}
+
+/// @brief Checks that the expired DHCPv4 leases are returned in the order
+/// of their expiration times.
+TEST_F(PgSqlLeaseMgrTest, getExpiredLeases4) {
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that the expired DHCPv6 leases are returned in the order
+/// of their expiration times.
+TEST_F(PgSqlLeaseMgrTest, getExpiredLeases6) {
+    testGetExpiredLeases6();
+}
+
+/// @brief Checks that the expired DHCPv4 lease is not deleted if it has
+/// been renewed after it was retrieved.
+TEST_F(PgSqlLeaseMgrTest, deleteExpiredLease4) {
+    testDeleteExpiredLease4();
+}
+
+/// @brief Checks that the expired DHCPv6 lease is not deleted if it has
+/// been renewed after it was retrieved.
+TEST_F(PgSqlLeaseMgrTest, deleteExpiredLease6) {
+    testDeleteExpiredLease6();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv4 leases.
+/// The operations are pipelined when supported by the client library.
+TEST_F(PgSqlLeaseMgrTest, asyncLease4) {
+    useBackend();
+    testAsyncLease4();
+}
+
+/// @brief Checks the asynchronous operations on the DHCPv6 leases.
+TEST_F(PgSqlLeaseMgrTest, asyncLease6) {
+    useBackend();
+    testAsyncLease6();
+}
+
 };
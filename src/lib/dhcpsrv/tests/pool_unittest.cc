@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include <iostream>
+#include <limits>
 #include <vector>
 #include <sstream>
 
@@ -197,6 +198,30 @@ TEST(Pool6Test, PD) {
                                 77, 77));
 }
 
+// Checks that the number of addresses and prefixes in the pools is computed.
+TEST(Pool6Test, capacity) {
+    Pool4 pool4a(IOAddress("192.0.2.10"), IOAddress("192.0.2.19"));
+    EXPECT_EQ(10, pool4a.getCapacity());
+    Pool4 pool4b(IOAddress("10.0.0.0"), 8);
+    EXPECT_EQ(0x1000000, pool4b.getCapacity());
+
+    Pool6 pool6a(Lease::TYPE_NA, IOAddress("2001:db8:1::1"),
+                 IOAddress("2001:db8:1::f"));
+    EXPECT_EQ(15, pool6a.getCapacity());
+    Pool6 pool6b(Lease::TYPE_NA, IOAddress("2001:db8:1::"), 112);
+    EXPECT_EQ(65536, pool6b.getCapacity());
+
+    // The number of addresses in /64 doesn't fit in 64 bits.
+    Pool6 pool6c(Lease::TYPE_NA, IOAddress("2001:db8:1::"), 48);
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), pool6c.getCapacity());
+
+    // For PD pools, the number of the delegated prefixes is returned.
+    Pool6 pool6d(Lease::TYPE_PD, IOAddress("2001:db8:1::"), 48, 64);
+    EXPECT_EQ(65536, pool6d.getCapacity());
+    Pool6 pool6e(Lease::TYPE_PD, IOAddress("2001:db8:1::"), 77, 77);
+    EXPECT_EQ(1, pool6e.getCapacity());
+}
+
 // Checks that temporary address pools are handled properly
 TEST(Pool6Test, TA) {
     // Note: since we defined TA pool types during PD work, we can test it
@@ -0,0 +1,150 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/option.h>
+#include <dhcpsrv/subnet.h>
+#include <dhcpsrv/subnet_index.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::asiolink;
+
+namespace {
+
+/// @brief Returns positions of the subnets containing the address as text.
+///
+/// @param index Index of the subnets.
+/// @param addr Address for which the subnets are searched.
+std::string
+getByAddress(const SubnetIndex& index, const std::string& addr) {
+    SubnetIndex::Positions positions;
+    index.getByAddress(IOAddress(addr), positions);
+    std::ostringstream s;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        s << (i > 0 ? " " : "") << positions[i];
+    }
+    return (s.str());
+}
+
+// This test verifies that the IPv4 subnets containing an address are found,
+// including the nested subnets and subnets appearing in a different order
+// than their prefix lengths.
+TEST(SubnetIndexTest, address4) {
+    SubnetIndex index;
+    EXPECT_EQ("", getByAddress(index, "192.0.2.1"));
+
+    index.add(Subnet4(IOAddress("192.0.2.0"), 26, 1, 2, 3), 0);
+    index.add(Subnet4(IOAddress("192.0.2.64"), 26, 1, 2, 3), 1);
+    index.add(Subnet4(IOAddress("192.0.0.0"), 16, 1, 2, 3), 2);
+    index.add(Subnet4(IOAddress("192.0.2.10"), 32, 1, 2, 3), 3);
+    index.add(Subnet4(IOAddress("0.0.0.0"), 0, 1, 2, 3), 4);
+    index.add(Subnet4(IOAddress("192.0.2.0"), 26, 1, 2, 3), 5);
+
+    EXPECT_EQ("0 2 4 5", getByAddress(index, "192.0.2.1"));
+    EXPECT_EQ("0 2 3 4 5", getByAddress(index, "192.0.2.10"));
+    EXPECT_EQ("1 2 4", getByAddress(index, "192.0.2.127"));
+    EXPECT_EQ("2 4", getByAddress(index, "192.0.2.128"));
+    EXPECT_EQ("2 4", getByAddress(index, "192.0.255.255"));
+    EXPECT_EQ("4", getByAddress(index, "10.0.0.1"));
+
+    index.clear();
+    EXPECT_EQ("", getByAddress(index, "192.0.2.1"));
+}
+
+// This test verifies that the IPv6 subnets containing an address are found.
+TEST(SubnetIndexTest, address6) {
+    SubnetIndex index;
+    index.add(Subnet6(IOAddress("2001:db8:1::"), 48, 1, 2, 3, 4), 0);
+    index.add(Subnet6(IOAddress("2001:db8:1:1::"), 64, 1, 2, 3, 4), 1);
+    index.add(Subnet6(IOAddress("2001:db8:2::"), 48, 1, 2, 3, 4), 2);
+    index.add(Subnet6(IOAddress("2001:db8:1:1::1"), 128, 1, 2, 3, 4), 3);
+
+    EXPECT_EQ("0", getByAddress(index, "2001:db8:1::1"));
+    EXPECT_EQ("0 1", getByAddress(index, "2001:db8:1:1::2"));
+    EXPECT_EQ("0 1 3", getByAddress(index, "2001:db8:1:1::1"));
+    EXPECT_EQ("2", getByAddress(index, "2001:db8:2:ffff::1"));
+    EXPECT_EQ("", getByAddress(index, "2001:db8:3::1"));
+}
+
+// This test verifies that the subnets are found by relay address, interface
+// name and interface-id.
+TEST(SubnetIndexTest, hashed) {
+    SubnetIndex index;
+
+    Subnet6 subnet1(IOAddress("2001:db8:1::"), 48, 1, 2, 3, 4);
+    subnet1.setRelayInfo(IOAddress("2001:db8:ff::1"));
+    subnet1.setIface("eth0");
+    OptionBuffer data(5, 'a');
+    subnet1.setInterfaceId(OptionPtr(new Option(Option::V6, D6O_INTERFACE_ID,
+                                                data)));
+
+    Subnet6 subnet2(IOAddress("2001:db8:2::"), 48, 1, 2, 3, 4);
+    subnet2.setRelayInfo(IOAddress("2001:db8:ff::1"));
+    subnet2.setIface("eth1");
+
+    Subnet6 subnet3(IOAddress("2001:db8:3::"), 48, 1, 2, 3, 4);
+    subnet3.setIface("eth0");
+    subnet3.setInterfaceId(OptionPtr(new Option(Option::V6, D6O_INTERFACE_ID,
+                                                data)));
+
+    index.add(subnet1, 0);
+    index.add(subnet2, 1);
+    index.add(subnet3, 2);
+
+    SubnetIndex::Positions positions =
+        index.getByRelay(IOAddress("2001:db8:ff::1"));
+    ASSERT_EQ(2, positions.size());
+    EXPECT_EQ(0, positions[0]);
+    EXPECT_EQ(1, positions[1]);
+    // The subnets without relay information have the unspecified address.
+    positions = index.getByRelay(IOAddress("::"));
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(2, positions[0]);
+    EXPECT_TRUE(index.getByRelay(IOAddress("2001:db8:ff::2")).empty());
+
+    positions = index.getByIface("eth0");
+    ASSERT_EQ(2, positions.size());
+    EXPECT_EQ(0, positions[0]);
+    EXPECT_EQ(2, positions[1]);
+    positions = index.getByIface("eth1");
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(1, positions[0]);
+    EXPECT_TRUE(index.getByIface("eth2").empty());
+    EXPECT_TRUE(index.getByIface("").empty());
+
+    positions = index.getByInterfaceId(OptionPtr(new Option(Option::V6,
+                                                            D6O_INTERFACE_ID,
+                                                            data)));
+    ASSERT_EQ(2, positions.size());
+    EXPECT_EQ(0, positions[0]);
+    EXPECT_EQ(2, positions[1]);
+    OptionPtr other(new Option(Option::V6, D6O_INTERFACE_ID,
+                               OptionBuffer(4, 'a')));
+    EXPECT_TRUE(index.getByInterfaceId(other).empty());
+
+    index.clear();
+    EXPECT_TRUE(index.getByRelay(IOAddress("2001:db8:ff::1")).empty());
+    EXPECT_TRUE(index.getByIface("eth0").empty());
+}
+
+} // end of anonymous namespace
@@ -23,6 +23,8 @@
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 
+#include <vector>
+
 // don't import the entire boost namespace.  It will unexpectedly hide uint8_t
 // for some systems.
 using boost::scoped_ptr;
@@ -294,6 +296,77 @@ TEST(Subnet4Test, inRangeinPool) {
     EXPECT_FALSE(subnet->inPool(Lease::TYPE_V4, IOAddress("192.3.0.0")));
 }
 
+// This test verifies that the pool is found among many small pools which
+// were added in a non-sorted order.
+TEST(Subnet4Test, manyPools) {
+    Subnet4Ptr subnet(new Subnet4(IOAddress("10.0.0.0"), 16, 1, 2, 3));
+
+    // Add 256 pools of 16 addresses each, leaving the gaps of 16 addresses
+    // between them. The pools are added starting from the middle.
+    std::vector<Pool4Ptr> pools;
+    for (uint32_t i = 0; i < 256; ++i) {
+        const uint32_t first = 0x0A000000 + ((i + 128) % 256) * 32;
+        pools.push_back(Pool4Ptr(new Pool4(IOAddress(first),
+                                           IOAddress(first + 15))));
+        ASSERT_NO_THROW(subnet->addPool(pools.back()));
+    }
+
+    for (uint32_t i = 0; i < 256; ++i) {
+        const uint32_t first = pools[i]->getFirstAddress();
+        EXPECT_EQ(pools[i], subnet->getPool(Lease::TYPE_V4, IOAddress(first),
+                                            false));
+        EXPECT_EQ(pools[i], subnet->getPool(Lease::TYPE_V4,
+                                            IOAddress(first + 15), false));
+        EXPECT_TRUE(subnet->inPool(Lease::TYPE_V4, IOAddress(first + 7)));
+
+        // The addresses in the gaps don't belong to any pool.
+        EXPECT_FALSE(subnet->getPool(Lease::TYPE_V4, IOAddress(first + 16),
+                                     false));
+        EXPECT_FALSE(subnet->inPool(Lease::TYPE_V4, IOAddress(first + 31)));
+
+        // The first pool is returned if any pool is acceptable.
+        EXPECT_EQ(pools[0], subnet->getPool(Lease::TYPE_V4,
+                                            IOAddress(first + 16)));
+    }
+
+    // No pools are found after they are deleted.
+    subnet->delPools(Lease::TYPE_V4);
+    EXPECT_FALSE(subnet->getPool(Lease::TYPE_V4, IOAddress("10.0.0.1")));
+    EXPECT_FALSE(subnet->inPool(Lease::TYPE_V4, IOAddress("10.0.0.1")));
+}
+
+// This test verifies that the pool which was added first is returned when
+// the pools overlap.
+TEST(Subnet4Test, overlappingPools) {
+    Subnet4Ptr subnet(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
+
+    Pool4Ptr pool1(new Pool4(IOAddress("192.0.2.100"),
+                             IOAddress("192.0.2.110")));
+    Pool4Ptr pool2(new Pool4(IOAddress("192.0.2.10"),
+                             IOAddress("192.0.2.200")));
+    Pool4Ptr pool3(new Pool4(IOAddress("192.0.2.105"),
+                             IOAddress("192.0.2.120")));
+    Pool4Ptr pool4(new Pool4(IOAddress("192.0.2.150"),
+                             IOAddress("192.0.2.160")));
+    subnet->addPool(pool1);
+    subnet->addPool(pool2);
+    subnet->addPool(pool3);
+    subnet->addPool(pool4);
+
+    EXPECT_EQ(pool2, subnet->getPool(Lease::TYPE_V4, IOAddress("192.0.2.10")));
+    EXPECT_EQ(pool1, subnet->getPool(Lease::TYPE_V4,
+                                     IOAddress("192.0.2.107")));
+    EXPECT_EQ(pool2, subnet->getPool(Lease::TYPE_V4,
+                                     IOAddress("192.0.2.115")));
+    EXPECT_EQ(pool2, subnet->getPool(Lease::TYPE_V4,
+                                     IOAddress("192.0.2.155")));
+    EXPECT_EQ(pool2, subnet->getPool(Lease::TYPE_V4,
+                                     IOAddress("192.0.2.200")));
+    EXPECT_FALSE(subnet->getPool(Lease::TYPE_V4, IOAddress("192.0.2.201"),
+                                 false));
+    EXPECT_FALSE(subnet->inPool(Lease::TYPE_V4, IOAddress("192.0.2.9")));
+}
+
 // This test checks if the toText() method returns text representation
 TEST(Subnet4Test, toText) {
     Subnet4Ptr subnet(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
@@ -840,6 +913,45 @@ TEST(Subnet6Test, getOptionDescriptor) {
     }
 }
 
+// This test verifies that the options of the DHCP option space are held
+// in the subnet along with their on-wire format.
+TEST(Subnet6Test, getPackedOption) {
+    Subnet6Ptr subnet(new Subnet6(IOAddress("2001:db8::"), 56, 1, 2, 3, 4));
+
+    // Add the options in the reverse order of their codes.
+    for (uint16_t code = 109; code >= 100; --code) {
+        OptionPtr option(new Option(Option::V6, code, OptionBuffer(10, 0xFF)));
+        ASSERT_NO_THROW(subnet->addOption(option, false, "dhcp6"));
+    }
+    // The options of the other option spaces are not held.
+    OptionPtr isc_option(new Option(Option::V6, 110, OptionBuffer(1, 1)));
+    ASSERT_NO_THROW(subnet->addOption(isc_option, false, "isc"));
+    // If there are several options with the same code, the same option
+    // is returned as by the getOptionDescriptor.
+    OptionPtr duplicate(new Option(Option::V6, 100, OptionBuffer(1, 1)));
+    ASSERT_NO_THROW(subnet->addOption(duplicate, false, "dhcp6"));
+
+    for (uint16_t code = 100; code < 110; ++code) {
+        PackedOption packed = subnet->getPackedOption(code);
+        ASSERT_TRUE(packed.option);
+        EXPECT_TRUE(packed.option ==
+                    subnet->getOptionDescriptor("dhcp6", code).option);
+
+        // The on-wire format matches the packed option.
+        ASSERT_TRUE(packed.wire);
+        isc::util::OutputBuffer buf(0);
+        packed.option->pack(buf);
+        ASSERT_EQ(buf.getLength(), packed.wire->size());
+        EXPECT_EQ(0, memcmp(buf.getData(), &(*packed.wire)[0],
+                            packed.wire->size()));
+    }
+    EXPECT_FALSE(subnet->getPackedOption(99).option);
+    EXPECT_FALSE(subnet->getPackedOption(110).option);
+
+    // The options are removed along with the other options.
+    subnet->delOptions();
+    EXPECT_FALSE(subnet->getPackedOption(100).option);
+}
 
 TEST(Subnet6Test, addVendorOptions) {
 
@@ -0,0 +1,171 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/worker_pool.h>
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Test fixture class for @c WorkerPool.
+class WorkerPoolTest : public ::testing::Test {
+public:
+
+    /// @brief Constructor.
+    WorkerPoolTest()
+        : count_(0), blocked_(false) {
+    }
+
+    /// @brief Work item incrementing the counter.
+    void increment() {
+        Mutex::Locker lock(mutex_);
+        ++count_;
+    }
+
+    /// @brief Work item blocking until @c unblock is called.
+    void block() {
+        Mutex::Locker lock(mutex_);
+        while (blocked_) {
+            cond_var_.wait(mutex_);
+        }
+    }
+
+    /// @brief Releases the threads running the @c block work item.
+    void unblock() {
+        Mutex::Locker lock(mutex_);
+        blocked_ = false;
+        cond_var_.broadcast();
+    }
+
+    /// @brief Work item throwing an exception.
+    void throwException() {
+        isc_throw(isc::Unexpected, "test exception");
+    }
+
+    /// @brief Returns the value of the counter.
+    int getCount() {
+        Mutex::Locker lock(mutex_);
+        return (count_);
+    }
+
+    /// @brief Counter incremented by the work items.
+    int count_;
+
+    /// @brief Indicates if the @c block work item should block.
+    bool blocked_;
+
+    /// @brief Mutex protecting the counter and the blocked flag.
+    Mutex mutex_;
+
+    /// @brief Condition variable used to release the blocked items.
+    CondVar cond_var_;
+};
+
+// This test verifies that the items are run synchronously if the pool
+// hasn't been started.
+TEST_F(WorkerPoolTest, synchronous) {
+    WorkerPool pool;
+    EXPECT_EQ(0, pool.getThreadCount());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+        EXPECT_EQ(i + 1, getCount());
+    }
+
+    // Starting with no threads is equivalent to not starting the pool.
+    ASSERT_NO_THROW(pool.start(0));
+    EXPECT_EQ(0, pool.getThreadCount());
+    EXPECT_TRUE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+    EXPECT_EQ(11, getCount());
+}
+
+// This test verifies that all queued items are run by the worker threads
+// before the pool is stopped.
+TEST_F(WorkerPoolTest, startStop) {
+    WorkerPool pool;
+    ASSERT_NO_THROW(pool.start(4));
+    EXPECT_EQ(4, pool.getThreadCount());
+
+    // Starting the running pool is an error.
+    EXPECT_THROW(pool.start(2), isc::InvalidOperation);
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+    }
+    ASSERT_NO_THROW(pool.stop());
+    EXPECT_EQ(0, pool.getThreadCount());
+    EXPECT_EQ(0, pool.getQueueSize());
+    EXPECT_EQ(1000, getCount());
+
+    // Stopping the stopped pool is no-op.
+    EXPECT_NO_THROW(pool.stop());
+
+    // It should be possible to start the pool again.
+    ASSERT_NO_THROW(pool.start(2));
+    EXPECT_EQ(2, pool.getThreadCount());
+    ASSERT_TRUE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+    ASSERT_NO_THROW(pool.stop());
+    EXPECT_EQ(1001, getCount());
+}
+
+// This test verifies that the items are rejected when the queue is full.
+TEST_F(WorkerPoolTest, maxQueueSize) {
+    WorkerPool pool;
+    ASSERT_NO_THROW(pool.start(1, 2));
+
+    // Occupy the only worker thread. Until the thread picks up this item,
+    // it is held in the queue, so wait for the queue to drain.
+    blocked_ = true;
+    ASSERT_TRUE(pool.add(boost::bind(&WorkerPoolTest::block, this)));
+    while (pool.getQueueSize() > 0) {
+        usleep(1000);
+    }
+
+    // Two items fit in the queue, the third one is rejected.
+    EXPECT_TRUE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+    EXPECT_TRUE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+    EXPECT_FALSE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+    EXPECT_EQ(2, pool.getQueueSize());
+
+    unblock();
+    ASSERT_NO_THROW(pool.stop());
+    EXPECT_EQ(2, getCount());
+}
+
+// This test verifies that the exception thrown by the work item doesn't
+// terminate the worker thread.
+TEST_F(WorkerPoolTest, exception) {
+    WorkerPool pool;
+    // Synchronous mode.
+    EXPECT_TRUE(pool.add(boost::bind(&WorkerPoolTest::throwException, this)));
+
+    ASSERT_NO_THROW(pool.start(1));
+    ASSERT_TRUE(pool.add(boost::bind(&WorkerPoolTest::throwException, this)));
+    ASSERT_TRUE(pool.add(boost::bind(&WorkerPoolTest::increment, this)));
+    ASSERT_NO_THROW(pool.stop());
+    EXPECT_EQ(1, getCount());
+}
+
+} // end of anonymous namespace
@@ -0,0 +1,153 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/worker_pool.h>
+
+#include <boost/bind.hpp>
+
+#include <signal.h>
+#include <pthread.h>
+
+using namespace isc::util::thread;
+
+namespace isc {
+namespace dhcp {
+
+WorkerPool::WorkerPool()
+    : threads_(), queue_(), max_queue_size_(0), stopping_(false) {
+}
+
+WorkerPool::~WorkerPool() {
+    try {
+        stop();
+    } catch (...) {
+        // Destructor must not throw.
+    }
+}
+
+void
+WorkerPool::start(const size_t thread_count, const size_t max_queue_size) {
+    Mutex::Locker lock(mutex_);
+    if (!threads_.empty()) {
+        isc_throw(InvalidOperation, "worker threads are already running");
+    }
+
+    max_queue_size_ = max_queue_size;
+    stopping_ = false;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.push_back(ThreadPtr(new Thread(boost::bind(&WorkerPool::run,
+                                                            this))));
+    }
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_WORKER_THREADS_STARTED).arg(thread_count);
+}
+
+void
+WorkerPool::stop() {
+    std::vector<ThreadPtr> threads;
+    {
+        Mutex::Locker lock(mutex_);
+        if (threads_.empty()) {
+            return;
+        }
+        stopping_ = true;
+        threads.swap(threads_);
+        cond_var_.broadcast();
+    }
+
+    // The threads finish the remaining queued items and terminate. Wait
+    // for them outside of the lock, so as they can still access the queue.
+    for (std::vector<ThreadPtr>::const_iterator thread = threads.begin();
+         thread != threads.end(); ++thread) {
+        (*thread)->wait();
+    }
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_WORKER_THREADS_STOPPED)
+        .arg(threads.size());
+}
+
+bool
+WorkerPool::add(const WorkItem& item) {
+    {
+        Mutex::Locker lock(mutex_);
+        if (!threads_.empty()) {
+            if ((max_queue_size_ > 0) && (queue_.size() >= max_queue_size_)) {
+                return (false);
+            }
+            queue_.push(item);
+            cond_var_.signal();
+            return (true);
+        }
+    }
+
+    // There are no worker threads so run the item synchronously.
+    runItem(item);
+    return (true);
+}
+
+size_t
+WorkerPool::getThreadCount() const {
+    Mutex::Locker lock(mutex_);
+    return (threads_.size());
+}
+
+size_t
+WorkerPool::getQueueSize() const {
+    Mutex::Locker lock(mutex_);
+    return (queue_.size());
+}
+
+void
+WorkerPool::runItem(const WorkItem& item) {
+    try {
+        item();
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_WORKER_ITEM_EXCEPTION)
+            .arg(ex.what());
+    } catch (...) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_WORKER_ITEM_EXCEPTION)
+            .arg("unknown exception");
+    }
+}
+
+void
+WorkerPool::run() {
+    // Signals are handled by the main thread of the server, which checks
+    // for them after each attempt to receive a packet. Block them here so
+    // as they don't interrupt packet processing on the worker threads.
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    for (;;) {
+        WorkItem item;
+        {
+            Mutex::Locker lock(mutex_);
+            while (queue_.empty() && !stopping_) {
+                cond_var_.wait(mutex_);
+            }
+            // Stop only when all items queued so far have been processed.
+            if (queue_.empty()) {
+                return;
+            }
+            item = queue_.front();
+            queue_.pop();
+        }
+        runItem(item);
+    }
+}
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
@@ -0,0 +1,138 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <queue>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Pool of threads processing work items taken from a common queue.
+///
+/// The DHCP servers use this class to process received packets on multiple
+/// threads. The thread receiving packets adds a work item (typically a
+/// functor processing a single packet) to the queue using @c WorkerPool::add
+/// and one of the idle worker threads picks it up and runs it.
+///
+/// The work items are run in the order in which they have been added to the
+/// queue, but an item may complete before an item added earlier if they are
+/// run by different threads.
+///
+/// The work items must not throw. If they do, the exception is caught, logged
+/// and the worker thread continues with the next item.
+///
+/// If the pool hasn't been started, or it has been started with zero threads,
+/// the items are run synchronously, by the caller of @c WorkerPool::add.
+class WorkerPool : public boost::noncopyable {
+public:
+
+    /// @brief Type of the work item run by the worker threads.
+    typedef boost::function<void()> WorkItem;
+
+    /// @brief Constructor.
+    ///
+    /// The constructor doesn't start any threads. Call @c WorkerPool::start
+    /// to start them.
+    WorkerPool();
+
+    /// @brief Destructor.
+    ///
+    /// Stops the threads, after they have processed all queued items.
+    ~WorkerPool();
+
+    /// @brief Starts worker threads.
+    ///
+    /// @param thread_count Number of threads to be started. If it is 0, no
+    /// threads are started and all items are run synchronously.
+    /// @param max_queue_size Maximum number of items waiting in the queue.
+    /// If this limit is reached, new items are rejected. The value of 0
+    /// means that the queue size is unlimited.
+    ///
+    /// @throw isc::InvalidOperation if the threads are already running.
+    void start(const size_t thread_count, const size_t max_queue_size = 0);
+
+    /// @brief Stops worker threads.
+    ///
+    /// This function blocks until all items queued so far have been
+    /// processed and all threads have terminated. It is no-op if there are
+    /// no threads running.
+    void stop();
+
+    /// @brief Adds a new work item.
+    ///
+    /// If no threads are running, the item is run by the calling thread
+    /// before this function returns.
+    ///
+    /// @param item Work item to be run.
+    ///
+    /// @return true if the item has been queued (or run), false if it has
+    /// been rejected because the queue is full.
+    bool add(const WorkItem& item);
+
+    /// @brief Returns the number of running worker threads.
+    size_t getThreadCount() const;
+
+    /// @brief Returns the number of items waiting in the queue.
+    size_t getQueueSize() const;
+
+private:
+
+    /// @brief Runs a single work item and catches all exceptions.
+    ///
+    /// @param item Work item to be run.
+    static void runItem(const WorkItem& item);
+
+    /// @brief Main function of the worker thread.
+    ///
+    /// It takes the items from the queue and runs them until the pool
+    /// is being stopped and the queue is empty.
+    void run();
+
+    /// @brief Pointer to the worker thread.
+    typedef boost::shared_ptr<isc::util::thread::Thread> ThreadPtr;
+
+    /// @brief Worker threads.
+    std::vector<ThreadPtr> threads_;
+
+    /// @brief Queue holding items waiting to be run.
+    std::queue<WorkItem> queue_;
+
+    /// @brief Maximum number of items in the queue (0 if unlimited).
+    size_t max_queue_size_;
+
+    /// @brief Indicates that the threads are being stopped.
+    bool stopping_;
+
+    /// @brief Mutex protecting the queue and the state of the pool.
+    mutable isc::util::thread::Mutex mutex_;
+
+    /// @brief Condition variable used to wake up idle worker threads.
+    isc::util::thread::CondVar cond_var_;
+};
+
+} // end of isc::dhcp namespace
+} // end of isc namespace
+
+#endif // WORKER_POOL_H
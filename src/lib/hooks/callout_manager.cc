@@ -32,7 +32,7 @@ namespace hooks {
 // Constructor
 CalloutManager::CalloutManager(int num_libraries)
     : server_hooks_(ServerHooks::getServerHooks()),
-      current_hook_(-1), current_library_(-1),
+      current_hook_(-1), call_mutex_(), current_library_(-1),
       hook_vector_(ServerHooks::getServerHooks().getCount()),
       library_handle_(this), pre_library_handle_(this, 0),
       post_library_handle_(this, INT_MAX), num_libraries_(num_libraries)
@@ -123,6 +123,10 @@ CalloutManager::callCallouts(int hook_index, CalloutHandle& callout_handle) {
     // also catches the case of an invalid index.
     if (calloutsPresent(hook_index)) {
 
+        // Prevent other threads from modifying the current hook and
+        // library indexes until all callouts have been called.
+        isc::util::thread::Mutex::Locker lock(call_mutex_);
+
         // Set the current hook index.  This is used should a callout wish to
         // determine to what hook it is attached.
         current_hook_ = hook_index;
@@ -18,6 +18,7 @@
 #include <exceptions/exceptions.h>
 #include <hooks/library_handle.h>
 #include <hooks/server_hooks.h>
+#include <util/threads/sync.h>
 
 #include <boost/shared_ptr.hpp>
 
@@ -200,6 +201,11 @@ public:
     /// @note This method invalidates the current library index set with
     ///       setLibraryIndex().
     ///
+    /// @note The callouts are called with a mutex held, so as this method
+    ///       can be invoked concurrently by multiple packet processing
+    ///       threads. As a result, the callouts for any hooks handled by
+    ///       this manager are never run concurrently.
+    ///
     /// @param hook_index Index of the hook to call.
     /// @param callout_handle Reference to the CalloutHandle object for the
     ///        current object being processed.
@@ -350,6 +356,11 @@ private:
     /// otherwise.
     int current_hook_;
 
+    /// Mutex serializing calls to callCallouts.  The current hook and library
+    /// indexes are set for the duration of such a call, so the callouts must
+    /// not be called by multiple threads at the same time.
+    isc::util::thread::Mutex call_mutex_;
+
     /// Current library index.  When a call is made to any of the callout
     /// registration methods, this variable indicates the index of the user
     /// library that should be associated with the call.
@@ -16,9 +16,13 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/constants.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
 namespace isc {
 namespace util {
 
@@ -79,8 +83,156 @@ CSVRow::checkIndex(const size_t at) const {
     }
 }
 
+CSVRowView::CSVRowView(const char separator)
+    : separator_(separator) {
+}
+
+void
+CSVRowView::parse(const char* begin, const char* end) {
+    // As for the CSVRow, the two consecutive separators mark an empty
+    // value and the empty line holds one empty value.
+    values_.clear();
+    Value value;
+    value.begin_ = begin;
+    for (const char* pos = begin; pos != end; ++pos) {
+        if (*pos == separator_) {
+            value.end_ = pos;
+            values_.push_back(value);
+            value.begin_ = pos + 1;
+        }
+    }
+    value.end_ = end;
+    values_.push_back(value);
+}
+
+template<>
+bool
+CSVRowView::readAndConvertAt<bool>(const size_t at) const {
+    checkIndex(at);
+    if (values_[at].end_ - values_[at].begin_ == 1) {
+        if (*values_[at].begin_ == '0') {
+            return (false);
+        } else if (*values_[at].begin_ == '1') {
+            return (true);
+        }
+    }
+    throwConversionError(at);
+    // Not reached.
+    return (false);
+}
+
+uint32_t
+CSVRowView::readIPv4At(const size_t at) const {
+    checkIndex(at);
+    // The address is copied to the buffer on stack, because inet_pton
+    // requires the terminating NUL character.
+    char text[INET_ADDRSTRLEN];
+    const size_t length = values_[at].end_ - values_[at].begin_;
+    struct in_addr address;
+    if (length >= sizeof(text)) {
+        throwConversionError(at);
+    }
+    memcpy(text, values_[at].begin_, length);
+    text[length] = '\0';
+    if (inet_pton(AF_INET, text, &address) != 1) {
+        throwConversionError(at);
+    }
+    return (ntohl(address.s_addr));
+}
+
+void
+CSVRowView::readIPv6At(const size_t at, uint8_t* address) const {
+    checkIndex(at);
+    char text[INET6_ADDRSTRLEN];
+    const size_t length = values_[at].end_ - values_[at].begin_;
+    if (length >= sizeof(text)) {
+        throwConversionError(at);
+    }
+    memcpy(text, values_[at].begin_, length);
+    text[length] = '\0';
+    if (inet_pton(AF_INET6, text, address) != 1) {
+        throwConversionError(at);
+    }
+}
+
+void
+CSVRowView::readHexAt(const size_t at, std::vector<uint8_t>& binary) const {
+    checkIndex(at);
+    binary.clear();
+    const char* pos = values_[at].begin_;
+    const char* end = values_[at].end_;
+    if (pos == end) {
+        return;
+    }
+    for (;;) {
+        // Each byte is specified with one or two digits.
+        unsigned byte = 0;
+        int digits = 0;
+        for (; (pos != end) && (*pos != ':'); ++pos) {
+            const char c = *pos;
+            unsigned nibble = 0;
+            if ((c >= '0') && (c <= '9')) {
+                nibble = c - '0';
+            } else if ((c >= 'a') && (c <= 'f')) {
+                nibble = c - 'a' + 10;
+            } else if ((c >= 'A') && (c <= 'F')) {
+                nibble = c - 'A' + 10;
+            } else {
+                throwConversionError(at);
+            }
+            if (++digits > 2) {
+                throwConversionError(at);
+            }
+            byte = (byte << 4) | nibble;
+        }
+        if (digits == 0) {
+            throwConversionError(at);
+        }
+        binary.push_back(static_cast<uint8_t>(byte));
+        if (pos == end) {
+            return;
+        }
+        // Skip the colon.
+        ++pos;
+    }
+}
+
+std::string
+CSVRowView::render() const {
+    std::string text;
+    for (size_t i = 0; i < values_.size(); ++i) {
+        // Do not put separator before the first value.
+        if (i > 0) {
+            text += separator_;
+        }
+        text.append(values_[i].begin_, values_[i].end_);
+    }
+    return (text);
+}
+
+void
+CSVRowView::checkIndex(const size_t at) const {
+    if (at >= values_.size()) {
+        isc_throw(CSVFileError, "value index '" << at << "' of the CSV row"
+                  " is out of bounds; maximal index is '"
+                  << (values_.size() - 1) << "'");
+    }
+}
+
+void
+CSVRowView::throwConversionError(const size_t at) const {
+    isc_throw(CSVFileError, "invalid value '" << readAt(at) << "' at"
+              " index '" << at << "' of the CSV row");
+}
+
+std::ostream& operator<<(std::ostream& os, const CSVRowView& row) {
+    os << row.render();
+    return (os);
+}
+
 CSVFile::CSVFile(const std::string& filename)
-    : filename_(filename), fs_(), cols_(0), read_msg_() {
+    : filename_(filename), fs_(), cols_(0), read_msg_(), read_pos_(0),
+      read_end_(0), read_eof_(false) {
 }
 
 CSVFile::~CSVFile() {
@@ -95,6 +247,9 @@ CSVFile::close() {
         fs_->close();
         fs_.reset();
     }
+    resetReadBuffer();
+    // Free the buffer of the closed file.
+    std::vector<char>().swap(read_buffer_);
 }
 
 void
@@ -144,6 +299,8 @@ CSVFile::append(const CSVRow& row) const {
     fs_->seekp(0, std::ios_base::end);
     fs_->seekg(0, std::ios_base::end);
     fs_->clear();
+    // The rows which have been read ahead are skipped, as before.
+    resetReadBuffer();
 
     std::string text = row.render();
     *fs_ << text << std::endl;
@@ -230,28 +387,111 @@ CSVFile::next(CSVRow& row, const bool skip_validation) {
     }
 
     // Get exactly one line of the file.
-    std::string line;
-    std::getline(*fs_, line);
-    // If we got empty line because we reached the end of file
-    // return an empty row.
-    if (line.empty() && fs_->eof()) {
-        row = EMPTY_ROW();
-        return (true);
-
-    } else if (!fs_->good()) {
+    const char* begin = NULL;
+    const char* end = NULL;
+    if (!readLine(begin, end)) {
         // If we hit an IO error, communicate it to the caller but do NOT close
         // the stream. Caller may try again.
         setReadMsg("error reading a row from CSV file '"
                    + std::string(filename_) + "'");
         return (false);
+
+    } else if (begin == NULL) {
+        // If we reached the end of file return an empty row.
+        row = EMPTY_ROW();
+        return (true);
     }
     // If we read anything, parse it.
-    row.parse(line);
+    row.parse(std::string(begin, end));
 
     // And check if it is correct.
     return (skip_validation ? true : validate(row));
 }
 
+bool
+CSVFile::next(CSVRowView& row, const bool skip_validation) {
+    setReadMsg("validation not started");
+
+    try {
+        checkStreamStatusAndReset("get next row");
+
+    } catch (isc::Exception& ex) {
+        setReadMsg(ex.what());
+        return (false);
+    }
+
+    const char* begin = NULL;
+    const char* end = NULL;
+    if (!readLine(begin, end)) {
+        setReadMsg("error reading a row from CSV file '"
+                   + std::string(filename_) + "'");
+        return (false);
+
+    } else if (begin == NULL) {
+        row.clear();
+        return (true);
+    }
+    row.parse(begin, end);
+
+    return (skip_validation ? true : validate(row));
+}
+
+bool
+CSVFile::readLine(const char*& begin, const char*& end) {
+    if (read_buffer_.empty()) {
+        read_buffer_.resize(READ_BUFFER_SIZE);
+    }
+    for (;;) {
+        char* buffer = &read_buffer_[0];
+        char* first = buffer + read_pos_;
+        char* last = buffer + read_end_;
+        char* newline = static_cast<char*>(memchr(first, '\n', last - first));
+        if (newline != NULL) {
+            begin = first;
+            end = newline;
+            read_pos_ = newline + 1 - buffer;
+            return (true);
+
+        } else if (read_eof_) {
+            // The last line may lack the newline character.
+            begin = (first == last ? NULL : first);
+            end = last;
+            read_pos_ = read_end_;
+            return (true);
+        }
+
+        // Move the incomplete line to the beginning of the buffer and
+        // fill the rest of the buffer. If the line takes the whole buffer,
+        // the buffer is enlarged.
+        memmove(buffer, first, last - first);
+        read_end_ = last - first;
+        read_pos_ = 0;
+        if (read_end_ == read_buffer_.size()) {
+            read_buffer_.resize(2 * read_buffer_.size());
+            buffer = &read_buffer_[0];
+        }
+        fs_->read(buffer + read_end_, read_buffer_.size() - read_end_);
+        read_end_ += fs_->gcount();
+        if (fs_->eof()) {
+            // The subsequent reads will return the end of file, unless
+            // something is appended to the file.
+            read_eof_ = true;
+            fs_->clear();
+
+        } else if (!fs_->good()) {
+            fs_->clear();
+            return (false);
+        }
+    }
+}
+
+void
+CSVFile::resetReadBuffer() const {
+    read_pos_ = 0;
+    read_end_ = 0;
+    read_eof_ = false;
+}
+
 void
 CSVFile::open() {
     // If file doesn't exist or is empty, we have to create our own file.
@@ -277,6 +517,7 @@ CSVFile::open() {
                 isc_throw(CSVFileError, "unable to set read pointer in the file '"
                           << filename_ << "'");
             }
+            resetReadBuffer();
 
             // Read the header.
             CSVRow header;
@@ -351,6 +592,20 @@ CSVFile::validate(const CSVRow& row) {
     return (ok);
 }
 
+bool
+CSVFile::validate(const CSVRowView& row) {
+    setReadMsg("success");
+    bool ok = (row.getValuesCount() == getColumnCount());
+    if (!ok) {
+        std::ostringstream s;
+        s << "the size of the row '" << row << "' doesn't match the number of"
+            " columns '" << getColumnCount() << "' of the CSV file '"
+          << filename_ << "'";
+        setReadMsg(s.str());
+    }
+    return (ok);
+}
+
 bool
 CSVFile::validateHeader(const CSVRow& header) {
     if (getColumnCount() == 0) {
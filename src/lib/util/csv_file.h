@@ -19,9 +19,11 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/shared_ptr.hpp>
 #include <fstream>
+#include <limits>
 #include <ostream>
 #include <string>
 #include <vector>
+#include <stdint.h>
 
 namespace isc {
 namespace util {
@@ -251,6 +253,202 @@ private:
 /// @param row Object representing a CSV file row.
 std::ostream& operator<<(std::ostream& os, const CSVRow& row);
 
+/// @brief Represents a single row of the CSV file, read in place.
+///
+/// Unlike the @c CSVRow, this class doesn't copy the values of the row.
+/// It holds pointers to the beginning and the end of each value in the
+/// buffer from which the row has been parsed, i.e. the read buffer of the
+/// @c CSVFile. The values are only valid until the next row is read from
+/// the file or the file is modified or closed.
+///
+/// The values are converted to the numbers, addresses and binary data
+/// directly from the buffer, without creating the temporary strings. The
+/// container of the value pointers is reused for the subsequent rows, so
+/// reading the rows doesn't allocate memory once it has grown to the
+/// number of the columns of the file. This class is meant to be used in
+/// the loops reading large CSV files, such as the lease files.
+class CSVRowView {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// Creates the row holding no values.
+    ///
+    /// @param separator Character being used as a separator in a parsed file.
+    CSVRowView(const char separator = ',');
+
+    /// @brief Returns number of values in a CSV row.
+    size_t getValuesCount() const {
+        return (values_.size());
+    }
+
+    /// @brief Removes all values from the row.
+    void clear() {
+        values_.clear();
+    }
+
+    /// @brief Parse the CSV file row held in the buffer.
+    ///
+    /// The row holds the pointers to the buffer, so the buffer must remain
+    /// valid as long as the values are read.
+    ///
+    /// This function is exception-free, unless it runs out of memory.
+    ///
+    /// @param begin Pointer to the beginning of the row.
+    /// @param end Pointer to the end of the row (past the last character).
+    void parse(const char* begin, const char* end);
+
+    /// @brief Retrieves a value as a string.
+    ///
+    /// This function copies the value, so it should only be used for the
+    /// values which are held as strings by the caller anyway.
+    ///
+    /// @param at Index of the value in the row.
+    ///
+    /// @throw CSVFileError if the index is out of range.
+    std::string readAt(const size_t at) const {
+        checkIndex(at);
+        return (std::string(values_[at].begin_, values_[at].end_));
+    }
+
+    /// @brief Returns the length of the value.
+    ///
+    /// @param at Index of the value in the row.
+    ///
+    /// @throw CSVFileError if the index is out of range.
+    size_t getLengthAt(const size_t at) const {
+        checkIndex(at);
+        return (values_[at].end_ - values_[at].begin_);
+    }
+
+    /// @brief Retrieves a value and converts it to the integer.
+    ///
+    /// The value must consist of the decimal digits, optionally preceded
+    /// by the minus sign if the type is signed.
+    ///
+    /// @param at Index of the value in the row.
+    /// @tparam T Integer type of the value to convert to.
+    ///
+    /// @return Converted value.
+    ///
+    /// @throw CSVFileError if the index is out of range or the value is not
+    /// a number in the range of the type.
+    template<typename T>
+    T readAndConvertAt(const size_t at) const {
+        checkIndex(at);
+        const char* pos = values_[at].begin_;
+        const char* end = values_[at].end_;
+        const bool negative = std::numeric_limits<T>::is_signed &&
+            (pos != end) && (*pos == '-');
+        if (negative) {
+            ++pos;
+        }
+        // The magnitude of the smallest negative number is one above
+        // the largest positive number.
+        const uint64_t limit = static_cast<uint64_t>
+            (std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+        uint64_t value = 0;
+        if (pos == end) {
+            throwConversionError(at);
+        }
+        for (; pos != end; ++pos) {
+            const unsigned digit = static_cast<unsigned char>(*pos) - '0';
+            if ((digit > 9) || (value > (limit - digit) / 10)) {
+                throwConversionError(at);
+            }
+            value = value * 10 + digit;
+        }
+        if (negative) {
+            return (value == 0 ? 0 : -static_cast<T>(value - 1) - 1);
+        }
+        return (static_cast<T>(value));
+    }
+
+    /// @brief Retrieves the IPv4 address in the dotted decimal notation.
+    ///
+    /// @param at Index of the value in the row.
+    ///
+    /// @return The address in the host byte order.
+    ///
+    /// @throw CSVFileError if the index is out of range or the value is not
+    /// an IPv4 address.
+    uint32_t readIPv4At(const size_t at) const;
+
+    /// @brief Retrieves the IPv6 address in the text form.
+    ///
+    /// @param at Index of the value in the row.
+    /// @param [out] address Buffer of 16 bytes receiving the address in
+    /// the network byte order.
+    ///
+    /// @throw CSVFileError if the index is out of range or the value is not
+    /// an IPv6 address.
+    void readIPv6At(const size_t at, uint8_t* address) const;
+
+    /// @brief Retrieves the binary data in the hexadecimal form.
+    ///
+    /// The data is expected in the form in which the hardware addresses,
+    /// client identifiers and DUIDs are written to the lease files: the
+    /// bytes are separated with colons and each byte is specified with one
+    /// or two hexadecimal digits, e.g. "01:2:a:bc". The empty value is
+    /// converted to the empty data.
+    ///
+    /// @param at Index of the value in the row.
+    /// @param [out] binary Container receiving the data. The previous
+    /// contents are replaced, but the capacity is retained, so the same
+    /// container can be reused without allocating memory.
+    ///
+    /// @throw CSVFileError if the index is out of range or the value is
+    /// malformed.
+    void readHexAt(const size_t at, std::vector<uint8_t>& binary) const;
+
+    /// @brief Creates a text representation of the CSV file row.
+    ///
+    /// @return Text representation of the CSV file row.
+    std::string render() const;
+
+private:
+
+    /// @brief Pointers to the beginning and the end of a value.
+    struct Value {
+        const char* begin_;
+        const char* end_;
+    };
+
+    /// @brief Check if the specified index of the value is in range.
+    ///
+    /// @param at Value index.
+    /// @throw CSVFileError if specified index is not in range.
+    void checkIndex(const size_t at) const;
+
+    /// @brief Throws the exception reporting the invalid value.
+    ///
+    /// @param at Index of the invalid value.
+    /// @throw CSVFileError always.
+    void throwConversionError(const size_t at) const;
+
+    /// @brief Separator character specifed in the constructor.
+    char separator_;
+
+    /// @brief Container holding the pointers to the values of the row.
+    std::vector<Value> values_;
+};
+
+/// @brief Converts the value of the row to the boolean value.
+///
+/// The value must be "0" or "1", as for the @c boost::lexical_cast.
+///
+/// @param at Index of the value in the row.
+/// @throw CSVFileError if the index is out of range or the value is
+/// neither "0" nor "1".
+template<>
+bool CSVRowView::readAndConvertAt<bool>(const size_t at) const;
+
+/// @brief Overrides standard output stream operator for @c CSVRowView object.
+///
+/// @param os Output stream.
+/// @param row Object representing a CSV file row.
+std::ostream& operator<<(std::ostream& os, const CSVRowView& row);
+
 /// @brief Provides input/output access to CSV files.
 ///
 /// This class provides basic methods to access (parse) and create CSV files.
@@ -273,9 +471,19 @@ std::ostream& operator<<(std::ostream& os, const CSVRow& row);
 /// immediately written into it. The header consists of the column names
 /// specified with the @c addColumn function. The subsequent rows are written
 /// into this file by calling @c append.
+///
+/// The file is read in large blocks into the read buffer, from which the
+/// rows are parsed. The @c next function taking the @c CSVRowView doesn't
+/// copy the values of the row out of the buffer and should be preferred
+/// when large files are read.
 class CSVFile {
 public:
 
+    /// @brief Initial size of the read buffer.
+    ///
+    /// The buffer grows if the file holds a longer row.
+    static const size_t READ_BUFFER_SIZE = 1048576;
+
     /// @brief Constructor.
     ///
     /// @param filename CSV file name.
@@ -304,7 +512,7 @@ public:
     void append(const CSVRow& row) const;
 
     /// @brief Closes the CSV file.
-    void close();
+    virtual void close();
 
     /// @brief Flushes a file.
     void flush() const;
@@ -357,6 +565,20 @@ public:
     /// failed.
     bool next(CSVRow& row, const bool skip_validation = false);
 
+    /// @brief Reads next row from CSV file without copying the values.
+    ///
+    /// This function parses the row in the read buffer. The values of the
+    /// row remain valid until the next row is read, or the file is
+    /// modified or closed. If the end of file has been reached, the row
+    /// holding no values is returned.
+    ///
+    /// @param [out] row Object receiving the parsed CSV row.
+    /// @param skip_validation Do not perform validation.
+    ///
+    /// @return true if row has been read and validated; false if validation
+    /// failed.
+    bool next(CSVRowView& row, const bool skip_validation = false);
+
     /// @brief Opens existing file or creates a new one.
     ///
     /// This function will try to open existing file if this file has size
@@ -368,7 +590,7 @@ public:
     /// be called.
     ///
     /// @throw CSVFileError when IO operation fails.
-    void open();
+    virtual void open();
 
     /// @brief Creates a new CSV file.
     ///
@@ -376,7 +598,7 @@ public:
     /// Otherwise, this function will write the header to the file.
     /// In order to write rows to opened file, the @c append function
     /// should be called.
-    void recreate();
+    virtual void recreate();
 
     /// @brief Sets error message after row validation.
     ///
@@ -430,6 +652,16 @@ protected:
     /// @return true if the column is valid; false otherwise.
     virtual bool validate(const CSVRow& row);
 
+    /// @brief Validate the row read from a file without copying the values.
+    ///
+    /// This default implementation checks that the number of values in the
+    /// row corresponds to the number of columns specified for this file.
+    ///
+    /// @param row A row to be validated.
+    ///
+    /// @return true if the column is valid; false otherwise.
+    virtual bool validate(const CSVRowView& row);
+
 private:
 
     /// @brief This function validates the header of the CSV file.
@@ -458,6 +690,25 @@ private:
     /// @brief Returns size of the CSV file.
     std::streampos size() const;
 
+    /// @brief Reads the next line from the read buffer.
+    ///
+    /// The buffer is refilled from the file stream when it holds no
+    /// complete line. The line doesn't include the terminating newline
+    /// character. The last line of the file may be unterminated.
+    ///
+    /// @param [out] begin Pointer to the beginning of the line or NULL if
+    /// the end of file has been reached.
+    /// @param [out] end Pointer to the end of the line.
+    ///
+    /// @return false if reading the file has failed, true otherwise.
+    bool readLine(const char*& begin, const char*& end);
+
+    /// @brief Discards the contents of the read buffer.
+    ///
+    /// It is called when the file is modified, so it is const as the
+    /// @c append function.
+    void resetReadBuffer() const;
+
     /// @brief CSV file name.
     std::string filename_;
 
@@ -469,6 +720,18 @@ private:
 
     /// @brief Holds last error during row reading or validation.
     std::string read_msg_;
+
+    /// @brief Buffer holding the data read from the file.
+    std::vector<char> read_buffer_;
+
+    /// @brief Offset of the first unread character in the read buffer.
+    mutable size_t read_pos_;
+
+    /// @brief Offset past the last character in the read buffer.
+    mutable size_t read_end_;
+
+    /// @brief Indicates that the end of the file has been read.
+    mutable bool read_eof_;
 };
 
 } // namespace isc::util
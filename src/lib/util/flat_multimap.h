@@ -0,0 +1,277 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef FLAT_MULTIMAP_H
+#define FLAT_MULTIMAP_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace isc {
+namespace util {
+
+/// @brief Multimap held in a sorted vector.
+///
+/// This container provides the subset of the @c std::multimap interface
+/// which is used for small collections, e.g. the options of a packet. The
+/// elements are held in a single vector sorted by key, rather than in
+/// separately allocated tree nodes, so filling the container takes a few
+/// allocations and walking it is cache friendly. The lookups are binary
+/// searches. As in the @c std::multimap, the elements having the same key
+/// are held in the order in which they were inserted.
+///
+/// Unlike the @c std::multimap, the insertion and removal of the elements
+/// invalidate the iterators pointing to the elements which follow the
+/// inserted or removed element (and all iterators if the vector is
+/// reallocated). The keys of the elements must not be modified through
+/// the iterators.
+///
+/// @tparam Key Type of the key.
+/// @tparam Value Type of the value held under the key.
+template<typename Key, typename Value>
+class FlatMultimap {
+public:
+
+    /// @brief Type of the key.
+    typedef Key key_type;
+
+    /// @brief Type of the value held under the key.
+    typedef Value mapped_type;
+
+    /// @brief Type of the element.
+    typedef std::pair<Key, Value> value_type;
+
+    /// @brief Type of the vector holding the elements.
+    typedef std::vector<value_type> Container;
+
+    /// @brief Iterator.
+    typedef typename Container::iterator iterator;
+
+    /// @brief Constant iterator.
+    typedef typename Container::const_iterator const_iterator;
+
+    /// @brief Type of the size of the container.
+    typedef typename Container::size_type size_type;
+
+    /// @brief Returns iterator to the first element.
+    iterator begin() {
+        return (elements_.begin());
+    }
+
+    /// @brief Returns constant iterator to the first element.
+    const_iterator begin() const {
+        return (elements_.begin());
+    }
+
+    /// @brief Returns iterator past the last element.
+    iterator end() {
+        return (elements_.end());
+    }
+
+    /// @brief Returns constant iterator past the last element.
+    const_iterator end() const {
+        return (elements_.end());
+    }
+
+    /// @brief Checks if the container is empty.
+    bool empty() const {
+        return (elements_.empty());
+    }
+
+    /// @brief Returns the number of elements.
+    size_type size() const {
+        return (elements_.size());
+    }
+
+    /// @brief Removes all elements.
+    void clear() {
+        elements_.clear();
+    }
+
+    /// @brief Reserves the space for the specified number of elements.
+    ///
+    /// @param count Number of elements.
+    void reserve(size_type count) {
+        elements_.reserve(count);
+    }
+
+    /// @brief Inserts the element.
+    ///
+    /// The element is inserted after the elements having the same key.
+    ///
+    /// @param value Element to be inserted.
+    ///
+    /// @return Iterator pointing to the inserted element.
+    iterator insert(const value_type& value) {
+        // Appending is the common case: the elements are often inserted
+        // in the order of their keys.
+        if (elements_.empty() || !(value.first < elements_.back().first)) {
+            elements_.push_back(value);
+            return (elements_.end() - 1);
+        }
+        return (elements_.insert(upper_bound(value.first), value));
+    }
+
+    /// @brief Removes the element.
+    ///
+    /// @param position Iterator pointing to the element to be removed.
+    void erase(iterator position) {
+        elements_.erase(position);
+    }
+
+    /// @brief Removes the elements in the range.
+    ///
+    /// @param first Iterator pointing to the first element to be removed.
+    /// @param last Iterator pointing past the last element to be removed.
+    void erase(iterator first, iterator last) {
+        elements_.erase(first, last);
+    }
+
+    /// @brief Removes all elements having the specified key.
+    ///
+    /// @param key Key of the elements to be removed.
+    ///
+    /// @return Number of the removed elements.
+    size_type erase(const Key& key) {
+        std::pair<iterator, iterator> range = equal_range(key);
+        size_type count = range.second - range.first;
+        elements_.erase(range.first, range.second);
+        return (count);
+    }
+
+    /// @brief Returns iterator to the first element having the key.
+    ///
+    /// @param key Searched key.
+    ///
+    /// @return Iterator to the element or @c end() if there is none.
+    iterator find(const Key& key) {
+        iterator it = lower_bound(key);
+        if ((it != elements_.end()) && !(key < it->first)) {
+            return (it);
+        }
+        return (elements_.end());
+    }
+
+    /// @brief Returns constant iterator to the first element having the key.
+    ///
+    /// @param key Searched key.
+    ///
+    /// @return Iterator to the element or @c end() if there is none.
+    const_iterator find(const Key& key) const {
+        const_iterator it = lower_bound(key);
+        if ((it != elements_.end()) && !(key < it->first)) {
+            return (it);
+        }
+        return (elements_.end());
+    }
+
+    /// @brief Returns the number of elements having the key.
+    ///
+    /// @param key Searched key.
+    size_type count(const Key& key) const {
+        std::pair<const_iterator, const_iterator> range = equal_range(key);
+        return (range.second - range.first);
+    }
+
+    /// @brief Returns iterator to the first element not less than the key.
+    ///
+    /// @param key Searched key.
+    iterator lower_bound(const Key& key) {
+        return (std::lower_bound(elements_.begin(), elements_.end(), key,
+                                 KeyCompare()));
+    }
+
+    /// @brief Returns constant iterator to the first element not less than
+    /// the key.
+    ///
+    /// @param key Searched key.
+    const_iterator lower_bound(const Key& key) const {
+        return (std::lower_bound(elements_.begin(), elements_.end(), key,
+                                 KeyCompare()));
+    }
+
+    /// @brief Returns iterator to the first element greater than the key.
+    ///
+    /// @param key Searched key.
+    iterator upper_bound(const Key& key) {
+        return (std::upper_bound(elements_.begin(), elements_.end(), key,
+                                 KeyCompare()));
+    }
+
+    /// @brief Returns constant iterator to the first element greater than
+    /// the key.
+    ///
+    /// @param key Searched key.
+    const_iterator upper_bound(const Key& key) const {
+        return (std::upper_bound(elements_.begin(), elements_.end(), key,
+                                 KeyCompare()));
+    }
+
+    /// @brief Returns the range of elements having the key.
+    ///
+    /// @param key Searched key.
+    std::pair<iterator, iterator> equal_range(const Key& key) {
+        return (std::equal_range(elements_.begin(), elements_.end(), key,
+                                 KeyCompare()));
+    }
+
+    /// @brief Returns the constant range of elements having the key.
+    ///
+    /// @param key Searched key.
+    std::pair<const_iterator, const_iterator>
+    equal_range(const Key& key) const {
+        return (std::equal_range(elements_.begin(), elements_.end(), key,
+                                 KeyCompare()));
+    }
+
+    /// @brief Swaps the contents of two containers.
+    ///
+    /// @param other Container to swap the contents with.
+    void swap(FlatMultimap& other) {
+        elements_.swap(other.elements_);
+    }
+
+private:
+
+    /// @brief Compares the keys of the elements with the searched key.
+    struct KeyCompare {
+        /// @brief Checks if the element's key is less than the key.
+        bool operator()(const value_type& element, const Key& key) const {
+            return (element.first < key);
+        }
+
+        /// @brief Checks if the key is less than the element's key.
+        bool operator()(const Key& key, const value_type& element) const {
+            return (key < element.first);
+        }
+
+        /// @brief Compares the keys of two elements.
+        ///
+        /// Some implementations of the standard library check the ordering
+        /// of the elements in the debug mode.
+        bool operator()(const value_type& first,
+                        const value_type& second) const {
+            return (first.first < second.first);
+        }
+    };
+
+    /// @brief Elements sorted by key.
+    Container elements_;
+};
+
+} // end of isc::util namespace
+} // end of isc namespace
+
+#endif // FLAT_MULTIMAP_H
@@ -0,0 +1,71 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef MMSG_UTIL_H
+#define MMSG_UTIL_H 1
+
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+// These definitions in this file are for the convenience of internal
+// implementation and test code, and are not intended to be used publicly.
+// The namespace "internal" indicates the intent. The file must be included
+// after config.h.
+
+namespace isc {
+namespace util {
+namespace io {
+namespace internal {
+
+#ifdef HAVE_SENDMMSG
+/// @brief Sends the messages with the sendmmsg system call.
+///
+/// The sendmmsg call stops at the first message which can't be sent. This
+/// function skips such message and sends the remaining messages, so as a
+/// single failure doesn't prevent the other messages from being sent.
+///
+/// @param sockfd Socket descriptor.
+/// @param msgs Array of the messages to be sent.
+/// @param count Number of the messages.
+///
+/// @return Description of the last error or an empty string if all messages
+/// have been sent.
+inline std::string
+sendMessages(const int sockfd, struct mmsghdr* msgs, const size_t count) {
+    std::string error;
+    size_t sent = 0;
+    while (sent < count) {
+        const int result = sendmmsg(sockfd, msgs + sent, count - sent, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = strerror(errno);
+            ++sent;
+        } else {
+            sent += result;
+        }
+    }
+    return (error);
+}
+#endif
+
+}
+}
+}
+}
+
+#endif  // MMSG_UTIL_H
@@ -16,9 +16,11 @@
 #include <util/csv_file.h>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace {
 
@@ -90,6 +92,102 @@ TEST(CSVRow, writeAt) {
     EXPECT_THROW(row.writeAt(3, "foo"), CSVFileError);
 }
 
+// This test checks that the row is parsed in place.
+TEST(CSVRowView, parse) {
+    const std::string text0 = "foo,,foo-bar";
+    CSVRowView row0;
+    row0.parse(text0.data(), text0.data() + text0.size());
+    ASSERT_EQ(3, row0.getValuesCount());
+    EXPECT_EQ("foo", row0.readAt(0));
+    EXPECT_TRUE(row0.readAt(1).empty());
+    EXPECT_EQ(0, row0.getLengthAt(1));
+    EXPECT_EQ("foo-bar", row0.readAt(2));
+    EXPECT_EQ(text0, row0.render());
+    EXPECT_THROW(row0.readAt(3), CSVFileError);
+
+    const std::string text1 = "foo-bar|foo|";
+    CSVRowView row1('|');
+    row1.parse(text1.data(), text1.data() + text1.size());
+    ASSERT_EQ(3, row1.getValuesCount());
+    EXPECT_EQ("foo-bar", row1.readAt(0));
+    EXPECT_EQ("foo", row1.readAt(1));
+    EXPECT_TRUE(row1.readAt(2).empty());
+
+    // As for the CSVRow, the empty line holds one empty value.
+    row1.parse(text1.data(), text1.data());
+    ASSERT_EQ(1, row1.getValuesCount());
+    EXPECT_TRUE(row1.readAt(0).empty());
+
+    row1.clear();
+    EXPECT_EQ(0, row1.getValuesCount());
+}
+
+// This test checks that the values of the row are converted to numbers.
+TEST(CSVRowView, readAndConvertAt) {
+    const std::string text = "0,4294967295,4294967296,-1,-2147483648,"
+        "2147483648,1,abc,,12a";
+    CSVRowView row;
+    row.parse(text.data(), text.data() + text.size());
+
+    EXPECT_EQ(0, row.readAndConvertAt<uint32_t>(0));
+    EXPECT_EQ(4294967295U, row.readAndConvertAt<uint32_t>(1));
+    EXPECT_THROW(row.readAndConvertAt<uint32_t>(2), CSVFileError);
+    EXPECT_EQ(4294967296LL, row.readAndConvertAt<int64_t>(2));
+    EXPECT_THROW(row.readAndConvertAt<uint32_t>(3), CSVFileError);
+    EXPECT_EQ(-1, row.readAndConvertAt<int>(3));
+    EXPECT_EQ(-2147483647 - 1, row.readAndConvertAt<int32_t>(4));
+    EXPECT_THROW(row.readAndConvertAt<int32_t>(5), CSVFileError);
+    EXPECT_THROW(row.readAndConvertAt<uint8_t>(5), CSVFileError);
+
+    EXPECT_FALSE(row.readAndConvertAt<bool>(0));
+    EXPECT_TRUE(row.readAndConvertAt<bool>(6));
+    EXPECT_THROW(row.readAndConvertAt<bool>(1), CSVFileError);
+
+    for (size_t i = 7; i < row.getValuesCount(); ++i) {
+        EXPECT_THROW(row.readAndConvertAt<uint32_t>(i), CSVFileError)
+            << "value at index " << i << " was accepted";
+    }
+}
+
+// This test checks that the values of the row are converted to addresses
+// and binary data.
+TEST(CSVRowView, readAddressAndHex) {
+    const std::string text = "192.0.2.1,2001:db8:1::2,192.0.2.256,"
+        "06:07:8:a:BC,,0a::0b,0a:abc,0x";
+    CSVRowView row;
+    row.parse(text.data(), text.data() + text.size());
+
+    EXPECT_EQ(0xc0000201, row.readIPv4At(0));
+    EXPECT_THROW(row.readIPv4At(1), CSVFileError);
+    EXPECT_THROW(row.readIPv4At(2), CSVFileError);
+
+    uint8_t address[16];
+    ASSERT_NO_THROW(row.readIPv6At(1, address));
+    const uint8_t expected_address[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0,
+                                         0, 0, 0, 0, 0, 0, 0, 2 };
+    EXPECT_TRUE(std::equal(address, address + sizeof(address),
+                           expected_address));
+    EXPECT_THROW(row.readIPv6At(0, address), CSVFileError);
+
+    std::vector<uint8_t> binary;
+    ASSERT_NO_THROW(row.readHexAt(3, binary));
+    ASSERT_EQ(5, binary.size());
+    EXPECT_EQ(0x06, binary[0]);
+    EXPECT_EQ(0x07, binary[1]);
+    EXPECT_EQ(0x08, binary[2]);
+    EXPECT_EQ(0x0a, binary[3]);
+    EXPECT_EQ(0xbc, binary[4]);
+
+    // The empty value is converted to the empty data.
+    ASSERT_NO_THROW(row.readHexAt(4, binary));
+    EXPECT_TRUE(binary.empty());
+
+    // Empty tokens, too long tokens and invalid digits are rejected.
+    EXPECT_THROW(row.readHexAt(5, binary), CSVFileError);
+    EXPECT_THROW(row.readHexAt(6, binary), CSVFileError);
+    EXPECT_THROW(row.readHexAt(7, binary), CSVFileError);
+}
+
 /// @brief Test fixture class for testing operations on CSV file.
 ///
 /// It implements basic operations on files, such as reading writing
@@ -286,6 +384,66 @@ TEST_F(CSVFileTest, openReadAllWrite) {
     EXPECT_THROW(csv->append(row_write), CSVFileError);
 }
 
+// This test checks that the rows are read in place and that the reads
+// may be mixed with the reads of the rows being copied.
+TEST_F(CSVFileTest, openReadView) {
+    // The last row is not terminated with the newline character.
+    writeFile("animal,age,color\n"
+              "cat,10,white\n"
+              "lion,15,yellow\n"
+              "dog,2,blue");
+
+    boost::scoped_ptr<CSVFile> csv(new CSVFile(testfile_));
+    ASSERT_NO_THROW(csv->open());
+
+    CSVRowView row;
+    ASSERT_TRUE(csv->next(row));
+    ASSERT_EQ(3, row.getValuesCount());
+    EXPECT_EQ("cat", row.readAt(0));
+    EXPECT_EQ(10, row.readAndConvertAt<int>(1));
+    EXPECT_EQ("white", row.readAt(2));
+
+    CSVRow row_copy;
+    ASSERT_TRUE(csv->next(row_copy));
+    EXPECT_EQ("lion,15,yellow", row_copy.render());
+
+    ASSERT_TRUE(csv->next(row));
+    EXPECT_EQ("dog,2,blue", row.render());
+
+    // The end of file is signalled with the row holding no values.
+    ASSERT_TRUE(csv->next(row));
+    EXPECT_EQ(0, row.getValuesCount());
+
+    // The invalid rows are reported.
+    csv->close();
+    writeFile("animal,age,color\n"
+              "lion,15,yellow,black\n");
+    ASSERT_NO_THROW(csv->open());
+    EXPECT_FALSE(csv->next(row));
+    EXPECT_NE("success", csv->getReadMsg());
+    csv->close();
+    EXPECT_FALSE(csv->next(row));
+}
+
+// This test checks that the row longer than the read buffer is read.
+TEST_F(CSVFileTest, readLongRow) {
+    const std::string long_value(CSVFile::READ_BUFFER_SIZE + 100, 'x');
+    writeFile("animal,comments\n"
+              "cat," + long_value + "\n"
+              "dog,nice one\n");
+
+    boost::scoped_ptr<CSVFile> csv(new CSVFile(testfile_));
+    ASSERT_NO_THROW(csv->open());
+
+    CSVRowView row;
+    ASSERT_TRUE(csv->next(row));
+    EXPECT_EQ(long_value.size(), row.getLengthAt(1));
+    ASSERT_TRUE(csv->next(row));
+    EXPECT_EQ("nice one", row.readAt(1));
+    ASSERT_TRUE(csv->next(row));
+    EXPECT_EQ(0, row.getValuesCount());
+}
+
 // This test checks that contents may be appended to a file which hasn't
 // been fully parsed/read.
 TEST_F(CSVFileTest, openReadPartialWrite) {
@@ -0,0 +1,108 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <util/flat_multimap.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+using namespace isc::util;
+
+namespace {
+
+/// @brief Type of the container used by the tests.
+typedef FlatMultimap<unsigned int, std::string> TestMultimap;
+
+// This test verifies that the elements are sorted by key and that the
+// elements having the same key are held in the order of insertion.
+TEST(FlatMultimapTest, insert) {
+    TestMultimap map;
+    EXPECT_TRUE(map.empty());
+
+    map.insert(std::make_pair(5, "five"));
+    map.insert(std::make_pair(1, "one"));
+    map.insert(std::make_pair(5, "five again"));
+    map.insert(std::make_pair(3, "three"));
+    TestMultimap::iterator it = map.insert(std::make_pair(1, "one again"));
+    EXPECT_EQ("one again", it->second);
+
+    ASSERT_EQ(5, map.size());
+    it = map.begin();
+    EXPECT_EQ("one", (it++)->second);
+    EXPECT_EQ("one again", (it++)->second);
+    EXPECT_EQ("three", (it++)->second);
+    EXPECT_EQ("five", (it++)->second);
+    EXPECT_EQ("five again", (it++)->second);
+    EXPECT_TRUE(it == map.end());
+}
+
+// This test verifies that the elements are found by key.
+TEST(FlatMultimapTest, find) {
+    TestMultimap map;
+    EXPECT_TRUE(map.find(1) == map.end());
+
+    map.insert(std::make_pair(3, "three"));
+    map.insert(std::make_pair(1, "one"));
+    map.insert(std::make_pair(3, "three again"));
+
+    TestMultimap::iterator it = map.find(3);
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ("three", it->second);
+    EXPECT_TRUE(map.find(2) == map.end());
+    EXPECT_TRUE(map.find(4) == map.end());
+
+    const TestMultimap& const_map = map;
+    TestMultimap::const_iterator const_it = const_map.find(1);
+    ASSERT_TRUE(const_it != const_map.end());
+    EXPECT_EQ("one", const_it->second);
+
+    EXPECT_EQ(2, map.count(3));
+    EXPECT_EQ(1, map.count(1));
+    EXPECT_EQ(0, map.count(2));
+
+    std::pair<TestMultimap::const_iterator, TestMultimap::const_iterator>
+        range = const_map.equal_range(3);
+    ASSERT_EQ(2, std::distance(range.first, range.second));
+    EXPECT_EQ("three", range.first->second);
+    EXPECT_EQ("three again", (++range.first)->second);
+}
+
+// This test verifies that the elements are removed.
+TEST(FlatMultimapTest, erase) {
+    TestMultimap map;
+    map.insert(std::make_pair(1, "one"));
+    map.insert(std::make_pair(2, "two"));
+    map.insert(std::make_pair(2, "two again"));
+    map.insert(std::make_pair(3, "three"));
+
+    // Remove a single element.
+    map.erase(map.find(1));
+    EXPECT_TRUE(map.find(1) == map.end());
+    ASSERT_EQ(3, map.size());
+
+    // Remove all elements having the key.
+    EXPECT_EQ(2, map.erase(2));
+    EXPECT_EQ(0, map.erase(2));
+    ASSERT_EQ(1, map.size());
+    EXPECT_EQ("three", map.begin()->second);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+}
+
+} // end of anonymous namespace
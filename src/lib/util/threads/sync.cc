@@ -24,6 +24,8 @@
 #include <cassert>
 
 #include <pthread.h>
+#include <stdint.h>
+#include <sys/time.h>
 
 using std::auto_ptr;
 
@@ -246,6 +248,35 @@ CondVar::wait(Mutex& mutex) {
     }
 }
 
+bool
+CondVar::timedWait(Mutex& mutex, const size_t timeout_ms) {
+    // The pthread_cond_timedwait() takes an absolute time.
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    struct timespec deadline;
+    const uint64_t nsec = static_cast<uint64_t>(now.tv_usec) * 1000 +
+        static_cast<uint64_t>(timeout_ms % 1000) * 1000000;
+    deadline.tv_sec = now.tv_sec + timeout_ms / 1000 + nsec / 1000000000;
+    deadline.tv_nsec = nsec % 1000000000;
+
+#ifdef ENABLE_DEBUG
+    mutex.preUnlockAction(true);    // Only in debug mode
+    const int result = pthread_cond_timedwait(&impl_->cond_,
+                                              &mutex.impl_->mutex, &deadline);
+    mutex.postLockAction();     // Only in debug mode
+#else
+    const int result = pthread_cond_timedwait(&impl_->cond_,
+                                              &mutex.impl_->mutex, &deadline);
+#endif
+    if (result == ETIMEDOUT) {
+        return (false);
+    } else if (result != 0) {
+        isc_throw(isc::BadValue, "pthread_cond_timedwait failed"
+                  " unexpectedly: " << std::strerror(result));
+    }
+    return (true);
+}
+
 void
 CondVar::signal() {
     const int result = pthread_cond_signal(&impl_->cond_);
@@ -255,6 +286,15 @@ CondVar::signal() {
     assert(result == 0);
 }
 
+void
+CondVar::broadcast() {
+    const int result = pthread_cond_broadcast(&impl_->cond_);
+
+    // pthread_cond_broadcast() can only fail when if cond_ is invalid.  It
+    // should be impossible as long as this is a valid CondVar object.
+    assert(result == 0);
+}
+
 }
 }
 }
@@ -133,6 +133,34 @@ TEST_F(CondVarTest, multiWaits) {
     EXPECT_EQ(4, shared_var);
 }
 
+// Similar to the previous test, but both threads are woken by a single
+// broadcast.
+TEST_F(CondVarTest, multiWaitsBroadcast) {
+    boost::scoped_ptr<Mutex::Locker> locker(new Mutex::Locker(mutex_));
+    CondVar condvar2; // separate cond var for initial synchronization
+    int shared_var = 0; // let the other thread increment this
+    Thread t1(boost::bind(&signalAndWait, &condvar_, &condvar2, &mutex_,
+                          &shared_var));
+    Thread t2(boost::bind(&signalAndWait, &condvar_, &condvar2, &mutex_,
+                          &shared_var));
+
+    // Wait until both threads are waiting on condvar_.
+    while (shared_var < 2 && !do_exit) {
+        condvar2.wait(mutex_);
+    }
+    // Check we exited from the loop successfully.
+    ASSERT_FALSE(do_exit);
+    ASSERT_EQ(2, shared_var);
+
+    // release the lock, wake up both threads at once, wait for them to die,
+    // and confirm they successfully woke up.
+    locker.reset();
+    condvar_.broadcast();
+    t1.wait();
+    t2.wait();
+    EXPECT_EQ(4, shared_var);
+}
+
 // Similar to the previous version of the same function, but just do
 // condvar operations.  It will never wake up.
 void
@@ -175,4 +203,32 @@ TEST_F(CondVarTest, emptySignal) {
     EXPECT_NO_THROW(condvar_.signal());
 }
 
+TEST_F(CondVarTest, emptyBroadcast) {
+    // It's okay to call broadcast when no one waits.
+    EXPECT_NO_THROW(condvar_.broadcast());
+}
+
+TEST_F(CondVarTest, timedWaitTimeout) {
+    // Nobody signals the condition variable, so the wait times out.
+    Mutex::Locker locker(mutex_);
+    EXPECT_FALSE(condvar_.timedWait(mutex_, 10));
+    EXPECT_FALSE(condvar_.timedWait(mutex_, 1010));
+}
+
+// Acquire the lock and signal the condition variable.
+void
+lockAndSignal(CondVar* condvar, Mutex* mutex) {
+    Mutex::Locker locker(*mutex);
+    condvar->signal();
+}
+
+TEST_F(CondVarTest, timedWaitSignal) {
+    // The thread can acquire the lock only when this thread waits, so the
+    // signal is never missed.
+    Mutex::Locker locker(mutex_);
+    Thread t(boost::bind(&lockAndSignal, &condvar_, &mutex_));
+    EXPECT_TRUE(condvar_.timedWait(mutex_, 10000));
+    t.wait();
+}
+
 }